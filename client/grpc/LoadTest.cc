@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+// File: LoadTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Mixed load against the namespace gRPC service: a set of threads issues
+// stat calls back to back while other threads run recursive finds. Reports
+// the stat latency percentiles and the find throughput, which shows whether
+// long streaming calls slow down the short ones.
+//------------------------------------------------------------------------------
+
+#include "proto/Rpc.grpc.pb.h"
+#include <grpc++/grpc++.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int usage(const char* prog)
+{
+  fprintf(stderr, "usage: %s [--endpoint <host:port>] [--token <auth-token>] "
+          "[--stat-threads <n>] [--find-threads <n>] [--duration <s>] "
+          "[--depth <depth>] <stat-path> <find-path>\n", prog);
+  return -1;
+}
+
+int main(int argc, const char* argv[])
+{
+  std::string endpoint = "localhost:50051";
+  std::string token;
+  size_t stat_threads = 16;
+  size_t find_threads = 2;
+  int duration = 30;
+  uint64_t depth = 1024;
+  std::vector<std::string> paths;
+
+  for (auto i = 1; i < argc; ++i) {
+    std::string option = argv[i];
+
+    if (option.substr(0, 2) == "--") {
+      if (argc <= i + 1) {
+        return usage(argv[0]);
+      }
+
+      std::string value = argv[++i];
+
+      if (option == "--endpoint") {
+        endpoint = value;
+      } else if (option == "--token") {
+        token = value;
+      } else if (option == "--stat-threads") {
+        stat_threads = std::stoul(value);
+      } else if (option == "--find-threads") {
+        find_threads = std::stoul(value);
+      } else if (option == "--duration") {
+        duration = std::stoi(value);
+      } else if (option == "--depth") {
+        depth = std::stoull(value);
+      } else {
+        return usage(argv[0]);
+      }
+
+      continue;
+    }
+
+    paths.push_back(option);
+  }
+
+  if (paths.size() != 2) {
+    return usage(argv[0]);
+  }
+
+  auto channel = grpc::CreateChannel(endpoint,
+                                     grpc::InsecureChannelCredentials());
+  std::unique_ptr<eos::rpc::Eos::Stub> stub = eos::rpc::Eos::NewStub(channel);
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline = start + std::chrono::seconds(duration);
+  std::mutex mutex;
+  std::vector<uint32_t> stat_latencies;
+  std::vector<uint32_t> find_durations;
+  std::atomic<uint64_t> find_entries {0};
+  std::atomic<uint64_t> errors {0};
+  std::vector<std::thread> threads;
+
+  for (size_t i = 0; i < stat_threads; ++i) {
+    threads.emplace_back([&]() {
+      std::vector<uint32_t> latencies;
+      eos::rpc::MDRequest request;
+      request.set_type(eos::rpc::STAT);
+      request.mutable_id()->set_path(paths[0]);
+      request.set_authkey(token);
+
+      while (Clock::now() < deadline) {
+        grpc::ClientContext context;
+        eos::rpc::MDResponse response;
+        Clock::time_point sent = Clock::now();
+        auto reader = stub->MD(&context, request);
+
+        while (reader->Read(&response)) {}
+
+        if (!reader->Finish().ok()) {
+          ++errors;
+        }
+
+        latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>
+                            (Clock::now() - sent).count());
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      stat_latencies.insert(stat_latencies.end(), latencies.begin(),
+                            latencies.end());
+    });
+  }
+
+  for (size_t i = 0; i < find_threads; ++i) {
+    threads.emplace_back([&]() {
+      eos::rpc::FindRequest request;
+      request.set_type(eos::rpc::LISTING);
+      request.mutable_id()->set_path(paths[1]);
+      request.set_maxdepth(depth);
+      request.set_authkey(token);
+
+      while (Clock::now() < deadline) {
+        grpc::ClientContext context;
+        eos::rpc::MDResponse response;
+        Clock::time_point sent = Clock::now();
+        auto reader = stub->Find(&context, request);
+
+        while (reader->Read(&response)) {
+          ++find_entries;
+        }
+
+        if (!reader->Finish().ok()) {
+          ++errors;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        find_durations.push_back(std::chrono::duration_cast
+                                 <std::chrono::milliseconds>
+                                 (Clock::now() - sent).count());
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+                   (Clock::now() - start).count() / 1000.0;
+  std::sort(stat_latencies.begin(), stat_latencies.end());
+  auto percentile = [&stat_latencies](double p) -> double {
+    if (stat_latencies.empty())
+    {
+      return 0.0;
+    }
+
+    return stat_latencies[std::min(stat_latencies.size() - 1,
+                                   (size_t)(p * stat_latencies.size()))] / 1000.0;
+  };
+  uint64_t find_total = 0;
+
+  for (auto d : find_durations) {
+    find_total += d;
+  }
+
+  std::cout << "duration=" << elapsed << "s errors=" << errors << std::endl
+            << "stat threads=" << stat_threads
+            << " calls=" << stat_latencies.size()
+            << " rate=" << (uint64_t)(stat_latencies.size() / elapsed)
+            << " calls/s p50=" << percentile(0.50) << "ms"
+            << " p90=" << percentile(0.90) << "ms"
+            << " p99=" << percentile(0.99) << "ms"
+            << " p99.9=" << percentile(0.999) << "ms"
+            << " max=" << (stat_latencies.empty() ? 0.0 :
+                           stat_latencies.back() / 1000.0) << "ms" << std::endl
+            << "find threads=" << find_threads
+            << " calls=" << find_durations.size()
+            << " avg=" << (find_durations.empty() ? 0 :
+                           find_total / find_durations.size()) << "ms"
+            << " max=" << (find_durations.empty() ? 0 :
+                           *std::max_element(find_durations.begin(),
+                               find_durations.end())) << "ms"
+            << " entries=" << find_entries
+            << " rate=" << (uint64_t)(find_entries / elapsed) << " entries/s"
+            << std::endl;
+  return 0;
+}
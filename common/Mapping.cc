@@ -36,6 +36,9 @@
 #include "XrdAcc/XrdAccAuthorize.hh"
 #include <pwd.h>
 #include <grp.h>
+#include <algorithm>
+#include <optional>
+#include <vector>
 #include <sys/stat.h>
 
 EOSCOMMONNAMESPACE_BEGIN
@@ -63,18 +66,138 @@ ShardedCache<std::string, Mapping::id_pair> Mapping::gShardedPhysicalUidCache(
   8);
 ShardedCache<std::string, Mapping::gid_set> Mapping::gShardedPhysicalGidCache(
   8);
-ShardedCache<uid_t, std::string> Mapping::gShardedNegativeUserNameCache(8);
-ShardedCache<gid_t, std::string> Mapping::gShardedNegativeGroupNameCache(8);
-ShardedCache<std::string, bool> Mapping::gShardedNegativePhysicalUidCache(8);
 ShardedCache<std::string, time_t> Mapping::ActiveTidentsSharded(16);
 ShardedCache<uid_t, size_t> Mapping::ActiveUidsSharded(16);
 
-std::mutex Mapping::gPhysicalUserNameCacheMutex;
-std::mutex Mapping::gPhysicalGroupNameCacheMutex;
-std::map<uid_t, std::string> Mapping::gPhysicalUserNameCache;
-std::map<gid_t, std::string> Mapping::gPhysicalGroupNameCache;
-std::map<std::string, uid_t> Mapping::gPhysicalUserIdCache;
-std::map<std::string, gid_t> Mapping::gPhysicalGroupIdCache;
+//------------------------------------------------------------------------------
+// NSS resolvers used by the identity caches, they must not hold any lock
+// since they can block for a long time when the backend is LDAP or SSSD
+//------------------------------------------------------------------------------
+namespace
+{
+//! Initial and maximum buffer size used for the NSS lookups
+constexpr size_t kNssBufferSize = 128 * 1024;
+constexpr size_t kNssMaxBufferSize = 16 * 1024 * 1024;
+
+std::optional<Mapping::pw_entry>
+ResolvePasswdByUid(const uid_t& uid)
+{
+  std::vector<char> buffer(kNssBufferSize);
+  struct passwd pwbuf;
+  struct passwd* pwbufp = nullptr;
+  int retc = 0;
+
+  while ((retc = getpwuid_r(uid, &pwbuf, buffer.data(), buffer.size(),
+                            &pwbufp)) == ERANGE) {
+    if (buffer.size() >= kNssMaxBufferSize) {
+      break;
+    }
+
+    buffer.resize(2 * buffer.size());
+  }
+
+  if (retc || !pwbufp) {
+    return std::nullopt;
+  }
+
+  return Mapping::pw_entry{pwbuf.pw_uid, pwbuf.pw_gid, pwbuf.pw_name};
+}
+
+std::optional<Mapping::pw_entry>
+ResolvePasswdByName(const std::string& name)
+{
+  std::vector<char> buffer(kNssBufferSize);
+  struct passwd pwbuf;
+  struct passwd* pwbufp = nullptr;
+  int retc = 0;
+
+  while ((retc = getpwnam_r(name.c_str(), &pwbuf, buffer.data(), buffer.size(),
+                            &pwbufp)) == ERANGE) {
+    if (buffer.size() >= kNssMaxBufferSize) {
+      break;
+    }
+
+    buffer.resize(2 * buffer.size());
+  }
+
+  if (retc || !pwbufp) {
+    return std::nullopt;
+  }
+
+  return Mapping::pw_entry{pwbuf.pw_uid, pwbuf.pw_gid, pwbuf.pw_name};
+}
+
+std::optional<std::string>
+ResolveGroupByGid(const gid_t& gid)
+{
+  std::vector<char> buffer(kNssBufferSize);
+  struct group grbuf;
+  struct group* grbufp = nullptr;
+  int retc = 0;
+
+  while ((retc = getgrgid_r(gid, &grbuf, buffer.data(), buffer.size(),
+                            &grbufp)) == ERANGE) {
+    if (buffer.size() >= kNssMaxBufferSize) {
+      break;
+    }
+
+    buffer.resize(2 * buffer.size());
+  }
+
+  if (retc || !grbufp) {
+    return std::nullopt;
+  }
+
+  return std::string(grbuf.gr_name);
+}
+
+std::optional<gid_t>
+ResolveGroupByName(const std::string& name)
+{
+  std::vector<char> buffer(kNssBufferSize);
+  struct group grbuf;
+  struct group* grbufp = nullptr;
+  int retc = 0;
+
+  while ((retc = getgrnam_r(name.c_str(), &grbuf, buffer.data(), buffer.size(),
+                            &grbufp)) == ERANGE) {
+    if (buffer.size() >= kNssMaxBufferSize) {
+      break;
+    }
+
+    buffer.resize(2 * buffer.size());
+  }
+
+  if (retc || !grbufp) {
+    return std::nullopt;
+  }
+
+  return grbuf.gr_gid;
+}
+
+//------------------------------------------------------------------------------
+// Check if string is a non-zero numeric id
+//------------------------------------------------------------------------------
+bool IsNumericId(const std::string& name, unsigned long& id)
+{
+  if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit)) {
+    return false;
+  }
+
+  id = strtoul(name.c_str(), nullptr, 10);
+  return (id != 0);
+}
+}
+
+NssCache<uid_t, Mapping::pw_entry>
+Mapping::gPasswdByUidCache(ResolvePasswdByUid);
+NssCache<std::string, Mapping::pw_entry>
+Mapping::gPasswdByNameCache(ResolvePasswdByName);
+NssCache<gid_t, std::string> Mapping::gGroupByGidCache(ResolveGroupByGid);
+NssCache<std::string, gid_t> Mapping::gGroupByNameCache(ResolveGroupByName);
+
+//! Pool running the NSS lookups, it must be destroyed before the caches
+static std::unique_ptr<ThreadPool> g_nss_pool;
 
 Mapping::ip_cache Mapping::gIpCache(300);
 
@@ -128,19 +251,35 @@ Mapping::Init()
       // Force expiry of UID/GID cache every 2 cycles
       gShardedPhysicalUidCache.set_force_expiry(true, 2);
       gShardedPhysicalGidCache.set_force_expiry(true, 2);
-      gShardedNegativeGroupNameCache.set_force_expiry(true, 2);
-      gShardedNegativePhysicalUidCache.set_force_expiry(true, 2);
 
       gShardedPhysicalUidCache.reset_cleanup_thread(3600 * 1000,
           "UidCacheGC");
       gShardedPhysicalGidCache.reset_cleanup_thread(3600 * 1000,
           "GidCacheGC");
-      gShardedNegativeUserNameCache.reset_cleanup_thread(3600 * 1000,
-          "NegUserNameGC");
-      gShardedNegativeGroupNameCache.reset_cleanup_thread(3600 * 1000,
-          "NegGroupNameGC");
-      gShardedNegativePhysicalUidCache.reset_cleanup_thread(3600 * 1000,
-          "NegUidGC");
+      // Bounded pool for the NSS lookups, callers wait at most the given
+      // timeout after which a stale entry is used if available
+      unsigned int nss_threads = 8;
+      NssCacheOptions opts;
+
+      if (getenv("EOS_NSS_THREADS")) {
+        nss_threads = std::max(1, atoi(getenv("EOS_NSS_THREADS")));
+      }
+
+      if (getenv("EOS_NSS_TIMEOUT_MS")) {
+        opts.mTimeout = std::chrono::milliseconds(
+                          std::max(1, atoi(getenv("EOS_NSS_TIMEOUT_MS"))));
+      }
+
+      g_nss_pool.reset(new ThreadPool(nss_threads, nss_threads, 10, 6, 10,
+                                      "NssLookup"));
+      gPasswdByUidCache.SetOptions(opts);
+      gPasswdByUidCache.SetPool(g_nss_pool.get());
+      gPasswdByNameCache.SetOptions(opts);
+      gPasswdByNameCache.SetPool(g_nss_pool.get());
+      gGroupByGidCache.SetOptions(opts);
+      gGroupByGidCache.SetPool(g_nss_pool.get());
+      gGroupByNameCache.SetOptions(opts);
+      gGroupByNameCache.SetPool(g_nss_pool.get());
       ActiveUidsSharded.reset_cleanup_thread(300 * 1000,
                                              "ActiveUidsSharded");
       ActiveTidentsSharded.reset_cleanup_thread(300 * 1000,
@@ -158,17 +297,12 @@ Mapping::Init()
 void
 Mapping::Reset()
 {
-  {
-    std::scoped_lock lock{gPhysicalUserNameCacheMutex, gPhysicalGroupNameCacheMutex};
-    gPhysicalGroupNameCache.clear();
-    gPhysicalUserNameCache.clear();
-    gPhysicalGroupIdCache.clear();
-    gPhysicalUserIdCache.clear();
-    gShardedPhysicalUidCache.clear();
-    gShardedPhysicalGidCache.clear();
-    gShardedNegativeGroupNameCache.clear();
-    gShardedNegativePhysicalUidCache.clear();
-  }
+  gPasswdByUidCache.Clear();
+  gPasswdByNameCache.Clear();
+  gGroupByGidCache.Clear();
+  gGroupByNameCache.Clear();
+  gShardedPhysicalUidCache.clear();
+  gShardedPhysicalGidCache.clear();
   ActiveTidentsSharded.clear();
   ActiveUidsSharded.clear();
 }
@@ -1394,56 +1528,15 @@ Mapping::Print(XrdOucString& stdOut, XrdOucString option)
 std::string
 Mapping::UidToUserName(uid_t uid, int& errc)
 {
-  errc = 0;
-  {
-    std::scoped_lock lock(gPhysicalUserNameCacheMutex);
-    auto kv = gPhysicalUserNameCache.find(uid);
-
-    if (kv != gPhysicalUserNameCache.end()) {
-      return kv->second;
-    }
-  }
-
-  if (auto user_ptr = gShardedNegativeUserNameCache.retrieve(uid)) {
-    return *user_ptr;
-  }
+  auto pw = gPasswdByUidCache.Get(uid, errc);
 
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  std::string uid_string = "";
-  struct passwd pwbuf;
-  struct passwd* pwbufp = 0;
-  (void) getpwuid_r(uid, &pwbuf, buffer, buflen, &pwbufp);
-
-  if (pwbufp == NULL) {
-    char buffer[131072];
-    int buflen = sizeof(buffer);
-    std::string uid_string = "";
-    struct passwd pwbuf;
-    struct passwd* pwbufp = 0;
-    {
-      if (getpwuid_r(uid, &pwbuf, buffer, buflen, &pwbufp) || (!pwbufp)) {
-        char suid[1024];
-        snprintf(suid, sizeof(suid) - 1, "%u", uid);
-        uid_string = suid;
-        errc = EINVAL;
-        gShardedNegativeUserNameCache.store(uid,
-                                            std::make_unique<std::string>(uid_string));
-        return uid_string;
-      } else {
-        uid_string = pwbuf.pw_name;
-        errc = 0;
-      }
-    }
-    cacheUserIds(uid, uid_string);
-    return uid_string;
-  } else {
-    uid_string = pwbuf.pw_name;
-    errc = 0;
+  if (!pw) {
+    errc = EINVAL;
+    return std::to_string(uid);
   }
 
-  cacheUserIds(uid, uid_string);
-  return uid_string;
+  errc = 0;
+  return pw->name;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1458,55 +1551,49 @@ Mapping::UidToUserName(uid_t uid, int& errc)
 
 /*----------------------------------------------------------------------------*/
 std::string
-Mapping::GidToGroupName(gid_t gid, int& errc, size_t buffersize)
+Mapping::GidToGroupName(gid_t gid, int& errc)
 {
-  errc = 0;
-  {
-    std::scoped_lock lock(gPhysicalGroupNameCacheMutex);
-    auto kv = gPhysicalGroupNameCache.find(gid);
+  auto name = gGroupByGidCache.Get(gid, errc);
 
-    if (kv != gPhysicalGroupNameCache.end()) {
-      return kv->second;
-    }
+  if (!name) {
+    errc = EINVAL;
+    return std::to_string(gid);
   }
 
-  if (auto group_ptr = gShardedNegativeGroupNameCache.retrieve(gid)) {
-    return *group_ptr;
-  }
+  errc = 0;
+  return *name;
+}
 
-  {
-    char buffer[buffersize];
-    int buflen = sizeof(buffer);
-    struct group grbuf;
-    struct group* grbufp = 0;
-    std::string gid_string = "";
-
-    if (getgrgid_r(gid, &grbuf, buffer, buflen, &grbufp) || (!grbufp)) {
-      if (errno == ERANGE) {
-        if (buffersize < (16 * 1024 * 1024)) {
-          // try doubling the buffer
-          return GidToGroupName(gid, errc, 2 * buffersize);
-        }
+//------------------------------------------------------------------------------
+// Convert a list of uids to user names
+//------------------------------------------------------------------------------
+std::map<uid_t, std::string>
+Mapping::UidsToUserNames(const std::vector<uid_t>& uids)
+{
+  std::map<uid_t, std::string> names;
 
-        // just give up here
-      }
+  for (const auto& elem : gPasswdByUidCache.GetMany(uids)) {
+    names[elem.first] = (elem.second ? elem.second->name :
+                         std::to_string(elem.first));
+  }
 
-      // cannot translate this name
-      char sgid[1024];
-      snprintf(sgid, sizeof(sgid) - 1, "%u", gid);
-      gid_string = sgid;
-      errc = EINVAL;
-      gShardedNegativeGroupNameCache.store(gid,
-                                           std::make_unique<std::string>(gid_string));
-      return gid_string;
-    } else {
-      gid_string = grbuf.gr_name;
-      errc = 0;
-    }
+  return names;
+}
+
+//------------------------------------------------------------------------------
+// Convert a list of gids to group names
+//------------------------------------------------------------------------------
+std::map<gid_t, std::string>
+Mapping::GidsToGroupNames(const std::vector<gid_t>& gids)
+{
+  std::map<gid_t, std::string> names;
 
-    cacheGroupIds(gid, gid_string);
-    return gid_string;
+  for (const auto& elem : gGroupByGidCache.GetMany(gids)) {
+    names[elem.first] = (elem.second ? *elem.second :
+                         std::to_string(elem.first));
   }
+
+  return names;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1523,52 +1610,20 @@ Mapping::GidToGroupName(gid_t gid, int& errc, size_t buffersize)
 uid_t
 Mapping::UserNameToUid(const std::string& username, int& errc)
 {
-  {
-    std::scoped_lock lock(gPhysicalUserNameCacheMutex);
-
-    if (auto kv = gPhysicalUserIdCache.find(username);
-        kv != gPhysicalUserIdCache.end()) {
-      return kv->second;
-    }
+  if (auto pw = gPasswdByNameCache.Get(username, errc)) {
+    errc = 0;
+    return pw->uid;
   }
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  uid_t uid = 99;
-  struct passwd pwbuf;
-  struct passwd* pwbufp = 0;
-  errc = 0;
-  (void) getpwnam_r(username.c_str(), &pwbuf, buffer, buflen, &pwbufp);
-
-  if (pwbufp == NULL) {
-    bool is_number = true;
-
-    for (size_t i = 0; i < username.length(); i++) {
-      if (!isdigit(username[i])) {
-        is_number = false;
-        break;
-      }
-    }
 
-    uid = atoi(username.c_str());
+  unsigned long id = 0;
 
-    if ((uid != 0) && (is_number)) {
-      errc = 0;
-      return uid;
-    } else {
-      errc = EINVAL;
-      uid = 99;
-      return uid;
-    }
-  } else {
-    uid = pwbuf.pw_uid;
+  if (IsNumericId(username, id)) {
     errc = 0;
+    return id;
   }
 
-  if (!errc) {
-    cacheUserIds(uid, username);
-  }
-
-  return uid;
+  errc = EINVAL;
+  return 99;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1585,51 +1640,20 @@ Mapping::UserNameToUid(const std::string& username, int& errc)
 gid_t
 Mapping::GroupNameToGid(const std::string& groupname, int& errc)
 {
-  {
-    std::scoped_lock lock(gPhysicalGroupNameCacheMutex);
-
-    if (auto kv = gPhysicalGroupIdCache.find(groupname);
-        kv != gPhysicalGroupIdCache.end()) {
-      return kv->second;
-    }
+  if (auto gid = gGroupByNameCache.Get(groupname, errc)) {
+    errc = 0;
+    return *gid;
   }
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  struct group grbuf;
-  struct group* grbufp = 0;
-  gid_t gid = 99;
-  errc = 0;
-  (void) getgrnam_r(groupname.c_str(), &grbuf, buffer, buflen, &grbufp);
-
-  if (!grbufp) {
-    bool is_number = true;
-
-    for (size_t i = 0; i < groupname.length(); i++) {
-      if (!isdigit(groupname[i])) {
-        is_number = false;
-        break;
-      }
-    }
 
-    gid = atoi(groupname.c_str());
+  unsigned long id = 0;
 
-    if ((gid != 0) && (is_number)) {
-      errc = 0;
-      return gid;
-    } else {
-      errc = EINVAL;
-      gid = 99;
-    }
-  } else {
-    gid = grbuf.gr_gid;
+  if (IsNumericId(groupname, id)) {
     errc = 0;
+    return id;
   }
 
-  if (!errc) {
-    cacheGroupIds(gid, groupname);
-  }
-
-  return gid;
+  errc = EINVAL;
+  return 99;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -2058,14 +2082,7 @@ Mapping::getPhysicalIdShards(const std::string& name, VirtualIdentity& vid)
     return;
   }
 
-  struct passwd passwdinfo;
-
-  char buffer[131072];
-
-  size_t buflen = sizeof(buffer);
-
-  memset(&passwdinfo, 0, sizeof(passwdinfo));
-
+  int errc = 0;
   eos_static_debug("find in uid cache %s cache shard=%d", name.c_str(),
                    gShardedPhysicalUidCache.calculateShard(name));
 
@@ -2123,31 +2140,31 @@ Mapping::getPhysicalIdShards(const std::string& name, VirtualIdentity& vid)
 
           if (startsWith(name, "*") || startsWith(name, "_")) {
             idp.reset(new id_pair((bituser >> 22) & 0xfffff, (bituser >> 6) & 0xffff));
-            struct passwd* pwbufp = 0;
+            auto pw = gPasswdByUidCache.Get(idp->uid, errc);
 
-            if (getpwuid_r(idp->uid, &passwdinfo, buffer, buflen, &pwbufp) || (!pwbufp)) {
+            if (!pw) {
               return;
             }
 
-            cacheUserIds(passwdinfo.pw_uid, passwdinfo.pw_name);
-            vid.uid_string = passwdinfo.pw_name;
+            gPasswdByNameCache.Store(pw->name, *pw);
+            vid.uid_string = pw->name;
 
-            if (idp->gid != passwdinfo.pw_gid) {
+            if (idp->gid != pw->gid) {
               // add the primary group if it is not the desired one
-              vid.allowed_gids.insert(passwdinfo.pw_gid);
+              vid.allowed_gids.insert(pw->gid);
             }
           } else {
             // only user id got forwarded, we retrieve the corresponding group
             uid_t ruid = (bituser >> 6) & 0xfffffffff;
-            struct passwd* pwbufp = 0;
+            auto pw = gPasswdByUidCache.Get(ruid, errc);
 
-            if (getpwuid_r(ruid, &passwdinfo, buffer, buflen, &pwbufp) || (!pwbufp)) {
+            if (!pw) {
               return;
             }
 
-            idp.reset(new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid));
-            vid.uid_string = passwdinfo.pw_name;
-            cacheUserIds(passwdinfo.pw_uid, passwdinfo.pw_name);
+            idp.reset(new id_pair(pw->uid, pw->gid));
+            vid.uid_string = pw->name;
+            gPasswdByNameCache.Store(pw->name, *pw);
           }
 
           eos_static_debug("using base64 mapping %s %d %d", name.c_str(), idp->uid,
@@ -2188,27 +2205,19 @@ Mapping::getPhysicalIdShards(const std::string& name, VirtualIdentity& vid)
     }
 
     if (use_pw) {
-      if (auto ptr = gShardedNegativePhysicalUidCache.retrieve(name)) {
-        eos_static_debug("msg=\"found in negative user name cache\" name=%s",
-                         name.c_str());
-        return;
-      }
+      auto pw = gPasswdByNameCache.Get(name, errc);
 
-      struct passwd* pwbufp = 0;
-
-      {
-        if (getpwnam_r(name.c_str(), &passwdinfo, buffer, buflen, &pwbufp) ||
-            (!pwbufp)) {
-          gShardedNegativePhysicalUidCache.store(name, std::make_unique<bool>(true));
-          return;
-        }
+      if (!pw) {
+        eos_static_debug("msg=\"user name not resolved\" name=%s errc=%d",
+                         name.c_str(), errc);
+        return;
       }
 
-      idp.reset(new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid));
+      idp.reset(new id_pair(pw->uid, pw->gid));
       vid.uid = idp->uid;
       vid.gid = idp->gid;
-      vid.uid_string = passwdinfo.pw_name;
-      cacheUserIds(passwdinfo.pw_uid, passwdinfo.pw_name);
+      vid.uid_string = pw->name;
+      gPasswdByUidCache.Store(pw->uid, *pw);
     }
   }
 
@@ -2273,19 +2282,17 @@ Mapping::getPhysicalUidGids(const char* name, VirtualIdentity& vid)
 }
 
 void
-Mapping::cacheUserIds(uid_t uid, const std::string& username)
+Mapping::cacheUserIds(const pw_entry& pw)
 {
-  std::scoped_lock lock(gPhysicalUserNameCacheMutex);
-  gPhysicalUserIdCache[username] = uid;
-  gPhysicalUserNameCache[uid] = username;
+  gPasswdByUidCache.Store(pw.uid, pw);
+  gPasswdByNameCache.Store(pw.name, pw);
 }
 
 void
 Mapping::cacheGroupIds(gid_t gid, const std::string& groupname)
 {
-  std::scoped_lock lock(gPhysicalGroupNameCacheMutex);
-  gPhysicalGroupIdCache[groupname] = gid;
-  gPhysicalGroupNameCache[gid] = groupname;
+  gGroupByGidCache.Store(gid, groupname);
+  gGroupByNameCache.Store(groupname, gid);
 }
 
 void
@@ -26,6 +26,7 @@
 #include "common/Namespace.hh"
 #include "common/RWMutex.hh"
 #include "common/ShardedCache.hh"
+#include "common/NssCache.hh"
 #include "common/OAuth.hh"
 #include "common/VirtualIdentity.hh"
 #include "XrdOuc/XrdOucString.hh"
@@ -33,6 +34,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 //! Forward declaration
 class XrdSecEntity;
@@ -187,7 +189,6 @@ public:
   // ---------------------------------------------------------------------------
   //! A cache for physical user id caching (e.g. from user name to uid)
   static ShardedCache<std::string, id_pair> gShardedPhysicalUidCache;
-  static ShardedCache<std::string, bool> gShardedNegativePhysicalUidCache;
 
   // ---------------------------------------------------------------------------
   //! A cache for physical group id caching (e.g. from group name to gid)
@@ -195,24 +196,24 @@ public:
   static ShardedCache<std::string, gid_set> gShardedPhysicalGidCache;
 
   // ---------------------------------------------------------------------------
-  //! A mutex protecting the physical id->name caches
+  //! Password database entry as returned by the NSS
   // ---------------------------------------------------------------------------
-  static std::mutex
-  gPhysicalUserNameCacheMutex; //< Mutex protecting UserId& UserName cache
-  static std::mutex
-  gPhysicalGroupNameCacheMutex; //< Mutex protecting GroupId& GroupName cache
+  struct pw_entry {
+    uid_t uid {99};
+    gid_t gid {99};
+    std::string name;
+  };
 
   // ---------------------------------------------------------------------------
-  //! A cache for physical user name caching (e.g. from uid to name)
-  static std::map<uid_t, std::string> gPhysicalUserNameCache;
-  static std::map<std::string, uid_t> gPhysicalUserIdCache;
-  static ShardedCache<uid_t, std::string> gShardedNegativeUserNameCache;
-  // ---------------------------------------------------------------------------
-  //! A cache for physical group id caching (e.g. from gid name to name)
+  //! Caches for the NSS lookups (passwd entry by uid and by name, group name
+  //! by gid and gid by group name) with negative entries. The lookups are
+  //! done in a bounded thread pool so that a slow NSS backend cannot block
+  //! all the calling threads.
   // ---------------------------------------------------------------------------
-  static std::map<gid_t, std::string> gPhysicalGroupNameCache;
-  static std::map<std::string, gid_t> gPhysicalGroupIdCache;
-  static ShardedCache<gid_t, std::string> gShardedNegativeGroupNameCache;
+  static NssCache<uid_t, pw_entry> gPasswdByUidCache;
+  static NssCache<std::string, pw_entry> gPasswdByNameCache;
+  static NssCache<gid_t, std::string> gGroupByGidCache;
+  static NssCache<std::string, gid_t> gGroupByNameCache;
 
   // ---------------------------------------------------------------------------
   //! RWMutex protecting all global hash maps
@@ -321,8 +322,21 @@ public:
   // ---------------------------------------------------------------------------
   //! Convert a gid to a group name
   // ---------------------------------------------------------------------------
-  static std::string GidToGroupName(uid_t gid, int& errc,
-                                    size_t buffersize = 128 * 1024);
+  static std::string GidToGroupName(uid_t gid, int& errc);
+
+  // ---------------------------------------------------------------------------
+  //! Convert a list of uids to user names, the missing entries are resolved
+  //! in parallel. Ids which can not be resolved map to their numeric string.
+  // ---------------------------------------------------------------------------
+  static std::map<uid_t, std::string>
+  UidsToUserNames(const std::vector<uid_t>& uids);
+
+  // ---------------------------------------------------------------------------
+  //! Convert a list of gids to group names, the missing entries are resolved
+  //! in parallel. Ids which can not be resolved map to their numeric string.
+  // ---------------------------------------------------------------------------
+  static std::map<gid_t, std::string>
+  GidsToGroupNames(const std::vector<gid_t>& gids);
 
   // ---------------------------------------------------------------------------
   //! Convert a user name to a uid
@@ -377,7 +391,7 @@ public:
                                   const std::string& uid_key_name,
                                   const std::string& gid_key_name);
 
-  static void cacheUserIds(uid_t uid, const std::string& username);
+  static void cacheUserIds(const pw_entry& pw);
   static void cacheGroupIds(gid_t gid, const std::string& groupname);
 
 
@@ -0,0 +1,557 @@
+//------------------------------------------------------------------------------
+//! @file NssCache.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include "common/ThreadPool.hh"
+#include "common/SteadyClock.hh"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Configuration of the NssCache objects
+//------------------------------------------------------------------------------
+struct NssCacheOptions {
+  std::chrono::milliseconds mPositiveTtl {std::chrono::hours(1)};
+  std::chrono::milliseconds mNegativeTtl {std::chrono::minutes(5)};
+  //! Positive entries are refreshed in the background during this interval
+  //! before their expiry
+  std::chrono::milliseconds mRefreshAhead {std::chrono::minutes(5)};
+  //! Maximum time a caller waits for a lookup
+  std::chrono::milliseconds mTimeout {std::chrono::seconds(5)};
+  //! Maximum number of lookups queued in the pool, beyond this limit misses
+  //! are served from stale entries or fail with EAGAIN and refreshes are
+  //! skipped. Lookups are never done in the caller's thread.
+  uint64_t mMaxQueued {1024};
+};
+
+//------------------------------------------------------------------------------
+//! Statistics of the NssCache objects
+//------------------------------------------------------------------------------
+struct NssCacheStats {
+  uint64_t mHits {0};
+  uint64_t mNegativeHits {0};
+  uint64_t mMisses {0};
+  uint64_t mTimeouts {0};
+  uint64_t mRefreshes {0};
+  uint64_t mOverloads {0}; ///< Misses not looked up, pool overloaded
+};
+
+//------------------------------------------------------------------------------
+//! @brief Concurrent cache for identity lookups which end up in NSS calls
+//! (getpwnam_r, getgrgid_r etc.) that can block for a long time when the
+//! backend is LDAP or SSSD.
+//!
+//! - storage is sharded, each shard has its own mutex
+//! - positive and negative entries are cached with separate TTLs
+//! - concurrent misses for the same key are coalesced into a single lookup
+//! - lookups run in a bounded thread pool and callers wait at most the given
+//!   timeout, after which a stale value is returned if there is one
+//! - when the pool is overloaded misses fail fast unless there is a stale
+//!   value, the entry is looked up by a later call
+//! - positive entries close to expiry are refreshed asynchronously so that
+//!   popular identities never expire in the caller's thread
+//------------------------------------------------------------------------------
+template<typename Key, typename Value>
+class NssCache
+{
+public:
+  //! Function doing the actual lookup, returns std::nullopt if key not found
+  using ResolverT = std::function<std::optional<Value>(const Key&)>;
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  using Options = NssCacheOptions;
+  using Stats = NssCacheStats;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param resolver function doing the actual lookup
+  //! @param shard_bits log2 of the number of shards
+  //! @param fake_clock if true use synthetic clock for testing
+  //----------------------------------------------------------------------------
+  NssCache(ResolverT resolver, uint8_t shard_bits = 6,
+           bool fake_clock = false):
+    mResolver(resolver), mShards(1ull << shard_bits), mClock(fake_clock)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor - wait for all lookups referencing this object to finish
+  //----------------------------------------------------------------------------
+  ~NssCache()
+  {
+    while (mInFlight) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Replace the resolver function, must be called before any lookup is done
+  //! e.g. for simulating a slow NSS backend in benchmarks
+  //----------------------------------------------------------------------------
+  void SetResolver(ResolverT resolver)
+  {
+    mResolver = resolver;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set the pool used for running lookups, if none is set a single thread
+  //! pool owned by the cache is created on first use
+  //----------------------------------------------------------------------------
+  void SetPool(eos::common::ThreadPool* pool)
+  {
+    mPool = pool;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Update cache options
+  //----------------------------------------------------------------------------
+  void SetOptions(const Options& opts)
+  {
+    std::unique_lock<std::mutex> lock(mOptionsMutex);
+    mOptions = opts;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get value for the given key
+  //!
+  //! @param key lookup key
+  //! @param errc 0 if found, ENOENT if key does not exist, ETIMEDOUT if the
+  //!        lookup did not finish in time and there is no stale value,
+  //!        EAGAIN if the lookup pool is overloaded and there is no stale value
+  //!
+  //! @return value if found, otherwise std::nullopt
+  //----------------------------------------------------------------------------
+  std::optional<Value> Get(const Key& key, int& errc)
+  {
+    std::optional<Value> value;
+    auto future = Lookup(key, value, errc);
+
+    if (!future.valid()) {
+      return value;
+    }
+
+    return Wait(key, future, GetOptions().mTimeout, errc);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get values for a batch of keys, all the missing keys are resolved in
+  //! parallel and the caller waits at most one timeout for the whole batch.
+  //!
+  //! @param keys list of keys
+  //!
+  //! @return map of key to value, std::nullopt for missing keys
+  //----------------------------------------------------------------------------
+  std::map<Key, std::optional<Value>> GetMany(const std::vector<Key>& keys)
+  {
+    std::map<Key, std::optional<Value>> result;
+    std::map<Key, std::shared_future<std::optional<Value>>> pending;
+    int errc = 0;
+
+    for (const auto& key : keys) {
+      std::optional<Value> value;
+      auto future = Lookup(key, value, errc);
+
+      if (future.valid()) {
+        pending.emplace(key, future);
+      } else {
+        result[key] = value;
+      }
+    }
+
+    const TimePoint deadline = std::chrono::steady_clock::now() +
+                               GetOptions().mTimeout;
+
+    for (auto& elem : pending) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>
+                       (deadline - std::chrono::steady_clock::now());
+
+      if (remaining.count() < 0) {
+        remaining = std::chrono::milliseconds(0);
+      }
+
+      result[elem.first] = Wait(elem.first, elem.second, remaining, errc);
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Store positive entry
+  //----------------------------------------------------------------------------
+  void Store(const Key& key, const Value& value)
+  {
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    auto& entry = shard.mEntries[key];
+    entry.mValid = true;
+    entry.mValue = value;
+    entry.mExpiry = SteadyClock::now(&mClock) + GetOptions().mPositiveTtl;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Store negative entry
+  //----------------------------------------------------------------------------
+  void StoreNegative(const Key& key)
+  {
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    auto& entry = shard.mEntries[key];
+    entry.mValid = true;
+    entry.mValue.reset();
+    entry.mExpiry = SteadyClock::now(&mClock) + GetOptions().mNegativeTtl;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop entry from the cache
+  //----------------------------------------------------------------------------
+  void Invalidate(const Key& key)
+  {
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(key);
+
+    if ((it != shard.mEntries.end()) && !it->second.mPending.valid()) {
+      shard.mEntries.erase(it);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries which don't have a lookup in progress
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    for (auto& shard : mShards) {
+      std::unique_lock<std::mutex> lock(shard.mMutex);
+
+      for (auto it = shard.mEntries.begin(); it != shard.mEntries.end();) {
+        if (it->second.mPending.valid()) {
+          it->second.mValid = false;
+          ++it;
+        } else {
+          it = shard.mEntries.erase(it);
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop expired entries which are not being looked up
+  //----------------------------------------------------------------------------
+  void ExpireEntries()
+  {
+    const TimePoint now = SteadyClock::now(&mClock);
+
+    for (auto& shard : mShards) {
+      std::unique_lock<std::mutex> lock(shard.mMutex);
+      SweepShard(shard, now);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of cached entries
+  //----------------------------------------------------------------------------
+  size_t Size()
+  {
+    size_t count = 0;
+
+    for (auto& shard : mShards) {
+      std::unique_lock<std::mutex> lock(shard.mMutex);
+      count += shard.mEntries.size();
+    }
+
+    return count;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get cache statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats() const
+  {
+    Stats stats;
+    stats.mHits = mHits;
+    stats.mNegativeHits = mNegativeHits;
+    stats.mMisses = mMisses;
+    stats.mTimeouts = mTimeouts;
+    stats.mRefreshes = mRefreshes;
+    stats.mOverloads = mOverloads;
+    return stats;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get clock reference for testing purposes
+  //----------------------------------------------------------------------------
+  inline SteadyClock& GetClock()
+  {
+    return mClock;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Cache entry
+  //----------------------------------------------------------------------------
+  struct Entry {
+    bool mValid {false}; ///< Entry holds a positive or negative result
+    std::optional<Value> mValue; ///< Cached value, empty for negative entries
+    TimePoint mExpiry; ///< Expiry time of the cached result
+    std::shared_future<std::optional<Value>> mPending; ///< Lookup in progress
+  };
+
+  //----------------------------------------------------------------------------
+  //! Cache shard
+  //----------------------------------------------------------------------------
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<Key, Entry> mEntries;
+    TimePoint mLastSweep; ///< Last time expired entries were dropped
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get shard for the given key
+  //----------------------------------------------------------------------------
+  Shard& GetShard(const Key& key)
+  {
+    return mShards[std::hash<Key>()(key) % mShards.size()];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop expired entries of the given shard which are not being looked up.
+  //! Must be called with the shard mutex locked.
+  //----------------------------------------------------------------------------
+  void SweepShard(Shard& shard, TimePoint now)
+  {
+    shard.mLastSweep = now;
+
+    for (auto it = shard.mEntries.begin(); it != shard.mEntries.end();) {
+      if (!it->second.mPending.valid() && (it->second.mExpiry <= now)) {
+        it = shard.mEntries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get copy of the current options
+  //----------------------------------------------------------------------------
+  Options GetOptions()
+  {
+    std::unique_lock<std::mutex> lock(mOptionsMutex);
+    return mOptions;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get cached value for the given key or start a lookup
+  //!
+  //! @param key lookup key
+  //! @param value set to the result if no wait is needed
+  //! @param errc set to ENOENT if the key does not exist
+  //!
+  //! @return valid future if the caller needs to wait for a lookup, otherwise
+  //!         an invalid future and the result is stored in value
+  //----------------------------------------------------------------------------
+  std::shared_future<std::optional<Value>>
+  Lookup(const Key& key, std::optional<Value>& value, int& errc)
+  {
+    const Options opts = GetOptions();
+    const TimePoint now = SteadyClock::now(&mClock);
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+
+    // Expired entries are dropped lazily so that negative entries for
+    // random names don't accumulate
+    if (now - shard.mLastSweep > opts.mNegativeTtl) {
+      SweepShard(shard, now);
+    }
+
+    auto& entry = shard.mEntries[key];
+    errc = 0;
+
+    if (entry.mValid && (now < entry.mExpiry)) {
+      value = entry.mValue;
+
+      if (entry.mValue) {
+        ++mHits;
+
+        // Refresh ahead popular entries which are about to expire
+        if (!entry.mPending.valid() &&
+            (now + opts.mRefreshAhead >= entry.mExpiry) &&
+            (mQueued < opts.mMaxQueued)) {
+          ++mRefreshes;
+          entry.mPending = Submit(key);
+        }
+      } else {
+        ++mNegativeHits;
+        errc = ENOENT;
+      }
+
+      return std::shared_future<std::optional<Value>>();
+    }
+
+    ++mMisses;
+
+    if (!entry.mPending.valid()) {
+      if (mQueued < opts.mMaxQueued) {
+        entry.mPending = Submit(key);
+      } else {
+        // Pool overloaded - don't block the caller on the NSS backend, serve
+        // the stale value if there is one
+        ++mOverloads;
+        value = entry.mValue;
+        errc = (value ? 0 : (entry.mValid ? ENOENT : EAGAIN));
+        return std::shared_future<std::optional<Value>>();
+      }
+    }
+
+    return entry.mPending;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait for a lookup to finish
+  //!
+  //! @param key lookup key
+  //! @param future future of the lookup
+  //! @param timeout maximum wait time
+  //! @param errc 0 if found, ENOENT if not found, ETIMEDOUT on timeout
+  //!
+  //! @return value if found, otherwise std::nullopt
+  //----------------------------------------------------------------------------
+  std::optional<Value>
+  Wait(const Key& key, std::shared_future<std::optional<Value>>& future,
+       std::chrono::milliseconds timeout, int& errc)
+  {
+    if (future.wait_for(timeout) == std::future_status::ready) {
+      auto value = future.get();
+      errc = (value ? 0 : ENOENT);
+      return value;
+    }
+
+    ++mTimeouts;
+    // Return stale value if there is one
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(key);
+
+    if ((it != shard.mEntries.end()) && it->second.mValue) {
+      errc = 0;
+      return it->second.mValue;
+    }
+
+    errc = ETIMEDOUT;
+    return std::nullopt;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Submit a lookup to the pool. Must be called with the shard mutex locked.
+  //----------------------------------------------------------------------------
+  std::shared_future<std::optional<Value>> Submit(const Key& key)
+  {
+    ++mQueued;
+    ++mInFlight;
+    std::function<std::optional<Value>(void)> task = [this, key]() {
+      --mQueued;
+      std::optional<Value> value;
+
+      try {
+        value = mResolver(key);
+      } catch (...) {
+        value.reset();
+      }
+
+      Update(key, value, true);
+      --mInFlight;
+      return value;
+    };
+    return GetPool()->PushTask(task).share();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the pool running the lookups
+  //----------------------------------------------------------------------------
+  eos::common::ThreadPool* GetPool()
+  {
+    if (mPool) {
+      return mPool;
+    }
+
+    std::call_once(mOwnPoolInit, [this]() {
+      mOwnPool.reset(new eos::common::ThreadPool(1, 1, 10, 6, 10, "NssLookup"));
+    });
+    return mOwnPool.get();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Update cache entry with the result of a lookup
+  //!
+  //! @param key lookup key
+  //! @param value result of the lookup
+  //! @param clear_pending if true mark the pending lookup as done
+  //----------------------------------------------------------------------------
+  void Update(const Key& key, const std::optional<Value>& value,
+              bool clear_pending = false)
+  {
+    const Options opts = GetOptions();
+    auto& shard = GetShard(key);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    auto& entry = shard.mEntries[key];
+    entry.mValid = true;
+    entry.mValue = value;
+    entry.mExpiry = SteadyClock::now(&mClock) +
+                    (value ? opts.mPositiveTtl : opts.mNegativeTtl);
+
+    if (clear_pending) {
+      entry.mPending = std::shared_future<std::optional<Value>>();
+    }
+  }
+
+  ResolverT mResolver; ///< Function doing the actual lookup
+  std::vector<Shard> mShards; ///< Cache shards
+  SteadyClock mClock; ///< Clock wrapper also used for testing
+  eos::common::ThreadPool* mPool {nullptr}; ///< Pool running the lookups
+  std::once_flag mOwnPoolInit; ///< Creation of the default pool
+  //! Default pool used if none is set
+  std::unique_ptr<eos::common::ThreadPool> mOwnPool;
+  std::mutex mOptionsMutex; ///< Mutex protecting the options
+  Options mOptions; ///< Cache configuration
+  std::atomic<uint64_t> mQueued {0}; ///< Lookups queued in the pool
+  std::atomic<uint64_t> mInFlight {0}; ///< Lookups referencing this object
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mNegativeHits {0};
+  std::atomic<uint64_t> mMisses {0};
+  std::atomic<uint64_t> mTimeouts {0};
+  std::atomic<uint64_t> mRefreshes {0};
+  std::atomic<uint64_t> mOverloads {0};
+};
+
+EOSCOMMONNAMESPACE_END
@@ -28,6 +28,8 @@
 #include <atomic>
 #include <thread>
 #include <set>
+#include <chrono>
+#include <mutex>
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -164,4 +166,153 @@ public:
   std::atomic<uint64_t> mLastTimestampUs;
 };
 
+//------------------------------------------------------------------------------
+//! Token bucket rate limiter - non-blocking variant which can be used to take
+//! admission decisions. The bucket refills at the configured rate up to a
+//! maximum burst size. The object is not thread-safe, synchronization is the
+//! responsibility of the caller.
+//------------------------------------------------------------------------------
+class TokenBucket
+{
+public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param rate refill rate in tokens per second, 0 means unlimited
+  //! @param burst maximum number of tokens, 0 means one second worth of tokens
+  //! @param now current time point
+  //----------------------------------------------------------------------------
+  TokenBucket(double rate = 0, double burst = 0,
+              TimePoint now = std::chrono::steady_clock::now())
+  {
+    Configure(rate, burst);
+    mTokens = mBurst;
+    mLastRefill = now;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Update rate and burst size keeping the current tokens
+  //!
+  //! @param rate refill rate in tokens per second, 0 means unlimited
+  //! @param burst maximum number of tokens, 0 means one second worth of tokens
+  //----------------------------------------------------------------------------
+  void Configure(double rate, double burst)
+  {
+    mRate = (rate < 0) ? 0 : rate;
+    mBurst = (burst > 0) ? burst : mRate;
+
+    if (mBurst < 1) {
+      mBurst = 1;
+    }
+
+    if (mTokens > mBurst) {
+      mTokens = mBurst;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the given number of tokens is available without consuming them
+  //!
+  //! @param now current time point
+  //! @param tokens number of tokens requested
+  //!
+  //! @return true if tokens are available, otherwise false
+  //----------------------------------------------------------------------------
+  bool CanConsume(TimePoint now, double tokens = 1)
+  {
+    Refill(now);
+    return (IsUnlimited() || (mTokens >= tokens));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Consume tokens from the bucket, this is allowed to go into debt so that
+  //! a set of hierarchical buckets can be updated consistently
+  //!
+  //! @param now current time point
+  //! @param tokens number of tokens consumed
+  //----------------------------------------------------------------------------
+  void Consume(TimePoint now, double tokens = 1)
+  {
+    Refill(now);
+
+    if (!IsUnlimited()) {
+      mTokens -= tokens;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get time until the given number of tokens becomes available
+  //!
+  //! @param now current time point
+  //! @param tokens number of tokens requested
+  //!
+  //! @return wait duration, zero if tokens available
+  //----------------------------------------------------------------------------
+  std::chrono::microseconds TimeToAvailable(TimePoint now, double tokens = 1)
+  {
+    if (CanConsume(now, tokens)) {
+      return std::chrono::microseconds(0);
+    }
+
+    return std::chrono::microseconds((uint64_t)
+                                     (1e6 * (tokens - mTokens) / mRate) + 1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the bucket enforces any limit
+  //----------------------------------------------------------------------------
+  inline bool IsUnlimited() const
+  {
+    return (mRate == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Getters
+  //----------------------------------------------------------------------------
+  inline double GetRate() const
+  {
+    return mRate;
+  }
+
+  inline double GetBurst() const
+  {
+    return mBurst;
+  }
+
+  inline double GetTokens(TimePoint now)
+  {
+    Refill(now);
+    return mTokens;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Refill the bucket with the tokens accumulated since the last refill
+  //!
+  //! @param now current time point
+  //----------------------------------------------------------------------------
+  void Refill(TimePoint now)
+  {
+    if (now <= mLastRefill) {
+      return;
+    }
+
+    double elapsed_sec = std::chrono::duration_cast<std::chrono::microseconds>
+                         (now - mLastRefill).count() / 1e6;
+    mLastRefill = now;
+    mTokens += elapsed_sec * mRate;
+
+    if (mTokens > mBurst) {
+      mTokens = mBurst;
+    }
+  }
+
+  double mRate {0}; ///< Refill rate in tokens per second
+  double mBurst {1}; ///< Maximum number of tokens
+  double mTokens {0}; ///< Currently available tokens, can be negative
+  TimePoint mLastRefill; ///< Timestamp of the last refill
+};
+
 EOSCOMMONNAMESPACE_END
@@ -0,0 +1,1645 @@
+//------------------------------------------------------------------------------
+//! @file HttpEventServer.cc
+//! @brief Event-driven HTTP/1.1 server with a fixed worker pool
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/http/HttpEventServer.hh"
+#include "common/ThreadPool.hh"
+#include "common/Logging.hh"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <strings.h>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+EOSCOMMONNAMESPACE_BEGIN
+
+namespace
+{
+//! Epoll tags of the listening socket and of the reactor wake-up descriptor,
+//! connections are tagged with their id which starts at 1
+constexpr uint64_t cListenTag = 0;
+constexpr uint64_t cWakeTag = UINT64_MAX;
+//! Size of a single socket read
+constexpr size_t cReadSize = 64 * 1024;
+//! Buffers larger than this are released once empty
+constexpr size_t cMaxIdleBuffer = 1024 * 1024;
+
+//! Decoding state of a chunked request body
+enum ChunkState {
+  kChunkSize, kChunkData, kChunkDataEnd, kChunkTrailer
+};
+
+//------------------------------------------------------------------------------
+// Decode %XX escapes and optionally '+' as space
+//------------------------------------------------------------------------------
+std::string
+Unescape(const std::string& in, bool plus_as_space)
+{
+  std::string out;
+  out.reserve(in.size());
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    if ((in[i] == '%') && (i + 2 < in.size()) &&
+        isxdigit((unsigned char) in[i + 1]) &&
+        isxdigit((unsigned char) in[i + 2])) {
+      out += (char) std::stoi(in.substr(i + 1, 2), nullptr, 16);
+      i += 2;
+    } else if (plus_as_space && (in[i] == '+')) {
+      out += ' ';
+    } else {
+      out += in[i];
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Decode the keys and values of a query string, the result has the same
+// format libmicrohttpd passes to the handlers
+//------------------------------------------------------------------------------
+std::string
+DecodeQuery(const std::string& query)
+{
+  std::string out;
+  size_t pos = 0;
+
+  while (pos < query.size()) {
+    size_t end = query.find('&', pos);
+
+    if (end == std::string::npos) {
+      end = query.size();
+    }
+
+    std::string arg = query.substr(pos, end - pos);
+    pos = end + 1;
+
+    if (arg.empty()) {
+      continue;
+    }
+
+    if (out.length()) {
+      out += "&";
+    }
+
+    size_t eq = arg.find('=');
+
+    if (eq == std::string::npos) {
+      out += Unescape(arg, true);
+    } else {
+      out += Unescape(arg.substr(0, eq), true);
+      out += "=";
+      out += Unescape(arg.substr(eq + 1), true);
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Trim spaces and tabs
+//------------------------------------------------------------------------------
+std::string
+Trim(const std::string& in)
+{
+  size_t begin = in.find_first_not_of(" \t");
+
+  if (begin == std::string::npos) {
+    return "";
+  }
+
+  size_t end = in.find_last_not_of(" \t");
+  return in.substr(begin, end - begin + 1);
+}
+
+//------------------------------------------------------------------------------
+// Lower case copy of a string
+//------------------------------------------------------------------------------
+std::string
+Lower(std::string in)
+{
+  for (auto& c : in) {
+    c = tolower(c);
+  }
+
+  return in;
+}
+}
+
+//------------------------------------------------------------------------------
+//! State of one client connection. All members are protected by the mutex,
+//! the reactor and the worker running the current exchange both use it.
+//------------------------------------------------------------------------------
+struct HttpExchange::Connection :
+  public std::enable_shared_from_this<HttpExchange::Connection> {
+  Connection(HttpEventServer* server, size_t reactor, uint64_t id, int fd):
+    mServer(server), mReactor(reactor), mId(id), mFd(fd),
+    mLastActive(time(nullptr))
+  {}
+
+  ~Connection()
+  {
+    if (mFd >= 0) {
+      (void) ::close(mFd);
+    }
+  }
+
+  HttpEventServer* mServer; ///< Owning server
+  const size_t mReactor; ///< Index of the reactor polling the connection
+  const uint64_t mId; ///< Connection id used as epoll tag
+  int mFd; ///< Socket, -1 once closed
+  struct sockaddr_storage mAddr; ///< Client address
+  std::string mClientIp; ///< Numeric client address
+  std::mutex mMutex;
+  std::condition_variable mCond; ///< Signals body input and output progress
+  time_t mLastActive; ///< Time of the last socket activity
+  std::string mIn; ///< Raw input not consumed yet
+  std::string mOut; ///< Pending output
+  size_t mOutPos {0}; ///< Position of the first unsent output byte
+  bool mClosed {false}; ///< Socket is closed
+  bool mReadPaused {false}; ///< Reading stopped on a full input buffer
+  bool mPeerClosed {false}; ///< Client shut down its sending side
+  bool mCloseAfter {false}; ///< Close once the pending output is sent
+  bool mBusy {false}; ///< An exchange is running
+  // Request body of the running exchange
+  bool mBodyDone {true}; ///< Whole body decoded
+  bool mChunked {false}; ///< Body uses the chunked transfer encoding
+  int mChunkState {kChunkSize}; ///< Chunked decoding state
+  uint64_t mBodyLeft {0}; ///< Bytes left of the body or of the chunk
+  std::string mBody; ///< Decoded body not read by the handler yet
+  size_t mBodyPos {0}; ///< Position of the first unread body byte
+  bool mContinue {false}; ///< Client expects a 100-continue
+  // Response of the running exchange
+  bool mKeepAlive {true}; ///< Keep the connection after the response
+  bool mHead {false}; ///< Request is a HEAD, suppress the response body
+  bool mResponseStarted {false}; ///< Status line was sent
+  bool mResponseChunked {false}; ///< Response uses the chunked encoding
+  bool mResponseNoBody {false}; ///< Response can not carry a body
+  int64_t mResponseLeft {-1}; ///< Response body bytes left, -1 if unknown
+};
+
+//------------------------------------------------------------------------------
+//! Epoll loop serving a subset of the connections. All reactors wait on the
+//! listening socket, the kernel wakes only one of them per new connection.
+//------------------------------------------------------------------------------
+class HttpEventServer::Reactor
+{
+public:
+  Reactor(HttpEventServer* server, size_t index):
+    mServer(server), mIndex(index)
+  {}
+
+  ~Reactor()
+  {
+    Join();
+
+    if (mEpollFd >= 0) {
+      (void) ::close(mEpollFd);
+    }
+
+    if (mWakeFd >= 0) {
+      (void) ::close(mWakeFd);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Create the epoll instance and register the listening socket
+  //----------------------------------------------------------------------------
+  bool Init(int listen_fd)
+  {
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if ((mEpollFd < 0) || (mWakeFd < 0)) {
+      return false;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.u64 = cListenTag;
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, listen_fd, &ev)) {
+      // Kernels before 4.5 reject EPOLLEXCLUSIVE
+      ev.events = EPOLLIN;
+
+      if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, listen_fd, &ev)) {
+        return false;
+      }
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.u64 = cWakeTag;
+    return (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev) == 0);
+  }
+
+  void Start()
+  {
+    mThread = std::thread(&Reactor::Run, this);
+  }
+
+  void Join()
+  {
+    Wake();
+
+    if (mThread.joinable()) {
+      mThread.join();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Hand a new connection over to this reactor. Called from any thread.
+  //----------------------------------------------------------------------------
+  void Adopt(const std::shared_ptr<Connection>& conn)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mPostMutex);
+      mAdopted.push_back(conn);
+    }
+    Wake();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Ask the reactor to look at a connection again, either to resume reading
+  //! or to drop it once closed. Called from any thread.
+  //----------------------------------------------------------------------------
+  void Post(uint64_t id)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mPostMutex);
+      mPosted.push_back(id);
+    }
+    Wake();
+  }
+
+  void Wake()
+  {
+    uint64_t one = 1;
+
+    if (mWakeFd >= 0) {
+      (void) !::write(mWakeFd, &one, sizeof(one));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Close all connections, called once the thread is stopped
+  //----------------------------------------------------------------------------
+  void CloseAll()
+  {
+    for (auto& elem : mConns) {
+      std::lock_guard<std::mutex> lock(elem.second->mMutex);
+      mServer->Close(*elem.second);
+    }
+  }
+
+  void Clear()
+  {
+    mConns.clear();
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Register a new connection, called by the reactor thread. Data which
+  //! arrived before the registration is reported right away by epoll.
+  //----------------------------------------------------------------------------
+  void Add(const std::shared_ptr<Connection>& conn)
+  {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.u64 = conn->mId;
+    mConns.emplace(conn->mId, conn);
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, conn->mFd, &ev)) {
+      eos_static_err("msg=\"failed to register http connection\" errno=%d",
+                     errno);
+      std::lock_guard<std::mutex> lock(conn->mMutex);
+      mServer->Close(*conn);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Event loop
+  //----------------------------------------------------------------------------
+  void Run()
+  {
+    struct epoll_event events[256];
+    time_t last_scan = time(nullptr);
+
+    while (mServer->mRunning) {
+      int n = epoll_wait(mEpollFd, events, 256, 1000);
+
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        eos_static_crit("msg=\"epoll_wait failed\" errno=%d", errno);
+        break;
+      }
+
+      for (int i = 0; i < n; ++i) {
+        uint64_t tag = events[i].data.u64;
+
+        if (tag == cListenTag) {
+          mServer->Accept(this);
+          continue;
+        }
+
+        if (tag == cWakeTag) {
+          uint64_t count;
+          (void) !::read(mWakeFd, &count, sizeof(count));
+          continue;
+        }
+
+        auto it = mConns.find(tag);
+
+        if (it == mConns.end()) {
+          continue;
+        }
+
+        std::shared_ptr<Connection> conn = it->second;
+        std::lock_guard<std::mutex> lock(conn->mMutex);
+
+        if (events[i].events & EPOLLOUT) {
+          mServer->Flush(*conn);
+        }
+
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+          mServer->OnReadable(*conn);
+        }
+      }
+
+      ProcessPosted();
+      time_t now = time(nullptr);
+
+      if (now != last_scan) {
+        last_scan = now;
+        CloseIdle(now);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Handle the connections posted by other threads
+  //----------------------------------------------------------------------------
+  void ProcessPosted()
+  {
+    std::vector<std::shared_ptr<Connection>> adopted;
+    std::vector<uint64_t> posted;
+    {
+      std::lock_guard<std::mutex> lock(mPostMutex);
+      adopted.swap(mAdopted);
+      posted.swap(mPosted);
+    }
+
+    for (const auto& conn : adopted) {
+      Add(conn);
+    }
+
+    for (auto id : posted) {
+      auto it = mConns.find(id);
+
+      if (it == mConns.end()) {
+        continue;
+      }
+
+      std::shared_ptr<Connection> conn = it->second;
+      std::unique_lock<std::mutex> lock(conn->mMutex);
+
+      if (conn->mClosed) {
+        lock.unlock();
+        mConns.erase(it);
+      } else {
+        mServer->OnReadable(*conn);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Close the connections idle for longer than the timeout, connections with
+  //! a running exchange are timed out by the blocking calls of the worker
+  //----------------------------------------------------------------------------
+  void CloseIdle(time_t now)
+  {
+    for (auto& elem : mConns) {
+      Connection& conn = *elem.second;
+      std::lock_guard<std::mutex> lock(conn.mMutex);
+
+      if (!conn.mClosed && !conn.mBusy &&
+          (now - conn.mLastActive > mServer->mOptions.mIdleTimeout)) {
+        mServer->Close(conn);
+      }
+    }
+  }
+
+  HttpEventServer* mServer; ///< Owning server
+  const size_t mIndex; ///< Index of the reactor
+  int mEpollFd {-1}; ///< Epoll instance
+  int mWakeFd {-1}; ///< Event descriptor waking up the loop
+  std::thread mThread; ///< Event loop thread
+  //! Connections of this reactor, only used by the reactor thread
+  std::unordered_map<uint64_t, std::shared_ptr<Connection>> mConns;
+  std::mutex mPostMutex; ///< Protects the posted and adopted connections
+  std::vector<uint64_t> mPosted; ///< Connections posted by other threads
+  //! New connections handed over by the accepting reactor
+  std::vector<std::shared_ptr<Connection>> mAdopted;
+
+  friend class HttpEventServer;
+};
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+HttpExchange::~HttpExchange() = default;
+
+//------------------------------------------------------------------------------
+// Get the cookies parsed from the cookie header
+//------------------------------------------------------------------------------
+HttpExchange::HeaderMap
+HttpExchange::GetCookies() const
+{
+  HeaderMap cookies;
+  auto it = mHeaders.find("cookie");
+
+  if (it == mHeaders.end()) {
+    return cookies;
+  }
+
+  size_t pos = 0;
+  const std::string& hdr = it->second;
+
+  while (pos < hdr.size()) {
+    size_t end = hdr.find(';', pos);
+
+    if (end == std::string::npos) {
+      end = hdr.size();
+    }
+
+    std::string cookie = hdr.substr(pos, end - pos);
+    size_t eq = cookie.find('=');
+    pos = end + 1;
+
+    if (eq != std::string::npos) {
+      cookies[Lower(Trim(cookie.substr(0, eq)))] = Trim(cookie.substr(eq + 1));
+    }
+  }
+
+  return cookies;
+}
+
+//------------------------------------------------------------------------------
+// Get the numeric address of the client
+//------------------------------------------------------------------------------
+const std::string&
+HttpExchange::GetClientIp() const
+{
+  return mConn->mClientIp;
+}
+
+//------------------------------------------------------------------------------
+// Get the socket address of the client
+//------------------------------------------------------------------------------
+const struct sockaddr*
+HttpExchange::GetClientAddress() const
+{
+  return (const struct sockaddr*) &mConn->mAddr;
+}
+
+//------------------------------------------------------------------------------
+// Read the next piece of the request body
+//------------------------------------------------------------------------------
+ssize_t
+HttpExchange::ReadBody(char* buf, size_t len)
+{
+  Connection& conn = *mConn;
+  HttpEventServer* server = conn.mServer;
+  std::unique_lock<std::mutex> lock(conn.mMutex);
+
+  if (conn.mContinue) {
+    conn.mContinue = false;
+
+    if (!conn.mResponseStarted && !conn.mClosed) {
+      conn.mOut += "HTTP/1.1 100 Continue\r\n\r\n";
+      server->Flush(conn);
+    }
+  }
+
+  while (true) {
+    if (conn.mBodyPos < conn.mBody.size()) {
+      size_t nread = std::min(len, conn.mBody.size() - conn.mBodyPos);
+      memcpy(buf, conn.mBody.data() + conn.mBodyPos, nread);
+      conn.mBodyPos += nread;
+
+      if (conn.mBodyPos == conn.mBody.size()) {
+        conn.mBody.clear();
+        conn.mBodyPos = 0;
+      }
+
+      if (!conn.mBodyDone) {
+        if (!server->DecodeBody(conn)) {
+          server->Close(conn);
+        } else {
+          server->Resume(conn);
+        }
+      }
+
+      return nread;
+    }
+
+    if (conn.mBodyDone) {
+      return 0;
+    }
+
+    if (conn.mClosed) {
+      return -1;
+    }
+
+    if (!server->DecodeBody(conn)) {
+      eos_static_err("msg=\"malformed chunked request body\" client=%s",
+                     conn.mClientIp.c_str());
+      server->Close(conn);
+      return -1;
+    }
+
+    if ((conn.mBodyPos < conn.mBody.size()) || conn.mBodyDone) {
+      continue;
+    }
+
+    server->Resume(conn);
+
+    if ((conn.mCond.wait_for(lock, std::chrono::seconds(
+                               server->mOptions.mIdleTimeout)) ==
+         std::cv_status::timeout) && (conn.mBodyPos == conn.mBody.size()) &&
+        !conn.mBodyDone && !conn.mClosed) {
+      eos_static_err("msg=\"timeout reading request body\" client=%s",
+                     conn.mClientIp.c_str());
+      server->Close(conn);
+      return -1;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the whole request body
+//------------------------------------------------------------------------------
+bool
+HttpExchange::ReadBody(std::string& body, size_t max)
+{
+  char buf[cReadSize];
+
+  while (true) {
+    ssize_t nread = ReadBody(buf, sizeof(buf));
+
+    if (nread < 0) {
+      return false;
+    }
+
+    if (nread == 0) {
+      return true;
+    }
+
+    if (max && (body.size() + nread > max)) {
+      return false;
+    }
+
+    body.append(buf, nread);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue the status line and headers. Called with the connection locked.
+//------------------------------------------------------------------------------
+static bool
+WriteHead(HttpExchange::Connection& conn, const std::string& version,
+          int code, const HttpExchange::HeaderMap& headers, int64_t length)
+{
+  if (conn.mClosed || conn.mResponseStarted) {
+    return false;
+  }
+
+  conn.mResponseStarted = true;
+  conn.mContinue = false;
+  conn.mResponseNoBody = conn.mHead || (code < 200) || (code == 204) ||
+                         (code == 304);
+
+  // An unread request body can only be skipped by closing the connection
+  if (!conn.mBodyDone) {
+    conn.mKeepAlive = false;
+  }
+
+  std::string out = "HTTP/1.1 ";
+  out += std::to_string(code);
+  out += " ";
+  out += HttpExchange::GetReasonPhrase(code);
+  out += "\r\n";
+
+  for (const auto& hdr : headers) {
+    if (!strcasecmp(hdr.first.c_str(), "content-length") ||
+        !strcasecmp(hdr.first.c_str(), "transfer-encoding") ||
+        !strcasecmp(hdr.first.c_str(), "connection")) {
+      continue;
+    }
+
+    out += hdr.first;
+    out += ": ";
+    out += hdr.second;
+    out += "\r\n";
+  }
+
+  conn.mResponseChunked = false;
+  conn.mResponseLeft = 0;
+
+  if (length >= 0) {
+    if ((code >= 200) && (code != 204)) {
+      out += "Content-Length: ";
+      out += std::to_string(length);
+      out += "\r\n";
+    }
+
+    if (!conn.mResponseNoBody) {
+      conn.mResponseLeft = length;
+    }
+  } else if (!conn.mResponseNoBody) {
+    if (version == "HTTP/1.1") {
+      out += "Transfer-Encoding: chunked\r\n";
+      conn.mResponseChunked = true;
+    } else {
+      // HTTP/1.0 clients read the body until the connection closes
+      conn.mKeepAlive = false;
+    }
+
+    conn.mResponseLeft = -1;
+  }
+
+  if (!conn.mKeepAlive) {
+    out += "Connection: close\r\n";
+  }
+
+  out += "\r\n";
+  conn.mOut += out;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Queue a piece of the response body. Called with the connection locked.
+//------------------------------------------------------------------------------
+static bool
+WriteBody(HttpExchange::Connection& conn, const char* data, size_t len)
+{
+  if (conn.mClosed || !conn.mResponseStarted) {
+    return false;
+  }
+
+  if (conn.mResponseNoBody || !len) {
+    return true;
+  }
+
+  if (conn.mResponseChunked) {
+    char size[32];
+    snprintf(size, sizeof(size), "%zx\r\n", len);
+    conn.mOut += size;
+    conn.mOut.append(data, len);
+    conn.mOut += "\r\n";
+    return true;
+  }
+
+  if (conn.mResponseLeft >= 0) {
+    if ((int64_t) len > conn.mResponseLeft) {
+      eos_static_err("msg=\"response body exceeds its content length\" "
+                     "client=%s", conn.mClientIp.c_str());
+      return false;
+    }
+
+    conn.mResponseLeft -= len;
+  }
+
+  conn.mOut.append(data, len);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Send a complete response
+//------------------------------------------------------------------------------
+bool
+HttpExchange::SendResponse(int code, const HeaderMap& headers,
+                           const std::string& body)
+{
+  Connection& conn = *mConn;
+  std::lock_guard<std::mutex> lock(conn.mMutex);
+
+  if (!WriteHead(conn, mVersion, code, headers, body.size()) ||
+      !WriteBody(conn, body.c_str(), body.size())) {
+    return false;
+  }
+
+  conn.mServer->Flush(conn);
+  return !conn.mClosed;
+}
+
+//------------------------------------------------------------------------------
+// Send the status line and headers of a streamed response
+//------------------------------------------------------------------------------
+bool
+HttpExchange::SendResponseHead(int code, const HeaderMap& headers,
+                               int64_t length)
+{
+  Connection& conn = *mConn;
+  std::lock_guard<std::mutex> lock(conn.mMutex);
+
+  if (!WriteHead(conn, mVersion, code, headers, length)) {
+    return false;
+  }
+
+  conn.mServer->Flush(conn);
+  return !conn.mClosed;
+}
+
+//------------------------------------------------------------------------------
+// Send a piece of the response body
+//------------------------------------------------------------------------------
+bool
+HttpExchange::SendBody(const char* data, size_t len)
+{
+  Connection& conn = *mConn;
+  HttpEventServer* server = conn.mServer;
+  std::unique_lock<std::mutex> lock(conn.mMutex);
+
+  if (!WriteBody(conn, data, len)) {
+    return false;
+  }
+
+  server->Flush(conn);
+
+  while (!conn.mClosed &&
+         (conn.mOut.size() - conn.mOutPos > server->mOptions.mMaxOutputBuffer)) {
+    if ((conn.mCond.wait_for(lock, std::chrono::seconds(
+                               server->mOptions.mIdleTimeout)) ==
+         std::cv_status::timeout) &&
+        (conn.mOut.size() - conn.mOutPos > server->mOptions.mMaxOutputBuffer)) {
+      eos_static_err("msg=\"timeout sending response body\" client=%s",
+                     conn.mClientIp.c_str());
+      server->Close(conn);
+    }
+  }
+
+  return !conn.mClosed;
+}
+
+//------------------------------------------------------------------------------
+// Complete the exchange
+//------------------------------------------------------------------------------
+void
+HttpExchange::Finish()
+{
+  if (mFinished) {
+    return;
+  }
+
+  mFinished = true;
+  Connection& conn = *mConn;
+  HttpEventServer* server = conn.mServer;
+  std::lock_guard<std::mutex> lock(conn.mMutex);
+
+  if (!conn.mResponseStarted) {
+    if (!conn.mClosed) {
+      eos_static_err("msg=\"no response sent\" method=%s path=\"%s\"",
+                     mMethod.c_str(), mPath.c_str());
+      WriteHead(conn, mVersion, 500, HeaderMap(), 0);
+    }
+  } else if (conn.mResponseChunked) {
+    conn.mOut += "0\r\n\r\n";
+  } else if (conn.mResponseLeft > 0) {
+    // The client can not tell where the truncated response ends
+    conn.mKeepAlive = false;
+  }
+
+  if (!conn.mBodyDone) {
+    conn.mKeepAlive = false;
+  }
+
+  if (!conn.mKeepAlive) {
+    conn.mCloseAfter = true;
+  }
+
+  conn.mBody.clear();
+  conn.mBodyPos = 0;
+  conn.mContinue = false;
+  conn.mBusy = false;
+  ++server->mRequests;
+  server->Flush(conn);
+
+  if (conn.mClosed || conn.mCloseAfter) {
+    return;
+  }
+
+  // Continue with the next pipelined request
+  server->Process(conn);
+
+  if (!conn.mBusy && conn.mPeerClosed) {
+    conn.mCloseAfter = true;
+    server->Flush(conn);
+    return;
+  }
+
+  server->Resume(conn);
+}
+
+//------------------------------------------------------------------------------
+// Get the reason phrase of a HTTP status code
+//------------------------------------------------------------------------------
+const char*
+HttpExchange::GetReasonPhrase(int code)
+{
+  switch (code) {
+  case 100:
+    return "Continue";
+
+  case 200:
+    return "OK";
+
+  case 201:
+    return "Created";
+
+  case 202:
+    return "Accepted";
+
+  case 204:
+    return "No Content";
+
+  case 206:
+    return "Partial Content";
+
+  case 207:
+    return "Multi-Status";
+
+  case 301:
+    return "Moved Permanently";
+
+  case 302:
+    return "Found";
+
+  case 304:
+    return "Not Modified";
+
+  case 307:
+    return "Temporary Redirect";
+
+  case 400:
+    return "Bad Request";
+
+  case 401:
+    return "Unauthorized";
+
+  case 403:
+    return "Forbidden";
+
+  case 404:
+    return "Not Found";
+
+  case 405:
+    return "Method Not Allowed";
+
+  case 409:
+    return "Conflict";
+
+  case 411:
+    return "Length Required";
+
+  case 412:
+    return "Precondition Failed";
+
+  case 413:
+    return "Payload Too Large";
+
+  case 416:
+    return "Range Not Satisfiable";
+
+  case 423:
+    return "Locked";
+
+  case 431:
+    return "Request Header Fields Too Large";
+
+  case 500:
+    return "Internal Server Error";
+
+  case 501:
+    return "Not Implemented";
+
+  case 503:
+    return "Service Unavailable";
+
+  case 505:
+    return "HTTP Version Not Supported";
+
+  case 507:
+    return "Insufficient Storage";
+
+  default:
+    return (code < 400) ? "OK" : "Error";
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+HttpEventServer::HttpEventServer(const Options& options, Handler handler):
+  mOptions(options), mHandler(std::move(handler))
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+HttpEventServer::~HttpEventServer()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Bind the listening socket and start the reactor and worker threads
+//------------------------------------------------------------------------------
+bool
+HttpEventServer::Start()
+{
+  if (mRunning) {
+    return false;
+  }
+
+  mListenFd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int on = 1;
+  int off = 0;
+
+  if (mListenFd >= 0) {
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(mOptions.mPort);
+    (void) setsockopt(mListenFd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    (void) setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    if (bind(mListenFd, (struct sockaddr*) &addr, sizeof(addr))) {
+      (void) ::close(mListenFd);
+      mListenFd = -1;
+    }
+  }
+
+  if (mListenFd < 0) {
+    // No IPv6 support, fall back to IPv4 only
+    mListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(mOptions.mPort);
+
+    if ((mListenFd < 0) ||
+        setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) ||
+        bind(mListenFd, (struct sockaddr*) &addr, sizeof(addr))) {
+      eos_static_err("msg=\"failed to bind http port\" port=%d errno=%d",
+                     mOptions.mPort, errno);
+
+      if (mListenFd >= 0) {
+        (void) ::close(mListenFd);
+        mListenFd = -1;
+      }
+
+      return false;
+    }
+  }
+
+  struct sockaddr_storage bound;
+  socklen_t len = sizeof(bound);
+
+  if (listen(mListenFd, SOMAXCONN) ||
+      getsockname(mListenFd, (struct sockaddr*) &bound, &len)) {
+    eos_static_err("msg=\"failed to listen on http port\" port=%d errno=%d",
+                   mOptions.mPort, errno);
+    (void) ::close(mListenFd);
+    mListenFd = -1;
+    return false;
+  }
+
+  mPort = ntohs((bound.ss_family == AF_INET6) ?
+                ((struct sockaddr_in6*) &bound)->sin6_port :
+                ((struct sockaddr_in*) &bound)->sin_port);
+  unsigned int nworkers = std::max(1u, mOptions.mWorkers);
+  mWorkers.reset(new ThreadPool(nworkers, nworkers, 10, 12, 10, "http"));
+  mRunning = true;
+
+  for (size_t i = 0; i < std::max(1u, mOptions.mReactors); ++i) {
+    mReactors.emplace_back(new Reactor(this, i));
+
+    if (!mReactors.back()->Init(mListenFd)) {
+      eos_static_err("msg=\"failed to create http reactor\" errno=%d", errno);
+      Stop();
+      return false;
+    }
+  }
+
+  for (auto& reactor : mReactors) {
+    reactor->Start();
+  }
+
+  eos_static_info("msg=\"started http event server\" port=%d reactors=%zu "
+                  "workers=%u", mPort, mReactors.size(), nworkers);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Stop the server
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Stop()
+{
+  if (!mRunning.exchange(false)) {
+    return;
+  }
+
+  for (auto& reactor : mReactors) {
+    reactor->Join();
+  }
+
+  // Fail the blocked handlers before waiting for the workers
+  for (auto& reactor : mReactors) {
+    reactor->CloseAll();
+  }
+
+  mWorkers->Stop();
+
+  for (auto& reactor : mReactors) {
+    reactor->Clear();
+  }
+
+  mReactors.clear();
+  mWorkers.reset();
+  (void) ::close(mListenFd);
+  mListenFd = -1;
+}
+
+//------------------------------------------------------------------------------
+// Accept all pending connections
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Accept(Reactor* acceptor)
+{
+  while (true) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    int fd = accept4(mListenFd, (struct sockaddr*) &addr, &len,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+        eos_static_err("msg=\"failed to accept http connection\" errno=%d",
+                       errno);
+      }
+
+      return;
+    }
+
+    if (mConnections >= mOptions.mMaxConnections) {
+      eos_static_warning("msg=\"rejecting http connection, too many open "
+                         "connections\" max=%u", mOptions.mMaxConnections);
+      (void) ::close(fd);
+      continue;
+    }
+
+    int on = 1;
+    (void) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    // The kernel wakes up one reactor per batch of new connections, spread
+    // them round robin so that the reactors share the load evenly
+    size_t index = mNextReactor++ % mReactors.size();
+    auto conn = std::make_shared<Connection>(this, index, mNextId++, fd);
+    conn->mAddr = addr;
+    char host[NI_MAXHOST];
+
+    if (!getnameinfo((struct sockaddr*) &addr, len, host, sizeof(host),
+                     nullptr, 0, NI_NUMERICHOST)) {
+      conn->mClientIp = host;
+
+      // Report IPv4 clients of the dual stack socket in dotted notation
+      if (conn->mClientIp.find("::ffff:") == 0) {
+        conn->mClientIp.erase(0, 7);
+      }
+    } else {
+      conn->mClientIp = "NOIPLOOKUP";
+    }
+
+    ++mConnections;
+
+    if (mReactors[index].get() == acceptor) {
+      acceptor->Add(conn);
+    } else {
+      mReactors[index]->Adopt(conn);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read from the socket of a connection
+//------------------------------------------------------------------------------
+void
+HttpEventServer::OnReadable(Connection& conn)
+{
+  if (conn.mClosed) {
+    return;
+  }
+
+  const size_t max_input = mOptions.mMaxHeaderSize + cReadSize;
+  char buf[cReadSize];
+
+  while (!conn.mPeerClosed) {
+    if (conn.mIn.size() >= max_input) {
+      conn.mReadPaused = true;
+      return;
+    }
+
+    ssize_t nread = ::read(conn.mFd, buf, sizeof(buf));
+
+    if (nread > 0) {
+      conn.mIn.append(buf, nread);
+      conn.mLastActive = time(nullptr);
+      Process(conn);
+
+      if (conn.mClosed) {
+        return;
+      }
+
+      continue;
+    }
+
+    if (nread == 0) {
+      conn.mPeerClosed = true;
+      break;
+    }
+
+    if (errno == EINTR) {
+      continue;
+    }
+
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      Close(conn);
+    }
+
+    return;
+  }
+
+  // The client stopped sending, a body still expected can not arrive anymore
+  if (!conn.mBusy) {
+    conn.mCloseAfter = true;
+    Flush(conn);
+  } else if (!conn.mBodyDone) {
+    Close(conn);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Consume buffered input
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Process(Connection& conn)
+{
+  if (conn.mClosed) {
+    return;
+  }
+
+  if (conn.mBusy) {
+    if (!conn.mBodyDone) {
+      if (!DecodeBody(conn)) {
+        eos_static_err("msg=\"malformed chunked request body\" client=%s",
+                       conn.mClientIp.c_str());
+        Close(conn);
+        return;
+      }
+
+      conn.mCond.notify_all();
+    }
+
+    return;
+  }
+
+  if (conn.mCloseAfter || !mRunning) {
+    return;
+  }
+
+  std::shared_ptr<HttpExchange> exchange = ParseRequest(conn);
+
+  if (!exchange) {
+    return;
+  }
+
+  conn.mBusy = true;
+
+  if (!conn.mBodyDone && !DecodeBody(conn)) {
+    eos_static_err("msg=\"malformed chunked request body\" client=%s",
+                   conn.mClientIp.c_str());
+    Close(conn);
+    return;
+  }
+
+  mWorkers->PushTask<void>([this, exchange] {
+    Dispatch(exchange);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parse the next request head
+//------------------------------------------------------------------------------
+std::shared_ptr<HttpExchange>
+HttpEventServer::ParseRequest(Connection& conn)
+{
+  // Empty lines before a request line are ignored
+  size_t start = 0;
+
+  while (conn.mIn.compare(start, 2, "\r\n") == 0) {
+    start += 2;
+  }
+
+  if (start) {
+    conn.mIn.erase(0, start);
+  }
+
+  size_t end = conn.mIn.find("\r\n\r\n");
+
+  if ((end == std::string::npos) || (end > mOptions.mMaxHeaderSize)) {
+    if ((end != std::string::npos) ||
+        (conn.mIn.size() > mOptions.mMaxHeaderSize)) {
+      Reject(conn, 431);
+    }
+
+    return nullptr;
+  }
+
+  std::string head = conn.mIn.substr(0, end + 2);
+  conn.mIn.erase(0, end + 4);
+  auto exchange = std::make_shared<HttpExchange>(conn.shared_from_this());
+  // Request line
+  size_t eol = head.find("\r\n");
+  std::string line = head.substr(0, eol);
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.rfind(' ');
+
+  if ((sp1 == std::string::npos) || (sp1 == 0) || (sp2 <= sp1 + 1)) {
+    Reject(conn, 400);
+    return nullptr;
+  }
+
+  exchange->mMethod = line.substr(0, sp1);
+  std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  exchange->mVersion = line.substr(sp2 + 1);
+
+  if ((exchange->mVersion != "HTTP/1.1") && (exchange->mVersion != "HTTP/1.0")) {
+    Reject(conn, (exchange->mVersion.find("HTTP/") == 0) ? 505 : 400);
+    return nullptr;
+  }
+
+  // Strip the scheme and authority of an absolute form target
+  if ((target.find("http://") == 0) || (target.find("https://") == 0)) {
+    size_t path_pos = target.find('/', target.find("//") + 2);
+    target = (path_pos == std::string::npos) ? "/" : target.substr(path_pos);
+  }
+
+  size_t qpos = target.find('?');
+
+  if (qpos != std::string::npos) {
+    exchange->mQuery = DecodeQuery(target.substr(qpos + 1));
+    target.erase(qpos);
+  }
+
+  exchange->mPath = Unescape(target, false);
+
+  // Header fields, repeated fields are combined into a list
+  for (size_t pos = eol + 2; pos < head.size();) {
+    size_t next = head.find("\r\n", pos);
+    line = head.substr(pos, next - pos);
+    pos = next + 2;
+    size_t colon = line.find(':');
+
+    // No whitespace is allowed in the field name nor before the colon, a
+    // field we can't recognize might frame the body for another parser
+    if ((colon == std::string::npos) || (colon == 0) ||
+        (line.find_first_of(" \t") < colon)) {
+      Reject(conn, 400);
+      return nullptr;
+    }
+
+    std::string key = Lower(line.substr(0, colon));
+    std::string value = Trim(line.substr(colon + 1));
+    auto it = exchange->mHeaders.find(key);
+
+    if (it == exchange->mHeaders.end()) {
+      exchange->mHeaders.emplace(key, value);
+    } else {
+      it->second += ", ";
+      it->second += value;
+    }
+  }
+
+  auto& headers = exchange->mHeaders;
+  // Request body framing
+  conn.mChunked = false;
+  conn.mChunkState = kChunkSize;
+  conn.mBodyLeft = 0;
+  auto it_te = headers.find("transfer-encoding");
+  auto it_cl = headers.find("content-length");
+
+  if (it_te != headers.end()) {
+    // Only the chunked transfer coding alone is implemented, anything else
+    // would hand a still encoded body to the handler
+    if (Lower(it_te->second) != "chunked") {
+      Reject(conn, 501);
+      return nullptr;
+    }
+
+    conn.mChunked = true;
+  } else if (it_cl != headers.end()) {
+    const std::string& cl = it_cl->second;
+
+    if (cl.empty() || (cl.size() > 18) ||
+        (cl.find_first_not_of("0123456789") != std::string::npos)) {
+      Reject(conn, 400);
+      return nullptr;
+    }
+
+    conn.mBodyLeft = std::stoull(cl);
+  }
+
+  exchange->mHasBody = conn.mChunked || conn.mBodyLeft;
+  conn.mBodyDone = !exchange->mHasBody;
+  conn.mBody.clear();
+  conn.mBodyPos = 0;
+  auto it_expect = headers.find("expect");
+  conn.mContinue = exchange->mHasBody && (exchange->mVersion == "HTTP/1.1") &&
+                   (it_expect != headers.end()) &&
+                   (Lower(it_expect->second) == "100-continue");
+  // Persistence of the connection
+  auto it_conn = headers.find("connection");
+  std::string conn_hdr = (it_conn != headers.end()) ? Lower(it_conn->second) :
+                         "";
+
+  if (exchange->mVersion == "HTTP/1.1") {
+    conn.mKeepAlive = (conn_hdr.find("close") == std::string::npos);
+  } else {
+    conn.mKeepAlive = (conn_hdr.find("keep-alive") != std::string::npos);
+  }
+
+  // With both a transfer coding and a content length an intermediary might
+  // have framed the body differently, don't trust what follows (RFC 7230
+  // section 3.3.3)
+  if (conn.mChunked && (it_cl != headers.end())) {
+    conn.mKeepAlive = false;
+  }
+
+  conn.mHead = (exchange->mMethod == "HEAD");
+  conn.mResponseStarted = false;
+  conn.mResponseChunked = false;
+  conn.mResponseNoBody = false;
+  conn.mResponseLeft = -1;
+  return exchange;
+}
+
+//------------------------------------------------------------------------------
+// Move request body bytes from the input buffer to the body buffer
+//------------------------------------------------------------------------------
+bool
+HttpEventServer::DecodeBody(Connection& conn)
+{
+  if (conn.mBodyPos && (conn.mBodyPos >= conn.mBody.size() / 2)) {
+    conn.mBody.erase(0, conn.mBodyPos);
+    conn.mBodyPos = 0;
+  }
+
+  while (!conn.mBodyDone) {
+    size_t buffered = conn.mBody.size() - conn.mBodyPos;
+
+    if (buffered >= mOptions.mMaxBodyBuffer) {
+      break;
+    }
+
+    if (!conn.mChunked || (conn.mChunkState == kChunkData)) {
+      size_t len = std::min((uint64_t) conn.mIn.size(), conn.mBodyLeft);
+      len = std::min(len, mOptions.mMaxBodyBuffer - buffered);
+
+      if (!len) {
+        break;
+      }
+
+      conn.mBody.append(conn.mIn, 0, len);
+      conn.mIn.erase(0, len);
+      conn.mBodyLeft -= len;
+
+      if (!conn.mBodyLeft) {
+        if (conn.mChunked) {
+          conn.mChunkState = kChunkDataEnd;
+        } else {
+          conn.mBodyDone = true;
+        }
+      }
+
+      continue;
+    }
+
+    if (conn.mChunkState == kChunkDataEnd) {
+      if (conn.mIn.size() < 2) {
+        break;
+      }
+
+      if (conn.mIn.compare(0, 2, "\r\n")) {
+        return false;
+      }
+
+      conn.mIn.erase(0, 2);
+      conn.mChunkState = kChunkSize;
+      continue;
+    }
+
+    size_t eol = conn.mIn.find("\r\n");
+
+    if (eol == std::string::npos) {
+      // Chunk size lines and trailer fields are short
+      return (conn.mIn.size() <= mOptions.mMaxHeaderSize);
+    }
+
+    std::string line = conn.mIn.substr(0, eol);
+    conn.mIn.erase(0, eol + 2);
+
+    if (conn.mChunkState == kChunkTrailer) {
+      conn.mBodyDone = line.empty();
+      continue;
+    }
+
+    // Chunk size with optional extensions
+    line = Trim(line.substr(0, line.find(';')));
+
+    if (line.empty() || (line.size() > 15) ||
+        (line.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)) {
+      return false;
+    }
+
+    conn.mBodyLeft = std::stoull(line, nullptr, 16);
+    conn.mChunkState = conn.mBodyLeft ? kChunkData : kChunkTrailer;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write pending output
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Flush(Connection& conn)
+{
+  if (conn.mClosed) {
+    return;
+  }
+
+  while (conn.mOutPos < conn.mOut.size()) {
+    ssize_t nwrite = ::send(conn.mFd, conn.mOut.data() + conn.mOutPos,
+                            conn.mOut.size() - conn.mOutPos, MSG_NOSIGNAL);
+
+    if (nwrite > 0) {
+      conn.mOutPos += nwrite;
+      conn.mLastActive = time(nullptr);
+      continue;
+    }
+
+    if ((nwrite < 0) && (errno == EINTR)) {
+      continue;
+    }
+
+    if ((nwrite < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+      break;
+    }
+
+    Close(conn);
+    return;
+  }
+
+  if (conn.mOutPos == conn.mOut.size()) {
+    if (conn.mOut.capacity() > cMaxIdleBuffer) {
+      std::string().swap(conn.mOut);
+    } else {
+      conn.mOut.clear();
+    }
+
+    conn.mOutPos = 0;
+
+    if (conn.mCloseAfter && !conn.mBusy) {
+      Close(conn);
+      return;
+    }
+  } else if (conn.mOutPos >= conn.mOut.size() / 2) {
+    conn.mOut.erase(0, conn.mOutPos);
+    conn.mOutPos = 0;
+  }
+
+  conn.mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Close a connection
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Close(Connection& conn)
+{
+  if (conn.mClosed) {
+    return;
+  }
+
+  conn.mClosed = true;
+  (void) ::close(conn.mFd);
+  conn.mFd = -1;
+  std::string().swap(conn.mIn);
+  std::string().swap(conn.mOut);
+  conn.mOutPos = 0;
+  --mConnections;
+  conn.mCond.notify_all();
+  mReactors[conn.mReactor]->Post(conn.mId);
+}
+
+//------------------------------------------------------------------------------
+// Resume reading from a paused connection
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Resume(Connection& conn)
+{
+  if (conn.mReadPaused && !conn.mClosed &&
+      (conn.mIn.size() < mOptions.mMaxHeaderSize + cReadSize)) {
+    conn.mReadPaused = false;
+    mReactors[conn.mReactor]->Post(conn.mId);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue an error response and close the connection afterwards
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Reject(Connection& conn, int code)
+{
+  eos_static_err("msg=\"rejecting http request\" client=%s code=%d",
+                 conn.mClientIp.c_str(), code);
+  conn.mOut += "HTTP/1.1 ";
+  conn.mOut += std::to_string(code);
+  conn.mOut += " ";
+  conn.mOut += HttpExchange::GetReasonPhrase(code);
+  conn.mOut += "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  conn.mCloseAfter = true;
+  conn.mIn.clear();
+  Flush(conn);
+}
+
+//------------------------------------------------------------------------------
+// Run the handler for an exchange
+//------------------------------------------------------------------------------
+void
+HttpEventServer::Dispatch(std::shared_ptr<HttpExchange> exchange)
+{
+  try {
+    mHandler(*exchange);
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"exception in http handler\" method=%s path=\"%s\" "
+                   "what=\"%s\"", exchange->GetMethod().c_str(),
+                   exchange->GetPath().c_str(), e.what());
+  } catch (...) {
+    eos_static_err("msg=\"unknown exception in http handler\" method=%s "
+                   "path=\"%s\"", exchange->GetMethod().c_str(),
+                   exchange->GetPath().c_str());
+  }
+
+  exchange->Finish();
+}
+
+EOSCOMMONNAMESPACE_END
@@ -0,0 +1,347 @@
+//------------------------------------------------------------------------------
+//! @file HttpEventServer.hh
+//! @brief Event-driven HTTP/1.1 server with a fixed worker pool
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <sys/socket.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+class ThreadPool;
+
+//------------------------------------------------------------------------------
+//! One request/response exchange of a HTTP connection, handed to a worker of
+//! the HttpEventServer. The request body is read and the response is written
+//! while the exchange runs, both are streamed through bounded buffers so a
+//! worker blocks instead of buffering a whole upload or download.
+//------------------------------------------------------------------------------
+class HttpExchange
+{
+public:
+  typedef std::map<std::string, std::string> HeaderMap;
+  struct Connection;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  HttpExchange(std::shared_ptr<Connection> conn): mConn(std::move(conn)) {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~HttpExchange();
+
+  //----------------------------------------------------------------------------
+  //! Request accessors, the header names are lower case
+  //----------------------------------------------------------------------------
+  const std::string& GetMethod() const
+  {
+    return mMethod;
+  }
+
+  const std::string& GetPath() const
+  {
+    return mPath;
+  }
+
+  const std::string& GetQuery() const
+  {
+    return mQuery;
+  }
+
+  const std::string& GetVersion() const
+  {
+    return mVersion;
+  }
+
+  HeaderMap& GetHeaders()
+  {
+    return mHeaders;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the cookies parsed from the cookie header
+  //----------------------------------------------------------------------------
+  HeaderMap GetCookies() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the numeric address of the client
+  //----------------------------------------------------------------------------
+  const std::string& GetClientIp() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the socket address of the client
+  //----------------------------------------------------------------------------
+  const struct sockaddr* GetClientAddress() const;
+
+  //----------------------------------------------------------------------------
+  //! Check if the request has a body i.e. a non zero content-length or a
+  //! chunked transfer encoding
+  //----------------------------------------------------------------------------
+  bool HasBody() const
+  {
+    return mHasBody;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Read the next piece of the request body, blocks until data is available.
+  //! The first call answers an "Expect: 100-continue" request.
+  //!
+  //! @param buf buffer to read into
+  //! @param len size of the buffer
+  //!
+  //! @return number of bytes read, 0 at the end of the body, -1 if the
+  //!         connection failed or timed out
+  //----------------------------------------------------------------------------
+  ssize_t ReadBody(char* buf, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Read the whole request body
+  //!
+  //! @param body string to append the body to
+  //! @param max maximum body size accepted, 0 means no limit
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool ReadBody(std::string& body, size_t max = 0);
+
+  //----------------------------------------------------------------------------
+  //! Send a complete response
+  //!
+  //! @param code HTTP status code
+  //! @param headers response headers, content-length, transfer-encoding and
+  //!        connection are set by the server
+  //! @param body response body, not sent for HEAD requests
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendResponse(int code, const HeaderMap& headers,
+                    const std::string& body);
+
+  //----------------------------------------------------------------------------
+  //! Send the status line and headers of a streamed response, the body
+  //! follows with SendBody
+  //!
+  //! @param code HTTP status code
+  //! @param headers response headers
+  //! @param length body length, -1 uses the chunked transfer encoding
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendResponseHead(int code, const HeaderMap& headers, int64_t length);
+
+  //----------------------------------------------------------------------------
+  //! Send a piece of the response body, blocks while too much output is
+  //! pending on the connection
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendBody(const char* data, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Complete the exchange, called by the server once the handler returns.
+  //! Sends an error if no response was sent and closes the connection if the
+  //! request body or the response body is incomplete, otherwise continues
+  //! with the next (pipelined) request of the connection.
+  //----------------------------------------------------------------------------
+  void Finish();
+
+  //----------------------------------------------------------------------------
+  //! Get the reason phrase of a HTTP status code
+  //----------------------------------------------------------------------------
+  static const char* GetReasonPhrase(int code);
+
+private:
+  friend class HttpEventServer;
+
+  std::shared_ptr<Connection> mConn; ///< Connection of the exchange
+  std::string mMethod; ///< Request method
+  std::string mPath; ///< Decoded request path
+  std::string mQuery; ///< Raw query string
+  std::string mVersion; ///< HTTP version e.g. HTTP/1.1
+  HeaderMap mHeaders; ///< Request headers with lower case names
+  bool mHasBody {false}; ///< Request comes with a body
+  bool mFinished {false}; ///< Exchange is complete
+};
+
+//------------------------------------------------------------------------------
+//! HTTP/1.1 server multiplexing all connections on a few epoll reactor
+//! threads. Complete request headers are dispatched to a fixed pool of worker
+//! threads running the handler, so the number of threads no longer grows
+//! with the number of clients. Connections are kept alive and pipelined
+//! requests are served in order.
+//------------------------------------------------------------------------------
+class HttpEventServer
+{
+public:
+  //! Handler of one exchange, runs in a worker thread
+  typedef std::function<void(HttpExchange&)> Handler;
+
+  //! Server settings
+  struct Options {
+    int mPort = 8000; ///< Listening port, 0 picks a free port
+    unsigned int mReactors = 4; ///< Number of epoll reactor threads
+    unsigned int mWorkers = 16; ///< Number of worker threads
+    unsigned int mMaxConnections = 65536; ///< Maximum open connections
+    int mIdleTimeout = 128; ///< Idle and blocked I/O timeout in seconds
+    size_t mMaxHeaderSize = 64 * 1024; ///< Maximum size of a request head
+    size_t mMaxBodyBuffer = 4 * 1024 * 1024; ///< Request body read ahead
+    size_t mMaxOutputBuffer = 4 * 1024 * 1024; ///< Pending output per conn.
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param options server settings
+  //! @param handler request handler
+  //----------------------------------------------------------------------------
+  HttpEventServer(const Options& options, Handler handler);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~HttpEventServer();
+
+  //----------------------------------------------------------------------------
+  //! Bind the listening socket and start the reactor and worker threads
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the server, closing all connections
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Get the port the server listens on
+  //----------------------------------------------------------------------------
+  int GetPort() const
+  {
+    return mPort;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of open connections
+  //----------------------------------------------------------------------------
+  uint64_t GetConnections() const
+  {
+    return mConnections;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of completed requests
+  //----------------------------------------------------------------------------
+  uint64_t GetRequests() const
+  {
+    return mRequests;
+  }
+
+private:
+  friend class HttpExchange;
+  class Reactor;
+  typedef HttpExchange::Connection Connection;
+
+  //----------------------------------------------------------------------------
+  //! Accept all pending connections and spread them over the reactors
+  //!
+  //! @param acceptor reactor woken up by the listening socket
+  //----------------------------------------------------------------------------
+  void Accept(Reactor* acceptor);
+
+  //----------------------------------------------------------------------------
+  //! Read from the socket of a connection until it would block or its
+  //! input buffer is full. Called with the connection locked.
+  //----------------------------------------------------------------------------
+  void OnReadable(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Consume buffered input: decode the body of the running exchange or
+  //! parse and dispatch the next request. Called with the connection locked.
+  //----------------------------------------------------------------------------
+  void Process(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Parse the next request head from the input buffer
+  //!
+  //! @return exchange, null if the head is incomplete or malformed
+  //----------------------------------------------------------------------------
+  std::shared_ptr<HttpExchange> ParseRequest(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Move request body bytes from the input buffer to the body buffer
+  //!
+  //! @return false if the body encoding is malformed, otherwise true
+  //----------------------------------------------------------------------------
+  bool DecodeBody(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Write pending output until the socket would block. Closes the
+  //! connection once drained if requested. Called with the connection locked.
+  //----------------------------------------------------------------------------
+  void Flush(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Close a connection. Called with the connection locked.
+  //----------------------------------------------------------------------------
+  void Close(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Resume reading from a connection paused on a full input buffer.
+  //! Called with the connection locked.
+  //----------------------------------------------------------------------------
+  void Resume(Connection& conn);
+
+  //----------------------------------------------------------------------------
+  //! Queue an error response and close the connection afterwards. Called
+  //! with the connection locked.
+  //----------------------------------------------------------------------------
+  void Reject(Connection& conn, int code);
+
+  //----------------------------------------------------------------------------
+  //! Run the handler for an exchange
+  //----------------------------------------------------------------------------
+  void Dispatch(std::shared_ptr<HttpExchange> exchange);
+
+  const Options mOptions; ///< Server settings
+  Handler mHandler; ///< Request handler
+  int mPort {0}; ///< Bound port
+  int mListenFd {-1}; ///< Listening socket
+  std::atomic<bool> mRunning {false}; ///< Server is running
+  std::atomic<uint64_t> mConnections {0}; ///< Open connections
+  std::atomic<uint64_t> mRequests {0}; ///< Completed requests
+  std::atomic<uint64_t> mNextId {1}; ///< Next connection id
+  std::atomic<uint64_t> mNextReactor {0}; ///< Reactor of the next connection
+  std::vector<std::unique_ptr<Reactor>> mReactors; ///< Reactor threads
+  std::unique_ptr<ThreadPool> mWorkers; ///< Worker threads
+};
+
+EOSCOMMONNAMESPACE_END
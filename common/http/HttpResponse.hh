@@ -32,6 +32,7 @@
 #define __EOSCOMMON_HTTP_RESPONSE__HH__
 
 #include "common/Namespace.hh"
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -89,10 +90,18 @@ public:
 public:
   typedef std::map<std::string, std::string> HeaderMap;
 
+  /**
+   * Producer of a streamed response body. Every call replaces the chunk with
+   * the next piece of the body and returns false once the body is complete,
+   * the chunk of the last call may still carry data.
+   */
+  typedef std::function<bool(std::string& chunk)> BodyGenerator;
+
 protected:
   HeaderMap    mResponseHeaders;       //!< the response headers to be filled
   std::string  mResponseBody;          //!< the response body to be created
   int          mResponseCode;          //!< the response code to be determined
+  BodyGenerator mBodyGenerator;        //!< producer of a streamed body
 
 public:
   off_t        mResponseLength;        //!< length of the response
@@ -186,6 +195,41 @@ public:
     return mResponseBody.length();
   }
 
+  /**
+   * Stream the response body instead of sending the body string. The body
+   * is sent with the chunked transfer encoding and no Content-Length.
+   *
+   * @param generator  producer of the body chunks
+   */
+  inline void
+  SetBodyGenerator(BodyGenerator generator)
+  {
+    mBodyGenerator = std::move(generator);
+  }
+
+  /**
+   * @return true if the response body is streamed through a generator
+   */
+  inline bool
+  IsStreamed() const
+  {
+    return (bool) mBodyGenerator;
+  }
+
+  /**
+   * Get the next piece of a streamed body
+   *
+   * @param chunk  replaced by the next piece of the body
+   *
+   * @return false once the body is complete, otherwise true
+   */
+  inline bool
+  NextBodyChunk(std::string& chunk)
+  {
+    chunk.clear();
+    return mBodyGenerator ? mBodyGenerator(chunk) : false;
+  }
+
   /**
    * @return the server response code
    */
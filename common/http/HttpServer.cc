@@ -66,6 +66,12 @@ HttpServer::Start()
 void
 HttpServer::Run(ThreadAssistant& assistant) noexcept
 {
+  if (getenv("EOS_HTTP_THREADPOOL") &&
+      (std::string(getenv("EOS_HTTP_THREADPOOL")) == "event")) {
+    RunEventServer(assistant);
+    return;
+  }
+
 #ifdef EOS_MICRO_HTTPD
   std::string thread_model = "threads";
   {
@@ -195,6 +201,70 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
 #endif
 }
 
+/*----------------------------------------------------------------------------*/
+void
+HttpServer::RunEventServer(ThreadAssistant& assistant) noexcept
+{
+  // Delay to make sure xrootd is configured before serving
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  HttpEventServer::Options options;
+  options.mPort = mPort;
+
+  if (getenv("EOS_HTTP_THREADPOOL_SIZE")) {
+    options.mWorkers = std::min(std::max(atoi(getenv("EOS_HTTP_THREADPOOL_SIZE")),
+                                         1), 4096);
+  }
+
+  if (getenv("EOS_HTTP_REACTORS")) {
+    options.mReactors = std::min(std::max(atoi(getenv("EOS_HTTP_REACTORS")), 1),
+                                 64);
+  }
+
+  if (getenv("EOS_HTTP_CONNECTION_TIMEOUT")) {
+    options.mIdleTimeout = std::max(atoi(getenv("EOS_HTTP_CONNECTION_TIMEOUT")),
+                                    1);
+  }
+
+  if (getenv("EOS_HTTP_CONNECTION_LIMIT")) {
+    options.mMaxConnections = std::max(atoi(getenv("EOS_HTTP_CONNECTION_LIMIT")),
+                                       1);
+  }
+
+  eos_static_notice("msg=\"starting http server\" mode=\"event\" reactors=%u "
+                    "threads=%u", options.mReactors, options.mWorkers);
+  mEventServer.reset(new HttpEventServer(options,
+  [this](HttpExchange & exchange) {
+    HandleExchange(exchange);
+  }));
+
+  if (!mEventServer->Start()) {
+    mRunning = false;
+    mEventServer.reset();
+    eos_static_warning("msg=\"start of http event server failed [port=%d]\"",
+                       mPort);
+    return;
+  }
+
+  mRunning = true;
+  eos_static_info("msg=\"start of http event server succeeded [port=%d]\"",
+                  mPort);
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(30));
+  }
+
+  mEventServer->Stop();
+  mEventServer.reset();
+}
+
+/*----------------------------------------------------------------------------*/
+void
+HttpServer::HandleExchange(HttpExchange& exchange)
+{
+  exchange.SendResponse(HttpResponse::NOT_IMPLEMENTED, HttpExchange::HeaderMap(),
+                        "");
+}
+
 #ifdef EOS_MICRO_HTTPD
 
 
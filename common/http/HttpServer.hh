@@ -29,6 +29,7 @@
  */
 
 #pragma once
+#include "common/http/HttpEventServer.hh"
 #include "common/http/HttpRequest.hh"
 #include "common/http/HttpResponse.hh"
 #include "common/AssistedThread.hh"
@@ -85,6 +86,15 @@ public:
    */
   void Run(ThreadAssistant& assistant) noexcept;
 
+  /**
+   * HTTP exchange handler function of the event-driven server, called by
+   * one of its worker threads
+   *
+   * @param exchange the request to serve and its response
+   */
+  virtual void
+  HandleExchange(HttpExchange& exchange);
+
   /**
    * Get an HTTP redirect response object.
    *
@@ -286,6 +296,12 @@ public:
 #endif
 
 protected:
+  /**
+   * Run the event-driven server instead of libmicrohttpd
+   */
+  void RunEventServer(ThreadAssistant& assistant) noexcept;
+
+  std::unique_ptr<HttpEventServer> mEventServer; //!< Event-driven server
 #ifdef EOS_MICRO_HTTPD
   struct MHD_Daemon* mDaemon {
     nullptr
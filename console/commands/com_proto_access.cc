@@ -414,6 +414,16 @@ void com_access_help()
       << "\t             threads:*              : set the default thread pool limit for each user\n"
       << "\t             threads:<uid/username> : set a specific thread pool limit for user <username/uid>\n"
       << std::endl
+      << "access set limit <value> admission:{global,group,user,app}:{<id>,*}:{r,w,*}\n"
+      << "\t             admission:global:*:<op>     : set the global token bucket rate in Hz for read, write or all operations\n"
+      << "\t             admission:group:<gid>:<op>  : set the token bucket rate in Hz for group <gid> or each group if *\n"
+      << "\t             admission:user:<uid>:<op>   : set the token bucket rate in Hz for user <uid> or each user if *\n"
+      << "\t             admission:app:<name>:<op>   : set the token bucket rate in Hz for application <name> or each application if *\n"
+      << "\t                                           the rate must be greater than 0, unlike for rate: limits 0 does not stall\n"
+      << "\t             admission:queue:depth       : set the maximum number of requests waiting for admission\n"
+      << "\t             admission:queue:wait        : set the maximum time in milliseconds a request waits for admission\n"
+      << "\t             admission:stall:max         : set the maximum stall time in seconds for rejected requests\n"
+      << std::endl
       << "access set limit <nfiles> rate:user:{name}:FindFiles :\n\tset find query limit to <nfiles> for user {name}\n"
       << std::endl
       << "access set limit <ndirs> rate:user:{name}:FindDirs:\n\tset find query limit to <ndirs> for user {name}\n"
@@ -457,6 +467,7 @@ void com_access_help()
       << " access set limit 0    rate:user:ab:OpenRead    : Limit the open for read rate for the ab user to 0 Hz, to continuously stall it\n"
       << " access set limit 2000 rate:group:zp:Stat       : Limit the stat rate for the zp group to 2kHz\n"
       << " access set limit 500 threads:*                 : Limit the thread pool usage to 500 threads per user\n"
+      << " access set limit 200 admission:user:*:w        : Admit at most 200 write requests per second for each user\n"
       << " access rm limit rate:user:*:OpenRead           : Removes the defined limit\n"
       << " access rm limit threads:*                      : Removes the default per user thread pool limit\n"
       << " access stallhosts add stall foo*.bar           : Add foo*.bar to the list of hosts which are stalled by limit rules (white list)\n"
@@ -143,6 +143,29 @@ ConvertHelper::ParseCommand(const char* arg)
 
         config->set_maxqueuesize(max_queue_size);
         option = true;
+      } else if (token.beginswith("--batchsize")) {
+        uint32_t batch_size = 0ul;
+
+        if (token.beginswith("--batchsize=")) {
+          token.replace("--batchsize=", "");
+        } else {
+          tokenizer.NextToken(token);
+        }
+
+        try {
+          batch_size = std::stoul(token.c_str());
+
+          if (batch_size == 0) {
+            throw std::invalid_argument("value zero not allowed");
+          }
+        } catch (...) {
+          std::cerr << "error: invalid value for <batchsize>='"
+                    << token << "'" << std::endl;
+          return false;
+        }
+
+        config->set_batchsize(batch_size);
+        option = true;
       } else {
         std::cerr << "warning: unknown config option '"
                   << token << "'" << std::endl;
@@ -375,6 +398,9 @@ void com_convert_help()
       << "    set converter engine configuration option      " << std::endl
       << "    --maxthreads=<#>   : max threadpool size (default 100)" << std::endl
       << "    --maxqueuesize=<#> : max queue size (default 1000)" << std::endl
+      << "    --batchsize=<#>    : max small file conversions grouped in a batch,"
+      << std::endl
+      << "                         1 disables batching (default 1)" << std::endl
       << std::endl
       << "  convert list [<option>]                          " << std::endl
       << "    list conversion jobs where <option> is:        " << std::endl
@@ -272,7 +272,11 @@ NsHelper::ParseCommand(const char* arg)
         int pos = 0;
         soption = option;
 
-        if ((soption.find("cid:") == 0)) {
+        if (soption == "--background") {
+          quota->set_background(true);
+        } else if (soption == "--status") {
+          quota->set_status(true);
+        } else if ((soption.find("cid:") == 0)) {
           pos = soption.find(':') + 1;
           quota->mutable_container()->set_cid(soption.substr(pos));
         } else if (soption.find("cxid:") == 0) {
@@ -701,9 +705,18 @@ void com_ns_help()
       << "    --depth : maximum depth for recomputation, default 0 i.e no limit"
       << std::endl
       << std::endl
-      << "  ns recompute_quotanode <path>|cid:<decimal_id>|cxid:<hex_id>"
+      << "  ns recompute_quotanode <path>|cid:<decimal_id>|cxid:<hex_id> [--background]"
+      << std::endl
+      << "    recompute the specified quotanode while the namespace stays online"
+      << std::endl
+      << "    --background : return once queued instead of waiting for the result"
+      << std::endl
+      << std::endl
+      << "  ns recompute_quotanode --status"
+      << std::endl
+      << "    show the progress and ETA of the queued recomputations and the"
       << std::endl
-      << "    recompute the specified quotanode"
+      << "    result of the finished ones"
       << std::endl
       << std::endl
       << "  ns update_quotanode <path>|cid:<decimal_id>|cxid:<hex_id> uid:<uid>|gid:<gid> bytes:<bytes> physicalbytes:<bytes> inodes:<inodes>"
@@ -64,7 +64,7 @@ void com_recycle_help()
       << std::endl
       << "    -m     : display info in monitoring format" << std::endl
       << std::endl
-      << "  recycle ls [-g|<date> [<limit>]] [-m] [-n]" << std::endl
+      << "  recycle ls [-g|<date> [<limit>]] [-m] [-n] [-c <cursor>]" << std::endl
       << "    list files in the recycle bin" << std::endl
       << "    -g     : list files of all users (if done by root or admin)"
       << std::endl
@@ -75,6 +75,10 @@ void com_recycle_help()
       << "             e.g.: recycle ls 2018/08/12" << std::endl
       << "    -m     : display info in monitoring format" << std::endl
       << "    -n     : display numeric uid/gid(s) instead of names" << std::endl
+      << "    -c <cursor> : continue a limited listing at the cursor reported by"
+      << std::endl
+      << "             the previous one (only with the recycle bin index)"
+      << std::endl
       << std::endl
       << "  recycle purge [-g|<date>] [-k <key>]" << std::endl
       << "    purge files in the recycle bin" << std::endl
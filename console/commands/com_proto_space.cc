@@ -499,6 +499,10 @@ void com_space_help()
       << "space config <space-name> space.drainer.node.nfs=<#>                  : configure the number of max draining filesystems per node (Valid only for central drain)  [ default=5 ]\n"
       << "space config <space-name> space.drainer.retries=<#>                   : configure the number of retry for the draining process (Valid only for central drain)     [ default=1 ]\n"
       << "space config <space-name> space.drainer.fs.ntx=<#>                    : configure the number of parallel draining transfers per fs (Valid only for central drain) [ default=5 ]\n"
+      << "space config <space-name> space.drainer.node.slots=<#>                : configure the max number of draining transfers per node, in and out (Valid only for central drain) [ default=0 (unlimited) ]\n"
+      << "space config <space-name> space.drainer.node.bw=<MB/s>                : configure the drain bandwidth budget per node, in and out (Valid only for central drain) [ default=0 (unlimited) ]\n"
+      << "space config <space-name> space.drainer.disk.slots=<#>                : configure the max number of draining transfers per source or destination disk (Valid only for central drain) [ default=0 (unlimited) ]\n"
+      << "space config <space-name> space.drainer.disk.bw=<MB/s>                : configure the drain bandwidth budget per source or destination disk (Valid only for central drain) [ default=0 (unlimited) ]\n"
       << "space config <space-name> space.groupbalancer=on|off                  : enable/disable the group balancer [ default=off ]\n"
       << "space config <space-name> space.groupbalancer.ntx=<ntx>               : configure the number of parallel group balancer jobs per 10s [ default=10 ]\n"
       << "space config <space-name> space.groupbalancer.engine=[value]          : configure the groupbalancer engine - std/minmax/freespace [ default=std ]\n"
@@ -520,6 +524,8 @@ void com_space_help()
       << "space config <space-name> space.groupdrainer.ntx                      : configure the max file transfer queue size [default=10000]\n"
       << "space config <space-name> space.lru=on|off                            : enable/disable the LRU policy engine [ default=off ]\n"
       << "space config <space-name> space.lru.interval=<sec>                    : configure the default lru scan interval\n"
+      << "space config <space-name> space.lru.incremental=on|off                : enable/disable the event driven LRU candidate queues [ default=off ]\n"
+      << "space config <space-name> space.lru.rate=<n>                          : limit the incremental LRU to <n> deletions/conversions per second [ default=0 (no limit) ]\n"
       << "space config <space-name> fs.max.ropen=<n>                            : allow more than <n> read streams per disk in the given space\n"
       << "space config <space-name> fs.max.wopen=<n>                            : allow more than <n> write streams per disk in the given space\n"
       << "space config <space-name> space.wfe=on|off|paused                     : enable/disable the Workflow Engine [ default=off ]\n"
@@ -93,6 +93,14 @@ RecycleHelper::ParseCommand(const char* arg)
           ls->set_monitorfmt(true);
         } else if (soption == "-n") {
           ls->set_numericids(true);
+        } else if (soption == "-c") {
+          if (!(option = tokenizer.GetToken())) {
+            std::cerr << "error: you have to provide a cursor when using the -c "
+                      << "option" << std::endl;
+            return false;
+          }
+
+          ls->set_cursor(option);
         } else {
           // This must be a date format
           if (!CheckDateFormat(soption)) {
@@ -26,6 +26,7 @@
 #include "fst/XrdFstOfsFile.hh"
 #include "common/http/ProtocolHandler.hh"
 #include "common/SecEntity.hh"
+#include "common/Timing.hh"
 #include "fst/XrdFstOfs.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
@@ -446,6 +447,174 @@ HttpServer::FileReaderCallback(void* cls, uint64_t pos, char* buf, size_t max)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// HTTP exchange handler function of the event-driven server. Like the XrdHttp
+// bridge, a PUT opens the file with the CREATE verb and the body is then
+// written piece by piece while GET streams the file.
+//------------------------------------------------------------------------------
+void
+HttpServer::HandleExchange(eos::common::HttpExchange& exchange)
+{
+  using eos::common::HttpResponse;
+  using eos::common::HttpExchange;
+  std::map<std::string, std::string> headers = exchange.GetHeaders();
+  std::map<std::string, std::string> cookies = exchange.GetCookies();
+  std::string method = exchange.GetMethod();
+  std::string uri = exchange.GetPath();
+  std::string query = exchange.GetQuery();
+  // CREATE makes sure the handler just opens the file and all writes
+  // are done later
+  std::string verb = (method == "PUT") ? "CREATE" : method;
+  std::string body;
+  ProtocolHandlerFactory factory = ProtocolHandlerFactory();
+  std::unique_ptr<eos::common::ProtocolHandler> handler(
+    factory.CreateProtocolHandler(verb, headers, 0));
+
+  if (!handler) {
+    eos_static_err("msg=\"no matching protocol for request method %s\"",
+                   method.c_str());
+    exchange.SendResponse(HttpResponse::METHOD_NOT_ALLOWED,
+                          HttpExchange::HeaderMap(), "");
+    return;
+  }
+
+  size_t bodySize = 0;
+  eos::common::HttpRequest request(headers, verb, uri, query, body, &bodySize,
+                                   cookies, true);
+  eos_static_debug("\n\n%s", request.ToString().c_str());
+  handler->HandleRequest(&request);
+  HttpResponse* response = handler->GetResponse();
+
+  if (!response) {
+    eos_static_crit("msg=\"response creation failed\"");
+    exchange.SendResponse(HttpResponse::INTERNAL_SERVER_ERROR,
+                          HttpExchange::HeaderMap(), "");
+    return;
+  }
+
+  response->AddHeader("Date",  eos::common::Timing::utctime(time(NULL)));
+  // Content length determined while opening the file
+  long long content_length = response->GetBody().length();
+  auto it_hd = response->GetHeaders().find("Content-Length");
+
+  if (it_hd != response->GetHeaders().end()) {
+    try {
+      content_length = std::stoll(it_hd->second);
+    } catch (...) {}
+  }
+
+  if (method == "HEAD") {
+    exchange.SendResponseHead(response->GetResponseCode(),
+                              response->GetHeaders(), content_length);
+    return;
+  }
+
+  if (method == "GET") {
+    if ((response->GetResponseCode() != response->OK) &&
+        (response->GetResponseCode() != response->PARTIAL_CONTENT)) {
+      exchange.SendResponse(response->GetResponseCode(), response->GetHeaders(),
+                            response->GetBody());
+      return;
+    }
+
+    int retc = 0;
+
+    if (!exchange.SendResponseHead(response->GetResponseCode(),
+                                   response->GetHeaders(), content_length)) {
+      retc = -1;
+    }
+
+    ssize_t nread = 0;
+    off_t pos = 0;
+    // allocate an IO buffer of 1M or if smaller the required content length
+    std::vector<char> buffer(content_length > (1024 * 1024) ?
+                             (1024 * 1024) : content_length);
+
+    while (!retc && (pos != content_length)) {
+      nread = FileReader(handler.get(), pos, &buffer[0], buffer.size());
+
+      if ((nread <= 0) || !exchange.SendBody(&buffer[0], nread)) {
+        retc = -1;
+      } else {
+        pos += nread;
+      }
+    }
+
+    FileClose(handler.get(), retc);
+    return;
+  }
+
+  if (method == "PUT") {
+    bool is_chunked = (headers.count("transfer-encoding") &&
+                       (headers["transfer-encoding"] == "chunked"));
+
+    // If no content-length provided then return an error
+    if ((headers.count("content-length") == 0) && !is_chunked) {
+      response->SetResponseCode(HttpResponse::LENGTH_REQUIRED);
+    }
+
+    if ((response->GetResponseCode() != 0) &&
+        (response->GetResponseCode() != 200)) {
+      exchange.SendResponse(response->GetResponseCode(), response->GetHeaders(),
+                            response->GetBody());
+      return;
+    }
+
+    // The server decodes a chunked body, both encodings are written the same
+    // way. The first read answers an "Expect: 100-continue".
+    const size_t eoshttp_sz = 1024 * 1024;
+    std::vector<char> buffer(eoshttp_sz);
+    ssize_t retc = 0;
+
+    while (!retc) {
+      size_t len = 0;
+      ssize_t nread = 0;
+
+      while ((len < eoshttp_sz) &&
+             ((nread = exchange.ReadBody(&buffer[len], eoshttp_sz - len)) > 0)) {
+        len += nread;
+      }
+
+      if (nread < 0) {
+        eos_static_err("msg=\"failed to read PUT body\" path=\"%s\"",
+                       uri.c_str());
+        FileClose(handler.get(), -1);
+        return;
+      }
+
+      if (!len) {
+        break;
+      }
+
+      body.assign(&buffer[0], len);
+      retc = FileWriter(handler.get(), method, uri, headers, query, cookies,
+                        body);
+    }
+
+    if (!retc) {
+      // trigger the close handler by calling with empty body
+      body.clear();
+      retc = FileWriter(handler.get(), method, uri, headers, query, cookies,
+                        body);
+    }
+
+    response = handler->GetResponse();
+
+    if (response && response->GetResponseCode()) {
+      exchange.SendResponse(response->GetResponseCode(), response->GetHeaders(),
+                            response->GetBody());
+    } else {
+      exchange.SendResponse(HttpResponse::INTERNAL_SERVER_ERROR,
+                            HttpExchange::HeaderMap(), "");
+    }
+
+    return;
+  }
+
+  exchange.SendResponse(response->GetResponseCode(), response->GetHeaders(),
+                        response->GetBody());
+}
+
 std::unique_ptr<eos::common::ProtocolHandler>
 HttpServer::XrdHttpHandler(std::string& method,
                            std::string& uri,
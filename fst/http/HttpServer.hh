@@ -86,6 +86,14 @@ public:
 
 #endif
 
+  /**
+   * HTTP exchange handler function on FST called by the event-driven server
+   *
+   * @param exchange the request to serve and its response
+   */
+  virtual void
+  HandleExchange(eos::common::HttpExchange& exchange);
+
   /**
    * File Read Callback function
    *
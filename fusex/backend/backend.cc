@@ -751,6 +751,127 @@ backend::putMD(fuse_id& id, eos::fusex::md* md, std::string authid,
   }
 }
 
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+backend::putMDBatch(fuse_id& id, std::vector<eos::fusex::md>& mds,
+                    const std::vector<std::string>& authids,
+                    std::vector<int>& retc)
+{
+  if (!(id.getid())) {
+    id.bind();
+  }
+
+  {
+    // update host + port NOW
+    XrdCl::URL lurl("root://" + hostport);
+    id.getid()->url.SetHostPort(lurl.GetHostName(), lurl.GetPort());
+  }
+
+  id.getid()->query["eos.app"] = get_appname();
+  id.getid()->query["fuse.v"] = std::to_string(FUSEPROTOCOLVERSION);
+  id.getid()->url.SetParams(id.getid()->query);
+  eos::fusex::md batch;
+  batch.set_operation(batch.BATCH);
+  batch.set_clientuuid(clientuuid);
+
+  for (size_t i = 0; i < mds.size(); ++i) {
+    eos::fusex::md* item = batch.add_batch();
+    *item = mds[i];
+    item->set_authid(authids[i]);
+    item->set_clientuuid(clientuuid);
+  }
+
+  std::string mdstream;
+
+  if (!batch.SerializeToString(&mdstream)) {
+    eos_static_err("fatal serialization error");
+    return EFAULT;
+  }
+
+  XrdCl::Buffer arg;
+  XrdCl::Buffer* response = 0;
+  std::string prefix = "/?fusex:";
+  arg.Append(prefix.c_str(), prefix.length());
+  arg.Append(mdstream.c_str(), mdstream.length());
+  eos_static_debug("query: url=%s path=%s length=%d batch=%lu",
+                   id.getid()->url.GetURL().c_str(),
+                   prefix.c_str(), mdstream.length(), mds.size());
+  XrdCl::XRootDStatus status = Query(id.getid()->url,
+                                     XrdCl::QueryCode::OpaqueFile, arg,
+                                     response, put_timeout);
+  std::unique_ptr<XrdCl::Buffer> rsp(response);
+
+  if (!status.IsOK()) {
+    eos_static_err("batch query resulted in error batch=%lu url=%s", mds.size(),
+                   id.getid()->url.GetURL().c_str());
+
+    if (status.code == XrdCl::errErrorResponse) {
+      eos_static_err("errno=%i", status.errNo);
+      return mapErrCode(status.errNo);
+    }
+
+    return EIO;
+  }
+
+  if (!response || !response->GetBuffer() || (response->GetSize() <= 6) ||
+      (std::string(response->GetBuffer(), 6) != "Fusex:")) {
+    eos_static_err("protocol error - illegal batch response received");
+    return EIO;
+  }
+
+  std::string sresponse;
+  std::string b64response;
+  b64response.assign(response->GetBuffer() + 6, response->GetSize() - 6);
+  eos::common::SymKey::DeBase64(b64response, sresponse);
+  eos::fusex::response resp;
+
+  if (!resp.ParseFromString(sresponse) || (resp.type() != resp.BATCH) ||
+      (resp.batch_().item__size() != (int) mds.size())) {
+    eos_static_err("parsing error/wrong batch response type received");
+    return EIO;
+  }
+
+  retc.assign(mds.size(), 0);
+
+  for (size_t i = 0; i < mds.size(); ++i) {
+    const eos::fusex::batch_item& item = resp.batch_().item_(i);
+
+    if (item.err_no()) {
+      eos_static_err("failed batched query for ino=%lx errno=%d", mds[i].id(),
+                     item.err_no());
+      retc[i] = item.err_no();
+      continue;
+    }
+
+    eos::fusex::response item_resp;
+
+    if (!item_resp.ParseFromString(item.result()) ||
+        ((item_resp.type() != item_resp.ACK) &&
+         (item_resp.type() != item_resp.NONE))) {
+      eos_static_err("parsing error/wrong response type received for ino=%lx",
+                     mds[i].id());
+      retc[i] = EIO;
+      continue;
+    }
+
+    if (item_resp.type() == item_resp.ACK) {
+      if (item_resp.ack_().code() != item_resp.ack_().OK) {
+        eos_static_err("failed batched query for ino=%lx error='%s'", mds[i].id(),
+                       item_resp.ack_().err_msg().c_str());
+        retc[i] = EIO;
+        continue;
+      }
+
+      if (item_resp.ack_().md_ino()) {
+        mds[i].set_md_ino(item_resp.ack_().md_ino());
+      }
+    }
+  }
+
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 int
 /* -------------------------------------------------------------------------- */
@@ -94,6 +94,13 @@ public:
   int putMD(fuse_id& id, eos::fusex::md* md, std::string authid,
             XrdSysMutex* locker);
 
+  // push several md records in a single request, the MGM applies them in
+  // order and the per record result is returned in retc - a non-zero return
+  // value means that the batch as a whole could not be delivered
+  int putMDBatch(fuse_id& id, std::vector<eos::fusex::md>& mds,
+                 const std::vector<std::string>& authids,
+                 std::vector<int>& retc);
+
   int getCAP(fuse_req_t req,
              uint64_t inode,
              std::vector<eos::fusex::container>& cont
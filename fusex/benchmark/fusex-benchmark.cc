@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <chrono>
 
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
@@ -34,6 +35,7 @@
 #define LOOP_20 100
 #define LOOP_21 10000
 #define LOOP_22 5
+#define LOOP_23 500
 
 int main(int argc, char* argv[])
 {
@@ -1003,6 +1005,67 @@ int main(int argc, char* argv[])
     COMMONTIMING("concurrent-list-recursive", &tm);
   }
 
+  // ------------------------------------------------------------------------ //
+  testno = 23;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+    // small file creation rate, dominated by the metadata flush to the MGM
+    char data[1024];
+    memset(data, 'x', sizeof(data));
+    size_t nfiles = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    if (mkdir("test23", S_IRWXU)) {
+      fprintf(stderr, "[test=%03d] toplevel mkdir failed\n", testno);
+      exit(testno);
+    }
+
+    for (size_t i1 = 0; i1 < 10; i1++) {
+      snprintf(name, sizeof(name), "test23/dir-%04lu", i1);
+
+      if (mkdir(name, S_IRWXU)) {
+        fprintf(stderr, "[test=%03d] mkdir failed %s\n", testno, name);
+        exit(testno);
+      }
+
+      for (size_t i2 = 0; i2 < LOOP_23; i2++) {
+        snprintf(name, sizeof(name), "test23/dir-%04lu/file-%04lu", i1, i2);
+        int fd = creat(name, S_IRWXU);
+
+        if (fd < 0) {
+          fprintf(stderr, "[test=%03d] creat failed %s\n", testno, name);
+          exit(testno);
+        }
+
+        if (write(fd, data, sizeof(data)) != (ssize_t) sizeof(data)) {
+          fprintf(stderr, "[test=%03d] write failed %s\n", testno, name);
+          exit(testno);
+        }
+
+        close(fd);
+        nfiles++;
+      }
+    }
+
+    // a sync flushes the pending metadata updates
+    sync();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                            start;
+    fprintf(stderr, "[test=%03d] created %lu files in %.02f s rate=%.02f files/s\n",
+            testno, nfiles, elapsed.count(), nfiles / elapsed.count());
+    eos::common::cmd_status rc;
+    eos::common::ShellCmd removedir("rm -r test23");
+    rc = removedir.wait(60);
+
+    if (rc.exit_code) {
+      fprintf(stderr, "[test=%03d] rm -r test23 dir failed\n", testno);
+      exit(testno);
+    }
+
+    COMMONTIMING("small-file-create", &tm);
+  }
+
   tm.Print();
   fprintf(stdout, "realtime = %.02f\n", tm.RealTime());
 }
@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------------
+//! @file fusex-md-benchmark.cc
+//! @brief multi-threaded meta data benchmark for an eosxd mount
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+// Runs stat, open/close and lookup of missing names on a set of files from
+// 1, 2, 4 ... up to max-threads threads and prints the aggregated rate for
+// each thread count. Against an eosxd mount this measures how the client's
+// inode and data tables scale with the number of FUSE worker threads.
+//
+// usage: fusex-md-benchmark <dir> [files=10000] [max-threads=64] [seconds=5]
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string
+filename(const std::string& dir, size_t i)
+{
+  char name[4096];
+  snprintf(name, sizeof(name), "%s/f.%08lu", dir.c_str(), i);
+  return name;
+}
+
+static uint64_t
+run(const std::string& dir, size_t files, size_t threads, int seconds,
+    uint64_t& errors)
+{
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> ops(0);
+  std::atomic<uint64_t> errs(0);
+  std::vector<std::thread> workers;
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 rnd(t);
+      uint64_t n = 0;
+      uint64_t e = 0;
+      struct stat buf;
+
+      while (!stop.load(std::memory_order_relaxed)) {
+        size_t i = rnd() % files;
+        std::string name = filename(dir, i);
+
+        switch (n % 4) {
+        case 0:
+        case 1:
+          if (stat(name.c_str(), &buf)) {
+            e++;
+          }
+
+          break;
+
+        case 2: {
+          int fd = open(name.c_str(), O_RDONLY);
+
+          if (fd < 0) {
+            e++;
+          } else {
+            close(fd);
+          }
+        }
+        break;
+
+        case 3:
+          // negative lookup
+          name += ".missing";
+
+          if (!stat(name.c_str(), &buf)) {
+            e++;
+          }
+
+          break;
+        }
+
+        n++;
+      }
+
+      ops += n;
+      errs += e;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  stop = true;
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  errors = errs.load();
+  return ops.load();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <dir> [files=10000] [max-threads=64] [seconds=5]\n",
+            argv[0]);
+    exit(EINVAL);
+  }
+
+  std::string dir = argv[1];
+  size_t files = (argc > 2) ? strtoul(argv[2], 0, 10) : 10000;
+  size_t max_threads = (argc > 3) ? strtoul(argv[3], 0, 10) : 64;
+  int seconds = (argc > 4) ? atoi(argv[4]) : 5;
+
+  if (!files || !max_threads || (seconds <= 0)) {
+    fprintf(stderr, "error: invalid arguments\n");
+    exit(EINVAL);
+  }
+
+  dir += "/fusex-md-benchmark." + std::to_string(getpid());
+
+  if (mkdir(dir.c_str(), S_IRWXU)) {
+    fprintf(stderr, "error: failed to create %s errno=%d\n", dir.c_str(), errno);
+    exit(errno);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < files; ++i) {
+    int fd = creat(filename(dir, i).c_str(), S_IRWXU);
+
+    if (fd < 0) {
+      fprintf(stderr, "error: creat failed i=%lu errno=%d\n", i, errno);
+      exit(errno);
+    }
+
+    close(fd);
+  }
+
+  double ct = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+              start).count();
+  fprintf(stdout, "# created %lu files in %.02f s [ %.01f Hz ]\n", files, ct,
+          files / ct);
+  fprintf(stdout, "# %8s %12s %12s %10s %8s\n", "threads", "ops", "rate[Hz]",
+          "speedup", "errors");
+  double base_rate = 0;
+  int rc = 0;
+  std::vector<size_t> counts;
+
+  for (size_t threads = 1; threads < max_threads; threads *= 2) {
+    counts.push_back(threads);
+  }
+
+  // always finish with the requested maximum
+  counts.push_back(max_threads);
+
+  for (size_t threads : counts) {
+    uint64_t errors = 0;
+    uint64_t ops = run(dir, files, threads, seconds, errors);
+    double rate = 1.0 * ops / seconds;
+
+    if (!base_rate) {
+      base_rate = rate;
+    }
+
+    fprintf(stdout, "  %8lu %12lu %12.01f %10.02f %8lu\n", threads, ops, rate,
+            base_rate ? rate / base_rate : 0, errors);
+    fflush(stdout);
+
+    if (errors) {
+      rc = EIO;
+    }
+  }
+
+  for (size_t i = 0; i < files; ++i) {
+    unlink(filename(dir, i).c_str());
+  }
+
+  rmdir(dir.c_str());
+  return rc;
+}
@@ -0,0 +1,212 @@
+//------------------------------------------------------------------------------
+//! @file fusex-read-benchmark.cc
+//! @brief multi-threaded read throughput benchmark for cached files
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+// Writes a set of files, reads them once to populate the eosxd file cache and
+// then reads them completely from 1, 2, 4 ... up to max-threads threads,
+// printing the aggregated throughput for each thread count. Files have to be
+// smaller than the per-file cache size of the mount. Run it with
+// "data-splice" and "data-passthrough" disabled and enabled to compare the
+// copying, the splicing and the passthrough read path. O_DIRECT is not used,
+// so a mount with "data-kernelcache" measures the kernel page cache instead.
+//
+// usage: fusex-read-benchmark <dir> [files=16] [size-mb=4] [max-threads=16] [seconds=5] [block-kb=128]
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string
+filename(const std::string& dir, size_t i)
+{
+  char name[4096];
+  snprintf(name, sizeof(name), "%s/f.%08lu", dir.c_str(), i);
+  return name;
+}
+
+// read a file completely, returns the number of bytes or -1
+static ssize_t
+readfile(const std::string& name, char* buf, size_t block)
+{
+  int fd = open(name.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  ssize_t total = 0;
+  ssize_t n = 0;
+
+  while ((n = read(fd, buf, block)) > 0) {
+    total += n;
+  }
+
+  close(fd);
+  return (n < 0) ? -1 : total;
+}
+
+static uint64_t
+run(const std::string& dir, size_t files, size_t size, size_t block,
+    size_t threads, int seconds, uint64_t& errors)
+{
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> bytes(0);
+  std::atomic<uint64_t> errs(0);
+  std::vector<std::thread> workers;
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::vector<char> buf(block);
+      uint64_t n = 0;
+      uint64_t e = 0;
+
+      for (size_t i = t; !stop.load(std::memory_order_relaxed); ++i) {
+        ssize_t r = readfile(filename(dir, i % files), buf.data(), block);
+
+        if (r != (ssize_t) size) {
+          e++;
+        } else {
+          n += r;
+        }
+      }
+
+      bytes += n;
+      errs += e;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  stop = true;
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  errors = errs.load();
+  return bytes.load();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <dir> [files=16] [size-mb=4] [max-threads=16] [seconds=5] [block-kb=128]\n",
+            argv[0]);
+    exit(EINVAL);
+  }
+
+  std::string dir = argv[1];
+  size_t files = (argc > 2) ? strtoul(argv[2], 0, 10) : 16;
+  size_t size = ((argc > 3) ? strtoul(argv[3], 0, 10) : 4) * 1024 * 1024;
+  size_t max_threads = (argc > 4) ? strtoul(argv[4], 0, 10) : 16;
+  int seconds = (argc > 5) ? atoi(argv[5]) : 5;
+  size_t block = ((argc > 6) ? strtoul(argv[6], 0, 10) : 128) * 1024;
+
+  if (!files || !size || !max_threads || (seconds <= 0) || !block) {
+    fprintf(stderr, "error: invalid arguments\n");
+    exit(EINVAL);
+  }
+
+  dir += "/fusex-read-benchmark." + std::to_string(getpid());
+
+  if (mkdir(dir.c_str(), S_IRWXU)) {
+    fprintf(stderr, "error: failed to create %s errno=%d\n", dir.c_str(), errno);
+    exit(errno);
+  }
+
+  std::vector<char> buf(size);
+
+  for (size_t i = 0; i < size; ++i) {
+    buf[i] = (char)(i * 31);
+  }
+
+  for (size_t i = 0; i < files; ++i) {
+    int fd = creat(filename(dir, i).c_str(), S_IRWXU);
+
+    if ((fd < 0) || (write(fd, buf.data(), size) != (ssize_t) size) || close(fd)) {
+      fprintf(stderr, "error: failed to write file i=%lu errno=%d\n", i, errno);
+      exit(errno ? errno : EIO);
+    }
+  }
+
+  // the first read populates the file cache
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < files; ++i) {
+    if (readfile(filename(dir, i), buf.data(), block) != (ssize_t) size) {
+      fprintf(stderr, "error: failed to read file i=%lu errno=%d\n", i, errno);
+      exit(errno ? errno : EIO);
+    }
+  }
+
+  double ct = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+              start).count();
+  fprintf(stdout, "# warmed %lu files of %lu MB in %.02f s [ %.01f MB/s ]\n",
+          files, size / 1024 / 1024, ct, files * size / ct / 1000000.0);
+  fprintf(stdout, "# %8s %14s %12s %10s %8s\n", "threads", "bytes", "rate[MB/s]",
+          "speedup", "errors");
+  double base_rate = 0;
+  int rc = 0;
+  std::vector<size_t> counts;
+
+  for (size_t threads = 1; threads < max_threads; threads *= 2) {
+    counts.push_back(threads);
+  }
+
+  // always finish with the requested maximum
+  counts.push_back(max_threads);
+
+  for (size_t threads : counts) {
+    uint64_t errors = 0;
+    uint64_t bytes = run(dir, files, size, block, threads, seconds, errors);
+    double rate = bytes / 1000000.0 / seconds;
+
+    if (!base_rate) {
+      base_rate = rate;
+    }
+
+    fprintf(stdout, "  %8lu %14lu %12.01f %10.02f %8lu\n", threads, bytes, rate,
+            base_rate ? rate / base_rate : 0, errors);
+    fflush(stdout);
+
+    if (errors) {
+      rc = EIO;
+    }
+  }
+
+  for (size_t i = 0; i < files; ++i) {
+    unlink(filename(dir, i).c_str());
+  }
+
+  rmdir(dir.c_str());
+  return rc;
+}
@@ -26,6 +26,7 @@
 #include "diskcache.hh"
 #include "memorycache.hh"
 #include "journalcache.hh"
+#include "sharedcache.hh"
 #include "cachehandler.hh"
 #include "common/Logging.hh"
 #include "common/Path.hh"
@@ -63,6 +64,15 @@ cachehandler::init(cacheconfig& _config)
     }
   }
 
+  if (config.shared_location.length()) {
+    if (sharedcache::instance().init(config)) {
+      fprintf(stderr,
+              "error: shared cache directory %s cannot be initialized - check existence/permissions!\n",
+              config.shared_location.c_str());
+      return EPERM;
+    }
+  }
+
   return 0;
 }
 
@@ -95,6 +105,14 @@ cachehandler::init_daemonized()
     }
   }
 
+  if (config.shared_location.length()) {
+    rc = sharedcache::instance().init_daemonized(config);
+
+    if (rc) {
+      return rc;
+    }
+  }
+
   return rc;
 }
 
@@ -147,10 +165,32 @@ cachehandler::logconfig()
                            eos::common::StringConversion::GetReadableSizeString(s,
                                config.per_file_journal_max_size, "B"));
       }
+
+      if (config.journal_writeback_size == 0) {
+        eos_static_warning("journal-writeback    := disabled");
+      } else {
+        eos_static_warning("journal-writeback    := %s",
+                           eos::common::StringConversion::GetReadableSizeString(s,
+                               config.journal_writeback_size, "B"));
+      }
     } else {
       eos_static_warning("journal-location     := disabled");
     }
   }
+
+  if (config.shared_location.length()) {
+    std::string s;
+    eos_static_warning("shared-cache-location:= %s",
+                       config.shared_location.c_str());
+    eos_static_warning("shared-cache-size    := %s",
+                       eos::common::StringConversion::GetReadableSizeString(s,
+                           config.shared_cache_size, "B"));
+    eos_static_warning("shared-block-size    := %s",
+                       eos::common::StringConversion::GetReadableSizeString(s,
+                           config.shared_block_size, "B"));
+  } else {
+    eos_static_warning("shared-cache-location:= disabled");
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -59,6 +59,12 @@ public:
     return 0;
   }
 
+  // file descriptor holding the cached bytes at their file offsets, -1 if none
+  virtual int descriptor()
+  {
+    return -1;
+  }
+
   virtual int set_attr(const std::string& key, const std::string& value) = 0;
   virtual int attr(const std::string& key, std::string& value) = 0;
 
@@ -36,12 +36,14 @@ struct cacheconfig {
     total_file_cache_size = total_file_cache_inodes = per_file_cache_max_size =
                               total_file_journal_size = total_file_journal_inodes = per_file_journal_max_size
                                   = default_read_ahead_size = max_inflight_read_ahead_buffer_size =
-                                        max_inflight_write_buffer_size = max_read_ahead_size = 0 ;
+                                        max_inflight_write_buffer_size = max_read_ahead_size =
+                                              journal_writeback_size = 0 ;
     max_read_ahead_blocks = 0;
     read_ahead_sparse_ratio = 0;
     clean_threshold = 0;
     clean_on_startup = false;
     rescuecache = false;
+    shared_cache_size = shared_block_size = 0;
   }
 
   cache_t type;
@@ -52,6 +54,7 @@ struct cacheconfig {
   uint64_t total_file_journal_size; // total size of the journal cache
   uint64_t total_file_journal_inodes; // max number of inodes in the journal cache
   uint64_t per_file_journal_max_size; // per file maximum journal cache size
+  uint64_t journal_writeback_size; // writes below this size are coalesced in the journal before going upstream
   uint64_t default_read_ahead_size; // default start value for read-ahead
   uint64_t max_inflight_read_ahead_buffer_size; // max size of read-ahead-buffers
   uint64_t max_inflight_write_buffer_size; // max size of write buffers
@@ -63,6 +66,9 @@ struct cacheconfig {
   bool  rescuecache; // indicates if journals/cache files are kept with .rescue extension in case of failures
   std::string journal;
   bool clean_on_startup; // indicate that the cache is not reusable after restart
+  std::string shared_location; // location of the host-wide shared block cache, empty if disabled
+  uint64_t shared_cache_size; // total size of the shared block cache
+  uint64_t shared_block_size; // block size of the shared block cache
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include "eosfuse.hh"
 #include "data/cachesyncer.hh"
 #include "data/journalcache.hh"
+#include "data/sharedcache.hh"
 #include "data/xrdclproxy.hh"
 #include "misc/MacOSXHelper.hh"
 #include "misc/fusexrdlogin.hh"
@@ -38,6 +39,8 @@
 
 
 bufferllmanager data::datax::sBufferManager;
+std::atomic<uint64_t> data::datax::sSpliceBytes(0);
+std::atomic<uint64_t> data::datax::sPassthroughOpens(0);
 std::string data::datax::kInlineAttribute = "sys.file.buffer";
 std::string data::datax::kInlineMaxSize = "sys.file.inline.maxsize";
 std::string data::datax::kInlineCompressor = "sys.file.inline.compressor";
@@ -90,38 +93,40 @@ data::get(fuse_req_t req,
           metad::shared_md md)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
-
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
-    io->attach(); // client ref counting
-    return io;
-  } else {
-    // protect against running out of file descriptors
-    size_t openfiles = datamap.size();
-    size_t openlimit = (EosFuse::Instance().Config().options.fdlimit - 128) / 2;
-
-    while ((openfiles = datamap.size()) > openlimit) {
-      datamap.UnLock();
-      eos_static_warning("open-files=%lu limit=%lu - waiting for release of file descriptors",
-                         openfiles, openlimit);
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      datamap.Lock();
-    }
+  dshard& s = datamap.shard(ino);
+  {
+    XrdSysMutexHelper mLock(s);
 
-    if (datamap.count(ino)) {
-      // might have been created in the meanwhile
-      shared_data io = datamap[ino];
+    if (s.count(ino)) {
+      shared_data io = s[ino];
       io->attach(); // client ref counting
       return io;
-    } else {
-      shared_data io = std::make_shared<datax>(md);
-      io->set_id(ino, req);
-      datamap[(fuse_ino_t) io->id()] = io;
-      io->attach();
-      return io;
     }
   }
+  // protect against running out of file descriptors
+  size_t openfiles = 0;
+  size_t openlimit = (EosFuse::Instance().Config().options.fdlimit - 128) / 2;
+
+  while ((openfiles = datamap.sizeTS()) > openlimit) {
+    eos_static_warning("open-files=%lu limit=%lu - waiting for release of file descriptors",
+                       openfiles, openlimit);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  }
+
+  XrdSysMutexHelper mLock(s);
+
+  if (s.count(ino)) {
+    // might have been created in the meanwhile
+    shared_data io = s[ino];
+    io->attach(); // client ref counting
+    return io;
+  } else {
+    shared_data io = std::make_shared<datax>(md);
+    io->set_id(ino, req);
+    s[ino] = io;
+    io->attach();
+    return io;
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -130,11 +135,12 @@ bool
 data::has(fuse_ino_t ino, bool checkwriteopen)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dshard& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
+  if (s.count(ino)) {
     if (checkwriteopen) {
-      if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      if (s[ino]->flags() & (O_RDWR | O_WRONLY)) {
         return true;
       } else {
         return false;
@@ -154,34 +160,61 @@ data::url(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
   std::string p;
-  XrdSysMutexHelper mLock(datamap);
+  dshard& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    p = datamap[ino]->fullpath();
+  if (s.count(ino)) {
+    p = s[ino]->fullpath();
 
     while (p.find("//") != std::string::npos) {
       p.replace(p.find("//"), p.size(), "/");
     }
 
     p += " [";
-    p += datamap[ino]->url(true);
+    p += s[ino]->url(true);
     p += " ]";
   }
 
   return p;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+data::readahead_stats(std::vector<rastat_t>& stats)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<shared_data> ios;
+
+  for (size_t i = 0; i < dmap::nshards; ++i) {
+    XrdSysMutexHelper mLock(datamap.at(i));
+
+    for (auto it = datamap.at(i).begin(); it != datamap.at(i).end(); ++it) {
+      ios.push_back(it->second);
+    }
+  }
+
+  for (auto it = ios.begin(); it != ios.end(); ++it) {
+    rastat_t stat;
+
+    if ((*it)->readahead_stats(stat)) {
+      stats.push_back(stat);
+    }
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 metad::shared_md
 data::retrieve_wr_md(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
   // return the shared_md  boject if this is a writer
-  XrdSysMutexHelper mLock(datamap);
+  dshard& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
-      return datamap[ino]->md();
+  if (s.count(ino)) {
+    if (s[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      return s[ino]->md();
     }
   }
 
@@ -195,19 +228,23 @@ data::release(fuse_req_t req,
               fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  datamap.lock2(ino, ino + 0xffffffff);
+  dshard& s = datamap.shard(ino);
+  dshard& us = datamap.shard(ino + 0xffffffff);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->detach();
     // the object is cleaned by the flush thread
   }
 
-  if (datamap.count(ino + 0xffffffff)) {
+  if (us.count(ino + 0xffffffff)) {
     // in case this is an unlinked object
-    shared_data io = datamap[ino + 0xffffffff];
+    shared_data io = us[ino + 0xffffffff];
     io->detach();
   }
+
+  datamap.unlock2(ino, ino + 0xffffffff);
 }
 
 void
@@ -215,10 +252,11 @@ void
 data::update_cookie(uint64_t ino, std::string& cookie)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dshard& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->attach(); // client ref counting
     io->store_cookie(cookie);
     io->detach();
@@ -231,10 +269,11 @@ void
 data::invalidate_cache(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dshard& s = datamap.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (s.count(ino)) {
+    shared_data io = s[ino];
     io->attach(); // client ref counting
     io->cache_invalidate();
     io->detach();
@@ -251,11 +290,12 @@ data::unlink(fuse_req_t req, fuse_ino_t ino)
   bool is_rw = false;
   shared_data datap;
   {
-    XrdSysMutexHelper mLock(datamap);
-    has_data = datamap.count(ino);
+    dshard& s = datamap.shard(ino);
+    XrdSysMutexHelper mLock(s);
+    has_data = s.count(ino);
 
     if (has_data) {
-      datap = datamap[ino];
+      datap = s[ino];
     }
   }
 
@@ -268,17 +308,20 @@ data::unlink(fuse_req_t req, fuse_ino_t ino)
     }
     // put the unlinked inode in a high bucket, will be removed by the flush thread
     {
-      XrdSysMutexHelper mLock(datamap);
+      datamap.lock2(ino, ino + 0xffffffff);
+      dshard& s = datamap.shard(ino);
 
-      if (datamap.count(ino)) {
-	if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      if (s.count(ino)) {
+	if (s[ino]->flags() & (O_RDWR | O_WRONLY)) {
 	  is_rw = true;
 	}
 
-        datamap[ino + 0xffffffff] = datamap[ino];
-        datamap.erase(ino);
-        eos_static_info("datacache::unlink size=%lu", datamap.size());
+        datamap.shard(ino + 0xffffffff)[ino + 0xffffffff] = s[ino];
+        s.erase(ino);
+        eos_static_info("datacache::unlink ino=%#lx", ino);
       }
+
+      datamap.unlock2(ino, ino + 0xffffffff);
     }
     return is_rw;
   } else {
@@ -341,6 +384,15 @@ data::datax::flush_nolock(fuse_req_t req, bool wait_open, bool wait_writes)
   bool journal_recovery = false;
   errno = 0;
 
+  if (mFile->journal() && mFile->has_xrdiorw(req) &&
+      mFile->journal()->writeback_bytes()) {
+    // send the tail of the coalesced writes, a failure is recovered from the
+    // journal like any failed upstream write
+    if (mFile->journal()->writeback(mFile->xrdiorw(req))) {
+      eos_err("journal write-back failed");
+    }
+  }
+
   if (mFile->journal() && mFile->has_xrdiorw(req)) {
     eos_info("flushing journal");
     ssize_t truncate_size = mFile->journal()->get_truncatesize();
@@ -729,6 +781,12 @@ data::datax::attach(fuse_req_t freq, std::string& cookie, int flags)
     mFile->disable_caches();
   }
 
+  if (isRW && mPassthrough && mFile->file()) {
+    // passthrough readers read the cache file directly in the kernel, a writer
+    // must not modify it underneath them - they keep the content they opened
+    remove_file_cache();
+  }
+
   int bcache = mFile->file() ? mFile->file()->attach(freq, cookie, isRW) : 0;
   int jcache = mFile->journal() ? ((isRW ||
                                     (mFlags & O_CACHE)) ? mFile->journal()->attach(freq, cookie,
@@ -2351,6 +2409,8 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
   if (dw < 0) {
     return dw;
   } else {
+    bool coalesce = false;
+
     if (mFile->journal()) {
       if (!mFile->journal()->fits(count)) {
         int rc = flush_nolock(req, true, true);
@@ -2362,8 +2422,12 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
         }
       }
 
+      // small writes are kept in the journal and go upstream as merged ranges
+      coalesce = (journalcache::writeback_size() &&
+                  (count < journalcache::writeback_size()) &&
+                  !(mFlags & O_SYNC) && mFile->has_xrdiorw(req));
       // now there is space to write for us
-      ssize_t jw = mFile->journal()->pwrite(buf, count, offset);
+      ssize_t jw = mFile->journal()->pwrite(buf, count, offset, coalesce);
 
       if (jw < 0) {
         return jw;
@@ -2393,11 +2457,21 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
       }
     }
 
-    // send an asynchronous upstream write, which does not wait for the file open to be done
-    XrdCl::Proxy::write_handler handler =
-      mFile->xrdiorw(req)->WriteAsyncPrepare(mFile->xrdiorw(req), count, offset, 60);
-    XrdCl::XRootDStatus status =
-      mFile->xrdiorw(req)->ScheduleWriteAsync(buf, handler);
+    XrdCl::XRootDStatus status;
+
+    if (coalesce) {
+      if (mFile->journal()->writeback_due() &&
+          mFile->journal()->writeback(mFile->xrdiorw(req))) {
+        status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError, EIO,
+                                     "journal write-back failed");
+      }
+    } else {
+      // send an asynchronous upstream write, which does not wait for the file open to be done
+      XrdCl::Proxy::write_handler handler =
+        mFile->xrdiorw(req)->WriteAsyncPrepare(mFile->xrdiorw(req), count, offset, 60);
+      status = mFile->xrdiorw(req)->ScheduleWriteAsync(buf, handler);
+    }
+
     // test if we switch to xoff mode, where we only write into the journal
     size_t cnt = 0;
 
@@ -2424,6 +2498,11 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
 
     mXoff = false;
 
+    if (coalesce && (mFlags & O_SYNC)) {
+      // switched to sync mode, nothing may stay behind in the journal
+      mFile->journal()->writeback(mFile->xrdiorw(req));
+    }
+
     if ((!status.IsOK()) && (!EosFuse::Instance().Config().recovery.write)) {
       errno = XrdCl::Proxy::status2errno(status);
       eos_err("async remote-io failed msg=\"%s\"", status.ToString().c_str());
@@ -2515,9 +2594,17 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
 /* -------------------------------------------------------------------------- */
 {
   size_t md_size = 0;
+  uint64_t md_ino = 0;
+  std::string etag;
   {
     XrdSysMutexHelper lLock(mMd->Locker());
     md_size = (*mMd)()->size();
+
+    if (sharedcache::instance().enabled()) {
+      md_ino = (*mMd)()->md_ino();
+      etag = sharedcache::etag(EosFuse::Instance().Config().hostport,
+                               (*mMd)()->mtime(), (*mMd)()->mtime_ns(), md_size);
+    }
   }
   mLock.Lock();
   eos_info("offset=%llu count=%lu size=%lu", offset, count, md_size);
@@ -2616,6 +2703,25 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     }
   }
 
+  // read the missing part from the shared cache - only for files nobody
+  // modifies locally, otherwise the version identifier is not reliable
+  if (md_ino && mFile->has_xrdioro(req) && !mFile->has_xrdiorw(req) &&
+      (!mFile->journal() || ((mFile->journal()->get_truncatesize() < 0) &&
+                             mFile->journal()->get_chunks(offset + br + jr,
+                                 count - br - jr).empty()))) {
+    ssize_t sr = shared_pread(req, buf + br + jr, count - br - jr,
+                              offset + br + jr, md_ino, etag, md_size);
+
+    if (sr >= 0) {
+      if (mFile->journal() && (mFlags & O_CACHE)) {
+        // optionally populate the read journal cache
+        mFile->journal()->pwrite(buf, br + jr + sr, offset);
+      }
+
+      return (br + jr + sr);
+    }
+  }
+
   // read the missing part remote
   XrdCl::shared_proxy proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(
                                 req) : mFile->xrdiorw(req);
@@ -2786,6 +2892,89 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
   return -1;
 }
 
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+data::datax::shared_pread(fuse_req_t req, char* buf, size_t count,
+                          off_t offset, uint64_t fid, const std::string& etag,
+                          size_t file_size)
+/* -------------------------------------------------------------------------- */
+{
+  sharedcache& sc = sharedcache::instance();
+  size_t bs = sc.blocksize();
+
+  if ((size_t) offset >= file_size) {
+    return 0;
+  }
+
+  if ((offset + count) > file_size) {
+    count = file_size - offset;
+  }
+
+  XrdCl::shared_proxy proxy = mFile->xrdioro(req);
+  bufferllmanager::shared_buffer block;
+  size_t done = 0;
+  bool failed = false;
+
+  while (done < count) {
+    off_t pos = offset + done;
+    uint64_t blk = pos / bs;
+    off_t blk_offset = pos - (blk * bs);
+    size_t blk_size = std::min(bs, (size_t)(file_size - (blk * bs)));
+    size_t len = std::min(count - done, (size_t)(blk_size - blk_offset));
+
+    if (sc.read(fid, etag, blk, buf + done, len, blk_offset) == (ssize_t) len) {
+      done += len;
+      continue;
+    }
+
+    // fetch the complete block, failures fall back to the regular remote read
+    if (!proxy) {
+      failed = true;
+      break;
+    }
+
+    XrdCl::XRootDStatus status;
+
+    if (proxy->IsOpening()) {
+      status = proxy->WaitOpen();
+    }
+
+    if (!block) {
+      block = sBufferManager.get_buffer(bs);
+    }
+
+    uint32_t bytesRead = 0;
+
+    if (status.IsOK()) {
+      status = proxy->Read(proxy, blk * bs, blk_size, block->ptr(), bytesRead);
+    }
+
+    if (!status.IsOK() || (bytesRead != blk_size)) {
+      eos_debug("shared-cache fetch failed block=%lu bytes-read=%u msg=\"%s\"",
+                blk, bytesRead, status.ToString().c_str());
+      failed = true;
+      break;
+    }
+
+    sc.account_miss(blk_size);
+    int rc = sc.put(fid, etag, blk, block->ptr(), blk_size);
+
+    if (rc) {
+      eos_warning("shared-cache store failed block=%lu errno=%d", blk, -rc);
+    }
+
+    memcpy(buf + done, block->ptr() + blk_offset, len);
+    done += len;
+  }
+
+  if (block) {
+    sBufferManager.put_buffer(block);
+  }
+
+  return failed ? -1 : (ssize_t) done;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -2793,12 +2982,96 @@ data::datax::release_pread()
 /* -------------------------------------------------------------------------- */
 {
   eos_info("");
-  sBufferManager.put_buffer(buffer);
-  buffer.reset();
+
+  if (buffer) {
+    // peek_splice does not use a buffer
+    sBufferManager.put_buffer(buffer);
+    buffer.reset();
+  }
+
   mLock.UnLock();
   return;
 }
 
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+data::datax::peek_splice(fuse_req_t req, int& fd, size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  // returns the number of bytes which can be spliced from fd at offset and
+  // keeps mLock until release_pread, returns -1 if peek_pread has to be used
+  size_t md_size = 0;
+  {
+    XrdSysMutexHelper lLock(mMd->Locker());
+    md_size = (*mMd)()->size();
+  }
+  mLock.Lock();
+  fd = mFile->file() ? mFile->file()->descriptor() : -1;
+
+  if ((fd < 0) || ((size_t) offset >= md_size) ||
+      (inline_buffer && inlined()) ||
+      (mFile->journal() && (mFile->journal()->get_truncatesize() >= 0))) {
+    mLock.UnLock();
+    return -1;
+  }
+
+  size_t avail = ((offset + count) > md_size) ? (md_size - offset) : count;
+
+  if (((off_t)(offset + avail) > mFile->file()->prefetch_size()) ||
+      ((offset + avail) > mFile->file()->size())) {
+    mLock.UnLock();
+    return -1;
+  }
+
+  eos_info("offset=%llu count=%lu size=%lu splice=%lu", offset, count, md_size,
+           avail);
+  sSpliceBytes += avail;
+  return avail;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+data::datax::passthrough_open(fuse_req_t req)
+/* -------------------------------------------------------------------------- */
+{
+  // returns the cache file descriptor if it holds the complete file, the
+  // kernel then serves all reads of this handle without calling eosxd
+  size_t md_size = 0;
+  {
+    XrdSysMutexHelper lLock(mMd->Locker());
+    md_size = (*mMd)()->size();
+  }
+  XrdSysMutexHelper lLock(mLock);
+  int fd = mFile->file() ? mFile->file()->descriptor() : -1;
+
+  if ((fd < 0) || !md_size || (inline_buffer && inlined()) ||
+      (mFile->journal() && (mFile->journal()->get_truncatesize() >= 0)) ||
+      ((off_t) md_size > mFile->file()->prefetch_size()) ||
+      (mFile->file()->size() != md_size)) {
+    return -1;
+  }
+
+  mPassthrough++;
+  sPassthroughOpens++;
+  eos_info("size=%lu passthrough=%lu", md_size, mPassthrough);
+  return fd;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+data::datax::passthrough_close()
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mLock);
+
+  if (mPassthrough) {
+    mPassthrough--;
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 int
 /* -------------------------------------------------------------------------- */
@@ -2828,7 +3101,10 @@ data::datax::truncate(fuse_req_t req, off_t offset)
     if (offset <= mFile->file()->prefetch_size()) {
       // if the truncate falls into the file cache size, we have disable it because
       // subsequent writes can stamp a whole inside the file cache
-      dt = mFile->file()->truncate(0);
+      if (!mPassthrough) {
+        dt = mFile->file()->truncate(0);
+      }
+
       remove_file_cache();
     }
   }
@@ -2896,6 +3172,10 @@ data::datax::sync()
       it->second->WaitOpen();
     }
 
+    if (mFile->journal() && mFile->journal()->writeback_bytes()) {
+      mFile->journal()->writeback(it->second);
+    }
+
     XrdCl::XRootDStatus status = it->second->WaitWrite();
 
     if (!status.IsOK()) {
@@ -2943,8 +3223,18 @@ data::datax::cache_invalidate()
 {
   eos_info("");
   XrdSysMutexHelper lLock(mLock);
-  // truncate the block cache
-  int dt = mFile->file() ? mFile->file()->truncate(0) : 0;
+  int dt = 0;
+
+  if (mFile->file()) {
+    if (mPassthrough) {
+      // passthrough readers still use the cache file, stop using it here instead
+      remove_file_cache();
+    } else {
+      // truncate the block cache
+      dt = mFile->file()->truncate(0);
+    }
+  }
+
   int jt = mFile->journal() ? mFile->journal()->truncate(0, true) : 0;
   inline_buffer = nullptr;
 
@@ -3092,6 +3382,40 @@ data::datax::set_shared_url()
   mUrl = std::make_shared<std::string>(p);
 }
 
+/* -------------------------------------------------------------------------- */
+bool
+data::datax::readahead_stats(rastat_t& stat)
+/* -------------------------------------------------------------------------- */
+{
+  XrdCl::shared_proxy proxy;
+
+  // never block the statistics behind a running IO
+  if (!mLock.CondLock()) {
+    return false;
+  }
+
+  if (mFile && mFile->has_xrdioro(mReq)) {
+    proxy = mFile->xrdioro(mReq);
+  }
+
+  mLock.UnLock();
+
+  if (!proxy || !proxy->get_read_bytes()) {
+    return false;
+  }
+
+  static const char* strategies[] = {"none", "static", "dynamic", "adaptive"};
+  stat.ino = mIno;
+  stat.path = fullpath();
+  stat.strategy = strategies[proxy->get_readahead_strategy()];
+  stat.bytes = proxy->get_read_bytes();
+  stat.efficiency = proxy->get_readahead_efficiency();
+  stat.volume_efficiency = proxy->get_readahead_volume_efficiency();
+  stat.waste = proxy->get_readahead_waste_bytes();
+  stat.streams = proxy->get_readahead_streams();
+  return true;
+}
+
 /* -------------------------------------------------------------------------- */
 std::string
 data::datax::url(bool nonblocking)
@@ -3147,10 +3471,7 @@ data::dmap::waitflush(uint64_t seconds)
   // if all is flushed, it returns true, otherwise false
   for (uint64_t i = 0; i < seconds; ++i) {
     size_t nattached = 0;
-    {
-      XrdSysMutexHelper mLock(this);
-      nattached = this->size();
-    }
+    nattached = sizeTS();
 
     if (nattached) {
       eos_static_warning("[ waiting data to be flushed for %03d io objects] [ %d of %d seconds ]",
@@ -3178,11 +3499,11 @@ data::dmap::ioflush(ThreadAssistant& assistant)
     {
       //eos_static_debug("");
       std::vector<shared_data> data;
-      {
-        // avoid mutex contention
-        XrdSysMutexHelper mLock(this);
+      // avoid mutex contention
+      for (size_t i = 0; i < nshards; ++i) {
+        XrdSysMutexHelper mLock(at(i));
 
-        for (auto it = this->begin(); it != this->end(); ++it) {
+        for (auto it = at(i).begin(); it != at(i).end(); ++it) {
           if (it->second) {
             data.push_back(it->second);
           }
@@ -3281,6 +3602,12 @@ data::dmap::ioflush(ThreadAssistant& assistant)
                                   (*it)->id());
                   // flush the journal using an asynchronous thread pool
                   // skipped: (*it)->journalflush_async(fit->first);
+                  if ((*it)->file()->journal() &&
+                      (*it)->file()->journal()->writeback_bytes()) {
+                    // coalesced writes which arrived after the last flush
+                    (*it)->file()->journal()->writeback(fit->second);
+                  }
+
                   fit->second->set_state_TS(XrdCl::Proxy::WAITWRITE);
                   eos_static_info("changing to wait write state");
                 }
@@ -3446,19 +3773,23 @@ data::dmap::ioflush(ThreadAssistant& assistant)
             }
           }
         }
-        XrdSysMutexHelper mLock(this);
-        XrdSysMutexHelper lLock((*it)->Locker());
+        uint64_t id = (*it)->id();
+        lock2(id, id + 0xffffffff);
+        {
+          XrdSysMutexHelper lLock((*it)->Locker());
 
-        // re-check that nobody is attached
-        if (!(*it)->attached_nolock() && !(*it)->file()->get_xrdiorw().size() &&
-            !(*it)->file()->get_xrdioro().size()) {
-          eos_static_info("dropping one");
-          // here we make the data object unreachable for new clients
-          (*it)->detach_nolock();
-          cachehandler::instance().rm((*it)->id());
-          this->erase((*it)->id());
-          this->erase((*it)->id() + 0xffffffff);
+          // re-check that nobody is attached
+          if (!(*it)->attached_nolock() && !(*it)->file()->get_xrdiorw().size() &&
+              !(*it)->file()->get_xrdioro().size()) {
+            eos_static_info("dropping one");
+            // here we make the data object unreachable for new clients
+            (*it)->detach_nolock();
+            cachehandler::instance().rm(id);
+            shard(id).erase(id);
+            shard(id + 0xffffffff).erase(id + 0xffffffff);
+          }
         }
+        unlock2(id, id + 0xffffffff);
       }
 
       assistant.wait_for(std::chrono::milliseconds(128));
@@ -31,6 +31,7 @@
 #include "data/io.hh"
 #include "data/cachehandler.hh"
 #include "misc/FuseId.hh"
+#include "misc/shardedmap.hh"
 #include "md/md.hh"
 #include "cap/cap.hh"
 #include "common/AssistedThread.hh"
@@ -55,6 +56,21 @@ class data
 {
 public:
 
+  //----------------------------------------------------------------------------
+  // read-ahead statistics of an open file
+  //----------------------------------------------------------------------------
+
+  typedef struct rastat {
+    fuse_ino_t ino;
+    std::string path;
+    std::string strategy;
+    off_t bytes; // bytes read
+    float efficiency; // percentage of the bytes read served by read-ahead
+    float volume_efficiency; // percentage of the read-ahead volume used
+    uint64_t waste; // read-ahead bytes dropped without being read
+    size_t streams; // streams detected by the adaptive read-ahead
+  } rastat_t;
+
   //----------------------------------------------------------------------------
 
   class datax : public LogId
@@ -68,7 +84,7 @@ public:
       mSimulateWriteErrorInFlusher(false),
       mFlags(0), mXoff(false), mIsInlined(false), mInlineMaxSize(0),
       mInlineCompressor("none"), mIsUnlinked(false),
-      mCanRecoverRead(true)
+      mCanRecoverRead(true), mPassthrough(0)
 
     {
       inline_buffer = nullptr;
@@ -80,7 +96,7 @@ public:
       mSimulateWriteErrorInFlusher(false),
       mFlags(0), mXoff(false),
       mIsInlined(false), mInlineMaxSize(0), mInlineCompressor("none"),
-      mIsUnlinked(false), mCanRecoverRead(true) { }
+      mIsUnlinked(false), mCanRecoverRead(true), mPassthrough(0) { }
 
     virtual ~datax()
     {
@@ -144,6 +160,10 @@ public:
     ssize_t pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset);
     ssize_t peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset);
     void release_pread();
+    // zero-copy variants of peek_pread for data fully held by the file cache
+    ssize_t peek_splice(fuse_req_t req, int& fd, size_t count, off_t offset);
+    int passthrough_open(fuse_req_t req);
+    void passthrough_close();
     int truncate(fuse_req_t req, off_t offset);
     int sync();
     size_t size();
@@ -219,6 +239,16 @@ public:
 
     static bufferllmanager sBufferManager;
 
+    static uint64_t splice_bytes()
+    {
+      return sSpliceBytes;
+    }
+
+    static uint64_t passthrough_opens()
+    {
+      return sPassthroughOpens;
+    }
+
     bool simulate_write_error_in_flusher()
     {
       return mSimulateWriteErrorInFlusher;
@@ -277,10 +307,15 @@ public:
     const char* Dump(std::string& out);
 
     std::string url(bool nonblocking = false);
+    bool readahead_stats(rastat_t& stat);
     typedef std::shared_ptr<std::string> shared_url;
     void set_shared_url();
 
   private:
+    // read a range through the host-wide shared block cache
+    ssize_t shared_pread(fuse_req_t req, char* buf, size_t count, off_t offset,
+                         uint64_t fid, const std::string& etag, size_t file_size);
+
     XrdSysMutex mLock;
     uint64_t mIno;
     fuse_req_t mReq;
@@ -308,6 +343,9 @@ public:
     bufferllmanager::shared_buffer inline_buffer;
     bool mIsUnlinked;
     bool mCanRecoverRead;
+    static std::atomic<uint64_t> sSpliceBytes;
+    static std::atomic<uint64_t> sPassthroughOpens;
+    size_t mPassthrough; // open handles reading the file cache in the kernel
   };
 
   typedef std::shared_ptr<datax> shared_data;
@@ -326,6 +364,7 @@ public:
     uint64_t _maxfilesize; // maximum allowed file size
     uint64_t _opensize; // size at the moment of opening the file
     eos::common::SymKey::hmac_t hmac; /// obfuscation/encryption cipher
+    int backing_id; // kernel passthrough backing file, -1 if not used
 
     _data_fh(shared_data _data, metad::shared_md _md, bool _rw, fuse_id _id)
     {
@@ -339,6 +378,7 @@ public:
       next_size_flush.store(0, std::memory_order_seq_cst);
       _maxfilesize = 0;
       _opensize = (*md)()->size();
+      backing_id = -1;
     }
 
     ~_data_fh() { }
@@ -419,7 +459,12 @@ public:
 
   //----------------------------------------------------------------------------
 
-  class dmap : public std::map<fuse_ino_t, shared_data>, public XrdSysMutex
+  // a lock domain of the table of data objects
+  class dshard : public std::map<fuse_ino_t, shared_data>, public XrdSysMutex
+  {
+  };
+
+  class dmap : public shardedmap<dshard>
   //----------------------------------------------------------------------------
   {
   public:
@@ -463,6 +508,8 @@ public:
 
   std::string url(fuse_ino_t ino);
 
+  void readahead_stats(std::vector<rastat_t>& stats);
+
   void release(fuse_req_t req,
                fuse_ino_t ino);
 
@@ -477,8 +524,7 @@ public:
 
   size_t size()
   {
-    XrdSysMutexHelper mLock(datamap);
-    return datamap.size();
+    return datamap.sizeTS();
   }
 
   void set_xoff()
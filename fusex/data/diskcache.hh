@@ -70,6 +70,11 @@ public:
     return sMaxSize;
   }
 
+  virtual int descriptor() override
+  {
+    return fd;
+  }
+
 private:
   XrdSysMutex mMutex;
   int location(std::string& path, bool mkpath = true);
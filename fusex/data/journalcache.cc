@@ -37,11 +37,15 @@ constexpr size_t journalcache::sDefaultMaxSize;
 
 std::string journalcache::sLocation;
 size_t journalcache::sMaxSize = journalcache::sDefaultMaxSize;
+size_t journalcache::sWriteBackSize = 0;
+std::atomic<uint64_t> journalcache::sWriteBackHeld(0);
+std::atomic<uint64_t> journalcache::sWriteBackSent(0);
 
 std::shared_ptr<dircleaner> journalcache::jDirCleaner;
 
 journalcache::journalcache(fuse_ino_t ino) : ino(ino), cachesize(0),
-  truncatesize(-1), max_offset(0), fd(-1), nbAttached(0), nbFlushed(0)
+  truncatesize(-1), max_offset(0), fd(-1), pending_bytes(0), pending_since(0),
+  nbAttached(0), nbFlushed(0)
 {
   memset(&attachstat, 0, sizeof(attachstat));
   memset(&detachstat, 0, sizeof(detachstat));
@@ -363,7 +367,8 @@ int journalcache::update_cache(std::vector<chunk_t>& updates)
   return 0;
 }
 
-ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset)
+ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset,
+                             bool writeback)
 {
   if (count <= 0) {
     return 0;
@@ -426,9 +431,108 @@ ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset)
     max_offset = offset + count;
   }
 
+  if (writeback) {
+    hold(offset, offset + count);
+  }
+
   return count;
 }
 
+void journalcache::hold(uint64_t low, uint64_t high)
+{
+  // merge with all kept ranges overlapping or touching [low, high)
+  auto res = pending.query(low ? low - 1 : 0, high + 1);
+  std::vector<std::pair<uint64_t, uint64_t>> merged;
+  uint64_t writes = 1;
+
+  for (auto& itr : res) {
+    low = std::min(low, (uint64_t) itr->low);
+    high = std::max(high, (uint64_t) itr->high);
+    writes += itr->value;
+    pending_bytes -= (itr->high - itr->low);
+    merged.push_back(std::make_pair(itr->low, itr->high));
+  }
+
+  for (auto& m : merged) {
+    pending.erase(m.first, m.second);
+  }
+
+  pending.insert(low, high, writes);
+  pending_bytes += (high - low);
+
+  if (!pending_since) {
+    pending_since = time(NULL);
+  }
+
+  sWriteBackHeld++;
+}
+
+bool journalcache::writeback_due()
+{
+  read_lock lck(clck);
+
+  if (!pending_bytes) {
+    return false;
+  }
+
+  // send when a full write-back block is collected, when there are too many
+  // disjoint ranges or when the oldest range waits for more than a second
+  return ((pending_bytes >= sWriteBackSize) ||
+          (pending.size() >= 64) ||
+          ((time(NULL) - pending_since) >= 1));
+}
+
+int journalcache::writeback(XrdCl::shared_proxy proxy)
+{
+  if (!proxy) {
+    return -1;
+  }
+
+  write_lock lck(clck);
+  int rc = 0;
+  off_t offshift = sizeof(header_t);
+
+  for (auto itr = pending.begin(); itr != pending.end(); ++itr) {
+    size_t size = itr->high - itr->low;
+    std::vector<char> data(size);
+    // a merged range can span several journal entries
+    auto res = journal.query(itr->low, itr->high);
+
+    for (auto& jtr : res) {
+      uint64_t low = std::max((uint64_t) jtr->low, (uint64_t) itr->low);
+      uint64_t high = std::min((uint64_t) jtr->high, (uint64_t) itr->high);
+      off_t cacheoff = jtr->value + offshift + (low - jtr->low);
+      ssize_t nr = ::pread(fd, data.data() + (low - itr->low), high - low, cacheoff);
+
+      if (nr != (ssize_t)(high - low)) {
+        rc = -1;
+        break;
+      }
+    }
+
+    if (rc) {
+      eos_static_err("failed to read journal for write-back ino=%#lx", ino);
+      break;
+    }
+
+    XrdCl::Proxy::write_handler handler = proxy->WriteAsyncPrepare(proxy, size,
+                                          itr->low, 60);
+    XrdCl::XRootDStatus st = proxy->ScheduleWriteAsync(data.data(), handler);
+
+    if (!st.IsOK()) {
+      eos_static_err("failed to issue write-back ino=%#lx", ino);
+      rc = -1;
+      break;
+    }
+
+    sWriteBackSent++;
+  }
+
+  // on failure the journal still holds the data for the recovery
+  clear_pending();
+  return rc;
+}
+
 int journalcache::truncate(off_t offset, bool invalidate)
 {
   int rc = 0;
@@ -448,6 +552,7 @@ int journalcache::truncate(off_t offset, bool invalidate)
 
     max_offset = 0;
     journal.clear();
+    clear_pending();
     cachesize = 0;
 
     if (!::ftruncate(fd, 0)) {
@@ -492,6 +597,8 @@ int journalcache::init(const cacheconfig& config)
     journalcache::sMaxSize = config.per_file_journal_max_size;
   }
 
+  journalcache::sWriteBackSize = config.journal_writeback_size;
+
   eos_static_info("journalcache location %s", sLocation.c_str());
   return 0;
 }
@@ -525,6 +632,7 @@ int journalcache::remote_sync(cachesyncer& syncer)
 
   if (!ret) {
     journal.clear();
+    clear_pending();
     eos_static_debug("ret=%d truncatesize=%ld\n", ret, truncatesize);
     ret |= ::ftruncate(fd, 0);
     eos_static_debug("ret=%d errno=%d\n", ret, errno);
@@ -588,6 +696,7 @@ int journalcache::remote_sync_async(XrdCl::shared_proxy proxy)
   }
 
   journal.clear();
+  clear_pending();
   eos_static_debug("ret=%d truncatesize=%ld\n", ret, truncatesize);
   errno = 0;
   ret |= ::ftruncate(fd, 0);
@@ -600,6 +709,7 @@ int journalcache::reset()
 {
   write_lock lck(clck);
   journal.clear();
+  clear_pending();
   int retc = (fd > 0) ?::ftruncate(fd, 0) : 0;
   cachesize = 0;
   max_offset = 0;
@@ -35,6 +35,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <string>
 
 class journalcache
@@ -83,7 +84,9 @@ public:
   int unlink();
 
   ssize_t pread(void* buf, size_t count, off_t offset);
-  ssize_t pwrite(const void* buf, size_t count, off_t offset);
+  // with writeback the range is kept for a coalesced upstream write
+  ssize_t pwrite(const void* buf, size_t count, off_t offset,
+                 bool writeback = false);
 
   int truncate(off_t, bool invalidate = false);
   int sync();
@@ -112,6 +115,33 @@ public:
 
   int remote_sync_async(XrdCl::shared_proxy proxy);
 
+  // send the merged ranges kept for write-back as asynchronous writes
+  int writeback(XrdCl::shared_proxy proxy);
+
+  // true if the kept ranges should be sent now
+  bool writeback_due();
+
+  size_t writeback_bytes()
+  {
+    read_lock lck(clck);
+    return pending_bytes;
+  }
+
+  static size_t writeback_size()
+  {
+    return sWriteBackSize;
+  }
+
+  static uint64_t writeback_held()
+  {
+    return sWriteBackHeld;
+  }
+
+  static uint64_t writeback_sent()
+  {
+    return sWriteBackSent;
+  }
+
   static int init(const cacheconfig& config);
   static int init_daemonized(const cacheconfig& config);
 
@@ -158,6 +188,15 @@ private:
 
   int read_journal();
 
+  void hold(uint64_t low, uint64_t high);
+
+  void clear_pending()
+  {
+    pending.clear();
+    pending_bytes = 0;
+    pending_since = 0;
+  }
+
   fuse_ino_t ino;
   size_t cachesize;
   ssize_t truncatesize;
@@ -165,6 +204,11 @@ private:
   int fd;
   // the value is the offset in the cache file
   interval_tree<uint64_t, uint64_t> journal;
+  // ranges written to the journal but not yet upstream, merged when they
+  // overlap or touch, the value is the number of writes merged
+  interval_tree<uint64_t, uint64_t> pending;
+  size_t pending_bytes;
+  time_t pending_since;
   size_t nbAttached;
   size_t nbFlushed;
   cachelock clck;
@@ -173,6 +217,9 @@ private:
   bufferllmanager::shared_buffer buffer;
   static std::string sLocation;
   static size_t sMaxSize;
+  static size_t sWriteBackSize;
+  static std::atomic<uint64_t> sWriteBackHeld;
+  static std::atomic<uint64_t> sWriteBackSent;
 
   struct stat attachstat;
   struct stat detachstat;
@@ -0,0 +1,379 @@
+//------------------------------------------------------------------------------
+//! @file readaheadstreams.cc
+//! @brief per file handle detection of interleaved read streams driving the
+//!        adaptive read-ahead of the XrdCl proxy
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "readaheadstreams.hh"
+#include <string.h>
+
+constexpr size_t readaheadstreams::max_streams;
+constexpr size_t readaheadstreams::adapt_interval;
+constexpr double readaheadstreams::adapt_latency_ms;
+constexpr size_t readaheadstreams::max_vector_chunk;
+
+/* -------------------------------------------------------------------------- */
+readaheadstreams::readaheadstreams() : mClock(0), mMin(4096),
+  mNom(256 * 1024), mMax(1024 * 1024), mBlocksMax(16),
+  mMaxPosition(64 * 1024ll * 1024ll * 1024ll * 1024ll),
+  mHitBytes(0), mRaBytes(0), mWasteBytes(0)
+/* -------------------------------------------------------------------------- */
+{
+  memset(mStreams, 0, sizeof(mStreams));
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::configure(size_t min, size_t nom, size_t max,
+                            size_t blocks_max, off_t max_position)
+/* -------------------------------------------------------------------------- */
+{
+  mMin = min ? min : 4096;
+  mMax = (max > mMin) ? max : mMin;
+  mNom = (nom < mMin) ? mMin : ((nom > mMax) ? mMax : nom);
+  mBlocksMax = blocks_max ? blocks_max : 1;
+  mMaxPosition = max_position;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::reset(stream_t& st, off_t offset, size_t size)
+/* -------------------------------------------------------------------------- */
+{
+  if (st.active) {
+    mHitBytes += st.hit_bytes;
+    mRaBytes += st.ra_bytes;
+    mWasteBytes += st.waste_bytes;
+  }
+
+  memset(&st, 0, sizeof(st));
+  st.active = true;
+  st.last_offset = offset;
+  st.size = size;
+  st.next = offset + size;
+  st.window = (size > mNom) ? ((size > mMax) ? mMax : size) : mNom;
+  st.blocks = (mBlocksMax > 1) ? 2 : 1;
+  st.seq = 1;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+readaheadstreams::access(off_t offset, size_t size, int& evicted)
+/* -------------------------------------------------------------------------- */
+{
+  evicted = -1;
+  mClock++;
+  int match = -1;
+
+  // a read continuing a stream where it is expected
+  for (size_t i = 0; i < max_streams; ++i) {
+    if (mStreams[i].active && (mStreams[i].next == offset)) {
+      match = i;
+      break;
+    }
+  }
+
+  if (match < 0) {
+    // a second read at a short distance after a young stream defines a stride
+    const off_t max_stride = 16 * mMax;
+
+    for (size_t i = 0; i < max_streams; ++i) {
+      stream_t& st = mStreams[i];
+
+      if (st.active && (st.seq == 1) && !st.stride &&
+          (size == st.size) &&
+          (offset > (off_t)(st.last_offset + st.size)) &&
+          ((offset - st.last_offset) <= max_stride)) {
+        st.stride = offset - st.last_offset;
+        match = i;
+        break;
+      }
+    }
+  }
+
+  if (match >= 0) {
+    stream_t& st = mStreams[match];
+    st.seq++;
+    st.last_offset = offset;
+    st.size = size;
+    st.next = offset + (st.stride ? st.stride : (off_t) size);
+    st.stamp = mClock;
+    st.sample_reads++;
+
+    if (!st.stride && (st.window < size)) {
+      st.window = (size > mMax) ? mMax : size;
+    }
+
+    if (st.sample_reads >= adapt_interval) {
+      adapt(st);
+    }
+
+    return match;
+  }
+
+  // a new stream, take a free slot or recycle the least recently used one
+  int slot = 0;
+
+  for (size_t i = 0; i < max_streams; ++i) {
+    if (!mStreams[i].active) {
+      slot = i;
+      break;
+    }
+
+    if (mStreams[i].stamp < mStreams[slot].stamp) {
+      slot = i;
+    }
+  }
+
+  if (mStreams[slot].active) {
+    evicted = slot;
+  }
+
+  reset(mStreams[slot], offset, size);
+  mStreams[slot].stamp = mClock;
+  return slot;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::adapt(stream_t& st)
+/* -------------------------------------------------------------------------- */
+{
+  uint64_t total = st.sample_hit + st.sample_miss;
+
+  if (st.sample_ra && ((2 * st.sample_waste) > st.sample_ra)) {
+    // more than half of the prefetched volume was never read - shrink
+    st.window /= 2;
+
+    if (st.window < mMin) {
+      st.window = mMin;
+    }
+
+    if (st.blocks > 1) {
+      st.blocks /= 2;
+    }
+  } else {
+    if (total && ((10 * st.sample_hit) < (9 * total))) {
+      // the prefetching does not cover the reads - grow
+      if (st.stride) {
+        st.blocks *= 2;
+      } else {
+        st.window *= 2;
+
+        if (st.window > mMax) {
+          st.window = mMax;
+        }
+      }
+    }
+
+    if (st.sample_hit &&
+        ((st.sample_wait_ms / st.sample_reads) > adapt_latency_ms)) {
+      // readers wait for in-flight blocks - prefetch further ahead
+      st.blocks *= 2;
+    }
+
+    if (st.blocks > mBlocksMax) {
+      st.blocks = mBlocksMax;
+    }
+  }
+
+  st.sample_reads = 0;
+  st.sample_hit = 0;
+  st.sample_miss = 0;
+  st.sample_ra = 0;
+  st.sample_waste = 0;
+  st.sample_wait_ms = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::hit(int s, size_t bytes, double wait_ms)
+/* -------------------------------------------------------------------------- */
+{
+  stream_t& st = mStreams[s];
+  st.hit_bytes += bytes;
+  st.sample_hit += bytes;
+  st.sample_wait_ms += wait_ms;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::miss(int s, size_t bytes)
+/* -------------------------------------------------------------------------- */
+{
+  stream_t& st = mStreams[s];
+  st.miss_bytes += bytes;
+  st.sample_miss += bytes;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::waste(int s, size_t bytes)
+/* -------------------------------------------------------------------------- */
+{
+  if ((s < 0) || (s >= (int) max_streams)) {
+    mWasteBytes += bytes;
+    return;
+  }
+
+  stream_t& st = mStreams[s];
+  st.waste_bytes += bytes;
+  st.sample_waste += bytes;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+readaheadstreams::plan(int s, std::vector<chunk_t>& chunks, bool& vector)
+/* -------------------------------------------------------------------------- */
+{
+  stream_t& st = mStreams[s];
+  chunks.clear();
+  vector = false;
+
+  if (st.stride) {
+    // a strided stream needs two confirmed strides before prefetching
+    if (st.seq < 3) {
+      return false;
+    }
+
+    off_t pos = (st.ra_position > st.next) ? st.ra_position : st.next;
+    off_t end = st.next + st.stride * st.blocks;
+
+    for (; pos < end; pos += st.stride) {
+      if ((pos + (off_t) st.size) > mMaxPosition) {
+        break;
+      }
+
+      chunks.push_back({pos, st.size});
+    }
+
+    vector = ((chunks.size() > 1) && (st.size <= max_vector_chunk));
+  } else {
+    if (st.seq < 2) {
+      return false;
+    }
+
+    off_t pos = (st.ra_position > st.next) ? st.ra_position : st.next;
+    off_t end = st.next + (off_t)(st.window * st.blocks);
+
+    for (; pos < end; pos += st.window) {
+      if (pos >= mMaxPosition) {
+        break;
+      }
+
+      chunks.push_back({pos, st.window});
+    }
+  }
+
+  return !chunks.empty();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+readaheadstreams::prefetched(int s, const std::vector<chunk_t>& chunks,
+                             size_t n)
+/* -------------------------------------------------------------------------- */
+{
+  stream_t& st = mStreams[s];
+
+  if (!n || (n > chunks.size())) {
+    return;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    st.ra_bytes += chunks[i].size;
+    st.sample_ra += chunks[i].size;
+  }
+
+  st.ra_position = chunks[n - 1].offset +
+                   (st.stride ? st.stride : (off_t) chunks[n - 1].size);
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+readaheadstreams::active() const
+/* -------------------------------------------------------------------------- */
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i < max_streams; ++i) {
+    if (mStreams[i].active) {
+      n++;
+    }
+  }
+
+  return n;
+}
+
+/* -------------------------------------------------------------------------- */
+uint64_t
+/* -------------------------------------------------------------------------- */
+readaheadstreams::hit_bytes() const
+/* -------------------------------------------------------------------------- */
+{
+  uint64_t n = mHitBytes;
+
+  for (size_t i = 0; i < max_streams; ++i) {
+    n += mStreams[i].hit_bytes;
+  }
+
+  return n;
+}
+
+/* -------------------------------------------------------------------------- */
+uint64_t
+/* -------------------------------------------------------------------------- */
+readaheadstreams::ra_bytes() const
+/* -------------------------------------------------------------------------- */
+{
+  uint64_t n = mRaBytes;
+
+  for (size_t i = 0; i < max_streams; ++i) {
+    n += mStreams[i].ra_bytes;
+  }
+
+  return n;
+}
+
+/* -------------------------------------------------------------------------- */
+uint64_t
+/* -------------------------------------------------------------------------- */
+readaheadstreams::waste_bytes() const
+/* -------------------------------------------------------------------------- */
+{
+  uint64_t n = mWasteBytes;
+
+  for (size_t i = 0; i < max_streams; ++i) {
+    n += mStreams[i].waste_bytes;
+  }
+
+  return n;
+}
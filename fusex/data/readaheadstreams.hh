@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+//! @file readaheadstreams.hh
+//! @brief per file handle detection of interleaved read streams driving the
+//!        adaptive read-ahead of the XrdCl proxy
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_READAHEADSTREAMS_HH_
+#define FUSE_READAHEADSTREAMS_HH_
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/* Tracks up to max_streams independent read streams of a single file handle. */
+/* A stream is either contiguous (each read starts where the previous ended)  */
+/* or strided (reads of the same size at a constant distance). Each stream    */
+/* has its own prefetch window and block count, which are adapted from the    */
+/* hit ratio, the wasted prefetch volume and the time readers had to wait     */
+/* for in-flight prefetches. The class is not thread-safe, the owner has to   */
+/* serialize the calls.                                                       */
+/* -------------------------------------------------------------------------- */
+
+class readaheadstreams
+{
+public:
+  static constexpr size_t max_streams = 8;
+  // number of reads after which a stream adapts its window
+  static constexpr size_t adapt_interval = 8;
+  // wait latency above which more blocks are kept in flight
+  static constexpr double adapt_latency_ms = 1.0;
+  // largest block fetched as part of a vector read
+  static constexpr size_t max_vector_chunk = 1024 * 1024;
+
+  typedef struct chunk {
+    off_t offset;
+    size_t size;
+  } chunk_t;
+
+  typedef struct stream {
+    off_t next; // expected offset of the next read
+    off_t last_offset; // offset of the last read
+    off_t stride; // distance between reads of a strided stream, 0 if contiguous
+    size_t size; // size of the last read
+    off_t ra_position; // next offset to prefetch
+    size_t window; // current prefetch block size
+    size_t blocks; // current number of prefetch blocks
+    size_t seq; // number of reads following the stream pattern
+    uint64_t stamp; // last use, for LRU recycling
+    bool active;
+
+    uint64_t hit_bytes; // bytes served from prefetched blocks
+    uint64_t miss_bytes; // bytes read synchronously
+    uint64_t ra_bytes; // bytes prefetched
+    uint64_t waste_bytes; // prefetched bytes dropped without being read
+
+    // sampling period for the adaptation
+    size_t sample_reads;
+    uint64_t sample_hit;
+    uint64_t sample_miss;
+    uint64_t sample_ra;
+    uint64_t sample_waste;
+    double sample_wait_ms;
+  } stream_t;
+
+  readaheadstreams();
+  virtual ~readaheadstreams() { }
+
+  void configure(size_t min, size_t nom, size_t max, size_t blocks_max,
+                 off_t max_position);
+
+  void set_max_position(off_t max_position)
+  {
+    mMaxPosition = max_position;
+  }
+
+  // assign a read to a stream, returns the stream index and the index of a
+  // recycled stream in evicted (-1 if none)
+  int access(off_t offset, size_t size, int& evicted);
+
+  // accounting
+  void hit(int s, size_t bytes, double wait_ms);
+  void miss(int s, size_t bytes);
+  void waste(int s, size_t bytes);
+
+  // compute the blocks to prefetch for stream s, vector is set if they should
+  // be fetched with a single vector read
+  bool plan(int s, std::vector<chunk_t>& chunks, bool& vector);
+
+  // confirm that the first n planned blocks were submitted
+  void prefetched(int s, const std::vector<chunk_t>& chunks, size_t n);
+
+  const stream_t& get(int s) const
+  {
+    return mStreams[s];
+  }
+
+  size_t active() const;
+
+  uint64_t hit_bytes() const;
+  uint64_t ra_bytes() const;
+  uint64_t waste_bytes() const;
+
+private:
+  void adapt(stream_t& st);
+  void reset(stream_t& st, off_t offset, size_t size);
+
+  stream_t mStreams[max_streams];
+  uint64_t mClock;
+  size_t mMin;
+  size_t mNom;
+  size_t mMax;
+  size_t mBlocksMax;
+  off_t mMaxPosition;
+
+  // totals of recycled streams
+  uint64_t mHitBytes;
+  uint64_t mRaBytes;
+  uint64_t mWasteBytes;
+};
+
+#endif /* FUSE_READAHEADSTREAMS_HH_ */
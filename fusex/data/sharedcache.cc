@@ -0,0 +1,404 @@
+//------------------------------------------------------------------------------
+//! @file sharedcache.cc
+//! @brief host-wide content-addressed data block cache shared between mounts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "data/sharedcache.hh"
+#include "common/Logging.hh"
+#include "common/Path.hh"
+#include <openssl/evp.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#undef __USE_FILE_OFFSET64
+#include <fts.h>
+#define __USE_FILE_OFFSET64
+
+/* -------------------------------------------------------------------------- */
+sharedcache::sharedcache() : mBlockSize(1024 * 1024), mHits(0), mHitBytes(0),
+  mMisses(0), mMissBytes(0), mStored(0), mDedup(0)
+/* -------------------------------------------------------------------------- */
+{
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+sharedcache::init(const cacheconfig& config)
+/* -------------------------------------------------------------------------- */
+{
+  if (!config.shared_location.length()) {
+    return 0;
+  }
+
+  if (::access(config.shared_location.c_str(), W_OK)) {
+    return errno;
+  }
+
+  mLocation = config.shared_location;
+
+  if (mLocation.rfind("/") != (mLocation.size() - 1)) {
+    mLocation += "/";
+  }
+
+  if (config.shared_block_size) {
+    mBlockSize = config.shared_block_size;
+  }
+
+  std::string dirs[2] = {mLocation + "data", mLocation + "index"};
+
+  for (size_t i = 0; i < 2; ++i) {
+    if (::mkdir(dirs[i].c_str(), S_IRWXU) && (errno != EEXIST)) {
+      return errno;
+    }
+  }
+
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+sharedcache::init_daemonized(const cacheconfig& config)
+/* -------------------------------------------------------------------------- */
+{
+  if (!enabled()) {
+    return 0;
+  }
+
+  // the dircleaner evicts the blocks with the oldest mtime when the budget is
+  // exceeded, a cache hit refreshes the mtime of a block
+  mDirCleaner = std::make_shared<dircleaner>(mLocation + "data",
+                "sc",
+                config.shared_cache_size,
+                0,
+                config.clean_threshold);
+  mDirCleaner->set_trim_suffix(".sc");
+  tSweeper.reset(&sharedcache::sweeper, this);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+sharedcache::etag(const std::string& instance, uint64_t mtime,
+                  uint64_t mtime_ns, uint64_t size)
+/* -------------------------------------------------------------------------- */
+{
+  char tag[128];
+  snprintf(tag, sizeof(tag), "%lx:%lx:%lx:%lx",
+           (unsigned long) std::hash<std::string>()(instance), mtime, mtime_ns, size);
+  return tag;
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+sharedcache::index_path(uint64_t fid, const std::string& etag,
+                        uint64_t block) const
+/* -------------------------------------------------------------------------- */
+{
+  char ipath[1024 + 128];
+  snprintf(ipath, sizeof(ipath), "%sindex/%03lX/%016lx.%s.%lx",
+           mLocation.c_str(), fid % 4096, fid, etag.c_str(), block);
+  return ipath;
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+sharedcache::data_path(const std::string& hash) const
+/* -------------------------------------------------------------------------- */
+{
+  return mLocation + "data/" + hash.substr(0, 2) + "/" + hash + ".sc";
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+sharedcache::hash(const void* buf, size_t size)
+/* -------------------------------------------------------------------------- */
+{
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_len = 0;
+  EVP_Digest(buf, size, digest, &digest_len, EVP_sha256(), 0);
+  std::string hex;
+  char x[3];
+
+  for (unsigned int i = 0; i < digest_len; ++i) {
+    snprintf(x, sizeof(x), "%02x", digest[i]);
+    hex += x;
+  }
+
+  return hex;
+}
+
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+sharedcache::read(uint64_t fid, const std::string& etag, uint64_t block,
+                  void* buf, size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  std::string ipath = index_path(fid, etag, block);
+  int fd = ::open(ipath.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    struct stat lbuf;
+
+    if ((errno == ENOENT) && !::lstat(ipath.c_str(), &lbuf)) {
+      // the block was evicted, drop the dangling index entry
+      (void) ::unlink(ipath.c_str());
+    }
+
+    return -1;
+  }
+
+  struct stat sbuf;
+
+  if (::fstat(fd, &sbuf) || ((off_t)(offset + count) > sbuf.st_size)) {
+    (void) ::close(fd);
+    return -1;
+  }
+
+  void* map = ::mmap(0, sbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  if (map == MAP_FAILED) {
+    (void) ::close(fd);
+    return -1;
+  }
+
+  memcpy(buf, (char*) map + offset, count);
+  (void) ::munmap(map, sbuf.st_size);
+
+  // refresh the LRU position of the block, at most once per minute
+  if ((time(NULL) - sbuf.st_mtime) > 60) {
+    (void) ::futimens(fd, 0);
+  }
+
+  (void) ::close(fd);
+  mHits++;
+  mHitBytes += count;
+  return count;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+sharedcache::put(uint64_t fid, const std::string& etag, uint64_t block,
+                 const void* buf, size_t size)
+/* -------------------------------------------------------------------------- */
+{
+  std::string h = hash(buf, size);
+  std::string dpath = data_path(h);
+  struct stat sbuf;
+
+  if (!::stat(dpath.c_str(), &sbuf) && ((size_t) sbuf.st_size == size)) {
+    // identical content is already stored for another file or version
+    mDedup++;
+    (void) ::utimensat(AT_FDCWD, dpath.c_str(), 0, 0);
+  } else {
+    eos::common::Path cPath(dpath.c_str());
+
+    if (!cPath.MakeParentPath(S_IRWXU)) {
+      return -errno;
+    }
+
+    // write to a hidden file which is invisible to the dircleaner and rename
+    // it in place, readers of other processes never see partial blocks
+    char tmp[1024 + 128];
+    snprintf(tmp, sizeof(tmp), "%sdata/.%s.%d.%lx", mLocation.c_str(),
+             h.c_str(), getpid(), (unsigned long) pthread_self());
+    int fd = ::open(tmp, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC,
+                    S_IRUSR | S_IWUSR);
+
+    if (fd < 0) {
+      return -errno;
+    }
+
+    size_t written = 0;
+
+    while (written < size) {
+      ssize_t nw = ::write(fd, (const char*) buf + written, size - written);
+
+      if (nw <= 0) {
+        int rc = errno;
+        (void) ::close(fd);
+        (void) ::unlink(tmp);
+        return -rc;
+      }
+
+      written += nw;
+    }
+
+    if (::close(fd) || ::rename(tmp, dpath.c_str())) {
+      int rc = errno;
+      (void) ::unlink(tmp);
+      return -rc;
+    }
+
+    mStored++;
+
+    if (mDirCleaner) {
+      mDirCleaner->get_external_tree().change(size, 1);
+    }
+  }
+
+  return link_index(index_path(fid, etag, block), h);
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+sharedcache::link_index(const std::string& ipath, const std::string& hash)
+/* -------------------------------------------------------------------------- */
+{
+  eos::common::Path cPath(ipath.c_str());
+
+  if (!cPath.MakeParentPath(S_IRWXU)) {
+    return -errno;
+  }
+
+  // relative target, the cache location can be moved or bind-mounted
+  std::string target = "../../data/" + hash.substr(0, 2) + "/" + hash + ".sc";
+  char tmp[1024 + 128];
+  snprintf(tmp, sizeof(tmp), "%s.%d.%lx.tmp", ipath.c_str(), getpid(),
+           (unsigned long) pthread_self());
+  (void) ::unlink(tmp);
+
+  if (::symlink(target.c_str(), tmp) || ::rename(tmp, ipath.c_str())) {
+    int rc = errno;
+    (void) ::unlink(tmp);
+    return -rc;
+  }
+
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+sharedcache::stats_t
+/* -------------------------------------------------------------------------- */
+sharedcache::get_stats() const
+/* -------------------------------------------------------------------------- */
+{
+  stats_t s;
+  s.hits = mHits.load();
+  s.hit_bytes = mHitBytes.load();
+  s.misses = mMisses.load();
+  s.miss_bytes = mMissBytes.load();
+  s.stored = mStored.load();
+  s.dedup = mDedup.load();
+  return s;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+sharedcache::sweep()
+/* -------------------------------------------------------------------------- */
+{
+  std::string index = mLocation + "index";
+  char* paths[2];
+  paths[0] = (char*) index.c_str();
+  paths[1] = 0;
+  FTS* tree = fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, 0);
+
+  if (!tree) {
+    eos_static_err("[ sc ] fts_open: path=%s errno=%d", index.c_str(), errno);
+    return;
+  }
+
+  FTSENT* node;
+  size_t removed = 0;
+  time_t now = time(NULL);
+
+  while ((node = fts_read(tree))) {
+    if (node->fts_info != FTS_SL) {
+      continue;
+    }
+
+    struct stat sbuf;
+    std::string linkpath = node->fts_accpath;
+    bool stale_tmp = ((linkpath.size() > 4) &&
+                      !linkpath.compare(linkpath.size() - 4, 4, ".tmp") &&
+                      !::lstat(linkpath.c_str(), &sbuf) &&
+                      ((now - sbuf.st_mtime) > 3600));
+
+    if (stale_tmp || (::stat(linkpath.c_str(), &sbuf) && (errno == ENOENT))) {
+      if (!::unlink(linkpath.c_str())) {
+        removed++;
+      }
+    }
+  }
+
+  if (fts_close(tree)) {
+    eos_static_err("[ sc ] fts_close: errno=%d", errno);
+  }
+
+  // blocks left behind by a crashed writer
+  std::string data = mLocation + "data/";
+  DIR* dir = opendir(data.c_str());
+
+  if (dir) {
+    struct dirent* entry;
+
+    while ((entry = readdir(dir))) {
+      if ((entry->d_name[0] != '.') || !strcmp(entry->d_name, ".") ||
+          !strcmp(entry->d_name, "..")) {
+        continue;
+      }
+
+      std::string tmp = data + entry->d_name;
+      struct stat sbuf;
+
+      if (!::stat(tmp.c_str(), &sbuf) && S_ISREG(sbuf.st_mode) &&
+          ((now - sbuf.st_mtime) > 3600)) {
+        (void) ::unlink(tmp.c_str());
+      }
+    }
+
+    closedir(dir);
+  }
+
+  eos_static_info("[ sc ] swept index removed-links=%lu", removed);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+sharedcache::sweeper(ThreadAssistant& assistant)
+/* -------------------------------------------------------------------------- */
+{
+  ThreadAssistant::setSelfThreadName("sc-sweeper");
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::minutes(60));
+
+    if (assistant.terminationRequested()) {
+      return;
+    }
+
+    sweep();
+  }
+}
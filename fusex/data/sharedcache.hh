@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+//! @file sharedcache.hh
+//! @brief host-wide content-addressed data block cache shared between mounts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_SHAREDCACHE_HH_
+#define FUSE_SHAREDCACHE_HH_
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "data/dircleaner.hh"
+#include "data/cacheconfig.hh"
+#include "common/AssistedThread.hh"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+/* The shared cache stores file blocks by the SHA-256 of their content under  */
+/* <location>/data/ and maps (fid, etag, block) to them with symbolic links   */
+/* under <location>/index/. Identical blocks of different files or versions   */
+/* are stored once. All eosxd processes of the host configured with the same  */
+/* location share the cache and it survives remounts. Blocks are read via     */
+/* mmap, a hit refreshes the block mtime and the least recently used blocks   */
+/* are evicted by the dircleaner when the byte budget is exceeded. Index      */
+/* links to evicted blocks are removed when they are found dangling.          */
+/* -------------------------------------------------------------------------- */
+
+class sharedcache
+{
+public:
+
+  typedef struct stats {
+    uint64_t hits; // blocks served from the cache
+    uint64_t hit_bytes; // bytes served from the cache, saved WAN traffic
+    uint64_t misses; // blocks fetched remotely
+    uint64_t miss_bytes; // bytes fetched remotely
+    uint64_t stored; // blocks added to the cache
+    uint64_t dedup; // blocks added which were already stored for other keys
+  } stats_t;
+
+  sharedcache();
+  virtual ~sharedcache() { }
+
+  static sharedcache&
+  instance()
+  {
+    static sharedcache i;
+    return i;
+  }
+
+  int init(const cacheconfig& config); // called before becoming a daemon
+  int init_daemonized(const cacheconfig& config); // called after becoming a daemon
+
+  bool enabled() const
+  {
+    return mLocation.length();
+  }
+
+  size_t blocksize() const
+  {
+    return mBlockSize;
+  }
+
+  // version identifier of a file's contents, qualified with the instance
+  // because inode numbers of different instances overlap
+  static std::string etag(const std::string& instance, uint64_t mtime,
+                          uint64_t mtime_ns, uint64_t size);
+
+  // read count bytes at offset inside a cached block, returns -1 on a miss
+  ssize_t read(uint64_t fid, const std::string& etag, uint64_t block,
+               void* buf, size_t count, off_t offset);
+
+  // store a complete block
+  int put(uint64_t fid, const std::string& etag, uint64_t block,
+          const void* buf, size_t size);
+
+  void account_miss(size_t bytes)
+  {
+    mMisses++;
+    mMissBytes += bytes;
+  }
+
+  stats_t get_stats() const;
+
+  // remove index links of evicted blocks
+  void sweep();
+
+private:
+  std::string index_path(uint64_t fid, const std::string& etag,
+                         uint64_t block) const;
+  std::string data_path(const std::string& hash) const;
+  static std::string hash(const void* buf, size_t size);
+  int link_index(const std::string& ipath, const std::string& hash);
+  void sweeper(ThreadAssistant& assistant);
+
+  std::string mLocation;
+  size_t mBlockSize;
+  std::shared_ptr<dircleaner> mDirCleaner;
+  AssistedThread tSweeper;
+
+  std::atomic<uint64_t> mHits;
+  std::atomic<uint64_t> mHitBytes;
+  std::atomic<uint64_t> mMisses;
+  std::atomic<uint64_t> mMissBytes;
+  std::atomic<uint64_t> mStored;
+  std::atomic<uint64_t> mDedup;
+};
+
+#endif /* FUSE_SHAREDCACHE_HH_ */
@@ -26,6 +26,7 @@
 #include "common/Logging.hh"
 #include "common/Path.hh"
 #include "XrdCl/XrdClXRootDResponses.hh"
+#include <chrono>
 
 using namespace XrdCl;
 
@@ -97,6 +98,10 @@ XrdCl::Proxy::Read(XrdCl::shared_proxy proxy,
     return status;
   }
 
+  if (XReadAheadStrategy == ADAPTIVE) {
+    return ReadAdaptive(proxy, offset, size, buffer, bytesRead, timeout);
+  }
+
   eos_debug("----: read: offset=%lu size=%u", offset, size);
   int readahead_window_hit = 0;
   uint64_t current_offset = offset;
@@ -429,6 +434,236 @@ XrdCl::Proxy::Read(XrdCl::shared_proxy proxy,
   return status;
 }
 
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+XrdCl::Proxy::ReadAdaptive(XrdCl::shared_proxy proxy,
+                           uint64_t offset,
+                           uint32_t size,
+                           void* buffer,
+                           uint32_t& bytesRead,
+                           uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  eos_debug("----: adaptive read: offset=%lu size=%u", offset, size);
+  XRootDStatus status;
+  uint64_t current_offset = offset;
+  uint32_t current_size = size;
+  std::vector<readaheadstreams::chunk_t> plan;
+  std::vector<readaheadstreams::chunk_t> todo;
+  bool vector = false;
+  int evicted = -1;
+  bytesRead = 0;
+  ReadCondVar().Lock();
+  int stream = mReadAheadStreams.access(offset, size, evicted);
+
+  // serve from the prefetched chunks of any stream
+  while (current_size && ChunkRMap().size()) {
+    auto it = ChunkRMap().upper_bound(current_offset);
+
+    if (it == ChunkRMap().begin()) {
+      break;
+    }
+
+    --it;
+    read_handler chunk = it->second;
+    XrdSysCondVarHelper lLock(chunk->ReadCondVar());
+    off_t match_offset;
+    uint32_t match_size;
+
+    if (!chunk->matches(current_offset, current_size, match_offset, match_size)) {
+      break;
+    }
+
+    auto wait_start = std::chrono::steady_clock::now();
+    size_t cnt = 0;
+
+    while (!chunk->done()) {
+      chunk->ReadCondVar().WaitMS(25);
+      cnt++;
+
+      if (!(cnt % 2400) && chunk->expired()) {
+        // every 60 seconds ...
+        eos_crit("read-ahead request expired after %u cycles - now: %lu ctime: %lu",
+                 cnt, time(NULL), chunk->creationtime());
+        break;
+      }
+    }
+
+    double wait_ms = std::chrono::duration<double, std::milli>
+                     (std::chrono::steady_clock::now() - wait_start).count();
+
+    if (!chunk->done()) {
+      {
+        // put on a garbage stack
+        std::lock_guard<std::mutex> lock(
+          XrdCl::Proxy::ReadAsyncHandler::gExpiredChunksMutex);
+        XrdCl::Proxy::ReadAsyncHandler::gExpiredChunks.push_back(chunk);
+      }
+      ChunkRMap().erase(it);
+      break;
+    }
+
+    if (!chunk->Status().IsOK()) {
+      // the missing piece is read synchronously
+      ChunkRMap().erase(it);
+      break;
+    }
+
+    // the match result can change after the read actually returned
+    if (!chunk->matches(current_offset, current_size, match_offset, match_size)) {
+      break;
+    }
+
+    memcpy(buffer, chunk->buffer() + match_offset - chunk->offset(), match_size);
+    chunk->consume(match_size);
+    bytesRead += match_size;
+    buffer = (char*) buffer + match_size;
+    current_offset = match_offset + match_size;
+    current_size -= match_size;
+    mTotalReadAheadHitBytes += match_size;
+    mReadAheadStreams.hit(stream, match_size, wait_ms);
+
+    if (current_offset >= (uint64_t)(chunk->offset() + chunk->size())) {
+      // fully read
+      ChunkRMap().erase(it);
+    }
+  }
+
+  // drop finished chunks which fell behind their stream or belong to a
+  // recycled stream and account what was never read as waste
+  for (auto it = ChunkRMap().begin(); it != ChunkRMap().end();) {
+    read_handler chunk = it->second;
+    XrdSysCondVarHelper lLock(chunk->ReadCondVar());
+    int s = chunk->stream();
+    bool stale = (s < 0) || (s == evicted) || !chunk->valid() ||
+                 ((off_t)(chunk->offset() + chunk->size()) <=
+                  mReadAheadStreams.get(s).last_offset);
+
+    if (!stale) {
+      ++it;
+      continue;
+    }
+
+    if (!chunk->done()) {
+      // the stream is gone, the chunk is dropped once it arrived
+      chunk->set_stream(-1);
+      ++it;
+      continue;
+    }
+
+    if (chunk->valid() && (chunk->size() > chunk->consumed())) {
+      mReadAheadStreams.waste(s == evicted ? -1 : s,
+                              chunk->size() - chunk->consumed());
+    }
+
+    it = ChunkRMap().erase(it);
+  }
+
+  if (current_size) {
+    mReadAheadStreams.miss(stream, current_size);
+  }
+
+  if (mReadAheadStreams.plan(stream, plan, vector)) {
+    // skip blocks which are already prefetched by another stream
+    for (auto it = plan.begin(); it != plan.end(); ++it) {
+      if (!ChunkRMap().count(it->offset)) {
+        todo.push_back(*it);
+      }
+    }
+
+    ReadCondVar().UnLock();
+    chunk_rvector chunks;
+
+    for (auto it = todo.begin(); it != todo.end(); ++it) {
+      XrdCl::Proxy::read_handler rahread = ReadAsyncPrepare(proxy, it->offset,
+                                           it->size, false);
+
+      if (!rahread->valid()) {
+        // no buffer available
+        break;
+      }
+
+      rahread->set_stream(stream);
+      chunks.push_back(rahread);
+    }
+
+    size_t submitted = 0;
+
+    if (vector && (chunks.size() > 1)) {
+      if (EOS_LOGS_DEBUG) {
+        eos_debug("----: pre-fetch vector offset=%lu chunks=%lu size=%lu",
+                  chunks.front()->offset(), chunks.size(), chunks.front()->size());
+      }
+
+      if (PreReadVectorAsync(chunks, timeout).IsOK()) {
+        submitted = chunks.size();
+      }
+    } else {
+      for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        if (EOS_LOGS_DEBUG) {
+          eos_debug("----: pre-fetch window=%lu pf-offset=%lu", (*it)->size(),
+                    (*it)->offset());
+        }
+
+        if (!PreReadAsync((*it)->offset(), (*it)->size(), *it, timeout).IsOK()) {
+          break;
+        }
+
+        submitted++;
+      }
+    }
+
+    ReadCondVar().Lock();
+
+    if (submitted) {
+      // advance the stream up to the last submitted block
+      off_t last = chunks[submitted - 1]->offset();
+      size_t n = 0;
+
+      while ((n < plan.size()) && (plan[n].offset <= last)) {
+        n++;
+      }
+
+      mReadAheadStreams.prefetched(stream, plan, n);
+
+      for (size_t i = 0; i < submitted; ++i) {
+        mTotalReadAheadBytes += chunks[i]->size();
+      }
+    }
+  }
+
+  ReadCondVar().UnLock();
+
+  if (current_size) {
+    // do a synchronous read for missing pieces
+    uint32_t rbytes_read = 0;
+    status = File::Read(current_offset,
+                        current_size,
+                        buffer, rbytes_read, timeout);
+
+    if (status.IsOK()) {
+      if (rbytes_read) {
+        if (EOS_LOGS_DEBUG) {
+          eos_debug("----: postfetched offset=%lu size=%u rbytes=%d", current_offset,
+                    current_size, rbytes_read);
+        }
+      }
+
+      bytesRead += rbytes_read;
+    }
+  }
+
+  set_readstate(&status);
+
+  if (status.IsOK()) {
+    XrdSysCondVarHelper lLock(ReadCondVar());
+    mPosition = offset + size;
+    mTotalBytes += bytesRead;
+  }
+
+  return status;
+}
+
 /* -------------------------------------------------------------------------- */
 XRootDStatus
 /* -------------------------------------------------------------------------- */
@@ -1229,6 +1464,43 @@ XrdCl::Proxy::ReadAsyncHandler::HandleResponse(XrdCl::XRootDStatus* status,
   }
 }
 
+void
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::VectorReadAsyncHandler::HandleResponse(XrdCl::XRootDStatus*
+    status,
+    XrdCl::AnyObject* response)
+/* -------------------------------------------------------------------------- */
+{
+  eos_static_debug("");
+  XrdCl::VectorReadInfo* info = 0;
+
+  if (status->IsOK() && response) {
+    response->Get(info);
+  }
+
+  // hand each chunk its own status and response, the chunk handlers delete
+  // them
+  for (size_t i = 0; i < mChunks.size(); ++i) {
+    XrdCl::XRootDStatus* chunk_status = new XrdCl::XRootDStatus(*status);
+    XrdCl::AnyObject* chunk_response = 0;
+
+    if (info && (i < info->GetChunks().size())) {
+      chunk_response = new XrdCl::AnyObject();
+      chunk_response->Set(new XrdCl::ChunkInfo(info->GetChunks()[i]));
+    }
+
+    mChunks[i]->HandleResponse(chunk_status, chunk_response);
+  }
+
+  delete status;
+
+  if (response) {
+    delete response;
+  }
+
+  delete this;
+}
+
 /* -------------------------------------------------------------------------- */
 XrdCl::Proxy::read_handler
 /* -------------------------------------------------------------------------- */
@@ -1295,6 +1567,35 @@ XrdCl::Proxy::PreReadAsync(uint64_t offset,
   return rstatus;
 }
 
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::PreReadVectorAsync(const chunk_rvector& chunks,
+                                 uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  eos_debug("");
+  VectorReadAsyncHandler* handler = new VectorReadAsyncHandler(chunks);
+  XRootDStatus status = WaitOpen();
+
+  if (status.IsOK()) {
+    status = File::VectorRead(handler->chunklist(), 0, handler, timeout);
+  }
+
+  if (!status.IsOK()) {
+    delete handler;
+    // remove the allocated chunk buffers
+    XrdSysCondVarHelper lLock(ReadCondVar());
+
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+      ChunkRMap().erase((*it)->offset());
+      dec_read_chunks_in_flight();
+    }
+  }
+
+  return status;
+}
+
 /* -------------------------------------------------------------------------- */
 XRootDStatus
 /* -------------------------------------------------------------------------- */
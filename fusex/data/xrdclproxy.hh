@@ -33,6 +33,7 @@
 #include "common/Logging.hh"
 #include "common/Timing.hh"
 #include "common/RWMutex.hh"
+#include "readaheadstreams.hh"
 #include <memory>
 #include <map>
 #include <string>
@@ -360,6 +361,15 @@ public:
                     uint32_t& bytesRead,
                     uint16_t timeout = 0);
 
+  // ---------------------------------------------------------------------- //
+  // read using the per-stream adaptive read-ahead
+  XRootDStatus ReadAdaptive(XrdCl::shared_proxy proxy,
+                            uint64_t offset,
+                            uint32_t size,
+                            void* buffer,
+                            uint32_t& bytesRead,
+                            uint16_t timeout = 0);
+
   // ---------------------------------------------------------------------- //
   XRootDStatus Sync(uint16_t timeout = 0);
 
@@ -560,12 +570,14 @@ public:
   enum READAHEAD_STRATEGY {
     NONE = 0,
     STATIC = 1,
-    DYNAMIC = 2
+    DYNAMIC = 2,
+    ADAPTIVE = 3
   };
 
   void set_readahead_maximum_position(off_t offset)
   {
     mReadAheadMaximumPosition = offset;
+    mReadAheadStreams.set_max_position(offset);
   }
 
   off_t get_readahead_maximum_position() const
@@ -594,6 +606,10 @@ public:
       return STATIC;
     }
 
+    if (strategy == "adaptive") {
+      return ADAPTIVE;
+    }
+
     return NONE;
   }
 
@@ -609,6 +625,13 @@ public:
     XReadAheadBlocksMin = 1;
     XReadAheadReenableHits = 0;
     XReadAheadSparseRatio = sparse_ratio;
+    mReadAheadStreams.configure(min, nom, max, rablocks,
+                                mReadAheadMaximumPosition);
+  }
+
+  READAHEAD_STRATEGY get_readahead_strategy() const
+  {
+    return XReadAheadStrategy;
   }
 
   float get_readahead_efficiency()
@@ -625,6 +648,24 @@ public:
            : 0.0;
   }
 
+  size_t get_readahead_streams()
+  {
+    XrdSysCondVarHelper lLock(ReadCondVar());
+    return mReadAheadStreams.active();
+  }
+
+  uint64_t get_readahead_waste_bytes()
+  {
+    XrdSysCondVarHelper lLock(ReadCondVar());
+    return mReadAheadStreams.waste_bytes();
+  }
+
+  off_t get_read_bytes()
+  {
+    XrdSysCondVarHelper lLock(ReadCondVar());
+    return mTotalBytes;
+  }
+
   void set_id(uint64_t ino, fuse_req_t req)
   {
     mIno = ino;
@@ -950,7 +991,7 @@ public:
   {
   public:
 
-    ReadAsyncHandler() : mAsyncCond(0) { }
+    ReadAsyncHandler() : mAsyncCond(0), mStream(-1), mConsumed(0) { }
 
     ReadAsyncHandler(ReadAsyncHandler* other) : mAsyncCond(0)
     {
@@ -964,6 +1005,8 @@ public:
       mDone = false;
       mEOF = false;
       mCreationTime = other->creationtime();
+      mStream = other->stream();
+      mConsumed = 0;
     }
 
     ReadAsyncHandler(shared_proxy file, off_t off, uint32_t size,
@@ -981,6 +1024,8 @@ public:
       mEOF = false;
       mProxy = file;
       mCreationTime = time(NULL);
+      mStream = -1;
+      mConsumed = 0;
 
       if (valid()) {
         eos_static_debug("----: creating chunk offset=%ld size=%u addr=%lx", off, size,
@@ -1111,6 +1156,28 @@ public:
       mProxy = 0;
     }
 
+    // read-ahead stream which requested this chunk, -1 if none
+    int stream()
+    {
+      return mStream;
+    }
+
+    void set_stream(int s)
+    {
+      mStream = s;
+    }
+
+    // bytes of the chunk handed out to readers
+    size_t consumed()
+    {
+      return mConsumed;
+    }
+
+    void consume(size_t bytes)
+    {
+      mConsumed += bytes;
+    }
+
     virtual void HandleResponse(XrdCl::XRootDStatus* pStatus,
 
                                 XrdCl::AnyObject* pResponse);
@@ -1134,6 +1201,8 @@ public:
     XRootDStatus mStatus;
     XrdSysCondVar mAsyncCond;
     time_t mCreationTime;
+    int mStream;
+    size_t mConsumed;
   };
 
 
@@ -1147,6 +1216,41 @@ public:
   typedef std::vector<write_handler> chunk_vector;
   typedef std::vector<read_handler> chunk_rvector;
 
+  // ---------------------------------------------------------------------- //
+
+  class VectorReadAsyncHandler : public XrdCl::ResponseHandler
+  // ---------------------------------------------------------------------- //
+  {
+  public:
+    // dispatches the response of a vector read to the read-ahead chunks
+    // it was built from, deletes itself after the response
+    VectorReadAsyncHandler(const chunk_rvector& chunks) : mChunks(chunks) { }
+
+    virtual ~VectorReadAsyncHandler() { }
+
+    XrdCl::ChunkList chunklist()
+    {
+      XrdCl::ChunkList list;
+
+      for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        list.push_back(XrdCl::ChunkInfo((*it)->offset(), (*it)->size(),
+                                        (*it)->buffer()));
+      }
+
+      return list;
+    }
+
+    virtual void HandleResponse(XrdCl::XRootDStatus* pStatus,
+                                XrdCl::AnyObject* pResponse);
+
+  private:
+    chunk_rvector mChunks;
+  };
+
+  // ---------------------------------------------------------------------- //
+  XRootDStatus PreReadVectorAsync(const chunk_rvector& chunks,
+                                  uint16_t timeout);
+
   // ---------------------------------------------------------------------- //
   write_handler WriteAsyncPrepare(XrdCl::shared_proxy proxy, uint32_t size,
                                   uint64_t offset = 0,
@@ -1511,6 +1615,7 @@ private:
   off_t mTotalReadAheadBytes;
   off_t mReadAheadMaximumPosition;
   off_t mSeqDistance;
+  readaheadstreams mReadAheadStreams; // stream detection of the adaptive strategy
   XrdSysMutex mAttachedMutex;
   size_t mAttached;
   fuse_req_t mReq;
@@ -86,6 +86,8 @@ extern "C" { /* this 'extern "C"' brace will eventually end up in the .h file, t
 #include "kv/kv.hh"
 #include "data/cache.hh"
 #include "data/cachehandler.hh"
+#include "data/journalcache.hh"
+#include "data/sharedcache.hh"
 #include "misc/ConcurrentMount.hh"
 
 #define _FILE_OFFSET_BITS 64
@@ -922,6 +924,26 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       root["options"]["inmemory-inodes"] = 16384;
     }
 
+    if (!root["options"].isMember("md-flush-threads")) {
+      root["options"]["md-flush-threads"] = 4;
+    }
+
+    if (!root["options"].isMember("md-flush-batch")) {
+      root["options"]["md-flush-batch"] = 32;
+    }
+
+    if (!root["options"].isMember("md-warm-cache")) {
+      root["options"]["md-warm-cache"] = 0;
+    }
+
+    if (!root["options"].isMember("data-splice")) {
+      root["options"]["data-splice"] = 1;
+    }
+
+    if (!root["options"].isMember("data-passthrough")) {
+      root["options"]["data-passthrough"] = 0;
+    }
+
     // xrdcl default options
     XrdCl::DefaultEnv::GetEnv()->PutInt("TimeoutResolution", 1);
     XrdCl::DefaultEnv::GetEnv()->PutInt("ConnectionWindow", 10);
@@ -1082,6 +1104,20 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     config.options.write_size_flush_interval =
       root["options"]["write-size-flush-interval"].asInt();
     config.options.inmemory_inodes = root["options"]["inmemory-inodes"].asInt();
+    config.options.md_flush_threads = root["options"]["md-flush-threads"].asInt();
+    config.options.md_flush_batch = root["options"]["md-flush-batch"].asInt();
+    config.options.md_warm_cache = root["options"]["md-warm-cache"].asInt();
+    config.options.data_splice = root["options"]["data-splice"].asInt();
+    config.options.data_passthrough = root["options"]["data-passthrough"].asInt();
+#ifndef FUSE_CAP_PASSTHROUGH
+
+    if (config.options.data_passthrough) {
+      std::cerr << "Options data-passthrough requires libfuse >= 3.16, disabling it."
+                << std::endl;
+      config.options.data_passthrough = 0;
+    }
+
+#endif
     config.options.flock = false;
 #ifdef FUSE_SUPPORTS_FLOCK
     config.options.flock = true;
@@ -1202,6 +1238,16 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       config.mdcachedir += config.name.length() ? config.name : "default";
     }
 
+    if (config.options.md_warm_cache < 0) {
+      config.options.md_warm_cache = 0;
+    }
+
+    if (config.options.md_warm_cache && config.mdcachedir.empty()) {
+      std::cerr << "Options md-warm-cache requires an mdcachedir, disabling it."
+                << std::endl;
+      config.options.md_warm_cache = 0;
+    }
+
     // the store directory is the tree before we append individual UUIDs for each mount
     store_directory = config.mdcachedir;
 
@@ -1344,9 +1390,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
 
     if ((cconfig.read_ahead_strategy != "none") &&
         (cconfig.read_ahead_strategy != "static") &&
-        (cconfig.read_ahead_strategy != "dynamic")) {
+        (cconfig.read_ahead_strategy != "dynamic") &&
+        (cconfig.read_ahead_strategy != "adaptive")) {
       fprintf(stderr,
-              "error: invalid read-ahead-strategy specified - only 'none' 'static' 'dynamic' allowed\n");
+              "error: invalid read-ahead-strategy specified - only 'none' 'static' 'dynamic' 'adaptive' allowed\n");
       exit(EINVAL);
     }
 
@@ -1454,6 +1501,35 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       cconfig.journal = "";
     }
 
+    if (!root["cache"].isMember("journal-writeback-kb")) {
+      root["cache"]["journal-writeback-kb"] = 1024;
+    }
+
+    if (!root["cache"].isMember("shared-size-mb")) {
+      root["cache"]["shared-size-mb"] = 4096;
+    }
+
+    if (!root["cache"].isMember("shared-block-kb")) {
+      root["cache"]["shared-block-kb"] = 1024;
+    }
+
+    // the shared block cache is used by all mounts of the host, it is not
+    // qualified with the mount name and disabled unless a location is given
+    cconfig.shared_location = root["cache"]["shared-location"].asString();
+
+    if (cconfig.shared_location == "OFF") {
+      cconfig.shared_location = "";
+    }
+
+    cconfig.shared_cache_size = root["cache"]["shared-size-mb"].asUInt64() * 1024 *
+                                1024;
+    cconfig.shared_block_size = root["cache"]["shared-block-kb"].asUInt64() * 1024;
+
+    if (cconfig.shared_location.length() && !cconfig.shared_block_size) {
+      fprintf(stderr, "error: invalid shared cache block size 0\n");
+      exit(EINVAL);
+    }
+
     if (cconfig.location.length()) {
       if (cconfig.location.rfind("/") != (cconfig.location.size() - 1)) {
         cconfig.location += "/";
@@ -1517,6 +1593,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     std::string mk_journaldir = "mkdir -p " + cconfig.journal;
     std::string mk_locationdir = "mkdir -p " + cconfig.location;
     std::string mk_credentialdir = "mkdir -p " + config.auth.credentialStore;
+    std::string mk_shareddir = "mkdir -p " + cconfig.shared_location;
 
     // These directories might still be used by execve spawned processes that don't have binded credentials
     if (system("mkdir -m 1777 -p /var/run/eos/credentials/") ||
@@ -1549,11 +1626,16 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       system(mk_credentialdir.c_str());
     }
 
+    if (cconfig.shared_location.length()) {
+      system(mk_shareddir.c_str());
+    }
+
     // make the cache directories private to root
     chmod_to_700_or_die(config.mdcachedir);
     chmod_to_700_or_die(cconfig.journal);
     chmod_to_700_or_die(cconfig.location);
     chmod_to_700_or_die(config.auth.credentialStore);
+    chmod_to_700_or_die(cconfig.shared_location);
     {
       char list[64];
 #ifndef __APPLE__
@@ -1582,6 +1664,8 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                                         * 1024;
       cconfig.per_file_journal_max_size =
         root["cache"]["file-journal-max-kb"].asUInt64() * 1024;
+      cconfig.journal_writeback_size =
+        root["cache"]["journal-writeback-kb"].asUInt64() * 1024;
       cconfig.clean_threshold = root["cache"]["clean-threshold"].asDouble();
       cconfig.rescuecache = root["cache"]["rescue-cache-files"].asInt();
       int rc = 0;
@@ -1906,6 +1990,52 @@ EosFuse::run(int argc, char* argv[], void* userdata)
         }
 
         mKV.reset(kv);
+
+        if (config.options.md_warm_cache) {
+          // the warm md cache lives next to the per-mount stores, is kept
+          // across remounts and is only trusted if the previous mount of the
+          // same remote tree was unmounted cleanly
+          std::string warmdir = store_directory + ".warm";
+          std::string mountid = config.hostport + ":" + config.remotemountdir;
+
+          for (size_t i = 0; i < 2; ++i) {
+            RocksKV* wkv = new RocksKV();
+
+            if (wkv->connect(config.name, warmdir) != 0) {
+              delete wkv;
+              break;
+            }
+
+            std::string smount;
+            std::string sclean;
+            (void) wkv->get("warm.mount", smount);
+            (void) wkv->get("warm.clean", sclean);
+
+            if (smount.length() && ((smount != mountid) || (sclean != "1"))) {
+              delete wkv;
+              std::string rmline = "rm -rf " + warmdir;
+              (void) !system(rmline.c_str());
+              fprintf(stderr, "###### discarding warm md cache '%s' (%s)\n",
+                      warmdir.c_str(), (smount != mountid) ? "other mount" : "unclean");
+              continue;
+            }
+
+            if (wkv->put("warm.mount", mountid) || wkv->put("warm.clean", "0")) {
+              delete wkv;
+              break;
+            }
+
+            (void) !chmod(warmdir.c_str(), S_IRWXU);
+            mWarmKV.reset(wkv);
+            break;
+          }
+
+          if (!mWarmKV) {
+            fprintf(stderr, "warning: failed to open warm md cache - path=%s\n",
+                    warmdir.c_str());
+            config.options.md_warm_cache = 0;
+          }
+        }
       }
 
 #endif // HAVE_ROCKSDB
@@ -1913,6 +2043,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                      config.options.md_backend_timeout,
                      config.options.md_backend_put_timeout);
       mds.init(&mdbackend);
+
+      if (mWarmKV) {
+        mds.warm_init(mWarmKV.get(), config.options.md_warm_cache);
+      }
       caps.init(&mdbackend, &mds);
       datas.init();
       eos::common::Mapping::Init();
@@ -2007,7 +2141,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
         eos_static_warning("ztn token              := enabled");
       }
 
-      eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d flush-w-open-sz:%ld flush-w-umount:%d locking:%d no-fsync:%s flush-nowait-exec:%s ol-mode:%03o show-tree-size:%d hide-versions:%d protect-symlink-loops:%d core-affinity:%d no-xattr:%d no-eos-xattr-listing: %d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d t(lease)=%d t(size-flush)=%d submounts=%d ino(in-mem)=%d flock:%d",
+      eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d flush-w-open-sz:%ld flush-w-umount:%d locking:%d no-fsync:%s flush-nowait-exec:%s ol-mode:%03o show-tree-size:%d hide-versions:%d protect-symlink-loops:%d core-affinity:%d no-xattr:%d no-eos-xattr-listing: %d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d t(lease)=%d t(size-flush)=%d submounts=%d ino(in-mem)=%d md-flush-threads=%d md-flush-batch=%d md-warm-cache=%d data-splice=%d data-passthrough=%d flock:%d",
                          config.options.enable_backtrace,
                          config.options.md_kernelcache,
                          config.options.md_kernelcache_enoent_timeout,
@@ -2038,6 +2172,11 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                          config.options.write_size_flush_interval,
                          config.options.submounts,
                          config.options.inmemory_inodes,
+                         config.options.md_flush_threads,
+                         config.options.md_flush_batch,
+                         config.options.md_warm_cache,
+                         config.options.data_splice,
+                         config.options.data_passthrough,
                          config.options.flock
                         );
       eos_static_warning("cache                  := rh-type:%s rh-nom:%d rh-max:%d rh-blocks:%d rh-sparse-ratio:%.01f max-rh-buffer=%lu max-wr-buffer=%lu tot-size=%ld tot-ino=%ld jc-size=%ld jc-ino=%ld dc-loc:%s jc-loc:%s clean-thrs:%02f%%%",
@@ -2147,6 +2286,12 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       tMetaCallback.join();
       tMetaCommunicate.join();
       tCapFlush.join();
+
+      if (mWarmKV) {
+        // persist all resident inodes for the next mount
+        mds.warm_checkpoint();
+      }
+
       {
         // rename the stats file
         std::string laststat = config.statfilepath;
@@ -2188,6 +2333,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       cmdet.Unlock();
       alarm(0);
       mKV.reset();
+      mWarmKV.reset();
 
       if (config.mdcachedir_unlink.length()) {
         // clean rocksdb directory
@@ -2300,6 +2446,25 @@ EosFuse::init(void* userdata, struct fuse_conn_info* conn)
   Instance().Config().options.writebackcache = false;
   conn->want |= FUSE_CAP_EXPORT_SUPPORT | FUSE_CAP_POSIX_LOCKS |
                 FUSE_CAP_BIG_WRITES;
+#endif
+
+  if (Instance().Config().options.data_splice) {
+    // reads served from the file cache are moved into the kernel with splice,
+    // libfuse copies them into the reply if the kernel can not do it
+    conn->want |= (conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE));
+  }
+
+#ifdef FUSE_CAP_PASSTHROUGH
+
+  if (Instance().Config().options.data_passthrough) {
+    if (conn->capable & FUSE_CAP_PASSTHROUGH) {
+      conn->want |= FUSE_CAP_PASSTHROUGH;
+    } else {
+      eos_static_warning("kernel does not support FUSE passthrough - disabling data-passthrough");
+      Instance().Config().options.data_passthrough = 0;
+    }
+  }
+
 #endif
 }
 
@@ -2357,6 +2522,15 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
                               XrdCl::Proxy::ReadAsyncHandler::nexpired();
       inodes["proxies"]     = (Json::UInt64) XrdCl::Proxy::Proxies();
       inodes["lrureset"]    = (Json::UInt64) this->getMdStat().lru_resets();
+      inodes["dentrydelta"] = (Json::UInt64) this->getMdStat().dentry_deltas();
+      inodes["dentryfallback"] = (Json::UInt64)
+                                 this->getMdStat().dentry_fallbacks();
+      inodes["warmloaded"]  = (Json::UInt64) this->getMdStat().warm_loaded();
+      inodes["warmvalid"]   = (Json::UInt64) this->getMdStat().warm_valid();
+      inodes["warmstale"]   = (Json::UInt64) this->getMdStat().warm_stale();
+      inodes["warmstored"]  = (Json::UInt64) this->getMdStat().warm_stored();
+      inodes["rmrfbulk"]    = (Json::UInt64) this->getMdStat().rmrf_bulk();
+      inodes["rmrfdropped"] = (Json::UInt64) this->getMdStat().rmrf_dropped();
       jsonstats["inodes"] = inodes;
     }
 
@@ -2378,6 +2552,14 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
              "ALL        rh-expired          := %lu\n"
              "ALL        proxies             := %d\n"
              "ALL        lrureset            := %ld\n"
+             "ALL        dentry-delta        := %ld\n"
+             "ALL        dentry-fallback     := %ld\n"
+             "ALL        warm-loaded         := %ld\n"
+             "ALL        warm-valid          := %ld\n"
+             "ALL        warm-stale          := %ld\n"
+             "ALL        warm-stored         := %ld\n"
+             "ALL        rm-rf-bulk          := %ld\n"
+             "ALL        rm-rf-dropped       := %ld\n"
              "# -----------------------------------------------------------------------------------------------------------\n",
              this->getMdStat().inodes(),
              this->getMdStat().inodes_stacked(),
@@ -2391,7 +2573,15 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
              this->Tracker().size(),
              XrdCl::Proxy::ReadAsyncHandler::nexpired(),
              XrdCl::Proxy::Proxies(),
-             this->getMdStat().lru_resets()
+             this->getMdStat().lru_resets(),
+             this->getMdStat().dentry_deltas(),
+             this->getMdStat().dentry_fallbacks(),
+             this->getMdStat().warm_loaded(),
+             this->getMdStat().warm_valid(),
+             this->getMdStat().warm_stale(),
+             this->getMdStat().warm_stored(),
+             this->getMdStat().rmrf_bulk(),
+             this->getMdStat().rmrf_dropped()
             );
     sout += ino_stat;
     {
@@ -2426,6 +2616,71 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
       Instance().aRecoveryOk = recovery_ok;
       Instance().aRecoveryFail = recovery_fail;
     }
+    {
+      // per file read-ahead efficiency of the open files
+      std::vector<data::rastat_t> rastats;
+      this->datas.readahead_stats(rastats);
+      Json::Value readahead{};
+
+      for (auto it = rastats.begin(); it != rastats.end(); ++it) {
+        if (EosFuse::Instance().config.options.jsonstats) {
+          Json::Value rafile{};
+          rafile["path"] = it->path;
+          rafile["strategy"] = it->strategy;
+          rafile["bytes"] = (Json::Int64) it->bytes;
+          rafile["efficiency"] = it->efficiency;
+          rafile["volume-efficiency"] = it->volume_efficiency;
+          rafile["waste-bytes"] = (Json::UInt64) it->waste;
+          rafile["streams"] = (Json::UInt64) it->streams;
+          readahead[std::to_string(it->ino)] = rafile;
+          jsonstats["readahead"] = readahead;
+        }
+
+        snprintf(ino_stat, sizeof(ino_stat),
+                 "ALL        ra-file             := ino=%016lx strategy=%s bytes=%ld "
+                 "ra-efficiency=%.02f ra-vol-efficiency=%.02f ra-waste-bytes=%lu "
+                 "streams=%lu path=%s\n", (unsigned long) it->ino,
+                 it->strategy.c_str(), (long) it->bytes, it->efficiency,
+                 it->volume_efficiency, (unsigned long) it->waste,
+                 (unsigned long) it->streams, it->path.c_str());
+        sout += ino_stat;
+      }
+
+      if (rastats.size() && !EosFuse::Instance().config.options.jsonstats) {
+        sout += "# -----------------------------------------------------------------------------------------------------------\n";
+      }
+    }
+
+    if (sharedcache::instance().enabled()) {
+      // host-wide shared block cache, hits are WAN bytes saved by this mount
+      sharedcache::stats_t scstats = sharedcache::instance().get_stats();
+      uint64_t scblocks = scstats.hits + scstats.misses;
+      double hitrate = scblocks ? 100.0 * scstats.hits / scblocks : 0.0;
+
+      if (EosFuse::Instance().config.options.jsonstats) {
+        Json::Value sc{};
+        sc["hits"] = (Json::UInt64) scstats.hits;
+        sc["misses"] = (Json::UInt64) scstats.misses;
+        sc["hit-rate"] = hitrate;
+        sc["saved-bytes"] = (Json::UInt64) scstats.hit_bytes;
+        sc["fetched-bytes"] = (Json::UInt64) scstats.miss_bytes;
+        sc["stored-blocks"] = (Json::UInt64) scstats.stored;
+        sc["dedup-blocks"] = (Json::UInt64) scstats.dedup;
+        jsonstats["sharedcache"] = sc;
+      }
+
+      snprintf(ino_stat, sizeof(ino_stat),
+               "ALL        sharedcache         := hits=%lu misses=%lu hit-rate=%.02f "
+               "saved-bytes=%lu fetched-bytes=%lu stored-blocks=%lu dedup-blocks=%lu\n",
+               (unsigned long) scstats.hits, (unsigned long) scstats.misses, hitrate,
+               (unsigned long) scstats.hit_bytes, (unsigned long) scstats.miss_bytes,
+               (unsigned long) scstats.stored, (unsigned long) scstats.dedup);
+      sout += ino_stat;
+
+      if (!EosFuse::Instance().config.options.jsonstats) {
+        sout += "# -----------------------------------------------------------------------------------------------------------\n";
+      }
+    }
     std::string s1;
     std::string s2;
     std::string s3;
@@ -2491,6 +2746,14 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
               XrdCl::Proxy::sWrBufferManager.queued(), "b");
         stats["wr-nobuff"]           = (Json::LargestUInt)
                                        XrdCl::Proxy::sWrBufferManager.nobuf();
+        stats["wr-coalesced"]        = (Json::LargestUInt)
+                                       journalcache::writeback_held();
+        stats["wr-writeback"]        = (Json::LargestUInt)
+                                       journalcache::writeback_sent();
+        stats["rd-splice-bytes"]     = (Json::LargestUInt)
+                                       data::datax::splice_bytes();
+        stats["rd-passthrough"]      = (Json::LargestUInt)
+                                       data::datax::passthrough_opens();
         stats["ra-buf-inflight"]     =
           eos::common::StringConversion::GetReadableSizeString(s5,
               XrdCl::Proxy::sRaBufferManager.inflight(), "b");
@@ -2545,6 +2808,10 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
                "ALL        wr-buf-inflight     := %s\n"
                "ALL        wr-buf-queued       := %s\n"
                "ALL        wr-nobuff           := %lu\n"
+               "ALL        wr-coalesced        := %lu\n"
+               "ALL        wr-writeback        := %lu\n"
+               "ALL        rd-splice-bytes     := %lu\n"
+               "ALL        rd-passthrough      := %lu\n"
                "ALL        ra-buf-inflight     := %s\n"
                "ALL        ra-buf-queued       := %s\n"
                "ALL        ra-xoff             := %lu\n"
@@ -2583,6 +2850,10 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
                eos::common::StringConversion::GetReadableSizeString(s4,
                    XrdCl::Proxy::sWrBufferManager.queued(), "b"),
                XrdCl::Proxy::sWrBufferManager.nobuf(),
+               (unsigned long) journalcache::writeback_held(),
+               (unsigned long) journalcache::writeback_sent(),
+               (unsigned long) data::datax::splice_bytes(),
+               (unsigned long) data::datax::passthrough_opens(),
                eos::common::StringConversion::GetReadableSizeString(s5,
                    XrdCl::Proxy::sRaBufferManager.inflight(), "b"),
                eos::common::StringConversion::GetReadableSizeString(s6,
@@ -3384,8 +3655,6 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
   eos_static_debug("");
   EXEC_TIMING_BEGIN(__func__);
   ADD_FUSE_STAT(__func__, req);
-  fuse_ino_t pino = 0;
-  std::string name;
   int rc = 0;
   fuse_id id(req);
   metad::shared_md md;
@@ -3394,64 +3663,17 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
   {
     Track::Monitor mon("opendir", "fs", Instance().Tracker(), req, ino);
 
-    if (Instance().Config().options.rm_rf_protect_levels &&
-        Instance().Config().options.rm_rf_bulk &&
+    if (Instance().Config().options.rm_rf_bulk &&
         isRecursiveRm(req, true, true)) {
       md = Instance().mds.get(req, ino);
-      XrdSysMutexHelper mLock(md->Locker());
+      int brc = bulkRm(req, md);
 
-      if (md && (*md)()->attr().count("sys.recycle")) {
+      if (brc != EAGAIN) {
+        // the tree is gone upstream, rm finds the directory empty
+        eos_static_warning("Running recursive rm (pid = %d) retc=%d",
+                           fuse_req_ctx(req)->pid, brc);
         do_listdir = false;
-        eos_static_warning("Running recursive rm (pid = %d)", fuse_req_ctx(req)->pid);
-        // bulk rm only when a recycle bin is configured
-        {
-          name = (*md)()->name();
-
-          if (!(*md)()->id() || md->deleted()) {
-            rc = md->deleted() ? ENOENT : (*md)()->err();
-          } else {
-            if (!md->get_rmrf()) {
-              rc = Instance().mds.rmrf(req, md);
-            }
-          }
-
-          if (!rc) {
-            if (!md->get_rmrf()) {
-              if (EOS_LOGS_DEBUG) {
-                eos_static_warning("rm-rf marks for deletion");
-              }
-
-              md->set_rmrf();
-            }
-          } else {
-            md->unset_rmrf();
-          }
-        }
-        mLock.UnLock();
-
-        if (EOS_LOGS_DEBUG) {
-          eos_static_debug("rm-rf gave retc=%d", rc);
-        }
-
-        if (!rc) {
-          metad::shared_md pmd = Instance().mds.getlocal(req, (*md)()->pid());
-
-          if (pmd) {
-            XrdSysMutexHelper pLock(pmd->Locker());
-            pmd->local_children().erase(eos::common::StringConversion::EncodeInvalidUTF8(
-                                          name));
-            (*pmd)()->mutable_children()->erase(
-              eos::common::StringConversion::EncodeInvalidUTF8(
-                name));
-            pino = (*pmd)()->id();
-          }
-
-          rc = 0;
-
-          if (EOS_LOGS_DEBUG) {
-            eos_static_debug("rm-rf returns 0");
-          }
-        }
+        rc = brc;
       }
     }
 
@@ -3486,7 +3708,8 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
           eos_static_debug("adding ino=%08lx p-ino=%08lx", (*md)()->id(), (*md)()->pid());
           fi->fh = (unsigned long) md_fh;
 #ifdef USE_FUSE3
-          fi->keep_cache = 1;
+          // a listing cached by the kernel is outdated after a bulk rm
+          fi->keep_cache = do_listdir ? 1 : 0;
           fi->cache_readdir = 1;
 #endif
         }
@@ -3494,11 +3717,6 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
     }
   }
 
-  // rm-rf might need to tell the kernel cache  that this directory is gone
-  if (pino && EosFuse::Instance().Config().options.md_kernelcache) {
-    kernelcache::inval_entry(pino, name.c_str());
-  }
-
   if (rc) {
     fuse_reply_err(req, rc);
   } else {
@@ -4826,8 +5044,31 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
               fi->keep_cache = false;
             }
 
+#ifdef FUSE_CAP_PASSTHROUGH
+
+            if (Instance().Config().options.data_passthrough && (mode != U_OK) &&
+                !outdated && obfuscation_key.empty() &&
+                !Instance().datas.retrieve_wr_md(ino)) {
+              // a file complete in the file cache is read by the kernel directly
+              // from the cache file, without any read request reaching eosxd
+              int fd = io->ioctx()->passthrough_open(req);
+
+              if (fd >= 0) {
+                int backing_id = fuse_passthrough_open(req, fd);
+
+                if (backing_id > 0) {
+                  io->backing_id = backing_id;
+                  fi->backing_id = backing_id;
+                } else {
+                  io->ioctx()->passthrough_close();
+                }
+              }
+            }
+
+#endif
             fi->direct_io = 0;
-            eos_static_info("%s data-cache=%d", md->dump(e).c_str(), fi->keep_cache);
+            eos_static_info("%s data-cache=%d passthrough=%d", md->dump(e).c_str(),
+                            fi->keep_cache, io->backing_id > 0);
           }
         }
       }
@@ -5197,8 +5438,24 @@ EosFuse::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
 
   if (io) {
     char* buf = 0;
-
-    if ((res = io->ioctx()->peek_pread(req, buf, size, off)) == -1) {
+    int fd = -1;
+
+    if (Instance().Config().options.data_splice && io->hmac.key.empty() &&
+        ((res = io->ioctx()->peek_splice(req, fd, size, off)) >= 0)) {
+      // the range is complete in the file cache, hand the descriptor to libfuse
+      // which splices it into the kernel or falls back to a copy
+      struct fuse_bufvec bufv = FUSE_BUFVEC_INIT(res);
+      bufv.buf[0].flags = (enum fuse_buf_flags)(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+      bufv.buf[0].fd = fd;
+      bufv.buf[0].pos = off;
+      eos_static_debug("reply splice res=%lu", res);
+
+      if ((rc = fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE))) {
+        // the reply is lost, don't send a second one
+        eos_static_err("splice reply failed ino=%#lx errno=%d", ino, -rc);
+        rc = 0;
+      }
+    } else if ((res = io->ioctx()->peek_pread(req, buf, size, off)) == -1) {
       rc = errno ? errno : EIO;
     } else {
       eos_static_debug("reply res=%lu", res);
@@ -5373,6 +5630,14 @@ EosFuse::release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
       }
     }
 
+#ifdef FUSE_CAP_PASSTHROUGH
+
+    if (io->backing_id > 0) {
+      fuse_passthrough_close(req, io->backing_id);
+      io->ioctx()->passthrough_close();
+    }
+
+#endif
     std::string cookie = "";
     io->ioctx()->detach(req, cookie, io->rw);
     Instance().caps.close_writer_inode(io->cap_);
@@ -6139,6 +6404,7 @@ EosFuse::setxattr(fuse_req_t req, fuse_ino_t ino, const char* xattr_name,
     static std::string s_resetlru = "system.eos.resetlru";
     static std::string s_log = "system.eos.log";
     static std::string s_fuzz = "system.eos.fuzz";
+    static std::string s_rmrf = "system.eos.rmrf";
 
     if (key.substr(0, s_fuzz.length()) == s_fuzz) {
       local_setxattr = true;
@@ -6274,6 +6540,17 @@ EosFuse::setxattr(fuse_req_t req, fuse_ino_t ino, const char* xattr_name,
         ::chmod(Instance().Config().logfilepath.c_str(), S_IRUSR | S_IWUSR);
       }
     }
+
+    if (key == s_rmrf) {
+      // explicit recursive delete of a directory tree in a single MGM call
+      local_setxattr = true;
+
+      if (Instance().Config().options.rm_rf_bulk) {
+        rc = bulkRm(req, Instance().mds.get(req, ino));
+      } else {
+        rc = EOPNOTSUPP;
+      }
+    }
   }
 
   if (!local_setxattr) {
@@ -7311,6 +7588,60 @@ EosFuse::isRecursiveRm(fuse_req_t req, bool forced, bool notverbose)
   return false;
 }
 
+/* -------------------------------------------------------------------------- */
+int
+EosFuse::bulkRm(fuse_req_t req, metad::shared_md md)
+/* -------------------------------------------------------------------------- */
+{
+  // removes the tree below md with one recursive delete on the MGM instead of
+  // an unlink/rmdir round trip per entry - EAGAIN asks the caller to remove
+  // the tree entry by entry
+  {
+    XrdSysMutexHelper mLock(md->Locker());
+
+    if (!(*md)()->id() || md->deleted()) {
+      return md->deleted() ? ENOENT : (*md)()->err();
+    }
+
+    if (!S_ISDIR((*md)()->mode())) {
+      return ENOTDIR;
+    }
+
+    if (md->get_rmrf()) {
+      // already removed by a previous call
+      return 0;
+    }
+
+    if ((Instance().Config().options.rm_rf_bulk < 2) &&
+        !(*md)()->attr().count("sys.recycle")) {
+      // without a recycle bin a bulk deletion can not be undone
+      return EAGAIN;
+    }
+
+    if (Instance().Config().options.rm_rf_protect_levels &&
+        Instance().mds.calculateDepth(md) <=
+        Instance().Config().options.rm_rf_protect_levels) {
+      eos_static_warning("Blocking recursive rm (pid = %d)", fuse_req_ctx(req)->pid);
+      return EPERM;
+    }
+  }
+
+  int rc = Instance().mds.rmrf(req, md);
+
+  if (EOS_LOGS_DEBUG) {
+    eos_static_debug("rm-rf gave retc=%d", rc);
+  }
+
+  if (rc && (rc != EAGAIN) && (rc != ENOENT)) {
+    // the MGM might have removed part of the tree, let rm report what is left
+    eos_static_warning("bulk rm-rf failed ino=%#lx retc=%d - removing entry by entry",
+                       (*md)()->id(), rc);
+    rc = EAGAIN;
+  }
+
+  return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
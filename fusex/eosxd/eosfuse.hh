@@ -284,6 +284,11 @@ public:
       int write_size_flush_interval;
       int submounts;
       int inmemory_inodes;
+      int md_flush_threads;
+      int md_flush_batch;
+      int md_warm_cache;
+      int data_splice;
+      int data_passthrough;
       bool flock;
       bool hide_versions;
       std::vector<std::string> no_fsync_suffixes;
@@ -425,6 +430,11 @@ public:
     return mKV.get();
   }
 
+  kv* getWarmKV()
+  {
+    return mWarmKV.get();
+  }
+
   cap& getCap()
   {
     return caps;
@@ -495,6 +505,8 @@ private:
   static bool isRecursiveRm(fuse_req_t req, bool forced = false,
                             bool notverbose = false);
 
+  static int bulkRm(fuse_req_t req, metad::shared_md md);
+
   static void Merge(Json::Value& a, Json::Value& b)
   {
     if (!a.isObject() || !b.isObject()) {
@@ -521,6 +533,7 @@ private:
   stringTS lastMgmHostPort;
 
   std::unique_ptr<kv> mKV;
+  std::unique_ptr<kv> mWarmKV;
   Stat fusestat;
 
   FILE* fstderr;
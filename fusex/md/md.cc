@@ -22,6 +22,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 #include <assert.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -58,6 +59,8 @@ metad::metad() : last_heartbeat(0), mdflush(0), mCb(0),
   stat.inodes_ever_inc();
   set_is_visible(0);
   mdbackend = 0;
+  warmstore = 0;
+  warmgrace = 0;
   mdmap.insertTS(1, md);
 }
 
@@ -81,13 +84,15 @@ metad::init(backend* _mdbackend)
   std::string mdstream;
   // load the root node
   fuse_id fuseid;
-  XrdSysMutexHelper mLock(mdmap);
-  update(fuseid, mdmap[1], "", true);
+  shared_md md1;
+  mdmap.retrieveTS(1, md1);
+  update(fuseid, md1, "", true);
   mdmap.init(EosFuse::Instance().getKV());
   dentrymessaging = false;
   writesizeflush = false;
   appname = false;
   mdquery = false;
+  mdbatch = false;
   serverversion = "<unkown>";
 }
 
@@ -198,9 +203,10 @@ metad::lookup(fuse_req_t req, fuse_ino_t parent, const char* name)
     // --------------------------------------------------
     // STEP 2: check if we hold a cap for that directory
     // --------------------------------------------------
-    if (pmd->cap_count() && !pmd->needs_refresh()) {
+    if ((pmd->cap_count() || pmd->warm()) && !pmd->needs_refresh()) {
       // --------------------------------------------------
       // if we have a cap and we listed this directory, we trust the child information
+      // - the same holds for a listing restored from the warm md cache
       // --------------------------------------------------
       if (pmd->local_children().count(
             eos::common::StringConversion::EncodeInvalidUTF8(name))) {
@@ -331,6 +337,12 @@ metad::forget(fuse_req_t req, fuse_ino_t ino, int nlookup)
                      (*md)()->name().c_str());
   }
 
+  if (warmstore) {
+    // keep the last known state for the next mount
+    XrdSysMutexHelper mLock(md->Locker());
+    warm_store(md);
+  }
+
   if (mdmap.eraseTS(ino)) {
     stat.inodes_dec();
   }
@@ -591,12 +603,12 @@ metad::wait_backlog(uint64_t id, size_t minfree)
   // minfree: if possible wait for the number of elements in mdqueue map to
   //          have this much headroom below the mdqueue_max_backlog level.
   //
-  // if the mdcflush thread is currently attempting to process "id", skip the
+  // if a mdcflush worker is currently attempting to process "id", skip the
   // wait as we risk a deadlock with mdcflush.
   // ------------------------------------------------------------------------
   while (mdqueue.size() + minfree > mdqueue_max_backlog) {
     if (id) {
-      if (id == mdqueue_current) {
+      if (mdqueue_inflight.count(id)) {
         return;
       }
     }
@@ -686,8 +698,14 @@ metad::get(fuse_req_t req,
 
   if (ino) {
     if (!mdmap.retrieveTS(ino, md)) {
-      md = std::make_shared<mdx>();
-      (*md)()->set_md_ino(inomap.backward(ino));
+      shared_md wmd = warmstore ? warm_restore(ino) : nullptr;
+
+      if (wmd) {
+        md = wmd;
+      } else {
+        md = std::make_shared<mdx>();
+        (*md)()->set_md_ino(inomap.backward(ino));
+      }
     } else {
       if (ino != 1) {
         // we need this to refetch a hard link target which was removed server side
@@ -720,6 +738,15 @@ metad::get(fuse_req_t req,
       return md;
     }
 
+    if (md->warm() && !md->needs_refresh()) {
+      XrdSysMutexHelper mLock(md->Locker());
+
+      if ((!listing) || ((*md)()->type() == (*md)()->MDLS)) {
+        eos_static_info("returning warm entry");
+        return md;
+      }
+    }
+
     if (pmd && (pmd->cap_count() || (*pmd)()->creator()) && !pmd->needs_refresh() &&
         !md->needs_refresh()) {
       eos_static_info("returning cap entry");
@@ -1112,6 +1139,8 @@ metad::add(fuse_req_t req, metad::shared_md pmd, metad::shared_md md,
     wait_backlog(id, 2);
     flushentry fe(id, authid, mdx::ADD, req);
     fe.bind();
+    // the parent has to exist upstream before the child can be created
+    fe.depend_on(pid);
     mdqueue[id]++;
     mdflushqueue.push_back(fe);
   }
@@ -1313,6 +1342,11 @@ metad::remove(fuse_req_t req, metad::shared_md pmd, metad::shared_md md,
 
   std::string name = (*md)()->name();
   const uint64_t id = (*md)()->id();
+
+  if (warmstore) {
+    warmstore->erase(id, "w");
+  }
+
   // avoid lock order violation
   md->Locker().UnLock();
   uint64_t pid = 0;
@@ -1338,6 +1372,9 @@ metad::remove(fuse_req_t req, metad::shared_md pmd, metad::shared_md md,
   wait_backlog(id, 2);
   flushentry fe(id, authid, mdx::RM, req);
   fe.bind();
+  // deletions are not reordered with respect to any other update e.g. a
+  // directory can only be removed once all its children are gone
+  fe.set_barrier();
   flushentry fep(pid, authid, mdx::LSTORE, req);
   fep.bind();
   mdqueue[pid]++;
@@ -1458,6 +1495,9 @@ metad::mv(fuse_req_t req, shared_md p1md, shared_md p2md, shared_md md,
 
   flushentry fe((*md)()->id(), authid2, mdx::UPDATE, req);
   fe.bind();
+  // renames are not reordered with respect to any other update since they
+  // can replace the target of a concurrent update
+  fe.set_barrier();
   mdqueue[(*md)()->id()]++;
   mdflushqueue.push_back(fe);
   stat.inodes_backlog_store(mdqueue.size());
@@ -1469,8 +1509,120 @@ metad::mv(fuse_req_t req, shared_md p1md, shared_md p2md, shared_md md,
 int
 metad::rmrf(fuse_req_t req, shared_md md)
 {
-  int rc = mdbackend->rmRf(req, (*md)());
-  return rc;
+  // collect the cached part of the tree, one md locked at a time
+  std::vector<shared_md> tree;
+  std::deque<shared_md> todo;
+  todo.push_back(md);
+
+  while (todo.size()) {
+    shared_md dmd = todo.front();
+    todo.pop_front();
+    std::vector<uint64_t> children;
+    {
+      XrdSysMutexHelper mLock(dmd->Locker());
+
+      for (auto it = dmd->local_children().begin();
+           it != dmd->local_children().end(); ++it) {
+        children.push_back(it->second);
+      }
+    }
+
+    for (auto ino : children) {
+      shared_md cmd;
+
+      if (mdmap.retrieveTS(ino, cmd)) {
+        tree.push_back(cmd);
+        todo.push_back(cmd);
+      }
+    }
+  }
+
+  int rc = 0;
+  std::string name;
+  fuse_ino_t pino = 0;
+  {
+    XrdSysMutexHelper mLock(md->Locker());
+    {
+      // entries created or changed locally might not exist upstream yet and
+      // would be re-created by the flusher after the recursive delete. The
+      // flush lock (taken after the mdx lock) is held until the delete is
+      // issued so that nothing can be queued in between.
+      XrdSysCondVarHelper fLock(mdflush);
+
+      if (mdqueue.count((*md)()->id())) {
+        return EAGAIN;
+      }
+
+      for (auto& cmd : tree) {
+        if (mdqueue.count((*cmd)()->id())) {
+          return EAGAIN;
+        }
+      }
+
+      rc = mdbackend->rmRf(req, (*md)());
+    }
+
+    if (rc) {
+      return rc;
+    }
+
+    name = (*md)()->name();
+    pino = (*md)()->pid();
+    // the directory itself stays known as empty until the kernel forgets it
+    md->local_children().clear();
+    md->local_enoent().clear();
+    md->get_todelete().clear();
+    (*md)()->clear_children();
+    (*md)()->set_nchildren(0);
+    (*md)()->set_type((*md)()->MDLS);
+    md->clear_warm();
+    md->set_rmrf();
+
+    if (warmstore) {
+      warmstore->erase((*md)()->id(), "w");
+    }
+  }
+
+  // everything below is gone upstream, the next access fetches it again
+  for (auto& cmd : tree) {
+    XrdSysMutexHelper mLock(cmd->Locker());
+    cmd->local_children().clear();
+    cmd->local_enoent().clear();
+    cmd->get_todelete().clear();
+    (*cmd)()->clear_children();
+    (*cmd)()->set_nchildren(0);
+    (*cmd)()->set_type((*cmd)()->MD);
+    cmd->clear_warm();
+    cmd->force_refresh();
+
+    if (warmstore) {
+      warmstore->erase((*cmd)()->id(), "w");
+    }
+  }
+
+  shared_md pmd;
+
+  if (pino && mdmap.retrieveTS(pino, pmd)) {
+    XrdSysMutexHelper pLock(pmd->Locker());
+    std::string ename = eos::common::StringConversion::EncodeInvalidUTF8(name);
+
+    if (pmd->local_children().count(ename)) {
+      pmd->local_children().erase(ename);
+      (*pmd)()->mutable_children()->erase(ename);
+      (*pmd)()->set_nchildren((*pmd)()->nchildren() - 1);
+    }
+  }
+
+  // invalidating the top entry detaches the whole subtree in the kernel
+  if (pino && EosFuse::Instance().Config().options.md_kernelcache) {
+    kernelcache::inval_entry(pino, name);
+  }
+
+  stat.rmrf_bulk_inc();
+  stat.rmrf_dropped_add(tree.size());
+  eos_static_notice("rm-rf ino=%#lx name=%s dropped=%lu", (*md)()->id(),
+                    name.c_str(), tree.size());
+  return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1932,14 +2084,14 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
     (*md)()->set_pid(p_ino);
     (*md)()->set_id(ino);
     md->clear_refresh();
+    warm_revalidated(md);
     eos_static_info("store local pino=%016lx for %016lx", (*md)()->pid(),
                     (*md)()->id());
     inomap.insert(md_ino, ino);
     md->Locker().UnLock();
 
     if (is_new) {
-      XrdSysMutexHelper mLock(mdmap);
-      mdmap[ino] = md;
+      mdmap.insertTS(ino, md);
       stat.inodes_inc();
       stat.inodes_ever_inc();
     }
@@ -2077,6 +2229,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
 
           (*md)()->clear_capability();
           (*md)()->set_id(ino);
+          warm_revalidated(md);
           p_ino = inomap.forward((*md)()->md_pino());
           (*md)()->set_pid(p_ino);
           eos_static_info("store remote-ino=%016lx local pino=%016lx for %016lx",
@@ -2242,201 +2395,466 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
 void
 metad::mdcflush(ThreadAssistant& assistant)
 {
-  uint64_t lastflushid = 0;
   ThreadAssistant::setSelfThreadName("metad::mdcflush");
+  int nworkers = EosFuse::Instance().Config().options.md_flush_threads;
+
+  if (nworkers < 1) {
+    nworkers = 1;
+  }
+
+  // the calling thread acts as the first worker, the additional workers are
+  // stopped once it is asked to terminate
+  std::vector<std::unique_ptr<AssistedThread>> workers;
+
+  for (int i = 1; i < nworkers; ++i) {
+    workers.emplace_back(new AssistedThread(&metad::mdcflush_worker, this));
+  }
+
+  eos_static_info("metacache::flush started workers=%d", nworkers);
+  mdcflush_worker(assistant);
+
+  for (auto& worker : workers) {
+    worker->join();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::mdcflush_worker(ThreadAssistant& assistant)
+{
+  ThreadAssistant::setSelfThreadName("metad::mdcflush");
+  size_t max_batch = std::max(1, EosFuse::Instance().Config().options.md_flush_batch);
 
   while (!assistant.terminationRequested()) {
-    {
-      mdflush.Lock();
+    // each group holds the merged entries of one inode
+    std::vector<std::vector<flushentry>> groups(1);
+    size_t batch_size = supports_mdbatch() ? max_batch : 1;
+    mdflush.Lock();
+    stat.inodes_backlog_store(mdqueue.size());
+
+    while (!mdflush_pick(groups.front())) {
+      // TODO(gbitzes): Fix this, so we don't need to poll. Have ThreadAssistant
+      // accept callbacks for when termination is requested, so we can wake up
+      // any condvar.
+      mdflush.Wait(1);
+
+      if (assistant.terminationRequested()) {
+        mdflush.UnLock();
+        return;
+      }
+    }
+
+    // collect more independent updates which can be pushed upstream together
+    while ((groups.size() < batch_size) &&
+           mdflush_batchable(groups.front().front(), groups.back().front())) {
+      std::vector<flushentry> next;
+
+      if (!mdflush_pick(next)) {
+        break;
+      }
+
+      groups.push_back(std::move(next));
+    }
+
+    for (const auto& entries : groups) {
+      eos_static_info("metacache::flush ino=%#lx flushqueue-size=%u merged=%lu",
+                      entries.front().id(), mdflushqueue.size(), entries.size());
+      eos_static_info("metacache::flush %s",
+                      flushentry::dump(entries.front()).c_str());
+    }
+
+    // hand over the remaining entries to an idle worker
+    if (!mdflushqueue.empty()) {
+      mdflush.Signal();
+    }
+
+    mdflush.UnLock();
+    std::vector<flushentry> batch;
+
+    for (const auto& entries : groups) {
+      const flushentry& fe = entries.front();
+
+      if (mdflush_batchable(groups.front().front(), fe)) {
+        batch.push_back(fe);
+      } else {
+        mdflush_entry(fe, entries.size());
+      }
+    }
+
+    if (batch.size() > 1) {
+      mdflush_batch(batch);
+    } else if (batch.size()) {
+      mdflush_entry(batch.front(), groups.front().size());
+    }
+
+    // done with the entries, release the inodes for the other workers
+    mdflush.Lock();
+
+    for (const auto& entries : groups) {
+      mdqueue_inflight.erase(entries.front().id());
+
+      if (entries.front().barrier()) {
+        mdqueue_barrier = false;
+      }
+
+      for (auto& e : entries) {
+        auto it = mdqueue.find(e.id());
 
-      if (mdqueue.count(lastflushid)) {
         // remove entries from the mdqueue, if their ref count is 0
-        if (!mdqueue[lastflushid]) {
-          mdqueue.erase(lastflushid);
+        if ((it != mdqueue.end()) && (!it->second || !--it->second)) {
+          mdqueue.erase(it);
         }
       }
+    }
 
-      mdqueue_current = 0;
-      stat.inodes_backlog_store(mdqueue.size());
+    mdflush.Broadcast();
+    mdflush.UnLock();
+  }
+}
 
-      while (mdqueue.size() == 0) {
-        // TODO(gbitzes): Fix this, so we don't need to poll. Have ThreadAssistant
-        // accept callbacks for when termination is requested, so we can wake up
-        // any condvar.
-        mdflush.Wait(1);
+/* -------------------------------------------------------------------------- */
+bool
+metad::mdflush_batchable(const flushentry& first, const flushentry& fe)
+{
+  // only plain md pushes issued with the same login can share a request
+  if (fe.barrier() || ((fe.op() != mdx::ADD) && (fe.op() != mdx::UPDATE))) {
+    return false;
+  }
 
-        if (assistant.terminationRequested()) {
-          mdflush.UnLock();
-          return;
-        }
+  if ((first.op() != mdx::ADD) && (first.op() != mdx::UPDATE)) {
+    return false;
+  }
+
+  const fuse_id& f1 = first.get_fuse_id();
+  const fuse_id& f2 = fe.get_fuse_id();
+
+  if ((f1.uid != f2.uid) || (f1.gid != f2.gid) || !f1.getid() || !f2.getid()) {
+    return false;
+  }
+
+  return (f1.getid()->url.GetUserName() == f2.getid()->url.GetUserName());
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+metad::mdflush_pick(std::vector<flushentry>& entries)
+{
+  // Entries of the same inode are flushed in queue order by a single worker,
+  // an entry depending on another inode waits until all the entries of that
+  // inode queued before it are flushed, and barrier entries are flushed alone.
+  // The scan is bounded to keep the cost under the mdflush lock constant.
+  static constexpr size_t max_scan = 1024;
+  std::set<uint64_t> blocked;
+
+  if (mdqueue_barrier) {
+    return false;
+  }
+
+  for (size_t i = 0; (i < mdflushqueue.size()) && (i < max_scan); ++i) {
+    const flushentry& fe = mdflushqueue[i];
+
+    if (fe.barrier()) {
+      if (i || !mdqueue_inflight.empty()) {
+        return false;
       }
 
-      // TODO: add an optimzation to merge requests in the queue
-      auto it = mdflushqueue.begin();
-      const uint64_t ino = it->id();
-      std::string authid = it->authid();
-      fuse_id f_id = it->get_fuse_id();
-      mdx::md_op op = it->op();
-      lastflushid = ino;
-      eos_static_info("metacache::flush ino=%#lx flushqueue-size=%u", ino,
-                      mdflushqueue.size());
-      eos_static_info("metacache::flush %s", flushentry::dump(*it).c_str());
-      mdqueue_current = ino;
-      mdflush.UnLock();
+      mdqueue_barrier = true;
+    } else {
+      if (blocked.count(fe.id()) || mdqueue_inflight.count(fe.id())) {
+        continue;
+      }
 
-      if (assistant.terminationRequested()) {
-        return;
+      if (fe.depends() && (blocked.count(fe.depends()) ||
+                           mdqueue_inflight.count(fe.depends()))) {
+        blocked.insert(fe.id());
+        continue;
       }
+    }
 
-      if (EOS_LOGS_DEBUG) {
-        eos_static_debug("metacache::flush ino=%016lx authid=%s op=%d", ino,
-                         authid.c_str(), (int) op);
+    const uint64_t ino = fe.id();
+    entries.push_back(fe);
+    mdflushqueue.erase(mdflushqueue.begin() + i);
+    mdqueue_inflight.insert(ino);
+
+    if (entries.front().barrier()) {
+      return true;
+    }
+
+    // coalesce the following pushes of the same inode, the upstream update
+    // always sends the current state of the md object, so one push covers
+    // all of them
+    for (size_t j = i; (j < mdflushqueue.size()) && (j < max_scan);) {
+      const flushentry& next = mdflushqueue[j];
+
+      if (next.barrier() || (next.depends() == ino)) {
+        break;
       }
 
-      do {
-        shared_md md;
+      if (next.id() != ino) {
+        ++j;
+        continue;
+      }
 
-        if (!mdmap.retrieveTS(ino, md)) {
-          eos_static_crit("metacache::flush failed to retrieve ino=%016lx", ino);
-          continue;
+      bool same = false;
+
+      if (entries.front().op() == mdx::LSTORE) {
+        same = (next.op() == mdx::LSTORE);
+      } else {
+        same = ((next.op() == mdx::UPDATE) &&
+                (next.authid() == entries.front().authid()));
+      }
+
+      if (!same) {
+        break;
+      }
+
+      entries.push_back(next);
+      mdflushqueue.erase(mdflushqueue.begin() + j);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::mdflush_pino(shared_md md)
+{
+  if (!(*md)()->md_pino()) {
+    // when creating objects locally faster than pushed upstream
+    // we might not know the remote parent id when we insert a local
+    // creation request
+    shared_md pmd;
+
+    if (mdmap.retrieveTS((*md)()->pid(), pmd)) {
+      // TODO: check if we need to lock pmd? But then we have to enforce
+      // locking order child -> parent
+      uint64_t md_pino = (*pmd)()->md_ino();
+      eos_static_info("metacache::flush providing parent inode %016lx to %016lx",
+                      (*md)()->id(), md_pino);
+      (*md)()->set_md_pino(md_pino);
+    } else {
+      eos_static_crit("metacache::flush ino=%016lx parent remote inode not known",
+                      (unsigned long long)(*md)()->id());
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::mdflush_entry(const flushentry& fe, size_t merged)
+{
+  const uint64_t ino = fe.id();
+  const std::string& authid = fe.authid();
+  fuse_id f_id = fe.get_fuse_id();
+  mdx::md_op op = fe.op();
+
+  if (EOS_LOGS_DEBUG) {
+    eos_static_debug("metacache::flush ino=%016lx authid=%s op=%d merged=%lu",
+                     ino, authid.c_str(), (int) op, merged);
+  }
+
+  shared_md md;
+
+  if (!mdmap.retrieveTS(ino, md)) {
+    eos_static_crit("metacache::flush failed to retrieve ino=%016lx", ino);
+    return;
+  }
+
+  eos_static_info("metacache::flush ino=%016lx", (unsigned long long) ino);
+
+  if (op != metad::mdx::LSTORE) {
+    XrdSysMutexHelper mdLock(md->Locker());
+    mdflush_pino(md);
+  }
+
+  md->Locker().Lock();
+
+  if ((*md)()->id()) {
+    uint64_t removeentry = 0;
+    const std::string md_name = (*md)()->name();
+    {
+      int rc = 0;
+
+      if (op == metad::mdx::RM) {
+        (*md)()->set_operation((*md)()->DELETE);
+      } else {
+        (*md)()->set_operation((*md)()->SET);
+      }
+
+      if (((op == metad::mdx::ADD) ||
+           (op == metad::mdx::UPDATE) ||
+           (op == metad::mdx::RM)) &&
+          (*md)()->id() != 1) {
+        eos_static_info("metacache::flush backend::putMD - start");
+        eos::fusex::md::TYPE mdtype = (*md)()->type();
+        (*md)()->set_type((*md)()->MD);
+
+        // push to backend
+        if ((rc = mdbackend->putMD(f_id, (*md)(), authid, &(md->Locker())))) {
+          eos_static_err("metacache::flush backend::putMD failed rc=%d", rc);
+          // we just set an error code
+          //! inomap.erase_bwd((*md)()->id());
+          //! removeentry=(*md)()->id();
+          (*md)()->set_err(rc);
+        } else {
+          inomap.insert((*md)()->md_ino(), (*md)()->id());
         }
 
-        eos_static_info("metacache::flush ino=%016lx", (unsigned long long) ino);
+        if (md->getop() != metad::mdx::RM) {
+          md->setop_none();
+          (*md)()->clear_mv_authid();
+        }
 
-        if (op != metad::mdx::LSTORE) {
-          XrdSysMutexHelper mdLock(md->Locker());
+        (*md)()->set_type(mdtype);
+        md->Signal();
+        eos_static_info("metacache::flush backend::putMD - stop");
+      }
 
-          if (!(*md)()->md_pino()) {
-            // when creating objects locally faster than pushed upstream
-            // we might not know the remote parent id when we insert a local
-            // creation request
-            shared_md pmd;
+      if ((op == metad::mdx::ADD) || (op == metad::mdx::UPDATE) ||
+          (op == metad::mdx::LSTORE)) {
+        // TODO: local MD store is now disabled - delete this code
+        //! std::string mdstream;
+        //! md->SerializeToString(&mdstream);
+        //! EosFuse::Instance().getKV()->put(ino, mdstream);
+        md->Locker().UnLock();
+      } else {
+        md->Locker().UnLock();
 
-            if (mdmap.retrieveTS((*md)()->pid(), pmd)) {
-              // TODO: check if we need to lock pmd? But then we have to enforce
-              // locking order child -> parent
-              uint64_t md_pino = (*pmd)()->md_ino();
-              eos_static_info("metacache::flush providing parent inode %016lx to %016lx",
-                              (*md)()->id(), md_pino);
-              (*md)()->set_md_pino(md_pino);
-            } else {
-              eos_static_crit("metacache::flush ino=%016lx parent remote inode not known",
-                              (unsigned long long) ino);
-            }
+        if (op == metad::mdx::RM) {
+          // this step is coupled to the forget function, since we cannot
+          // forget an entry if we didn't process the outstanding KV changes
+          stat.inodes_deleted_dec();
+
+          if (EOS_LOGS_DEBUG) {
+            eos_static_debug("count=%d(-%d) - ino=%#lx", md->lookup_is(), 1, ino);
+          }
+
+          XrdSysMutexHelper mLock(md->Locker());
+
+          if (md->lookup_dec(1)) {
+            // forget this inode
+            removeentry = ino;
           }
         }
+      }
+    }
 
-        md->Locker().Lock();
+    if (removeentry) {
+      shared_md pmd;
 
-        if ((*md)()->id()) {
-          uint64_t removeentry = 0;
-          const std::string md_name = (*md)()->name();
-          {
-            int rc = 0;
+      if (EOS_LOGS_DEBUG) {
+        eos_static_debug("delete md object - ino=%#lx", removeentry);
+      }
 
-            if (op == metad::mdx::RM) {
-              (*md)()->set_operation((*md)()->DELETE);
-            } else {
-              (*md)()->set_operation((*md)()->SET);
-            }
+      {
+        if (EOS_LOGS_DEBUG) {
+          eos_static_debug("calling forget function %#lx", removeentry);
+        }
 
-            if (((op == metad::mdx::ADD) ||
-                 (op == metad::mdx::UPDATE) ||
-                 (op == metad::mdx::RM)) &&
-                (*md)()->id() != 1) {
-              eos_static_info("metacache::flush backend::putMD - start");
-              eos::fusex::md::TYPE mdtype = (*md)()->type();
-              (*md)()->set_type((*md)()->MD);
+        forget(0, removeentry, 0);
+      }
 
-              // push to backend
-              if ((rc = mdbackend->putMD(f_id, (*md)(), authid, &(md->Locker())))) {
-                eos_static_err("metacache::flush backend::putMD failed rc=%d", rc);
-                // we just set an error code
-                //! inomap.erase_bwd((*md)()->id());
-                //! removeentry=(*md)()->id();
-                (*md)()->set_err(rc);
-              } else {
-                inomap.insert((*md)()->md_ino(), (*md)()->id());
-              }
+      {
+        if (pmd) {
+          XrdSysMutexHelper mmLock(pmd->Locker());
+          // we don't remote entries from the local deletion list because there could be
+          // a race condition of a thread doing MDLS overwriting the locally deleted entry
+          pmd->get_todelete().erase(eos::common::StringConversion::EncodeInvalidUTF8(
+                                      md_name));
+          pmd->Signal();
+        }
+      }
+    }
+  } else {
+    md->Locker().UnLock();
+  }
+}
 
-              if (md->getop() != metad::mdx::RM) {
-                md->setop_none();
-                (*md)()->clear_mv_authid();
-              }
+/* -------------------------------------------------------------------------- */
+void
+metad::mdflush_batch(const std::vector<flushentry>& fes)
+{
+  std::vector<const flushentry*> entries;
+  std::vector<shared_md> mds;
+  std::vector<eos::fusex::md> records;
+  std::vector<std::string> authids;
 
-              (*md)()->set_type(mdtype);
-              md->Signal();
-              eos_static_info("metacache::flush backend::putMD - stop");
-            }
+  for (const auto& fe : fes) {
+    shared_md md;
 
-            if ((op == metad::mdx::ADD) || (op == metad::mdx::UPDATE) ||
-                (op == metad::mdx::LSTORE)) {
-              // TODO: local MD store is now disabled - delete this code
-              //! std::string mdstream;
-              //! md->SerializeToString(&mdstream);
-              //! EosFuse::Instance().getKV()->put(ino, mdstream);
-              md->Locker().UnLock();
-            } else {
-              md->Locker().UnLock();
+    if (!mdmap.retrieveTS(fe.id(), md)) {
+      eos_static_crit("metacache::flush failed to retrieve ino=%016lx", fe.id());
+      continue;
+    }
 
-              if (op == metad::mdx::RM) {
-                // this step is coupled to the forget function, since we cannot
-                // forget an entry if we didn't process the outstanding KV changes
-                stat.inodes_deleted_dec();
+    XrdSysMutexHelper mdLock(md->Locker());
 
-                if (EOS_LOGS_DEBUG) {
-                  eos_static_debug("count=%d(-%d) - ino=%#lx", md->lookup_is(), 1, ino);
-                }
+    if (!(*md)()->id() || ((*md)()->id() == 1)) {
+      continue;
+    }
 
-                XrdSysMutexHelper mLock(md->Locker());
+    mdflush_pino(md);
+    (*md)()->set_operation((*md)()->SET);
+    records.push_back(*(*md)());
+    records.back().set_type(records.back().MD);
+    entries.push_back(&fe);
+    mds.push_back(md);
+    authids.push_back(fe.authid());
+  }
 
-                if (md->lookup_dec(1)) {
-                  // forget this inode
-                  removeentry = ino;
-                }
-              }
-            }
-          }
+  if (records.size() < 2) {
+    for (auto fe : entries) {
+      mdflush_entry(*fe, 1);
+    }
 
-          if (removeentry) {
-            shared_md pmd;
+    return;
+  }
 
-            if (EOS_LOGS_DEBUG) {
-              eos_static_debug("delete md object - ino=%#lx", removeentry);
-            }
+  eos_static_info("metacache::flush backend::putMDBatch - start batch=%lu",
+                  records.size());
+  fuse_id f_id = entries.front()->get_fuse_id();
+  std::vector<int> retc;
 
-            {
-              if (EOS_LOGS_DEBUG) {
-                eos_static_debug("calling forget function %#lx", removeentry);
-              }
+  if (mdbackend->putMDBatch(f_id, records, authids, retc)) {
+    // the batch did not make it upstream, push the entries one by one
+    eos_static_err("metacache::flush backend::putMDBatch failed batch=%lu",
+                   records.size());
 
-              forget(0, removeentry, 0);
-            }
+    for (auto fe : entries) {
+      mdflush_entry(*fe, 1);
+    }
 
-            {
-              if (pmd) {
-                XrdSysMutexHelper mmLock(pmd->Locker());
-                // we don't remote entries from the local deletion list because there could be
-                // a race condition of a thread doing MDLS overwriting the locally deleted entry
-                pmd->get_todelete().erase(eos::common::StringConversion::EncodeInvalidUTF8(
-                                            md_name));
-                pmd->Signal();
-              }
-            }
-          }
-        } else {
-          md->Locker().UnLock();
-        }
-      } while(0);
+    return;
+  }
 
-      // done with the entry, remove it from the queue
-      mdflush.Lock();
-      it = mdflushqueue.begin();
-      mdflushqueue.erase(it);
-      mdqueue[ino]--;
-      mdflush.UnLock();
+  for (size_t i = 0; i < mds.size(); ++i) {
+    shared_md md = mds[i];
+    XrdSysMutexHelper mdLock(md->Locker());
+
+    if (retc[i]) {
+      eos_static_err("metacache::flush backend::putMD failed rc=%d", retc[i]);
+      (*md)()->set_err(retc[i]);
+    } else {
+      if (records[i].md_ino()) {
+        (*md)()->set_md_ino(records[i].md_ino());
+      }
+
+      inomap.insert((*md)()->md_ino(), (*md)()->id());
+    }
+
+    if (md->getop() != metad::mdx::RM) {
+      md->setop_none();
+      (*md)()->clear_mv_authid();
     }
+
+    md->Signal();
   }
+
+  eos_static_info("metacache::flush backend::putMDBatch - stop batch=%lu",
+                  records.size());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -2444,6 +2862,7 @@ void
 metad::mdstackfree(ThreadAssistant& assistant)
 {
   size_t cnt = 0;
+  size_t swap_shard = 0;
   int max_inodes = EosFuse::Instance().Config().options.inmemory_inodes;
   ThreadAssistant::setSelfThreadName("metad::mdstackfree");
 
@@ -2458,53 +2877,73 @@ metad::mdstackfree(ThreadAssistant& assistant)
 
     // do this ~every 128 seconds
     if (!(cnt % 256)) {
-      XrdSysMutexHelper mLock(mdmap);
+      for (size_t i = 0; i < pmap::nshards; ++i) {
+        // entries whose parent has to be looked up in another shard
+        std::vector<std::pair<fuse_ino_t, uint64_t>> orphans;
+        {
+          pmap::shard& s = mdmap.at(i);
+          XrdSysMutexHelper mLock(s);
 
-      for (auto it = mdmap.begin(); it != mdmap.end();) {
-        if (!it->second) {
-          it++;
-          continue;
-        }
+          for (auto it = s.begin(); it != s.end();) {
+            if (!it->second) {
+              it++;
+              continue;
+            }
 
-        // Try if we can acquire a md lock, if yes, then remove them
-        // from the map & LRU if not,we try the next cycle
-        std::optional<uint64_t> pid;
+            // Try if we can acquire a md lock, if yes, then remove them
+            // from the map & LRU if not,we try the next cycle
+            std::optional<uint64_t> pid;
 
-        if (it->second->Locker().CondLock()) {
-          pid = it->second->pid();
-          it->second->Locker().UnLock();
-        }
+            if (it->second->Locker().CondLock()) {
+              pid = it->second->pid();
+              it->second->Locker().UnLock();
+            }
 
-        // if the parent is gone, we can remove the child
-        if ((pid && !mdmap.count(*pid)) &&
-            (!S_ISDIR((*(it->second))()->mode()) || it->second->deleted())) {
-          eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
-                           it->first, (*(it->second))()->fullpath().c_str());
-          mdmap.lru_remove(it->first);
-          it = mdmap.erase(it);
-          stat.inodes_dec();
-        } else {
-          if (it->second->deleted()) {
-            if ((!has_flush(it->first)) &&
-                (!EosFuse::Instance().datas.has(it->first))) {
-              eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
-                               it->first, (*(it->second))()->fullpath().c_str());
-              mdmap.lru_remove(it->first);
-              it = mdmap.erase(it);
-              stat.inodes_dec();
-            } else {
-              it++;
+            // if the parent is gone, we can remove the child
+            if (pid && (!S_ISDIR((*(it->second))()->mode()) || it->second->deleted())) {
+              orphans.push_back(std::make_pair(it->first, *pid));
             }
-          } else {
+
+            if (it->second->deleted()) {
+              if ((!has_flush(it->first)) &&
+                  (!EosFuse::Instance().datas.has(it->first))) {
+                eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
+                                 it->first, (*(it->second))()->fullpath().c_str());
+                s.lru_remove(it->first);
+                it = s.erase(it);
+                stat.inodes_dec();
+                continue;
+              }
+            }
+
             it++;
           }
         }
+
+        for (auto& orphan : orphans) {
+          if (mdmap.countTS(orphan.second)) {
+            continue;
+          }
+
+          pmap::shard& s = mdmap.at(i);
+          XrdSysMutexHelper mLock(s);
+          auto it = s.find(orphan.first);
+
+          if ((it != s.end()) && it->second) {
+            eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
+                             it->first, (*(it->second))()->fullpath().c_str());
+            s.lru_remove(it->first);
+            s.erase(it);
+            stat.inodes_dec();
+          }
+        }
       }
-    } //end mLock(mdmap)
+    }
 
     if (!EosFuse::Instance().Config().mdcachedir.empty()) {
       // level the inodes stored in memory and eventually swap out into kv store
       int swap_out_inodes = 0 ;
+      size_t empty_shards = 0;
 
       do {
         swap_out_inodes = mdmap.sizeTS() - max_inodes -
@@ -2512,21 +2951,32 @@ metad::mdstackfree(ThreadAssistant& assistant)
 
         if (swap_out_inodes > 0) {
           eos_static_info("swap-out %d inodes", swap_out_inodes);
+          // every shard keeps its own lru list, they are visited in turn
+          swap_shard = (swap_shard + 1) % pmap::nshards;
+          pmap::shard& s = mdmap.at(swap_shard);
           // grab the last lru inode and swap out
-          mdmap.Lock();
-          mdmap.lru_dump();
-          uint64_t inode_to_swap = mdmap.lru_oldest();
+          s.Lock();
+          s.lru_dump();
+          uint64_t inode_to_swap = s.lru_oldest();
 
           if (!inode_to_swap) {
-            // nothing in the lru list anymore
-            stat.lru_resets_inc();
-            mdmap.lru_reset();
-            mdmap.UnLock();
-            break;
+            // nothing in the lru list of this shard
+            s.UnLock();
+
+            if (++empty_shards >= pmap::nshards) {
+              // nothing in any lru list anymore
+              stat.lru_resets_inc();
+              mdmap.lru_resetTS();
+              break;
+            }
+
+            continue;
           }
 
-          if (mdmap.count(inode_to_swap)) {
-            shared_md md = mdmap[inode_to_swap];
+          empty_shards = 0;
+
+          if (s.count(inode_to_swap)) {
+            shared_md md = s[inode_to_swap];
 
             if ((md.use_count() > 2) ||
                 (md && md->LockTable().size())) {
@@ -2535,31 +2985,31 @@ metad::mdstackfree(ThreadAssistant& assistant)
                               md.use_count());
 
               if (md) {
-                mdmap.lru_update(inode_to_swap, md);
+                s.lru_update(inode_to_swap, md);
               }
 
-              mdmap.UnLock();
+              s.UnLock();
               continue;
             }
 
             if (md) {
               eos_static_info("swap-out lru-removed ino=%#llx oldest=%#llx", inode_to_swap,
-                              mdmap.lru_oldest());
-              mdmap.lru_remove(inode_to_swap);
-              mdmap[inode_to_swap] = 0;
+                              s.lru_oldest());
+              s.lru_remove(inode_to_swap);
+              s[inode_to_swap] = 0;
 
-              if (mdmap.swap_out(inode_to_swap, md)) {
+              if (s.swap_out(inode_to_swap, md)) {
                 eos_static_err("swap-out failed for ino=%#llx", inode_to_swap);
               }
             }
           } else {
             // the inode to be swapped isn't there, reset LRU list
-            mdmap.lru_remove(inode_to_swap);
+            s.lru_remove(inode_to_swap);
             stat.lru_resets_inc();
-            mdmap.lru_reset();
+            s.lru_reset();
           }
 
-          mdmap.UnLock();
+          s.UnLock();
         }
       } while ((swap_out_inodes > 0) &&
                (!assistant.terminationRequested()));
@@ -2685,6 +3135,227 @@ metad::calculateLocalPath(shared_md md)
   return calculateLocalPath(pmd) + lpath;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+metad::check_delta_base(shared_md pmd, uint64_t base_mtime,
+                        uint64_t base_mtime_ns)
+{
+  // a delta carries the parent mtime before the change, if our listing has
+  // missed an intermediate change, patching it is not enough and the
+  // listing is fetched again on the next access
+  if (!base_mtime && !base_mtime_ns) {
+    return;
+  }
+
+  if ((*pmd)()->type() != (*pmd)()->MDLS) {
+    // no listing cached
+    return;
+  }
+
+  if (((*pmd)()->mtime() == base_mtime) &&
+      ((*pmd)()->mtime_ns() == base_mtime_ns)) {
+    stat.dentry_deltas_inc();
+  } else {
+    eos_static_info("ino=%#lx mtime=%lu.%lu base=%lu.%lu - refetching listing",
+                    (*pmd)()->id(), (*pmd)()->mtime(), (*pmd)()->mtime_ns(),
+                    base_mtime, base_mtime_ns);
+    pmd->force_refresh();
+    stat.dentry_fallbacks_inc();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::warm_init(kv* store, int grace)
+{
+  // records found in store are served for grace seconds after they have been
+  // restored, afterwards the usual cap logic applies and the first access
+  // fetches them again from the MGM, which revalidates them
+  warmstore = store;
+  warmgrace = grace;
+  shared_md md1;
+  mdmap.retrieveTS(1, md1);
+  XrdSysMutexHelper mLock(md1->Locker());
+
+  if (warm_load(1, md1)) {
+    stat.warm_loaded_inc();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+int
+metad::warm_store(shared_md md)
+{
+  // called with md locked
+  const uint64_t ino = (*md)()->id();
+
+  if (!warmstore || !ino || !(*md)()->md_ino() || md->deleted() ||
+      (*md)()->err() || md->needs_refresh()) {
+    // nothing upstream to remember
+    return 0;
+  }
+
+  eos::fusex::md record(*(*md)());
+  record.clear_capability();
+  record.set_creator(false);
+  record.clear_children();
+
+  for (auto it = md->local_children().begin(); it != md->local_children().end();
+       ++it) {
+    (*record.mutable_children())[it->first] = it->second;
+  }
+
+  if (md->get_todelete().size()) {
+    // the listing is not settled upstream
+    record.set_type(record.MD);
+  }
+
+  std::string value;
+
+  if (!record.SerializeToString(&value)) {
+    return EFAULT;
+  }
+
+  if (warmstore->put(ino, value, "w")) {
+    return EIO;
+  }
+
+  stat.warm_stored_add(1);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+metad::warm_load(fuse_ino_t ino, shared_md md)
+{
+  // called with md locked or not yet visible to others
+  std::string value;
+
+  if (!warmstore || warmstore->get(ino, value, "w")) {
+    return false;
+  }
+
+  eos::fusex::md record;
+
+  if (!record.ParseFromString(value) || (record.id() != ino) ||
+      !record.md_ino()) {
+    eos_static_err("msg=\"dropping invalid warm md record\" ino=%#lx", ino);
+    warmstore->erase(ino, "w");
+    return false;
+  }
+
+  md->local_children().clear();
+
+  for (auto it = record.children().begin(); it != record.children().end(); ++it) {
+    md->local_children()[it->first] = it->second;
+  }
+
+  record.clear_children();
+  record.set_nchildren(md->local_children().size());
+  *((*md)()) = record;
+  md->setop_none();
+  md->set_warm(time(NULL) + warmgrace, record.clock());
+  inomap.insert(record.md_ino(), ino);
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+metad::shared_md
+metad::warm_restore(fuse_ino_t ino)
+{
+  shared_md md = std::make_shared<mdx>();
+
+  if (!warm_load(ino, md)) {
+    return nullptr;
+  }
+
+  shared_md emd;
+
+  if (mdmap.retrieveTS(ino, emd)) {
+    // somebody else was faster
+    return emd;
+  }
+
+  mdmap.insertTS(ino, md);
+  stat.inodes_inc();
+  stat.inodes_ever_inc();
+  stat.warm_loaded_inc();
+  eos_static_info("ino=%#lx restored from warm md cache", ino);
+  return md;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::warm_revalidated(shared_md md)
+{
+  // called with md locked after a record has been updated from the MGM
+  if (!md->was_warm()) {
+    return;
+  }
+
+  if ((*md)()->clock() == md->warm_clock()) {
+    stat.warm_valid_inc();
+  } else {
+    stat.warm_stale_inc();
+  }
+
+  md->clear_warm();
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+metad::warm_checkpoint()
+{
+  if (!warmstore) {
+    return 0;
+  }
+
+  size_t n = 0;
+  size_t errors = 0;
+
+  for (size_t i = 0; i < pmap::nshards; ++i) {
+    std::vector<fuse_ino_t> inodes;
+    {
+      pmap::shard& s = mdmap.at(i);
+      XrdSysMutexHelper sLock(s);
+
+      for (auto it = s.begin(); it != s.end(); ++it) {
+        inodes.push_back(it->first);
+      }
+    }
+
+    for (auto ino : inodes) {
+      shared_md md;
+
+      // swapped out inodes come back through retrieve
+      if (!mdmap.retrieveTS(ino, md)) {
+        continue;
+      }
+
+      XrdSysMutexHelper mLock(md->Locker());
+
+      if (has_flush(ino)) {
+        continue;
+      }
+
+      if (warm_store(md)) {
+        errors++;
+      } else {
+        n++;
+      }
+    }
+  }
+
+  if (!errors) {
+    // only a complete checkpoint can be trusted by the next mount
+    warmstore->put("warm.clean", "1");
+  }
+
+  eos_static_warning("msg=\"warm md cache checkpoint\" inodes=%lu errors=%lu",
+                     n, errors);
+  return n;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 metad::mdcallback(ThreadAssistant& assistant)
@@ -2813,12 +3484,13 @@ metad::mdcallback(ThreadAssistant& assistant)
 
     if (rsp->type() == rsp->CONFIG) {
       if (rsp->config_().hbrate()) {
-        eos_static_warning("MGM asked us to set our heartbeat interval to %d seconds, %s dentry-messaging, %s writesizeflush, %s appname, %s mdquery versions %s and server-version=%s",
+        eos_static_warning("MGM asked us to set our heartbeat interval to %d seconds, %s dentry-messaging, %s writesizeflush, %s appname, %s mdquery, %s mdbatch versions %s and server-version=%s",
                            rsp->config_().hbrate(),
                            rsp->config_().dentrymessaging() ? "enable" : "disable",
                            rsp->config_().writesizeflush() ?  "enable" : "disable",
                            rsp->config_().appname() ? "accepts" : "rejects",
                            rsp->config_().mdquery() ? "accepts" : "rejects",
+                           rsp->config_().mdbatch() ? "accepts" : "rejects",
                            rsp->config_().hideversion() ? "hidden" : "visible",
                            rsp->config_().serverversion().c_str());
         XrdSysMutexHelper cLock(EosFuse::Instance().mds.ConfigMutex);
@@ -2826,6 +3498,7 @@ metad::mdcallback(ThreadAssistant& assistant)
         EosFuse::Instance().mds.writesizeflush = rsp->config_().writesizeflush();
         EosFuse::Instance().mds.appname = rsp->config_().appname();
         EosFuse::Instance().mds.mdquery = rsp->config_().mdquery();
+        EosFuse::Instance().mds.mdbatch = rsp->config_().mdbatch();
         EosFuse::Instance().mds.hideversion = rsp->config_().hideversion();
         EosFuse::Instance().mds.hb_interval = (int) rsp->config_().hbrate();
 
@@ -2842,6 +3515,8 @@ metad::mdcallback(ThreadAssistant& assistant)
       uint64_t ino = inomap.forward(md_ino);
       uint64_t pt_mtime = rsp->dentry_().pt_mtime();
       uint64_t pt_mtime_ns = rsp->dentry_().pt_mtime_ns();
+      uint64_t pt_base_mtime = rsp->dentry_().pt_base_mtime();
+      uint64_t pt_base_mtime_ns = rsp->dentry_().pt_base_mtime_ns();
 
       if (rsp->dentry_().type() == rsp->dentry_().ADD) {
       } else if (rsp->dentry_().type() == rsp->dentry_().REMOVE) {
@@ -2858,6 +3533,7 @@ metad::mdcallback(ThreadAssistant& assistant)
         if (ino && mdmap.retrieveTS(ino, pmd)) {
           {
             XrdSysMutexHelper mLock(pmd->Locker());
+            check_delta_base(pmd, pt_base_mtime, pt_base_mtime_ns);
 
             if (pmd->local_children().count(
                   eos::common::StringConversion::EncodeInvalidUTF8(name))) {
@@ -3135,6 +3811,9 @@ metad::mdcallback(ThreadAssistant& assistant)
         shared_md pmd;
 
         if (pino && mdmap.retrieveTS(pino, pmd)) {
+          check_delta_base(pmd, (*md)()->pt_base_mtime(),
+                           (*md)()->pt_base_mtime_ns());
+
           if ((*md)()->pt_mtime()) {
             (*pmd)()->set_mtime((*md)()->pt_mtime());
             (*pmd)()->set_mtime_ns((*md)()->pt_mtime_ns());
@@ -3144,6 +3823,8 @@ metad::mdcallback(ThreadAssistant& assistant)
 
           (*md)()->clear_pt_mtime();
           (*md)()->clear_pt_mtime_ns();
+          (*md)()->clear_pt_base_mtime();
+          (*md)()->clear_pt_base_mtime_ns();
           inomap.insert((*md)()->md_ino(), (*md)()->id());
           add(0, pmd, md, authid, true);
           // adjust local quota
@@ -3478,28 +4159,21 @@ metad::vmap::backward(fuse_ino_t lookup)
 }
 
 
-/* -------------------------------------------------------------------------- */
-size_t
-metad::pmap::sizeTS()
-{
-  XrdSysMutexHelper mLock(this);
-  return size();
-}
-
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
+  shard& s = shards.shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (this->retrieve(ino, ret)) {
+  if (s.retrieve(ino, ret)) {
     return false;
   }
 
   ret = std::make_shared<mdx>();
 
   if (ino) {
-    (*this)[ino] = ret;
+    s[ino] = ret;
   }
 
   return true;
@@ -3509,13 +4183,57 @@ metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 bool
 metad::pmap::retrieveTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
-  return this->retrieve(ino, ret);
+  shard& s = shards.shard(ino);
+  XrdSysMutexHelper mLock(s);
+  return s.retrieve(ino, ret);
 }
 
 /* -------------------------------------------------------------------------- */
 bool
-metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
+metad::pmap::countTS(fuse_ino_t ino)
+{
+  shard& s = shards.shard(ino);
+  XrdSysMutexHelper mLock(s);
+  return s.count(ino);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::pmap::lru_resetTS()
+{
+  for (size_t i = 0; i < nshards; ++i) {
+    XrdSysMutexHelper mLock(shards.at(i));
+    shards.at(i).lru_reset();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+metad::shared_md
+metad::pmap::resetTS()
+{
+  // all shards are locked in index order
+  for (size_t i = 0; i < nshards; ++i) {
+    shards.at(i).Lock();
+  }
+
+  shared_md md1 = shards.shard(1)[1];
+
+  for (size_t i = 0; i < nshards; ++i) {
+    shards.at(i).clear();
+  }
+
+  shards.shard(1)[1] = md1;
+
+  for (size_t i = 0; i < nshards; ++i) {
+    shards.at(i).UnLock();
+  }
+
+  return md1;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+metad::pmap::shard::retrieve(fuse_ino_t ino, shared_md& ret)
 {
   auto it = this->find(ino);
 
@@ -3561,21 +4279,21 @@ metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
 
 /* -------------------------------------------------------------------------- */
 uint64_t
-metad::pmap::lru_oldest() const
+metad::pmap::shard::lru_oldest() const
 {
   return lru_last;
 }
 
 /* -------------------------------------------------------------------------- */
 uint64_t
-metad::pmap::lru_newest() const
+metad::pmap::shard::lru_newest() const
 {
   return lru_first;
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_add(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::lru_add(fuse_ino_t ino, shared_md md)
 {
   if (ino <= 1) {
     return;
@@ -3607,7 +4325,7 @@ metad::pmap::lru_add(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_remove(fuse_ino_t ino)
+metad::pmap::shard::lru_remove(fuse_ino_t ino)
 {
   if (ino <= 1) {
     return;
@@ -3663,7 +4381,7 @@ metad::pmap::lru_remove(fuse_ino_t ino)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_update(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::lru_update(fuse_ino_t ino, shared_md md)
 {
   if (ino == 1) {
     return;
@@ -3709,7 +4427,7 @@ metad::pmap::lru_update(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_dump(bool force)
+metad::pmap::shard::lru_dump(bool force)
 {
   if (!EOS_LOGS_DEBUG && !force) {
     return;
@@ -3756,7 +4474,7 @@ metad::pmap::lru_dump(bool force)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_reset()
+metad::pmap::shard::lru_reset()
 {
   eos_static_crit("resetting LRU list");
   // force an output of that list
@@ -3856,7 +4574,7 @@ metad::mdx::state_deserialize(std::string& mdsstream)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_out(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::swap_out(fuse_ino_t ino, shared_md md)
 {
   // serialize an in-memory md object into the kv store
   std::string mdstream;
@@ -3892,7 +4610,7 @@ metad::pmap::swap_out(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_in(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::swap_in(fuse_ino_t ino, shared_md md)
 {
   // deserialize an in-memory md object from the kv store
   std::string mdstream;
@@ -3932,7 +4650,7 @@ metad::pmap::swap_in(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_rm(fuse_ino_t ino)
+metad::pmap::shard::swap_rm(fuse_ino_t ino)
 {
   // delete from the external KV store
   if (store) {
@@ -3959,41 +4677,43 @@ metad::pmap::swap_rm(fuse_ino_t ino)
 void
 metad::pmap::insertTS(fuse_ino_t ino, shared_md& md)
 {
-  XrdSysMutexHelper mLock(this);
-  const bool exists = this->count(ino);
+  shard& s = shards.shard(ino);
+  XrdSysMutexHelper mLock(s);
+  const bool exists = s.count(ino);
   bool same = false;
   if (exists) {
     // test is for equality of md pointer in the shared_ptr
-    same = ((*this)[ino] == md);
+    same = (s[ino] == md);
   }
 
   if (exists && !same) {
     // remove from lru if an md entry already exists for this ino
     // but we're replacing it with a different one.
-    lru_remove(ino);
+    s.lru_remove(ino);
   }
 
-  (*this)[ino] = md;
+  s[ino] = md;
   // lru list handling
 
   if (!same) {
-    lru_add(ino, md);
+    s.lru_add(ino, md);
   }
 
-  lru_dump();
+  s.lru_dump();
 }
 
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::eraseTS(fuse_ino_t ino)
 {
-  XrdSysMutexHelper mLock(this);
+  shard& s = shards.shard(ino);
+  XrdSysMutexHelper mLock(s);
   // lru list handling
-  lru_remove(ino);
+  s.lru_remove(ino);
   bool exists = false;
-  auto it = this->find(ino);
+  auto it = s.find(ino);
 
-  if ((it != this->end()) && it->first) {
+  if ((it != s.end()) && it->first) {
     exists = true;
   }
 
@@ -4003,10 +4723,10 @@ metad::pmap::eraseTS(fuse_ino_t ino)
   }
 
   if (exists) {
-    this->erase(it);
+    s.erase(it);
   }
 
-  swap_rm(ino); // ignore return code
+  s.swap_rm(ino); // ignore return code
   return exists;
 }
 
@@ -4017,29 +4737,35 @@ metad::pmap::retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd,
 {
   // Atomically retrieve md objects for an inode, and its parent.
   while (true) {
-    // In this particular case, we need to first lock mdmap, and then
-    // md.. The following algorithm is meant to avoid deadlocks with code
-    // which locks md first, and then mdmap.
+    // In this particular case, we need to first lock the shard of ino, and
+    // then md.. The following algorithm is meant to avoid deadlocks with code
+    // which locks md first, and then the inode table.
     md.reset();
     pmd.reset();
     md_name.clear();
-    XrdSysMutexHelper mLock(this);
+    bool locked = false;
+    {
+      shard& s = shards.shard(ino);
+      XrdSysMutexHelper mLock(s);
 
-    if (!retrieve(ino, md)) {
-      return; // ino not there, nothing to do
+      if (!s.retrieve(ino, md)) {
+        return; // ino not there, nothing to do
+      }
+
+      // md has been found. Can we lock it?
+      locked = md->Locker().CondLock();
     }
 
-    // md has been found. Can we lock it?
-    if (md->Locker().CondLock()) {
-      // Success!
-      retrieve((*md)()->pid(), pmd);
+    if (locked) {
+      // Success! The parent cannot change while md is locked, the shard of
+      // the parent is taken in the usual order md first, then table
+      retrieveTS((*md)()->pid(), pmd);
       md_name = (*md)()->name();
       md->Locker().UnLock();
       return;
     }
 
-    // Nope, unlock mdmap and try again.
-    mLock.UnLock();
+    // Nope, try again.
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
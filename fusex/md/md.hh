@@ -38,6 +38,7 @@
 #include "common/SymKeys.hh"
 #include "kv/kv.hh"
 #include "misc/FuseId.hh"
+#include "misc/shardedmap.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <memory>
 #include <map>
@@ -83,6 +84,8 @@ public:
       inline_size = 0;
       _lru_prev.store(0, std::memory_order_seq_cst);
       _lru_next.store(0, std::memory_order_seq_cst);
+      _warm_until.store(0, std::memory_order_seq_cst);
+      _warm_clock = 0;
     }
 
     mdx(fuse_ino_t ino) : mdx()
@@ -435,6 +438,35 @@ public:
       refresh.store(0, std::memory_order_seq_cst);
     }
 
+    // records restored from the warm md cache are served without asking
+    // the MGM until they are revalidated or their grace period is over
+    void set_warm(time_t until, uint64_t clock)
+    {
+      _warm_clock = clock;
+      _warm_until.store(until, std::memory_order_seq_cst);
+    }
+
+    bool warm() const
+    {
+      time_t until = _warm_until.load();
+      return until && (time(NULL) < until);
+    }
+
+    bool was_warm() const
+    {
+      return _warm_until.load() ? true : false;
+    }
+
+    uint64_t warm_clock() const
+    {
+      return _warm_clock;
+    }
+
+    void clear_warm()
+    {
+      _warm_until.store(0, std::memory_order_seq_cst);
+    }
+
     void set_lru_prev(uint64_t prev)
     {
       _lru_prev.store(prev, std::memory_order_seq_cst);
@@ -506,6 +538,8 @@ public:
 
     std::atomic<uint64_t> _lru_prev;
     std::atomic<uint64_t> _lru_next;
+    std::atomic<time_t> _warm_until;
+    uint64_t _warm_clock;
     eos::fusex::md proto;
 
     struct hmac_t {
@@ -562,53 +596,90 @@ public:
     XrdSysMutex mMutex;
   };
 
-  class pmap : public std::map<fuse_ino_t, shared_md>, public XrdSysMutex
+  class pmap
   //----------------------------------------------------------------------------
   {
   public:
 
-    pmap()
+    // a lock domain of the inode table, keeping its own LRU list
+    class shard : public std::map<fuse_ino_t, shared_md>, public XrdSysMutex
     {
-      lru_first = 0;
-      lru_last = 0;
-      store = 0 ;
-    }
+    public:
+
+      shard()
+      {
+        lru_first = 0;
+        lru_last = 0;
+        store = 0 ;
+      }
+
+      virtual ~shard() { }
+
+      void init(kv* _kv)
+      {
+        store = _kv;
+      }
+
+      bool retrieve(fuse_ino_t ino, shared_md& ret);
+
+      uint64_t lru_oldest() const;
+      uint64_t lru_newest() const;
+      void lru_add(fuse_ino_t ino, shared_md md);
+      void lru_remove(fuse_ino_t ino);
+      void lru_update(fuse_ino_t ino, shared_md md);
+      void lru_dump(bool force = false);
+      void lru_reset();
+
+      int swap_out(fuse_ino_t ino, shared_md md);
+      int swap_in(fuse_ino_t ino, shared_md md);
+      int swap_rm(fuse_ino_t ino);
+
+    private:
+      uint64_t lru_first;
+      uint64_t lru_last;
+      kv* store;
+    };
+
+    static constexpr size_t nshards = shardedmap<shard>::nshards;
+
+    pmap() { }
 
     void init(kv* _kv)
     {
-      store = _kv;
+      for (size_t i = 0; i < nshards; ++i) {
+        shards.at(i).init(_kv);
+      }
     }
 
     virtual ~pmap() { }
 
     // TS stands for "thread-safe"
 
-    size_t sizeTS();
+    size_t sizeTS()
+    {
+      return shards.sizeTS();
+    }
 
     bool retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret);
     bool retrieveTS(fuse_ino_t ino, shared_md& ret);
-    bool retrieve(fuse_ino_t ino, shared_md& ret);
+    bool countTS(fuse_ino_t ino);
     void insertTS(fuse_ino_t ino, shared_md& md);
     bool eraseTS(fuse_ino_t ino);
     void retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd,
                               std::string& md_name);
 
-    uint64_t lru_oldest() const;
-    uint64_t lru_newest() const;
-    void lru_add(fuse_ino_t ino, shared_md md);
-    void lru_remove(fuse_ino_t ino);
-    void lru_update(fuse_ino_t ino, shared_md md);
-    void lru_dump(bool force = false);
-    void lru_reset();
+    void lru_resetTS();
 
-    int swap_out(fuse_ino_t ino, shared_md md);
-    int swap_in(fuse_ino_t ino, shared_md md);
-    int swap_rm(fuse_ino_t ino);
+    // drop all entries but the root, returns the root entry
+    shared_md resetTS();
+
+    shard& at(size_t i)
+    {
+      return shards.at(i);
+    }
 
   private:
-    uint64_t lru_first;
-    uint64_t lru_last;
-    kv* store;
+    shardedmap<shard> shards;
   };
 
   //----------------------------------------------------------------------------
@@ -683,6 +754,8 @@ public:
           std::string newname,
           std::string authid1, std::string authid2);
 
+  // recursive delete of a directory tree with a single MGM request, called
+  // with md unlocked - returns EAGAIN if local changes below md are unflushed
   int rmrf(fuse_req_t req, shared_md md);
 
   std::string dump_md(shared_md md, bool lock = true);
@@ -698,15 +771,28 @@ public:
 
   void mdcflush(ThreadAssistant& assistant); // thread pushing into md cache
 
+  void mdcflush_worker(ThreadAssistant&
+                       assistant); // worker pushing md updates upstream
+
   void mdcommunicate(ThreadAssistant&
                      assistant); // thread interacting with the MGM for meta data
 
   void mdcallback(ThreadAssistant&
                   assistant); // thread applying MGM callback responses
 
+  // verify that the listing of pmd is the one a delta applies to
+  void check_delta_base(shared_md pmd, uint64_t base_mtime,
+                        uint64_t base_mtime_ns);
+
   void mdstackfree(ThreadAssistant&
                    assistant); // thread removing stacked inodes
 
+  // attach the persistent md cache used for warm remounts
+  void warm_init(kv* store, int grace);
+
+  // write all resident inodes to the persistent md cache at unmount
+  size_t warm_checkpoint();
+
   int connect(std::string zmqtarget, std::string zmqidentity = "",
               std::string zmqname = "", std::string zmqclienthost = "",
               std::string zmqclientuuid = "");
@@ -738,6 +824,14 @@ public:
       _inodes_deleted_ever.store(0, std::memory_order_seq_cst);
       _inodes_backlog.store(0, std::memory_order_seq_cst);
       _lru_resets.store(0, std::memory_order_seq_cst);
+      _dentry_deltas.store(0, std::memory_order_seq_cst);
+      _dentry_fallbacks.store(0, std::memory_order_seq_cst);
+      _warm_loaded.store(0, std::memory_order_seq_cst);
+      _warm_valid.store(0, std::memory_order_seq_cst);
+      _warm_stale.store(0, std::memory_order_seq_cst);
+      _warm_stored.store(0, std::memory_order_seq_cst);
+      _rmrf_bulk.store(0, std::memory_order_seq_cst);
+      _rmrf_dropped.store(0, std::memory_order_seq_cst);
     }
 
     void inodes_inc()
@@ -780,6 +874,46 @@ public:
       _lru_resets.fetch_add(1, std::memory_order_seq_cst);
     }
 
+    void dentry_deltas_inc()
+    {
+      _dentry_deltas.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void dentry_fallbacks_inc()
+    {
+      _dentry_fallbacks.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void warm_loaded_inc()
+    {
+      _warm_loaded.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void warm_valid_inc()
+    {
+      _warm_valid.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void warm_stale_inc()
+    {
+      _warm_stale.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void warm_stored_add(ssize_t n)
+    {
+      _warm_stored.fetch_add(n, std::memory_order_seq_cst);
+    }
+
+    void rmrf_bulk_inc()
+    {
+      _rmrf_bulk.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void rmrf_dropped_add(ssize_t n)
+    {
+      _rmrf_dropped.fetch_add(n, std::memory_order_seq_cst);
+    }
+
     void inodes_deleted_dec()
     {
       _inodes_deleted.fetch_sub(1, std::memory_order_seq_cst);
@@ -826,6 +960,46 @@ public:
       return _lru_resets.load();
     }
 
+    ssize_t dentry_deltas()
+    {
+      return _dentry_deltas.load();
+    }
+
+    ssize_t dentry_fallbacks()
+    {
+      return _dentry_fallbacks.load();
+    }
+
+    ssize_t warm_loaded()
+    {
+      return _warm_loaded.load();
+    }
+
+    ssize_t warm_valid()
+    {
+      return _warm_valid.load();
+    }
+
+    ssize_t warm_stale()
+    {
+      return _warm_stale.load();
+    }
+
+    ssize_t warm_stored()
+    {
+      return _warm_stored.load();
+    }
+
+    ssize_t rmrf_bulk()
+    {
+      return _rmrf_bulk.load();
+    }
+
+    ssize_t rmrf_dropped()
+    {
+      return _rmrf_dropped.load();
+    }
+
   private:
     std::atomic<ssize_t> _inodes;
     std::atomic<ssize_t> _inodes_stacked;
@@ -834,6 +1008,14 @@ public:
     std::atomic<ssize_t> _inodes_ever;
     std::atomic<ssize_t> _inodes_deleted_ever;
     std::atomic<ssize_t> _lru_resets;
+    std::atomic<ssize_t> _dentry_deltas;
+    std::atomic<ssize_t> _dentry_fallbacks;
+    std::atomic<ssize_t> _warm_loaded;
+    std::atomic<ssize_t> _warm_valid;
+    std::atomic<ssize_t> _warm_stale;
+    std::atomic<ssize_t> _warm_stored;
+    std::atomic<ssize_t> _rmrf_bulk;
+    std::atomic<ssize_t> _rmrf_dropped;
   };
 
   mdstat& stats()
@@ -848,12 +1030,9 @@ public:
 
   void mdreset()
   {
-    XrdSysMutexHelper lock(mdmap);
-    shared_md md1 = mdmap[1];
+    shared_md md1 = mdmap.resetTS();
     (*md1)()->set_type((*md1)()->MD);
     md1->force_refresh();
-    mdmap.clear();
-    mdmap[1] = md1;
     uint64_t i_root = inomap.backward(1);
     inomap.clear();
     inomap.insert(i_root, 1);
@@ -862,7 +1041,7 @@ public:
   void lrureset()
   {
     stat.lru_resets_inc();
-    mdmap.lru_reset();
+    mdmap.lru_resetTS();
   }
 
   void
@@ -967,6 +1146,30 @@ public:
       _fuse_id.bind();
     }
 
+    // the entry can only be flushed after the entries of this inode
+    // queued before it, typically the creation of the parent directory
+    void depend_on(uint64_t id)
+    {
+      _depend = id;
+    }
+
+    uint64_t depends() const
+    {
+      return _depend;
+    }
+
+    // the entry is flushed alone, after all the entries queued before it
+    // and before all the entries queued after it
+    void set_barrier()
+    {
+      _barrier = true;
+    }
+
+    bool barrier() const
+    {
+      return _barrier;
+    }
+
     static std::deque<flushentry> merge(std::deque<flushentry>& f)
     {
       return f;
@@ -988,6 +1191,8 @@ public:
     std::string _authid;
     mdx::md_op _op;
     fuse_id _fuse_id;
+    uint64_t _depend{0};
+    bool _barrier{false};
   };
 
   typedef std::deque<flushentry> flushentry_set_t;
@@ -1036,6 +1241,12 @@ public:
     return mdquery;
   }
 
+  bool supports_mdbatch()
+  {
+    XrdSysMutexHelper cLock(ConfigMutex);
+    return mdbatch;
+  }
+
   bool supports_hideversion()
   {
     XrdSysMutexHelper cLock(ConfigMutex);
@@ -1084,6 +1295,17 @@ private:
   bool determineLockOrder(shared_md md1, shared_md md2);
   bool isChild(shared_md potentialChild, fuse_ino_t parentId);
 
+  // warm md cache helpers, called with md locked
+  int warm_store(shared_md md);
+  bool warm_load(fuse_ino_t ino, shared_md md);
+  void warm_revalidated(shared_md md);
+
+  // restore an inode from the warm md cache and attach it to the table
+  shared_md warm_restore(fuse_ino_t ino);
+
+  kv* warmstore;
+  int warmgrace;
+
   pmap mdmap;
   vmap inomap;
   mdstat stat;
@@ -1094,6 +1316,7 @@ private:
   bool writesizeflush;
   bool appname;
   bool mdquery;
+  bool mdbatch;
   bool hideversion;
   std::atomic<int>  hb_interval;
 
@@ -1103,7 +1326,23 @@ private:
 
   std::map<uint64_t, size_t> mdqueue; // inode, counter of mds to flush
   std::deque<flushentry> mdflushqueue; // linear queue with all entries to flush
-  uint64_t mdqueue_current{0}; // ino of entry currently being flushed
+  std::set<uint64_t> mdqueue_inflight; // inodes currently being flushed
+  bool mdqueue_barrier{false}; // a barrier entry is currently being flushed
+
+  // pick the next entries which can be flushed, called with mdflush locked
+  bool mdflush_pick(std::vector<flushentry>& entries);
+
+  // push one or more merged flush entries of the same inode upstream
+  void mdflush_entry(const flushentry& fe, size_t merged);
+
+  // push the flush entries of several inodes upstream in one request
+  void mdflush_batch(const std::vector<flushentry>& fes);
+
+  // check if an entry can be pushed in the same request as the first one
+  bool mdflush_batchable(const flushentry& first, const flushentry& fe);
+
+  // fill in the remote parent inode if it was unknown when queueing
+  void mdflush_pino(shared_md md);
 
   typedef std::shared_ptr<eos::fusex::response> shared_response;
   std::deque<shared_response> mCbQueue; // queue will callbacks
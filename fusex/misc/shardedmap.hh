@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+//! @file shardedmap.hh
+//! @brief inode keyed table split into independently locked shards
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_SHARDEDMAP_HH_
+#define FUSE_SHARDEDMAP_HH_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* -------------------------------------------------------------------------- */
+/* The FUSE worker threads look up, create and forget inodes concurrently.    */
+/* Instead of one map behind one mutex, the table is split into 2^bits shards */
+/* each carrying its own lock, so that operations on different inodes rarely  */
+/* wait for each other. S is the shard type and has to provide the map and    */
+/* the XrdSysMutex interface. Inode numbers have their low bits often zero,   */
+/* so the shard is chosen by a multiplicative hash of the whole number.       */
+/* Operations touching two inodes lock the shards in index order.             */
+/* -------------------------------------------------------------------------- */
+
+template<class S, unsigned int bits = 6>
+class shardedmap
+{
+public:
+  static constexpr size_t nshards = (1ul << bits);
+
+  shardedmap() { }
+
+  virtual ~shardedmap() { }
+
+  static size_t index(uint64_t ino)
+  {
+    return (size_t)((ino * 0x9e3779b97f4a7c15ull) >> (64 - bits));
+  }
+
+  S& shard(uint64_t ino)
+  {
+    return shards[index(ino)];
+  }
+
+  S& at(size_t i)
+  {
+    return shards[i];
+  }
+
+  size_t sizeTS()
+  {
+    size_t n = 0;
+
+    for (size_t i = 0; i < nshards; ++i) {
+      shards[i].Lock();
+      n += shards[i].size();
+      shards[i].UnLock();
+    }
+
+    return n;
+  }
+
+  // lock the shards of two inodes without risking a dead-lock
+  void lock2(uint64_t ino1, uint64_t ino2)
+  {
+    size_t i1 = index(ino1);
+    size_t i2 = index(ino2);
+
+    if (i1 == i2) {
+      shards[i1].Lock();
+    } else if (i1 < i2) {
+      shards[i1].Lock();
+      shards[i2].Lock();
+    } else {
+      shards[i2].Lock();
+      shards[i1].Lock();
+    }
+  }
+
+  void unlock2(uint64_t ino1, uint64_t ino2)
+  {
+    size_t i1 = index(ino1);
+    size_t i2 = index(ino2);
+    shards[i1].UnLock();
+
+    if (i1 != i2) {
+      shards[i2].UnLock();
+    }
+  }
+
+private:
+  S shards[nshards];
+};
+
+#endif /* FUSE_SHARDEDMAP_HH_ */
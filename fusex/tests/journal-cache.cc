@@ -127,6 +127,46 @@ TEST(JournalCache, BasicSanity)
   ASSERT_EQ(rc, (int64_t) truncsize);
 }
 
+TEST(JournalCache, WriteBackCoalescing)
+{
+  cacheconfig config;
+  config.journal = "/tmp/";
+  config.location = "/tmp/";
+  config.per_file_journal_max_size = journalcache::sDefaultMaxSize;
+  config.journal_writeback_size = 16384;
+  journalcache::init(config);
+  journalcache jc(6);
+  std::string cookie = "";
+  fuse_req_t req = 0;
+  ASSERT_EQ(jc.attach(req, cookie, true), 0);
+  ASSERT_EQ(jc.truncate(0), 0);
+  std::string data = random_str(4096);
+  uint64_t held = journalcache::writeback_held();
+  // adjacent writes are merged into a single range
+  ASSERT_EQ(jc.pwrite(data.c_str(), 4096, 0, true), 4096);
+  ASSERT_EQ(jc.pwrite(data.c_str(), 4096, 4096, true), 4096);
+  ASSERT_EQ(jc.writeback_bytes(), 8192u);
+  ASSERT_FALSE(jc.writeback_due());
+  // overwrites do not add bytes
+  ASSERT_EQ(jc.pwrite(data.c_str(), 1024, 2048, true), 1024);
+  ASSERT_EQ(jc.writeback_bytes(), 8192u);
+  // writes not kept for write-back are not accounted
+  ASSERT_EQ(jc.pwrite(data.c_str(), 4096, 65536), 4096);
+  ASSERT_EQ(jc.writeback_bytes(), 8192u);
+  // a disjoint range and a write bridging the gap
+  ASSERT_EQ(jc.pwrite(data.c_str(), 4096, 12288, true), 4096);
+  ASSERT_EQ(jc.writeback_bytes(), 12288u);
+  ASSERT_EQ(jc.pwrite(data.c_str(), 4096, 8192, true), 4096);
+  ASSERT_EQ(jc.writeback_bytes(), 16384u);
+  ASSERT_TRUE(jc.writeback_due());
+  ASSERT_EQ(journalcache::writeback_held() - held, 5u);
+  // a truncation to zero drops the kept ranges
+  ASSERT_EQ(jc.truncate(0), 0);
+  ASSERT_EQ(jc.writeback_bytes(), 0u);
+  ASSERT_FALSE(jc.writeback_due());
+  ASSERT_EQ(jc.detach(cookie), 0);
+}
+
 const std::string TestData::input =
   "Miusov, as a man man of breeding and deilcacy, could not but feel some inwrd qualms, when he reached the Father Superior's with Ivan: he felt ashamed of havin lost his temper. He felt that he ought to have disdaimed that despicable wretch, Fyodor Pavlovitch, too much to have been upset by him in Father Zossima's cell, and so to have forgotten himself. \"Teh monks were not to blame, in any case,\" he reflceted, on the steps. \"And if they're decent people here (and the Father Superior, I understand, is a nobleman) why not be friendly and courteous withthem? I won't argue, I'll fall in with everything, I'll win them by politness, and show them that I've nothing to do with that Aesop, thta buffoon, that Pierrot, and have merely been takken in over this affair, just as they have.\""
   "He determined to drop his litigation with the monastry, and relinguish his claims to the wood-cuting and fishery rihgts at once. He was the more ready to do this becuase the rights had becom much less valuable, and he had indeed the vaguest idea where the wood and river in quedtion were."
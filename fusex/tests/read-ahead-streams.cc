@@ -0,0 +1,179 @@
+//------------------------------------------------------------------------------
+//! @file read-ahead-streams.cc
+//! @brief tests for the stream detection of the adaptive read-ahead
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "data/readaheadstreams.hh"
+
+TEST(ReadAheadStreams, Sequential)
+{
+  readaheadstreams ra;
+  ra.configure(4096, 65536, 1024 * 1024, 16, 1024 * 1024 * 1024ll);
+  std::vector<readaheadstreams::chunk_t> chunks;
+  bool vector = true;
+  int evicted;
+  int s = ra.access(0, 4096, evicted);
+  ASSERT_EQ(evicted, -1);
+  // a single read does not trigger a prefetch
+  ASSERT_FALSE(ra.plan(s, chunks, vector));
+  ASSERT_EQ(ra.access(4096, 4096, evicted), s);
+  ASSERT_TRUE(ra.plan(s, chunks, vector));
+  ASSERT_FALSE(vector);
+  ASSERT_EQ(chunks.size(), 2u);
+  ASSERT_EQ(chunks[0].offset, 8192);
+  ASSERT_EQ(chunks[0].size, 65536u);
+  ASSERT_EQ(chunks[1].offset, 8192 + 65536);
+  ra.prefetched(s, chunks, chunks.size());
+  ASSERT_EQ(ra.get(s).ra_position, 8192 + 2 * 65536);
+  // the window slides with the reader, prefetched blocks are not repeated
+  ASSERT_EQ(ra.access(8192, 4096, evicted), s);
+  ASSERT_TRUE(ra.plan(s, chunks, vector));
+  ASSERT_EQ(chunks.size(), 1u);
+  ASSERT_EQ(chunks[0].offset, 8192 + 2 * 65536);
+  ASSERT_EQ(ra.active(), 1u);
+  ASSERT_EQ(ra.ra_bytes(), 2 * 65536u);
+}
+
+TEST(ReadAheadStreams, Interleaved)
+{
+  readaheadstreams ra;
+  ra.configure(4096, 65536, 1024 * 1024, 16, 1024 * 1024 * 1024ll);
+  int evicted;
+  // three interleaved sequential readers far apart
+  off_t base[3] = {0, 100 * 1024 * 1024, 500 * 1024 * 1024};
+  int s[3];
+
+  for (int i = 0; i < 3; ++i) {
+    s[i] = ra.access(base[i], 16384, evicted);
+    ASSERT_EQ(evicted, -1);
+  }
+
+  ASSERT_NE(s[0], s[1]);
+  ASSERT_NE(s[1], s[2]);
+
+  for (int n = 1; n < 10; ++n) {
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_EQ(ra.access(base[i] + n * 16384, 16384, evicted), s[i]);
+      ASSERT_EQ(evicted, -1);
+    }
+  }
+
+  ASSERT_EQ(ra.active(), 3u);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(ra.get(s[i]).seq, 10u);
+    ASSERT_EQ(ra.get(s[i]).stride, 0);
+  }
+}
+
+TEST(ReadAheadStreams, Strided)
+{
+  readaheadstreams ra;
+  ra.configure(4096, 65536, 1024 * 1024, 4, 1024 * 1024 * 1024ll);
+  std::vector<readaheadstreams::chunk_t> chunks;
+  bool vector = false;
+  int evicted;
+  int s = ra.access(0, 1000, evicted);
+  ASSERT_EQ(ra.access(10000, 1000, evicted), s);
+  ASSERT_EQ(ra.get(s).stride, 10000);
+  // the stride has to be confirmed once
+  ASSERT_FALSE(ra.plan(s, chunks, vector));
+  ASSERT_EQ(ra.access(20000, 1000, evicted), s);
+  ASSERT_TRUE(ra.plan(s, chunks, vector));
+  ASSERT_TRUE(vector);
+  ASSERT_EQ(chunks.size(), 2u);
+  ASSERT_EQ(chunks[0].offset, 30000);
+  ASSERT_EQ(chunks[0].size, 1000u);
+  ASSERT_EQ(chunks[1].offset, 40000);
+  ra.prefetched(s, chunks, chunks.size());
+  ASSERT_EQ(ra.access(30000, 1000, evicted), s);
+  ASSERT_TRUE(ra.plan(s, chunks, vector));
+  ASSERT_EQ(chunks.size(), 1u);
+  ASSERT_EQ(chunks[0].offset, 50000);
+  ASSERT_FALSE(vector);
+}
+
+TEST(ReadAheadStreams, Eviction)
+{
+  readaheadstreams ra;
+  ra.configure(4096, 65536, 1024 * 1024, 16, 1024 * 1024 * 1024ll);
+  int evicted;
+  off_t distance = 1024 * 1024 * 1024ll / 16;
+
+  for (size_t i = 0; i < readaheadstreams::max_streams; ++i) {
+    ra.access(i * distance, 4096, evicted);
+    ASSERT_EQ(evicted, -1);
+  }
+
+  // keep the first stream alive, the second one is the oldest
+  int first = ra.access(4096, 4096, evicted);
+  ASSERT_EQ(evicted, -1);
+  int s = ra.access(15 * distance, 4096, evicted);
+  ASSERT_NE(evicted, -1);
+  ASSERT_NE(evicted, first);
+  ASSERT_EQ(s, evicted);
+  ASSERT_EQ(ra.get(s).last_offset, 15 * distance);
+  ASSERT_EQ(ra.active(), readaheadstreams::max_streams);
+}
+
+TEST(ReadAheadStreams, Adaptation)
+{
+  readaheadstreams ra;
+  ra.configure(4096, 65536, 1024 * 1024, 16, 1024 * 1024 * 1024ll);
+  int evicted;
+  int s = ra.access(0, 4096, evicted);
+  off_t offset = 4096;
+
+  // reads miss the prefetched data: the window grows
+  for (size_t i = 0; i < readaheadstreams::adapt_interval; ++i) {
+    ra.miss(s, 4096);
+    ASSERT_EQ(ra.access(offset, 4096, evicted), s);
+    offset += 4096;
+  }
+
+  ASSERT_EQ(ra.get(s).window, 131072u);
+  size_t blocks = ra.get(s).blocks;
+
+  // reads wait for blocks in flight: more blocks are kept in flight
+  for (size_t i = 0; i < readaheadstreams::adapt_interval; ++i) {
+    ra.hit(s, 4096, 5.0);
+    ASSERT_EQ(ra.access(offset, 4096, evicted), s);
+    offset += 4096;
+  }
+
+  ASSERT_EQ(ra.get(s).blocks, 2 * blocks);
+  // most of the prefetched volume is wasted: the window shrinks
+  std::vector<readaheadstreams::chunk_t> chunks;
+  bool vector;
+  ASSERT_TRUE(ra.plan(s, chunks, vector));
+  ra.prefetched(s, chunks, chunks.size());
+  ra.waste(s, chunks.size() * ra.get(s).window);
+
+  for (size_t i = 0; i < readaheadstreams::adapt_interval; ++i) {
+    ra.hit(s, 4096, 0);
+    ASSERT_EQ(ra.access(offset, 4096, evicted), s);
+    offset += 4096;
+  }
+
+  ASSERT_EQ(ra.get(s).window, 65536u);
+  ASSERT_EQ(ra.get(s).blocks, blocks);
+}
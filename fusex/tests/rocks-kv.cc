@@ -60,4 +60,36 @@ TEST(RocksKV, BasicSanity)
   ASSERT_EQ(kv.inc("test", increment), -1);
 }
 
+TEST(RocksKV, Reopen)
+{
+  // the warm md cache relies on records surviving a reconnect
+  ASSERT_EQ(system("rm -rf /tmp/eos-fusex-tests-reopen"), 0);
+  eos::fusex::md record;
+  record.set_id(0x1234);
+  record.set_md_ino(0x1234);
+  record.set_clock(42);
+  record.set_type(record.MDLS);
+  (*record.mutable_children())["file"] = 0x5678;
+  std::string value;
+  ASSERT_TRUE(record.SerializeToString(&value));
+  {
+    RocksKV kv;
+    ASSERT_EQ(kv.connect("myprefix", "/tmp/eos-fusex-tests-reopen"), 0);
+    ASSERT_EQ(kv.put(0x1234, value, "w"), 0);
+    ASSERT_EQ(kv.put("warm.clean", "1"), 0);
+  }
+  RocksKV kv;
+  ASSERT_EQ(kv.connect("myprefix", "/tmp/eos-fusex-tests-reopen"), 0);
+  std::string tmp;
+  ASSERT_EQ(kv.get("warm.clean", tmp), 0);
+  ASSERT_EQ(tmp, "1");
+  ASSERT_EQ(kv.get(0x1234, tmp, "w"), 0);
+  eos::fusex::md reread;
+  ASSERT_TRUE(reread.ParseFromString(tmp));
+  ASSERT_EQ(reread.clock(), 42u);
+  ASSERT_EQ(reread.type(), reread.MDLS);
+  ASSERT_EQ(reread.children().at("file"), 0x5678u);
+  ASSERT_EQ(kv.get(0x1235, tmp, "w"), 1);
+}
+
 #endif // HAVE_ROCKSDB
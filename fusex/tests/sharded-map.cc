@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+//! @file sharded-map.cc
+//! @brief tests for the lock-sharded inode table
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "misc/shardedmap.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+class testshard : public std::map<uint64_t, uint64_t>, public XrdSysMutex
+{
+};
+
+TEST(ShardedMap, Distribution)
+{
+  shardedmap<testshard> map;
+  std::set<size_t> used;
+
+  // file inodes are fid << 28 and have all low bits zero
+  for (uint64_t fid = 1; fid <= 1024; ++fid) {
+    size_t i = shardedmap<testshard>::index(fid << 28);
+    ASSERT_LT(i, shardedmap<testshard>::nshards);
+    used.insert(i);
+  }
+
+  ASSERT_EQ(used.size(), shardedmap<testshard>::nshards);
+}
+
+TEST(ShardedMap, Concurrent)
+{
+  shardedmap<testshard> map;
+  std::vector<std::thread> workers;
+  const uint64_t n = 10000;
+
+  for (uint64_t t = 0; t < 8; ++t) {
+    workers.emplace_back([&map, t, n]() {
+      for (uint64_t ino = t * n; ino < (t + 1) * n; ++ino) {
+        testshard& s = map.shard(ino);
+        XrdSysMutexHelper mLock(s);
+        s[ino] = ino;
+      }
+
+      // move entries between shards as an unlink does
+      for (uint64_t ino = t * n; ino < (t + 1) * n; ino += 2) {
+        map.lock2(ino, ino + 0xffffffff);
+        map.shard(ino + 0xffffffff)[ino + 0xffffffff] = map.shard(ino)[ino];
+        map.shard(ino).erase(ino);
+        map.unlock2(ino, ino + 0xffffffff);
+      }
+    });
+  }
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  ASSERT_EQ(map.sizeTS(), 8 * n);
+  testshard& s = map.shard(2 + 0xffffffffull);
+  ASSERT_EQ(s[2 + 0xffffffffull], 2u);
+  ASSERT_FALSE(map.shard(2).count(2));
+  ASSERT_TRUE(map.shard(3).count(3));
+}
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+//! @file shared-cache.cc
+//! @brief tests for the host-wide shared block cache
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "data/sharedcache.hh"
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+class SharedCacheF : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    char tmpl[] = "/tmp/eos-fusex-sharedcache-XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpl));
+    location = tmpl;
+    config.shared_location = location;
+    config.shared_cache_size = 64 * 1024 * 1024;
+    config.shared_block_size = 4096;
+  }
+
+  virtual void TearDown()
+  {
+    std::string rm = "rm -rf " + location;
+    (void) system(rm.c_str());
+  }
+
+  size_t count_entries(const std::string& path)
+  {
+    size_t n = 0;
+    DIR* dir = opendir(path.c_str());
+
+    if (!dir) {
+      return 0;
+    }
+
+    struct dirent* entry;
+
+    while ((entry = readdir(dir))) {
+      if (entry->d_name[0] != '.') {
+        n++;
+      }
+    }
+
+    closedir(dir);
+    return n;
+  }
+
+  std::string location;
+  cacheconfig config;
+};
+
+TEST_F(SharedCacheF, PutAndRead)
+{
+  sharedcache sc;
+  ASSERT_EQ(sc.init(config), 0);
+  ASSERT_TRUE(sc.enabled());
+  ASSERT_EQ(sc.blocksize(), 4096u);
+  std::string etag = sharedcache::etag("mgm:1094", 1000, 1, 8192);
+  char block[4096];
+  char out[4096];
+
+  for (size_t i = 0; i < sizeof(block); ++i) {
+    block[i] = i % 251;
+  }
+
+  ASSERT_EQ(sc.read(0x1234, etag, 0, out, 100, 0), -1);
+  ASSERT_EQ(sc.put(0x1234, etag, 0, block, sizeof(block)), 0);
+  ASSERT_EQ(sc.read(0x1234, etag, 0, out, 100, 1000), 100);
+  ASSERT_EQ(memcmp(out, block + 1000, 100), 0);
+  // a read beyond the stored block is a miss
+  ASSERT_EQ(sc.read(0x1234, etag, 0, out, 100, 4000), -1);
+  // another version of the file does not see the block
+  std::string etag2 = sharedcache::etag("mgm:1094", 1001, 1, 8192);
+  ASSERT_EQ(sc.read(0x1234, etag2, 0, out, 100, 0), -1);
+  // another instance does not see the block
+  std::string etag3 = sharedcache::etag("othermgm:1094", 1000, 1, 8192);
+  ASSERT_EQ(sc.read(0x1234, etag3, 0, out, 100, 0), -1);
+  sharedcache::stats_t stats = sc.get_stats();
+  ASSERT_EQ(stats.hits, 1u);
+  ASSERT_EQ(stats.hit_bytes, 100u);
+  ASSERT_EQ(stats.stored, 1u);
+  ASSERT_EQ(stats.dedup, 0u);
+}
+
+TEST_F(SharedCacheF, Dedup)
+{
+  sharedcache sc;
+  ASSERT_EQ(sc.init(config), 0);
+  char block[4096];
+  char out[4096];
+  memset(block, 'x', sizeof(block));
+  std::string etag = sharedcache::etag("mgm:1094", 1000, 1, 4096);
+  ASSERT_EQ(sc.put(1, etag, 0, block, sizeof(block)), 0);
+  ASSERT_EQ(sc.put(2, etag, 0, block, sizeof(block)), 0);
+  ASSERT_EQ(sc.put(3, etag, 0, block, sizeof(block)), 0);
+  ASSERT_EQ(sc.read(2, etag, 0, out, sizeof(out), 0), (ssize_t) sizeof(out));
+  ASSERT_EQ(memcmp(out, block, sizeof(block)), 0);
+  sharedcache::stats_t stats = sc.get_stats();
+  ASSERT_EQ(stats.stored, 1u);
+  ASSERT_EQ(stats.dedup, 2u);
+}
+
+TEST_F(SharedCacheF, Remount)
+{
+  char block[4096];
+  char out[4096];
+  memset(block, 'y', sizeof(block));
+  std::string etag = sharedcache::etag("mgm:1094", 1000, 1, 4096);
+  {
+    sharedcache sc;
+    ASSERT_EQ(sc.init(config), 0);
+    ASSERT_EQ(sc.put(7, etag, 0, block, sizeof(block)), 0);
+  }
+  // a second process using the same location finds the block
+  sharedcache sc;
+  ASSERT_EQ(sc.init(config), 0);
+  ASSERT_EQ(sc.read(7, etag, 0, out, sizeof(out), 0), (ssize_t) sizeof(out));
+  ASSERT_EQ(memcmp(out, block, sizeof(block)), 0);
+}
+
+TEST_F(SharedCacheF, EvictedBlocks)
+{
+  sharedcache sc;
+  ASSERT_EQ(sc.init(config), 0);
+  char block[4096];
+  char out[4096];
+  std::string etag = sharedcache::etag("mgm:1094", 1000, 1, 3 * 4096);
+
+  for (uint64_t b = 0; b < 3; ++b) {
+    memset(block, 'a' + b, sizeof(block));
+    ASSERT_EQ(sc.put(9, etag, b, block, sizeof(block)), 0);
+  }
+
+  // evict all blocks as the dircleaner would do
+  std::string rm = "rm -rf " + location + "/data/*";
+  ASSERT_EQ(system(rm.c_str()), 0);
+  // a read drops the dangling index entry, the sweep removes the others
+  ASSERT_EQ(sc.read(9, etag, 0, out, sizeof(out), 0), -1);
+  std::string index = location + "/index/009";
+  ASSERT_EQ(count_entries(index), 2u);
+  sc.sweep();
+  ASSERT_EQ(count_entries(index), 0u);
+}
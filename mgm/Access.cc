@@ -86,6 +86,12 @@ std::atomic<bool> Access::gStallWrite {false};
 //! indicates a user or group rate stall entry
 std::atomic<bool> Access::gStallUserGroup {false};
 
+//! indicates an admission control entry
+std::atomic<bool> Access::gStallAdmission {false};
+
+//! version of the stall rules incremented on every update
+std::atomic<uint64_t> Access::gStallRulesVersion {0};
+
 //! singleton map for UID based redirection (not used yet)
 std::map<uid_t, std::string> Access::gUserRedirection;
 
@@ -167,6 +173,8 @@ Access::Reset(bool skip_stall_redirect)
     Access::gGroupRedirection.clear();
     Access::gStallGlobal = Access::gStallRead =
                              Access::gStallWrite = Access::gStallUserGroup = false;
+    Access::gStallAdmission = false;
+    ++Access::gStallRulesVersion;
   }
 }
 
@@ -319,7 +327,8 @@ Access::ApplyAccessConfig(bool applyredirectandstall)
   for (size_t i = 0; i < tokens.size(); ++i) {
     if (tokens[i].length()) {
       if (applyredirectandstall || ((tokens[i].find("rate:") == 0) ||
-                                    (tokens[i].find("threads:") == 0))) {
+                                    (tokens[i].find("threads:") == 0) ||
+                                    (tokens[i].find("admission:") == 0))) {
         subtokens.clear();
         eos::common::StringConversion::Tokenize(tokens[i], subtokens,
                                                 subdelimiter);
@@ -343,6 +352,10 @@ Access::ApplyAccessConfig(bool applyredirectandstall)
             gStallUserGroup = true;
           }
 
+          if ((subtokens[0].find("admission:") == 0)) {
+            gStallAdmission = true;
+          }
+
           if (subtokens.size() == 3) {
             XrdOucString comment = subtokens[2].c_str();
 
@@ -359,6 +372,8 @@ Access::ApplyAccessConfig(bool applyredirectandstall)
     }
   }
 
+  ++gStallRulesVersion;
+
   if (applyredirectandstall) {
     tokens.clear();
     delimiter = ",";
@@ -481,6 +496,8 @@ Access::StoreAccessConfig()
   }
 
   gStallRead = gStallWrite = gStallGlobal = gStallUserGroup = false;
+  gStallAdmission = false;
+  ++gStallRulesVersion;
 
   for (itstall = Access::gStallRules.begin();
        itstall != Access::gStallRules.end(); itstall++) {
@@ -514,6 +531,10 @@ Access::StoreAccessConfig()
     if ((itstall->first.find("rate:") == 0)) {
       gStallUserGroup = true;
     }
+
+    if ((itstall->first.find("admission:") == 0)) {
+      gStallAdmission = true;
+    }
   }
 
   for (itredirect = Access::gRedirectionRules.begin();
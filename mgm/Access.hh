@@ -166,6 +166,12 @@ public:
   //! indicates a user or group rate stall entry
   static std::atomic<bool> gStallUserGroup;
 
+  //! indicates an admission control entry
+  static std::atomic<bool> gStallAdmission;
+
+  //! version of the stall rules incremented on every update
+  static std::atomic<uint64_t> gStallRulesVersion;
+
   //! indicates a list of hostname matching
   static std::set<std::string> gNoStallHosts;
 
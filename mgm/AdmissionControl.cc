@@ -0,0 +1,593 @@
+// ----------------------------------------------------------------------
+// File: AdmissionControl.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/AdmissionControl.hh"
+#include "common/StringTokenizer.hh"
+#include "common/table_formatter/TableFormatterBase.hh"
+#include "common/utils/RandUtils.hh"
+#include <cmath>
+#include <set>
+
+EOSMGMNAMESPACE_BEGIN
+
+using namespace std::chrono;
+
+namespace
+{
+//! Interval between bucket expiry attempts
+constexpr auto sExpireInterval = seconds(60);
+//! Buckets not used for this long are dropped
+constexpr auto sBucketIdle = seconds(300);
+//! All levels in the evaluation order
+const std::list<AdmissionControl::Level> sLevels {
+  AdmissionControl::Level::Global, AdmissionControl::Level::Group,
+  AdmissionControl::Level::User, AdmissionControl::Level::App
+};
+//! Metadata read operations which are never queued
+const std::set<std::string> sExemptOps {
+  "stat", "FuseStat", "exists", "access", "Access", "GetXrdAccPrivs",
+  "Statvfs", "Readlink", "readlink", "Version", "Checksum", "chksum",
+  "Getfmd", "FSctl", "Eosxd::prot::STAT", "Eosxd::prot::LS", "Eosxd::ext::LS",
+  "Eosxd::ext::LS-Entry"
+};
+}
+
+//------------------------------------------------------------------------------
+// Apply configuration from the access stall rules
+//------------------------------------------------------------------------------
+void
+AdmissionControl::Configure(const std::map<std::string, std::string>& rules,
+                            uint64_t version)
+{
+  if (mVersion == version) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mRules.clear();
+  mMaxQueueDepth = 1000;
+  mMaxWait = milliseconds(200);
+  mMaxStallSec = 60;
+
+  for (const auto& elem : rules) {
+    if (elem.first.find(sRulePrefix) != 0) {
+      continue;
+    }
+
+    auto tokens = eos::common::StringTokenizer::split<std::vector<std::string>>
+                  (elem.first, ':');
+    uint64_t value = strtoull(elem.second.c_str(), nullptr, 10);
+
+    if (tokens.size() == 3) {
+      if ((tokens[1] == "queue") && (tokens[2] == "depth")) {
+        mMaxQueueDepth = value;
+      } else if ((tokens[1] == "queue") && (tokens[2] == "wait")) {
+        mMaxWait = milliseconds(value);
+      } else if ((tokens[1] == "stall") && (tokens[2] == "max")) {
+        mMaxStallSec = (value ? value : 1);
+      } else {
+        eos_static_err("msg=\"unknown admission rule\" key=%s",
+                       elem.first.c_str());
+      }
+
+      continue;
+    }
+
+    if ((tokens.size() != 4) ||
+        ((tokens[1] != "global") && (tokens[1] != "group") &&
+         (tokens[1] != "user") && (tokens[1] != "app")) ||
+        ((tokens[3] != "r") && (tokens[3] != "w") && (tokens[3] != "*"))) {
+      eos_static_err("msg=\"malformed admission rule\" key=%s",
+                     elem.first.c_str());
+      continue;
+    }
+
+    if ((tokens[1] == "global") && (tokens[2] != "*")) {
+      eos_static_err("msg=\"global admission rule requires wildcard id\" "
+                     "key=%s", elem.first.c_str());
+      continue;
+    }
+
+    // Unlike the rate rules, a zero rate can not mean "always stall" for a
+    // token bucket, so it is refused instead of silently lifting the limit
+    if (value == 0) {
+      eos_static_err("msg=\"admission rate must be greater than zero\" "
+                     "key=%s", elem.first.c_str());
+      continue;
+    }
+
+    Rule rule;
+    rule.mRate = (double) value;
+    mRules[tokens[1] + ":" + tokens[2] + ":" + tokens[3]] = rule;
+  }
+
+  mEnabled = !mRules.empty();
+  mVersion = version;
+  eos_static_info("msg=\"applied admission rules\" num_rules=%lu "
+                  "max_queue_depth=%llu max_wait_ms=%lld",
+                  mRules.size(), mMaxQueueDepth, (long long) mMaxWait.count());
+  lock.unlock();
+  // Queued requests need to re-evaluate against the new configuration
+  mCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Check if the given operation goes through admission control
+//------------------------------------------------------------------------------
+bool
+AdmissionControl::IsAdmissionOp(const std::string& function)
+{
+  return (sExemptOps.count(function) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Take admission decision for the given request
+//------------------------------------------------------------------------------
+AdmissionControl::Decision
+AdmissionControl::Admit(const Request& req)
+{
+  Decision decision;
+  std::unique_lock<std::mutex> lock(mMutex);
+  TimePoint now = eos::common::SteadyClock::now(&mClock);
+  const TimePoint start = now;
+  ExpireBuckets(now);
+  auto path = GetPath(req, now);
+
+  if (path.empty()) {
+    return decision;
+  }
+
+  // Only bypass the queues if nobody is waiting, otherwise we are not fair
+  if (mQueues.empty() && TryConsume(path, now, req.mWeight)) {
+    for (auto& bucket : path) {
+      ++bucket->mStats.mAdmitted;
+    }
+
+    return decision;
+  }
+
+  auto limiting = GetLimiting(path, now);
+
+  if (limiting == nullptr) {
+    // Tokens might be available but other requests are already queued
+    limiting = path.back();
+  }
+
+  if ((mMaxWait.count() == 0) || (mQueueDepth >= mMaxQueueDepth)) {
+    for (auto& bucket : path) {
+      ++bucket->mStats.mRejected;
+    }
+
+    decision.mAdmitted = false;
+    decision.mStallSec = ComputeStallHint(limiting, now);
+    decision.mBucket = limiting->mName;
+    return decision;
+  }
+
+  auto ticket = std::make_shared<Ticket>();
+  ticket->mPath = path;
+  ticket->mWeight = req.mWeight;
+  mQueues[req.mUid].push_back(ticket);
+  ++mQueueDepth;
+
+  for (auto& bucket : path) {
+    ++bucket->mStats.mQueued;
+  }
+
+  const TimePoint deadline = now + mMaxWait;
+
+  while (true) {
+    if (ServeQueues(now)) {
+      mCv.notify_all();
+    }
+
+    if (ticket->mGranted) {
+      for (auto& bucket : path) {
+        ++bucket->mStats.mAdmitted;
+      }
+
+      decision.mQueued = duration_cast<microseconds>(now - start);
+      return decision;
+    }
+
+    if (now >= deadline) {
+      break;
+    }
+
+    // Sleep until the limiting bucket might have tokens again or until the
+    // deadline, whichever comes first
+    limiting = GetLimiting(path, now);
+    auto wait = duration_cast<microseconds>(deadline - now);
+
+    if (limiting) {
+      auto refill = limiting->mTokens.TimeToAvailable(now);
+
+      if ((refill.count() > 0) && (refill < wait)) {
+        wait = refill;
+      }
+    }
+
+    mCv.wait_for(lock, wait);
+    now = eos::common::SteadyClock::now(&mClock);
+  }
+
+  // Deadline expired - remove the ticket from the queue
+  auto it_queue = mQueues.find(req.mUid);
+
+  if (it_queue != mQueues.end()) {
+    auto& queue = it_queue->second;
+
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+      if (*it == ticket) {
+        queue.erase(it);
+        --mQueueDepth;
+        break;
+      }
+    }
+
+    if (queue.empty()) {
+      mQueues.erase(it_queue);
+    }
+  }
+
+  limiting = GetLimiting(path, now);
+
+  if (limiting == nullptr) {
+    limiting = path.back();
+  }
+
+  for (auto& bucket : path) {
+    ++bucket->mStats.mRejected;
+  }
+
+  decision.mAdmitted = false;
+  decision.mQueued = duration_cast<microseconds>(now - start);
+  decision.mStallSec = ComputeStallHint(limiting, now);
+  decision.mBucket = limiting->mName;
+  return decision;
+}
+
+//------------------------------------------------------------------------------
+// Get statistics for the given bucket
+//------------------------------------------------------------------------------
+AdmissionControl::BucketStats
+AdmissionControl::GetBucketStats(const std::string& bucket)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mBuckets.find(bucket);
+
+  if (it == mBuckets.end()) {
+    return BucketStats();
+  }
+
+  return it->second->mStats;
+}
+
+//------------------------------------------------------------------------------
+// Dump bucket metrics
+//------------------------------------------------------------------------------
+std::string
+AdmissionControl::PrintOut(bool monitoring)
+{
+  std::string format_l = !monitoring ? "+l" : "ol";
+  std::string format_s = !monitoring ? "s" : "os";
+  std::string format_f = !monitoring ? "f" : "of";
+  TableFormatterBase table_all;
+
+  if (!monitoring) {
+    table_all.SetHeader({
+      std::make_tuple("bucket", 24, format_s),
+      std::make_tuple("rate", 8, format_l),
+      std::make_tuple("tokens", 8, format_f),
+      std::make_tuple("admitted", 8, format_l),
+      std::make_tuple("queued", 8, format_l),
+      std::make_tuple("rejected", 8, format_l),
+      std::make_tuple("queue-depth", 8, format_l)
+    });
+  } else {
+    table_all.SetHeader({
+      std::make_tuple("bucket", 0, format_s),
+      std::make_tuple("rate", 0, format_l),
+      std::make_tuple("tokens", 0, format_f),
+      std::make_tuple("admitted", 0, format_l),
+      std::make_tuple("queued", 0, format_l),
+      std::make_tuple("rejected", 0, format_l),
+      std::make_tuple("queue-depth", 0, format_l)
+    });
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  TimePoint now = eos::common::SteadyClock::now(&mClock);
+
+  for (const auto& elem : mBuckets) {
+    TableData table_data;
+    auto& bucket = elem.second;
+    table_data.emplace_back();
+    table_data.back().push_back(TableCell(elem.first, format_s));
+    table_data.back().push_back(TableCell((long long)
+                                          bucket->mTokens.GetRate(), format_l));
+    table_data.back().push_back(TableCell(bucket->mTokens.GetTokens(now),
+                                          format_f));
+    table_data.back().push_back(TableCell((long long)
+                                          bucket->mStats.mAdmitted, format_l));
+    table_data.back().push_back(TableCell((long long)
+                                          bucket->mStats.mQueued, format_l));
+    table_data.back().push_back(TableCell((long long)
+                                          bucket->mStats.mRejected, format_l));
+    table_data.back().push_back(TableCell((long long) mQueueDepth.load(),
+                                          format_l));
+    table_all.AddRows(table_data);
+  }
+
+  return table_all.GenerateTable(HEADER);
+}
+
+//------------------------------------------------------------------------------
+// Get the identifier of the given request at the given level
+//------------------------------------------------------------------------------
+std::string
+AdmissionControl::GetId(const Request& req, Level level)
+{
+  switch (level) {
+  case Level::Global:
+    return "*";
+
+  case Level::Group:
+    return std::to_string(req.mGid);
+
+  case Level::User:
+    return std::to_string(req.mUid);
+
+  case Level::App:
+    return (req.mApp.empty() ? std::string("default") : req.mApp);
+  }
+
+  return "*";
+}
+
+//------------------------------------------------------------------------------
+// Convert level to string
+//------------------------------------------------------------------------------
+std::string
+AdmissionControl::LevelToString(Level level)
+{
+  switch (level) {
+  case Level::Global:
+    return "global";
+
+  case Level::Group:
+    return "group";
+
+  case Level::User:
+    return "user";
+
+  case Level::App:
+    return "app";
+  }
+
+  return "unknown";
+}
+
+//------------------------------------------------------------------------------
+// Find the rule matching the given level, id and operation
+//------------------------------------------------------------------------------
+const AdmissionControl::Rule*
+AdmissionControl::FindRule(Level level, const std::string& id,
+                           const std::string& op, std::string& name) const
+{
+  const std::string slevel = LevelToString(level);
+
+  for (const auto& sid : {
+         id, std::string("*")
+       }) {
+    for (const auto& sop : {
+           op, std::string("*")
+         }) {
+      auto it = mRules.find(slevel + ":" + sid + ":" + sop);
+
+      if (it != mRules.end()) {
+        // Each identity gets its own bucket even for wildcard rules
+        name = slevel + ":" + id + ":" + sop;
+        return &it->second;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Collect the buckets on the path of the given request
+//------------------------------------------------------------------------------
+std::list<std::shared_ptr<AdmissionControl::Bucket>>
+AdmissionControl::GetPath(const Request& req, TimePoint now)
+{
+  std::list<std::shared_ptr<Bucket>> path;
+
+  if (!mEnabled) {
+    return path;
+  }
+
+  for (const auto level : sLevels) {
+    std::string name;
+    const Rule* rule = FindRule(level, GetId(req, level), req.mOp, name);
+
+    if (rule == nullptr) {
+      continue;
+    }
+
+    auto it = mBuckets.find(name);
+
+    if (it == mBuckets.end()) {
+      auto bucket = std::make_shared<Bucket>();
+      bucket->mName = name;
+      bucket->mTokens = eos::common::TokenBucket(rule->mRate, 0, now);
+      it = mBuckets.emplace(name, bucket).first;
+    } else if (it->second->mTokens.GetRate() != rule->mRate) {
+      it->second->mTokens.Configure(rule->mRate, 0);
+    }
+
+    it->second->mLastUsed = now;
+    path.push_back(it->second);
+  }
+
+  return path;
+}
+
+//------------------------------------------------------------------------------
+// Get the bucket on the given path which needs the longest time to refill
+//------------------------------------------------------------------------------
+std::shared_ptr<AdmissionControl::Bucket>
+AdmissionControl::GetLimiting(const std::list<std::shared_ptr<Bucket>>& path,
+                              TimePoint now)
+{
+  std::shared_ptr<Bucket> limiting;
+  microseconds max_wait {0};
+
+  for (auto& bucket : path) {
+    auto wait = bucket->mTokens.TimeToAvailable(now);
+
+    if (wait > max_wait) {
+      max_wait = wait;
+      limiting = bucket;
+    }
+  }
+
+  return limiting;
+}
+
+//------------------------------------------------------------------------------
+// Try to consume tokens from all the buckets on the given path
+//------------------------------------------------------------------------------
+bool
+AdmissionControl::TryConsume(const std::list<std::shared_ptr<Bucket>>& path,
+                             TimePoint now, uint32_t tokens)
+{
+  if (GetLimiting(path, now)) {
+    return false;
+  }
+
+  for (auto& bucket : path) {
+    bucket->mTokens.Consume(now, tokens);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Serve queued tickets in round-robin order between users
+//------------------------------------------------------------------------------
+bool
+AdmissionControl::ServeQueues(TimePoint now)
+{
+  bool any_granted = false;
+  bool progress = true;
+
+  while (progress && !mQueues.empty()) {
+    progress = false;
+    // Start with the user following the last one served
+    auto it = mQueues.upper_bound(mLastServedUid);
+
+    for (size_t i = 0, num_users = mQueues.size(); i < num_users; ++i) {
+      if (it == mQueues.end()) {
+        it = mQueues.begin();
+      }
+
+      auto& queue = it->second;
+      auto& ticket = queue.front();
+
+      if (TryConsume(ticket->mPath, now, ticket->mWeight)) {
+        ticket->mGranted = true;
+        queue.pop_front();
+        --mQueueDepth;
+        mLastServedUid = it->first;
+        progress = any_granted = true;
+
+        if (queue.empty()) {
+          it = mQueues.erase(it);
+          continue;
+        }
+      }
+
+      ++it;
+    }
+  }
+
+  return any_granted;
+}
+
+//------------------------------------------------------------------------------
+// Compute stall hint based on the queue depth and the limiting bucket
+//------------------------------------------------------------------------------
+uint32_t
+AdmissionControl::ComputeStallHint(const std::shared_ptr<Bucket>& limiting,
+                                   TimePoint now)
+{
+  double rate = limiting->mTokens.GetRate();
+  double stall_sec = 1;
+
+  if (rate > 0) {
+    // Time needed to drain the requests ahead plus the current token debt
+    stall_sec = (mQueueDepth + 1) / rate +
+                limiting->mTokens.TimeToAvailable(now).count() / 1e6;
+  }
+
+  stall_sec = std::ceil(stall_sec);
+
+  if (stall_sec < 1) {
+    stall_sec = 1;
+  }
+
+  if (stall_sec > mMaxStallSec) {
+    stall_sec = mMaxStallSec;
+  }
+
+  // Spread the retries over an interval proportional to the hint so that
+  // clients don't come back all at the same time
+  uint32_t hint = (uint32_t) stall_sec;
+  return hint + eos::common::getRandom((uint32_t) 0, hint / 2);
+}
+
+//------------------------------------------------------------------------------
+// Drop buckets which have not been used recently
+//------------------------------------------------------------------------------
+void
+AdmissionControl::ExpireBuckets(TimePoint now)
+{
+  if (now - mLastExpire < sExpireInterval) {
+    return;
+  }
+
+  mLastExpire = now;
+
+  for (auto it = mBuckets.begin(); it != mBuckets.end(); /* no inc */) {
+    // Buckets referenced by queued tickets are kept
+    if ((it->second.use_count() == 1) &&
+        (now - it->second->mLastUsed > sBucketIdle)) {
+      it = mBuckets.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,339 @@
+// ----------------------------------------------------------------------
+// File: AdmissionControl.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/RateLimit.hh"
+#include "common/SteadyClock.hh"
+#include "common/Logging.hh"
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Admission control for the MGM front door
+//!
+//! Requests are checked against a hierarchy of token buckets per operation
+//! type: global -> group -> user -> application. A request is admitted only
+//! if all the buckets on its path have tokens available. Requests that can not
+//! be admitted immediately wait in a short per-user queue which is served in
+//! round-robin order between users until their deadline expires. Requests
+//! which can not be served before the deadline or which find the queue full
+//! are rejected with a stall hint computed from the current queue depth and
+//! the rate of the limiting bucket.
+//!
+//! The limits are configured through the access stall rules using keys of the
+//! form:
+//!   admission:{global,group,user,app}:{<id>,*}:{r,w,*} = <rate Hz>
+//!   admission:queue:depth = <max queued requests>
+//!   admission:queue:wait  = <max queueing time in milliseconds>
+//!   admission:stall:max   = <max stall hint in seconds>
+//!
+//! The rate has to be greater than zero: contrary to the access rate rules
+//! where 0 means "always stall", bucket rules with a zero rate are ignored.
+//------------------------------------------------------------------------------
+class AdmissionControl: public eos::common::LogId
+{
+public:
+  //! Levels of the bucket hierarchy in the order they are evaluated
+  enum class Level {
+    Global = 0, Group = 1, User = 2, App = 3
+  };
+
+  //----------------------------------------------------------------------------
+  //! Request description used for taking the admission decision
+  //----------------------------------------------------------------------------
+  struct Request {
+    uid_t mUid {0};
+    gid_t mGid {0};
+    std::string mApp;
+    std::string mOp {"r"}; ///< operation type "r" or "w"
+    //! Number of operations the request stands for e.g. the records of a
+    //! batch. It is admitted as soon as one token is available and then
+    //! charged all of them, the following requests wait for the debt.
+    uint32_t mWeight {1};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Admission decision
+  //----------------------------------------------------------------------------
+  struct Decision {
+    bool mAdmitted {true};
+    uint32_t mStallSec {0}; ///< stall hint for rejected requests
+    std::string mBucket; ///< limiting bucket for rejected requests
+    std::chrono::microseconds mQueued {0}; ///< time spent in the queue
+  };
+
+  //----------------------------------------------------------------------------
+  //! Per bucket statistics
+  //----------------------------------------------------------------------------
+  struct BucketStats {
+    uint64_t mAdmitted {0};
+    uint64_t mQueued {0};
+    uint64_t mRejected {0};
+  };
+
+  //! Key prefix used in the access stall rules
+  static constexpr const char* sRulePrefix = "admission:";
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fake_clock if true use synthetic clock for testing
+  //----------------------------------------------------------------------------
+  AdmissionControl(bool fake_clock = false):
+    mClock(fake_clock)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~AdmissionControl() = default;
+
+  //----------------------------------------------------------------------------
+  //! Apply configuration from the access stall rules. Only the keys starting
+  //! with the "admission:" prefix are considered. The update is skipped if the
+  //! given version matches the currently applied one.
+  //!
+  //! @param rules map of access stall rules
+  //! @param version version of the rules
+  //----------------------------------------------------------------------------
+  void Configure(const std::map<std::string, std::string>& rules,
+                 uint64_t version);
+
+  //----------------------------------------------------------------------------
+  //! Check if admission control is enabled i.e. there is at least one bucket
+  //! rule configured
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return mEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the given operation goes through admission control. Metadata
+  //! reads (stat, access, checksum, locate, fusex STAT/LS ...) are exempt
+  //! just like they are exempt from the access rate rules.
+  //!
+  //! @param function name of the operation as passed to ShouldStall
+  //!
+  //! @return true if the operation is subject to admission, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsAdmissionOp(const std::string& function);
+
+  //----------------------------------------------------------------------------
+  //! Take admission decision for the given request, this might block the
+  //! current thread for at most the configured maximum queueing time.
+  //!
+  //! @param req request description
+  //!
+  //! @return admission decision
+  //----------------------------------------------------------------------------
+  Decision Admit(const Request& req);
+
+  //----------------------------------------------------------------------------
+  //! Get number of requests currently waiting in the queues
+  //----------------------------------------------------------------------------
+  uint64_t GetQueueDepth() const
+  {
+    return mQueueDepth;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get statistics for the given bucket
+  //!
+  //! @param bucket bucket name e.g. "user:1001:w"
+  //!
+  //! @return bucket statistics
+  //----------------------------------------------------------------------------
+  BucketStats GetBucketStats(const std::string& bucket);
+
+  //----------------------------------------------------------------------------
+  //! Dump bucket metrics
+  //!
+  //! @param monitoring if true use monitoring format
+  //!
+  //! @return table with the bucket metrics
+  //----------------------------------------------------------------------------
+  std::string PrintOut(bool monitoring);
+
+  //----------------------------------------------------------------------------
+  //! Get clock reference for testing purposes
+  //----------------------------------------------------------------------------
+  inline eos::common::SteadyClock& GetClock()
+  {
+    return mClock;
+  }
+
+private:
+#ifdef IN_TEST_HARNESS
+public:
+#endif
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  //----------------------------------------------------------------------------
+  //! Rule describing the limit for a level/id/op combination
+  //----------------------------------------------------------------------------
+  struct Rule {
+    double mRate {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Bucket object with its statistics
+  //----------------------------------------------------------------------------
+  struct Bucket {
+    std::string mName;
+    eos::common::TokenBucket mTokens;
+    BucketStats mStats;
+    TimePoint mLastUsed;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Waiting request ticket
+  //----------------------------------------------------------------------------
+  struct Ticket {
+    std::list<std::shared_ptr<Bucket>> mPath;
+    uint32_t mWeight {1};
+    bool mGranted {false};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the identifier of the given request at the given level
+  //----------------------------------------------------------------------------
+  static std::string GetId(const Request& req, Level level);
+
+  //----------------------------------------------------------------------------
+  //! Convert level to string
+  //----------------------------------------------------------------------------
+  static std::string LevelToString(Level level);
+
+  //----------------------------------------------------------------------------
+  //! Find the rule matching the given level, id and operation with the
+  //! following precedence: exact id/op, exact id/any op, wildcard id/op,
+  //! wildcard id/any op.
+  //!
+  //! @param level bucket level
+  //! @param id identifier at the given level
+  //! @param op operation type
+  //! @param name set to the name of the corresponding bucket
+  //!
+  //! @return pointer to rule or nullptr if no limit applies
+  //----------------------------------------------------------------------------
+  const Rule* FindRule(Level level, const std::string& id,
+                       const std::string& op, std::string& name) const;
+
+  //----------------------------------------------------------------------------
+  //! Collect the buckets on the path of the given request, creating them if
+  //! necessary. Must be called with the mutex locked.
+  //!
+  //! @param req request description
+  //! @param now current time point
+  //!
+  //! @return list of buckets ordered from global to application level
+  //----------------------------------------------------------------------------
+  std::list<std::shared_ptr<Bucket>>
+  GetPath(const Request& req, TimePoint now);
+
+  //----------------------------------------------------------------------------
+  //! Get the bucket on the given path which needs the longest time until a
+  //! token becomes available. Must be called with the mutex locked.
+  //!
+  //! @param path list of buckets
+  //! @param now current time point
+  //!
+  //! @return limiting bucket or nullptr if all buckets have tokens
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Bucket>
+  GetLimiting(const std::list<std::shared_ptr<Bucket>>& path, TimePoint now);
+
+  //----------------------------------------------------------------------------
+  //! Consume the given number of tokens from all the buckets on the given
+  //! path if each of them has at least one token available, the buckets may
+  //! go into debt. Must be called with the mutex locked.
+  //!
+  //! @param path list of buckets
+  //! @param now current time point
+  //! @param tokens number of tokens to consume
+  //!
+  //! @return true if tokens were consumed, otherwise false
+  //----------------------------------------------------------------------------
+  bool TryConsume(const std::list<std::shared_ptr<Bucket>>& path,
+                  TimePoint now, uint32_t tokens);
+
+  //----------------------------------------------------------------------------
+  //! Serve queued tickets in round-robin order between users. Must be called
+  //! with the mutex locked.
+  //!
+  //! @param now current time point
+  //!
+  //! @return true if at least one ticket was granted
+  //----------------------------------------------------------------------------
+  bool ServeQueues(TimePoint now);
+
+  //----------------------------------------------------------------------------
+  //! Compute stall hint based on the queue depth and the rate of the limiting
+  //! bucket. Must be called with the mutex locked.
+  //!
+  //! @param limiting limiting bucket
+  //! @param now current time point
+  //!
+  //! @return stall hint in seconds
+  //----------------------------------------------------------------------------
+  uint32_t ComputeStallHint(const std::shared_ptr<Bucket>& limiting,
+                            TimePoint now);
+
+  //----------------------------------------------------------------------------
+  //! Drop buckets which have not been used recently. Must be called with the
+  //! mutex locked.
+  //!
+  //! @param now current time point
+  //----------------------------------------------------------------------------
+  void ExpireBuckets(TimePoint now);
+
+  eos::common::SteadyClock mClock; ///< Clock wrapper also used for testing
+  std::atomic<bool> mEnabled {false};
+  std::atomic<uint64_t> mVersion {0}; ///< Version of the applied rules
+  std::atomic<uint64_t> mQueueDepth {0}; ///< Number of queued requests
+  uint64_t mMaxQueueDepth {1000}; ///< Maximum number of queued requests
+  std::chrono::milliseconds mMaxWait {200}; ///< Maximum queueing time
+  uint32_t mMaxStallSec {60}; ///< Maximum stall hint in seconds
+  std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mCv; ///< Signal queued requests
+  //! Rules indexed by level, id and operation type
+  std::map<std::string, Rule> mRules;
+  //! Buckets indexed by their name "<level>:<id>:<op>"
+  std::map<std::string, std::shared_ptr<Bucket>> mBuckets;
+  //! Queued tickets per user
+  std::map<uid_t, std::deque<std::shared_ptr<Ticket>>> mQueues;
+  uid_t mLastServedUid {0}; ///< Last user served from the queues
+  TimePoint mLastExpire; ///< Timestamp of the last bucket expiry
+};
+
+EOSMGMNAMESPACE_END
@@ -1539,6 +1539,8 @@ FsView::GetFileSystemFormat(std::string option)
     format += "key=local.drain.bytesleft:format=ol|";
     format += "key=local.drain.failed:format=ol|";
     format += "key=local.drain.timeleft:format=ol|";
+    format += "key=local.drain.rate:format=ol|";
+    format += "key=local.drain.eta:format=ol|";
     format += "key=graceperiod:format=ol|";
     format += "key=drainperiod:format=ol|";
     format += "key=stat.active:format=os|";
@@ -1602,6 +1604,8 @@ FsView::GetFileSystemFormat(std::string option)
     format += "key=local.drain.files:width=12:format=+l:tag=files|";
     format += "key=local.drain.bytesleft:width=12:format=+l:tag=bytes-left:unit=B|";
     format += "key=local.drain.timeleft:width=11:format=l:tag=timeleft|";
+    format += "key=local.drain.rate:width=10:format=+l:tag=rate:unit=B/s|";
+    format += "key=local.drain.eta:width=11:format=l:tag=eta|";
     format += "key=local.drain.failed:width=12:format=+l:tag=failed";
   } else if (option == "l") {
     // long format
@@ -283,6 +283,76 @@ FuseServer::Caps::BroadcastDeletionFromExternal(uint64_t id,
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+int
+FuseServer::Caps::BroadcastDeltaFromExternal(uint64_t id, uint64_t pid,
+					     const eos::fusex::md* md,
+					     const std::string& name,
+					     struct timespec& pt_mtime,
+					     struct timespec& pt_base_mtime)
+/*----------------------------------------------------------------------------*/
+{
+  gOFS->MgmStats.Add("Eosxd::int::BcDeltaExt", 0, 0, 1);
+  EXEC_TIMING_BEGIN("Eosxd::int::BcDeltaExt");
+  eos_static_debug("id=%lx pid=%lx name=%s add=%d", id, pid, name.c_str(),
+                   md ? 1 : 0);
+  std::unordered_set<std::string> clients_sent;
+  // clients holding the listing of id patch it with the delta
+  auto bccaps = GetBroadcastCapsTS(id);
+
+  for (auto it : bccaps) {
+    if (clients_sent.count((*it)()->clientuuid())) {
+      continue;
+    }
+
+    clients_sent.emplace((*it)()->clientuuid());
+
+    if (md) {
+      gOFS->zMQ->gFuseServer.Client().SendMD(*md,
+					     (*it)()->clientuuid(),
+					     (*it)()->clientid(),
+					     md->md_ino(),
+					     id,
+					     md->clock(),
+					     pt_mtime,
+					     &pt_base_mtime);
+    } else {
+      gOFS->zMQ->gFuseServer.Client().DeleteEntry(id,
+						  (*it)()->clientuuid(),
+						  (*it)()->clientid(),
+						  name,
+						  pt_mtime,
+						  &pt_base_mtime);
+    }
+
+    errno = 0 ; // seems that ZMQ function might set errno
+  }
+
+  // all others only see the changed attributes of id and refresh it
+  auto pbccaps = GetBroadcastCapsTS(pid, nullptr, nullptr, true,
+                                    "Eosxd::int::BcRefreshExtSup");
+  size_t n_skipped = 0;
+
+  for (auto it : pbccaps) {
+    if (clients_sent.count((*it)()->clientuuid())) {
+      n_skipped++;
+      continue;
+    }
+
+    gOFS->zMQ->gFuseServer.Client().RefreshEntry(id,
+						 (*it)()->clientuuid(),
+						 (*it)()->clientid());
+    errno = 0 ;
+  }
+
+  if (n_skipped) {
+    gOFS->MgmStats.Add("Eosxd::int::BcDeltaExtNoRefresh", 0, 0, n_skipped);
+  }
+
+  EXEC_TIMING_END("Eosxd::int::BcDeltaExt");
+  return 0;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 FuseServer::Caps::BroadcastDeletion(uint64_t id, const eos::fusex::md& md,
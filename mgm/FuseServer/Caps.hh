@@ -265,6 +265,16 @@ public:
                                     const std::string& name,
 				    struct timespec& p_mtime);
 
+  // broad cast an added (md != 0) or removed entry of container inode to the
+  // clients holding a cap on it, the parent refresh is sent only to clients
+  // of parent_inode which did not get the delta
+  int BroadcastDeltaFromExternal(uint64_t inode,
+                                 uint64_t parent_inode,
+                                 const eos::fusex::md* md,
+                                 const std::string& name,
+                                 struct timespec& p_mtime,
+                                 struct timespec& p_base_mtime);
+
   int BroadcastMD(const eos::fusex::md& md,
                   uint64_t md_ino,
                   uint64_t md_pino,
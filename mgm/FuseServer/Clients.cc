@@ -264,6 +264,7 @@ FuseServer::Clients::Dispatch(const std::string identity,
     cfg.set_appname(true);
     cfg.set_mdquery(true);
     cfg.set_hideversion(true);
+    cfg.set_mdbatch(true);
     cfg.set_serverversion(std::string(VERSION) + std::string("::") + std::string(
                             RELEASE));
     BroadcastConfig(identity, cfg);
@@ -793,7 +794,8 @@ FuseServer::Clients::DeleteEntry(uint64_t md_ino,
                                  const std::string& uuid,
                                  const std::string& clientid,
                                  const std::string& name,
-                                 struct timespec& pt_mtime
+                                 struct timespec& pt_mtime,
+                                 const struct timespec* pt_base_mtime
                                 )
 {
   gOFS->MgmStats.Add("Eosxd::int::DeleteEntry", 0, 0, 1);
@@ -807,6 +809,13 @@ FuseServer::Clients::DeleteEntry(uint64_t md_ino,
   rsp.mutable_dentry_()->set_clientid(clientid);
   rsp.mutable_dentry_()->set_pt_mtime(pt_mtime.tv_sec);
   rsp.mutable_dentry_()->set_pt_mtime_ns(pt_mtime.tv_nsec);
+
+  if (pt_base_mtime) {
+    // lets the client verify that its listing is the one this delta applies to
+    rsp.mutable_dentry_()->set_pt_base_mtime(pt_base_mtime->tv_sec);
+    rsp.mutable_dentry_()->set_pt_base_mtime_ns(pt_base_mtime->tv_nsec);
+  }
+
   std::string rspstream;
   rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
@@ -887,7 +896,8 @@ FuseServer::Clients::SendMD(const eos::fusex::md& md,
                             uint64_t md_ino,
                             uint64_t md_pino,
                             uint64_t clock,
-                            struct timespec& p_mtime
+                            struct timespec& p_mtime,
+                            const struct timespec* p_base_mtime
                            )
 /*----------------------------------------------------------------------------*/
 
@@ -910,6 +920,11 @@ FuseServer::Clients::SendMD(const eos::fusex::md& md,
     rsp.mutable_md_()->set_pt_mtime_ns(p_mtime.tv_nsec);
   }
 
+  if (p_base_mtime) {
+    rsp.mutable_md_()->set_pt_base_mtime(p_base_mtime->tv_sec);
+    rsp.mutable_md_()->set_pt_base_mtime_ns(p_base_mtime->tv_nsec);
+  }
+
   rsp.mutable_md_()->set_clock(clock);
   std::string rspstream;
   rsp.SerializeToString(&rspstream);
@@ -1035,6 +1050,7 @@ FuseServer::Clients::SetHeartbeatInterval(int interval)
       cfg.set_appname(true);
       cfg.set_mdquery(true);
       cfg.set_hideversion(true);
+      cfg.set_mdbatch(true);
       cfg.set_serverversion(std::string(VERSION) + std::string("::") + std::string(
                               RELEASE));
       BroadcastConfig(id, cfg);
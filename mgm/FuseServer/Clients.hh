@@ -189,7 +189,8 @@ public:
                   const std::string& uuid,
                   const std::string& clientid,
                   const std::string& name,
-		  struct timespec& pt_mtime);
+		  struct timespec& pt_mtime,
+		  const struct timespec* pt_base_mtime = 0);
 
   // refresh entry
   int RefreshEntry(uint64_t id,
@@ -204,7 +205,8 @@ public:
              uint64_t md_ino,
              uint64_t md_pino,
              uint64_t clock,
-             struct timespec& p_mtime
+             struct timespec& p_mtime,
+             const struct timespec* p_base_mtime = 0
             );
 
   // broadcast a new cap
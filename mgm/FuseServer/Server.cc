@@ -1151,6 +1151,25 @@ Server::prefetchMD(const eos::fusex::md& md)
     }
   } else if (md.operation() == md.GETCAP) {
     Prefetcher::prefetchInodeAndWait(gOFS->eosView, md.md_ino());
+  } else if (md.operation() == md.BATCH) {
+    // stage all the entries of the batch at once and wait only once
+    Prefetcher prefetcher(gOFS->eosView);
+
+    for (const auto& item : md.batch()) {
+      if (item.md_ino()) {
+        if (eos::common::FileId::IsFileInode(item.md_ino())) {
+          prefetcher.stageFileMD(eos::common::FileId::InodeToFid(item.md_ino()));
+        } else {
+          prefetcher.stageContainerMD(item.md_ino());
+        }
+      }
+
+      if (item.md_pino()) {
+        prefetcher.stageContainerMD(item.md_pino());
+      }
+    }
+
+    prefetcher.wait();
   }
 }
 
@@ -3498,6 +3517,61 @@ Server::OpSetLock(const std::string& id,
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Serve a batch of meta-data requests
+//------------------------------------------------------------------------------
+
+int
+Server::OpBatch(const std::string& id,
+                const eos::fusex::md& md,
+                eos::common::VirtualIdentity& vid,
+                std::string* response,
+                uint64_t* clock)
+{
+  gOFS->MgmStats.Add("Eosxd::ext::BATCH", vid.uid, vid.gid, 1);
+  EXEC_TIMING_BEGIN("Eosxd::ext::BATCH");
+  eos::fusex::response resp;
+  resp.set_type(resp.BATCH);
+  auto batch = resp.mutable_batch_();
+
+  // the namespace entries have been prefetched for the whole batch, the
+  // requests are served one by one in the order given by the client
+  for (const auto& item : md.batch()) {
+    auto rsp_item = batch->add_item_();
+    rsp_item->set_md_ino(item.md_ino());
+
+    switch (item.operation()) {
+    case eos::fusex::md::OP::md_OP_GET:
+    case eos::fusex::md::OP::md_OP_GETCAP:
+    case eos::fusex::md::OP::md_OP_SET:
+    case eos::fusex::md::OP::md_OP_DELETE: {
+      std::string result;
+      int rc = HandleMD(id, item, vid, &result, 0);
+      rsp_item->set_err_no(rc);
+      rsp_item->set_result(result);
+      break;
+    }
+
+    default:
+      // listings, locks and nested batches are not allowed in a batch
+      rsp_item->set_err_no(EINVAL);
+      break;
+    }
+  }
+
+  std::string rspstream;
+  resp.SerializeToString(&rspstream);
+
+  if (!response) {
+    gOFS->zMQ->mTask->reply(id, rspstream);
+  } else {
+    *response = rspstream;
+  }
+
+  EXEC_TIMING_END("Eosxd::ext::BATCH");
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Dispatch meta-data requests
 //------------------------------------------------------------------------------
@@ -3532,6 +3606,8 @@ Server::HandleMD(const std::string& id,
     ops = "BEGINFLUSH";
   } else if (op_type == md.ENDFLUSH) {
     ops = "ENDFLUSH";
+  } else if (op_type == md.BATCH) {
+    ops = "BATCH";
   } else {
     ops = "UNKNOWN";
   }
@@ -3593,6 +3669,9 @@ Server::HandleMD(const std::string& id,
   case eos::fusex::md::OP::md_OP_SETLKW:
     return OpSetLock(id, md, vid, response, clock);
 
+  case eos::fusex::md::OP::md_OP_BATCH:
+    return OpBatch(id, md, vid, response, clock);
+
   default:
     break;
   }
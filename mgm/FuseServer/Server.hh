@@ -188,6 +188,12 @@ public:
                 std::string* response = 0,
                 uint64_t* clock = 0);
 
+  int OpBatch(const std::string& identity,
+              const eos::fusex::md& md,
+              eos::common::VirtualIdentity& vid,
+              std::string* response = 0,
+              uint64_t* clock = 0);
+
   int HandleMD(const std::string& identity,
                const eos::fusex::md& md,
                eos::common::VirtualIdentity& vid,
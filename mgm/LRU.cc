@@ -34,11 +34,13 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/convert/ConverterDriver.hh"
 #include "namespace/interface/IView.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/Prefetcher.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
 #include "namespace/ns_quarkdb/NamespaceGroup.hh"
 #include <qclient/QClient.hh>
+#include <algorithm>
 
 //! Attribute name defining any LRU policy
 const char* LRU::gLRUPolicyPrefix = "sys.lru.*";
@@ -85,11 +87,21 @@ LRU::Options LRU::getOptions()
   // Default options
   opts.enabled = false;
   opts.interval = std::chrono::minutes(30);
+  opts.incremental = false;
+  opts.rate = 0;
   eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
 
   if (FsView::gFsView.mSpaceView.count("default") &&
       (FsView::gFsView.mSpaceView["default"]->GetConfigMember("lru") == "on")) {
     opts.enabled = true;
+    auto space = FsView::gFsView.mSpaceView["default"];
+    opts.incremental = (space->GetConfigMember("lru.incremental") == "on");
+    std::string rate = space->GetConfigMember("lru.rate");
+    int64_t irate = 0;
+
+    if (!rate.empty() && common::ParseInt64(rate, irate) && (irate > 0)) {
+      opts.rate = irate;
+    }
   }
 
   std::string interval = getLRUIntervalConfig();
@@ -104,7 +116,8 @@ LRU::Options LRU::getOptions()
   }
 
   if (opts.enabled) {
-    eos_static_info("msg=\"lru is enabled\" interval=%ds", opts.interval.count());
+    eos_static_info("msg=\"lru is enabled\" interval=%ds incremental=%d "
+                    "rate=%llu", opts.interval.count(), opts.incremental, opts.rate);
   }
 
   // Set long interval in case LRU is de-activated, prevent the background
@@ -165,6 +178,157 @@ bool LRU::parseExpireMatchPolicy(const std::string& policy,
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Parse an "sys.lru.convert.match" policy
+//------------------------------------------------------------------------------
+bool LRU::parseConvertMatchPolicy(const eos::IContainerMD::XAttrMap& map,
+                                  std::map<std::string, time_t>& matchAgeMap,
+                                  std::map<std::string, ssize_t>& matchSizeMap)
+{
+  std::map < std::string, std::string> lMatchMap;
+  matchAgeMap.clear();
+  matchSizeMap.clear();
+  auto it_policy = map.find("sys.lru.convert.match");
+
+  if ((it_policy == map.end()) ||
+      !StringConversion::GetKeyValueMap(it_policy->second.c_str(), lMatchMap,
+                                        ":")) {
+    eos_static_err("msg=\"LRU match attribute is illegal\" val=\"%s\"",
+                   (it_policy == map.end()) ? "" : it_policy->second.c_str());
+    return false;
+  }
+
+  for (auto it = lMatchMap.begin(); it != lMatchMap.end(); it++) {
+    std::string time_tag;
+    std::string size_tag;
+    eos::common::StringConversion::SplitKeyValue(it->second, time_tag, size_tag);
+
+    if (time_tag.empty()) {
+      time_tag = it->second;
+    }
+
+    bool size_smaller = false;
+    bool size_larger  = false;
+    size_t size_limit = 0;
+
+    if (size_tag.length()) {
+      if (size_tag.substr(0, 1) == "<") {
+        size_smaller = true;
+      }
+
+      if (size_tag.substr(0, 1) == ">") {
+        size_larger = true;
+      }
+
+      size_tag.erase(0, 1);
+
+      if (!size_smaller && !size_larger) {
+        eos_static_err("msg=\"LRU match attribute has illegal size\" "
+                       " match=\"%s\", size=\"%s\"",
+                       it->first.c_str(),
+                       size_tag.c_str());
+      } else {
+        size_limit = eos::common::StringConversion::GetSizeFromString(size_tag.c_str());
+      }
+    }
+
+    eos_static_info("time-tag=%s size-tag=%s <%d >%d limit=%lu", time_tag.c_str(),
+                    size_tag.c_str(), size_smaller, size_larger, size_limit);
+    time_t t = eos::common::StringConversion::GetSizeFromString(time_tag.c_str());
+
+    if (errno) {
+      eos_static_err("msg=\"LRU match attribute has illegal age\" "
+                     "match=\"%s\", age=\"%s\"", it->first.c_str(),
+                     time_tag.c_str());
+    } else {
+      std::string conv_attr = "sys.conversion.";
+      conv_attr += it->first;
+
+      if (map.count(conv_attr)) {
+        matchAgeMap[it->first] = t;
+
+        if (size_smaller) {
+          matchSizeMap[it->first] = -size_limit;
+        }
+
+        if (size_larger) {
+          matchSizeMap[it->first] = +size_limit;
+        }
+
+        eos_static_info("rule=\"%s %u\"", it->first.c_str(), t);
+      } else {
+        eos_static_err("msg=\"LRU match attribute has no conversion "
+                       "attribute defined\" attr-missing=\"%s\"",
+                       conv_attr.c_str());
+      }
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the time when an expire policy is due for a file
+//------------------------------------------------------------------------------
+time_t LRU::getExpireDue(const std::string& name, time_t ctime,
+                         const std::map<std::string, time_t>& matchAgeMap)
+{
+  XrdOucString fname = name.c_str();
+  time_t due = 0;
+
+  for (auto it = matchAgeMap.begin(); it != matchAgeMap.end(); ++it) {
+    if (fname.matches(it->first.c_str())) {
+      time_t rule_due = ctime + it->second;
+
+      if (!due || (rule_due < due)) {
+        due = rule_due;
+      }
+    }
+  }
+
+  return due;
+}
+
+//------------------------------------------------------------------------------
+// Get the time when a conversion policy is due for a file
+//------------------------------------------------------------------------------
+time_t LRU::getConvertDue(const std::string& name, time_t ctime, uint64_t size,
+                          const std::map<std::string, time_t>& matchAgeMap,
+                          const std::map<std::string, ssize_t>& matchSizeMap,
+                          std::string& rule)
+{
+  XrdOucString fname = name.c_str();
+  time_t due = 0;
+  rule.clear();
+
+  for (auto it = matchAgeMap.begin(); it != matchAgeMap.end(); ++it) {
+    if (!fname.matches(it->first.c_str())) {
+      continue;
+    }
+
+    auto it_size = matchSizeMap.find(it->first);
+
+    if (it_size != matchSizeMap.end()) {
+      if ((it_size->second < 0) && ((ssize_t)size >= -it_size->second)) {
+        continue;
+      }
+
+      if ((it_size->second > 0) && ((ssize_t)size <= it_size->second)) {
+        continue;
+      }
+    }
+
+    time_t rule_due = ctime + it->second;
+
+    if (!due || (rule_due < due)) {
+      due = rule_due;
+      rule = it->first;
+    }
+  }
+
+  return due;
+}
+
 //------------------------------------------------------------------------------
 // Perform a single LRU cycle, QDB namespace
 //------------------------------------------------------------------------------
@@ -190,11 +354,22 @@ void LRU::performCycleQDB(ThreadAssistant& assistant) noexcept
            static_cast<QuarkNamespaceGroup*>(gOFS->namespaceGroup.get())->getExecutor());
   NamespaceItem item;
   int64_t processed = 0;
+  const bool incremental = mIncremental;
+  std::map<IContainerMD::id_t, PolicyDir> policies;
+  std::unordered_map<IContainerMD::id_t, TrackedDir> tracked;
+  std::vector<std::pair<std::string, IContainerMD::id_t>> watermarks;
 
   while (explorer.fetch(item)) {
     eos_static_debug("lru-dir-qdb=\"%s\" attrs=%d", item.fullPath.c_str(),
                      item.attrs.size());
-    processDirectory(item.fullPath,item.attrs);
+
+    if (incremental) {
+      discoverDirectory(item.fullPath, item.containerMd.id(), item.attrs,
+                        policies, tracked, watermarks);
+    } else {
+      processDirectory(item.fullPath, item.attrs);
+    }
+
     processed++;
 
     if (processed % 1000 == 0) {
@@ -203,12 +378,17 @@ void LRU::performCycleQDB(ThreadAssistant& assistant) noexcept
 
       if (assistant.terminationRequested()) {
         eos_static_info("%s", "msg=\"termination requested, quit LRU\"");
-        break;
+        return;
       }
     }
   }
 
   eos_static_info("msg=\"LRU scan done\" num_scanned_dirs=%lli", processed);
+
+  if (incremental) {
+    updateTracking(policies, tracked, assistant);
+    applyPolicies(assistant);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -233,9 +413,28 @@ void LRU::backgroundThread(ThreadAssistant& assistant) noexcept
     // every now and then we wake up
     Options opts = getOptions();
     common::IntervalStopwatch stopwatch(opts.interval);
-
     // Only a master needs to run LRU
-    if (opts.enabled && gOFS->mMaster->IsMaster()) {
+    bool active = opts.enabled && gOFS->mMaster->IsMaster();
+
+    if (active && opts.incremental) {
+      if (!mIncremental) {
+        eos_static_notice("%s", "msg=\"enable incremental LRU\"");
+        mIncremental = true;
+      }
+
+      if (opts.rate != mRate) {
+        if (opts.rate) {
+          mRateLimit.SetRatePerSecond(opts.rate);
+        }
+
+        mRate = opts.rate;
+      }
+    } else if (mIncremental) {
+      eos_static_notice("%s", "msg=\"disable incremental LRU\"");
+      resetIncremental();
+    }
+
+    if (active) {
       performCycleQDB(assistant);
     }
 
@@ -246,9 +445,15 @@ void LRU::backgroundThread(ThreadAssistant& assistant) noexcept
         mRefresh = false;
         break;
       }
+
+      // The candidate queues are applied in between the discovery cycles
+      if (mIncremental && gOFS->mMaster->IsMaster()) {
+        applyPolicies(assistant);
+      }
     }
   }
 
+  resetIncremental();
   eos_static_notice("%s", "msg=\"stopped LRU thread\"");
 }
 
@@ -292,6 +497,571 @@ void LRU::processDirectory(const std::string& dir,
   }
 }
 
+//------------------------------------------------------------------------------
+// Queue files of tracked directories for the candidate queues
+//------------------------------------------------------------------------------
+void
+LRU::fileMDChanged(IFileMDChangeListener::Event* event)
+{
+  if (!mIncremental) {
+    return;
+  }
+
+  // Creations are not tracked, the file is not attached yet. Attaching it to
+  // a container and every size update come as SizeChange with the container.
+  if (event->action != IFileMDChangeListener::SizeChange) {
+    return;
+  }
+
+  IContainerMD::id_t cid = event->file->getContainerId();
+
+  // A file removed from a container passes the container as location
+  if (cid == 0) {
+    cid = event->location;
+  }
+
+  std::lock_guard<std::mutex> lock(mEventMutex);
+
+  if ((cid == 0) || !mTrackedDirs.count(cid)) {
+    return;
+  }
+
+  if (mPendingEvents.size() >= cMaxPendingEvents) {
+    if (!mEventsOverflow) {
+      eos_static_warning("msg=\"LRU event queue full, dropping events until "
+                         "the next cycle\" max=%lu", cMaxPendingEvents);
+      mEventsOverflow = true;
+    }
+
+    return;
+  }
+
+  mPendingEvents.emplace(event->file->getId(), cid);
+}
+
+//------------------------------------------------------------------------------
+// Record the policies of a directory found by a discovery cycle
+//------------------------------------------------------------------------------
+void
+LRU::discoverDirectory(const std::string& dir, IContainerMD::id_t cid,
+                       const eos::IContainerMD::XAttrMap& map,
+                       std::map<IContainerMD::id_t, PolicyDir>& policies,
+                       std::unordered_map<IContainerMD::id_t, TrackedDir>& tracked,
+                       std::vector<std::pair<std::string, IContainerMD::id_t>>& watermarks)
+{
+  // No LRU on "/" and in the proc directory
+  if ((dir == "/") || dir.empty() ||
+      (dir.substr(0, gOFS->MgmProcPath.length()) == gOFS->MgmProcPath.c_str())) {
+    return;
+  }
+
+  // Empty directories are checked right away, this does not list anything
+  auto it_empty = map.find("sys.lru.expire.empty");
+
+  if (it_empty != map.end()) {
+    AgeExpireEmpty(dir.c_str(), it_empty->second);
+  }
+
+  while (!watermarks.empty() && (dir.find(watermarks.back().first) != 0)) {
+    watermarks.pop_back();
+  }
+
+  bool direct = (map.count("sys.lru.expire.match") ||
+                 map.count("sys.lru.convert.match"));
+  // Same condition as CacheExpire, the policy needs a quota node
+  bool watermark = (map.count("sys.lru.lowwatermark") &&
+                    map.count("sys.lru.highwatermark") && Quota::Exists(dir));
+
+  if (direct || watermark) {
+    PolicyDir& policy = policies[cid];
+    policy.mPath = dir;
+    policy.mWatermark = watermark;
+
+    for (const auto& attr : map) {
+      if ((attr.first.find("sys.lru.") == 0) ||
+          (attr.first.find("sys.conversion.") == 0) ||
+          (attr.first == "sys.forced.space") ||
+          (attr.first == "user.forced.space")) {
+        policy.mAttrs.insert(attr);
+      }
+    }
+  }
+
+  if (watermark) {
+    watermarks.emplace_back(dir, cid);
+  }
+
+  if (direct || !watermarks.empty()) {
+    TrackedDir& entry = tracked[cid];
+    entry.mPath = dir;
+    entry.mDirect = (direct ? cid : 0);
+    entry.mCache = (watermarks.empty() ? 0 : watermarks.back().second);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Update the policy directories and the tracked directories from a discovery
+// cycle and populate the queues of new tracked directories
+//------------------------------------------------------------------------------
+void
+LRU::updateTracking(std::map<IContainerMD::id_t, PolicyDir>& policies,
+                    std::unordered_map<IContainerMD::id_t, TrackedDir>& tracked,
+                    ThreadAssistant& assistant)
+{
+  // Keep the queues of the policies which did not change
+  for (auto& elem : policies) {
+    PolicyDir& policy = elem.second;
+    auto it = mPolicyDirs.find(elem.first);
+
+    if ((it != mPolicyDirs.end()) && (it->second.mPath == policy.mPath) &&
+        (it->second.mWatermark == policy.mWatermark) &&
+        (it->second.mAttrs == policy.mAttrs)) {
+      policy = std::move(it->second);
+      continue;
+    }
+
+    eos_static_info("msg=\"LRU tracking policy directory\" path=\"%s\" "
+                    "watermark=%d", policy.mPath.c_str(), policy.mWatermark);
+    policy.mGeneration = ++mGeneration;
+    auto it_expire = policy.mAttrs.find("sys.lru.expire.match");
+
+    if ((it_expire != policy.mAttrs.end()) &&
+        !parseExpireMatchPolicy(it_expire->second, policy.mExpireAge)) {
+      eos_static_err("msg=\"LRU match attribute is illegal\" val=\"%s\"",
+                     it_expire->second.c_str());
+    }
+
+    if (policy.mAttrs.count("sys.lru.convert.match")) {
+      (void) parseConvertMatchPolicy(policy.mAttrs, policy.mConvertAge,
+                                     policy.mConvertSize);
+    }
+  }
+
+  mPolicyDirs.swap(policies);
+  std::vector<std::pair<IContainerMD::id_t, TrackedDir>> populate;
+  bool resync = false;
+  {
+    std::lock_guard<std::mutex> lock(mEventMutex);
+    resync = mEventsOverflow;
+    mEventsOverflow = false;
+
+    for (auto& elem : tracked) {
+      TrackedDir& entry = elem.second;
+      uint64_t generation = 0;
+      auto it_direct = mPolicyDirs.find(entry.mDirect);
+      auto it_cache = mPolicyDirs.find(entry.mCache);
+
+      if (entry.mDirect && (it_direct != mPolicyDirs.end())) {
+        generation = it_direct->second.mGeneration;
+      }
+
+      if (entry.mCache && (it_cache != mPolicyDirs.end())) {
+        generation = std::max(generation, it_cache->second.mGeneration);
+      }
+
+      auto it = mTrackedDirs.find(elem.first);
+
+      if (resync || (it == mTrackedDirs.end()) ||
+          (it->second.mDirect != entry.mDirect) ||
+          (it->second.mCache != entry.mCache) ||
+          (it->second.mGeneration < generation)) {
+        entry.mGeneration = generation;
+        populate.emplace_back(elem.first, entry);
+      } else {
+        entry.mGeneration = it->second.mGeneration;
+      }
+    }
+
+    mTrackedDirs.swap(tracked);
+  }
+
+  if (resync) {
+    eos_static_warning("%s", "msg=\"LRU events were dropped, repopulating all "
+                       "candidate queues\"");
+
+    for (auto& elem : mPolicyDirs) {
+      elem.second.mExpire.Clear();
+      elem.second.mConvert.Clear();
+      elem.second.mCache.Clear();
+    }
+  }
+
+  // Directories are listed only after they are tracked, changes happening
+  // in the meantime are applied from the events
+  for (const auto& elem : populate) {
+    if (assistant.terminationRequested()) {
+      return;
+    }
+
+    populateDirectory(elem.first, elem.second);
+  }
+
+  eos_static_info("msg=\"LRU tracking updated\" policy_dirs=%lu "
+                  "tracked_dirs=%lu populated_dirs=%lu", mPolicyDirs.size(),
+                  mTrackedDirs.size(), populate.size());
+}
+
+//------------------------------------------------------------------------------
+// List a tracked directory and queue all its files
+//------------------------------------------------------------------------------
+void
+LRU::populateDirectory(IContainerMD::id_t cid, const TrackedDir& tracked)
+{
+  std::shared_ptr<eos::IContainerMD> cmd;
+  eos::Prefetcher::prefetchContainerMDWithChildrenAndWait(gOFS->eosView,
+      tracked.mPath);
+  RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  try {
+    cmd = gOFS->eosDirectoryService->getContainerMD(cid);
+    lock.Release();
+
+    for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
+      std::shared_ptr<eos::IFileMD> fmd = cmd->findFile(it.key());
+
+      if (fmd) {
+        queueFile(fmd, tracked);
+      }
+    }
+  } catch (eos::MDException& e) {
+    eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\" path=\"%s\"",
+                   e.getErrno(), e.getMessage().str().c_str(),
+                   tracked.mPath.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Update the candidate queues with the current state of a file
+//------------------------------------------------------------------------------
+void
+LRU::queueFile(const std::shared_ptr<eos::IFileMD>& fmd,
+               const TrackedDir& tracked)
+{
+  const FileId::fileid_t fid = fmd->getId();
+  const std::string name = fmd->getName();
+  const uint64_t size = fmd->getSize();
+  eos::IFileMD::ctime_t ctime;
+  fmd->getCTime(ctime);
+  auto it = mPolicyDirs.find(tracked.mDirect);
+
+  if (tracked.mDirect && (it != mPolicyDirs.end())) {
+    PolicyDir& policy = it->second;
+
+    if (!policy.mExpireAge.empty()) {
+      time_t due = getExpireDue(name, ctime.tv_sec, policy.mExpireAge);
+
+      if (due) {
+        policy.mExpire.Update(fid, due, size);
+      } else {
+        policy.mExpire.Remove(fid);
+      }
+    }
+
+    if (!policy.mConvertAge.empty()) {
+      std::string rule;
+      time_t due = getConvertDue(name, ctime.tv_sec, size, policy.mConvertAge,
+                                 policy.mConvertSize, rule);
+
+      if (due) {
+        policy.mConvert.Update(fid, due, size);
+      } else {
+        policy.mConvert.Remove(fid);
+      }
+    }
+  }
+
+  it = mPolicyDirs.find(tracked.mCache);
+
+  if (tracked.mCache && (it != mPolicyDirs.end()) && it->second.mWatermark) {
+    it->second.mCache.Update(fid, ctime.tv_sec, size);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop a file from the candidate queues of a tracked directory
+//------------------------------------------------------------------------------
+void
+LRU::unqueueFile(FileId::fileid_t fid, const TrackedDir& tracked)
+{
+  auto it = mPolicyDirs.find(tracked.mDirect);
+
+  if (tracked.mDirect && (it != mPolicyDirs.end())) {
+    it->second.mExpire.Remove(fid);
+    it->second.mConvert.Remove(fid);
+  }
+
+  it = mPolicyDirs.find(tracked.mCache);
+
+  if (tracked.mCache && (it != mPolicyDirs.end())) {
+    it->second.mCache.Remove(fid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get a file and its path
+//------------------------------------------------------------------------------
+std::shared_ptr<eos::IFileMD>
+LRU::fetchFile(FileId::fileid_t fid, std::string& path)
+{
+  std::shared_ptr<eos::IFileMD> fmd;
+  eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
+  RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  try {
+    fmd = gOFS->eosFileService->getFileMD(fid);
+
+    if (fmd->getContainerId() == 0) {
+      return nullptr;
+    }
+
+    path = gOFS->eosView->getUri(fmd.get());
+  } catch (eos::MDException& e) {
+    return nullptr;
+  }
+
+  return fmd;
+}
+
+//------------------------------------------------------------------------------
+// Apply the queued file change events to the candidate queues
+//------------------------------------------------------------------------------
+void
+LRU::processEvents()
+{
+  std::set<std::pair<FileId::fileid_t, IContainerMD::id_t>> events;
+  {
+    std::lock_guard<std::mutex> lock(mEventMutex);
+    events.swap(mPendingEvents);
+  }
+
+  if (events.empty()) {
+    return;
+  }
+
+  for (const auto& event : events) {
+    TrackedDir previous;
+    TrackedDir current;
+    bool has_previous = false;
+    bool has_current = false;
+
+    if (event.second) {
+      std::lock_guard<std::mutex> lock(mEventMutex);
+      auto it = mTrackedDirs.find(event.second);
+
+      if (it != mTrackedDirs.end()) {
+        previous = it->second;
+        has_previous = true;
+      }
+    }
+
+    if (has_previous) {
+      unqueueFile(event.first, previous);
+    }
+
+    std::string path;
+    std::shared_ptr<eos::IFileMD> fmd = fetchFile(event.first, path);
+
+    if (!fmd) {
+      continue;
+    }
+
+    IContainerMD::id_t cid = fmd->getContainerId();
+
+    if (has_previous && (cid == event.second)) {
+      current = previous;
+      has_current = true;
+    } else {
+      std::lock_guard<std::mutex> lock(mEventMutex);
+      auto it = mTrackedDirs.find(cid);
+
+      if (it != mTrackedDirs.end()) {
+        current = it->second;
+        has_current = true;
+      }
+    }
+
+    if (has_current) {
+      queueFile(fmd, current);
+    }
+  }
+
+  gOFS->MgmStats.Add("LRU::Events", 0, 0, events.size());
+}
+
+//------------------------------------------------------------------------------
+// Pop and apply all due candidates of the policy directories
+//------------------------------------------------------------------------------
+void
+LRU::applyPolicies(ThreadAssistant& assistant)
+{
+  processEvents();
+  time_t now = time(NULL);
+  time_t max_lag = 0;
+  size_t num_candidates = 0;
+  LRUCandidates::Candidate candidate;
+  // Record the time between a policy becoming due and being applied
+  auto record_lag = [&](time_t due) {
+    time_t lag = (now > due) ? (now - due) : 0;
+    max_lag = std::max(max_lag, lag);
+    gOFS->MgmStats.AddExec("LRU::Lag", lag * 1000.0);
+  };
+  auto rate_limit = [&]() {
+    if (mRate) {
+      mRateLimit.Allow();
+    }
+  };
+
+  for (auto& elem : mPolicyDirs) {
+    const IContainerMD::id_t cid = elem.first;
+    PolicyDir& policy = elem.second;
+
+    while (!assistant.terminationRequested() &&
+           policy.mExpire.Pop(now, candidate)) {
+      std::string path;
+      std::shared_ptr<eos::IFileMD> fmd = fetchFile(candidate.mFid, path);
+
+      if (!fmd || (fmd->getContainerId() != cid)) {
+        continue;
+      }
+
+      // The file may have changed since it was queued
+      eos::IFileMD::ctime_t ctime;
+      fmd->getCTime(ctime);
+      time_t due = getExpireDue(fmd->getName(), ctime.tv_sec, policy.mExpireAge);
+
+      if (!due) {
+        continue;
+      }
+
+      if (due > now) {
+        policy.mExpire.Update(candidate.mFid, due, fmd->getSize());
+        continue;
+      }
+
+      rate_limit();
+      eos_static_notice("msg=\"delete expired file\" path=\"%s\" ctime=%u "
+                        "age=%u", path.c_str(), ctime.tv_sec,
+                        now - ctime.tv_sec);
+
+      if (gOFS->_rem(path.c_str(), mError, mRootVid, "")) {
+        eos_static_err("msg=\"failed to expire file\" path=\"%s\"", path.c_str());
+      } else {
+        policy.mConvert.Remove(candidate.mFid);
+        record_lag(due);
+        gOFS->MgmStats.Add("LRU::Expire", 0, 0, 1);
+      }
+    }
+
+    while (!assistant.terminationRequested() &&
+           policy.mConvert.Pop(now, candidate)) {
+      std::string path;
+      std::shared_ptr<eos::IFileMD> fmd = fetchFile(candidate.mFid, path);
+
+      if (!fmd || (fmd->getContainerId() != cid)) {
+        continue;
+      }
+
+      std::string rule;
+      eos::IFileMD::ctime_t ctime;
+      fmd->getCTime(ctime);
+      time_t due = getConvertDue(fmd->getName(), ctime.tv_sec, fmd->getSize(),
+                                 policy.mConvertAge, policy.mConvertSize, rule);
+
+      if (!due) {
+        continue;
+      }
+
+      if (due > now) {
+        policy.mConvert.Update(candidate.mFid, due, fmd->getSize());
+        continue;
+      }
+
+      std::string conversion = policy.mAttrs["sys.conversion." + rule];
+      unsigned long long lid = strtoll(conversion.c_str(), 0, 16);
+
+      if (fmd->getLayoutId() == lid) {
+        eos_static_debug("msg=\"skipping conversion - file has already "
+                         "the desired target layout\" fxid=%08llx", fmd->getId());
+        continue;
+      }
+
+      rate_limit();
+      eos_static_notice("msg=\"convert expired file\" path=\"%s\" ctime=%u "
+                        "age=%u fxid=%08llx layout=\"%s\"", path.c_str(),
+                        ctime.tv_sec, now - ctime.tv_sec,
+                        (unsigned long long) fmd->getId(), conversion.c_str());
+
+      if (scheduleConversion(candidate.mFid, conversion, policy.mAttrs)) {
+        record_lag(due);
+        gOFS->MgmStats.Add("LRU::Convert", 0, 0, 1);
+      }
+    }
+
+    if (policy.mWatermark && policy.mCache.Size()) {
+      unsigned long long bytes_to_free =
+        getBytesToFree(policy.mPath.c_str(), policy.mAttrs["sys.lru.lowwatermark"],
+                       policy.mAttrs["sys.lru.highwatermark"]);
+      unsigned long long freed = 0;
+
+      // Delete starting with the 'oldest' entry until we have freed enough
+      // space to go under the low watermark
+      while ((freed < bytes_to_free) && !assistant.terminationRequested() &&
+             policy.mCache.Pop(0, candidate)) {
+        std::string path;
+        std::shared_ptr<eos::IFileMD> fmd = fetchFile(candidate.mFid, path);
+
+        if (!fmd || (path.find(policy.mPath) != 0)) {
+          continue;
+        }
+
+        eos::IFileMD::ctime_t ctime;
+        fmd->getCTime(ctime);
+
+        if (ctime.tv_sec != candidate.mDue) {
+          policy.mCache.Update(candidate.mFid, ctime.tv_sec, fmd->getSize());
+          continue;
+        }
+
+        rate_limit();
+        eos_static_notice("msg=\"delete LRU file\" path=\"%s\" ctime=%lu "
+                          "size=%llu", path.c_str(), ctime.tv_sec,
+                          fmd->getSize());
+
+        if (gOFS->_rem(path.c_str(), mError, mRootVid, "")) {
+          eos_static_err("msg=\"failed to expire file\" path=\"%s\"",
+                         path.c_str());
+        } else {
+          freed += fmd->getSize();
+          gOFS->MgmStats.Add("LRU::CacheExpire", 0, 0, 1);
+        }
+      }
+    }
+
+    num_candidates += policy.mExpire.Size() + policy.mConvert.Size() +
+                      policy.mCache.Size();
+  }
+
+  eos_static_debug("msg=\"LRU policies applied\" policy_dirs=%lu "
+                   "candidates=%lu max_lag=%lus", mPolicyDirs.size(),
+                   num_candidates, max_lag);
+}
+
+//------------------------------------------------------------------------------
+// Drop all state of the incremental engine
+//------------------------------------------------------------------------------
+void
+LRU::resetIncremental()
+{
+  mIncremental = false;
+  {
+    std::lock_guard<std::mutex> lock(mEventMutex);
+    mTrackedDirs.clear();
+    mPendingEvents.clear();
+    mEventsOverflow = false;
+  }
+  mPolicyDirs.clear();
+}
+
 //------------------------------------------------------------------------------
 // Remove empty directories if they are older than age given in policy
 //------------------------------------------------------------------------------
@@ -401,19 +1171,15 @@ LRU::AgeExpire(const char* dir, const std::string& policy)
 }
 
 //------------------------------------------------------------------------------
-// Expire the oldest files to go under the low watermark
+// Compute the number of bytes a watermark policy has to free
 //------------------------------------------------------------------------------
-void
-LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
-
+unsigned long long
+LRU::getBytesToFree(const char* dir, const std::string& lowmark,
+                    const std::string& highmark)
 {
-  eos_static_info("msg=\"applying volume deletion policy\" "
-                  "dir=\"%s\" low-mark=\"%s\" high-mark=\"%s\"",
-                  dir, lowmark.c_str(), highmark.c_str());
-
   // Update space quota, return if this is not a ns quota node
   if (!Quota::UpdateFromNsQuota(dir, 0, 0)) {
-    return;
+    return 0;
   }
 
   // Check for project quota
@@ -422,7 +1188,7 @@ LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
   long long is_volume = map_quotas[SpaceQuota::kGroupBytesIs];
 
   if (target_volume <= 0) {
-    return;
+    return 0;
   }
 
   errno = 0;
@@ -432,7 +1198,7 @@ LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
     eos_static_err("msg=\"low watermark value is illegal - "
                    "must be 0 < lw < 100\" low-watermark=\"%s\"",
                    lowmark.c_str());
-    return;
+    return 0;
   }
 
   errno = 0;
@@ -443,7 +1209,7 @@ LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
                    "must be 0 < lw < hw < 100\" "
                    "low_watermark=\"%s\" high-watermark=\"%s\"",
                    lowmark.c_str(), highmark.c_str());
-    return;
+    return 0;
   }
 
   double cwm = 100.0 * is_volume / target_volume;
@@ -451,7 +1217,7 @@ LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
 
   // check if we have to do cache cleanup e.g. current is over high water mark
   if (cwm < hwm) {
-    return;
+    return 0;
   }
 
   unsigned long long bytes_to_free = is_volume - (lwm * target_volume / 100.0);
@@ -459,6 +1225,25 @@ LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
   eos_static_notice("low-mark=%.02f high-mark=%.02f current-mark=%.02f "
                     "deletion-bytes=%s", lwm, hwm,  cwm,
                     StringConversion::GetReadableSizeString(sizestring, bytes_to_free, "B"));
+  return bytes_to_free;
+}
+
+//------------------------------------------------------------------------------
+// Expire the oldest files to go under the low watermark
+//------------------------------------------------------------------------------
+void
+LRU::CacheExpire(const char* dir, std::string& lowmark, std::string& highmark)
+
+{
+  eos_static_info("msg=\"applying volume deletion policy\" "
+                  "dir=\"%s\" low-mark=\"%s\" high-mark=\"%s\"",
+                  dir, lowmark.c_str(), highmark.c_str());
+  unsigned long long bytes_to_free = getBytesToFree(dir, lowmark, highmark);
+
+  if (!bytes_to_free) {
+    return;
+  }
+
   // Build the LRU list
   std::map<std::string, std::set<std::string> > cachedirs;
   XrdOucString stdErr;
@@ -551,86 +1336,14 @@ LRU::ConvertMatch(const char* dir,
 {
   eos_static_info("msg=\"applying match policy\" dir=\"%s\" match=\"%s\"",
                   dir, map["sys.lru.convert.match"].c_str());
-  std::map < std::string, std::string> lMatchMap;
   std::map < std::string, time_t> lMatchAgeMap;
   std::map < std::string, ssize_t> lMatchSizeMap;
   time_t now = time(NULL);
 
-  if (!StringConversion::GetKeyValueMap(map["sys.lru.convert.match"].c_str(),
-                                        lMatchMap,
-                                        ":")
-     ) {
-    eos_static_err("msg=\"LRU match attribute is illegal\" val=\"%s\"",
-                   map["sys.lru.convert.match"].c_str());
+  if (!parseConvertMatchPolicy(map, lMatchAgeMap, lMatchSizeMap)) {
     return;
   }
 
-  for (auto it = lMatchMap.begin(); it != lMatchMap.end(); it++) {
-    std::string time_tag;
-    std::string size_tag;
-    eos::common::StringConversion::SplitKeyValue(it->second, time_tag, size_tag);
-
-    if (time_tag.empty()) {
-      time_tag = it->second;
-    }
-
-    bool size_smaller = false;
-    bool size_larger  = false;
-    size_t size_limit = 0;
-
-    if (size_tag.length()) {
-      if (size_tag.substr(0, 1) == "<") {
-        size_smaller = true;
-      }
-
-      if (size_tag.substr(0, 1) == ">") {
-        size_larger = true;
-      }
-
-      size_tag.erase(0, 1);
-
-      if (!size_smaller && !size_larger) {
-        eos_static_err("msg=\"LRU match attribute has illegal size\" "
-                       " match=\"%s\", size=\"%s\"",
-                       it->first.c_str(),
-                       size_tag.c_str());
-      } else {
-        size_limit = eos::common::StringConversion::GetSizeFromString(size_tag.c_str());
-      }
-    }
-
-    eos_static_info("time-tag=%s size-tag=%s <%d >%d limit=%lu", time_tag.c_str(),
-                    size_tag.c_str(), size_smaller, size_larger, size_limit);
-    time_t t = eos::common::StringConversion::GetSizeFromString(time_tag.c_str());
-
-    if (errno) {
-      eos_static_err("msg=\"LRU match attribute has illegal age\" "
-                     "match=\"%s\", age=\"%s\"", it->first.c_str(),
-                     time_tag.c_str());
-    } else {
-      std::string conv_attr = "sys.conversion.";
-      conv_attr += it->first;
-
-      if (map.count(conv_attr)) {
-        lMatchAgeMap[it->first] = t;
-
-        if (size_smaller) {
-          lMatchSizeMap[it->first] = -size_limit;
-        }
-
-        if (size_larger) {
-          lMatchSizeMap[it->first] = +size_limit;
-        }
-
-        eos_static_info("rule=\"%s %u\"", it->first.c_str(), t);
-      } else {
-        eos_static_err("msg=\"LRU match attribute has no conversion "
-                       "attribute defined\" attr-missing=\"%s\"",
-                       conv_attr.c_str());
-      }
-    }
-  }
-
   std::vector < std::pair<FileId::fileid_t, std::string> > lConversionList;
   {
     // Check the directory contents
@@ -742,57 +1455,68 @@ LRU::ConvertMatch(const char* dir,
   }
 
   for (auto it = lConversionList.begin(); it != lConversionList.end(); it++) {
-    const eos::common::FileId::fileid_t fid = it->first;
-    std::string conversion = it->second;
-    std::string plctplcy;
+    scheduleConversion(it->first, it->second, map);
+  }
+}
 
-    if (((int)conversion.find("|")) != STR_NPOS) {
-      eos::common::StringConversion::SplitKeyValue(conversion, conversion, plctplcy,
-          "|");
-      plctplcy = "~" + plctplcy;
-    }
+//------------------------------------------------------------------------------
+// Schedule the conversion of a file
+//------------------------------------------------------------------------------
+bool
+LRU::scheduleConversion(eos::common::FileId::fileid_t fid,
+                        std::string conversion,
+                        const eos::IContainerMD::XAttrMap& map)
+{
+  std::string plctplcy;
 
-    char conversiontagfile[1024];
-    std::string space;
+  if (((int)conversion.find("|")) != STR_NPOS) {
+    eos::common::StringConversion::SplitKeyValue(conversion, conversion, plctplcy,
+        "|");
+    plctplcy = "~" + plctplcy;
+  }
 
-    if (map.count("user.forced.space")) {
-      space = map["user.forced.space"];
-    }
+  char conversiontagfile[1024];
+  std::string space;
 
-    if (map.count("sys.forced.space")) {
-      space = map["sys.forced.space"];
-    }
+  if (map.count("user.forced.space")) {
+    space = map.at("user.forced.space");
+  }
 
-    if (map.count("sys.lru.conversion.space")) {
-      space = map["sys.lru.conversion.space"];
-    }
+  if (map.count("sys.forced.space")) {
+    space = map.at("sys.forced.space");
+  }
 
-    // the conversion value can be directory an layout env representation like
-    // "eos.space=...&eos.layout ..."
-    XrdOucEnv cenv(conversion.c_str());
+  if (map.count("sys.lru.conversion.space")) {
+    space = map.at("sys.lru.conversion.space");
+  }
 
-    if (cenv.Get("eos.space")) {
-      space = cenv.Get("eos.space");
-    }
+  // the conversion value can be directory an layout env representation like
+  // "eos.space=...&eos.layout ..."
+  XrdOucEnv cenv(conversion.c_str());
 
-    snprintf(conversiontagfile, sizeof(conversiontagfile) - 1,
-             "%s/%016llx:%s#%s%s",
-             gOFS->MgmProcConversionPath.c_str(), it->first, space.c_str(),
-             conversion.c_str(), plctplcy.c_str());
-    std::string conv_tag = conversiontagfile;
-    conv_tag.erase(0, gOFS->MgmProcConversionPath.length() + 1);
-    // For the new converted we need to tell it explicitly that we want the
-    // ctime to be updated since this doesn't happen by default
-    conv_tag += eos::mgm::ConversionInfo::UPDATE_CTIME;
+  if (cenv.Get("eos.space")) {
+    space = cenv.Get("eos.space");
+  }
 
-    if (gOFS->mConverterDriver->ScheduleJob(fid, conv_tag)) {
-      eos_static_info("msg=\"LRU scheduled conversion job\" tag=\"%s\"",
-                      conv_tag.c_str());
-    } else {
-      eos_static_err("msg=\"LRU failed to schedule conversion job\" "
-                     "tag=\"%s\"", conv_tag.c_str());
-    }
+  snprintf(conversiontagfile, sizeof(conversiontagfile) - 1,
+           "%s/%016llx:%s#%s%s",
+           gOFS->MgmProcConversionPath.c_str(), fid, space.c_str(),
+           conversion.c_str(), plctplcy.c_str());
+  std::string conv_tag = conversiontagfile;
+  conv_tag.erase(0, gOFS->MgmProcConversionPath.length() + 1);
+  // For the new converted we need to tell it explicitly that we want the
+  // ctime to be updated since this doesn't happen by default
+  conv_tag += eos::mgm::ConversionInfo::UPDATE_CTIME;
+
+  if (gOFS->mConverterDriver->ScheduleJob(fid, conv_tag)) {
+    eos_static_info("msg=\"LRU scheduled conversion job\" tag=\"%s\"",
+                    conv_tag.c_str());
+    return true;
   }
+
+  eos_static_err("msg=\"LRU failed to schedule conversion job\" "
+                 "tag=\"%s\"", conv_tag.c_str());
+  return false;
 }
 
 
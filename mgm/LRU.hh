@@ -23,12 +23,21 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/LRUCandidates.hh"
 #include "common/Mapping.hh"
 #include "common/AssistedThread.hh"
+#include "common/FileId.hh"
+#include "common/RateLimit.hh"
 #include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IFileMDSvc.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include <sys/types.h>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace qclient
 {
@@ -39,8 +48,14 @@ EOSMGMNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 // @brief  This class implements an LRU engine
+//
+// By default every cycle lists and stats the contents of all directories with
+// an LRU policy. With "lru.incremental" enabled the cycle only discovers the
+// policy directories and lists the ones it has not seen before. Their files
+// are kept in per-policy candidate queues which are updated from the file
+// change events of the namespace and applied every few seconds.
 //------------------------------------------------------------------------------
-class LRU
+class LRU : public eos::IFileMDChangeListener
 {
 public:
   static const char* gLRUPolicyPrefix;
@@ -51,6 +66,8 @@ public:
   struct Options {
     bool enabled;                  //< Is LRU even enabled?
     std::chrono::seconds interval; //< Run LRU every this many seconds.
+    bool incremental;              //< Use the event driven candidate queues
+    unsigned long long rate;       //< Max policy actions per second, 0 no limit
   };
 
   //----------------------------------------------------------------------------
@@ -61,6 +78,44 @@ public:
   static bool parseExpireMatchPolicy(const std::string& policy,
                                      std::map<std::string, time_t>& matchAgeMap);
 
+  //----------------------------------------------------------------------------
+  //! Parse an "sys.lru.convert.match" policy, rules without a matching
+  //! "sys.conversion.<match>" attribute are skipped
+  //!
+  //! @param map directory attributes
+  //! @param matchAgeMap rule to age map
+  //! @param matchSizeMap rule to size limit map, negative for files smaller
+  //!        and positive for files larger than the limit
+  //!
+  //! @return true if parsing succeeded, false otherwise
+  //----------------------------------------------------------------------------
+  static bool parseConvertMatchPolicy(const eos::IContainerMD::XAttrMap& map,
+                                      std::map<std::string, time_t>& matchAgeMap,
+                                      std::map<std::string, ssize_t>& matchSizeMap);
+
+  //----------------------------------------------------------------------------
+  //! Get the time when an expire policy is due for a file
+  //!
+  //! @return earliest ctime + age of the matching rules or 0 if no rule
+  //!         matches the file name
+  //----------------------------------------------------------------------------
+  static time_t getExpireDue(const std::string& name, time_t ctime,
+                             const std::map<std::string, time_t>& matchAgeMap);
+
+  //----------------------------------------------------------------------------
+  //! Get the time when a conversion policy is due for a file
+  //!
+  //! @param rule set to the rule with the earliest due time
+  //!
+  //! @return earliest ctime + age of the rules matching the file name and
+  //!         size or 0 if no rule matches
+  //----------------------------------------------------------------------------
+  static time_t getConvertDue(const std::string& name, time_t ctime,
+                              uint64_t size,
+                              const std::map<std::string, time_t>& matchAgeMap,
+                              const std::map<std::string, ssize_t>& matchSizeMap,
+                              std::string& rule);
+
   //----------------------------------------------------------------------------
   //! Retrieve current LRU configuration options
   //----------------------------------------------------------------------------
@@ -80,7 +135,7 @@ public:
   //----------------------------------------------------------------------------
   //! Destructor - stop the background thread, if running
   //----------------------------------------------------------------------------
-  ~LRU();
+  virtual ~LRU();
 
   //----------------------------------------------------------------------------
   //! Start the LRU thread
@@ -123,6 +178,23 @@ public:
   //----------------------------------------------------------------------------
   void ConvertMatch(const char* dir, eos::IContainerMD::XAttrMap& map);
 
+  //----------------------------------------------------------------------------
+  //! Queue files of tracked directories for the candidate queues, called by
+  //! the namespace file service
+  //----------------------------------------------------------------------------
+  void fileMDChanged(IFileMDChangeListener::Event* event) override;
+
+  void fileMDRead(IFileMD* obj) override {}
+
+  bool fileMDCheck(IFileMD* obj) override
+  {
+    return true;
+  }
+
+  void AddTree(IContainerMD* obj, int64_t dsize) override {}
+
+  void RemoveTree(IContainerMD* obj, int64_t dsize) override {}
+
   //----------------------------------------------------------------------------
   //! Signal the LRU stat it shoudl refresh it's options
   //----------------------------------------------------------------------------
@@ -173,11 +245,137 @@ private:
   //----------------------------------------------------------------------------
   void performCycleQDB(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Compute the number of bytes a watermark policy has to free
+  //!
+  //! @return bytes to free or 0 if the directory is below the high watermark
+  //!         or the policy does not apply
+  //----------------------------------------------------------------------------
+  unsigned long long getBytesToFree(const char* dir, const std::string& lowmark,
+                                    const std::string& highmark);
+
+  //----------------------------------------------------------------------------
+  //! Schedule the conversion of a file
+  //!
+  //! @param fid file id
+  //! @param conversion value of the "sys.conversion.<match>" attribute
+  //! @param map directory attributes
+  //!
+  //! @return true if the conversion job was scheduled, otherwise false
+  //----------------------------------------------------------------------------
+  bool scheduleConversion(eos::common::FileId::fileid_t fid,
+                          std::string conversion,
+                          const eos::IContainerMD::XAttrMap& map);
+
+  //! Directory with LRU policies handled by the incremental engine
+  struct PolicyDir {
+    std::string mPath;
+    eos::IContainerMD::XAttrMap mAttrs; ///< Policy attributes
+    std::map<std::string, time_t> mExpireAge; ///< Parsed expire rules
+    std::map<std::string, time_t> mConvertAge; ///< Parsed conversion rules
+    std::map<std::string, ssize_t> mConvertSize; ///< Conversion size limits
+    bool mWatermark {false}; ///< Watermark policy on the subtree
+    LRUCandidates mExpire; ///< Files by ctime + expire age
+    LRUCandidates mConvert; ///< Files by ctime + conversion age
+    LRUCandidates mCache; ///< Subtree files by ctime
+    uint64_t mGeneration {0}; ///< Changed whenever the policy changes
+  };
+
+  //! Directory whose files are candidates of policy directories
+  struct TrackedDir {
+    std::string mPath;
+    eos::IContainerMD::id_t mDirect {0}; ///< Expire/conversion policy
+    eos::IContainerMD::id_t mCache {0}; ///< Watermark policy
+    uint64_t mGeneration {0}; ///< Newest policy generation when listed
+  };
+
+  //----------------------------------------------------------------------------
+  //! Record the policies of a directory found by a discovery cycle
+  //!
+  //! @param dir directory path
+  //! @param cid directory container id
+  //! @param map directory attributes
+  //! @param policies policy directories found so far
+  //! @param tracked tracked directories found so far
+  //! @param watermarks enclosing watermark policy directories as path and
+  //!        container id pairs, innermost last
+  //----------------------------------------------------------------------------
+  void discoverDirectory(const std::string& dir, eos::IContainerMD::id_t cid,
+                         const eos::IContainerMD::XAttrMap& map,
+                         std::map<eos::IContainerMD::id_t, PolicyDir>& policies,
+                         std::unordered_map<eos::IContainerMD::id_t, TrackedDir>& tracked,
+                         std::vector<std::pair<std::string, eos::IContainerMD::id_t>>&
+                         watermarks);
+
+  //----------------------------------------------------------------------------
+  //! Get a file and its path
+  //!
+  //! @return file object or nullptr if the file does not exist or is detached
+  //----------------------------------------------------------------------------
+  std::shared_ptr<eos::IFileMD> fetchFile(eos::common::FileId::fileid_t fid,
+                                          std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Update the candidate queues with the current state of a file
+  //----------------------------------------------------------------------------
+  void queueFile(const std::shared_ptr<eos::IFileMD>& fmd,
+                 const TrackedDir& tracked);
+
+  //----------------------------------------------------------------------------
+  //! Drop a file from the candidate queues of a tracked directory
+  //----------------------------------------------------------------------------
+  void unqueueFile(eos::common::FileId::fileid_t fid, const TrackedDir& tracked);
+
+  //----------------------------------------------------------------------------
+  //! List a tracked directory and queue all its files
+  //----------------------------------------------------------------------------
+  void populateDirectory(eos::IContainerMD::id_t cid, const TrackedDir& tracked);
+
+  //----------------------------------------------------------------------------
+  //! Update the policy directories and the tracked directories from a
+  //! discovery cycle and populate the queues of new tracked directories
+  //----------------------------------------------------------------------------
+  void updateTracking(std::map<eos::IContainerMD::id_t, PolicyDir>& policies,
+                      std::unordered_map<eos::IContainerMD::id_t, TrackedDir>& tracked,
+                      ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! Apply the queued file change events to the candidate queues
+  //----------------------------------------------------------------------------
+  void processEvents();
+
+  //----------------------------------------------------------------------------
+  //! Pop and apply all due candidates of the policy directories
+  //----------------------------------------------------------------------------
+  void applyPolicies(ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! Drop all state of the incremental engine
+  //----------------------------------------------------------------------------
+  void resetIncremental();
+
+  //! Max number of queued file change events before a full repopulation
+  static constexpr size_t cMaxPendingEvents {1000000};
+
   std::unique_ptr<qclient::QClient> mQcl; ///< Internal QCl object
   AssistedThread mThread; ///< thread id of the LRU thread
   eos::common::VirtualIdentity mRootVid; ///< Uses the root vid
   XrdOucErrInfo mError; ///< XRootD error object
   std::atomic<bool> mRefresh; ///< Flag to mark option refresh
+  //! Incremental engine enabled, file change events are queued
+  std::atomic<bool> mIncremental {false};
+  //! Policy directories by container id, only used by the LRU thread
+  std::map<eos::IContainerMD::id_t, PolicyDir> mPolicyDirs;
+  std::mutex mEventMutex; ///< Protects the tracked dirs and pending events
+  //! Tracked directories by container id
+  std::unordered_map<eos::IContainerMD::id_t, TrackedDir> mTrackedDirs;
+  //! Pending file change events as file id and container id pairs
+  std::set<std::pair<eos::common::FileId::fileid_t, eos::IContainerMD::id_t>>
+      mPendingEvents;
+  bool mEventsOverflow {false}; ///< Events dropped, repopulate all queues
+  eos::common::RequestRateLimit mRateLimit; ///< Limits the policy actions
+  unsigned long long mRate {0}; ///< Policy actions per second, 0 no limit
+  uint64_t mGeneration {0}; ///< Last assigned policy generation
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+//! @file LRUCandidates.cc
+//! @brief Candidate queue of one LRU policy
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/LRUCandidates.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Queue a file or move it to a new position
+//------------------------------------------------------------------------------
+void
+LRUCandidates::Update(uint64_t fid, time_t due, uint64_t size)
+{
+  auto it = mFiles.find(fid);
+
+  if (it != mFiles.end()) {
+    mQueue.erase(std::make_pair(it->second.first, fid));
+    mBytes -= it->second.second;
+    it->second = std::make_pair(due, size);
+  } else {
+    mFiles.emplace(fid, std::make_pair(due, size));
+  }
+
+  mQueue.emplace(due, fid);
+  mBytes += size;
+}
+
+//------------------------------------------------------------------------------
+// Remove a file
+//------------------------------------------------------------------------------
+bool
+LRUCandidates::Remove(uint64_t fid)
+{
+  auto it = mFiles.find(fid);
+
+  if (it == mFiles.end()) {
+    return false;
+  }
+
+  mQueue.erase(std::make_pair(it->second.first, fid));
+  mBytes -= it->second.second;
+  mFiles.erase(it);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Pop the file with the earliest due time
+//------------------------------------------------------------------------------
+bool
+LRUCandidates::Pop(time_t now, Candidate& candidate)
+{
+  if (mQueue.empty()) {
+    return false;
+  }
+
+  auto front = mQueue.begin();
+
+  if (now && (front->first > now)) {
+    return false;
+  }
+
+  auto it = mFiles.find(front->second);
+  candidate.mFid = front->second;
+  candidate.mDue = front->first;
+  candidate.mSize = it->second.second;
+  mBytes -= it->second.second;
+  mFiles.erase(it);
+  mQueue.erase(front);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop all queued files
+//------------------------------------------------------------------------------
+void
+LRUCandidates::Clear()
+{
+  mQueue.clear();
+  mFiles.clear();
+  mBytes = 0;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+//! @file LRUCandidates.hh
+//! @brief Candidate queue of one LRU policy
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <cstdint>
+#include <ctime>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Files a LRU policy has to act on, ordered by the time the policy is due
+//! for them e.g. ctime + age for the expire and conversion policies or the
+//! ctime for the watermark policy. A file is queued at most once, updating
+//! it moves it to its new position. The class is not thread-safe.
+//------------------------------------------------------------------------------
+class LRUCandidates
+{
+public:
+  //! Queued file
+  struct Candidate {
+    uint64_t mFid = 0;
+    time_t mDue = 0;
+    uint64_t mSize = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Queue a file or move it to a new position
+  //!
+  //! @param fid file id
+  //! @param due time when the policy is due for the file
+  //! @param size size of the file
+  //----------------------------------------------------------------------------
+  void Update(uint64_t fid, time_t due, uint64_t size);
+
+  //----------------------------------------------------------------------------
+  //! Remove a file
+  //!
+  //! @return true if the file was queued, otherwise false
+  //----------------------------------------------------------------------------
+  bool Remove(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Check if a file is queued
+  //----------------------------------------------------------------------------
+  bool Contains(uint64_t fid) const
+  {
+    return (mFiles.find(fid) != mFiles.end());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Pop the file with the earliest due time
+  //!
+  //! @param now only pop the file if it is due at or before this time, 0
+  //!        pops it regardless of its due time
+  //! @param candidate popped file
+  //!
+  //! @return true if a file was popped, otherwise false
+  //----------------------------------------------------------------------------
+  bool Pop(time_t now, Candidate& candidate);
+
+  //----------------------------------------------------------------------------
+  //! Get the earliest due time, 0 if the queue is empty
+  //----------------------------------------------------------------------------
+  time_t GetEarliestDue() const
+  {
+    return mQueue.empty() ? 0 : mQueue.begin()->first;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of queued files
+  //----------------------------------------------------------------------------
+  size_t Size() const
+  {
+    return mFiles.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the total size of the queued files
+  //----------------------------------------------------------------------------
+  uint64_t GetBytes() const
+  {
+    return mBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all queued files
+  //----------------------------------------------------------------------------
+  void Clear();
+
+private:
+  //! Due time and file id ordered queue
+  std::set<std::pair<time_t, uint64_t>> mQueue;
+  //! File id to due time and size
+  std::unordered_map<uint64_t, std::pair<time_t, uint64_t>> mFiles;
+  uint64_t mBytes {0}; ///< Total size of the queued files
+};
+
+EOSMGMNAMESPACE_END
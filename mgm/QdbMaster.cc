@@ -28,6 +28,7 @@
 #include "mgm/WFE.hh"
 #include "mgm/fsck/Fsck.hh"
 #include "mgm/LRU.hh"
+#include "mgm/QuotaRecompute.hh"
 #include "mgm/Recycle.hh"
 #include "mgm/convert/ConverterDriver.hh"
 #include "mgm/config/IConfigEngine.hh"
@@ -109,6 +110,11 @@ QdbMaster::BootNamespace()
   namespaceConfig["qdb_password"] = gOFS->mQdbPassword;
   namespaceConfig["qdb_flusher_md"] = SSTR(instance_id << "_md");
   namespaceConfig["qdb_flusher_quota"] = SSTR(instance_id << "_quota");
+
+  if (!gOFS->mNsIndexSpec.empty()) {
+    namespaceConfig[mdindex::sConfigKey] = gOFS->mNsIndexSpec;
+  }
+
   FillNsCacheConfig(gOFS->ConfEngine, namespaceConfig);
 
   if (!gOFS->namespaceGroup->initialize(&gOFS->eosViewRWMutex, namespaceConfig,
@@ -126,6 +132,18 @@ QdbMaster::BootNamespace()
     gOFS->namespaceGroup->getContainerAccountingView();
   gOFS->eosSyncTimeAccounting = gOFS->namespaceGroup->getSyncTimeAccountingView();
 
+  // The LRU engine keeps its candidate queues up to date from the file changes
+  if (gOFS->eosFileService && gOFS->mLRUEngine) {
+    gOFS->eosFileService->addChangeListener(gOFS->mLRUEngine.get());
+  }
+
+  // The quota recomputation marks the changed containers for re-reading
+  if (gOFS->eosFileService && gOFS->eosDirectoryService &&
+      gOFS->mQuotaRecompute) {
+    gOFS->eosFileService->addChangeListener(gOFS->mQuotaRecompute.get());
+    gOFS->eosDirectoryService->addChangeListener(gOFS->mQuotaRecompute.get());
+  }
+
   if (!gOFS->eosDirectoryService || !gOFS->eosFileService || !gOFS->eosView ||
       !gOFS->eosFsView || !gOFS->eosContainerAccounting ||
       !gOFS->eosSyncTimeAccounting) {
@@ -146,6 +164,8 @@ QdbMaster::BootNamespace()
     gOFS->eosFileService->setQuotaStats(gOFS->eosView->getQuotaStats());
     gOFS->eosDirectoryService->setQuotaStats(gOFS->eosView->getQuotaStats());
     gOFS->eosView->getQuotaStats()->registerSizeMapper(Quota::MapSizeCB);
+    gOFS->eosView->getQuotaStats()->registerUsageListener(
+      Quota::GetUsageListener());
     gOFS->eosView->initialize1();
     gOFS->mBootContainerId = gOFS->eosDirectoryService->getFirstFreeId();
     MasterLog(eos_log(LOG_NOTICE, "msg=\"container initialization done\" "
@@ -373,6 +393,7 @@ QdbMaster::SlaveToMaster()
   }
 
   gOFS->mLRUEngine->Start();
+  gOFS->mQuotaRecompute->Start();
   gOFS->Recycler->Start();
   Access::RemoveStallRule("*");
   Access::SetSlaveToMasterRules();
@@ -413,6 +434,7 @@ QdbMaster::MasterToSlave()
   gOFS->mDrainEngine.Stop();
   gOFS->mFsckEngine->Stop();
   gOFS->mLRUEngine->Stop();
+  gOFS->mQuotaRecompute->Stop();
 
   if (gOFS->mConverterDriver) {
     gOFS->mConverterDriver->Stop();
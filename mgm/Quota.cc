@@ -36,6 +36,9 @@ EOSMGMNAMESPACE_BEGIN
 std::map<std::string, SpaceQuota*> Quota::pMapQuota;
 std::map<eos::IContainerMD::id_t, SpaceQuota*> Quota::pMapInodeQuota;
 eos::common::RWMutex Quota::pMapMutex;
+eos::common::atomic_unique_ptr<std::map<eos::IContainerMD::id_t, SpaceQuota*>>
+    Quota::pInodeQuotaView;
+eos::common::VersionedRCUDomain Quota::pInodeQuotaRCU;
 gid_t Quota::gProjectId = 99;
 
 #ifdef __APPLE__
@@ -56,7 +59,8 @@ SpaceQuota::SpaceQuota(const char* path):
   mLastEnableCheck(0),
   mLastRefresh(0),
   mLayoutSizeFactor(1.0),
-  mDirtyTarget(true)
+  mDirtyTarget(true),
+  mLastReconcile(0)
 {
   std::shared_ptr<eos::IContainerMD> quotadir;
 
@@ -214,6 +218,7 @@ SpaceQuota::RmQuota(unsigned long tag, unsigned long id)
 
   if (mMapIdQuota.count(Index(tag, id))) {
     mMapIdQuota.erase(Index(tag, id));
+    MirrorTarget(tag, id, 0);
     mDirtyTarget = true;
     return true;
   }
@@ -247,6 +252,7 @@ SpaceQuota::SetQuota(unsigned long tag, unsigned long id,
   eos_debug("set quota tag=%lu id=%lu value=%llu", tag, id, value);
   XrdSysMutexHelper scope_lock(mMutex);
   mMapIdQuota[Index(tag, id)] = value;
+  MirrorTarget(tag, id, value);
 
   if ((tag == kUserBytesTarget) ||
       (tag == kGroupBytesTarget) ||
@@ -265,6 +271,7 @@ void
 SpaceQuota::ResetQuota(unsigned long tag, unsigned long id)
 {
   mMapIdQuota[Index(tag, id)] = 0;
+  MirrorTarget(tag, id, 0);
 
   if ((tag == kUserBytesTarget) ||
       (tag == kGroupBytesTarget) ||
@@ -293,6 +300,126 @@ SpaceQuota::AddQuota(unsigned long tag, unsigned long id, long long value)
             mMapIdQuota[Index(tag, id)]);
 }
 
+//------------------------------------------------------------------------------
+// Mirror a target value into the counters
+//------------------------------------------------------------------------------
+void
+SpaceQuota::MirrorTarget(unsigned long tag, unsigned long id, long long value)
+{
+  if (!IsCounterTarget(tag)) {
+    return;
+  }
+
+  mCounters.Set(tag, id, value);
+
+  // Defining or dropping a project quota changes how the project usage is
+  // accounted
+  if ((tag == kGroupBytesTarget) && (id == Quota::gProjectId)) {
+    MarkCountersStale();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account a file usage change of the ns quota node in the counters
+//------------------------------------------------------------------------------
+void
+SpaceQuota::AccountUsage(uid_t uid, gid_t gid, long long size,
+                         long long physical_size, long long files)
+{
+  mCounters.Add(kUserBytesIs, uid, physical_size);
+  mCounters.Add(kUserLogicalBytesIs, uid, size);
+  mCounters.Add(kUserFilesIs, uid, files);
+  // With a project quota the project usage is the usage of all the users
+  bool project = (mCounters.Get(kGroupBytesTarget, Quota::gProjectId) > 0);
+
+  if (project) {
+    mCounters.Add(kGroupBytesIs, Quota::gProjectId, physical_size);
+    mCounters.Add(kGroupLogicalBytesIs, Quota::gProjectId, size);
+    mCounters.Add(kGroupFilesIs, Quota::gProjectId, files);
+  }
+
+  if (!project || (gid != Quota::gProjectId)) {
+    mCounters.Add(kGroupBytesIs, gid, physical_size);
+    mCounters.Add(kGroupLogicalBytesIs, gid, size);
+    mCounters.Add(kGroupFilesIs, gid, files);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Reconcile the counters with the ns quota node if they are too old
+//------------------------------------------------------------------------------
+void
+SpaceQuota::ReconcileCountersIfStale()
+{
+  time_t now = time(NULL);
+  time_t last = mLastReconcile.load();
+
+  if ((now - last < sReconcileInterval) ||
+      !mLastReconcile.compare_exchange_strong(last, now)) {
+    return;
+  }
+
+  ReconcileCounters();
+}
+
+//------------------------------------------------------------------------------
+// Replace the usage counters with the values of the ns quota node. Deltas
+// applied while reading the quota node might be lost or counted twice, the
+// next reconciliation fixes them.
+//------------------------------------------------------------------------------
+void
+SpaceQuota::ReconcileCounters()
+{
+  if (!mQuotaNode) {
+    return;
+  }
+
+  bool project = (mCounters.Get(kGroupBytesTarget, Quota::gProjectId) > 0);
+  long long project_bytes = 0;
+  long long project_logical_bytes = 0;
+  long long project_files = 0;
+  std::map<unsigned long long, long long> usage;
+
+  for (const auto uid : mQuotaNode->getUids()) {
+    long long bytes = mQuotaNode->getPhysicalSpaceByUser(uid);
+    long long logical_bytes = mQuotaNode->getUsedSpaceByUser(uid);
+    long long files = mQuotaNode->getNumFilesByUser(uid);
+    usage[Index(kUserBytesIs, uid)] = bytes;
+    usage[Index(kUserLogicalBytesIs, uid)] = logical_bytes;
+    usage[Index(kUserFilesIs, uid)] = files;
+    project_bytes += bytes;
+    project_logical_bytes += logical_bytes;
+    project_files += files;
+  }
+
+  for (const auto gid : mQuotaNode->getGids()) {
+    if (project && (gid == Quota::gProjectId)) {
+      continue;
+    }
+
+    usage[Index(kGroupBytesIs, gid)] = mQuotaNode->getPhysicalSpaceByGroup(gid);
+    usage[Index(kGroupLogicalBytesIs, gid)] = mQuotaNode->getUsedSpaceByGroup(gid);
+    usage[Index(kGroupFilesIs, gid)] = mQuotaNode->getNumFilesByGroup(gid);
+  }
+
+  if (project) {
+    usage[Index(kGroupBytesIs, Quota::gProjectId)] = project_bytes;
+    usage[Index(kGroupLogicalBytesIs, Quota::gProjectId)] = project_logical_bytes;
+    usage[Index(kGroupFilesIs, Quota::gProjectId)] = project_files;
+  }
+
+  // Ids which are gone from the quota node have no usage left
+  mCounters.ForEach([&](unsigned long tag, unsigned long id, long long value) {
+    if (!IsCounterTarget(tag) && value && !usage.count(Index(tag, id))) {
+      mCounters.Set(tag, id, 0);
+    }
+  });
+
+  for (const auto& elem : usage) {
+    mCounters.Set(UnIndex(elem.first), elem.first & 0xffffffff, elem.second);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Update
 //------------------------------------------------------------------------------
@@ -482,6 +609,8 @@ SpaceQuota::Refresh(time_t age)
   UpdateLogicalSizeFactor();
   UpdateIsSums();
   UpdateTargetSums();
+  mLastReconcile = now;
+  ReconcileCounters();
 }
 
 
@@ -544,31 +673,36 @@ SpaceQuota::PrintOut(XrdOucString& output, long long int uid_sel,
     }
   }
 
-  // translate ids without mutex held
+  // translate ids without mutex held, all the ids are resolved in one batch
   if (translate_ids) {
-    std::string name;
     std::vector<std::pair<std::string, unsigned>> tuids, tgids;
+    std::map<uid_t, std::string> uid_names;
+    std::map<gid_t, std::string> gid_names;
 
-    for (auto u : uids) {
-      if (gid_sel == Quota::gProjectId) {
-        name = "project";
-      } else {
-        int errc = 0;
-        name = eos::common::Mapping::UidToUserName(u.second, errc);
+    if (gid_sel != Quota::gProjectId) {
+      std::vector<uid_t> lst_uids;
+      std::vector<gid_t> lst_gids;
+
+      for (const auto& u : uids) {
+        lst_uids.push_back(u.second);
+      }
+
+      for (const auto& g : gids) {
+        lst_gids.push_back(g.second);
       }
 
-      tuids.push_back(std::make_pair(name, u.second));
+      uid_names = eos::common::Mapping::UidsToUserNames(lst_uids);
+      gid_names = eos::common::Mapping::GidsToGroupNames(lst_gids);
     }
 
-    for (auto g : gids) {
-      if (gid_sel == Quota::gProjectId) {
-        name = "project";
-      } else {
-        int errc = 0;
-        name = eos::common::Mapping::GidToGroupName(g.second, errc);
-      }
+    for (auto u : uids) {
+      tuids.push_back(std::make_pair(gid_sel == Quota::gProjectId ? "project" :
+                                     uid_names[u.second], u.second));
+    }
 
-      tgids.push_back(std::make_pair(name, g.second));
+    for (auto g : gids) {
+      tgids.push_back(std::make_pair(gid_sel == Quota::gProjectId ? "project" :
+                                     gid_names[g.second], g.second));
     }
 
     uids = tuids;
@@ -946,11 +1080,11 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
                             unsigned int inodes)
 {
   bool hasquota = false;
-  // Update info from the ns quota node - user, group and project quotas
-  UpdateFromQuotaNode(uid, gid, GetQuota(kGroupBytesTarget, Quota::gProjectId)
-                      ? true : false);
+  // The usage counters follow the ns quota node, catch up with changes which
+  // bypassed the ns quota node accounting from time to time
+  ReconcileCountersIfStale();
   eos_info("uid=%d gid=%d size=%llu quota=%llu", uid, gid, desired_vol,
-           GetQuota(kUserBytesTarget, uid));
+           mCounters.Get(kUserBytesTarget, uid));
   bool userquota = false;
   bool groupquota = false;
   bool projectquota = false;
@@ -962,28 +1096,28 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
   bool groupvolumequota = false;
   bool groupinodequota = false;
 
-  if (GetQuota(kUserBytesTarget, uid) > 0) {
+  if (mCounters.Get(kUserBytesTarget, uid) > 0) {
     userquota = true;
     uservolumequota = true;
   }
 
-  if (GetQuota(kGroupBytesTarget, gid) > 0) {
+  if (mCounters.Get(kGroupBytesTarget, gid) > 0) {
     groupquota = true;
     groupvolumequota = true;
   }
 
-  if (GetQuota(kUserFilesTarget, uid) > 0) {
+  if (mCounters.Get(kUserFilesTarget, uid) > 0) {
     userquota = true;
     userinodequota = true;
   }
 
-  if (GetQuota(kGroupFilesTarget, gid) > 0) {
+  if (mCounters.Get(kGroupFilesTarget, gid) > 0) {
     groupquota = true;
     groupinodequota = true;
   }
 
   if (uservolumequota) {
-    if ((GetQuota(kUserBytesTarget, uid) - GetQuota(kUserBytesIs,
+    if ((mCounters.Get(kUserBytesTarget, uid) - mCounters.Get(kUserBytesIs,
          uid)) > (long long)desired_vol) {
       hasuserquota = true;
     } else {
@@ -994,7 +1128,7 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
   if (userinodequota) {
     // The +1 comes from the fact the the current file is already accounted to
     // the ns quota by doing ns_quota->addFile previously in the open function.
-    if ((GetQuota(kUserFilesTarget, uid) - GetQuota(kUserFilesIs,
+    if ((mCounters.Get(kUserFilesTarget, uid) - mCounters.Get(kUserFilesIs,
          uid) + 1) >= inodes) {
       if (!uservolumequota) {
         hasuserquota = true;
@@ -1005,7 +1139,7 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
   }
 
   if (groupvolumequota) {
-    if ((GetQuota(kGroupBytesTarget, gid) - GetQuota(kGroupBytesIs,
+    if ((mCounters.Get(kGroupBytesTarget, gid) - mCounters.Get(kGroupBytesIs,
          gid)) > desired_vol) {
       hasgroupquota = true;
     } else {
@@ -1014,7 +1148,7 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
   }
 
   if (groupinodequota) {
-    if ((GetQuota(kGroupFilesTarget, gid) - GetQuota(kGroupFilesIs,
+    if ((mCounters.Get(kGroupFilesTarget, gid) - mCounters.Get(kGroupFilesIs,
          gid)) > inodes) {
       if (!groupvolumequota) {
         hasgroupquota = true;
@@ -1024,13 +1158,13 @@ SpaceQuota::CheckWriteQuota(uid_t uid, gid_t gid, long long desired_vol,
     }
   }
 
-  if (((GetQuota(kGroupBytesTarget, Quota::gProjectId) -
-        GetQuota(kGroupBytesIs, Quota::gProjectId)) > desired_vol)) {
+  if (((mCounters.Get(kGroupBytesTarget, Quota::gProjectId) -
+        mCounters.Get(kGroupBytesIs, Quota::gProjectId)) > desired_vol)) {
     hasprojectquota = true;
 
-    if ((GetQuota(kGroupFilesTarget, Quota::gProjectId)) &&
-        ((GetQuota(kGroupFilesTarget, Quota::gProjectId) <
-          (GetQuota(kGroupFilesIs, Quota::gProjectId) + inodes)))) {
+    if ((mCounters.Get(kGroupFilesTarget, Quota::gProjectId)) &&
+        ((mCounters.Get(kGroupFilesTarget, Quota::gProjectId) <
+          (mCounters.Get(kGroupFilesIs, Quota::gProjectId) + inodes)))) {
       hasprojectquota = false;
     }
   }
@@ -1731,6 +1865,7 @@ Quota::RmSpaceQuota(const std::string& qpath, std::string& msg, int& retc)
     pMapQuota.erase(path);
     // Delete also from the pMapInodeQuota
     (void) pMapInodeQuota.erase(squota->GetQuotaNode()->getId());
+    PublishInodeQuota();
 
     // Remove ns quota node
     try {
@@ -1791,6 +1926,65 @@ Quota::MapSizeCB(const eos::IFileMD* file)
   return (uint64_t) file->getSize() * eos::common::LayoutId::GetSizeFactor(lid);
 }
 
+//------------------------------------------------------------------------------
+//! Listener keeping the quota counters up to date with the ns quota nodes
+//------------------------------------------------------------------------------
+class QuotaUsageListener : public eos::IQuotaUsageListener
+{
+public:
+  void usageChanged(eos::IContainerMD::id_t node_id, uid_t uid, gid_t gid,
+                    int64_t size, int64_t physical_size,
+                    int64_t files) override
+  {
+    eos::common::RCUReadLock rlock(Quota::pInodeQuotaRCU);
+    auto* view = Quota::pInodeQuotaView.get();
+
+    if (view) {
+      auto it = view->find(node_id);
+
+      if (it != view->end()) {
+        it->second->AccountUsage(uid, gid, size, physical_size, files);
+      }
+    }
+  }
+
+  void usageReset(eos::IContainerMD::id_t node_id) override
+  {
+    eos::common::RCUReadLock rlock(Quota::pInodeQuotaRCU);
+    auto* view = Quota::pInodeQuotaView.get();
+
+    if (view) {
+      auto it = view->find(node_id);
+
+      if (it != view->end()) {
+        it->second->MarkCountersStale();
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Get the listener of the usage changes of the ns quota nodes
+//------------------------------------------------------------------------------
+eos::IQuotaUsageListener*
+Quota::GetUsageListener()
+{
+  static QuotaUsageListener listener;
+  return &listener;
+}
+
+//------------------------------------------------------------------------------
+// Publish the current pMapInodeQuota for the usage listener
+//------------------------------------------------------------------------------
+void
+Quota::PublishInodeQuota()
+{
+  // Wait for the listeners still reading the old copy before deleting it
+  eos::common::ScopedRCUWrite rcu_write(pInodeQuotaRCU, pInodeQuotaView,
+                                        new std::map<eos::IContainerMD::id_t,
+                                        SpaceQuota*>(pMapInodeQuota));
+}
+
 //------------------------------------------------------------------------------
 // Load nodes
 //------------------------------------------------------------------------------
@@ -1972,13 +2166,14 @@ void
 Quota::CleanUp()
 {
   eos::common::RWMutexWriteLock wr_lock(pMapMutex);
+  std::map<std::string, SpaceQuota*> old_quota;
+  old_quota.swap(pMapQuota);
+  pMapInodeQuota.clear();
+  PublishInodeQuota();
 
-  for (auto it = pMapQuota.begin(); it != pMapQuota.end(); ++it) {
+  for (auto it = old_quota.begin(); it != old_quota.end(); ++it) {
     delete it->second;
   }
-
-  pMapQuota.clear();
-  pMapInodeQuota.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2060,6 +2255,7 @@ Quota::Create(const std::string& path)
       SpaceQuota* squota = new SpaceQuota(path.c_str());
       pMapQuota[path] = squota;
       pMapInodeQuota[squota->GetQuotaNode()->getId()] = squota;
+      PublishInodeQuota();
     } catch (const eos::MDException& e) {
       eos_static_crit("Failed to create quota node %s", path.c_str());
       return false;
@@ -2159,18 +2355,16 @@ Quota::GetQuotaInfo(SpaceQuota* squota, uid_t uid, gid_t gid,
   long long maxbytes = 0;
   freebytes_user = freebytes_group = freebytes_project = 0;
   maxbytes_user = maxbytes_group = maxbytes_project = 0;
-  squota->UpdateFromQuotaNode(uid, gid,
-                              squota->GetQuota(SpaceQuota::kGroupBytesTarget, Quota::gProjectId)
-                              ? true : false);
-  maxbytes_user  = squota->GetQuota(SpaceQuota::kUserBytesTarget, uid);
-  maxbytes_group = squota->GetQuota(SpaceQuota::kGroupBytesTarget, gid);
-  maxbytes_project = squota->GetQuota(SpaceQuota::kGroupBytesTarget,
+  squota->ReconcileCountersIfStale();
+  maxbytes_user  = squota->mCounters.Get(SpaceQuota::kUserBytesTarget, uid);
+  maxbytes_group = squota->mCounters.Get(SpaceQuota::kGroupBytesTarget, gid);
+  maxbytes_project = squota->mCounters.Get(SpaceQuota::kGroupBytesTarget,
                                       Quota::gProjectId);
-  freebytes_user = maxbytes_user - squota->GetQuota(
+  freebytes_user = maxbytes_user - squota->mCounters.Get(
                      SpaceQuota::kUserBytesIs, uid);
-  freebytes_group = maxbytes_group - squota->GetQuota(
+  freebytes_group = maxbytes_group - squota->mCounters.Get(
                       SpaceQuota::kGroupBytesIs, gid);
-  freebytes_project = maxbytes_project - squota->GetQuota(
+  freebytes_project = maxbytes_project - squota->mCounters.Get(
                         SpaceQuota::kGroupBytesIs, Quota::gProjectId);
   // rescale the leftover physical space to the default layout and report the recomputed logical quota
   maxbytes_user /= squota->GetLayoutSizeFactor();
@@ -2215,15 +2409,15 @@ Quota::GetQuotaInfo(SpaceQuota* squota, uid_t uid, gid_t gid,
   long long maxfiles = 0;
   freefiles_user = freefiles_group = freefiles_project = 0;
   maxfiles_user = maxfiles_group = maxfiles_project = 0;
-  maxfiles_user  = squota->GetQuota(SpaceQuota::kUserFilesTarget, uid);
-  maxfiles_group = squota->GetQuota(SpaceQuota::kGroupFilesTarget, gid);
-  maxfiles_project = squota->GetQuota(SpaceQuota::kGroupFilesTarget,
+  maxfiles_user  = squota->mCounters.Get(SpaceQuota::kUserFilesTarget, uid);
+  maxfiles_group = squota->mCounters.Get(SpaceQuota::kGroupFilesTarget, gid);
+  maxfiles_project = squota->mCounters.Get(SpaceQuota::kGroupFilesTarget,
                                       Quota::gProjectId);
-  freefiles_user = maxfiles_user - squota->GetQuota(SpaceQuota::kUserFilesIs,
+  freefiles_user = maxfiles_user - squota->mCounters.Get(SpaceQuota::kUserFilesIs,
                    uid);
-  freefiles_group = maxfiles_group - squota->GetQuota(SpaceQuota::kGroupFilesIs,
+  freefiles_group = maxfiles_group - squota->mCounters.Get(SpaceQuota::kGroupFilesIs,
                     gid);
-  freefiles_project = maxfiles_project - squota->GetQuota(
+  freefiles_project = maxfiles_project - squota->mCounters.Get(
                         SpaceQuota::kGroupFilesIs, Quota::gProjectId);
 
   if (freefiles_user > freefiles) {
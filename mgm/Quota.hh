@@ -29,16 +29,21 @@
 #include <google/dense_hash_map>
 #include <google/sparsehash/densehashtable.h>
 #include "mgm/Scheduler.hh"
+#include "mgm/QuotaCounters.hh"
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
 #include "common/Mapping.hh"
 #include "common/RWMutex.hh"
+#include "common/concurrency/AtomicUniquePtr.h"
+#include "common/concurrency/RCULite.hh"
 #include "namespace/interface/IQuota.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <atomic>
 
 EOSMGMNAMESPACE_BEGIN
 
 class Quota;
+class QuotaUsageListener;
 
 //------------------------------------------------------------------------------
 //! Class SpaceQuota
@@ -46,6 +51,7 @@ class Quota;
 class SpaceQuota : public eos::common::LogId
 {
   friend class Quota;
+  friend class QuotaUsageListener;
 
 public:
 
@@ -85,7 +91,8 @@ public:
 
   //----------------------------------------------------------------------------
   //! Check user and/or group quota. If both are present, they both have to be
-  //! fullfilled.
+  //! fullfilled. Only reads the lock-free counters, which are reconciled with
+  //! the ns quota node at most every sReconcileInterval seconds.
   //!
   //! @param uid user id
   //! @param gid group id
@@ -169,6 +176,53 @@ private:
   //----------------------------------------------------------------------------
   void AccountNsToSpace();
 
+  //----------------------------------------------------------------------------
+  //! Account a file added to or removed from the ns quota node in the
+  //! counters, lock-free
+  //!
+  //! @param uid user id
+  //! @param gid group id
+  //! @param size logical size change
+  //! @param physical_size physical size change
+  //! @param files number of files change
+  //----------------------------------------------------------------------------
+  void AccountUsage(uid_t uid, gid_t gid, long long size,
+                    long long physical_size, long long files);
+
+  //----------------------------------------------------------------------------
+  //! Reconcile the counters with the ns quota node at the next quota check
+  //----------------------------------------------------------------------------
+  inline void MarkCountersStale()
+  {
+    mLastReconcile = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reconcile the counters with the ns quota node if the last reconciliation
+  //! is older than sReconcileInterval. Only one caller does it, the others
+  //! go on with the current counters.
+  //----------------------------------------------------------------------------
+  void ReconcileCountersIfStale();
+
+  //----------------------------------------------------------------------------
+  //! Replace the usage counters with the values of the ns quota node
+  //----------------------------------------------------------------------------
+  void ReconcileCounters();
+
+  //----------------------------------------------------------------------------
+  //! Mirror a target value into the counters, if used by the quota checks
+  //----------------------------------------------------------------------------
+  void MirrorTarget(unsigned long tag, unsigned long id, long long value);
+
+  //----------------------------------------------------------------------------
+  //! Check if the tag is a target value mirrored in the counters
+  //----------------------------------------------------------------------------
+  static inline bool IsCounterTarget(unsigned long tag)
+  {
+    return ((tag == kUserBytesTarget) || (tag == kUserFilesTarget) ||
+            (tag == kGroupBytesTarget) || (tag == kGroupFilesTarget));
+  }
+
   //----------------------------------------------------------------------------
   //! Update quota from the ns quota node for the given identity only if the
   //! requested path is actually a ns quota node.
@@ -311,6 +365,12 @@ private:
 
   //! Map for user view, depending on eQuota and uid/gid
   std::map<long long, unsigned long long> mMapIdQuota;
+  //! Values used by the quota checks: the per uid/gid targets mirrored from
+  //! mMapIdQuota and the per uid/gid usage kept up to date from the ns deltas
+  QuotaCounters mCounters;
+  std::atomic<time_t> mLastReconcile; ///< Time of the last reconciliation
+  //! Seconds after which the counters are reconciled with the ns quota node
+  static constexpr time_t sReconcileInterval = 5;
 };
 
 
@@ -515,6 +575,12 @@ public:
   //----------------------------------------------------------------------------
   static void LoadNodes();
 
+  //----------------------------------------------------------------------------
+  //! Get the listener to register with the ns quota stats, which keeps the
+  //! quota counters up to date with the usage changes of the ns quota nodes
+  //----------------------------------------------------------------------------
+  static eos::IQuotaUsageListener* GetUsageListener();
+
   //----------------------------------------------------------------------------
   //! Clean-up all space quotas by deleting them and clearing the map
   //----------------------------------------------------------------------------
@@ -677,6 +743,15 @@ private:
   //----------------------------------------------------------------------------
   static SpaceQuota* GetResponsibleSpaceQuota(const std::string& path);
 
+  //----------------------------------------------------------------------------
+  //! Publish the current pMapInodeQuota for the usage listener
+  //!
+  //! @warning Caller needs to hold a write-lock on pMapMutex and delete the
+  //!          removed SpaceQuota objects only after this call
+  //----------------------------------------------------------------------------
+  static void PublishInodeQuota();
+
+  friend class QuotaUsageListener;
 
   //----------------------------------------------------------------------------
   //! Make sure the path ends with a /
@@ -700,6 +775,10 @@ private:
   static std::map<std::string, SpaceQuota*> pMapQuota;
   //! Map from container id to SpaceQuota object
   static std::map<eos::IContainerMD::id_t, SpaceQuota*> pMapInodeQuota;
+  //! Copy of pMapInodeQuota read by the usage listener under RCU
+  static eos::common::atomic_unique_ptr
+  <std::map<eos::IContainerMD::id_t, SpaceQuota*>> pInodeQuotaView;
+  static eos::common::VersionedRCUDomain pInodeQuotaRCU; ///< RCU of the copy
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,188 @@
+//------------------------------------------------------------------------------
+//! @file QuotaCounters.cc
+//! @brief Lock-free quota counters indexed by quota tag and uid/gid
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/QuotaCounters.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QuotaCounters::QuotaCounters(size_t capacity):
+  mCapacity(16)
+{
+  while (mCapacity < capacity) {
+    mCapacity <<= 1;
+  }
+
+  mTable.reset_from_null(new Table(mCapacity));
+}
+
+//------------------------------------------------------------------------------
+// Get counter value
+//------------------------------------------------------------------------------
+long long
+QuotaCounters::Get(unsigned long tag, unsigned long id) const
+{
+  std::atomic<long long>* value = Find(mTable.get(), Key(tag, id));
+  return (value ? value->load(std::memory_order_relaxed) : 0);
+}
+
+//------------------------------------------------------------------------------
+// Set counter value
+//------------------------------------------------------------------------------
+void
+QuotaCounters::Set(unsigned long tag, unsigned long id, long long value)
+{
+  GetOrAdd(Key(tag, id))->store(value, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Add to counter value
+//------------------------------------------------------------------------------
+void
+QuotaCounters::Add(unsigned long tag, unsigned long id, long long delta)
+{
+  std::atomic<long long>* value = GetOrAdd(Key(tag, id));
+  long long current = value->load(std::memory_order_relaxed);
+  long long updated;
+
+  do {
+    updated = current + delta;
+
+    if (updated < 0) {
+      updated = 0;
+    }
+  } while (!value->compare_exchange_weak(current, updated,
+                                         std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+// Call a function for every counter
+//------------------------------------------------------------------------------
+void
+QuotaCounters::ForEach(const std::function<void(unsigned long, unsigned long,
+                       long long)>& func) const
+{
+  const Table* table = mTable.get();
+
+  for (size_t i = 0; i <= table->mMask; ++i) {
+    unsigned long long key = table->mSlots[i].mKey.load(
+                               std::memory_order_acquire);
+
+    if (key) {
+      func(key >> 32, key & 0xffffffff,
+           table->mSlots[i].mValue.load(std::memory_order_relaxed)->load(
+             std::memory_order_relaxed));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Find counter of key in table
+//------------------------------------------------------------------------------
+std::atomic<long long>*
+QuotaCounters::Find(const Table* table, unsigned long long key)
+{
+  // The table is never more than half full, probing ends at an empty slot
+  for (size_t pos = Hash(key, table->mMask); ;
+       pos = (pos + 1) & table->mMask) {
+    unsigned long long slot_key = table->mSlots[pos].mKey.load(
+                                    std::memory_order_acquire);
+
+    if (slot_key == key) {
+      return table->mSlots[pos].mValue.load(std::memory_order_relaxed);
+    }
+
+    if (slot_key == 0) {
+      return nullptr;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get counter of key, add it if needed
+//------------------------------------------------------------------------------
+std::atomic<long long>*
+QuotaCounters::GetOrAdd(unsigned long long key)
+{
+  std::atomic<long long>* value = Find(mTable.get(), key);
+
+  if (value) {
+    return value;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  // Another thread might have added it meanwhile
+  value = Find(mTable.get(), key);
+
+  if (value) {
+    return value;
+  }
+
+  if (2 * (mSize + 1) > mCapacity) {
+    // Copy the slots into a table twice the size and publish it, readers
+    // still using the old table find the same counters
+    std::unique_ptr<Table> table(new Table(2 * mCapacity));
+    const Table* old_table = mTable.get();
+
+    for (size_t i = 0; i < mCapacity; ++i) {
+      unsigned long long old_key = old_table->mSlots[i].mKey.load(
+                                     std::memory_order_relaxed);
+
+      if (old_key) {
+        Insert(table.get(), old_key,
+               old_table->mSlots[i].mValue.load(std::memory_order_relaxed));
+      }
+    }
+
+    mCapacity *= 2;
+    mRetired.emplace_back(mTable.reset(table.release()));
+  }
+
+  mValues.emplace_back(0);
+  value = &mValues.back();
+  Insert(mTable.get(), key, value);
+  mSize.fetch_add(1, std::memory_order_relaxed);
+  return value;
+}
+
+//------------------------------------------------------------------------------
+// Store key and counter in a free slot of table
+//------------------------------------------------------------------------------
+void
+QuotaCounters::Insert(Table* table, unsigned long long key,
+                      std::atomic<long long>* value)
+{
+  size_t pos = Hash(key, table->mMask);
+
+  while (table->mSlots[pos].mKey.load(std::memory_order_relaxed)) {
+    pos = (pos + 1) & table->mMask;
+  }
+
+  // Readers which see the key also see the counter
+  table->mSlots[pos].mValue.store(value, std::memory_order_relaxed);
+  table->mSlots[pos].mKey.store(key, std::memory_order_release);
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+//! @file QuotaCounters.hh
+//! @brief Lock-free quota counters indexed by quota tag and uid/gid
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/concurrency/AtomicUniquePtr.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Counters of a space quota which are read and updated without locks
+//!
+//! Open addressing hash table from (tag, id) to an atomic counter. Entries are
+//! never removed, so lookups just probe the current table until they find the
+//! key or an empty slot. Only adding a new key takes a mutex, when the table
+//! gets half full a table twice the size is published. The counters live
+//! outside of the tables, hence an update going through a table which was
+//! just replaced is not lost. Replaced tables are kept until destruction,
+//! they add up to less than the current one.
+//------------------------------------------------------------------------------
+class QuotaCounters
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity initial number of slots, rounded up to a power of two
+  //----------------------------------------------------------------------------
+  QuotaCounters(size_t capacity = 256);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~QuotaCounters() = default;
+
+  //----------------------------------------------------------------------------
+  //! Get counter value, lock-free
+  //!
+  //! @param tag quota type tag (SpaceQuota::eQuotaTag)
+  //! @param id uid/gid/project id
+  //!
+  //! @return counter value, 0 if the counter does not exist
+  //----------------------------------------------------------------------------
+  long long Get(unsigned long tag, unsigned long id) const;
+
+  //----------------------------------------------------------------------------
+  //! Set counter value, lock-free unless the counter is new
+  //----------------------------------------------------------------------------
+  void Set(unsigned long tag, unsigned long id, long long value);
+
+  //----------------------------------------------------------------------------
+  //! Add to counter value, lock-free unless the counter is new. The value
+  //! does not go below 0, like SpaceQuota::AddQuota.
+  //----------------------------------------------------------------------------
+  void Add(unsigned long tag, unsigned long id, long long delta);
+
+  //----------------------------------------------------------------------------
+  //! Call a function for every counter, lock-free. Counters added in the
+  //! meantime may or may not be visited.
+  //----------------------------------------------------------------------------
+  void ForEach(const std::function<void(unsigned long tag, unsigned long id,
+               long long value)>& func) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of counters
+  //----------------------------------------------------------------------------
+  size_t Size() const
+  {
+    return mSize.load(std::memory_order_relaxed);
+  }
+
+private:
+  //! Table slot, the key is written last and 0 marks an empty slot
+  struct Slot {
+    std::atomic<unsigned long long> mKey {0};
+    std::atomic<std::atomic<long long>*> mValue {nullptr};
+  };
+
+  //! Table of slots
+  struct Table {
+    explicit Table(size_t capacity):
+      mMask(capacity - 1), mSlots(new Slot[capacity])
+    {}
+
+    const size_t mMask;
+    std::unique_ptr<Slot[]> mSlots;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Build key, tags start at 1 so a key is never 0
+  //----------------------------------------------------------------------------
+  static inline unsigned long long Key(unsigned long tag, unsigned long id)
+  {
+    return (((unsigned long long) tag << 32) | (id & 0xffffffff));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Slot where probing for a key starts
+  //----------------------------------------------------------------------------
+  static inline size_t Hash(unsigned long long key, size_t mask)
+  {
+    key *= 0x9e3779b97f4a7c15ull;
+    return (key ^ (key >> 32)) & mask;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find counter of key in table
+  //!
+  //! @return counter or nullptr if key not found
+  //----------------------------------------------------------------------------
+  static std::atomic<long long>* Find(const Table* table,
+                                      unsigned long long key);
+
+  //----------------------------------------------------------------------------
+  //! Get counter of key, add it if needed
+  //----------------------------------------------------------------------------
+  std::atomic<long long>* GetOrAdd(unsigned long long key);
+
+  //----------------------------------------------------------------------------
+  //! Store key and counter in a free slot of table, needs mMutex
+  //----------------------------------------------------------------------------
+  static void Insert(Table* table, unsigned long long key,
+                     std::atomic<long long>* value);
+
+  eos::common::atomic_unique_ptr<Table> mTable; ///< Current table
+  std::atomic<size_t> mSize {0}; ///< Number of counters
+  size_t mCapacity; ///< Capacity of the current table
+  std::mutex mMutex; ///< Serializes adding counters
+  std::deque<std::atomic<long long>> mValues; ///< Counters, stable addresses
+  std::vector<std::unique_ptr<Table>> mRetired; ///< Replaced tables
+};
+
+EOSMGMNAMESPACE_END
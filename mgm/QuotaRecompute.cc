@@ -0,0 +1,593 @@
+//------------------------------------------------------------------------------
+//! @file QuotaRecompute.cc
+//! @brief Online, resumable recomputation of quota nodes
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/QuotaRecompute.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "common/RWMutex.hh"
+#include "common/StringConversion.hh"
+#include "namespace/Constants.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/utils/QuotaRecomputeJob.hh"
+#include <qclient/QClient.hh>
+#include <qclient/structures/QHash.hh>
+#include <list>
+#include <sstream>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//! Queued jobs, quota node container id to "<uid>:<gid>" filter
+const std::string sKeyJobs = "quota-recompute:jobs";
+//! Dirty containers left for the final reconcile with the namespace locked
+constexpr size_t cMaxFinalDirty = 10000;
+//! Containers walked with the namespace locked, beyond this limit the lock is
+//! released and the walk continues online
+constexpr uint64_t cMaxFinalWalk = 10000;
+//! Online reconcile passes before reconciling with the namespace locked
+constexpr int cMaxOnlinePasses = 10;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QuotaRecompute::QuotaRecompute()
+{
+  const char* ptr = getenv("EOS_MGM_QUOTA_RECOMPUTE_THREADS");
+
+  if (ptr && strtoul(ptr, nullptr, 10)) {
+    mThreads = strtoul(ptr, nullptr, 10);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+QuotaRecompute::~QuotaRecompute()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Resume the interrupted jobs and start the job thread
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::Start()
+{
+  auto* group = dynamic_cast<eos::QuarkNamespaceGroup*>
+                (gOFS->namespaceGroup.get());
+
+  if (!group) {
+    return;
+  }
+
+  Stop();
+  mFlusher = group->getMetadataFlusher();
+
+  if (!mQcl) {
+    mQcl = std::make_unique<qclient::QClient>
+           (gOFS->mQdbContactDetails.members,
+            gOFS->mQdbContactDetails.constructOptions());
+  }
+
+  try {
+    qclient::QHash jobs(*mQcl, sKeyJobs);
+    std::string cursor = "0";
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    do {
+      auto reply = jobs.hscan(cursor, 1000);
+      cursor = reply.first;
+
+      for (const auto& elem : reply.second) {
+        size_t pos = elem.second.find(':');
+        eos_static_info("msg=\"resume quota recomputation\" cxid=%08llx",
+                        std::stoull(elem.first));
+        AddJob(std::stoull(elem.first), elem.second.substr(0, pos),
+               (pos == std::string::npos) ? "" : elem.second.substr(pos + 1));
+      }
+    } while (cursor != "0");
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to list interrupted quota recomputations\" "
+                   "emsg=\"%s\"", e.what());
+  }
+
+  mThread.reset(&QuotaRecompute::backgroundThread, this);
+  mRunning = true;
+}
+
+//------------------------------------------------------------------------------
+// Stop the job thread
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::Stop()
+{
+  mRunning = false;
+  mThread.join();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mActive = false;
+  mJobs.clear();
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Create a job
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::AddJob(eos::IContainerMD::id_t cont_id, const std::string& uid,
+                       const std::string& gid)
+{
+  auto job = std::make_shared<Job>();
+  job->mContId = cont_id;
+  job->mUid = uid;
+  job->mGid = gid;
+  job->mWork.reset(new eos::QuotaRecomputeJob(mQcl.get(), cont_id));
+  mJobs[cont_id] = job;
+  mResults.erase(cont_id);
+  mActive = true;
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Queue the recomputation of a quota node
+//------------------------------------------------------------------------------
+int
+QuotaRecompute::Submit(eos::IContainerMD::id_t cont_id, const std::string& uid,
+                       const std::string& gid, std::string& msg)
+{
+  if (!mRunning) {
+    msg = "error: quota recomputation is only available on the master with a "
+          "QDB namespace";
+    return EINVAL;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mJobs.count(cont_id)) {
+      msg = "info: quota recomputation already queued";
+      return 0;
+    }
+  }
+
+  // Not under mMutex, the namespace listeners take it with the namespace
+  // write lock held
+  try {
+    mQcl->exec("HSET", sKeyJobs, std::to_string(cont_id),
+               uid + ":" + gid).get();
+  } catch (const std::exception& e) {
+    msg = SSTR("error: failed to queue quota recomputation: " << e.what());
+    return EIO;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mJobs.count(cont_id)) {
+    msg = "info: quota recomputation already queued";
+    return 0;
+  }
+
+  AddJob(cont_id, uid, gid);
+  msg = "info: quota recomputation queued";
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Wait for the job of a quota node to finish
+//------------------------------------------------------------------------------
+int
+QuotaRecompute::Wait(eos::IContainerMD::id_t cont_id, std::string& msg)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (mJobs.count(cont_id)) {
+    mCond.wait_for(lock, std::chrono::seconds(1));
+  }
+
+  auto it = mResults.find(cont_id);
+
+  if (it == mResults.end()) {
+    msg = "error: quota recomputation interrupted, it resumes on the next "
+          "master";
+    return EINTR;
+  }
+
+  msg = it->second.second;
+  return it->second.first;
+}
+
+//------------------------------------------------------------------------------
+// Set the state of a job
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::SetState(Job& job, const std::string& state)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  job.mState = state;
+}
+
+//------------------------------------------------------------------------------
+// Get the progress of the jobs
+//------------------------------------------------------------------------------
+std::string
+QuotaRecompute::GetStatus()
+{
+  std::ostringstream oss;
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (const auto& elem : mJobs) {
+    const Job& job = *elem.second;
+    const auto progress = job.mWork->getProgress();
+    oss << "cxid=" << eos::common::StringConversion::FastUnsignedToAsciiHex
+        (job.mContId) << " path=" << (job.mPath.empty() ? "-" : job.mPath)
+        << " state=" << job.mState
+        << " containers=" << progress.mContainers
+        << " pending=" << progress.mPending
+        << " files=" << progress.mFiles
+        << " expected_files=" << job.mExpectedFiles
+        << " dirty=" << progress.mDirty
+        << " reconciled=" << progress.mReconciled
+        << " elapsed=" << progress.mElapsed << "s"
+        << " rate=" << (uint64_t) progress.mFileRate << "files/s";
+
+    // The quota node still holds the old, possibly drifted, usage: good
+    // enough to estimate what is left
+    if (job.mState == "walking") {
+      oss << " eta=";
+
+      if (progress.mFileRate > 0) {
+        uint64_t left = (job.mExpectedFiles > progress.mFiles) ?
+                        job.mExpectedFiles - progress.mFiles : 0;
+        oss << (uint64_t)(left / progress.mFileRate) << "s";
+      } else {
+        oss << "-";
+      }
+    }
+
+    oss << std::endl;
+  }
+
+  for (const auto& elem : mResults) {
+    oss << "cxid=" << eos::common::StringConversion::FastUnsignedToAsciiHex
+        (elem.first) << " state=" << (elem.second.first ? "failed" : "done")
+        << " retc=" << elem.second.first << " msg=\""
+        << elem.second.second << "\"" << std::endl;
+  }
+
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Mark a container dirty for all jobs
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::MarkDirty(eos::IContainerMD::id_t id)
+{
+  if (id == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto& elem : mJobs) {
+    // Persist the mark with the change itself, a resumed job re-reads it
+    if (elem.second->mWork->markDirty(id) && mFlusher) {
+      mFlusher->sadd(eos::QuotaRecomputeJob::KeyDirty(elem.first),
+                     std::to_string(id));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop the persisted marks of reconciled containers
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::PruneDirty(Job& job,
+                           const std::unordered_set<eos::IContainerMD::id_t>& ids)
+{
+  const std::string key = eos::QuotaRecomputeJob::KeyDirty(job.mContId);
+  std::list<std::string> items;
+  // MarkDirty persists new marks under mMutex and through the same flusher,
+  // containers marked again meanwhile keep their mark
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto id : ids) {
+    if (!job.mWork->isDirty(id)) {
+      items.push_back(std::to_string(id));
+    }
+  }
+
+  if (!items.empty()) {
+    mFlusher->srem(key, items);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Mark the container of a changed file dirty
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::fileMDChanged(IFileMDChangeListener::Event* event)
+{
+  if (!mActive) {
+    return;
+  }
+
+  switch (event->action) {
+  case IFileMDChangeListener::Updated:
+  case IFileMDChangeListener::Deleted:
+    MarkDirty(event->file->getContainerId());
+    break;
+
+  case IFileMDChangeListener::SizeChange:
+    // A file removed from a container passes the container as location
+    MarkDirty(event->file->getContainerId() ? event->file->getContainerId() :
+              event->location);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Mark a changed container and its parent dirty
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::containerMDChanged(IContainerMD* obj,
+                                   IContainerMDChangeListener::Action type)
+{
+  if (!mActive) {
+    return;
+  }
+
+  switch (type) {
+  case IContainerMDChangeListener::Updated:
+  case IContainerMDChangeListener::Deleted:
+    MarkDirty(obj->getId());
+    MarkDirty(obj->getParentId());
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Job thread loop
+//------------------------------------------------------------------------------
+void
+QuotaRecompute::backgroundThread(ThreadAssistant& assistant) noexcept
+{
+  ThreadAssistant::setSelfThreadName("QuotaRecompute");
+
+  while (!assistant.terminationRequested()) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      for (const auto& elem : mJobs) {
+        if (elem.second->mState == "queued") {
+          job = elem.second;
+          break;
+        }
+      }
+
+      if (!job) {
+        mCond.wait_for(lock, std::chrono::seconds(1));
+        continue;
+      }
+    }
+    std::string msg;
+    int retc = Run(*job, assistant, msg);
+
+    // Interrupted jobs keep their checkpoint and resume on the next master
+    if (assistant.terminationRequested()) {
+      eos_static_notice("msg=\"quota recomputation interrupted\" cxid=%08llx "
+                        "path=\"%s\"", job->mContId, job->mPath.c_str());
+      break;
+    }
+
+    if (retc) {
+      eos_static_err("msg=\"quota recomputation failed\" cxid=%08llx "
+                     "path=\"%s\" retc=%d emsg=\"%s\"", job->mContId,
+                     job->mPath.c_str(), retc, msg.c_str());
+    }
+
+    job->mWork->clear();
+
+    try {
+      mQcl->exec("HDEL", sKeyJobs, std::to_string(job->mContId)).get();
+    } catch (const std::exception& e) {
+      eos_static_err("msg=\"failed to remove quota recomputation\" "
+                     "cxid=%08llx emsg=\"%s\"", job->mContId, e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResults[job->mContId] = std::make_pair(retc, msg);
+    mJobs.erase(job->mContId);
+    mActive = !mJobs.empty();
+    mCond.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Run a job
+//------------------------------------------------------------------------------
+int
+QuotaRecompute::Run(Job& job, ThreadAssistant& assistant, std::string& msg)
+{
+  eos::QuotaRecomputeJob& work = *job.mWork;
+  auto stopped = [&assistant]() {
+    return assistant.terminationRequested();
+  };
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    try {
+      auto cont = gOFS->eosDirectoryService->getContainerMD(job.mContId);
+
+      if ((cont->getFlags() & eos::QUOTA_NODE_FLAG) == 0) {
+        msg = "error: directory is not a quota node";
+        return EINVAL;
+      }
+
+      std::string path = gOFS->eosView->getUri(cont.get());
+      uint64_t expected = 0;
+      eos::IQuotaNode* quotaNode = gOFS->eosView->getQuotaNode(cont.get());
+
+      if (quotaNode) {
+        const eos::QuotaNodeCore& core = quotaNode->getCore();
+
+        for (auto uid : core.getUids()) {
+          expected += core.getNumFilesByUser(uid);
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mMutex);
+      job.mPath = path;
+      job.mExpectedFiles = expected;
+    } catch (const eos::MDException& e) {
+      msg = e.what();
+      return e.getErrno();
+    }
+  }
+  // Changes since the job was queued are marked dirty, the older ones have
+  // to reach QuarkDB before the walk reads it
+  mFlusher->synchronize();
+  SetState(job, "walking");
+  eos_static_info("msg=\"quota recomputation started\" cxid=%08llx path=\"%s\"",
+                  job.mContId, job.mPath.c_str());
+  eos::MDStatus status = work.load();
+
+  if (status.ok()) {
+    status = work.walk(mThreads, stopped);
+  }
+
+  int pass = 0;
+  eos::common::RWMutexWriteLock ns_wr_lock;
+
+  while (true) {
+    // Re-read the containers changed meanwhile until only a few are left
+    for (; status.ok() && (pass < cMaxOnlinePasses) &&
+         (work.getNumDirty() > cMaxFinalDirty); ++pass) {
+      SetState(job, "reconciling");
+      auto dirty = work.takeDirty();
+      mFlusher->synchronize();
+      status = work.reconcile(dirty);
+
+      if (status.ok()) {
+        PruneDirty(job, dirty);
+        status = work.walk(mThreads, stopped);
+      }
+    }
+
+    if (!status.ok()) {
+      msg = status.getError();
+      return status.getErrno();
+    }
+
+    // Last changes with the namespace frozen, then swap in the new usage
+    SetState(job, "finalizing");
+    ns_wr_lock.Grab(gOFS->eosViewRWMutex);
+    mFlusher->synchronize();
+    auto dirty = work.takeDirty();
+    status = work.reconcile(dirty);
+
+    if (status.ok()) {
+      PruneDirty(job, dirty);
+    }
+
+    // Subtrees moved in meanwhile are walked with the namespace frozen only
+    // up to a limit, beyond it the walk continues online
+    if (status.ok()) {
+      status = work.walk(mThreads, stopped, cMaxFinalWalk);
+    }
+
+    if (status.ok()) {
+      break;
+    }
+
+    if ((status.getErrno() != EINTR) || stopped()) {
+      msg = status.getError();
+      return status.getErrno();
+    }
+
+    ns_wr_lock.Release();
+
+    if (pass++ >= cMaxOnlinePasses) {
+      msg = "error: too many containers changing below the quota node, "
+            "retry later";
+      return EBUSY;
+    }
+
+    SetState(job, "walking");
+    status = work.walk(mThreads, stopped);
+  }
+
+  eos::QuotaNodeCore qnc;
+  work.getCore(qnc);
+
+  try {
+    auto cont = gOFS->eosDirectoryService->getContainerMD(job.mContId);
+
+    if ((cont->getFlags() & eos::QUOTA_NODE_FLAG) == 0) {
+      msg = "error: directory is not a quota node (anymore)";
+      return EINVAL;
+    }
+
+    eos::IQuotaNode* quotaNode = gOFS->eosView->getQuotaNode(cont.get());
+
+    if (!quotaNode) {
+      msg = "error: quota node not found";
+      return ENOENT;
+    }
+
+    // Remove all the entries which should not be updated if any uid/gid
+    // specified
+    if (job.mUid.size() || job.mGid.size()) {
+      qnc.filterByUid(strtoul(job.mUid.c_str(), 0, 10));
+      qnc.filterByGid(strtoul(job.mGid.c_str(), 0, 10));
+      quotaNode->updateCore(qnc);
+    } else {
+      quotaNode->replaceCore(qnc);
+    }
+  } catch (const eos::MDException& e) {
+    msg = SSTR("error: quota node removed: " << e.what());
+    return e.getErrno();
+  }
+
+  const auto progress = work.getProgress();
+  msg = SSTR("success: quota node " << job.mPath << " recomputed, containers="
+             << progress.mContainers << " files=" << progress.mFiles
+             << " reconciled=" << progress.mReconciled);
+  eos_static_info("msg=\"quota recomputation successful\" cxid=%08llx "
+                  "path=\"%s\" containers=%llu files=%llu reconciled=%llu",
+                  job.mContId, job.mPath.c_str(), progress.mContainers,
+                  progress.mFiles, progress.mReconciled);
+  return 0;
+}
+
+EOSMGMNAMESPACE_END
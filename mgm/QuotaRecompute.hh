@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+//! @file QuotaRecompute.hh
+//! @brief Online, resumable recomputation of quota nodes
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace qclient
+{
+class QClient;
+}
+
+namespace eos
+{
+class MetadataFlusher;
+class QuotaRecomputeJob;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Recomputes quota nodes while the namespace stays online
+//!
+//! Jobs run one after the other in a background thread. Each job walks the
+//! subtree of its quota node in parallel and checkpoints in QuarkDB what it
+//! found per container. The engine listens to the file and container changes
+//! of the namespace and marks the changed containers dirty for every queued
+//! job. Once the walk is done the dirty containers are re-read, first online
+//! until only a few are left, then once more with the namespace write-locked
+//! before the quota node is replaced. Jobs interrupted by a restart or a
+//! failover resume from their checkpoint on the new master.
+//------------------------------------------------------------------------------
+class QuotaRecompute : public eos::IFileMDChangeListener,
+  public eos::IContainerMDChangeListener
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  QuotaRecompute();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~QuotaRecompute();
+
+  //----------------------------------------------------------------------------
+  //! Resume the interrupted jobs and start the job thread
+  //----------------------------------------------------------------------------
+  void Start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the job thread, the running job keeps its checkpoint
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Queue the recomputation of a quota node
+  //!
+  //! @param cont_id quota node container id
+  //! @param uid if not empty, only update this uid (and gid)
+  //! @param gid if not empty, only update this gid (and uid)
+  //! @param msg error message
+  //!
+  //! @return 0 if queued or already queued, otherwise errno
+  //----------------------------------------------------------------------------
+  int Submit(eos::IContainerMD::id_t cont_id, const std::string& uid,
+             const std::string& gid, std::string& msg);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the job of a quota node to finish
+  //!
+  //! @param cont_id quota node container id
+  //! @param msg result message
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  int Wait(eos::IContainerMD::id_t cont_id, std::string& msg);
+
+  //----------------------------------------------------------------------------
+  //! Get the progress of the queued jobs and the result of the finished ones,
+  //! one line of key=value pairs per quota node
+  //----------------------------------------------------------------------------
+  std::string GetStatus();
+
+  //----------------------------------------------------------------------------
+  //! Mark the container of a changed file dirty
+  //----------------------------------------------------------------------------
+  void fileMDChanged(IFileMDChangeListener::Event* event) override;
+
+  //----------------------------------------------------------------------------
+  //! Mark a changed container and its parent dirty
+  //----------------------------------------------------------------------------
+  void containerMDChanged(IContainerMD* obj,
+                          IContainerMDChangeListener::Action type) override;
+
+private:
+  //! Recomputation of one quota node
+  struct Job {
+    eos::IContainerMD::id_t mContId {0}; ///< Quota node container id
+    std::string mPath; ///< Quota node path
+    std::string mUid; ///< Uid filter
+    std::string mGid; ///< Gid filter
+    std::string mState {"queued"}; ///< queued, walking, reconciling, ...
+    uint64_t mExpectedFiles {0}; ///< Files accounted by the quota node
+    std::unique_ptr<eos::QuotaRecomputeJob> mWork; ///< Walk and checkpoint
+  };
+
+  //----------------------------------------------------------------------------
+  //! Job thread loop
+  //----------------------------------------------------------------------------
+  void backgroundThread(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Run a job
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  int Run(Job& job, ThreadAssistant& assistant, std::string& msg);
+
+  //----------------------------------------------------------------------------
+  //! Create a job, needs mMutex
+  //----------------------------------------------------------------------------
+  void AddJob(eos::IContainerMD::id_t cont_id, const std::string& uid,
+              const std::string& gid);
+
+  //----------------------------------------------------------------------------
+  //! Set the state of a job
+  //----------------------------------------------------------------------------
+  void SetState(Job& job, const std::string& state);
+
+  //----------------------------------------------------------------------------
+  //! Mark a container dirty for all jobs
+  //----------------------------------------------------------------------------
+  void MarkDirty(eos::IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop the persisted marks of reconciled containers, so that a resumed
+  //! job does not re-read them
+  //----------------------------------------------------------------------------
+  void PruneDirty(Job& job,
+                  const std::unordered_set<eos::IContainerMD::id_t>& ids);
+
+  AssistedThread mThread; ///< Job thread
+  std::unique_ptr<qclient::QClient> mQcl; ///< QuarkDB client of the jobs
+  eos::MetadataFlusher* mFlusher {nullptr}; ///< Namespace metadata flusher
+  size_t mThreads {16}; ///< Walk threads per job
+  std::atomic<bool> mRunning {false}; ///< Job thread is started
+  std::atomic<bool> mActive {false}; ///< Some job is queued
+  std::mutex mMutex; ///< Protects the members below
+  std::condition_variable mCond; ///< Signals queued and finished jobs
+  std::map<eos::IContainerMD::id_t, std::shared_ptr<Job>> mJobs; ///< Queue
+  //! Result of the finished jobs: errno and message
+  std::map<eos::IContainerMD::id_t, std::pair<int, std::string>> mResults;
+};
+
+EOSMGMNAMESPACE_END
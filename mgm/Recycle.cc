@@ -36,6 +36,8 @@
 #include "namespace/interface/IView.hh"
 #include "namespace/Prefetcher.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
+#include <algorithm>
+#include <future>
 
 // MgmOfsConfigure prepends the proc directory path e.g. the bin is
 // /eos/<instance/proc/recycle/
@@ -45,6 +47,8 @@ std::string Recycle::gRecyclingTimeAttribute = "sys.recycle.keeptime";
 std::string Recycle::gRecyclingKeepRatio = "sys.recycle.keepratio";
 std::string Recycle::gRecyclingVersionKey = "sys.recycle.version.key";
 std::string Recycle::gRecyclingPostFix = ".d";
+std::string Recycle::gRecyclingPurgeThreads = "sys.recycle.purge.threads";
+std::string Recycle::gRecyclingPurgeRate = "sys.recycle.purge.rate";
 int Recycle::gRecyclingPollTime = 30;
 
 EOSMGMNAMESPACE_BEGIN
@@ -87,6 +91,7 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
   unsigned long long lLowInodesWatermark = 0;
   unsigned long long lLowSpaceWatermark = 0;
   bool show_attribute_missing = true;
+  bool index_dropped = false;
   eos_static_info("%s", "\"msg = \"recycling thread started\"");
   gOFS->WaitUntilNamespaceIsBooted(assistant);
 
@@ -124,6 +129,20 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
 
     // This will be reconfigured to an appropriate value later
     snoozetime = gRecyclingPollTime;
+    RecycleIndex* index = GetIndex(false);
+
+    if (index) {
+      if (!mIndexReady) {
+        mIndexReady = index->IsBuilt() || BuildIndex(assistant);
+      }
+
+      ConfigurePurge();
+    } else if (!index_dropped && InitIndex()) {
+      // An index which is not maintained gets stale, force a rebuild once
+      // it is enabled again
+      InitIndex()->SetBuilt(false);
+      index_dropped = true;
+    }
     // Read our current policy setting
     eos::IContainerMD::XAttrMap attrmap;
 
@@ -176,7 +195,12 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
                         lDeletionMap.size());
 
         if (lKeepTime > 0) {
-          if (!lDeletionMap.size()) {
+          if (index && mIndexReady) {
+            lDeletionMap.clear();
+            snoozetime = ExpireIndexed(assistant, lKeepTime,
+                                       attrmap.count(Recycle::gRecyclingKeepRatio),
+                                       lLowInodesWatermark, lLowSpaceWatermark);
+          } else if (!lDeletionMap.size()) {
             //...................................................................
             //  the deletion map is filled if there is nothing inside with files/
             //  directories found previously in the garbage bin
@@ -388,81 +412,22 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
                 }
 
                 XrdOucString delpath = it->second.c_str();
+                bool is_dir = ((it->second.length()) &&
+                               (delpath.endswith(Recycle::gRecyclingPostFix.c_str())));
 
-                if ((it->second.length()) &&
-                    (delpath.endswith(Recycle::gRecyclingPostFix.c_str()))) {
-                  // Do a directory deletion - first find all subtree children
-                  std::map<std::string, std::set<std::string> > found;
-                  std::map<std::string, std::set<std::string> >::const_reverse_iterator rfoundit;
-                  XrdOucString err_msg;
-
-                  if (gOFS->_find(it->second.c_str(), lError, err_msg, rootvid, found)) {
-                    eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"",
-                                   it->second.c_str(), err_msg.c_str());
-                  } else {
-                    // Delete files starting at the deepest level
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
-                      for (auto fileit = rfoundit->second.begin();
-                           fileit != rfoundit->second.end();
-                           fileit++) {
-                        // Symlink files returned by the find command above contain
-                        // a pointer to the original name which needs to be removed
-                        // so that we can properly stat the file.
-                        std::string fname = *fileit;
-                        size_t pos = fname.find(" -> ");
-
-                        if (pos != std::string::npos) {
-                          fname.erase(pos);
-                          eos_static_debug("orig_path=\"%s\" symlink_path=\"%s\"",
-                                           fileit->c_str(), fname.c_str());
-                        }
-
-                        std::string fullpath = rfoundit->first;
-                        fullpath += fname;
-
-                        if (gOFS->_rem(fullpath.c_str(), lError, rootvid, (const char*) 0)) {
-                          eos_static_err("msg=\"unable to remove file\" path=%s",
-                                         fullpath.c_str());
-                        } else {
-                          eos_static_info("msg=\"permanently deleted file from recycle bin\" "
-                                          "path=%s keep-time=%llu", fullpath.c_str(), lKeepTime);
-                        }
-                      }
-                    }
+                if (!RemoveFromBin(it->second, is_dir)) {
+                  eos_static_info("msg=\"permanently deleted from recycle bin\" "
+                                  "path=%s keep-time=%llu", it->second.c_str(),
+                                  lKeepTime);
 
-                    // Delete directories starting at the deepest level
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
-                      // Don't even try to delete the root directory
-                      std::string fspath = rfoundit->first.c_str();
-
-                      if (fspath == "/") {
-                        continue;
-                      }
-
-                      if (gOFS->_remdir(rfoundit->first.c_str(), lError, rootvid, (const char*) 0)) {
-                        eos_static_err("msg=\"unable to remove directory\" path=%s",
-                                       fspath.c_str());
-                      } else {
-                        eos_static_info("msg=\"permanently deleted directory from "
-                                        "recycle bin\" path=%s keep-time=%llu",
-                                        fspath.c_str(), lKeepTime);
-                      }
-                    }
-                  }
-
-                  lDeletionMap.erase(it);
-                  it = lDeletionMap.begin();
-                } else {
-                  // Do a single file deletion
-                  if (gOFS->_rem(it->second.c_str(), lError, rootvid, (const char*) 0)) {
-                    eos_static_err("msg=\"unable to remove file\" path=\"%s\" "
-                                   "err_msg=\"%s\" errc=%i", it->second.c_str(),
-                                   lError.getErrText(), lError.getErrInfo());
+                  if (index) {
+                    eos::common::Path cpath(it->second.c_str());
+                    index->Remove(RecycleIndex::GetKeyFromName(cpath.GetName()));
                   }
-
-                  lDeletionMap.erase(it);
-                  it = lDeletionMap.begin();
                 }
+
+                lDeletionMap.erase(it);
+                it = lDeletionMap.begin();
               } else {
                 // This entry has still to be kept
                 eos_static_info("oldest entry: %lld sec to deletion",
@@ -512,6 +477,497 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
   eos_static_info("%s", "msg=\"recycler thread exiting\"");
 }
 
+//------------------------------------------------------------------------------
+// Create the index objects once
+//------------------------------------------------------------------------------
+RecycleIndex*
+Recycle::InitIndex()
+{
+  std::call_once(mIndexInit, [this]() {
+    if (gOFS->mQdbContactDetails.members.empty()) {
+      return;
+    }
+
+    mQcl = std::make_unique<qclient::QClient>(gOFS->mQdbContactDetails.members,
+           gOFS->mQdbContactDetails.constructOptions());
+    mIndex = std::make_unique<RecycleIndex>(*mQcl);
+
+    if (gOFS->mRecycleIndex) {
+      mPurgePool = std::make_unique<eos::common::ThreadPool>
+                   (cMaxPurgeThreads, cMaxPurgeThreads, 10, 6, 5, "recycle");
+    }
+  });
+  return mIndex.get();
+}
+
+//------------------------------------------------------------------------------
+// Get the recycle bin index
+//------------------------------------------------------------------------------
+RecycleIndex*
+Recycle::GetIndex(bool ready)
+{
+  if (!gOFS->mRecycleIndex || (ready && !mIndexReady)) {
+    return nullptr;
+  }
+
+  return InitIndex();
+}
+
+//------------------------------------------------------------------------------
+// Mark the recycle bin index as incomplete
+//------------------------------------------------------------------------------
+void
+Recycle::InvalidateIndex()
+{
+  mIndexReady = false;
+
+  if (RecycleIndex* index = GetIndex(false)) {
+    index->SetBuilt(false);
+  }
+
+  WakeUp();
+}
+
+//------------------------------------------------------------------------------
+// Fill the index from the recycle bin directories
+//------------------------------------------------------------------------------
+bool
+Recycle::BuildIndex(ThreadAssistant& assistant)
+{
+  RecycleIndex* index = GetIndex(false);
+  eos::common::VirtualIdentity rootvid = eos::common::VirtualIdentity::Root();
+  XrdMgmOfsDirectory dirl;
+  std::vector<std::string> bins;
+  uint64_t nentries = 0;
+
+  if (!index) {
+    return false;
+  }
+
+  eos_static_notice("msg=\"building recycle bin index\" recycle-path=%s",
+                    Recycle::gRecyclingPrefix.c_str());
+
+  if (dirl.open(Recycle::gRecyclingPrefix.c_str(), rootvid, (const char*) 0)) {
+    eos_static_err("msg=\"unable to list the garbage directory level-1\" "
+                   "recycle-path=%s", Recycle::gRecyclingPrefix.c_str());
+    return false;
+  }
+
+  const char* dname;
+
+  while ((dname = dirl.nextEntry())) {
+    std::string sdname = dname;
+
+    if ((sdname != ".") && (sdname != "..")) {
+      bins.push_back(sdname);
+    }
+  }
+
+  dirl.close();
+
+  for (const auto& bin : bins) {
+    if (assistant.terminationRequested()) {
+      return false;
+    }
+
+    // The new bin layout is uid:<uid>/<year>/<month>/<day>/<index>/<entry>,
+    // the old one <gid>/<uid>/<entry>
+    bool new_layout = (bin.substr(0, 4) == "uid:");
+    std::string bindir = Recycle::gRecyclingPrefix + bin + "/";
+    std::map<std::string, std::set<std::string>> findmap;
+    XrdOucErrInfo lError;
+    XrdOucString err_msg;
+    (void) gOFS->_find(bindir.c_str(), lError, err_msg, rootvid, findmap,
+                       0, 0, false, 0, true, new_layout ? 5 : 2);
+    std::vector<std::string> candidates;
+
+    for (auto dirit = findmap.begin(); dirit != findmap.end(); ++dirit) {
+      XrdOucString dirname = dirit->first.c_str();
+
+      if (dirname.endswith(".d/")) {
+        std::string dirpath = dirit->first;
+        dirpath.erase(dirpath.length() - 1);
+        candidates.push_back(dirpath);
+        continue;
+      }
+
+      for (auto fileit = dirit->second.begin(); fileit != dirit->second.end();
+           ++fileit) {
+        std::string fname = *fileit;
+        size_t pos = fname.find(" -> ");
+
+        if (pos != std::string::npos) {
+          fname.erase(pos);
+        }
+
+        if (fname.find('#') == 0) {
+          candidates.push_back(dirit->first + fname);
+        }
+      }
+    }
+
+    for (const auto& path : candidates) {
+      eos::common::Path cpath(path.c_str());
+      std::string parent = cpath.GetParentPath();
+      RecycleIndex::Entry entry;
+      entry.mKey = RecycleIndex::GetKeyFromName(cpath.GetName());
+      struct stat buf;
+
+      // Skip anything below a recursively deleted directory
+      if (entry.mKey.empty() ||
+          (parent.find(Recycle::gRecyclingPostFix + "/", bindir.length()) !=
+           std::string::npos) ||
+          gOFS->_stat(path.c_str(), &buf, lError, rootvid, "", nullptr, false)) {
+        continue;
+      }
+
+      entry.mPath = path;
+      entry.mSize = buf.st_size;
+      entry.mDeletionTime = buf.st_ctime;
+
+      if (new_layout) {
+        entry.mUid = strtoul(bin.c_str() + 4, nullptr, 10);
+        entry.mGid = buf.st_gid;
+      } else {
+        entry.mGid = strtoul(bin.c_str(), nullptr, 10);
+        entry.mUid = strtoul(parent.c_str() + bindir.length(), nullptr, 10);
+      }
+
+      if (!index->Add(entry)) {
+        return false;
+      }
+
+      ++nentries;
+    }
+  }
+
+  if (!index->SetBuilt(true)) {
+    return false;
+  }
+
+  eos_static_notice("msg=\"built recycle bin index\" entries=%llu",
+                    (unsigned long long) nentries);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Purge all expired entries using the index
+//------------------------------------------------------------------------------
+time_t
+Recycle::ExpireIndexed(ThreadAssistant& assistant, time_t keep_time,
+                       bool check_ratio, unsigned long long low_inodes,
+                       unsigned long long low_space)
+{
+  RecycleIndex* index = GetIndex();
+
+  if (!index) {
+    return gRecyclingPollTime;
+  }
+
+  while (!assistant.terminationRequested()) {
+    // If there is a keep-ratio policy defined we stop deleting once we are
+    // enough under the thresholds
+    if (check_ratio) {
+      auto map_quotas = Quota::GetGroupStatistics(Recycle::gRecyclingPrefix,
+                        Quota::gProjectId);
+
+      if (!map_quotas.empty() &&
+          (low_inodes >= map_quotas[SpaceQuota::kGroupFilesIs]) &&
+          (low_space >= map_quotas[SpaceQuota::kGroupBytesIs])) {
+        eos_static_debug("%s", "msg=\"skipping recycle clean-up - ratio went "
+                         "under low watermarks\"");
+        return gRecyclingPollTime;
+      }
+    }
+
+    std::string cursor;
+    std::vector<RecycleIndex::Entry> entries =
+      index->List(true, 0, 0, time(NULL) - keep_time, cursor,
+                  RecycleIndex::cBatchSize);
+
+    if (entries.empty()) {
+      break;
+    }
+
+    uint64_t nfiles = 0;
+    uint64_t nbulk = 0;
+    PurgeEntries(entries, nfiles, nbulk);
+    eos_static_info("msg=\"purged expired entries from recycle bin\" "
+                    "files=%llu bulk=%llu keep-time=%llu",
+                    (unsigned long long) nfiles, (unsigned long long) nbulk,
+                    (unsigned long long) keep_time);
+
+    // Entries which cannot be removed stay in the index, don't spin on them
+    if (!nfiles && !nbulk) {
+      break;
+    }
+  }
+
+  // Define the sleep period from the oldest entry
+  std::string cursor;
+  std::vector<RecycleIndex::Entry> oldest = index->List(true, 0, 0, 0, cursor,
+      1);
+  time_t snoozetime = gRecyclingPollTime;
+
+  if (!oldest.empty()) {
+    snoozetime = oldest[0].mDeletionTime + keep_time - time(NULL);
+    eos_static_info("oldest entry: %lld sec to deletion", (long long) snoozetime);
+
+    if (snoozetime < gRecyclingPollTime) {
+      snoozetime = gRecyclingPollTime;
+    }
+
+    if (snoozetime > keep_time) {
+      snoozetime = keep_time;
+    }
+  }
+
+  return snoozetime;
+}
+
+//------------------------------------------------------------------------------
+// Read the purge pipeline settings from the recycle bin attributes
+//------------------------------------------------------------------------------
+void
+Recycle::ConfigurePurge()
+{
+  eos::common::VirtualIdentity rootvid = eos::common::VirtualIdentity::Root();
+  eos::IContainerMD::XAttrMap attrmap;
+  XrdOucErrInfo lError;
+  unsigned long long threads = cDefaultPurgeThreads;
+  unsigned long long rate = 0;
+
+  if (gOFS->_attr_ls(Recycle::gRecyclingPrefix.c_str(), lError, rootvid, "",
+                     attrmap)) {
+    return;
+  }
+
+  if (attrmap.count(Recycle::gRecyclingPurgeThreads)) {
+    threads = strtoull(attrmap[Recycle::gRecyclingPurgeThreads].c_str(), 0, 10);
+    threads = std::min<unsigned long long>(std::max(threads, 1ull),
+                                           cMaxPurgeThreads);
+  }
+
+  if (attrmap.count(Recycle::gRecyclingPurgeRate)) {
+    rate = strtoull(attrmap[Recycle::gRecyclingPurgeRate].c_str(), 0, 10);
+  }
+
+  mPurgeThreads = threads;
+
+  if (rate != mPurgeRate) {
+    if (rate) {
+      mPurgeRateLimit.SetRatePerSecond(rate);
+    }
+
+    mPurgeRate = rate;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove indexed entries from the recycle bin using the purge thread pool
+//------------------------------------------------------------------------------
+void
+Recycle::PurgeEntries(const std::vector<RecycleIndex::Entry>& entries,
+                      uint64_t& nfiles, uint64_t& nbulk)
+{
+  RecycleIndex* index = GetIndex(false);
+  std::atomic<uint64_t> files {0};
+  std::atomic<uint64_t> bulk {0};
+  // Worker w takes care of the entries w, w + nworkers, w + 2 * nworkers ...
+  auto purge = [&](size_t w, size_t nworkers) {
+    for (size_t i = w; i < entries.size(); i += nworkers) {
+      const RecycleIndex::Entry& entry = entries[i];
+
+      if (mPurgeRate) {
+        mPurgeRateLimit.Allow();
+      }
+
+      int rc = RemoveFromBin(entry.mPath, entry.IsDirectory());
+
+      if (index && (!rc || (rc == ENOENT))) {
+        index->Remove(entry.mKey);
+      }
+
+      if (!rc) {
+        if (entry.IsDirectory()) {
+          ++bulk;
+        } else {
+          ++files;
+        }
+      }
+    }
+  };
+  size_t nworkers = std::min<size_t>(mPurgeThreads, entries.size());
+
+  if (!mPurgePool || (nworkers <= 1)) {
+    purge(0, 1);
+  } else {
+    std::vector<std::future<void>> futures;
+
+    for (size_t w = 0; w < nworkers; ++w) {
+      futures.push_back(mPurgePool->PushTask<void>([&purge, w, nworkers]() {
+        purge(w, nworkers);
+      }));
+    }
+
+    for (auto& fut : futures) {
+      fut.get();
+    }
+  }
+
+  nfiles += files;
+  nbulk += bulk;
+}
+
+//------------------------------------------------------------------------------
+// Permanently remove a file or directory tree from the recycle bin
+//------------------------------------------------------------------------------
+int
+Recycle::RemoveFromBin(const std::string& path, bool is_dir)
+{
+  eos::common::VirtualIdentity rootvid = eos::common::VirtualIdentity::Root();
+  XrdOucErrInfo lError;
+
+  // Never touch anything outside of the recycle bin
+  if ((path.find(Recycle::gRecyclingPrefix) != 0) ||
+      (path.find("/../") != std::string::npos)) {
+    eos_static_err("msg=\"refusing to remove path outside of the recycle bin\" "
+                   "path=\"%s\"", path.c_str());
+    return EPERM;
+  }
+
+  if (!is_dir) {
+    // Do a single file deletion
+    if (gOFS->_rem(path.c_str(), lError, rootvid, (const char*) 0)) {
+      int errc = lError.getErrInfo();
+
+      if (errc != ENOENT) {
+        eos_static_err("msg=\"unable to remove file\" path=\"%s\" "
+                       "err_msg=\"%s\" errc=%i", path.c_str(),
+                       lError.getErrText(), errc);
+      }
+
+      return (errc ? errc : EIO);
+    }
+
+    return 0;
+  }
+
+  struct stat buf;
+
+  if (gOFS->_stat(path.c_str(), &buf, lError, rootvid, "", nullptr, false)) {
+    return ENOENT;
+  }
+
+  // Do a directory deletion - first find all subtree children
+  std::map<std::string, std::set<std::string> > found;
+  std::map<std::string, std::set<std::string> >::const_reverse_iterator rfoundit;
+  XrdOucString err_msg;
+  int retc = 0;
+
+  if (gOFS->_find(path.c_str(), lError, err_msg, rootvid, found)) {
+    eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"",
+                   path.c_str(), err_msg.c_str());
+    return EIO;
+  }
+
+  // Delete files starting at the deepest level
+  for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
+    for (auto fileit = rfoundit->second.begin();
+         fileit != rfoundit->second.end();
+         fileit++) {
+      // Symlink files returned by the find command above contain
+      // a pointer to the original name which needs to be removed
+      // so that we can properly stat the file.
+      std::string fname = *fileit;
+      size_t pos = fname.find(" -> ");
+
+      if (pos != std::string::npos) {
+        fname.erase(pos);
+        eos_static_debug("orig_path=\"%s\" symlink_path=\"%s\"",
+                         fileit->c_str(), fname.c_str());
+      }
+
+      std::string fullpath = rfoundit->first;
+      fullpath += fname;
+
+      if (gOFS->_rem(fullpath.c_str(), lError, rootvid, (const char*) 0)) {
+        eos_static_err("msg=\"unable to remove file\" path=%s",
+                       fullpath.c_str());
+        retc = EIO;
+      } else {
+        eos_static_debug("msg=\"permanently deleted file from recycle bin\" "
+                         "path=%s", fullpath.c_str());
+      }
+    }
+  }
+
+  // Delete directories starting at the deepest level
+  for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
+    // Don't even try to delete the root directory
+    std::string fspath = rfoundit->first.c_str();
+
+    if (fspath == "/") {
+      continue;
+    }
+
+    if (gOFS->_remdir(rfoundit->first.c_str(), lError, rootvid, (const char*) 0)) {
+      eos_static_err("msg=\"unable to remove directory\" path=%s",
+                     fspath.c_str());
+      retc = EIO;
+    } else {
+      eos_static_debug("msg=\"permanently deleted directory from recycle bin\" "
+                       "path=%s", fspath.c_str());
+    }
+  }
+
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Convert a date filter into the range of local times it covers
+//------------------------------------------------------------------------------
+bool
+Recycle::GetDateRange(const std::string& date, time_t& from, time_t& until)
+{
+  unsigned int year = 0, month = 1, day = 1;
+  from = until = 0;
+
+  if (date.empty()) {
+    return true;
+  }
+
+  int n = sscanf(date.c_str(), "%u/%u/%u", &year, &month, &day);
+
+  if ((n < 1) || (year < 1970) || (month < 1) || (month > 12) ||
+      (day < 1) || (day > 31)) {
+    return false;
+  }
+
+  struct tm tm {};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_isdst = -1;
+  from = mktime(&tm);
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+  tm.tm_isdst = -1;
+
+  if (n == 1) {
+    tm.tm_year++;
+  } else if (n == 2) {
+    tm.tm_mon++;
+  } else {
+    tm.tm_mday++;
+  }
+
+  until = mktime(&tm);
+  return ((from != (time_t) - 1) && (until != (time_t) - 1));
+}
+
 /*----------------------------------------------------------------------------*/
 int
 Recycle::ToGarbage(const char* epname, XrdOucErrInfo& error, bool fusexcast)
@@ -566,22 +1022,128 @@ Recycle::ToGarbage(const char* epname, XrdOucErrInfo& error, bool fusexcast)
     return gOFS->Emsg(epname, error, EIO, "rename file/directory", srecyclepath);
   }
 
+  if (RecycleIndex* index = gOFS->Recycler->GetIndex(false)) {
+    RecycleIndex::Entry entry;
+    XrdOucErrInfo lError;
+    struct stat buf;
+    entry.mKey = RecycleIndex::GetKey(mId, isdir);
+    entry.mPath = srecyclepath;
+    entry.mUid = mOwnerUid;
+    entry.mGid = mOwnerGid;
+    entry.mDeletionTime = time(NULL);
+
+    if (!gOFS->_stat(srecyclepath, &buf, lError, rootvid, "", nullptr, false)) {
+      entry.mSize = buf.st_size;
+    }
+
+    // A missing entry would go unnoticed, have the index rebuilt instead
+    if (!index->Add(entry)) {
+      gOFS->Recycler->InvalidateIndex();
+    }
+  }
+
   // store the recycle path in the error object
   error.setErrInfo(0, srecyclepath);
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Print one entry of the recycle bin listing
+//------------------------------------------------------------------------------
+static void
+PrintEntry(std::ostringstream& oss_out, Recycle::RecycleListing* rvec,
+           bool monitoring, bool translateids, bool header, uid_t uid,
+           gid_t gid, unsigned long long size, time_t dtime,
+           const std::string& type, const std::string& origpath,
+           const std::string& originode, const std::string& deleter)
+{
+  using namespace eos::common;
+  std::string uids;
+  std::string gids;
+
+  if (translateids) {
+    int errc = 0;
+    uids = eos::common::Mapping::UidToUserName(uid, errc);
+
+    if (errc) {
+      uids = eos::common::Mapping::UidAsString(uid);
+    }
+
+    gids = eos::common::Mapping::GidToGroupName(gid, errc);
+
+    if (errc) {
+      gids = eos::common::Mapping::GidAsString(gid);
+    }
+  } else {
+    uids = eos::common::Mapping::UidAsString(uid);
+    gids = eos::common::Mapping::GidAsString(gid);
+  }
+
+  if (monitoring) {
+    oss_out << "recycle=ls recycle-bin=" << Recycle::gRecyclingPrefix
+            << " uid=" << uids << " gid=" << gids
+            << " size=" << std::to_string(size)
+            << " deletion-time=" << std::to_string(dtime)
+            << " type=" << type
+            << " keylength.restore-path=" << origpath.length()
+            << " restore-path=" << origpath
+            << " restore-key=" << originode
+            << " dtrace=\"" << deleter << "\""
+            << std::endl;
+
+    if (rvec) {
+      std::map<std::string, std::string> rmap;
+      rmap["uid"] = std::to_string(uid);
+      rmap["gid"] = std::to_string(gid);
+      rmap["username"] = uids;
+      rmap["groupname"] = gids;
+      rmap["size"] = std::to_string(size);
+      rmap["dtime"] = std::to_string(dtime);
+      rmap["type"] = type;
+      rmap["path"] = origpath;
+      rmap["key"] = originode;
+      rmap["dtrace"] = deleter;
+      rvec->push_back(rmap);
+    }
+  } else {
+    char sline[4096];
+
+    if (header) {
+      // print a header
+      snprintf(sline, sizeof(sline) - 1,
+               "# %-24s %-8s %-8s %-12s %-13s %-21s %-64s %-32s\n", "Deletion Time", "UID",
+               "GID",
+               "SIZE", "TYPE", "RESTORE-KEY", "RESTORE-PATH", "DTRACE");
+      oss_out << sline
+              << "# ================================================"
+              << "=================================================="
+              << "========================================================="
+              << "============================="
+              << std::endl;
+    }
+
+    char tdeltime[4096];
+    std::string deltime = ctime_r(&dtime, tdeltime);
+    deltime.erase(deltime.length() - 1);
+    snprintf(sline, sizeof(sline) - 1,
+             "%-26s %-8s %-8s %-12s %-13s %-16s %-64s %-32s",
+             deltime.c_str(), uids.c_str(), gids.c_str(),
+             StringConversion::GetSizeString(size).c_str(),
+             type.c_str(), originode.c_str(), origpath.c_str(), deleter.c_str());
+    oss_out << sline << std::endl;
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 
 int
 Recycle::Print(std::string& std_out, std::string& std_err,
                eos::common::VirtualIdentity& vid, bool monitoring,
                bool translateids, bool details, std::string date, bool global,
-               Recycle::RecycleListing* rvec, bool whodeleted, int32_t maxentries)
+               Recycle::RecycleListing* rvec, bool whodeleted, int32_t maxentries,
+               const std::string& cursor)
 {
   using namespace eos::common;
-  XrdOucString uids;
-  XrdOucString gids;
   std::map<uid_t, bool> printmap;
   eos::common::VirtualIdentity rootvid = eos::common::VirtualIdentity::Root();
   std::ostringstream oss_out;
@@ -591,6 +1153,95 @@ Recycle::Print(std::string& std_out, std::string& std_err,
     return EINVAL;
   }
 
+  RecycleIndex* index = gOFS->Recycler ? gOFS->Recycler->GetIndex() : nullptr;
+
+  if (details && index) {
+    // list a time ordered page from the index instead of walking the bins
+    time_t from = 0;
+    time_t until = 0;
+    bool all = global && ((!vid.uid) || (vid.hasUid(3)) || (vid.hasGid(4)));
+    size_t limit = (maxentries > 0) ? maxentries : 0;
+    bool capped = false;
+    size_t count = 0;
+
+    if (!GetDateRange(date, from, until)) {
+      std_err = "error: the date has to be <year> or <year>/<month> or "
+                "<year>/<month>/<day>\n";
+      return EINVAL;
+    }
+
+    if ((vid.uid) && (!vid.sudoer) && (!limit || (limit > 100000))) {
+      limit = 100000;
+      capped = true;
+    }
+
+    std::string next = cursor;
+    std::vector<RecycleIndex::Entry> entries = index->List(all, vid.uid, from,
+        until, next, limit);
+
+    for (const auto& entry : entries) {
+      eos::common::Path cpath(entry.mPath.c_str());
+      XrdOucString origpath = cpath.GetName();
+      std::string type = entry.IsDirectory() ? "recursive-dir" : "file";
+      std::string deleter;
+      XrdOucErrInfo error;
+
+      // demangle the original pathname
+      while (origpath.replace("#:#", "/")) {
+      }
+
+      if (entry.IsDirectory()) {
+        origpath.erase(origpath.length() - Recycle::gRecyclingPostFix.length());
+      }
+
+      if (origpath.length() < 17) {
+        continue;
+      }
+
+      origpath.erase(origpath.length() - 17);
+
+      if (whodeleted) {
+        if (gOFS->_attr_get(entry.mPath.c_str(), error, vid, "",
+                            eos::common::EOS_DTRACE_ATTR, deleter)) {
+          deleter = "{}";
+        }
+      }
+
+      if (!monitoring && (oss_out.tellp() > 1 * 1024 * 1024 * 1024)) {
+        oss_out << "... (truncated after 1G of output)" << std::endl;
+        std_out += oss_out.str();
+        std_err += "warning: list too long - truncated after 1GB of output!\n";
+        return E2BIG;
+      }
+
+      PrintEntry(oss_out, rvec, monitoring, translateids, (count == 0),
+                 entry.mUid, entry.mGid, entry.mSize, entry.mDeletionTime,
+                 type, origpath.c_str(), entry.mKey, deleter);
+      count++;
+    }
+
+    if (next.empty()) {
+      std_out += oss_out.str();
+      return 0;
+    }
+
+    // more entries are available, tell the client where to continue
+    if (monitoring) {
+      oss_out << "recycle=ls next-cursor=" << next << std::endl;
+    } else if (capped) {
+      oss_out << "... (truncated)" << std::endl;
+      std_err += "warning: list too long - truncated after 100000 entries!\n";
+    }
+
+    std_err += "info: list limited to ";
+    std_err += std::to_string(limit);
+    std_err += " entries - continue with cursor ";
+    std_err += next;
+    std_err += "\n";
+    std_out += oss_out.str();
+    return E2BIG;
+  }
+
   if (global && ((!vid.uid) ||
                  (vid.hasUid(3)) ||
                  (vid.hasGid(4)))) {
@@ -709,24 +1360,6 @@ Recycle::Print(std::string& std_out, std::string& std_err,
           struct stat buf;
 
           if (!gOFS->_stat(fullpath.c_str(), &buf, error, vid, "", nullptr, false)) {
-            if (translateids) {
-              int errc = 0;
-              uids = eos::common::Mapping::UidToUserName(buf.st_uid, errc).c_str();
-
-              if (errc) {
-                uids = eos::common::Mapping::UidAsString(buf.st_uid).c_str();
-              }
-
-              gids = eos::common::Mapping::GidToGroupName(buf.st_gid, errc).c_str();
-
-              if (errc) {
-                gids = eos::common::Mapping::GidAsString(buf.st_gid).c_str();
-              }
-            } else {
-              uids = eos::common::Mapping::UidAsString(buf.st_uid).c_str();
-              gids = eos::common::Mapping::GidAsString(buf.st_gid).c_str();
-            }
-
             if (origpath.endswith(Recycle::gRecyclingPostFix.c_str())) {
               type = "recursive-dir";
               origpath.erase(origpath.length() - Recycle::gRecyclingPostFix.length());
@@ -752,69 +1385,18 @@ Recycle::Print(std::string& std_out, std::string& std_err,
               }
             }
 
-            if (monitoring) {
-              oss_out << "recycle=ls recycle-bin=" << Recycle::gRecyclingPrefix
-                      << " uid=" << uids.c_str() << " gid=" << gids.c_str()
-                      << " size=" << std::to_string(buf.st_size)
-                      << " deletion-time=" << std::to_string(buf.st_ctime)
-                      << " type=" << type.c_str()
-                      << " keylength.restore-path=" << origpath.length()
-                      << " restore-path=" << origpath.c_str()
-                      << " restore-key=" << originode.c_str()
-                      << " dtrace=\"" << deleter.c_str() << "\""
-                      << std::endl;
-
-              if (rvec) {
-                std::map<std::string, std::string> rmap;
-                rmap["uid"] = std::to_string(buf.st_uid);
-                rmap["gid"] = std::to_string(buf.st_gid);
-                rmap["username"] = uids.c_str();
-                rmap["groupname"] = gids.c_str();
-                rmap["size"] = std::to_string(buf.st_size);
-                rmap["dtime"] = std::to_string(buf.st_ctime);
-                rmap["type"] = type.c_str();
-                rmap["path"] = origpath.c_str();
-                rmap["key"] = originode.c_str();
-                rmap["dtrace"] = deleter.c_str();
-                rvec->push_back(rmap);
-              }
-            } else {
-              char sline[4096];
-
-              if (count == 0) {
-                // print a header
-                snprintf(sline, sizeof(sline) - 1,
-                         "# %-24s %-8s %-8s %-12s %-13s %-21s %-64s %-32s\n", "Deletion Time", "UID",
-                         "GID",
-                         "SIZE", "TYPE", "RESTORE-KEY", "RESTORE-PATH", "DTRACE");
-                oss_out << sline
-                        << "# ================================================"
-                        << "=================================================="
-                        << "========================================================="
-                        << "============================="
-                        << std::endl;
-              }
-
-              char tdeltime[4096];
-              std::string deltime = ctime_r(&buf.st_ctime, tdeltime);
-              deltime.erase(deltime.length() - 1);
-              snprintf(sline, sizeof(sline) - 1,
-                       "%-26s %-8s %-8s %-12s %-13s %-16s %-64s %-32s",
-                       deltime.c_str(), uids.c_str(), gids.c_str(),
-                       StringConversion::GetSizeString((unsigned long long) buf.st_size).c_str(),
-                       type.c_str(), originode.c_str(), origpath.c_str(), deleter.c_str());
-
-              if (oss_out.tellp() > 1 * 1024 * 1024 * 1024) {
-                retc = E2BIG;
-                oss_out << "... (truncated after 1G of output)" << std::endl;
-                std_out += oss_out.str();
-                std_err += "warning: list too long - truncated after 1GB of output!\n";
-                return E2BIG;
-              }
-
-              oss_out << sline << std::endl;
+            if (!monitoring && (oss_out.tellp() > 1 * 1024 * 1024 * 1024)) {
+              retc = E2BIG;
+              oss_out << "... (truncated after 1G of output)" << std::endl;
+              std_out += oss_out.str();
+              std_err += "warning: list too long - truncated after 1GB of output!\n";
+              return E2BIG;
             }
 
+            PrintEntry(oss_out, rvec, monitoring, translateids, (count == 0),
+                       buf.st_uid, buf.st_gid, buf.st_size, buf.st_ctime,
+                       type.c_str(), origpath.c_str(), originode.c_str(),
+                       deleter);
             count++;
 
             if ((vid.uid) && (!vid.sudoer) && (count > 100000)) {
@@ -1144,7 +1726,28 @@ Recycle::Restore(std::string& std_out, std::string& std_err,
   while (newrprefix.replace("//", "/")) {
   }
 
-  {
+  RecycleIndex* index = gOFS->Recycler ? gOFS->Recycler->GetIndex(false) :
+                        nullptr;
+  RecycleIndex::Entry entry;
+  bool indexed = false;
+
+  // The index maps the key directly to the path inside the recycle bin
+  if (index && gOFS->Recycler->GetIndex()) {
+    indexed = ((!force_directory &&
+                index->Get(RecycleIndex::GetKey(fid, false), entry)) ||
+               (!force_file && index->Get(RecycleIndex::GetKey(fid, true), entry)));
+  }
+
+  if (indexed) {
+    recyclepath = entry.mPath;
+    repath = recyclepath.c_str();
+
+    if (!repath.beginswith(rprefix.c_str()) &&
+        !repath.beginswith(newrprefix.c_str())) {
+      std_err = "error: this is not an entry in your recycle bin\n";
+      return EPERM;
+    }
+  } else {
     // TODO(gbitzes): This could be more precise...
     eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
     eos::Prefetcher::prefetchContainerMDWithParentsAndWait(gOFS->eosView, fid);
@@ -1217,10 +1820,20 @@ Recycle::Restore(std::string& std_out, std::string& std_err,
                   cPath.GetPath());
 
   if (gOFS->_stat(cPath.GetPath(), &buf, lError, rootvid, "", nullptr, false)) {
+    if (indexed) {
+      // stale index entry, the object is gone from the recycle bin
+      index->Remove(entry.mKey);
+      std_err = "error: cannot find object referenced by recycle-key=";
+      std_err += key;
+      return ENOENT;
+    }
+
     std_err += "error: unable to stat path to be recycled\n";
     return EIO;
   }
 
+  bool is_dir = S_ISDIR(buf.st_mode);
+
   // check that the client is the owner of that object
   if (vid.uid != buf.st_uid) {
     std_err +=
@@ -1303,6 +1916,10 @@ Recycle::Restore(std::string& std_out, std::string& std_err,
     std_out += "\n";
   }
 
+  if (index) {
+    index->Remove(indexed ? entry.mKey : RecycleIndex::GetKey(fid, is_dir));
+  }
+
   if (restore_versions == false) {
     // don't restore old versions
     return 0;
@@ -1420,6 +2037,7 @@ Recycle::Purge(std::string& std_out, std::string& std_err,
   int nfiles_deleted = 0;
   int nbulk_deleted = 0;
   std::string rpath;
+  const std::string rkey = key;
 
   // fix security hole
   if (date.find("..") != std::string::npos) {
@@ -1452,6 +2070,58 @@ Recycle::Purge(std::string& std_out, std::string& std_err,
     return EPERM;
   }
 
+  RecycleIndex* index = gOFS->Recycler ? gOFS->Recycler->GetIndex() : nullptr;
+
+  if (index) {
+    // take the entries from the index and delete them in parallel
+    time_t from = 0;
+    time_t until = 0;
+    bool all = global && !vid.uid;
+    uint64_t nfiles = 0;
+    uint64_t nbulk = 0;
+
+    if (!GetDateRange(date, from, until)) {
+      std_err = "error: the date has to be <year> or <year>/<month> or "
+                "<year>/<month>/<day>";
+      return EINVAL;
+    }
+
+    gOFS->Recycler->ConfigurePurge();
+
+    if (rkey.length()) {
+      RecycleIndex::Entry entry;
+
+      if (index->Get(rkey, entry) && (all || (entry.mUid == vid.uid)) &&
+          (!until || ((entry.mDeletionTime >= from) &&
+                      (entry.mDeletionTime < until)))) {
+        gOFS->Recycler->PurgeEntries({entry}, nfiles, nbulk);
+      }
+    } else {
+      std::string cursor;
+
+      do {
+        std::vector<RecycleIndex::Entry> entries =
+          index->List(all, vid.uid, from, until, cursor, RecycleIndex::cBatchSize);
+        gOFS->Recycler->PurgeEntries(entries, nfiles, nbulk);
+      } while (!cursor.empty());
+    }
+
+    std_out += "success: purged ";
+    std_out += std::to_string(nbulk);
+    std_out += " bulk deletions and ";
+    std_out += std::to_string(nfiles);
+    std_out += " individual files from the recycle bin!";
+
+    if (rkey.length() && !nbulk && !nfiles) {
+      std_err += "error: no entry for key='";
+      std_err += rkey;
+      std_err += "'";
+      return ENODATA;
+    }
+
+    return 0;
+  }
+
   if (!global || (global && vid.uid)) {
     snprintf(sdir, sizeof(sdir) - 1, "%s/uid:%u/%s",
              Recycle::gRecyclingPrefix.c_str(),
@@ -1556,6 +2226,10 @@ Recycle::Purge(std::string& std_out, std::string& std_err,
           } else {
             nfiles_deleted++;
           }
+
+          if (RecycleIndex* index = gOFS->Recycler->GetIndex(false)) {
+            index->Remove(RecycleIndex::GetKeyFromName(fname));
+          }
         }
       }
     }
@@ -25,9 +25,14 @@
 #define __EOSMGM_RECYCLE__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/RecycleIndex.hh"
 #include "common/AssistedThread.hh"
+#include "common/RateLimit.hh"
+#include "common/ThreadPool.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <qclient/QClient.hh>
 #include <sys/types.h>
+#include <mutex>
 
 class XrdOucErrInfo;
 
@@ -62,6 +67,14 @@ private:
   gid_t mOwnerGid;
   unsigned long long mId;
   std::atomic<bool> mWakeUp;
+  std::once_flag mIndexInit; ///< Guards the creation of the index
+  std::unique_ptr<qclient::QClient> mQcl; ///< qclient of the index
+  std::unique_ptr<RecycleIndex> mIndex; ///< Recycle bin index
+  std::atomic<bool> mIndexReady {false}; ///< Index is built and usable
+  std::unique_ptr<eos::common::ThreadPool> mPurgePool; ///< Purge workers
+  eos::common::RequestRateLimit mPurgeRateLimit; ///< Limits purge deletions
+  std::atomic<unsigned int> mPurgeThreads {cDefaultPurgeThreads};
+  std::atomic<unsigned long long> mPurgeRate {0}; ///< Deletions/s, 0 no limit
 
 public:
   //----------------------------------------------------------------------------
@@ -152,6 +165,8 @@ public:
    * @param rvec a vector of maps with all recycle informations requested
    * @param whodeleted - show who exectued a deletion
    * @param maxentries - maximum number of entries to report
+   * @param cursor - position to continue a limited listing from, only used
+   *                 with the recycle bin index
    * @return 0 if success, E2BIG if return list is limited
    */
   static int Print(std::string& std_out, std::string& std_err,
@@ -161,7 +176,8 @@ public:
                     bool global = false,
                     RecycleListing* rvec = 0,
 		    bool whodeleted = true,
-		    int32_t maxentries = 0
+		    int32_t maxentries = 0,
+		    const std::string& cursor = ""
                    );
 
   /**
@@ -222,6 +238,28 @@ public:
                     eos::common::VirtualIdentity& vid,
                     const std::string& key, const std::string& value);
 
+  /**
+   * get the recycle bin index
+   * @param ready if true, return the index only once it has been built
+   * @return index or nullptr if it is not configured (or not yet built)
+   */
+  RecycleIndex* GetIndex(bool ready = true);
+
+  /**
+   * mark the recycle bin index as incomplete, the recycle thread rebuilds it
+   */
+  void InvalidateIndex();
+
+  /**
+   * remove indexed entries from the recycle bin using the purge thread pool,
+   * deletions are limited to the rate configured by gRecyclingPurgeRate
+   * @param entries entries to remove
+   * @param nfiles incremented by the number of removed files
+   * @param nbulk incremented by the number of removed directory trees
+   */
+  void PurgeEntries(const std::vector<RecycleIndex::Entry>& entries,
+                    uint64_t& nfiles, uint64_t& nbulk);
+
   /**
    * set the wake-up flag in the recycle thread to look at modified recycle bin settings
    */
@@ -247,7 +285,57 @@ public:
   gRecyclingPostFix; //<  postfix which identifies a name in the garbage bin as a bulk deletion of a directory
   static std::string
   gRecyclingVersionKey; //<  attribute key storing the recycling key of the version directory belonging to a given file
+  static std::string
+  gRecyclingPurgeThreads; //<  attribute key defining the number of parallel deletions when purging with the index
+  static std::string
+  gRecyclingPurgeRate; //<  attribute key defining the maximum deletions per second when purging with the index
   static int gRecyclingPollTime; //< poll interval inside the garbage bin
+  static constexpr unsigned int cDefaultPurgeThreads {4};
+  static constexpr unsigned int cMaxPurgeThreads {16};
+
+private:
+  /**
+   * create the index objects once
+   * @return index or nullptr if there is no QuarkDB backend
+   */
+  RecycleIndex* InitIndex();
+
+  /**
+   * fill the index from the recycle bin directories and mark it as built
+   * @return true if successful, otherwise false
+   */
+  bool BuildIndex(ThreadAssistant& assistant);
+
+  /**
+   * purge all expired entries using the index
+   * @param keep_time lifetime of entries in the recycle bin
+   * @param check_ratio stop once usage is under the given watermarks
+   * @return time to sleep until the oldest entry expires
+   */
+  time_t ExpireIndexed(ThreadAssistant& assistant, time_t keep_time,
+                       bool check_ratio, unsigned long long low_inodes,
+                       unsigned long long low_space);
+
+  /**
+   * read the purge pipeline settings from the recycle bin attributes
+   */
+  void ConfigurePurge();
+
+  /**
+   * permanently remove a file or directory tree from the recycle bin
+   * @param path path inside the recycle bin
+   * @param is_dir true for a directory tree
+   * @return 0 if removed, ENOENT if it does not exist, otherwise errno
+   */
+  static int RemoveFromBin(const std::string& path, bool is_dir);
+
+  /**
+   * convert a date filter <year> or <year>/<month> or <year>/<month>/<day>
+   * into the range of local times it covers
+   * @return true if successful, otherwise false
+   */
+  static bool GetDateRange(const std::string& date, time_t& from,
+                           time_t& until);
 };
 
 EOSMGMNAMESPACE_END
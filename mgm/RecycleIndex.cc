@@ -0,0 +1,424 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/RecycleIndex.hh"
+#include "common/Logging.hh"
+#include <qclient/QClient.hh>
+#include <qclient/MultiBuilder.hh>
+#include "qclient/structures/QHash.hh"
+#include <algorithm>
+#include <set>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Check the reply of a MULTI block
+//------------------------------------------------------------------------------
+bool IsMultiOk(const qclient::redisReplyPtr& reply)
+{
+  if (!reply || (reply->type != REDIS_REPLY_ARRAY)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < reply->elements; ++i) {
+    if (reply->element[i]->type == REDIS_REPLY_ERROR) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the deletion time encoded in a time ordered hash field
+//------------------------------------------------------------------------------
+time_t GetFieldTime(const std::string& field)
+{
+  return strtoll(field.c_str(), nullptr, 10);
+}
+
+//------------------------------------------------------------------------------
+// Get the restore key encoded in a time ordered hash field
+//------------------------------------------------------------------------------
+std::string GetFieldKey(const std::string& field)
+{
+  size_t pos = field.find(':');
+  return (pos == std::string::npos) ? "" : field.substr(pos + 1);
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RecycleIndex::RecycleIndex(qclient::QClient& qcl, const std::string& prefix):
+  mQcl(qcl), mEntriesKey(prefix + "-entries"), mTimeKey(prefix + "-time"),
+  mUidKeyPrefix(prefix + "-uid:"), mMetaKey(prefix + "-meta")
+{}
+
+//------------------------------------------------------------------------------
+// Add an entry
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Add(const Entry& entry)
+{
+  try {
+    const std::string field = GetTimeField(entry.mDeletionTime, entry.mKey);
+    qclient::MultiBuilder multi;
+    multi.emplace_back("HSET", mEntriesKey, entry.mKey, Serialize(entry));
+    multi.emplace_back("HSET", mTimeKey, field, "");
+    multi.emplace_back("HSET", GetUidKey(entry.mUid), field, "");
+
+    if (IsMultiOk(mQcl.follyExecute(multi.getDeque()).get())) {
+      return true;
+    }
+
+    eos_static_err("msg=\"failed to add recycle index entry\" key=%s",
+                   entry.mKey.c_str());
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to add recycle index entry\" key=%s "
+                    "emsg=\"%s\"", entry.mKey.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get an entry by its restore key
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Get(const std::string& key, Entry& entry)
+{
+  try {
+    qclient::redisReplyPtr reply = mQcl.exec("HGET", mEntriesKey, key).get();
+
+    if (reply && (reply->type == REDIS_REPLY_STRING) &&
+        Deserialize(std::string(reply->str, reply->len), entry)) {
+      entry.mKey = key;
+      return true;
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to get recycle index entry\" key=%s "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Remove an entry
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Remove(const std::string& key)
+{
+  Entry entry;
+
+  if (!Get(key, entry)) {
+    return true;
+  }
+
+  try {
+    const std::string field = GetTimeField(entry.mDeletionTime, entry.mKey);
+    qclient::MultiBuilder multi;
+    multi.emplace_back("HDEL", mEntriesKey, entry.mKey);
+    multi.emplace_back("HDEL", mTimeKey, field);
+    multi.emplace_back("HDEL", GetUidKey(entry.mUid), field);
+
+    if (IsMultiOk(mQcl.follyExecute(multi.getDeque()).get())) {
+      return true;
+    }
+
+    eos_static_err("msg=\"failed to remove recycle index entry\" key=%s",
+                   key.c_str());
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to remove recycle index entry\" key=%s "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// List entries ordered by deletion time
+//------------------------------------------------------------------------------
+std::vector<RecycleIndex::Entry>
+RecycleIndex::List(bool all, uid_t uid, time_t from, time_t until,
+                   std::string& cursor, size_t max)
+{
+  std::vector<Entry> entries;
+  std::vector<std::string> keys;
+  const std::string hash = all ? mTimeKey : GetUidKey(uid);
+  // QuarkDB scan cursors are of the form "next:<field>", so a scan can be
+  // started at any position of the ordered fields
+  std::string scan = "next:" + (cursor.empty() ? GetTimeField(from, "") :
+                                cursor);
+  cursor.clear();
+
+  try {
+    while (true) {
+      size_t count = max ? std::min(cBatchSize, max - keys.size() + 1) :
+                     cBatchSize;
+      qclient::redisReplyPtr reply = mQcl.exec("HSCAN", hash, scan, "COUNT",
+                                     std::to_string(count)).get();
+
+      if (!reply || (reply->type != REDIS_REPLY_ARRAY) ||
+          (reply->elements != 2) ||
+          (reply->element[0]->type != REDIS_REPLY_STRING) ||
+          (reply->element[1]->type != REDIS_REPLY_ARRAY)) {
+        eos_static_err("msg=\"unexpected reply when listing recycle index\" "
+                       "reply=\"%s\"", qclient::describeRedisReply(reply).c_str());
+        break;
+      }
+
+      scan = std::string(reply->element[0]->str, reply->element[0]->len);
+      bool done = (scan == "0");
+
+      for (size_t i = 0; i + 1 < reply->element[1]->elements; i += 2) {
+        redisReply* elem = reply->element[1]->element[i];
+        std::string field(elem->str, elem->len);
+
+        if (until && (GetFieldTime(field) >= until)) {
+          done = true;
+          break;
+        }
+
+        if (max && (keys.size() == max)) {
+          cursor = field;
+          done = true;
+          break;
+        }
+
+        keys.push_back(GetFieldKey(field));
+      }
+
+      if (done) {
+        break;
+      }
+    }
+
+    // Fetch the entries with pipelined requests
+    for (size_t pos = 0; pos < keys.size(); pos += cBatchSize) {
+      std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+      size_t end = std::min(keys.size(), pos + cBatchSize);
+
+      for (size_t i = pos; i < end; ++i) {
+        replies.emplace_back(mQcl.exec("HGET", mEntriesKey, keys[i]));
+      }
+
+      for (size_t i = pos; i < end; ++i) {
+        qclient::redisReplyPtr reply = std::move(replies[i - pos]).get();
+        Entry entry;
+
+        // Entries removed in the meantime are skipped
+        if (reply && (reply->type == REDIS_REPLY_STRING) &&
+            Deserialize(std::string(reply->str, reply->len), entry)) {
+          entry.mKey = keys[i];
+          entries.push_back(std::move(entry));
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to list recycle index\" emsg=\"%s\"",
+                    e.what());
+    cursor.clear();
+  }
+
+  return entries;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of indexed entries
+//------------------------------------------------------------------------------
+uint64_t
+RecycleIndex::Count()
+{
+  try {
+    qclient::redisReplyPtr reply = mQcl.exec("HLEN", mEntriesKey).get();
+
+    if (reply && (reply->type == REDIS_REPLY_INTEGER)) {
+      return reply->integer;
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to count recycle index entries\" "
+                    "emsg=\"%s\"", e.what());
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Check if the index has been built
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::IsBuilt()
+{
+  try {
+    qclient::redisReplyPtr reply = mQcl.exec("HEXISTS", mMetaKey,
+                                   "built").get();
+    return (reply && (reply->type == REDIS_REPLY_INTEGER) &&
+            (reply->integer == 1));
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to query recycle index state\" "
+                    "emsg=\"%s\"", e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Mark the index as built or not built
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::SetBuilt(bool built)
+{
+  try {
+    qclient::redisReplyPtr reply = built ?
+                                   mQcl.exec("HSET", mMetaKey, "built",
+                                       std::to_string(time(nullptr))).get() :
+                                   mQcl.exec("HDEL", mMetaKey, "built").get();
+    return (reply && (reply->type == REDIS_REPLY_INTEGER));
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to update recycle index state\" "
+                    "emsg=\"%s\"", e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Drop all entries of the index
+//------------------------------------------------------------------------------
+void
+RecycleIndex::Clear()
+{
+  try {
+    std::set<uid_t> uids;
+    qclient::QHash entries(mQcl, mEntriesKey);
+
+    for (auto it = entries.getIterator(cBatchSize, "0"); it.valid(); it.next()) {
+      Entry entry;
+
+      if (Deserialize(it.getValue(), entry)) {
+        uids.insert(entry.mUid);
+      }
+    }
+
+    qclient::MultiBuilder multi;
+
+    for (const auto& key : {
+           mEntriesKey, mTimeKey, mMetaKey
+         }) {
+      multi.emplace_back("DEL", key);
+    }
+
+    for (auto uid : uids) {
+      multi.emplace_back("DEL", GetUidKey(uid));
+    }
+
+    mQcl.follyExecute(multi.getDeque()).get();
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to clear recycle index\" emsg=\"%s\"",
+                    e.what());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Build the restore key of a recycle bin entry
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::GetKey(unsigned long long id, bool is_dir)
+{
+  char skey[64];
+  snprintf(skey, sizeof(skey), "%s:%016llx", is_dir ? "pxid" : "fxid", id);
+  return skey;
+}
+
+//------------------------------------------------------------------------------
+// Extract the restore key from the name of a recycle bin entry
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::GetKeyFromName(const std::string& name)
+{
+  std::string base = name;
+  bool is_dir = false;
+
+  if ((base.length() > 2) && (base.compare(base.length() - 2, 2, ".d") == 0)) {
+    base.erase(base.length() - 2);
+    is_dir = true;
+  }
+
+  if ((base.length() < 18) || (base[base.length() - 17] != '.')) {
+    return "";
+  }
+
+  std::string hex = base.substr(base.length() - 16);
+
+  if (hex.find_first_not_of("0123456789abcdef") != std::string::npos) {
+    return "";
+  }
+
+  return GetKey(strtoull(hex.c_str(), nullptr, 16), is_dir);
+}
+
+//------------------------------------------------------------------------------
+// Get the field of an entry in the time ordered hashes
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::GetTimeField(time_t deletion_time, const std::string& key)
+{
+  char stime[32];
+  snprintf(stime, sizeof(stime), "%010lld", (long long) deletion_time);
+  return std::string(stime) + ":" + key;
+}
+
+//------------------------------------------------------------------------------
+// Serialize an entry
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::Serialize(const Entry& entry)
+{
+  return std::to_string(entry.mUid) + " " + std::to_string(entry.mGid) + " " +
+         std::to_string(entry.mSize) + " " +
+         std::to_string((long long) entry.mDeletionTime) + " " + entry.mPath;
+}
+
+//------------------------------------------------------------------------------
+// Parse a serialized entry
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Deserialize(const std::string& data, Entry& entry)
+{
+  unsigned long long uid, gid, size;
+  long long dtime;
+  int pos = 0;
+
+  if ((sscanf(data.c_str(), "%llu %llu %llu %lld %n", &uid, &gid, &size,
+              &dtime, &pos) != 4) || !pos || ((size_t) pos >= data.length())) {
+    return false;
+  }
+
+  entry.mUid = uid;
+  entry.mGid = gid;
+  entry.mSize = size;
+  entry.mDeletionTime = dtime;
+  entry.mPath = data.substr(pos);
+  return true;
+}
+
+EOSMGMNAMESPACE_END
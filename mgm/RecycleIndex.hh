@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------
+//! @file RecycleIndex.hh
+//! @brief Index of the recycle bin entries kept in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <sys/types.h>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Index of the recycle bin entries stored in QuarkDB, maintained when an
+//! entry is moved to the recycle bin. It is made of:
+//!
+//!   <prefix>-entries     hash restore key -> serialized entry
+//!   <prefix>-time        hash "<deletion time>:<restore key>" -> ""
+//!   <prefix>-uid:<uid>   hash "<deletion time>:<restore key>" -> ""
+//!   <prefix>-meta        hash holding the "built" marker
+//!
+//! The deletion time in the fields of the time ordered hashes is zero padded,
+//! so that a hash scan returns them oldest first and a scan can start at any
+//! given time. The index only becomes authoritative once it has been built
+//! from the recycle bin directories, until then the callers fall back to the
+//! directory tree walk.
+//------------------------------------------------------------------------------
+class RecycleIndex
+{
+public:
+  //! Indexed recycle bin entry
+  struct Entry {
+    std::string mKey; ///< Restore key, fxid:<hex> or pxid:<hex>
+    std::string mPath; ///< Path of the entry inside the recycle bin
+    uid_t mUid = 0;
+    gid_t mGid = 0;
+    uint64_t mSize = 0;
+    time_t mDeletionTime = 0;
+
+    //--------------------------------------------------------------------------
+    //! Check if the entry is a recursively deleted directory
+    //--------------------------------------------------------------------------
+    bool IsDirectory() const
+    {
+      return (mKey.find("pxid:") == 0);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl qclient object, must outlive the index
+  //! @param prefix prefix of all QuarkDB keys of the index
+  //----------------------------------------------------------------------------
+  RecycleIndex(qclient::QClient& qcl, const std::string& prefix = "eos-recycle");
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~RecycleIndex() = default;
+
+  //----------------------------------------------------------------------------
+  //! Add an entry
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Add(const Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Get an entry by its restore key
+  //!
+  //! @return true if the entry exists, otherwise false
+  //----------------------------------------------------------------------------
+  bool Get(const std::string& key, Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Remove an entry, does nothing if the entry does not exist
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Remove(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! List entries ordered by deletion time
+  //!
+  //! @param all list the entries of all users, otherwise only the ones of uid
+  //! @param uid owner of the entries to list
+  //! @param from list entries deleted at or after this time
+  //! @param until list entries deleted before this time, 0 means no limit
+  //! @param cursor position to continue listing from, empty to start at from.
+  //!        It is set to the position of the next entry or to an empty string
+  //!        if there are no more entries.
+  //! @param max maximum number of entries to return, 0 means no limit
+  //!
+  //! @return listed entries
+  //----------------------------------------------------------------------------
+  std::vector<Entry> List(bool all, uid_t uid, time_t from, time_t until,
+                          std::string& cursor, size_t max);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of indexed entries
+  //----------------------------------------------------------------------------
+  uint64_t Count();
+
+  //----------------------------------------------------------------------------
+  //! Check if the index has been built from the recycle bin directories
+  //----------------------------------------------------------------------------
+  bool IsBuilt();
+
+  //----------------------------------------------------------------------------
+  //! Mark the index as built or not built
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool SetBuilt(bool built);
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries of the index
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Build the restore key of a recycle bin entry
+  //!
+  //! @param id file or container id
+  //! @param is_dir true for a recursively deleted directory
+  //----------------------------------------------------------------------------
+  static std::string GetKey(unsigned long long id, bool is_dir);
+
+  //----------------------------------------------------------------------------
+  //! Extract the restore key from the name of a recycle bin entry i.e.
+  //! <contracted path>.<016x id>[.d]
+  //!
+  //! @return restore key or empty string if the name is not a recycle entry
+  //----------------------------------------------------------------------------
+  static std::string GetKeyFromName(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Get the field of an entry in the time ordered hashes
+  //----------------------------------------------------------------------------
+  static std::string GetTimeField(time_t deletion_time, const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Serialize an entry as "<uid> <gid> <size> <deletion time> <path>"
+  //----------------------------------------------------------------------------
+  static std::string Serialize(const Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Parse a serialized entry, the key is not part of the serialization
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Deserialize(const std::string& data, Entry& entry);
+
+  //! Number of requests pipelined in one batch
+  static constexpr size_t cBatchSize {1000};
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get the key of the time ordered hash of a user
+  //----------------------------------------------------------------------------
+  std::string GetUidKey(uid_t uid) const
+  {
+    return mUidKeyPrefix + std::to_string(uid);
+  }
+
+  qclient::QClient& mQcl; ///< QClient object
+  const std::string mEntriesKey; ///< Hash of entries
+  const std::string mTimeKey; ///< Time ordered hash of all entries
+  const std::string mUidKeyPrefix; ///< Prefix of the per user time hashes
+  const std::string mMetaKey; ///< Hash holding the built marker
+};
+
+EOSMGMNAMESPACE_END
@@ -42,6 +42,7 @@
 #include "namespace/Prefetcher.hh"
 #include "namespace/utils/Checksum.hh"
 #include "Xrd/XrdScheduler.hh"
+#include <qclient/QClient.hh>
 
 #define EOS_WFE_BASH_PREFIX "/var/eos/wfe/bash/"
 
@@ -99,6 +100,23 @@ WFE::Stop()
   mThread.join();
 }
 
+//------------------------------------------------------------------------------
+// Get the QuarkDB job queue, created on first use once the configuration
+// is known
+//------------------------------------------------------------------------------
+WFEQueue*
+WFE::GetQueue()
+{
+  std::call_once(mQueueInit, [this]() {
+    if (gOFS->mWfeQdbQueue) {
+      mQcl = std::make_unique<qclient::QClient>(gOFS->mQdbContactDetails.members,
+             gOFS->mQdbContactDetails.constructOptions());
+      mQueue = std::make_unique<WFEQueue>(*mQcl);
+    }
+  });
+  return mQueue.get();
+}
+
 //------------------------------------------------------------------------------
 // @brief WFE method doing the actual workflow
 //
@@ -127,6 +145,8 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
     time_t lStartTime = time(NULL);
     time_t lStopTime;
     time_t lKeepTime = 7 * 86400;
+    time_t lLeaseTime = 3600;
+    bool dispatched = false;
     std::map<std::string, std::set<std::string> > wfedirs;
     XrdOucString stdErr;
     {
@@ -150,14 +170,28 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
         if (!lKeepTime) {
           lKeepTime = 7 * 86400;
         }
+
+        lLeaseTime = atoi(
+                       FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe.lease").c_str());
+
+        if (lLeaseTime <= 0) {
+          lLeaseTime = 3600;
+        }
       } else {
         lWFEInterval = 0;
         lWFEntx = 0;
       }
     }
 
+    WFEQueue* queue = GetQueue();
+
     // Only a master needs to run WFE
-    if (gOFS->mMaster->IsMaster() && IsEnabledWFE) {
+    if (queue && gOFS->mMaster->IsMaster() && IsEnabledWFE) {
+      // Take jobs from the QuarkDB job queue for a full interval
+      Dispatch(assistant, lWFEntx, lLeaseTime,
+               lStartTime + std::max<time_t>(lWFEInterval, 1));
+      dispatched = true;
+    } else if (gOFS->mMaster->IsMaster() && IsEnabledWFE) {
       eos_static_debug("msg=\"start WFE scan\"");
       // Find all directories defining an WFE policy
       gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
@@ -271,6 +305,10 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
       snoozetime = lWFEInterval - (lStopTime - lStartTime);
     }
 
+    if (dispatched) {
+      snoozetime = 0;
+    }
+
     if (!IsEnabledWFE) {
       snoozetime = 6000;
     }
@@ -304,6 +342,12 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
         (!cleanuptime || (cleanuptime < time(NULL)))) {
       time_t now = time(NULL);
       eos_static_info("msg=\"clean old workflows\"");
+
+      if (queue) {
+        size_t expired = queue->Expire(now, lKeepTime);
+        eos_static_info("msg=\"cleaned workflow job queue\" expired=%lu", expired);
+      }
+
       XrdMgmOfsDirectory dir;
 
       if (dir.open(gOFS->MgmProcWorkflowPath.c_str(), mRootVid, "") != SFS_OK) {
@@ -351,6 +395,159 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
   }
 }
 
+//------------------------------------------------------------------------------
+// Run due jobs of the QuarkDB job queue until the deadline
+//------------------------------------------------------------------------------
+void
+WFE::Dispatch(ThreadAssistant& assistant, size_t ntx, time_t lease,
+              time_t deadline)
+{
+  WFEQueue* queue = GetQueue();
+  time_t now = time(nullptr);
+  size_t promoted = queue->Promote(now);
+  size_t recovered = queue->RecoverExpired(now);
+  eos_static_debug("msg=\"start WFE dispatch\" promoted=%lu recovered=%lu",
+                   promoted, recovered);
+
+  while (!assistant.terminationRequested() && gOFS->mMaster->IsMaster() &&
+         (time(nullptr) < deadline)) {
+    size_t batch = WFEQueue::cBatchSize;
+
+    // stop dequeuing if there are too many jobs running
+    if (ntx) {
+      size_t active = GetActiveJobs();
+
+      if (active >= ntx) {
+        mDoneSignal.WaitMS(100);
+        continue;
+      }
+
+      batch = std::min(batch, ntx - active);
+    }
+
+    EXEC_TIMING_BEGIN("WFEDequeue");
+    now = time(nullptr);
+    std::vector<WFEQueue::Entry> entries = queue->Dequeue(batch, now, lease);
+    gOFS->MgmStats.Add("WFEDequeue", 0, 0, entries.size());
+    EXEC_TIMING_END("WFEDequeue");
+
+    for (const auto& entry : entries) {
+      Job* job = new Job();
+
+      if (job->Load(entry) || job->IsSync()) {
+        eos_static_err("msg=\"cannot load workflow job\" id=%s",
+                       entry.mId.c_str());
+        std::string id = entry.mId;
+        queue->Store(id, entry.mRecord, "f", now);
+        delete job;
+        continue;
+      }
+
+      // use the shared scheduler for asynchronous jobs
+      XrdSysMutexHelper sLock(gSchedulerMutex);
+      IncActiveJobs();
+      gScheduler->Schedule((XrdJob*) job);
+      eos_static_info("msg=\"scheduled workflow\" job=\"%s\" id=%s",
+                      job->mDescription.c_str(), entry.mId.c_str());
+    }
+
+    if (entries.size() < batch) {
+      // queue drained, wait for new or due jobs
+      assistant.wait_for(std::chrono::milliseconds(100));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move queued jobs stored in the proc workflow directory into the QuarkDB
+// job queue - only today's and yesterday's queues are looked at by the
+// directory based engine, so only those are migrated
+//------------------------------------------------------------------------------
+void
+WFE::MigrateDirectoryQueue()
+{
+  std::map<std::string, std::set<std::string>> wfedirs;
+  XrdOucErrInfo errInfo;
+  XrdOucString stdErr;
+  time_t when = time(nullptr);
+
+  for (int i = 0; i < 2; ++i, when -= (24 * 3600)) {
+    std::string day = eos::common::Timing::UnixTimestamp_to_Day(when);
+
+    for (const char* q : {
+           "q", "e", "r"
+         }) {
+      std::string query = gOFS->MgmProcWorkflowPath.c_str();
+      query += "/";
+      query += day;
+      query += "/";
+      query += q;
+      query += "/";
+      gOFS->_find(query.c_str(), errInfo, stdErr, mRootVid, wfedirs, nullptr,
+                  nullptr, false, 0, false, 0);
+    }
+  }
+
+  size_t migrated = 0;
+
+  for (const auto& wfedir : wfedirs) {
+    for (const auto& entry : wfedir.second) {
+      std::string path = wfedir.first + entry;
+      Job job;
+
+      if (job.Load(path)) {
+        eos_static_err("msg=\"cannot load workflow entry for migration\" "
+                       "value=\"%s\"", path.c_str());
+        continue;
+      }
+
+      if (job.IsSync()) {
+        continue;
+      }
+
+      // running jobs did not survive the master change
+      std::string queue = (job.mActions[0].mQueue == "e") ? "e" : "q";
+      time_t jobtime = job.mActions[0].mTime;
+
+      if (job.Save(queue, jobtime, 0, job.mRetry)) {
+        eos_static_err("msg=\"failed to migrate workflow entry\" value=\"%s\"",
+                       path.c_str());
+        continue;
+      }
+
+      if (gOFS->_rem(path.c_str(), errInfo, mRootVid, "", false, false, true)) {
+        eos_static_err("msg=\"failed to remove migrated workflow entry\" "
+                       "value=\"%s\"", path.c_str());
+      }
+
+      ++migrated;
+    }
+  }
+
+  if (migrated) {
+    eos_static_info("msg=\"migrated workflow entries into job queue\" "
+                    "count=%lu", migrated);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the record of the job for the QuarkDB job queue
+//------------------------------------------------------------------------------
+WFEQueue::Record
+WFE::Job::GetRecord(int action, int retry)
+{
+  WFEQueue::Record record;
+  record["action"] = mActions[action].mAction;
+  record["event"] = mActions[action].mEvent;
+  record["workflow"] = mActions[action].mWorkflow;
+  record["day"] = mActions[action].mDay;
+  record["fxid"] = eos::common::FileId::Fid2Hex(mFid);
+  record["vid"] = eos::common::Mapping::VidToString(mVid);
+  record["retry"] = std::to_string(retry);
+  record["errmsg"] = mErrorMesssage;
+  return record;
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief store a workflow jobs in the workflow queue
@@ -364,6 +561,21 @@ WFE::Job::Save(std::string queue, time_t& when, int action, int retry)
     return -1;
   }
 
+  if (WFEQueue* wfeQueue = gOFS->WFEd.GetQueue()) {
+    if (!when) {
+      when = time(nullptr);
+    }
+
+    mActions[action].mSavedOnDay = mActions[action].mDay;
+
+    if (!wfeQueue->Store(mQueueId, GetRecord(action, retry), queue, when)) {
+      return -1;
+    }
+
+    mWorkflowPath = mQueueId;
+    return SFS_OK;
+  }
+
   std::string workflowdir = gOFS->MgmProcWorkflowPath.c_str();
   workflowdir += "/";
   workflowdir += mActions[action].mDay;
@@ -534,6 +746,41 @@ WFE::Job::Load(std::string path2entry)
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Load a workflow job dequeued from the QuarkDB job queue
+//------------------------------------------------------------------------------
+int
+WFE::Job::Load(const WFEQueue::Entry& entry)
+{
+  auto field = [&entry](const std::string & name) -> std::string {
+    auto it = entry.mRecord.find(name);
+    return (it == entry.mRecord.end()) ? "" : it->second;
+  };
+
+  mQueueId = entry.mId;
+  mWorkflowPath = entry.mId;
+
+  if (field("action").empty() || field("event").empty()) {
+    eos_static_err("msg=\"illegal workflow job\" id=%s", entry.mId.c_str());
+    return SFS_ERROR;
+  }
+
+  mFid = eos::common::FileId::Hex2Fid(field("fxid").c_str());
+  time_t t_when = strtoull(field("when").c_str(), 0, 10);
+  AddAction(field("action"), field("event"), t_when, field("day"),
+            field("workflow"), field("queue"));
+  std::string vidstring = field("vid");
+
+  if (!eos::common::Mapping::VidFromString(mVid, vidstring.c_str())) {
+    eos_static_crit("parsing of %s failed - setting nobody\n", vidstring.c_str());
+    mVid = eos::common::VirtualIdentity::Nobody();
+  }
+
+  mRetry = (int)strtoul(field("retry").c_str(), nullptr, 10);
+  mErrorMesssage = field("errmsg");
+  return SFS_OK;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 WFE::Job::Move(std::string from_queue, std::string to_queue, time_t& when,
@@ -550,7 +797,9 @@ WFE::Job::Move(std::string from_queue, std::string to_queue, time_t& when,
   if (Save(to_queue, when, 0, retry) == SFS_OK) {
     mActions[0].mQueue = to_queue;
 
-    if ((from_queue != to_queue) && (Delete(from_queue, fromDay) == SFS_ERROR)) {
+    // the QuarkDB job queue moves the job record in place
+    if ((from_queue != to_queue) && !gOFS->WFEd.GetQueue() &&
+        (Delete(from_queue, fromDay) == SFS_ERROR)) {
       eos_static_err("msg=\"failed to remove for move from queue=\"%s\" to queue=\"%s\"",
                      from_queue.c_str(), to_queue.c_str());
     }
@@ -569,6 +818,18 @@ int
 WFE::Job::Results(std::string queue, int retc, XrdOucString log, time_t when)
 /*----------------------------------------------------------------------------*/
 {
+  if (WFEQueue* wfeQueue = gOFS->WFEd.GetQueue()) {
+    WFEQueue::Record fields {{"retc", std::to_string(retc)}, {"log", log.c_str()}};
+
+    if (!wfeQueue->SetFields(mQueueId, fields)) {
+      eos_static_err("msg=\"failed to store workflow results\" id=%s",
+                     mQueueId.c_str());
+      return -1;
+    }
+
+    return SFS_OK;
+  }
+
   std::string workflowdir = gOFS->MgmProcWorkflowPath.c_str();
   workflowdir += "/";
   workflowdir += mActions[0].mDay;
@@ -651,6 +912,10 @@ WFE::Job::Delete(std::string queue, std::string fromDay)
     return SFS_ERROR;
   }
 
+  if (WFEQueue* wfeQueue = gOFS->WFEd.GetQueue()) {
+    return wfeQueue->Remove(mQueueId) ? SFS_OK : SFS_ERROR;
+  }
+
   std::string workflowdir = gOFS->MgmProcWorkflowPath.c_str();
   workflowdir += "/";
   // We have to remove from the day when it was saved
@@ -1496,22 +1761,36 @@ WFE::Job::DoIt(bool issync, std::string& errorMsg, const char* const ininfo)
                     value.assign(outerr.c_str(), xend + 1, std::string::npos);
                   }
 
-                  eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, mWorkflowPath);
-                  eos::common::RWMutexWriteLock nsLock(gOFS->eosViewRWMutex);
-
-                  try {
-                    fmd = gOFS->eosView->getFile(mWorkflowPath);
+                  if (WFEQueue* wfeQueue = gOFS->WFEd.GetQueue()) {
+                    // the job record takes the place of the vpath entry
                     base64 = value.c_str();
                     eos::common::SymKey::DeBase64(base64, unbase64);
-                    fmd->setAttribute(key, unbase64.c_str());
-                    fmd->setMTimeNow();
-                    gOFS->eosView->updateFileStore(fmd.get());
-                    errno = 0;
-                    eos_static_info("msg=\"stored extended attribute on vpath\" vpath=%s key=%s value=%s",
-                                    mWorkflowPath.c_str(), key.c_str(), value.c_str());
-                  } catch (eos::MDException& e) {
-                    eos_static_err("msg=\"failed set extended attribute\" key=%s value=%s",
-                                   key.c_str(), value.c_str());
+
+                    if (wfeQueue->SetFields(mQueueId, {{"xattr." + key, unbase64.c_str()}})) {
+                      eos_static_info("msg=\"stored extended attribute on job\" id=%s key=%s value=%s",
+                                      mQueueId.c_str(), key.c_str(), value.c_str());
+                    } else {
+                      eos_static_err("msg=\"failed set extended attribute\" key=%s value=%s",
+                                     key.c_str(), value.c_str());
+                    }
+                  } else {
+                    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, mWorkflowPath);
+                    eos::common::RWMutexWriteLock nsLock(gOFS->eosViewRWMutex);
+
+                    try {
+                      fmd = gOFS->eosView->getFile(mWorkflowPath);
+                      base64 = value.c_str();
+                      eos::common::SymKey::DeBase64(base64, unbase64);
+                      fmd->setAttribute(key, unbase64.c_str());
+                      fmd->setMTimeNow();
+                      gOFS->eosView->updateFileStore(fmd.get());
+                      errno = 0;
+                      eos_static_info("msg=\"stored extended attribute on vpath\" vpath=%s key=%s value=%s",
+                                      mWorkflowPath.c_str(), key.c_str(), value.c_str());
+                    } catch (eos::MDException& e) {
+                      eos_static_err("msg=\"failed set extended attribute\" key=%s value=%s",
+                                       key.c_str(), value.c_str());
+                    }
                   }
                 }
 
@@ -3041,6 +3320,13 @@ WFE::CollectAttributes(const std::string& fullPath)
 void
 WFE::MoveFromRBackToQ()
 {
+  if (WFEQueue* queue = gOFS->WFEd.GetQueue()) {
+    size_t queued = queue->Reset(time(nullptr));
+    eos_static_info("msg=\"reset workflow job queue\" queued=%lu", queued);
+    gOFS->WFEd.MigrateDirectoryQueue();
+    return;
+  }
+
   std::string queries[2];
 
   for (auto& query : queries) {
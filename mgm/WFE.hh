@@ -25,6 +25,7 @@
 #define __EOSMGM_WFE__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/WFEQueue.hh"
 #include "common/Mapping.hh"
 #include "common/Timing.hh"
 #include "common/FileId.hh"
@@ -36,10 +37,16 @@
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include "Xrd/XrdJob.hh"
 #include <sys/types.h>
+#include <mutex>
 
 //! Forward declaration
 class XrdScheduler;
 
+namespace qclient
+{
+class QClient;
+}
+
 EOSMGMNAMESPACE_BEGIN
 
 /**
@@ -67,6 +74,26 @@ private:
   /// condition variable to get signalled for a done job
   XrdSysCondVar mDoneSignal;
 
+  std::once_flag mQueueInit; ///< guards the creation of the job queue
+  std::unique_ptr<qclient::QClient> mQcl; ///< qclient of the job queue
+  std::unique_ptr<WFEQueue> mQueue; ///< QuarkDB job queue if configured
+
+  /**
+   * @brief run due jobs of the QuarkDB job queue until the deadline
+   * @param assistant thread assistant of the WFE thread
+   * @param ntx maximum number of active jobs, 0 for no limit
+   * @param lease visibility timeout of dequeued jobs
+   * @param deadline time when to return
+   */
+  void Dispatch(ThreadAssistant& assistant, size_t ntx, time_t lease,
+                time_t deadline);
+
+  /**
+   * @brief move queued jobs stored in the proc workflow directory into the
+   * QuarkDB job queue
+   */
+  void MigrateDirectoryQueue();
+
 public:
 
   /* Default Constructor - use it to run the WFE thread by calling Start
@@ -103,6 +130,12 @@ public:
    */
   void WFEr(ThreadAssistant& assistant) noexcept;
 
+  /**
+   * @brief get the QuarkDB job queue
+   * @return job queue or nullptr if jobs are kept in the proc directory
+   */
+  WFEQueue* GetQueue();
+
   /**
    * @brief Destructor
    *
@@ -176,6 +209,7 @@ public:
       mDescription = other.mDescription;
       mRetry = other.mRetry;
       mErrorMesssage = other.mErrorMesssage;
+      mQueueId = other.mQueueId;
     }
     // ---------------------------------------------------------------------------
     // Job execution function
@@ -292,6 +326,8 @@ public:
 
     int Load(std::string path2entry);
 
+    int Load(const WFEQueue::Entry& entry);
+
     int Move(std::string from_queue, std::string to_queue, time_t& when,
              int retry = 0);
 
@@ -350,8 +386,14 @@ public:
     std::string mWorkflowPath;
     std::string mErrorMesssage;
     int mRetry;///! number of retries
+    std::string mQueueId; ///! job id in the QuarkDB job queue
 
   private:
+    //! @brief get the record of the job for the QuarkDB job queue
+    //! @param action index of the action to store
+    //! @param retry number of retries
+    WFEQueue::Record GetRecord(int action, int retry);
+
     //! @brief moving proto wf event jobs to retry queue
     //! @param filePath the path of the file concerned
     void MoveToRetry(const std::string& filePath);
@@ -0,0 +1,718 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/WFEQueue.hh"
+#include "common/Logging.hh"
+#include <qclient/QClient.hh>
+#include <qclient/MultiBuilder.hh>
+#include "qclient/structures/QHash.hh"
+#include <algorithm>
+#include <set>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Check the reply of a MULTI block
+//------------------------------------------------------------------------------
+bool IsMultiOk(const qclient::redisReplyPtr& reply)
+{
+  if (!reply || (reply->type != REDIS_REPLY_ARRAY)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < reply->elements; ++i) {
+    if (reply->element[i]->type == REDIS_REPLY_ERROR) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get a record field as time value
+//------------------------------------------------------------------------------
+time_t GetTime(const WFEQueue::Record& record, const std::string& field)
+{
+  auto it = record.find(field);
+  return (it == record.end()) ? 0 : strtoll(it->second.c_str(), nullptr, 10);
+}
+
+//------------------------------------------------------------------------------
+// Get a record field
+//------------------------------------------------------------------------------
+std::string GetField(const WFEQueue::Record& record, const std::string& field)
+{
+  auto it = record.find(field);
+  return (it == record.end()) ? "" : it->second;
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+WFEQueue::WFEQueue(qclient::QClient& qcl, const std::string& prefix):
+  mQcl(qcl), mJobsKey(prefix + "-jobs"), mReadyKey(prefix + "-ready"),
+  mDelayedKey(prefix + "-delayed"), mLeasesKey(prefix + "-leases"),
+  mDoneKey(prefix + "-done"), mMetaKey(prefix + "-meta")
+{}
+
+//------------------------------------------------------------------------------
+// Store a job in the given queue
+//------------------------------------------------------------------------------
+bool
+WFEQueue::Store(std::string& id, Record record, const std::string& queue,
+                time_t when)
+{
+  try {
+    if (id.empty()) {
+      qclient::redisReplyPtr reply = mQcl.exec("HINCRBY", mMetaKey, "seq",
+                                     "1").get();
+
+      if (!reply || (reply->type != REDIS_REPLY_INTEGER)) {
+        eos_static_err("%s", "msg=\"failed to allocate workflow job id\"");
+        return false;
+      }
+
+      id = std::to_string(reply->integer);
+    }
+
+    const time_t now = time(nullptr);
+    record["queue"] = queue;
+    record["when"] = std::to_string(when);
+    qclient::MultiBuilder multi;
+    multi.emplace_back("HSET", mJobsKey, id, Serialize(record));
+
+    if (IsQueued(queue)) {
+      multi.emplace_back("HDEL", mLeasesKey, id);
+      multi.emplace_back("deque-push-back",
+                         (when <= now) ? mReadyKey : mDelayedKey, id);
+    } else if (queue != "r") {
+      multi.emplace_back("HDEL", mLeasesKey, id);
+      multi.emplace_back("deque-push-back", mDoneKey,
+                         std::to_string(now) + ":" + id);
+    }
+
+    if (!IsMultiOk(mQcl.follyExecute(multi.getDeque()).get())) {
+      eos_static_err("msg=\"failed to store workflow job\" id=%s queue=%s",
+                     id.c_str(), queue.c_str());
+      return false;
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to store workflow job\" id=%s emsg=\"%s\"",
+                    id.c_str(), e.what());
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the record of a job
+//------------------------------------------------------------------------------
+bool
+WFEQueue::Get(const std::string& id, Record& record)
+{
+  try {
+    record = std::move(GetRecords({id})[0]);
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to get workflow job\" id=%s emsg=\"%s\"",
+                    id.c_str(), e.what());
+    record.clear();
+  }
+
+  return !record.empty();
+}
+
+//------------------------------------------------------------------------------
+// Add or overwrite fields of a job record
+//------------------------------------------------------------------------------
+bool
+WFEQueue::SetFields(const std::string& id, const Record& fields)
+{
+  Record record;
+
+  if (!Get(id, record)) {
+    return false;
+  }
+
+  for (const auto& elem : fields) {
+    record[elem.first] = elem.second;
+  }
+
+  try {
+    qclient::redisReplyPtr reply = mQcl.exec("HSET", mJobsKey, id,
+                                   Serialize(record)).get();
+    return (reply && (reply->type == REDIS_REPLY_INTEGER));
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to update workflow job\" id=%s emsg=\"%s\"",
+                    id.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Remove a job
+//------------------------------------------------------------------------------
+bool
+WFEQueue::Remove(const std::string& id)
+{
+  try {
+    qclient::MultiBuilder multi;
+    multi.emplace_back("HDEL", mJobsKey, id);
+    multi.emplace_back("HDEL", mLeasesKey, id);
+    return IsMultiOk(mQcl.follyExecute(multi.getDeque()).get());
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to remove workflow job\" id=%s emsg=\"%s\"",
+                    id.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Take a batch of due jobs from the ready deque and lease them
+//------------------------------------------------------------------------------
+std::vector<WFEQueue::Entry>
+WFEQueue::Dequeue(size_t max, time_t now, time_t lease)
+{
+  std::vector<Entry> dequeued;
+  // The ids are already popped from the ready deque, the ones which are not
+  // settled when something fails are put back so that the jobs are retried
+  // by the next Dequeue instead of the next Reset
+  std::vector<std::string> ids;
+  std::set<std::string> settled;
+
+  try {
+    ids = PopFront(mReadyKey, max);
+    std::set<std::string> seen;
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+    [&seen](const std::string & id) {
+      return !seen.insert(id).second;
+    }), ids.end());
+    std::vector<Record> records = GetRecords(ids);
+    std::vector<std::string> delayed;
+    std::vector<Entry> leased;
+    std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+    const std::string expiry = std::to_string(now + lease);
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+      Record& record = records[i];
+
+      // Removed, running or finished in the meantime
+      if (!IsQueued(GetField(record, "queue"))) {
+        settled.insert(ids[i]);
+        continue;
+      }
+
+      if (GetTime(record, "when") > now) {
+        delayed.push_back(ids[i]);
+        continue;
+      }
+
+      record["queue"] = "r";
+      qclient::MultiBuilder multi;
+      multi.emplace_back("HSET", mJobsKey, ids[i], Serialize(record));
+      multi.emplace_back("HSET", mLeasesKey, ids[i], expiry);
+      replies.emplace_back(mQcl.follyExecute(multi.getDeque()));
+      leased.push_back({ids[i], std::move(record)});
+    }
+
+    PushBack(mDelayedKey, delayed);
+    settled.insert(delayed.begin(), delayed.end());
+    std::vector<std::string> failed;
+
+    for (size_t i = 0; i < replies.size(); ++i) {
+      if (IsMultiOk(std::move(replies[i]).get())) {
+        settled.insert(leased[i].mId);
+        dequeued.push_back(std::move(leased[i]));
+      } else {
+        eos_static_err("msg=\"failed to lease workflow job\" id=%s",
+                       leased[i].mId.c_str());
+        failed.push_back(leased[i].mId);
+      }
+    }
+
+    PushBack(mReadyKey, failed);
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to dequeue workflow jobs\" emsg=\"%s\"",
+                    e.what());
+    // A job leased meanwhile is skipped by the next Dequeue as it's no
+    // longer queued, so putting back too much is harmless
+    std::vector<std::string> pending;
+
+    for (const auto& id : ids) {
+      if (!settled.count(id)) {
+        pending.push_back(id);
+      }
+    }
+
+    try {
+      PushBack(mReadyKey, pending);
+    } catch (const std::exception& ex) {
+      eos_static_crit("msg=\"failed to re-queue workflow jobs\" num=%lu "
+                      "emsg=\"%s\"", pending.size(), ex.what());
+    }
+  }
+
+  return dequeued;
+}
+
+//------------------------------------------------------------------------------
+// Move delayed jobs which became due to the ready deque
+//------------------------------------------------------------------------------
+size_t
+WFEQueue::Promote(time_t now)
+{
+  size_t promoted = 0;
+  // Ids of the current batch popped from the delayed deque and not yet
+  // settled, put back if something fails like in Dequeue
+  std::vector<std::string> ids;
+  std::set<std::string> settled;
+
+  try {
+    qclient::redisReplyPtr reply = mQcl.exec("deque-len", mDelayedKey).get();
+
+    if (!reply || (reply->type != REDIS_REPLY_INTEGER)) {
+      return 0;
+    }
+
+    // Look at every delayed job once, jobs pushed back meanwhile are skipped
+    uint64_t len = reply->integer;
+
+    while (len) {
+      size_t n = std::min<uint64_t>(len, cBatchSize);
+      len -= n;
+      ids.clear();
+      settled.clear();
+      ids = PopFront(mDelayedKey, n);
+      std::vector<Record> records = GetRecords(ids);
+      std::vector<std::string> ready, later;
+
+      for (size_t i = 0; i < ids.size(); ++i) {
+        if (!IsQueued(GetField(records[i], "queue"))) {
+          settled.insert(ids[i]);
+          continue;
+        }
+
+        if (GetTime(records[i], "when") <= now) {
+          ready.push_back(ids[i]);
+        } else {
+          later.push_back(ids[i]);
+        }
+      }
+
+      PushBack(mReadyKey, ready);
+      settled.insert(ready.begin(), ready.end());
+      PushBack(mDelayedKey, later);
+      settled.insert(later.begin(), later.end());
+      promoted += ready.size();
+
+      if (ids.size() < n) {
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to promote delayed workflow jobs\" "
+                    "emsg=\"%s\"", e.what());
+    std::vector<std::string> pending;
+
+    for (const auto& id : ids) {
+      if (!settled.count(id)) {
+        pending.push_back(id);
+      }
+    }
+
+    try {
+      PushBack(mDelayedKey, pending);
+    } catch (const std::exception& ex) {
+      eos_static_crit("msg=\"failed to re-queue delayed workflow jobs\" "
+                      "num=%lu emsg=\"%s\"", pending.size(), ex.what());
+    }
+  }
+
+  return promoted;
+}
+
+//------------------------------------------------------------------------------
+// Make running jobs with an expired lease visible again
+//------------------------------------------------------------------------------
+size_t
+WFEQueue::RecoverExpired(time_t now)
+{
+  size_t recovered = 0;
+
+  try {
+    std::vector<std::string> expired;
+    qclient::QHash leases(mQcl, mLeasesKey);
+
+    for (auto it = leases.getIterator(cBatchSize, "0"); it.valid(); it.next()) {
+      if (strtoll(it.getValue().c_str(), nullptr, 10) <= now) {
+        expired.push_back(it.getKey());
+      }
+    }
+
+    std::vector<Record> records = GetRecords(expired);
+    std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+
+    for (size_t i = 0; i < expired.size(); ++i) {
+      qclient::MultiBuilder multi;
+      multi.emplace_back("HDEL", mLeasesKey, expired[i]);
+
+      if (GetField(records[i], "queue") == "r") {
+        records[i]["queue"] = "q";
+        multi.emplace_back("HSET", mJobsKey, expired[i], Serialize(records[i]));
+        multi.emplace_back("deque-push-back", mReadyKey, expired[i]);
+        eos_static_warning("msg=\"workflow job lease expired, requeued\" id=%s",
+                           expired[i].c_str());
+        ++recovered;
+      }
+
+      replies.emplace_back(mQcl.follyExecute(multi.getDeque()));
+    }
+
+    for (auto& reply : replies) {
+      std::move(reply).get();
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to recover expired workflow jobs\" "
+                    "emsg=\"%s\"", e.what());
+  }
+
+  return recovered;
+}
+
+//------------------------------------------------------------------------------
+// Rebuild the deques from the job records
+//------------------------------------------------------------------------------
+size_t
+WFEQueue::Reset(time_t now)
+{
+  size_t queued = 0;
+
+  try {
+    qclient::MultiBuilder multi;
+    multi.emplace_back("DEL", mReadyKey);
+    multi.emplace_back("DEL", mDelayedKey);
+    multi.emplace_back("DEL", mLeasesKey);
+
+    if (!IsMultiOk(mQcl.follyExecute(multi.getDeque()).get())) {
+      eos_static_err("%s", "msg=\"failed to reset workflow job queue\"");
+      return 0;
+    }
+
+    std::vector<std::string> ready, delayed;
+    std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+    qclient::QHash jobs(mQcl, mJobsKey);
+
+    for (auto it = jobs.getIterator(cBatchSize, "0"); it.valid(); it.next()) {
+      Record record;
+
+      if (!Deserialize(it.getValue(), record)) {
+        eos_static_err("msg=\"dropping malformed workflow job\" id=%s",
+                       it.getKey().c_str());
+        replies.emplace_back(mQcl.exec("HDEL", mJobsKey, it.getKey()));
+        continue;
+      }
+
+      std::string queue = GetField(record, "queue");
+
+      if (queue == "r") {
+        record["queue"] = "q";
+        replies.emplace_back(mQcl.exec("HSET", mJobsKey, it.getKey(),
+                                       Serialize(record)));
+      } else if (!IsQueued(queue)) {
+        continue;
+      }
+
+      if (GetTime(record, "when") <= now) {
+        ready.push_back(it.getKey());
+      } else {
+        delayed.push_back(it.getKey());
+      }
+    }
+
+    for (auto& reply : replies) {
+      std::move(reply).get();
+    }
+
+    PushBack(mReadyKey, ready);
+    PushBack(mDelayedKey, delayed);
+    queued = ready.size() + delayed.size();
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to reset workflow job queue\" emsg=\"%s\"",
+                    e.what());
+  }
+
+  return queued;
+}
+
+//------------------------------------------------------------------------------
+// Drop finished jobs older than the given keep time
+//------------------------------------------------------------------------------
+size_t
+WFEQueue::Expire(time_t now, time_t keep)
+{
+  size_t dropped = 0;
+
+  try {
+    while (true) {
+      std::vector<std::string> entries = PopFront(mDoneKey, cBatchSize);
+      std::vector<std::string> ids, young;
+
+      for (size_t i = 0; i < entries.size(); ++i) {
+        if (strtoll(entries[i].c_str(), nullptr, 10) + keep > now) {
+          young.assign(entries.begin() + i, entries.end());
+          break;
+        }
+
+        size_t pos = entries[i].find(':');
+
+        if (pos != std::string::npos) {
+          ids.push_back(entries[i].substr(pos + 1));
+        }
+      }
+
+      std::vector<Record> records = GetRecords(ids);
+      std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+
+      for (size_t i = 0; i < ids.size(); ++i) {
+        std::string queue = GetField(records[i], "queue");
+
+        // Skip jobs which were removed or put back into a queue since
+        if (queue.empty() || IsQueued(queue) || (queue == "r")) {
+          continue;
+        }
+
+        replies.emplace_back(mQcl.exec("HDEL", mJobsKey, ids[i]));
+        ++dropped;
+      }
+
+      // Restore the order of the entries which are kept
+      for (auto it = young.rbegin(); it != young.rend(); ++it) {
+        replies.emplace_back(mQcl.exec("deque-push-front", mDoneKey, *it));
+      }
+
+      for (auto& reply : replies) {
+        std::move(reply).get();
+      }
+
+      if (!young.empty() || (entries.size() < cBatchSize)) {
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to expire workflow jobs\" emsg=\"%s\"",
+                    e.what());
+  }
+
+  return dropped;
+}
+
+//------------------------------------------------------------------------------
+// Get the queue lengths
+//------------------------------------------------------------------------------
+WFEQueue::Stats
+WFEQueue::GetStats()
+{
+  Stats stats;
+
+  try {
+    auto jobs = mQcl.exec("HLEN", mJobsKey);
+    auto ready = mQcl.exec("deque-len", mReadyKey);
+    auto delayed = mQcl.exec("deque-len", mDelayedKey);
+    auto leased = mQcl.exec("HLEN", mLeasesKey);
+    auto value = [](folly::Future<qclient::redisReplyPtr>&& fut) -> uint64_t {
+      qclient::redisReplyPtr reply = std::move(fut).get();
+      return (reply && (reply->type == REDIS_REPLY_INTEGER)) ? reply->integer : 0;
+    };
+    stats.mJobs = value(std::move(jobs));
+    stats.mReady = value(std::move(ready));
+    stats.mDelayed = value(std::move(delayed));
+    stats.mLeased = value(std::move(leased));
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to get workflow queue stats\" emsg=\"%s\"",
+                    e.what());
+  }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Drop all jobs of the queue
+//------------------------------------------------------------------------------
+void
+WFEQueue::Clear()
+{
+  try {
+    qclient::MultiBuilder multi;
+
+    for (const auto& key : {
+           mJobsKey, mReadyKey, mDelayedKey, mLeasesKey, mDoneKey, mMetaKey
+         }) {
+      multi.emplace_back("DEL", key);
+    }
+
+    (void) mQcl.follyExecute(multi.getDeque()).get();
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to clear workflow queue\" emsg=\"%s\"",
+                    e.what());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Serialize a record
+//------------------------------------------------------------------------------
+std::string
+WFEQueue::Serialize(const Record& record)
+{
+  std::string out;
+
+  for (const auto& elem : record) {
+    for (const std::string* str : {
+           &elem.first, &elem.second
+         }) {
+      out += std::to_string(str->size());
+      out += ':';
+      out += *str;
+      out += ',';
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Parse a serialized record
+//------------------------------------------------------------------------------
+bool
+WFEQueue::Deserialize(const std::string& data, Record& record)
+{
+  record.clear();
+  std::vector<std::string> items;
+  size_t pos = 0;
+
+  while (pos < data.size()) {
+    size_t colon = data.find(':', pos);
+
+    if ((colon == std::string::npos) || (colon == pos)) {
+      return false;
+    }
+
+    char* end = nullptr;
+    unsigned long long len = strtoull(data.c_str() + pos, &end, 10);
+
+    if ((end != data.c_str() + colon) || (len > data.size() - colon - 1) ||
+        (colon + 1 + len >= data.size()) || (data[colon + 1 + len] != ',')) {
+      return false;
+    }
+
+    items.emplace_back(data, colon + 1, len);
+    pos = colon + len + 2;
+  }
+
+  if (items.size() % 2) {
+    return false;
+  }
+
+  for (size_t i = 0; i < items.size(); i += 2) {
+    record[items[i]] = std::move(items[i + 1]);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the records of the given jobs
+//------------------------------------------------------------------------------
+std::vector<WFEQueue::Record>
+WFEQueue::GetRecords(const std::vector<std::string>& ids)
+{
+  std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+  std::vector<Record> records(ids.size());
+
+  for (const auto& id : ids) {
+    replies.emplace_back(mQcl.exec("HGET", mJobsKey, id));
+  }
+
+  for (size_t i = 0; i < replies.size(); ++i) {
+    qclient::redisReplyPtr reply = std::move(replies[i]).get();
+
+    if (reply && (reply->type == REDIS_REPLY_STRING) &&
+        !Deserialize(std::string(reply->str, reply->len), records[i])) {
+      eos_static_err("msg=\"malformed workflow job record\" id=%s",
+                     ids[i].c_str());
+      records[i].clear();
+    }
+  }
+
+  return records;
+}
+
+//------------------------------------------------------------------------------
+// Pop up to max ids from the front of a deque
+//------------------------------------------------------------------------------
+std::vector<std::string>
+WFEQueue::PopFront(const std::string& key, size_t max)
+{
+  std::vector<std::string> ids;
+  qclient::redisReplyPtr reply = mQcl.exec("deque-len", key).get();
+
+  if (!reply || (reply->type != REDIS_REPLY_INTEGER)) {
+    return ids;
+  }
+
+  size_t n = std::min<uint64_t>(max, reply->integer);
+  std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+
+  for (size_t i = 0; i < n; ++i) {
+    replies.emplace_back(mQcl.exec("deque-pop-front", key));
+  }
+
+  for (auto& fut : replies) {
+    reply = std::move(fut).get();
+
+    if (reply && (reply->type == REDIS_REPLY_STRING)) {
+      ids.emplace_back(reply->str, reply->len);
+    }
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Append ids to the back of a deque
+//------------------------------------------------------------------------------
+void
+WFEQueue::PushBack(const std::string& key, const std::vector<std::string>& ids)
+{
+  std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+
+  for (const auto& id : ids) {
+    replies.emplace_back(mQcl.exec("deque-push-back", key, id));
+  }
+
+  for (auto& reply : replies) {
+    std::move(reply).get();
+  }
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,229 @@
+//------------------------------------------------------------------------------
+//! @file WFEQueue.hh
+//! @brief Persistent workflow job queue kept in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Persistent queue of workflow jobs stored in QuarkDB, replacing the
+//! per-job entries under the proc workflow directory. It is made of:
+//!
+//!   <prefix>-jobs      hash job id -> serialized job record
+//!   <prefix>-ready     deque of ids of queued jobs which are due
+//!   <prefix>-delayed   deque of ids of queued jobs scheduled in the future
+//!   <prefix>-leases    hash job id -> lease expiry of running jobs
+//!   <prefix>-done      deque of "<time>:<id>" of finished jobs
+//!   <prefix>-meta      hash holding the job id sequence
+//!
+//! The record of a job carries its queue ("q", "e", "r" or a final one like
+//! "d", "f" or "g") and the time it is due. Dequeuing pops a batch of ids from
+//! the ready deque, moves the jobs into the "r" queue and gives them a lease.
+//! A job whose lease expired without it being stored in a different queue is
+//! visible again and put back to the ready deque. The deques only hold
+//! hints, every id taken from them is checked against the job record, so
+//! duplicated or stale ids are harmless.
+//!
+//! The queue expects a single consumer, i.e. the MGM master.
+//------------------------------------------------------------------------------
+class WFEQueue
+{
+public:
+  //! Job record, the "queue" and "when" fields are maintained by the queue
+  using Record = std::map<std::string, std::string>;
+
+  //! Dequeued job
+  struct Entry {
+    std::string mId;
+    Record mRecord;
+  };
+
+  //! Queue lengths
+  struct Stats {
+    uint64_t mJobs = 0;
+    uint64_t mReady = 0;
+    uint64_t mDelayed = 0;
+    uint64_t mLeased = 0;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl qclient object, must outlive the queue
+  //! @param prefix prefix of all QuarkDB keys of the queue
+  //----------------------------------------------------------------------------
+  WFEQueue(qclient::QClient& qcl, const std::string& prefix = "eos-wfe");
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~WFEQueue() = default;
+
+  //----------------------------------------------------------------------------
+  //! Store a job in the given queue. Queued ("q" or "e") jobs become
+  //! available for dequeuing once due, running ("r") jobs are only updated
+  //! and any other queue is final, which drops the lease of the job.
+  //!
+  //! @param id job id, a new one is allocated if empty
+  //! @param record job record
+  //! @param queue queue name
+  //! @param when time when the job is due
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Store(std::string& id, Record record, const std::string& queue,
+             time_t when);
+
+  //----------------------------------------------------------------------------
+  //! Get the record of a job
+  //!
+  //! @return true if the job exists, otherwise false
+  //----------------------------------------------------------------------------
+  bool Get(const std::string& id, Record& record);
+
+  //----------------------------------------------------------------------------
+  //! Add or overwrite fields of a job record, does nothing if the job
+  //! does not exist
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool SetFields(const std::string& id, const Record& fields);
+
+  //----------------------------------------------------------------------------
+  //! Remove a job
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Remove(const std::string& id);
+
+  //----------------------------------------------------------------------------
+  //! Take a batch of due jobs from the ready deque, move them into the "r"
+  //! queue and lease them until now + lease. All requests of a batch are
+  //! pipelined.
+  //!
+  //! @param max maximum number of jobs to dequeue
+  //! @param now current time
+  //! @param lease visibility timeout in seconds
+  //!
+  //! @return dequeued jobs
+  //----------------------------------------------------------------------------
+  std::vector<Entry> Dequeue(size_t max, time_t now, time_t lease);
+
+  //----------------------------------------------------------------------------
+  //! Move delayed jobs which became due to the ready deque
+  //!
+  //! @return number of jobs made ready
+  //----------------------------------------------------------------------------
+  size_t Promote(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Make running jobs with an expired lease visible again
+  //!
+  //! @return number of jobs put back to the "q" queue
+  //----------------------------------------------------------------------------
+  size_t RecoverExpired(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Rebuild the deques from the job records and put all running jobs back
+  //! to the "q" queue - used by a new master, which owns no running job
+  //!
+  //! @return number of queued jobs
+  //----------------------------------------------------------------------------
+  size_t Reset(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Drop finished jobs older than the given keep time
+  //!
+  //! @return number of dropped jobs
+  //----------------------------------------------------------------------------
+  size_t Expire(time_t now, time_t keep);
+
+  //----------------------------------------------------------------------------
+  //! Get the queue lengths
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+  //----------------------------------------------------------------------------
+  //! Drop all jobs of the queue
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Serialize a record as a sequence of "<length>:<bytes>," strings
+  //----------------------------------------------------------------------------
+  static std::string Serialize(const Record& record);
+
+  //----------------------------------------------------------------------------
+  //! Parse a serialized record
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Deserialize(const std::string& data, Record& record);
+
+  //! Number of requests pipelined in one batch
+  static constexpr size_t cBatchSize {1000};
+
+private:
+  //----------------------------------------------------------------------------
+  //! Check if a queue holds jobs waiting to be run
+  //----------------------------------------------------------------------------
+  static bool IsQueued(const std::string& queue)
+  {
+    return (queue == "q") || (queue == "e");
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the records of the given jobs, missing jobs get an empty record
+  //----------------------------------------------------------------------------
+  std::vector<Record> GetRecords(const std::vector<std::string>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Pop up to max ids from the front of a deque
+  //----------------------------------------------------------------------------
+  std::vector<std::string> PopFront(const std::string& key, size_t max);
+
+  //----------------------------------------------------------------------------
+  //! Append ids to the back of a deque
+  //----------------------------------------------------------------------------
+  void PushBack(const std::string& key, const std::vector<std::string>& ids);
+
+  qclient::QClient& mQcl; ///< QClient object
+  const std::string mJobsKey; ///< Hash of job records
+  const std::string mReadyKey; ///< Deque of due jobs
+  const std::string mDelayedKey; ///< Deque of jobs due in the future
+  const std::string mLeasesKey; ///< Hash of leases of running jobs
+  const std::string mDoneKey; ///< Deque of finished jobs
+  const std::string mMetaKey; ///< Hash holding the id sequence
+};
+
+EOSMGMNAMESPACE_END
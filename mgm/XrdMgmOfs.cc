@@ -75,6 +75,7 @@
 #include "mgm/ZMQ.hh"
 #include "mgm/Iostat.hh"
 #include "mgm/LRU.hh"
+#include "mgm/QuotaRecompute.hh"
 #include "mgm/WFE.hh"
 #include "mgm/fsck/Fsck.hh"
 #include "mgm/IMaster.hh"
@@ -309,6 +310,7 @@ XrdMgmOfs::XrdMgmOfs(XrdSysError* ep):
   mRouting(new eos::mgm::PathRouting()), mConverterDriver(),
   mHttpd(nullptr), GRPCd(nullptr), WNCd(nullptr), mRestGrpcSrv(nullptr),
   mLRUEngine(new eos::mgm::LRU()),
+  mQuotaRecompute(new eos::mgm::QuotaRecompute()),
   WFEPtr(new eos::mgm::WFE()), WFEd(*WFEPtr), mFstGwHost(""),
   mFstGwPort(0), mQdbCluster(""), mHttpdPort(8000),
   mFusexPort(1100), mGRPCPort(50051), mWncPort(50052),
@@ -504,8 +506,20 @@ XrdMgmOfs::OrderlyShutdown()
     WFEPtr.reset();
   }
 
-  eos_warning("%s", "msg=\"stopping and deleting the LRU engine\"");
-  mLRUEngine.reset();
+  // The LRU engine is a listener of the file service, it is deleted only
+  // after the namespace is finalized
+  eos_warning("%s", "msg=\"stopping the LRU engine\"");
+
+  if (mLRUEngine) {
+    mLRUEngine->Stop();
+  }
+
+  // Same for the quota recomputation, a running job keeps its checkpoint
+  eos_warning("%s", "msg=\"stopping the quota recomputation\"");
+
+  if (mQuotaRecompute) {
+    mQuotaRecompute->Stop();
+  }
 
   if (EgroupRefresh) {
     eos_warning("%s", "msg=\"stopping and deleting egroup refresh thread\"");
@@ -556,6 +570,10 @@ XrdMgmOfs::OrderlyShutdown()
     }
   }
 
+  eos_warning("%s", "msg=\"deleting the LRU engine\"");
+  mLRUEngine.reset();
+  mQuotaRecompute.reset();
+
   eos_warning("%s", "msg=\"stopping master-slave supervisor thread\"");
 
   if (mMaster) {
@@ -1072,6 +1090,68 @@ XrdMgmOfs::FuseXCastRefresh(eos::FileIdentifier id,
     parentid.getUnderlyingUInt64());
 }
 
+//------------------------------------------------------------------------------
+// Cast an added entry as a listing delta to clients
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::FuseXCastDentryAdd(eos::ContainerIdentifier id,
+                              eos::ContainerIdentifier parentid,
+                              eos::ContainerIdentifier pparentid,
+                              struct timespec& pt_mtime,
+                              struct timespec& pt_base_mtime)
+{
+  eos::fusex::md dir;
+  static eos::common::VirtualIdentity root_vid =
+    eos::common::VirtualIdentity::Root();
+
+  if (!gOFS->zMQ->gFuseServer.FillContainerMD(id.getUnderlyingUInt64(), dir,
+      root_vid, true)) {
+    gOFS->zMQ->gFuseServer.Cap().BroadcastDeltaFromExternal(
+      parentid.getUnderlyingUInt64(), pparentid.getUnderlyingUInt64(), &dir,
+      dir.name(), pt_mtime, pt_base_mtime);
+  } else {
+    gOFS->zMQ->gFuseServer.Cap().BroadcastRefreshFromExternal(
+      parentid.getUnderlyingUInt64(), pparentid.getUnderlyingUInt64());
+  }
+}
+
+void
+XrdMgmOfs::FuseXCastDentryAdd(eos::FileIdentifier id,
+                              eos::ContainerIdentifier parentid,
+                              eos::ContainerIdentifier pparentid,
+                              struct timespec& pt_mtime,
+                              struct timespec& pt_base_mtime)
+{
+  eos::fusex::md file;
+  static eos::common::VirtualIdentity root_vid =
+    eos::common::VirtualIdentity::Root();
+
+  if (gOFS->zMQ->gFuseServer.FillFileMD(eos::common::FileId::FidToInode(
+                                          id.getUnderlyingUInt64()), file, root_vid, true)) {
+    gOFS->zMQ->gFuseServer.Cap().BroadcastDeltaFromExternal(
+      parentid.getUnderlyingUInt64(), pparentid.getUnderlyingUInt64(), &file,
+      file.name(), pt_mtime, pt_base_mtime);
+  } else {
+    gOFS->zMQ->gFuseServer.Cap().BroadcastRefreshFromExternal(
+      parentid.getUnderlyingUInt64(), pparentid.getUnderlyingUInt64());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Cast a removed entry as a listing delta to clients
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::FuseXCastDentryRemove(eos::ContainerIdentifier id,
+                                 eos::ContainerIdentifier parentid,
+                                 const std::string& name,
+                                 struct timespec& pt_mtime,
+                                 struct timespec& pt_base_mtime)
+{
+  gOFS->zMQ->gFuseServer.Cap().BroadcastDeltaFromExternal(
+    id.getUnderlyingUInt64(), parentid.getUnderlyingUInt64(), nullptr,
+    name, pt_mtime, pt_base_mtime);
+}
+
 //------------------------------------------------------------------------------
 // Cast a MD object to clients
 //------------------------------------------------------------------------------
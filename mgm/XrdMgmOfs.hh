@@ -123,6 +123,7 @@
 #include "namespace/locking/NSObjectLocker.hh"
 #include "namespace/locking/BulkNsObjectLocker.hh"
 #include "mgm/InFlightTracker.hh"
+#include "mgm/AdmissionControl.hh"
 #include "mgm/namespacestats/NamespaceStats.hh"
 #include "XrdAcc/XrdAccPrivs.hh"
 #include <google/sparse_hash_map>
@@ -171,6 +172,7 @@ class Iostat;
 class Stat;
 class WFE;
 class LRU;
+class QuotaRecompute;
 class Fsck;
 class FsckEntry;
 class IMaster;
@@ -1345,6 +1347,8 @@ public:
   //! or writing (namespace modifying) function
   //! @param stalltime returns the time for a stall
   //! @param stallmsg returns the message to be displayed to the user
+  //! @param weight number of operations the call stands for, used as cost of
+  //!        the admission decision
   //!
   //! @return true if client should get a stall, otherwise false
   //!
@@ -1353,7 +1357,8 @@ public:
   //----------------------------------------------------------------------------
   bool ShouldStall(const char* function, int accessmode,
                    eos::common::VirtualIdentity& vid,
-                   int& stalltime, XrdOucString& stallmsg);
+                   int& stalltime, XrdOucString& stallmsg,
+                   uint32_t weight = 1);
 
   //----------------------------------------------------------------------------
   //! @brief Check if a client based on the called function and his
@@ -1824,6 +1829,44 @@ public:
   void FuseXCastRefresh(eos::FileIdentifier id,
                         eos::ContainerIdentifier parentid);
 
+  //----------------------------------------------------------------------------
+  //! Cast an added entry of a container as a delta to fusex clients listing
+  //! the container, other clients get a refresh of the container
+  //!
+  //! @param id identifier of the added entry
+  //! @param parentid container identifier
+  //! @param pparentid identifier of the parent of the container
+  //! @param pt_mtime new mtime of the container
+  //! @param pt_base_mtime mtime of the container before the change
+  //----------------------------------------------------------------------------
+  void FuseXCastDentryAdd(eos::ContainerIdentifier id,
+                          eos::ContainerIdentifier parentid,
+                          eos::ContainerIdentifier pparentid,
+                          struct timespec& pt_mtime,
+                          struct timespec& pt_base_mtime);
+
+  void FuseXCastDentryAdd(eos::FileIdentifier id,
+                          eos::ContainerIdentifier parentid,
+                          eos::ContainerIdentifier pparentid,
+                          struct timespec& pt_mtime,
+                          struct timespec& pt_base_mtime);
+
+  //----------------------------------------------------------------------------
+  //! Cast a removed entry of a container as a delta to fusex clients listing
+  //! the container, other clients get a refresh of the container
+  //!
+  //! @param id container identifier
+  //! @param parentid identifier of the parent of the container
+  //! @param name removed name
+  //! @param pt_mtime new mtime of the container
+  //! @param pt_base_mtime mtime of the container before the change
+  //----------------------------------------------------------------------------
+  void FuseXCastDentryRemove(eos::ContainerIdentifier id,
+                             eos::ContainerIdentifier parentid,
+                             const std::string& name,
+                             struct timespec& pt_mtime,
+                             struct timespec& pt_base_mtime);
+
   //----------------------------------------------------------------------------
   //! Cast MD to FUSE clients
   //!
@@ -1956,6 +1999,9 @@ public:
   //! LRU object running the LRU policy engine
   std::unique_ptr<LRU> mLRUEngine;
 
+  //! Online recomputation of quota nodes
+  std::unique_ptr<QuotaRecompute> mQuotaRecompute;
+
   //! WFE object running the WFE engine
   std::unique_ptr<WFE> WFEPtr;
   WFE& WFEd;
@@ -1979,6 +2025,9 @@ public:
   std::string mQdbPassword; ///< Quarkdb cluster password
   eos::QdbContactDetails mQdbContactDetails; ///< QuarkDB contact details
   std::string mQClientDir; ///<QClient metadata directory
+  std::string mNsIndexSpec; ///< Secondary namespace metadata index spec
+  bool mWfeQdbQueue {false}; ///< Keep workflow jobs in the QuarkDB queue
+  bool mRecycleIndex {false}; ///< Maintain the recycle bin index in QuarkDB
   int mHttpdPort; ///< port of the http server, default 8000
   int mFusexPort; ///< port of the FUSEX broadcast MQZ, default 1100
   int mGRPCPort; ///< port of the GRPC server, default 50051
@@ -1987,6 +2036,8 @@ public:
   eos::common::XrdConnPool mXrdConnPool; ///< XRD connection pool
   //! Tracker for requests which are currently executing MGM code
   eos::mgm::InFlightTracker mTracker;
+  //! Token bucket based admission control for incoming requests
+  eos::mgm::AdmissionControl mAdmission;
   //! The tape-aware garbage collector's interface to the EOS MGM
   std::unique_ptr<tgc::RealTapeGcMgm> mTapeGcMgm;
   //! Multi-space tape-aware garbage collector
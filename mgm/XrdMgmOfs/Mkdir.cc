@@ -321,6 +321,8 @@ XrdMgmOfs::_mkdir(const char* path,
           char btime[256];
           snprintf(btime, sizeof(btime), "%lu.%lu", ctime.tv_sec, ctime.tv_nsec);
           newdir->setAttribute("sys.eos.btime", btime);
+          eos::IContainerMD::mtime_t base_mtime;
+          dir->getMTime(base_mtime);
           dir->setMTime(ctime);
           dir->notifyMTimeChange(gOFS->eosDirectoryService);
           // commit
@@ -332,8 +334,7 @@ XrdMgmOfs::_mkdir(const char* path,
           eos::ContainerIdentifier d_id = dir->getIdentifier();
           eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
           lock.Release();
-          gOFS->FuseXCastMD(nd_id, d_id,ctime, true);
-          gOFS->FuseXCastRefresh(d_id, d_pid);
+          gOFS->FuseXCastDentryAdd(nd_id, d_id, d_pid, ctime, base_mtime);
         } catch (eos::MDException& e) {
           errno = e.getErrno();
           eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
@@ -378,6 +379,8 @@ XrdMgmOfs::_mkdir(const char* path,
     char btime[256];
     snprintf(btime, sizeof(btime), "%lu.%lu", ctime.tv_sec, ctime.tv_nsec);
     newdir->setAttribute("sys.eos.btime", btime);
+    eos::IContainerMD::mtime_t base_mtime;
+    dir->getMTime(base_mtime);
     dir->setMTime(ctime);
 
     // If not version directory, then inherit attributes
@@ -403,8 +406,7 @@ XrdMgmOfs::_mkdir(const char* path,
     eos::ContainerIdentifier d_id = dir->getIdentifier();
     eos::ContainerIdentifier d_pid = dir->getParentIdentifier();
     lock.Release();
-    gOFS->FuseXCastMD(nd_id, d_id, ctime, true);
-    gOFS->FuseXCastRefresh(d_id, d_pid);
+    gOFS->FuseXCastDentryAdd(nd_id, d_id, d_pid, ctime, base_mtime);
   } catch (eos::MDException& e) {
     errno = e.getErrno();
     eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"",
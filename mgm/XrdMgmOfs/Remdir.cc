@@ -226,10 +226,14 @@ XrdMgmOfs::_remdir(const char* path,
       eos::ContainerIdentifier dhpar_id;
       eos::ContainerIdentifier dhpar_pid;
       std::string dh_name;
+      eos::IContainerMD::mtime_t base_mtime {0, 0};
+      eos::IContainerMD::mtime_t mtime {0, 0};
 
       // update the in-memory modification time of the parent directory
       if (dhpar) {
+        dhpar->getMTime(base_mtime);
         dhpar->setMTimeNow();
+        dhpar->getMTime(mtime);
         dhpar->notifyMTimeChange(gOFS->eosDirectoryService);
         eosView->updateContainerStore(dhpar.get());
         dhpar_id = dhpar->getIdentifier();
@@ -241,8 +245,8 @@ XrdMgmOfs::_remdir(const char* path,
       viewLock.Release();
 
       if (dhpar) {
-        gOFS->FuseXCastDeletion(dhpar_id, dh_name);
-        gOFS->FuseXCastRefresh(dhpar_id, dhpar_pid);
+        gOFS->FuseXCastDentryRemove(dhpar_id, dhpar_pid, dh_name, mtime,
+                                    base_mtime);
       }
     } catch (eos::MDException& e) {
       errno = e.getErrno();
@@ -342,15 +342,19 @@ XrdMgmOfs::_rem(const char* path,
           gOFS->WriteRmRecord(fmd);
 
           if (container) {
+            eos::IContainerMD::mtime_t base_mtime;
+            eos::IContainerMD::mtime_t mtime;
+            container->getMTime(base_mtime);
             container->setMTimeNow();
+            container->getMTime(mtime);
             container->notifyMTimeChange(gOFS->eosDirectoryService);
             eosView->updateContainerStore(container.get());
             std::string deletion_name = fmd->getName();
             eos::ContainerIdentifier c_ident = container->getIdentifier();
             eos::ContainerIdentifier p_ident = container->getParentIdentifier();
             lock.Release();
-            gOFS->FuseXCastDeletion(c_ident, deletion_name);
-            gOFS->FuseXCastRefresh(c_ident, p_ident);
+            gOFS->FuseXCastDentryRemove(c_ident, p_ident, deletion_name, mtime,
+                                        base_mtime);
           }
         }
       }
@@ -33,7 +33,8 @@ bool
 XrdMgmOfs::ShouldStall(const char* function,
                        int __AccessMode__,
                        eos::common::VirtualIdentity& vid,
-                       int& stalltime, XrdOucString& stallmsg)
+                       int& stalltime, XrdOucString& stallmsg,
+                       uint32_t weight)
 {
   // Check for user, group or host banning
   std::string smsg = "";
@@ -224,10 +225,40 @@ XrdMgmOfs::ShouldStall(const char* function,
         }
       }
 
+      bool admission_stall = false;
+
+      // Metadata reads are never queued, like they are never rate limited
+      if (!stalltime && !limit && Access::gStallAdmission &&
+          eos::mgm::AdmissionControl::IsAdmissionOp(functionname)) {
+        gOFS->mAdmission.Configure(Access::gStallRules,
+                                   Access::gStallRulesVersion);
+        // Don't hold the access mutex while waiting in the admission queue
+        lock.Release();
+        eos::mgm::AdmissionControl::Request req;
+        req.mUid = vid.uid;
+        req.mGid = vid.gid;
+        req.mApp = vid.app;
+        req.mOp = (IS_ACCESSMODE_W ? "w" : "r");
+        req.mWeight = weight;
+        auto decision = gOFS->mAdmission.Admit(req);
+
+        if (!decision.mAdmitted) {
+          // The stall hint is already adapted to the queue depth
+          admission_stall = true;
+          stalltime = decision.mStallSec;
+          smsg = "operate - you are exceeding the admission rate";
+          stallid += "::admission::";
+          stallid += decision.mBucket;
+        }
+      }
+
       if (stalltime && (saturated || ! limit)) {
-        // add random offset between 0 and 5 to stalltime
-        int random_stall = rand() % 6;
-        stalltime += random_stall;
+        if (!admission_stall) {
+          // add random offset between 0 and 5 to stalltime
+          int random_stall = rand() % 6;
+          stalltime += random_stall;
+        }
+
         stallmsg = "Attention: you are currently hold in this instance and each"
                    " request is stalled for ";
         stallmsg += (int) stalltime;
@@ -29,6 +29,7 @@
 #include "mgm/ZMQ.hh"
 
 #include <XrdOuc/XrdOucEnv.hh>
+#include <map>
 
 //----------------------------------------------------------------------------
 // Fuse extension.
@@ -45,10 +46,6 @@ XrdMgmOfs::Fusex(const char* path,
 {
   static const char* epname = "Fusex";
   ACCESSMODE_W;
-  FUNCTIONMAYSTALL("Eosxd::prot::SET", vid, error);
-  MAYREDIRECT;
-  EXEC_TIMING_BEGIN("Eosxd::prot::SET");
-  gOFS->MgmStats.Add("Eosxd::prot::SET", vid.uid, vid.gid, 1);
   eos_static_debug("protobuf-len=%d", protobuf.length());
   eos::fusex::md md;
 
@@ -56,6 +53,62 @@ XrdMgmOfs::Fusex(const char* path,
     return Emsg(epname, error, EINVAL, "parse protocol buffer [EINVAL]", "");
   }
 
+  // A batch is accounted and throttled with the number of sub-operations of
+  // each type, otherwise packing many requests into one message would bypass
+  // the rate limits. Lookups count as STAT like the GetFusex calls they
+  // replace. The admission decision is taken once per type and weighted by
+  // the count so that one batch waits at most once in the admission queue.
+  std::map<std::string, std::pair<int, uint32_t>> ops;
+
+  if (md.operation() == md.BATCH) {
+    for (const auto& item : md.batch()) {
+      if ((item.operation() == item.GET) || (item.operation() == item.GETCAP)) {
+        auto& op = ops.emplace("Eosxd::prot::STAT",
+                               std::make_pair(0, 0u)).first->second;
+        ++op.second;
+      } else {
+        auto& op = ops.emplace("Eosxd::prot::SET",
+                               std::make_pair(1, 0u)).first->second;
+        ++op.second;
+      }
+    }
+  }
+
+  if (ops.empty()) {
+    ops.emplace("Eosxd::prot::SET", std::make_pair(1, 1u));
+  }
+
+  eos::mgm::InFlightRegistration tracker_helper(gOFS->mTracker, vid);
+
+  if (gOFS->IsStall) {
+    XrdOucString stallmsg = "";
+    int stalltime = 0;
+
+    for (const auto& op : ops) {
+      if (gOFS->ShouldStall(op.first.c_str(), op.second.first, vid, stalltime,
+                            stallmsg, op.second.second)) {
+        if (stalltime) {
+          return gOFS->Stall(error, stalltime, stallmsg.c_str());
+        } else {
+          return gOFS->Emsg("maystall", error, EPERM, stallmsg.c_str(), "");
+        }
+      }
+    }
+
+    if (!tracker_helper.IsOK()) {
+      stallmsg = "track request, stall the client 5 seconds";
+      stalltime = 5;
+      return gOFS->Stall(error, stalltime, stallmsg.c_str());
+    }
+  }
+
+  MAYREDIRECT;
+  EXEC_TIMING_BEGIN("Eosxd::prot::SET");
+
+  for (const auto& op : ops) {
+    gOFS->MgmStats.Add(op.first.c_str(), vid.uid, vid.gid, op.second.second);
+  }
+
   std::string resultstream;
   std::string id = std::string("Fusex::sync:") + vid.tident.c_str();
   int rc = gOFS->zMQ->gFuseServer.HandleMD(id, md, vid, &resultstream, 0);
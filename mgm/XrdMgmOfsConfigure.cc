@@ -620,6 +620,41 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
           }
         }
 
+        if (!strcmp("nsindex", var)) {
+          mNsIndexSpec.clear();
+
+          while ((val = Config.GetWord())) {
+            mNsIndexSpec += (mNsIndexSpec.empty() ? "" : ",");
+            mNsIndexSpec += val;
+          }
+
+          Eroute.Say("=====> mgmofs.nsindex : ", mNsIndexSpec.c_str());
+        }
+
+        if (!strcmp("wfequeue", var)) {
+          if (!(val = Config.GetWord()) ||
+              (strcmp("namespace", val) && strcmp("quarkdb", val))) {
+            Eroute.Emsg("Config", "argument for wfequeue is invalid, has to be "
+                        "namespace or quarkdb");
+            NoGo = 1;
+          } else {
+            mWfeQdbQueue = !strcmp("quarkdb", val);
+            Eroute.Say("=====> mgmofs.wfequeue : ", val);
+          }
+        }
+
+        if (!strcmp("recycleindex", var)) {
+          if (!(val = Config.GetWord()) ||
+              (strcmp("true", val) && strcmp("false", val))) {
+            Eroute.Emsg("Config", "argument for recycleindex is invalid, has to "
+                        "be true or false");
+            NoGo = 1;
+          } else {
+            mRecycleIndex = !strcmp("true", val);
+            Eroute.Say("=====> mgmofs.recycleindex : ", val);
+          }
+        }
+
         if (!strcmp("authlib", var)) {
           if ((!(val = Config.GetWord())) || (::access(val, R_OK))) {
             Eroute.Emsg("Config", "I cannot access the authorization library!");
@@ -2307,6 +2342,7 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Eosxd::ext::SETLK", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::GETLK", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::SETLKW", 0, 0, 0);
+  MgmStats.Add("Eosxd::ext::BATCH", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::BEGINFLUSH", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::ENDFLUSH", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::CREATELNK", 0, 0, 0);
@@ -2320,6 +2356,8 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Eosxd::int::BcRefreshExt", 0, 0, 0);
   MgmStats.Add("Eosxd::int::BcDeletion", 0, 0, 0);
   MgmStats.Add("Eosxd::int::BcDeletionExt", 0, 0, 0);
+  MgmStats.Add("Eosxd::int::BcDeltaExt", 0, 0, 0);
+  MgmStats.Add("Eosxd::int::BcDeltaExtNoRefresh", 0, 0, 0);
   MgmStats.Add("Eosxd::int::DeleteEntry", 0, 0, 0);
   MgmStats.Add("Eosxd::int::FillContainerCAP", 0, 0, 0);
   MgmStats.Add("Eosxd::int::FillContainerMD", 0, 0, 0);
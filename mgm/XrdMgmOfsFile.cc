@@ -1841,7 +1841,11 @@ XrdMgmOfsFile::open(eos::common::VirtualIdentity* invid,
           gOFS->eosDirectoryService->getContainerMD(cid);
         eos::ContainerIdentifier cmd_id = cmd->getIdentifier();
         eos::ContainerIdentifier pcmd_id = cmd->getParentIdentifier();
+        eos::IContainerMD::mtime_t pt_base_mtime;
+        eos::IContainerMD::mtime_t pt_mtime;
+        cmd->getMTime(pt_base_mtime);
         cmd->setMTimeNow();
+        cmd->getMTime(pt_mtime);
 
         if (isCreation || (!fmd->getNumLocation())) {
           eos::IQuotaNode* ns_quota = gOFS->eosView->getQuotaNode(cmd.get());
@@ -1856,8 +1860,16 @@ XrdMgmOfsFile::open(eos::common::VirtualIdentity* invid,
         gOFS->eosView->updateFileStore(fmd.get());
         cmd->notifyMTimeChange(gOFS->eosDirectoryService);
         gOFS->eosView->updateContainerStore(cmd.get());
-        gOFS->FuseXCastRefresh(fmd_id, cmd_id);
-        gOFS->FuseXCastRefresh(cmd_id, pcmd_id);
+
+        if (isCreation) {
+          // clients listing the directory add the new entry to their listing
+          gOFS->FuseXCastDentryAdd(fmd_id, cmd_id, pcmd_id, pt_mtime,
+                                   pt_base_mtime);
+        } else {
+          gOFS->FuseXCastRefresh(fmd_id, cmd_id);
+          gOFS->FuseXCastRefresh(cmd_id, pcmd_id);
+        }
+
         COMMONTIMING("fusex::bc", &tm);
       } catch (eos::MDException& e) {
         errno = e.getErrno();
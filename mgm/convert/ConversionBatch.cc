@@ -0,0 +1,198 @@
+//------------------------------------------------------------------------------
+//! @file ConversionBatch.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/convert/ConversionBatch.hh"
+#include "mgm/Quota.hh"
+#include "namespace/Prefetcher.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr uint8_t ConversionBatch::sMaxParallel;
+constexpr uint64_t ConversionBatch::sMaxFileSize;
+
+//------------------------------------------------------------------------------
+// Build the key identifying the conversions that can be batched together
+//------------------------------------------------------------------------------
+std::string
+ConversionBatch::GetKey(const ConversionInfo& info, unsigned long src_lid)
+{
+  return SSTR(std::hex << src_lid << ":" << info.mLid << ":"
+              << info.mLocation.getGroup() << ":" << info.mPlctPolicy
+              << ":" << info.mUpdateCtime << ":" << info.mAppTag);
+}
+
+//------------------------------------------------------------------------------
+// Execute the conversions of the batch
+//------------------------------------------------------------------------------
+void
+ConversionBatch::DoIt() noexcept
+{
+  eos_static_debug("msg=\"starting conversion batch\" size=%lu", mJobs.size());
+  // Bulk prefetch the metadata of the files and their parents which is
+  // needed to build the transfer paths
+  {
+    eos::Prefetcher prefetcher(gOFS->eosView);
+
+    for (const auto& job : mJobs) {
+      prefetcher.stageFileMDWithParents(job->GetFid());
+    }
+
+    prefetcher.wait();
+  }
+  Commit(Transfer(mJobs));
+}
+
+//------------------------------------------------------------------------------
+// Run the transfers of the given jobs as one pipelined copy process
+//------------------------------------------------------------------------------
+std::vector<std::shared_ptr<ConversionJob>>
+ConversionBatch::Transfer(const std::vector<std::shared_ptr<ConversionJob>>&
+                          jobs)
+{
+  std::vector<std::shared_ptr<ConversionJob>> prepared;
+  std::vector<std::shared_ptr<ConversionJob>> transferred;
+  // Results must not be reallocated once handed to the copy process
+  std::vector<XrdCl::PropertyList> results(jobs.size());
+  XrdCl::CopyProcess copy;
+  XrdCl::PropertyList config;
+  config.Set("jobType", "configuration");
+  config.Set("parallel", sMaxParallel);
+  copy.AddJob(config, nullptr);
+
+  for (const auto& job : jobs) {
+    XrdCl::PropertyList properties;
+
+    if (job->Prepare(properties)) {
+      copy.AddJob(properties, &results[prepared.size()]);
+      prepared.push_back(job);
+    }
+  }
+
+  if (prepared.empty()) {
+    return transferred;
+  }
+
+  XrdCl::XRootDStatus prepare_status = copy.Prepare();
+  eos_static_info("msg=\"prepared conversion batch\" num_tpc=%lu "
+                  "prepare_msg=%s", prepared.size(),
+                  prepare_status.ToStr().c_str());
+
+  if (!prepare_status.IsOK()) {
+    for (const auto& job : prepared) {
+      job->ReleaseConnections();
+      job->HandleError("prepare conversion failed");
+    }
+
+    return transferred;
+  }
+
+  ProgressHandler handler(prepared);
+  XrdCl::XRootDStatus run_status = copy.Run(&handler);
+
+  for (size_t i = 0; i < prepared.size(); ++i) {
+    // Fall back to the global status if the job did not report its own
+    XrdCl::XRootDStatus tpc_status = run_status;
+    (void) results[i].Get("status", tpc_status);
+
+    if (prepared[i]->CheckTransfer(tpc_status)) {
+      transferred.push_back(prepared[i]);
+    }
+  }
+
+  return transferred;
+}
+
+//------------------------------------------------------------------------------
+// Verify and merge the given transferred jobs into the namespace
+//------------------------------------------------------------------------------
+void
+ConversionBatch::Commit(const std::vector<std::shared_ptr<ConversionJob>>&
+                        jobs)
+{
+  if (jobs.empty()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<ConversionJob>> verified;
+  {
+    eos::Prefetcher prefetcher(gOFS->eosView);
+
+    for (const auto& job : jobs) {
+      job->StageMetadata(prefetcher);
+    }
+
+    prefetcher.wait();
+  }
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    for (const auto& job : jobs) {
+      if (job->VerifyLocked()) {
+        verified.push_back(job);
+      }
+    }
+  }
+
+  // Quota accounting takes the namespace lock itself
+  for (const auto& job : verified) {
+    job->mHasQuota = Quota::RemoveFile(job->GetFid());
+  }
+
+  std::vector<bool> attached(verified.size(), false);
+  std::vector<bool> merged(verified.size(), false);
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    for (size_t i = 0; i < verified.size(); ++i) {
+      attached[i] = verified[i]->MergeAttachLocked();
+    }
+  }
+
+  for (size_t i = 0; i < verified.size(); ++i) {
+    if (attached[i]) {
+      merged[i] = verified[i]->MergeRename();
+    }
+  }
+
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    for (size_t i = 0; i < verified.size(); ++i) {
+      if (attached[i]) {
+        merged[i] = verified[i]->MergeCompleteLocked(merged[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < verified.size(); ++i) {
+    verified[i]->MergeFinalize(merged[i]);
+
+    if (merged[i]) {
+      verified[i]->Complete();
+    }
+  }
+
+  eos_static_info("msg=\"finished conversion batch\" size=%lu transferred=%lu "
+                  "verified=%lu", mJobs.size(), jobs.size(), verified.size());
+}
+
+EOSMGMNAMESPACE_END
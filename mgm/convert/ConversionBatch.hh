@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+//! @file ConversionBatch.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "mgm/convert/ConversionJob.hh"
+#include <memory>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Group of small file conversions sharing the same source layout and
+//! the same target layout, space and placement. The batch prefetches the
+//! metadata of all its files at once, runs the transfers as a single
+//! pipelined copy process with several TPC jobs in flight and applies the
+//! namespace changes of all the files under a single lock acquisition per
+//! merge step. Each file keeps its own ConversionJob object so that the
+//! status, error reporting and clean up are the same as for the standalone
+//! conversions.
+//------------------------------------------------------------------------------
+class ConversionBatch : public eos::common::LogId
+{
+public:
+  //! Max number of TPC jobs in flight for a batch
+  static constexpr uint8_t sMaxParallel {16};
+  //! Max size of a file eligible for batched conversion
+  static constexpr uint64_t sMaxFileSize {64ull * 1024 * 1024};
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param jobs conversion jobs part of the batch
+  //----------------------------------------------------------------------------
+  ConversionBatch(std::vector<std::shared_ptr<ConversionJob>>&& jobs):
+    mJobs(std::move(jobs))
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Execute the conversions of the batch
+  //----------------------------------------------------------------------------
+  void DoIt() noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Get number of conversions in the batch
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mJobs.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Build the key identifying the conversions that can be batched together
+  //!
+  //! @param info conversion info
+  //! @param src_lid layout id of the file to be converted
+  //!
+  //! @return batch key
+  //----------------------------------------------------------------------------
+  static std::string GetKey(const ConversionInfo& info,
+                            unsigned long src_lid);
+
+private:
+  //----------------------------------------------------------------------------
+  //! @brief Progress handler dispatching the notifications of the copy
+  //! process to the progress handler of the corresponding conversion job
+  //----------------------------------------------------------------------------
+  class ProgressHandler : public XrdCl::CopyProgressHandler
+  {
+  public:
+    ProgressHandler(const std::vector<std::shared_ptr<ConversionJob>>& jobs):
+      mJobs(jobs)
+    {}
+
+    void BeginJob(uint16_t jobNum, uint16_t jobTotal,
+                  const XrdCl::URL* source,
+                  const XrdCl::URL* destination) override
+    {
+      if (auto* handler = GetHandler(jobNum)) {
+        handler->BeginJob(jobNum, jobTotal, source, destination);
+      }
+    }
+
+    void JobProgress(uint16_t jobNum, uint64_t bytesProcessed,
+                     uint64_t bytesTotal) override
+    {
+      if (auto* handler = GetHandler(jobNum)) {
+        handler->JobProgress(jobNum, bytesProcessed, bytesTotal);
+      }
+    }
+
+    bool ShouldCancel(uint16_t jobNum) override
+    {
+      auto* handler = GetHandler(jobNum);
+      return (handler ? handler->ShouldCancel(jobNum) : false);
+    }
+
+  private:
+    //--------------------------------------------------------------------------
+    //! Get progress handler of the given job, job numbers start from 1
+    //--------------------------------------------------------------------------
+    ConversionProgressHandler* GetHandler(uint16_t jobNum)
+    {
+      if ((jobNum == 0) || (jobNum > mJobs.size())) {
+        return nullptr;
+      }
+
+      return &mJobs[jobNum - 1]->mProgressHandler;
+    }
+
+    const std::vector<std::shared_ptr<ConversionJob>>& mJobs;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Run the transfers of the given jobs as one pipelined copy process
+  //!
+  //! @param jobs list of jobs to transfer
+  //!
+  //! @return list of jobs whose transfer was successful
+  //----------------------------------------------------------------------------
+  std::vector<std::shared_ptr<ConversionJob>>
+  Transfer(const std::vector<std::shared_ptr<ConversionJob>>& jobs);
+
+  //----------------------------------------------------------------------------
+  //! Verify and merge the given transferred jobs into the namespace
+  //!
+  //! @param jobs list of transferred jobs
+  //----------------------------------------------------------------------------
+  void Commit(const std::vector<std::shared_ptr<ConversionJob>>& jobs);
+
+  std::vector<std::shared_ptr<ConversionJob>> mJobs; ///< Batch conversions
+};
+
+EOSMGMNAMESPACE_END
@@ -140,11 +140,65 @@ ConversionJob::~ConversionJob()
 // Execute a third-party copy
 //------------------------------------------------------------------------------
 void ConversionJob::DoIt() noexcept
+{
+  XrdCl::PropertyList properties;
+
+  if (!Prepare(properties)) {
+    return;
+  }
+
+  // Create the TPC job
+  XrdCl::PropertyList result;
+  XrdCl::CopyProcess copy;
+  copy.AddJob(properties, &result);
+  XrdCl::XRootDStatus prepare_status = copy.Prepare();
+  eos_static_info("[tpc]: %s@%s => %s@%s prepare_msg=%s",
+                  mUrlSrc.GetHostId().c_str(), mUrlSrc.GetLocation().c_str(),
+                  mUrlDst.GetHostId().c_str(), mUrlDst.GetLocation().c_str(),
+                  prepare_status.ToStr().c_str());
+
+  // Check the TPC prepare status
+  if (!prepare_status.IsOK()) {
+    ReleaseConnections();
+    HandleError("prepare conversion failed");
+    return;
+  }
+
+  // Trigger the TPC job
+  if (!CheckTransfer(copy.Run(&mProgressHandler))) {
+    return;
+  }
+
+  // TPC job succeeded:
+  //  - Verify new file has all fragments according to layout
+  //  - Verify initial file hasn't changed
+  //  - Merge the conversion entry
+  {
+    eos::Prefetcher prefetcher(gOFS->eosView);
+    StageMetadata(prefetcher);
+    prefetcher.wait();
+  }
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    if (!VerifyLocked()) {
+      return;
+    }
+  }
+
+  if (Merge()) {
+    Complete();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Retrieve the file metadata and build the TPC job properties
+//------------------------------------------------------------------------------
+bool
+ConversionJob::Prepare(XrdCl::PropertyList& properties) noexcept
 {
   using eos::common::FileId;
   using eos::common::LayoutId;
-  std::string source_xs;
-  std::string source_xs_postconversion;
   bool overwrite_checksum;
   uint64_t source_size;
   eos::IFileMD::LocationVector src_locations;
@@ -156,7 +210,7 @@ void ConversionJob::DoIt() noexcept
   // Avoid running cancelled jobs
   if (mProgressHandler.ShouldCancel(0)) {
     HandleError("conversion job cancelled before start");
-    return;
+    return false;
   }
 
   mStatus.store(Status::RUNNING, std::memory_order_relaxed);
@@ -169,7 +223,7 @@ void ConversionJob::DoIt() noexcept
     source_size = fmd->getSize();
     src_locations = fmd->getLocations();
     src_unlink_loc = fmd->getUnlinkedLocations();
-    eos::appendChecksumOnStringAsHex(fmd.get(), source_xs);
+    eos::appendChecksumOnStringAsHex(fmd.get(), mSourceXs);
     // Check if conversion requests a checksum rewrite
     std::string file_checksum = LayoutId::GetChecksumString(fmd->getLayoutId());
     std::string conversion_checksum =
@@ -180,9 +234,10 @@ void ConversionJob::DoIt() noexcept
                 SSTR("fxid=" << FileId::Fid2Hex(mConversionInfo.mFid)
                      << " ec=" << e.getErrno()
                      << " emsg=\"" << e.getMessage().str() << "\""));
-    return;
+    return false;
   }
 
+  mSourceSize = source_size;
   const std::string& app_tag = mConversionInfo.mAppTag.empty() ? EOS_APP_NAME :
                                mConversionInfo.mAppTag;
   // Construct destination CGI
@@ -192,8 +247,8 @@ void ConversionJob::DoIt() noexcept
           << "&eos.app=" << app_tag
           << "&eos.targetsize=" << source_size;
 
-  if (source_xs.size() && !overwrite_checksum) {
-    dst_cgi << "&eos.checksum=" << source_xs;
+  if (mSourceXs.size() && !overwrite_checksum) {
+    dst_cgi << "&eos.checksum=" << mSourceXs;
   }
 
   // Add the list of file systems to exclude for the new entry
@@ -215,55 +270,66 @@ void ConversionJob::DoIt() noexcept
 
   dst_cgi << exclude_fsids;
   // Prepare the TPC job
-  XrdCl::URL url_src = NewUrl();
+  mUrlSrc = NewUrl();
   std::string url_params = "eos.ruid=0&eos.rgid=0&eos.app=" + app_tag;
-  url_src.SetParams(url_params);
-  url_src.SetPath(mSourcePath);
-  XrdCl::URL url_dst = NewUrl();
-  url_dst.SetParams(dst_cgi.str());
-  url_dst.SetPath(mConversionPath);
-  eos::common::XrdConnIdHelper src_id_helper(gOFS->mXrdConnPool, url_src);
-  eos::common::XrdConnIdHelper dst_id_helper(gOFS->mXrdConnPool, url_dst);
-  XrdCl::PropertyList properties = TpcProperties(source_size);
-  properties.Set("source", url_src);
-  properties.Set("target", url_dst);
-  // Create the TPC job
-  XrdCl::PropertyList result;
-  XrdCl::CopyProcess copy;
-  copy.AddJob(properties, &result);
-  XrdCl::XRootDStatus prepare_status = copy.Prepare();
-  eos_static_info("[tpc]: %s@%s => %s@%s prepare_msg=%s",
-                  url_src.GetHostId().c_str(), url_src.GetLocation().c_str(),
-                  url_dst.GetHostId().c_str(), url_dst.GetLocation().c_str(),
-                  prepare_status.ToStr().c_str());
-
-  // Check the TPC prepare status
-  if (!prepare_status.IsOK()) {
-    HandleError("prepare conversion failed");
-    return;
-  }
+  mUrlSrc.SetParams(url_params);
+  mUrlSrc.SetPath(mSourcePath);
+  mUrlDst = NewUrl();
+  mUrlDst.SetParams(dst_cgi.str());
+  mUrlDst.SetPath(mConversionPath);
+  mSrcIdHelper.reset(new eos::common::XrdConnIdHelper(gOFS->mXrdConnPool,
+                     mUrlSrc));
+  mDstIdHelper.reset(new eos::common::XrdConnIdHelper(gOFS->mXrdConnPool,
+                     mUrlDst));
+  properties = TpcProperties(source_size);
+  properties.Set("source", mUrlSrc);
+  properties.Set("target", mUrlDst);
+  return true;
+}
 
-  // Trigger the TPC job
-  XrdCl::XRootDStatus tpc_status = copy.Run(&mProgressHandler);
+//------------------------------------------------------------------------------
+// Release the connections used by the TPC job and check its status
+//------------------------------------------------------------------------------
+bool
+ConversionJob::CheckTransfer(const XrdCl::XRootDStatus& tpc_status)
+{
+  ReleaseConnections();
 
   if (!tpc_status.IsOK()) {
     HandleError(tpc_status.ToStr(),
-                SSTR("tpc_src=" << url_src.GetLocation()
-                     << " tpc_dst=" << url_dst.GetLocation()));
-    return;
+                SSTR("tpc_src=" << mUrlSrc.GetLocation()
+                     << " tpc_dst=" << mUrlDst.GetLocation()));
+    return false;
   }
 
   eos_static_info("[tpc]: %s => %s status=success tpc_msg=%s",
-                  url_src.GetLocation().c_str(), url_dst.GetLocation().c_str(),
+                  mUrlSrc.GetLocation().c_str(), mUrlDst.GetLocation().c_str(),
                   tpc_status.ToStr().c_str());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Declare the intent to access the original and the converted file metadata
+//------------------------------------------------------------------------------
+void
+ConversionJob::StageMetadata(eos::Prefetcher& prefetcher) const
+{
+  prefetcher.stageFileMD(mConversionInfo.mFid);
+  prefetcher.stageFileMD(mConversionPath, false);
+}
+
+//------------------------------------------------------------------------------
+// Verify the converted file and that the original file did not change
+//------------------------------------------------------------------------------
+bool
+ConversionJob::VerifyLocked()
+{
+  using eos::common::FileId;
+  using eos::common::LayoutId;
+  std::string source_xs_postconversion;
 
-  // TPC job succeeded:
-  //  - Verify new file has all fragments according to layout
-  //  - Verify initial file hasn't changed
-  //  - Merge the conversion entry
   // Verify new file has all fragments according to layout
   try {
-    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
     auto fmd = gOFS->eosView->getFile(mConversionPath);
     size_t expected = LayoutId::GetStripeNumber(mConversionInfo.mLid) + 1;
     size_t actual = fmd->getNumLocation();
@@ -271,19 +337,17 @@ void ConversionJob::DoIt() noexcept
     if (expected != actual) {
       HandleError("converted file replica number mismatch",
                   SSTR("expected=" << expected << " actual=" << actual));
-      return;
+      return false;
     }
   } catch (eos::MDException& e) {
     HandleError("failed to retrieve converted file metadata",
                 SSTR("path=" << mConversionPath << " ec=" << e.getErrno()
                      << " emsg=\"" << e.getMessage().str() << "\""));
-    return;
+    return false;
   }
 
   // Verify initial file hasn't changed
   try {
-    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, mConversionInfo.mFid);
-    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
     auto fmd = gOFS->eosFileService->getFileMD(mConversionInfo.mFid);
     eos::appendChecksumOnStringAsHex(fmd.get(), source_xs_postconversion);
   } catch (eos::MDException& e) {
@@ -293,25 +357,25 @@ void ConversionJob::DoIt() noexcept
                      mConversionInfo.ToString().c_str());
   }
 
-  if (source_xs != source_xs_postconversion) {
+  if (mSourceXs != source_xs_postconversion) {
     HandleError("file checksum changed during conversion",
                 SSTR("fxid=" << FileId::Fid2Hex(mConversionInfo.mFid)
-                     << " initial_xs=" << source_xs << " final_xs="
+                     << " initial_xs=" << mSourceXs << " final_xs="
                      << source_xs_postconversion));
-    return;
+    return false;
   }
 
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Finalize the QoS transition and mark the job as done
+//------------------------------------------------------------------------------
+void
+ConversionJob::Complete()
+{
   XrdOucErrInfo error;
   eos::common::VirtualIdentity rootvid = eos::common::VirtualIdentity::Root();
-
-  // Merge the conversion entry
-  if (!Merge()) {
-    HandleError("failed to merge conversion entry",
-                SSTR("path=" << mSourcePath << " converted_path="
-                     << mConversionPath));
-    return;
-  }
-
   // Finalize  QoS transition
   XrdOucString target_qos;
   XrdOucString current_qos;
@@ -362,8 +426,6 @@ void ConversionJob::DoIt() noexcept
       // Ignore any garbage collection exceptions
     }
   }
-
-  return;
 }
 
 //------------------------------------------------------------------------------
@@ -428,46 +490,65 @@ std::string ConversionJob::ConversionCGI(const ConversionInfo& info) const
 bool
 ConversionJob::Merge()
 {
-  std::list<eos::IFileMD::location_t> conv_locations;
-  eos::IFileMD::id_t orig_fid {0ull}, conv_fid {0ull};
-  std::shared_ptr<eos::IFileMD> orig_fmd, conv_fmd;
-  bool has_quota = Quota::RemoveFile(mFid);
+  bool merged = false;
+  mHasQuota = Quota::RemoveFile(mFid);
   {
     eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+    merged = MergeAttachLocked();
+  }
 
-    try {
-      orig_fmd = gOFS->eosFileService->getFileMD(mFid);
-      conv_fmd = gOFS->eosView->getFile(mConversionPath);
-    } catch (const eos::MDException& e) {
-      eos_static_err("msg=\"failed to retrieve file metadata\" msg=\"%s\"",
-                     e.what());
-
-      if (has_quota) {
-        ns_rd_lock.Release();
-        Quota::AddFile(mFid);
-      }
+  if (merged) {
+    merged = MergeRename();
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+    merged = MergeCompleteLocked(merged);
+  }
 
-      return false;
-    }
+  MergeFinalize(merged);
+  return merged;
+}
 
-    orig_fid = orig_fmd->getId();
-    conv_fid = conv_fmd->getId();
+//------------------------------------------------------------------------------
+// Merge step attaching the new locations to the original file
+//------------------------------------------------------------------------------
+bool
+ConversionJob::MergeAttachLocked()
+{
+  std::shared_ptr<eos::IFileMD> orig_fmd, conv_fmd;
+  mConvLocations.clear();
 
-    // Add the new locations
-    for (const auto& loc : conv_fmd->getLocations()) {
-      orig_fmd->addLocation(loc);
-      conv_locations.push_back(loc);
-    }
+  try {
+    orig_fmd = gOFS->eosFileService->getFileMD(mFid);
+    conv_fmd = gOFS->eosView->getFile(mConversionPath);
+  } catch (const eos::MDException& e) {
+    eos_static_err("msg=\"failed to retrieve file metadata\" msg=\"%s\"",
+                   e.what());
+    return false;
+  }
 
-    gOFS->eosView->updateFileStore(orig_fmd.get());
+  mConvFid = conv_fmd->getId();
+
+  // Add the new locations
+  for (const auto& loc : conv_fmd->getLocations()) {
+    orig_fmd->addLocation(loc);
+    mConvLocations.push_back(loc);
   }
+
+  gOFS->eosView->updateFileStore(orig_fmd.get());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Merge step renaming the physical files on the new locations
+//------------------------------------------------------------------------------
+bool
+ConversionJob::MergeRename()
+{
   // For each location get the FST information and trigger a physical file
   // rename from the conv_fmd(fid) to the orig_fmd(fid)
-  bool failed_rename = false;
   std::string fst_host;
   int fst_port;
 
-  for (const auto& loc : conv_locations) {
+  for (const auto& loc : mConvLocations) {
     {
       eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
       FileSystem* fs = FsView::gFsView.mIdView.lookupByID(loc);
@@ -477,8 +558,7 @@ ConversionJob::Merge()
           (fs->GetConfigStatus() != eos::common::ConfigStatus::kRW)) {
         eos_static_err("msg=\"file system config cannot accept conversion\" "
                        "fsid=%u", loc);
-        failed_rename = true;
-        break;
+        return false;
       }
 
       fst_host = fs->GetHost();
@@ -490,15 +570,14 @@ ConversionJob::Merge()
 
     if (!url.IsValid()) {
       eos_static_err("msg=\"invalid FST url\" url=\"%s\"", oss.str().c_str());
-      failed_rename = true;
-      break;
+      return false;
     }
 
     oss.str("");
     // Build up the actual query string
     oss << "/?fst.pcmd=local_rename"
-        << "&fst.rename.ofid=" << eos::common::FileId::Fid2Hex(conv_fid)
-        << "&fst.rename.nfid=" << eos::common::FileId::Fid2Hex(orig_fid)
+        << "&fst.rename.ofid=" << eos::common::FileId::Fid2Hex(mConvFid)
+        << "&fst.rename.nfid=" << eos::common::FileId::Fid2Hex(mFid)
         << "&fst.rename.fsid=" << loc
         << "&fst.nspath=" << mSourcePath;
     uint16_t timeout = 10;
@@ -515,100 +594,100 @@ ConversionJob::Merge()
       eos_static_err("msg=\"failed local rename on file system\" "
                      "orig_fxid=%08llx conv_fxid=%08llx fsid=%u "
                      "status=%d err_msg=\"%s\" response=\"%s\"",
-                     orig_fid, conv_fid, loc, status.IsOK(),
+                     mFid, mConvFid, loc, status.IsOK(),
                      status.GetErrorMessage().c_str(),
                      (response ? response->ToString().c_str() : "none"));
-      failed_rename = true;
       delete response;
-      break;
+      return false;
     }
 
     delete response;
     eos_static_debug("msg=\"successful rename on file system\" orig_fxid=%08llx "
-                     "conv_fxid=%08llx fsid=%u", orig_fid, conv_fid, loc);
+                     "conv_fxid=%08llx fsid=%u", mFid, mConvFid, loc);
   }
 
-  // Do cleanup in case of failures
-  if (failed_rename) {
-    // Update locations and clean up conversion file object
-    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+  return true;
+}
 
-    try {
-      orig_fmd = gOFS->eosFileService->getFileMD(orig_fid);
-    } catch (const eos::MDException& e) {
-      eos_static_err("msg=\"failed to retrieve file metadata\" msg=\"%s\" "
-                     "orig_fxid=%08llx", e.what(), orig_fid);
-      return false;
-    }
+//------------------------------------------------------------------------------
+// Merge step committing the new layout or rolling back the new locations
+//------------------------------------------------------------------------------
+bool
+ConversionJob::MergeCompleteLocked(bool renamed)
+{
+  std::shared_ptr<eos::IFileMD> orig_fmd;
 
+  try {
+    orig_fmd = gOFS->eosFileService->getFileMD(mFid);
+  } catch (const eos::MDException& e) {
+    eos_static_err("msg=\"failed to retrieve file metadata\" msg=\"%s\" "
+                   "orig_fxid=%08llx", e.what(), mFid);
+    return false;
+  }
+
+  if (!renamed) {
     // Unlink all the newly added locations
     for (const auto& loc : orig_fmd->getLocations()) {
-      if (std::find(conv_locations.begin(), conv_locations.end(), loc) !=
-          conv_locations.end()) {
+      if (std::find(mConvLocations.begin(), mConvLocations.end(), loc) !=
+          mConvLocations.end()) {
         orig_fmd->unlinkLocation(loc);
       }
     }
 
     gOFS->eosView->updateFileStore(orig_fmd.get());
-
-    if (has_quota) {
-      ns_rd_lock.Release();
-      Quota::AddFile(mFid);
-    }
-
     return false;
   }
 
-  {
-    // Update locations and clean up conversion file object
-    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
-
-    try {
-      orig_fmd = gOFS->eosFileService->getFileMD(orig_fid);
-      conv_fmd = gOFS->eosFileService->getFileMD(conv_fid);
-    } catch (const eos::MDException& e) {
-      eos_static_err("msg=\"failed to retrieve file metadata\" msg=\"%s\"",
-                     e.what());
-      return false;
+  // Unlink the old locations from the original file object
+  for (const auto& loc : orig_fmd->getLocations()) {
+    if (loc == eos::common::TAPE_FS_ID) {
+      continue;
     }
 
-    // Unlink the old locations from the original file object
-    for (const auto& loc : orig_fmd->getLocations()) {
-      if (loc == eos::common::TAPE_FS_ID) {
-        continue;
-      }
-
-      if (std::find(conv_locations.begin(), conv_locations.end(), loc) ==
-          conv_locations.end()) {
-        orig_fmd->unlinkLocation(loc);
-      }
+    if (std::find(mConvLocations.begin(), mConvLocations.end(), loc) ==
+        mConvLocations.end()) {
+      orig_fmd->unlinkLocation(loc);
     }
+  }
 
-    // Update the new layout id
-    orig_fmd->setLayoutId(mConversionInfo.mLid);
-
-    // If requested then also update the ctime of the original file
-    if (mConversionInfo.mUpdateCtime) {
-      orig_fmd->setCTimeNow();
-    }
+  // Update the new layout id
+  orig_fmd->setLayoutId(mConversionInfo.mLid);
 
-    gOFS->eosView->updateFileStore(orig_fmd.get());
+  // If requested then also update the ctime of the original file
+  if (mConversionInfo.mUpdateCtime) {
+    orig_fmd->setCTimeNow();
   }
 
+  gOFS->eosView->updateFileStore(orig_fmd.get());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Merge step restoring the quota and triggering the resync
+//------------------------------------------------------------------------------
+void
+ConversionJob::MergeFinalize(bool merged)
+{
   // Update quota node given the new possible layout
-  if (has_quota) {
+  if (mHasQuota) {
     Quota::AddFile(mFid);
+    mHasQuota = false;
+  }
+
+  if (!merged) {
+    HandleError("failed to merge conversion entry",
+                SSTR("path=" << mSourcePath << " converted_path="
+                     << mConversionPath));
+    return;
   }
 
   // Trigger a resync of the local information for the new locations
-  for (const auto& loc : conv_locations) {
-    if (gOFS->QueryResync(orig_fid, loc, true)) {
+  for (const auto& loc : mConvLocations) {
+    if (gOFS->QueryResync(mFid, loc, true)) {
       eos_static_err("msg=\"failed to send resync\" fxid=%08llx fsid=%u",
-                     orig_fid, loc);
+                     mFid, loc);
     }
   }
-
-  return true;
 }
 
 EOSMGMNAMESPACE_END
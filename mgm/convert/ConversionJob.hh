@@ -28,13 +28,20 @@
 #include "common/FileId.hh"
 #include "common/LayoutId.hh"
 #include "common/FileSystem.hh"
+#include "common/XrdConnPool.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "XrdCl/XrdClCopyProcess.hh"
 
+namespace eos
+{
+class Prefetcher;
+}
+
 EOSMGMNAMESPACE_BEGIN
 
 //! Forward declaration
 class ConversionJob;
+class ConversionBatch;
 enum class ConversionJobStatus { DONE, RUNNING, PENDING, FAILED };
 static std::string EOS_APP_NAME = "eos/converter";
 
@@ -169,6 +176,14 @@ public:
     return mFid;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the conversion details
+  //----------------------------------------------------------------------------
+  inline const ConversionInfo& GetConversionInfo() const
+  {
+    return mConversionInfo;
+  }
+
   //----------------------------------------------------------------------------
   //! Get the conversion error message
   //----------------------------------------------------------------------------
@@ -177,15 +192,109 @@ public:
     return mErrorString;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the size of the file to be converted, only valid once the job
+  //! retrieved the file metadata
+  //----------------------------------------------------------------------------
+  inline uint64_t GetSize() const
+  {
+    return mSourceSize;
+  }
+
 private:
+  friend class ConversionBatch;
+
+  //----------------------------------------------------------------------------
+  //! Retrieve the file metadata and build the TPC job properties
+  //!
+  //! @param properties TPC job properties
+  //!
+  //! @return true if successful, otherwise false and the job is failed
+  //----------------------------------------------------------------------------
+  bool Prepare(XrdCl::PropertyList& properties) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Release the connections used by the TPC job and check its status
+  //!
+  //! @param tpc_status TPC job status
+  //!
+  //! @return true if successful, otherwise false and the job is failed
+  //----------------------------------------------------------------------------
+  bool CheckTransfer(const XrdCl::XRootDStatus& tpc_status);
+
+  //----------------------------------------------------------------------------
+  //! Declare the intent to access the metadata of both the original and the
+  //! converted file
+  //!
+  //! @param prefetcher namespace prefetcher
+  //----------------------------------------------------------------------------
+  void StageMetadata(eos::Prefetcher& prefetcher) const;
+
+  //----------------------------------------------------------------------------
+  //! Verify the converted file has all the fragments according to the layout
+  //! and that the original file did not change. Must be called with the
+  //! namespace lock held.
+  //!
+  //! @return true if successful, otherwise false and the job is failed
+  //----------------------------------------------------------------------------
+  bool VerifyLocked();
+
   //----------------------------------------------------------------------------
   //! Merge original and the newly converted one so that the initial file
   //! identifier and all the rest of the metadata information is preserved.
   //!
-  //! @return true if successful, otherwise false
+  //! @return true if successful, otherwise false and the job is failed
   //----------------------------------------------------------------------------
   bool Merge();
 
+  //----------------------------------------------------------------------------
+  //! Merge step attaching the new locations to the original file. Must be
+  //! called with the namespace lock held.
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool MergeAttachLocked();
+
+  //----------------------------------------------------------------------------
+  //! Merge step renaming the physical files on the new locations
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool MergeRename();
+
+  //----------------------------------------------------------------------------
+  //! Merge step committing the new layout or, if the rename failed, rolling
+  //! back the attached locations. Must be called with the namespace lock held.
+  //!
+  //! @param renamed true if the physical files were renamed
+  //!
+  //! @return true if the new layout was committed, otherwise false
+  //----------------------------------------------------------------------------
+  bool MergeCompleteLocked(bool renamed);
+
+  //----------------------------------------------------------------------------
+  //! Merge step restoring the quota accounting and triggering the resync of
+  //! the new locations
+  //!
+  //! @param merged true if the merge was successful, otherwise the job is
+  //!        failed
+  //----------------------------------------------------------------------------
+  void MergeFinalize(bool merged);
+
+  //----------------------------------------------------------------------------
+  //! Finalize the QoS transition and mark the job as done
+  //----------------------------------------------------------------------------
+  void Complete();
+
+  //----------------------------------------------------------------------------
+  //! Release the connections assigned to the TPC job
+  //----------------------------------------------------------------------------
+  inline void ReleaseConnections()
+  {
+    mSrcIdHelper.reset();
+    mDstIdHelper.reset();
+  }
+
   //----------------------------------------------------------------------------
   //! Log the error message, store it and set the job as failed
   //!
@@ -210,6 +319,16 @@ private:
   std::atomic<Status> mStatus; ///< Conversion job status
   std::string mErrorString; ///< Error message
   ConversionProgressHandler mProgressHandler; ///< Conversion progress handler
+  std::atomic<uint64_t> mSourceSize {0ull}; ///< Size of file to be converted
+  std::string mSourceXs; ///< Checksum of file to be converted
+  XrdCl::URL mUrlSrc; ///< TPC source
+  XrdCl::URL mUrlDst; ///< TPC destination
+  std::unique_ptr<eos::common::XrdConnIdHelper> mSrcIdHelper;
+  std::unique_ptr<eos::common::XrdConnIdHelper> mDstIdHelper;
+  bool mHasQuota {false}; ///< Mark if file was removed from quota accounting
+  eos::IFileMD::id_t mConvFid {0ull}; ///< File id of the converted file
+  //! Locations of the converted file
+  std::list<eos::IFileMD::location_t> mConvLocations;
 };
 
 EOSMGMNAMESPACE_END
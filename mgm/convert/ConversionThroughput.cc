@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+//! @file ConversionThroughput.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/convert/ConversionThroughput.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+using namespace std::chrono;
+constexpr std::chrono::seconds ConversionThroughput::sRateWindow;
+
+//------------------------------------------------------------------------------
+// Account a finished conversion
+//------------------------------------------------------------------------------
+void
+ConversionThroughput::Account(bool success, uint64_t bytes)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (success) {
+    ++mStats.mFiles;
+    mStats.mBytes += bytes;
+    ++mWindowFiles;
+    mWindowBytes += bytes;
+  } else {
+    ++mStats.mFailed;
+  }
+
+  UpdateRate(mClock.getTime());
+}
+
+//------------------------------------------------------------------------------
+// Get conversion statistics
+//------------------------------------------------------------------------------
+ConversionThroughput::Stats
+ConversionThroughput::GetStats()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  UpdateRate(mClock.getTime());
+  return mStats;
+}
+
+//------------------------------------------------------------------------------
+// Fold the current sampling window into the smoothed rates
+//------------------------------------------------------------------------------
+void
+ConversionThroughput::UpdateRate(steady_clock::time_point now)
+{
+  if (!mStarted) {
+    mStarted = true;
+    mWindowStart = now;
+    return;
+  }
+
+  auto elapsed = duration_cast<milliseconds>(now - mWindowStart);
+
+  if (elapsed < sRateWindow) {
+    return;
+  }
+
+  double file_sample = 1000.0 * mWindowFiles / elapsed.count();
+  double byte_sample = 1000.0 * mWindowBytes / elapsed.count();
+
+  // Take the sample as is if there is no history or the converter was idle
+  // for a long time, otherwise smooth it
+  if ((mStats.mFileRate == 0) || (elapsed >= 6 * sRateWindow)) {
+    mStats.mFileRate = file_sample;
+    mStats.mByteRate = byte_sample;
+  } else {
+    mStats.mFileRate = 0.7 * mStats.mFileRate + 0.3 * file_sample;
+    mStats.mByteRate = 0.7 * mStats.mByteRate + 0.3 * byte_sample;
+  }
+
+  mWindowFiles = 0;
+  mWindowBytes = 0;
+  mWindowStart = now;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+//! @file ConversionThroughput.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/SteadyClock.hh"
+#include <mutex>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Track the number of finished conversions and the conversion rate
+//! in files/s and bytes/s. The rates are sampled over fixed windows and
+//! smoothed to avoid jumps when batches finish at once.
+//------------------------------------------------------------------------------
+class ConversionThroughput
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Conversion statistics
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t mFiles {0}; ///< Number of files converted
+    uint64_t mBytes {0}; ///< Number of bytes converted
+    uint64_t mFailed {0}; ///< Number of failed conversions
+    double mFileRate {0}; ///< Smoothed rate in files/s
+    double mByteRate {0}; ///< Smoothed rate in bytes/s
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fake_clock if true use a fake clock, used for testing
+  //----------------------------------------------------------------------------
+  ConversionThroughput(bool fake_clock = false):
+    mClock(fake_clock)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Account a finished conversion
+  //!
+  //! @param success true if the conversion was successful
+  //! @param bytes size of the converted file
+  //----------------------------------------------------------------------------
+  void Account(bool success, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Get conversion statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+  //----------------------------------------------------------------------------
+  //! Get clock reference for testing purposes
+  //----------------------------------------------------------------------------
+  inline eos::common::SteadyClock& GetClock()
+  {
+    return mClock;
+  }
+
+private:
+#ifdef IN_TEST_HARNESS
+public:
+#endif
+  //! Window over which the rates are sampled
+  static constexpr std::chrono::seconds sRateWindow {10};
+
+  //----------------------------------------------------------------------------
+  //! Fold the current sampling window into the smoothed rates. Must be called
+  //! with the mutex locked.
+  //----------------------------------------------------------------------------
+  void UpdateRate(std::chrono::steady_clock::time_point now);
+
+  std::mutex mMutex; ///< Mutex protecting the members below
+  Stats mStats; ///< Conversion statistics
+  bool mStarted {false}; ///< Mark if sampling started
+  uint64_t mWindowFiles {0}; ///< Files converted in the current window
+  uint64_t mWindowBytes {0}; ///< Bytes converted in the current window
+  std::chrono::steady_clock::time_point mWindowStart;
+  eos::common::SteadyClock mClock; ///< Clock, can be faked for testing
+};
+
+EOSMGMNAMESPACE_END
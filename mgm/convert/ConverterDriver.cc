@@ -22,11 +22,14 @@
  ************************************************************************/
 
 #include "mgm/convert/ConverterDriver.hh"
+#include "mgm/convert/ConversionBatch.hh"
 #include "mgm/IMaster.hh"
+#include "namespace/Prefetcher.hh"
 
 EOSMGMNAMESPACE_BEGIN
 
 constexpr unsigned int ConverterDriver::cDefaultRequestIntervalSec;
+constexpr unsigned int ConverterDriver::cBatchGroupWindow;
 constexpr unsigned int ConverterDriver::QdbHelper::cBatchSize;
 
 //------------------------------------------------------------------------------
@@ -93,23 +96,25 @@ ConverterDriver::Convert(ThreadAssistant& assistant) noexcept
       assistant.wait_for(std::chrono::seconds(5));
     }
 
-    auto fid = info.first;
-    auto conversion_info = ConversionInfo::parseConversionString(info.second);
-
-    if (conversion_info != nullptr) {
-      auto job = std::make_shared<ConversionJob>(fid, *conversion_info.get());
-      mThreadPool.PushTask<void>([ = ]() {
-        return job->DoIt();
-      });
-      eos::common::RWMutexWriteLock wlock(mJobsMutex);
-      mJobsRunning.push_back(job);
-    } else {
-      eos_static_err("msg=\"invalid conversion scheduled\" fxid=%08llx "
-                     "conversion_id=%s", fid, info.second.c_str());
-      mQdbHelper.RemovePendingJob(fid);
-      gOFS->mFidTracker.RemoveEntry(fid);
-    }
+    std::vector<std::shared_ptr<ConversionJob>> jobs;
+    const size_t window = GetSubmitWindow();
+
+    do {
+      auto fid = info.first;
+      auto conversion_info = ConversionInfo::parseConversionString(info.second);
+
+      if (conversion_info != nullptr) {
+        jobs.push_back(std::make_shared<ConversionJob>(fid,
+                       *conversion_info.get()));
+      } else {
+        eos_static_err("msg=\"invalid conversion scheduled\" fxid=%08llx "
+                       "conversion_id=%s", fid, info.second.c_str());
+        mQdbHelper.RemovePendingJob(fid);
+        gOFS->mFidTracker.RemoveEntry(fid);
+      }
+    } while ((jobs.size() < window) && mPendingJobs.try_pop(info));
 
+    SubmitJobs(jobs);
     HandleRunningJobs();
   }
 
@@ -155,6 +160,7 @@ void
 ConverterDriver::SubmitQdbPending(ThreadAssistant& assistant)
 {
   const auto lst_pending = mQdbHelper.GetPendingJobs();
+  std::vector<std::shared_ptr<ConversionJob>> jobs;
 
   for (const auto& info : lst_pending) {
     auto id = info.first;
@@ -166,14 +172,15 @@ ConverterDriver::SubmitQdbPending(ThreadAssistant& assistant)
     }
 
     if (conversion_info != nullptr) {
-      auto job = std::make_shared<ConversionJob>(id, *conversion_info.get());
-      mThreadPool.PushTask<void>([ = ]() {
-        return job->DoIt();
-      });
-      eos::common::RWMutexWriteLock wlock(mJobsMutex);
-      mJobsRunning.push_back(job);
+      jobs.push_back(std::make_shared<ConversionJob>(id, *conversion_info.get()));
+    }
+
+    if (jobs.size() < GetSubmitWindow()) {
+      continue;
     }
 
+    SubmitJobs(jobs);
+
     while ((mThreadPool.GetQueueSize() > mMaxQueueSize) &&
            !assistant.terminationRequested()) {
       assistant.wait_for(std::chrono::seconds(5));
@@ -183,6 +190,93 @@ ConverterDriver::SubmitQdbPending(ThreadAssistant& assistant)
       break;
     }
   }
+
+  if (!jobs.empty() && !assistant.terminationRequested()) {
+    SubmitJobs(jobs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Submit conversion jobs to the thread pool
+//------------------------------------------------------------------------------
+void
+ConverterDriver::SubmitJobs(std::vector<std::shared_ptr<ConversionJob>>& jobs)
+{
+  std::list<std::shared_ptr<ConversionBatch>> batches;
+  std::vector<std::shared_ptr<ConversionJob>> singles;
+  std::vector<std::shared_ptr<ConversionJob>> batched;
+  const unsigned int batch_size = mBatchSize.load();
+
+  if ((batch_size <= 1) || (jobs.size() <= 1)) {
+    singles.swap(jobs);
+  } else {
+    std::map<std::string, std::vector<std::shared_ptr<ConversionJob>>> groups;
+    {
+      // Bulk prefetch the metadata needed for grouping the jobs
+      eos::Prefetcher prefetcher(gOFS->eosView);
+
+      for (const auto& job : jobs) {
+        prefetcher.stageFileMD(job->GetFid());
+      }
+
+      prefetcher.wait();
+    }
+    {
+      eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+      for (auto& job : jobs) {
+        try {
+          auto fmd = gOFS->eosFileService->getFileMD(job->GetFid());
+
+          if (fmd->getSize() <= ConversionBatch::sMaxFileSize) {
+            groups[ConversionBatch::GetKey(job->GetConversionInfo(),
+                                           fmd->getLayoutId())].push_back(job);
+            continue;
+          }
+        } catch (const eos::MDException& e) {
+          // The job itself reports the error
+        }
+
+        singles.push_back(job);
+      }
+    }
+    jobs.clear();
+
+    for (auto& group : groups) {
+      auto& lst = group.second;
+
+      for (size_t pos = 0; pos < lst.size(); pos += batch_size) {
+        auto end = lst.begin() + std::min(pos + batch_size, lst.size());
+
+        if (end - (lst.begin() + pos) == 1) {
+          singles.push_back(lst[pos]);
+        } else {
+          std::vector<std::shared_ptr<ConversionJob>>
+              batch_jobs(lst.begin() + pos, end);
+          batched.insert(batched.end(), batch_jobs.begin(), batch_jobs.end());
+          batches.push_back(std::make_shared<ConversionBatch>
+                            (std::move(batch_jobs)));
+        }
+      }
+    }
+  }
+
+  for (const auto& job : singles) {
+    mThreadPool.PushTask<void>([ = ]() {
+      return job->DoIt();
+    });
+  }
+
+  for (const auto& batch : batches) {
+    eos_static_debug("msg=\"submit conversion batch\" size=%lu", batch->Size());
+    mThreadPool.PushTask<void>([ = ]() {
+      return batch->DoIt();
+    });
+  }
+
+  eos::common::RWMutexWriteLock wlock(mJobsMutex);
+  mJobsRunning.insert(mJobsRunning.end(), singles.begin(), singles.end());
+  mJobsRunning.insert(mJobsRunning.end(), batched.begin(), batched.end());
 }
 
 //------------------------------------------------------------------------------
@@ -208,6 +302,8 @@ ConverterDriver::HandleRunningJobs()
         mQdbHelper.AddFailedJob(*it);
       }
 
+      mThroughput.Account(job_status == ConversionJob::Status::DONE,
+                          (*it)->GetSize());
       mObserverMgr->notifyChange(job_status, (*it)->GetConversionString());
       it = mJobsRunning.erase(it);
     } else {
@@ -288,7 +384,10 @@ ConverterDriver::InitConfig()
   unsigned int max_queue_sz = mConfigStore->get(kConverterMaxQueueSize,
                               cDefaultMaxQueueSize);
   mMaxThreadPoolSize.store(max_threads, std::memory_order_relaxed);
+  unsigned int batch_sz = mConfigStore->get(kConverterBatchSize,
+                          cDefaultBatchSize);
   mMaxQueueSize.store(max_queue_sz, std::memory_order_relaxed);
+  mBatchSize.store(batch_sz, std::memory_order_relaxed);
 }
 
 //------------------------------------------------------------------------------
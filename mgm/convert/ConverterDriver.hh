@@ -29,6 +29,7 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/config/GlobalConfigStore.hh"
 #include "mgm/convert/ConversionJob.hh"
+#include "mgm/convert/ConversionThroughput.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
@@ -41,6 +42,7 @@ class ConversionJob;
 enum class ConversionJobStatus;
 static const std::string kConverterMaxThreads {"converter-max-threads"};
 static const std::string kConverterMaxQueueSize {"converter-max-queuesize"};
+static const std::string kConverterBatchSize {"converter-batch-size"};
 //------------------------------------------------------------------------------
 //! @brief Class running the conversion threadpool
 //------------------------------------------------------------------------------
@@ -60,7 +62,8 @@ public:
     mThreadPool(std::thread::hardware_concurrency(), cDefaultMaxThreadPoolSize,
                 10, 5, 3, "converter"),
     mMaxThreadPoolSize(cDefaultMaxThreadPoolSize),
-    mMaxQueueSize(cDefaultMaxQueueSize), mTimestamp(),
+    mMaxQueueSize(cDefaultMaxQueueSize), mBatchSize(cDefaultBatchSize),
+    mTimestamp(),
     mObserverMgr(std::make_unique<ObserverT>(4)),
     mConfigStore(std::make_unique<GlobalConfigStore>(&FsView::gFsView))
   {}
@@ -151,6 +154,22 @@ public:
     return mMaxQueueSize.load();
   }
 
+  //----------------------------------------------------------------------------
+  //! Get max number of conversions per batch
+  //----------------------------------------------------------------------------
+  inline uint32_t GetBatchSize() const
+  {
+    return mBatchSize.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get conversion throughput statistics
+  //----------------------------------------------------------------------------
+  inline ConversionThroughput::Stats GetThroughput()
+  {
+    return mThroughput.GetStats();
+  }
+
   //----------------------------------------------------------------------------
   //! Set maximum size of the converter thread pool
   //!
@@ -174,6 +193,17 @@ public:
     mConfigStore->save(kConverterMaxQueueSize, std::to_string(max));
   }
 
+  //----------------------------------------------------------------------------
+  //! Set maximum number of small file conversions grouped in a batch
+  //!
+  //! @param max maximum batch size, 1 disables batching
+  //----------------------------------------------------------------------------
+  inline void SetBatchSize(uint32_t max)
+  {
+    mBatchSize = max;
+    mConfigStore->save(kConverterBatchSize, std::to_string(max));
+  }
+
   //----------------------------------------------------------------------------
   //! Get list of pending jobs
   //!
@@ -333,6 +363,25 @@ private:
   //----------------------------------------------------------------------------
   void SubmitQdbPending(ThreadAssistant& assistant);
 
+  //----------------------------------------------------------------------------
+  //! Get number of jobs to collect before submitting them so that similar
+  //! small file conversions can be grouped in batches
+  //----------------------------------------------------------------------------
+  inline size_t GetSubmitWindow() const
+  {
+    unsigned int batch_size = mBatchSize.load();
+    return ((batch_size > 1) ? cBatchGroupWindow * batch_size : 1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Submit conversion jobs to the thread pool. If batching is enabled, the
+  //! small file conversions with the same source layout and the same target
+  //! are grouped in batches, the rest are executed individually.
+  //!
+  //! @param jobs list of conversion jobs
+  //----------------------------------------------------------------------------
+  void SubmitJobs(std::vector<std::shared_ptr<ConversionJob>>& jobs);
+
   //----------------------------------------------------------------------------
   //! Observer job called when a conversion is done taking care of deleting
   //! the "proc" entry and updating the tracking information
@@ -349,6 +398,10 @@ private:
   static constexpr unsigned int cDefaultMaxThreadPoolSize{100};
   //! Max queue size from the thread pool when we delay new jobs
   static constexpr unsigned int cDefaultMaxQueueSize{1000};
+  //! Default max number of conversions per batch, 1 means no batching
+  static constexpr unsigned int cDefaultBatchSize{1};
+  //! Number of batches worth of jobs collected before grouping them
+  static constexpr unsigned int cBatchGroupWindow{4};
 
   AssistedThread mThread; ///< Thread controller object
   QdbHelper mQdbHelper; ///< QuarkDB helper object
@@ -356,6 +409,7 @@ private:
   eos::common::ThreadPool mThreadPool; ///< Thread pool for conversion jobs
   std::atomic<unsigned int> mMaxThreadPoolSize; ///< Max threadpool size
   std::atomic<unsigned int> mMaxQueueSize; ///< Max submitted queue size
+  std::atomic<unsigned int> mBatchSize; ///< Max conversions per batch
   //! Timestamp of last jobs request
   std::chrono::steady_clock::time_point mTimestamp;
   //! Collection of running conversion jobs
@@ -366,6 +420,7 @@ private:
   eos::common::ConcurrentQueue<JobInfoT> mPendingJobs;
   std::unique_ptr<ObserverT> mObserverMgr;
   std::unique_ptr<common::ConfigStore> mConfigStore;
+  ConversionThroughput mThroughput; ///< Conversion throughput tracker
 
 };
 
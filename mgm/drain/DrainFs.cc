@@ -22,6 +22,7 @@
 
 #include "mgm/drain/DrainFs.hh"
 #include "mgm/drain/DrainTransferJob.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/FsView.hh"
 #include "common/table_formatter/TableFormatterBase.hh"
@@ -40,11 +41,12 @@ constexpr std::chrono::seconds DrainFs::sStallTimeout;
 //------------------------------------------------------------------------------
 DrainFs::DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
                  eos::common::FileSystem::fsid_t src_fsid,
-                 eos::common::FileSystem::fsid_t dst_fsid):
+                 eos::common::FileSystem::fsid_t dst_fsid,
+                 DrainScheduler* scheduler):
   mNsFsView(fs_view), mFsId(src_fsid), mTargetFsId(dst_fsid),
   mStatus(eos::common::DrainStatus::kNoDrain), mDidRerun(false),
   mDrainStop(false), mMaxJobs(10), mDrainPeriod(0), mThreadPool(thread_pool),
-  mTotalFiles(0ull), mPending(0ull), mLastPending(0ull),
+  mScheduler(scheduler), mTotalFiles(0ull), mPending(0ull), mLastPending(0ull),
   mLastProgressTime(steady_clock::now()),
   mLastUpdateTime(steady_clock::now())
 {}
@@ -56,6 +58,10 @@ DrainFs::~DrainFs()
 {
   eos_static_debug("msg=\"fsid=%u destroying fs drain object", mFsId);
   ResetCounters();
+
+  if (mScheduler) {
+    mScheduler->ForgetDrain(mFsId);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -108,6 +114,7 @@ DrainFs::DoIt()
   }
 
   State state = State::Running;
+  const DrainScheduler::Endpoint src {mFsId, mNode};
 
   // Loop to drain the files
   while (!mDrainStop && (state != State::Done) && (state != State::Failed)) {
@@ -116,13 +123,32 @@ DrainFs::DoIt()
 
     for (auto it_fid = mNsFsView->getStreamingFileList(mFsId);
          it_fid && it_fid->valid(); /* no progress */) {
-      if (NumRunningJobs() <= mMaxJobs) {
+      bool submit = (NumRunningJobs() <= mMaxJobs);
+
+      if (!submit) {
+        std::this_thread::sleep_for(seconds(1));
+      } else if (mScheduler) {
+        // Submit only once the drained disk and its node have a free slot so
+        // that the workers never wait for one
+        submit = mScheduler->WaitSource(src, seconds(1));
+      }
+
+      if (submit) {
         std::shared_ptr<DrainTransferJob> job {
           new DrainTransferJob(it_fid->getElement(), mFsId, mTargetFsId)};
 
+        if (mScheduler) {
+          job->SetScheduler(mScheduler, src);
+        }
+
         if (!gOFS->mFidTracker.AddEntry(it_fid->getElement(), TrackerType::Drain)) {
           job->ReportError(SSTR("msg=\"skip currently scheduled drain\" "
                                 "fxid=" << std::hex << it_fid->getElement()));
+
+          if (mScheduler) {
+            mScheduler->Release(src, {}, mFsId, false, 0);
+          }
+
           eos::common::RWMutexWriteLock wr_lock(mJobsMutex);
           mJobsFailed.insert(job);
         } else {
@@ -142,8 +168,6 @@ DrainFs::DoIt()
         // Advance to the next file id to be drained
         it_fid->next();
         --mPending;
-      } else {
-        std::this_thread::sleep_for(seconds(1));
       }
 
       state = UpdateProgress();
@@ -222,6 +246,7 @@ DrainFs::SuccessfulDrain()
     batch.setLongLongLocal("local.drain.timeleft", 0);
     batch.setLongLongLocal("local.drain.failed", 0);
     batch.setLongLongLocal("local.drain.files", 0);
+    batch.setLongLongLocal("local.drain.eta", 0);
 
     if (!gOFS->Shutdown) {
       // If drain done and the system is not shutting down then set the
@@ -325,6 +350,7 @@ DrainFs::PrepareFs()
     eos::common::FileSystem::fs_snapshot_t drain_snapshot;
     fs->SnapShotFileSystem(drain_snapshot, false);
     space_name = drain_snapshot.mSpace;
+    mNode = drain_snapshot.mHostPort;
   }
   mDrainStart = steady_clock::now();
   mDrainEnd = mDrainStart + mDrainPeriod;
@@ -373,6 +399,12 @@ DrainFs::PrepareFs()
   batch.setLongLongLocal("local.drain.bytesleft",
                          fs->GetLongLong("stat.statfs.usedbytes"));
   fs->applyBatch(batch);
+
+  if (mScheduler) {
+    // Start sampling the drain throughput
+    (void) mScheduler->GetDrainStats(mFsId);
+  }
+
   return true;
 }
 
@@ -455,12 +487,19 @@ DrainFs::UpdateProgress()
       time_left = duration_cast<seconds>(mDrainEnd - now).count();
     }
 
+    const uint64_t bytes_left = fs->GetLongLong("stat.statfs.usedbytes");
     batch.setLongLongLocal("local.drain.failed", NumFailedJobs());
     batch.setLongLongLocal("local.drain.files", mPending);
     batch.setLongLongLocal("local.drain.progress", progress);
     batch.setLongLongLocal("local.drain.timeleft", time_left);
-    batch.setLongLongLocal("local.drain.bytesleft",
-                           fs->GetLongLong("stat.statfs.usedbytes"));
+    batch.setLongLongLocal("local.drain.bytesleft", bytes_left);
+
+    if (mScheduler) {
+      batch.setLongLongLocal("local.drain.rate",
+                             mScheduler->GetDrainStats(mFsId).mRate);
+      batch.setLongLongLocal("local.drain.eta",
+                             mScheduler->GetEta(mFsId, bytes_left));
+    }
     fs->applyBatch(batch);
     eos_static_debug("msg=\"fsid=%d, update progress", mFsId);
   }
@@ -521,6 +560,8 @@ DrainFs::ResetCounters()
     batch.setLongLongLocal("local.drain.files", 0);
     batch.setLongLongLocal("local.drain.timeleft", 0);
     batch.setLongLongLocal("local.drain.progress", 0);
+    batch.setLongLongLocal("local.drain.rate", 0);
+    batch.setLongLongLocal("local.drain.eta", 0);
     batch.setDrainStatusLocal(eos::common::DrainStatus::kNoDrain);
     fs->applyBatch(batch);
   }
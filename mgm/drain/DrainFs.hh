@@ -41,6 +41,7 @@ class ThreadPool;
 EOSMGMNAMESPACE_BEGIN
 
 class DrainTransferJob;
+class DrainScheduler;
 class TableFormatterBase;
 
 //------------------------------------------------------------------------------
@@ -61,10 +62,12 @@ public:
   //! @param fs_view file system view
   //! @param src_fsid filesystem id to drain
   //! @param dst_fsid file system where to drain
+  //! @param scheduler scheduler shared by all drains, can be null
   //----------------------------------------------------------------------------
   DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
           eos::common::FileSystem::fsid_t src_fsid,
-          eos::common::FileSystem::fsid_t dst_fsid = 0);
+          eos::common::FileSystem::fsid_t dst_fsid = 0,
+          DrainScheduler* scheduler = nullptr);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -245,6 +248,8 @@ private:
       std::shared_ptr<DrainTransferJob>> mJobsRunning;
   mutable eos::common::RWMutex mJobsMutex; ///< RW mutex protecting job lists
   eos::common::ThreadPool& mThreadPool;
+  DrainScheduler* mScheduler; ///< Transfer scheduler shared by all drains
+  std::string mNode; ///< Node hosting the drained file system
   std::future<State> mFuture;
   uint64_t mTotalFiles; ///< Total number of files to drain
   uint64_t mPending; ///< Current num. of pending files to drain
@@ -0,0 +1,360 @@
+//------------------------------------------------------------------------------
+//! @file DrainScheduler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/drain/DrainScheduler.hh"
+#include <algorithm>
+
+EOSMGMNAMESPACE_BEGIN
+
+using namespace std::chrono;
+constexpr std::chrono::seconds DrainScheduler::sRateWindow;
+
+//------------------------------------------------------------------------------
+// Update scheduling budgets
+//------------------------------------------------------------------------------
+void
+DrainScheduler::SetBudget(const Budget& budget)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mBudget = budget;
+
+  for (auto& elem : mFsLoad) {
+    elem.second.mBw.Configure(mBudget.mFsRate, 0);
+  }
+
+  for (auto& elem : mNodeLoad) {
+    elem.second.mBw.Configure(mBudget.mNodeRate, 0);
+  }
+
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Get current scheduling budgets
+//------------------------------------------------------------------------------
+DrainScheduler::Budget
+DrainScheduler::GetBudget() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mBudget;
+}
+
+//------------------------------------------------------------------------------
+// Order the given candidates by their current load
+//------------------------------------------------------------------------------
+std::vector<DrainScheduler::Endpoint>
+DrainScheduler::Rank(const std::vector<Endpoint>& candidates)
+{
+  std::vector<std::pair<RankT, Endpoint>> ranked;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto now = mClock.getTime();
+
+    for (const auto& ep : candidates) {
+      ranked.emplace_back(GetRank(ep, now), ep);
+    }
+  }
+  std::stable_sort(ranked.begin(), ranked.end(),
+                   [](const std::pair<RankT, Endpoint>& a,
+  const std::pair<RankT, Endpoint>& b) {
+    return a.first < b.first;
+  });
+  std::vector<Endpoint> result;
+  result.reserve(ranked.size());
+
+  for (auto& elem : ranked) {
+    result.push_back(std::move(elem.second));
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Try to reserve a transfer slot between the given endpoints
+//------------------------------------------------------------------------------
+bool
+DrainScheduler::TryAcquire(const Endpoint& src, const Endpoint& dst)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto now = mClock.getTime();
+
+  if (!HasCapacity(src, now) ||
+      !HasCapacity(dst, now, (src.mNode == dst.mNode) ? 1 : 0)) {
+    return false;
+  }
+
+  ++GetFs(src.mFsid, now).mRunning;
+  ++GetFs(dst.mFsid, now).mRunning;
+  ++GetNode(src.mNode, now).mRunning;
+  ++GetNode(dst.mNode, now).mRunning;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Wait until the source endpoint can take one more transfer and reserve it
+//------------------------------------------------------------------------------
+bool
+DrainScheduler::WaitSource(const Endpoint& src, milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto deadline = steady_clock::now() + timeout;
+
+  while (!HasCapacity(src, mClock.getTime())) {
+    // Bandwidth debt is paid back over time without any notification, the
+    // caller retries after the timeout
+    if (mCond.wait_until(lock, deadline) == std::cv_status::timeout) {
+      return false;
+    }
+  }
+
+  auto now = mClock.getTime();
+  ++GetFs(src.mFsid, now).mRunning;
+  ++GetNode(src.mNode, now).mRunning;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Pick and reserve the destination of a transfer
+//------------------------------------------------------------------------------
+DrainScheduler::Endpoint
+DrainScheduler::AcquireDst(const std::vector<Endpoint>& candidates)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto now = mClock.getTime();
+  const Endpoint* best = nullptr;
+  RankT best_rank;
+
+  for (const auto& ep : candidates) {
+    RankT rank = GetRank(ep, now);
+
+    if ((best == nullptr) || (rank < best_rank)) {
+      best = &ep;
+      best_rank = rank;
+    }
+  }
+
+  if (best == nullptr) {
+    return Endpoint();
+  }
+
+  ++GetFs(best->mFsid, now).mRunning;
+  ++GetNode(best->mNode, now).mRunning;
+  return *best;
+}
+
+//------------------------------------------------------------------------------
+// Release a transfer slot and account the data moved
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Release(const Endpoint& src, const Endpoint& dst,
+                        fsid_t drain_fsid, bool success, uint64_t bytes)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto now = mClock.getTime();
+  std::vector<Load*> loads {&GetFs(src.mFsid, now), &GetNode(src.mNode, now)};
+
+  if (dst.mFsid) {
+    loads.push_back(&GetFs(dst.mFsid, now));
+    loads.push_back(&GetNode(dst.mNode, now));
+  }
+
+  for (Load* load : loads) {
+    if (load->mRunning) {
+      --load->mRunning;
+    }
+
+    if (bytes) {
+      load->mBw.Consume(now, bytes);
+    }
+  }
+
+  mCond.notify_all();
+
+  if (success) {
+    auto& tracker = mDrains[drain_fsid];
+    ++tracker.mStats.mFiles;
+    tracker.mStats.mBytes += bytes;
+    tracker.mWindowBytes += bytes;
+    UpdateRate(tracker, now);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get throughput statistics of a draining file system
+//------------------------------------------------------------------------------
+DrainScheduler::DrainStats
+DrainScheduler::GetDrainStats(fsid_t drain_fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  // The first call starts tracking the given file system
+  auto& tracker = mDrains[drain_fsid];
+  UpdateRate(tracker, mClock.getTime());
+  return tracker.mStats;
+}
+
+//------------------------------------------------------------------------------
+// Estimate the remaining drain time
+//------------------------------------------------------------------------------
+int64_t
+DrainScheduler::GetEta(fsid_t drain_fsid, uint64_t bytes_left)
+{
+  DrainStats stats = GetDrainStats(drain_fsid);
+
+  if (stats.mRate < 1.0) {
+    return -1;
+  }
+
+  return (int64_t)(bytes_left / stats.mRate);
+}
+
+//------------------------------------------------------------------------------
+// Drop the statistics of a file system which is no longer draining
+//------------------------------------------------------------------------------
+void
+DrainScheduler::ForgetDrain(fsid_t drain_fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDrains.erase(drain_fsid);
+}
+
+//------------------------------------------------------------------------------
+// Get number of running transfers involving the given disk
+//------------------------------------------------------------------------------
+uint32_t
+DrainScheduler::GetFsLoad(fsid_t fsid) const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mFsLoad.find(fsid);
+  return ((it == mFsLoad.end()) ? 0 : it->second.mRunning);
+}
+
+//------------------------------------------------------------------------------
+// Get number of running transfers involving the given node
+//------------------------------------------------------------------------------
+uint32_t
+DrainScheduler::GetNodeLoad(const std::string& node) const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodeLoad.find(node);
+  return ((it == mNodeLoad.end()) ? 0 : it->second.mRunning);
+}
+
+//------------------------------------------------------------------------------
+// Get load object for the given disk
+//------------------------------------------------------------------------------
+DrainScheduler::Load&
+DrainScheduler::GetFs(fsid_t fsid, steady_clock::time_point now)
+{
+  auto it = mFsLoad.find(fsid);
+
+  if (it == mFsLoad.end()) {
+    it = mFsLoad.emplace(fsid, Load()).first;
+    it->second.mBw = eos::common::TokenBucket(mBudget.mFsRate, 0, now);
+  }
+
+  return it->second;
+}
+
+//------------------------------------------------------------------------------
+// Get load object for the given node
+//------------------------------------------------------------------------------
+DrainScheduler::Load&
+DrainScheduler::GetNode(const std::string& node, steady_clock::time_point now)
+{
+  auto it = mNodeLoad.find(node);
+
+  if (it == mNodeLoad.end()) {
+    it = mNodeLoad.emplace(node, Load()).first;
+    it->second.mBw = eos::common::TokenBucket(mBudget.mNodeRate, 0, now);
+  }
+
+  return it->second;
+}
+
+//------------------------------------------------------------------------------
+// Check if the given endpoint can take one more transfer
+//------------------------------------------------------------------------------
+bool
+DrainScheduler::HasCapacity(const Endpoint& ep, steady_clock::time_point now,
+                            uint32_t extra_node)
+{
+  Load& fs = GetFs(ep.mFsid, now);
+
+  if ((mBudget.mFsSlots && (fs.mRunning >= mBudget.mFsSlots)) ||
+      !fs.mBw.CanConsume(now, 1)) {
+    return false;
+  }
+
+  Load& node = GetNode(ep.mNode, now);
+
+  if ((mBudget.mNodeSlots &&
+       (node.mRunning + extra_node >= mBudget.mNodeSlots)) ||
+      !node.mBw.CanConsume(now, 1)) {
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the rank of an endpoint
+//------------------------------------------------------------------------------
+DrainScheduler::RankT
+DrainScheduler::GetRank(const Endpoint& ep, steady_clock::time_point now)
+{
+  bool full = !HasCapacity(ep, now);
+  return RankT(full, GetFs(ep.mFsid, now).mRunning,
+               GetNode(ep.mNode, now).mRunning);
+}
+
+//------------------------------------------------------------------------------
+// Fold the current sampling window into the smoothed drain rate
+//------------------------------------------------------------------------------
+void
+DrainScheduler::UpdateRate(DrainTracker& tracker, steady_clock::time_point now)
+{
+  if (!tracker.mStarted) {
+    tracker.mStarted = true;
+    tracker.mWindowStart = now;
+    return;
+  }
+
+  auto elapsed = duration_cast<milliseconds>(now - tracker.mWindowStart);
+
+  if (elapsed < sRateWindow) {
+    return;
+  }
+
+  double sample = 1000.0 * tracker.mWindowBytes / elapsed.count();
+
+  if (tracker.mStats.mRate == 0) {
+    tracker.mStats.mRate = sample;
+  } else {
+    // Exponential smoothing to avoid jumps in the reported ETA
+    tracker.mStats.mRate = 0.7 * tracker.mStats.mRate + 0.3 * sample;
+  }
+
+  tracker.mWindowBytes = 0;
+  tracker.mWindowStart = now;
+}
+
+EOSMGMNAMESPACE_END
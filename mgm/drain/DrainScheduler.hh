@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------------
+//! @file DrainScheduler.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include "common/RateLimit.hh"
+#include "common/SteadyClock.hh"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Scheduler shared by all the ongoing file system drains. Every drain
+//! transfer reserves a slot on its source disk, its destination disk and on
+//! the nodes hosting them. Slots and bandwidth are limited per disk and per
+//! node so that the drains of a full node are spread over all the available
+//! destinations instead of saturating a few of them. The source slot gates
+//! the submission of the drain jobs, the destination is picked once the job
+//! runs among the candidates of the placement.
+//! Bandwidth is enforced with token buckets charged with the amount of data
+//! moved by each finished transfer - new transfers are admitted only while
+//! the buckets are not in debt. The scheduler also tracks the throughput per
+//! draining file system which is used to estimate the remaining drain time.
+//------------------------------------------------------------------------------
+class DrainScheduler
+{
+public:
+  using fsid_t = eos::common::FileSystem::fsid_t;
+
+  //----------------------------------------------------------------------------
+  //! Transfer endpoint i.e. a disk and the node hosting it
+  //----------------------------------------------------------------------------
+  struct Endpoint {
+    fsid_t mFsid {0};
+    std::string mNode;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Scheduling budgets, 0 means unlimited
+  //----------------------------------------------------------------------------
+  struct Budget {
+    uint32_t mFsSlots {0}; ///< Max transfers per disk (source or destination)
+    uint32_t mNodeSlots {0}; ///< Max transfers per node (in or out)
+    uint64_t mFsRate {0}; ///< Max bandwidth per disk in bytes/s
+    uint64_t mNodeRate {0}; ///< Max bandwidth per node in bytes/s
+  };
+
+  //----------------------------------------------------------------------------
+  //! Throughput statistics of a draining file system
+  //----------------------------------------------------------------------------
+  struct DrainStats {
+    uint64_t mFiles {0}; ///< Number of files moved
+    uint64_t mBytes {0}; ///< Number of bytes moved
+    double mRate {0}; ///< Smoothed throughput in bytes/s
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fake_clock if true use a fake clock, used for testing
+  //----------------------------------------------------------------------------
+  DrainScheduler(bool fake_clock = false):
+    mClock(fake_clock)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Update scheduling budgets
+  //!
+  //! @param budget new budgets
+  //----------------------------------------------------------------------------
+  void SetBudget(const Budget& budget);
+
+  //----------------------------------------------------------------------------
+  //! Get current scheduling budgets
+  //----------------------------------------------------------------------------
+  Budget GetBudget() const;
+
+  //----------------------------------------------------------------------------
+  //! Order the given candidates by their current load, the least loaded
+  //! first. Candidates which are over their budget are moved at the end.
+  //!
+  //! @param candidates list of candidate endpoints
+  //!
+  //! @return ordered list of endpoints
+  //----------------------------------------------------------------------------
+  std::vector<Endpoint> Rank(const std::vector<Endpoint>& candidates);
+
+  //----------------------------------------------------------------------------
+  //! Try to reserve a transfer slot between the given endpoints. Either all
+  //! the slots on the disks and nodes involved are reserved or none.
+  //!
+  //! @param src source endpoint
+  //! @param dst destination endpoint
+  //!
+  //! @return true if reserved, otherwise false
+  //----------------------------------------------------------------------------
+  bool TryAcquire(const Endpoint& src, const Endpoint& dst);
+
+  //----------------------------------------------------------------------------
+  //! Wait until the source endpoint can take one more transfer and reserve
+  //! its source slot. The waiters are woken up whenever a slot is released.
+  //!
+  //! @param src source endpoint
+  //! @param timeout maximum time to wait
+  //!
+  //! @return true if reserved, false if timed out
+  //----------------------------------------------------------------------------
+  bool WaitSource(const Endpoint& src, std::chrono::milliseconds timeout);
+
+  //----------------------------------------------------------------------------
+  //! Pick the destination of a transfer whose source slot is already
+  //! reserved and reserve its slot. The least loaded candidate is picked,
+  //! if all of them are over their budget the least loaded one still takes
+  //! the transfer since the job already runs.
+  //!
+  //! @param candidates list of candidate endpoints, not empty
+  //!
+  //! @return destination endpoint
+  //----------------------------------------------------------------------------
+  Endpoint AcquireDst(const std::vector<Endpoint>& candidates);
+
+  //----------------------------------------------------------------------------
+  //! Release a transfer slot previously reserved and account the data moved
+  //!
+  //! @param src source endpoint
+  //! @param dst destination endpoint, fsid 0 if no destination was reserved
+  //! @param drain_fsid draining file system on whose behalf the transfer ran
+  //! @param success true if the transfer was successful
+  //! @param bytes amount of data moved
+  //----------------------------------------------------------------------------
+  void Release(const Endpoint& src, const Endpoint& dst, fsid_t drain_fsid,
+               bool success, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Get throughput statistics of a draining file system. The first call
+  //! starts the throughput sampling for the given file system.
+  //!
+  //! @param drain_fsid draining file system
+  //!
+  //! @return drain statistics
+  //----------------------------------------------------------------------------
+  DrainStats GetDrainStats(fsid_t drain_fsid);
+
+  //----------------------------------------------------------------------------
+  //! Estimate the remaining drain time based on the current throughput
+  //!
+  //! @param drain_fsid draining file system
+  //! @param bytes_left bytes still to be drained
+  //!
+  //! @return estimated seconds, -1 if no estimate is available yet
+  //----------------------------------------------------------------------------
+  int64_t GetEta(fsid_t drain_fsid, uint64_t bytes_left);
+
+  //----------------------------------------------------------------------------
+  //! Drop the statistics of a file system which is no longer draining
+  //!
+  //! @param drain_fsid draining file system
+  //----------------------------------------------------------------------------
+  void ForgetDrain(fsid_t drain_fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get number of running transfers involving the given disk
+  //----------------------------------------------------------------------------
+  uint32_t GetFsLoad(fsid_t fsid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of running transfers involving the given node
+  //----------------------------------------------------------------------------
+  uint32_t GetNodeLoad(const std::string& node) const;
+
+  //----------------------------------------------------------------------------
+  //! Get clock reference for testing purposes
+  //----------------------------------------------------------------------------
+  inline eos::common::SteadyClock& GetClock()
+  {
+    return mClock;
+  }
+
+private:
+#ifdef IN_TEST_HARNESS
+public:
+#endif
+  //! Window over which the drain throughput is sampled
+  static constexpr std::chrono::seconds sRateWindow {10};
+
+  //! Rank of an endpoint: over budget, disk load and node load
+  using RankT = std::tuple<bool, uint32_t, uint32_t>;
+
+  //----------------------------------------------------------------------------
+  //! Load of a disk or a node
+  //----------------------------------------------------------------------------
+  struct Load {
+    uint32_t mRunning {0}; ///< Number of running transfers
+    eos::common::TokenBucket mBw; ///< Bandwidth budget
+  };
+
+  //----------------------------------------------------------------------------
+  //! Throughput tracking of a draining file system
+  //----------------------------------------------------------------------------
+  struct DrainTracker {
+    DrainStats mStats;
+    bool mStarted {false}; ///< Mark if sampling started
+    uint64_t mWindowBytes {0}; ///< Bytes moved in the current window
+    std::chrono::steady_clock::time_point mWindowStart;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get load object for the given disk, creating it if needed. Must be called
+  //! with the mutex locked.
+  //----------------------------------------------------------------------------
+  Load& GetFs(fsid_t fsid, std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Get load object for the given node, creating it if needed. Must be
+  //! called with the mutex locked.
+  //----------------------------------------------------------------------------
+  Load& GetNode(const std::string& node,
+                std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Check if the given endpoint can take one more transfer. Must be called
+  //! with the mutex locked.
+  //!
+  //! @param ep endpoint
+  //! @param now current time point
+  //! @param extra_node number of transfers already counted on the node for
+  //!        the current request
+  //----------------------------------------------------------------------------
+  bool HasCapacity(const Endpoint& ep, std::chrono::steady_clock::time_point now,
+                   uint32_t extra_node = 0);
+
+  //----------------------------------------------------------------------------
+  //! Get the rank of an endpoint, lower is better. Must be called with the
+  //! mutex locked.
+  //----------------------------------------------------------------------------
+  RankT GetRank(const Endpoint& ep, std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Fold the current sampling window into the smoothed drain rate. Must be
+  //! called with the mutex locked.
+  //----------------------------------------------------------------------------
+  void UpdateRate(DrainTracker& tracker,
+                  std::chrono::steady_clock::time_point now);
+
+  mutable std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mCond; ///< Notified when slots are released
+  Budget mBudget; ///< Scheduling budgets
+  std::map<fsid_t, Load> mFsLoad; ///< Load per disk
+  std::map<std::string, Load> mNodeLoad; ///< Load per node
+  std::map<fsid_t, DrainTracker> mDrains; ///< Throughput per draining fs
+  eos::common::SteadyClock mClock; ///< Clock, can be faked for testing
+};
+
+EOSMGMNAMESPACE_END
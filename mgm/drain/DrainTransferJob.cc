@@ -36,6 +36,31 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+namespace
+{
+//! Number of destination candidates requested from the placement when
+//! scheduling through the drain scheduler
+constexpr unsigned int sNumDstCandidates = 3;
+
+//------------------------------------------------------------------------------
+// Get the node hosting the given file system
+//
+// @note must be called with a read lock on the FsView::ViewMutex
+//------------------------------------------------------------------------------
+std::string GetFsNode(eos::common::FileSystem::fsid_t fsid)
+{
+  FileSystem* fs = FsView::gFsView.mIdView.lookupByID(fsid);
+
+  if (fs == nullptr) {
+    return std::string();
+  }
+
+  eos::common::FileSystem::fs_snapshot_t snapshot;
+  fs->SnapShotFileSystem(snapshot, false);
+  return snapshot.mHostPort;
+}
+}
+
 //------------------------------------------------------------------------------
 // Save error message and set the status accordingly
 //------------------------------------------------------------------------------
@@ -51,6 +76,17 @@ void DrainTransferJob::ReportError(const std::string& error)
 //------------------------------------------------------------------------------
 void
 DrainTransferJob::DoIt() noexcept
+{
+  RunTransfer();
+  // Release the slot of a transfer which failed or never started
+  ReleaseSlot(false, 0);
+}
+
+//------------------------------------------------------------------------------
+// Execute the third-party transfer
+//------------------------------------------------------------------------------
+void
+DrainTransferJob::RunTransfer()
 {
   using eos::common::LayoutId;
   eos_static_info("msg=\"running job\" fsid_src=%i fsid_dst=%i fxid=%08llx",
@@ -86,6 +122,12 @@ DrainTransferJob::DoIt() noexcept
       return;
     }
 
+    if (mHasSlot && (mSlotDst.mFsid == 0)) {
+      // Destination given by the caller, reserve its slot
+      eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+      (void) ReserveDst({mFsIdTarget});
+    }
+
     // Special case when deadling with 0-size replica files
     if ((fdrain.mProto.size() == 0) &&
         (LayoutId::GetLayoutType(fdrain.mProto.layout_id()) ==
@@ -162,6 +204,7 @@ DrainTransferJob::DoIt() noexcept
       } else {
         eos_info("msg=\"%s successful\" logid=%s fxid=%s", mAppTag.c_str(),
                  log_id.c_str(), eos::common::FileId::Fid2Hex(mFileId).c_str());
+        ReleaseSlot(true, fdrain.mProto.size());
         mStatus = Status::OK;
         return;
       }
@@ -235,7 +278,15 @@ DrainTransferJob::BuildTpcSrc(const FileDrainInfo& fdrain,
     bool found = false;
 
     if (!mBalanceMode) {
-      for (const auto id : fdrain.mProto.locations()) {
+      std::vector<eos::common::FileSystem::fsid_t> replicas
+      (fdrain.mProto.locations().begin(), fdrain.mProto.locations().end());
+      {
+        // Prefer the replicas on the least loaded disks
+        eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+        RankByLoad(replicas);
+      }
+
+      for (const auto id : replicas) {
         // First try copying from a location different from the current source
         // file system. Make sure we also skip any EOS_TAPE_FSID (65535)
         // replicas.
@@ -575,6 +626,11 @@ DrainTransferJob::SelectDstFs(const FileDrainInfo& fdrain)
     return false;
   }
 
+  // With a scheduler ask for more candidates and pick the least loaded one
+  if (mScheduler) {
+    nfilesystems = sNumDstCandidates;
+  }
+
   bool res = gOFS->mGeoTreeEngine->placeNewReplicasOneGroup(
                group, nfilesystems,
                &new_repl,
@@ -593,6 +649,16 @@ DrainTransferJob::SelectDstFs(const FileDrainInfo& fdrain)
                &mExcludeDsts,
                &fsid_geotags); // excludeGeoTags
 
+  if ((!res || new_repl.empty()) && (nfilesystems > 1)) {
+    // Not enough candidates in the group, fall back to a single one
+    new_repl.clear();
+    res = gOFS->mGeoTreeEngine->placeNewReplicasOneGroup(
+            group, 1, &new_repl, (ino64_t) fdrain.mProto.id(), NULL, NULL,
+            GeoTreeEngine::draining, &existing_repl, &fsid_geotags,
+            fdrain.mProto.size(), "", "", ncollocatedfs, &mExcludeDsts,
+            &fsid_geotags);
+  }
+
   if (!res || new_repl.empty())  {
     eos_err("msg=\"fxid=%08llx could not place new replica\"", mFileId.load());
     return false;
@@ -604,14 +670,71 @@ DrainTransferJob::SelectDstFs(const FileDrainInfo& fdrain)
     oss << " " << (unsigned long)(elem);
   }
 
-  // Return only one fs now
-  mFsIdTarget = new_repl[0];
+  // Return only one fs now, with a scheduler the least loaded one
+  mFsIdTarget = ReserveDst(new_repl);
   mExcludeDsts.push_back(mFsIdTarget);
   eos_static_debug("msg=\"schedule placement retc=%d with fsids=%s\" ",
                    (int)res, oss.str().c_str());
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Order the given replica file systems by their current drain load
+//------------------------------------------------------------------------------
+void
+DrainTransferJob::RankByLoad(std::vector<eos::common::FileSystem::fsid_t>&
+                             fsids) const
+{
+  if ((mScheduler == nullptr) || (fsids.size() < 2)) {
+    return;
+  }
+
+  std::vector<DrainScheduler::Endpoint> candidates;
+
+  for (const auto& fsid : fsids) {
+    candidates.push_back({fsid, GetFsNode(fsid)});
+  }
+
+  fsids.clear();
+
+  for (const auto& ep : mScheduler->Rank(candidates)) {
+    fsids.push_back(ep.mFsid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Pick the destination among the given candidates and reserve its slot
+//------------------------------------------------------------------------------
+eos::common::FileSystem::fsid_t
+DrainTransferJob::ReserveDst(const std::vector<eos::common::FileSystem::fsid_t>&
+                             fsids)
+{
+  if (!mHasSlot) {
+    return fsids.front();
+  }
+
+  std::vector<DrainScheduler::Endpoint> candidates;
+
+  for (const auto& fsid : fsids) {
+    candidates.push_back({fsid, GetFsNode(fsid)});
+  }
+
+  mSlotDst = mScheduler->AcquireDst(candidates);
+  return mSlotDst.mFsid;
+}
+
+//------------------------------------------------------------------------------
+// Release the slot held by the job
+//------------------------------------------------------------------------------
+void
+DrainTransferJob::ReleaseSlot(bool success, uint64_t bytes)
+{
+  if (mHasSlot) {
+    mHasSlot = false;
+    mScheduler->Release(mSlotSrc, mSlotDst, mFsIdSource, success, bytes);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Drain 0-size file
 //------------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include "common/FileId.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
@@ -226,6 +227,24 @@ public:
     return mFileId.load();
   }
 
+  //----------------------------------------------------------------------------
+  //! Set scheduler used to pick the source and destination file systems. The
+  //! caller already reserved the source slot of the job, the destination
+  //! slot is reserved once the destination is picked and both are released
+  //! when the job finishes. Without a scheduler the transfer starts right
+  //! away.
+  //!
+  //! @param scheduler drain scheduler object
+  //! @param src source endpoint reserved for this job
+  //----------------------------------------------------------------------------
+  inline void SetScheduler(DrainScheduler* scheduler,
+                           const DrainScheduler::Endpoint& src)
+  {
+    mScheduler = scheduler;
+    mSlotSrc = src;
+    mHasSlot = true;
+  }
+
 
 #ifdef IN_TEST_HARNESS
 public:
@@ -281,6 +300,43 @@ private:
   //----------------------------------------------------------------------------
   bool SelectDstFs(const FileDrainInfo& fdrain);
 
+  //----------------------------------------------------------------------------
+  //! Order the given replica file systems by their current drain load, the
+  //! least loaded first. No-op if there is no scheduler.
+  //!
+  //! @param fsids list of file system ids
+  //!
+  //! @note must be called with a read lock on the FsView::ViewMutex
+  //----------------------------------------------------------------------------
+  void RankByLoad(std::vector<eos::common::FileSystem::fsid_t>& fsids) const;
+
+  //----------------------------------------------------------------------------
+  //! Pick the destination among the given candidates and reserve its slot.
+  //! Without a scheduler slot the first candidate is picked.
+  //!
+  //! @param fsids list of candidate file system ids, not empty
+  //!
+  //! @return destination file system id
+  //!
+  //! @note must be called with a read lock on the FsView::ViewMutex
+  //----------------------------------------------------------------------------
+  eos::common::FileSystem::fsid_t
+  ReserveDst(const std::vector<eos::common::FileSystem::fsid_t>& fsids);
+
+  //----------------------------------------------------------------------------
+  //! Release the slot held by the job, no-op if no slot is held
+  //!
+  //! @param success true if the transfer was successful
+  //! @param bytes amount of data transferred
+  //----------------------------------------------------------------------------
+  void ReleaseSlot(bool success, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Execute the third-party transfer, the scheduler slot may still be held
+  //! when it returns
+  //----------------------------------------------------------------------------
+  void RunTransfer();
+
   //----------------------------------------------------------------------------
   //! Drain 0-size file
   //!
@@ -310,6 +366,10 @@ private:
   bool mRepairExcluded; ///< Mark if mTriedSrcs should be included in recfs for rain layouts
   DrainProgressHandler mProgressHandler; ///< TPC progress handler
   eos::common::VirtualIdentity mVid; /// VID triggering the job
+  DrainScheduler* mScheduler {nullptr}; ///< Scheduler shared by all drains
+  bool mHasSlot {false}; ///< Mark if a scheduler slot is held
+  DrainScheduler::Endpoint mSlotSrc; ///< Source of the held scheduler slot
+  DrainScheduler::Endpoint mSlotDst; ///< Destination of the held slot if any
 };
 
 EOSMGMNAMESPACE_END
@@ -141,7 +141,7 @@ Drainer::StartFsDrain(eos::mgm::FileSystem* fs,
 
   // Start the drain
   std::shared_ptr<DrainFs> dfs(new DrainFs(mThreadPool, gOFS->eosFsView,
-                               src_fsid, dst_fsid));
+                               src_fsid, dst_fsid, &mScheduler));
   auto future = std::async(std::launch::async, &DrainFs::DoIt, dfs);
   dfs->SetFuture(std::move(future));
   mDrainFs[src_snapshot.mHostPort].emplace(dfs);
@@ -365,6 +365,17 @@ Drainer::UpdateFromSpaceConfig()
   // Update every minute
   if (duration_cast<seconds>(steady_clock::now() - last_update).count() > 60) {
     last_update = std::chrono::steady_clock::now();
+    DrainScheduler::Budget budget;
+    // Use the most restrictive scheduling budget defined in any of the spaces
+    auto update_min = [](auto & value, const std::string & cfg, uint64_t scale) {
+      if (!cfg.empty()) {
+        uint64_t val = strtoull(cfg.c_str(), nullptr, 10) * scale;
+
+        if (val && ((value == 0) || (val < value))) {
+          value = val;
+        }
+      }
+    };
     eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
 
     for (const auto& space : FsView::gFsView.mSpaceView) {
@@ -376,10 +387,20 @@ Drainer::UpdateFromSpaceConfig()
         space.second->SetConfigMember("drainer.node.nfs", "5");
       }
 
+      update_min(budget.mFsSlots,
+                 space.second->GetConfigMember("drainer.disk.slots"), 1);
+      update_min(budget.mNodeSlots,
+                 space.second->GetConfigMember("drainer.node.slots"), 1);
+      update_min(budget.mFsRate,
+                 space.second->GetConfigMember("drainer.disk.bw"), 1024 * 1024);
+      update_min(budget.mNodeRate,
+                 space.second->GetConfigMember("drainer.node.bw"), 1024 * 1024);
       // Set the space configuration
       XrdSysMutexHelper scope_lock(mCfgMutex);
       mCfgMap[space.first] = max_drain_fs;
     }
+
+    mScheduler.SetBudget(budget);
   }
 }
 
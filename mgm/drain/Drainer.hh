@@ -27,6 +27,7 @@
 #include "common/ThreadPool.hh"
 #include "common/AssistedThread.hh"
 #include "common/FileSystem.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include <list>
 
 EOSMGMNAMESPACE_BEGIN
@@ -127,6 +128,16 @@ public:
     return mThreadPool;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get reference to the scheduler shared by all the drain jobs
+  //!
+  //! @return drain scheduler object
+  //----------------------------------------------------------------------------
+  DrainScheduler& GetScheduler()
+  {
+    return mScheduler;
+  }
+
   //----------------------------------------------------------------------------
   //! Get drain jobs info (global or specific to an fsid)
   //!
@@ -183,6 +194,7 @@ private:
   AssistedThread mThread; ///< Thread updating the drain configuration
   //! Contains per space the max allowed fs draining per node
   std::map<std::string, int> mCfgMap;
+  DrainScheduler mScheduler; ///< Transfer scheduler shared by all drains
   DrainMap mDrainFs; ///< Map of nodes to file systems draining
   mutable eos::common::RWMutex mDrainMutex; ///< Mutex protecting the drain map
   mutable XrdSysMutex mCfgMutex; ///< Mutex for drain config updates
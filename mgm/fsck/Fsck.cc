@@ -36,6 +36,7 @@
 #include "namespace/interface/IFsView.hh"
 #include "namespace/Prefetcher.cc"
 #include "qclient/structures/QSet.hh"
+#include "qclient/structures/QHash.hh"
 #include "json/json.h"
 
 EOSMGMNAMESPACE_BEGIN
@@ -47,18 +48,55 @@ const std::string Fsck::sCollectKey {"toggle-collect"};
 const std::string Fsck::sCollectIntervalKey {"collect-interval-min"};
 const std::string Fsck::sRepairKey {"toggle-repair"};
 const std::string Fsck::sRepairCategory {"repair-category"};
+const std::string Fsck::sProgressKey {"fsck:progress"};
 
 using eos::common::FsckErr;
 using eos::common::ConvertToFsckErr;
+
+namespace
+{
+//! Error types handled by the repair thread ordered by their priority
+const std::vector<std::string> sRepairPriority {
+  "stripe_err", "blockxs_err",   "unreg_n",
+  "rep_diff_n", "rep_missing_n", "m_mem_sz_diff",
+  "m_cx_diff",  "d_mem_sz_diff", "d_cx_diff"};
+
+//------------------------------------------------------------------------------
+// Parse fsck info stored in QDB in the form: fid:fsid
+//------------------------------------------------------------------------------
+std::pair<eos::IFileMD::id_t, eos::common::FileSystem::fsid_t>
+ParseFsckElement(const std::string& data)
+{
+  const size_t pos = data.find(':');
+
+  if ((pos == std::string::npos) || (pos == data.length())) {
+    eos_static_err("msg=\"failed to parse fsck element\" data=\"%s\"",
+                   data.c_str());
+    return {0ull, 0ul};
+  }
+
+  eos::IFileMD::id_t fid;
+  eos::common::FileSystem::fsid_t fsid;
+
+  if (!eos::common::StringToNumeric(data.substr(0, pos), fid) ||
+      !eos::common::StringToNumeric(data.substr(pos + 1), fsid)) {
+    eos_static_err("msg=\"failed to convert fsck info\" data=\"%s\"",
+                   data.c_str());
+    return {0ull, 0ul};
+  }
+
+  return {fid, fsid};
+}
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 Fsck::Fsck():
   mShowOffline(false), mShowNoReplica(false), mShowDarkFiles(false),
-  mStartProcessing(false), mCollectEnabled(false), mRepairEnabled(false),
+  mCollectEnabled(false), mRepairEnabled(false),
   mCollectRunning(false), mRepairRunning(false), mRepairCategory(FsckErr::None),
   mCollectInterval(std::chrono::seconds(30 * 60)),
-  eTimeStamp(0),
   mThreadPool(2, mMaxThreadPoolSize, 10, 6, 5, "fsck")
 {}
 
@@ -307,15 +345,11 @@ Fsck::CollectErrs(ThreadAssistant& assistant) noexcept
   while (!assistant.terminationRequested()) {
     Log("Start error collection");
     Log("Filesystems to check: %lu", FsView::gFsView.GetNumFileSystems());
-    decltype(eFsMap) tmp_err_map;
-    QueryQdb(tmp_err_map);
-    {
-      // Swap in the new list of errors and clear the rest
-      eos::common::RWMutexWriteLock wr_lock(mErrMutex);
-      std::swap(tmp_err_map, eFsMap);
-      eFsUnavail.clear();
-      eFsDark.clear();
-      eTimeStamp = time(NULL);
+    ResetErrorMaps();
+
+    // Errors are streamed to the repair thread while being collected
+    if (!CollectQdbErrs(assistant)) {
+      break;
     }
 
     // @note accounting the offline replicas/files is a heavy ns op.
@@ -340,8 +374,6 @@ Fsck::CollectErrs(ThreadAssistant& assistant) noexcept
     Log("Finished error collection");
     Log("Next run in %d minutes",
         std::chrono::duration_cast<std::chrono::minutes>(mCollectInterval).count());
-    // Notify the repair thread that it can run now
-    mStartProcessing = true;
     PublishLogs();
     // Wait for next FSCK round ...
     assistant.wait_for(mCollectInterval);
@@ -371,121 +403,85 @@ Fsck::RepairErrs(ThreadAssistant& assistant) noexcept
   }
 
   gOFS->WaitUntilNamespaceIsBooted();
+  uint64_t msg_delay = 0;
+  FsckRepairItem item;
+  auto rank_fn = [this](const FsckRepairItem & item) {
+    return GetRepairPriority(item);
+  };
 
   while (!assistant.terminationRequested()) {
     // Don't run if we are not a master
-    while (!gOFS->mMaster->IsMaster()) {
-      assistant.wait_for(std::chrono::seconds(1));
-
-      if (assistant.terminationRequested()) {
-        eos_info("%s", "msg=\"stopped fsck repair thread\"");
-        mRepairRunning = false;
-        return;
-      }
-    }
-
-    // Wait for the collector thread to signal us
-    while (!mStartProcessing) {
+    if (!gOFS->mMaster->IsMaster()) {
+      mPipeline.SetConsumerActive(false);
       assistant.wait_for(std::chrono::seconds(1));
-
-      if (assistant.terminationRequested()) {
-        eos_info("%s", "msg=\"stopped fsck repair thread\"");
-        mRepairRunning = false;
-        return;
-      }
-    }
-
-    // Create local struct for errors so that we avoid the iterator invalidation
-    // and the long locks
-    std::map<std::string,
-        std::map<eos::common::FileId::fileid_t ,
-        std::set <eos::common::FileSystem::fsid_t> > > local_emap;
-    {
-      eos::common::RWMutexReadLock rd_lock(mErrMutex);
-      local_emap.insert(eFsMap.begin(), eFsMap.end());
+      continue;
     }
-    uint64_t count = 0ull;
-    uint64_t msg_delay = 0;
-    std::list<std::string> err_priority{
-      "stripe_err", "blockxs_err",   "unreg_n",
-      "rep_diff_n", "rep_missing_n", "m_mem_sz_diff",
-      "m_cx_diff",  "d_mem_sz_diff", "d_cx_diff"};
-
-    for (const auto& err_type : err_priority) {
-      // Repair only targeted categories if this option is set
-      if ((mRepairCategory != FsckErr::None) &&
-          (mRepairCategory != ConvertToFsckErr(err_type))) {
-        continue;
-      }
 
-      for (const auto& elem : local_emap[err_type]) {
-        if (!gOFS->mFidTracker.AddEntry(elem.first, TrackerType::Fsck)) {
-          eos_debug("msg=\"skip already scheduled transfer\" fxid=%08llx",
-                    elem.first);
-          continue;
-        }
+    mPipeline.SetConsumerActive(true);
 
-        std::shared_ptr<FsckEntry> job{
-          new FsckEntry(elem.first, elem.second, err_type, mQcl)};
-        mThreadPool.PushTask<void>([job]() {
-          return job->Repair();
-        });
-
-        // Check regularly if we should exit and sleep if queue is full
-        while ((mThreadPool.GetQueueSize() > mMaxQueuedJobs) ||
-               (++count % 100 == 0)) {
-          if (assistant.terminationRequested()) {
-            // Wait that there are not more jobs in the queue - this can
-            // take a while depending on the queue size
-            while (mThreadPool.GetQueueSize()) {
-              std::this_thread::sleep_for(std::chrono::seconds(1));
-
-              if (++msg_delay % 5 == 0) {
-                eos_info("%s", "msg=\"stopping fsck repair waiting for thread "
-                         "pool queue to be consummed\"");
-                msg_delay = 0;
-              }
-            }
-
-            eos_info("%s", "msg=\"stopped fsck repair thread\"");
-            mRepairRunning = false;
-            return;
-          } else {
-            if (mThreadPool.GetQueueSize() > mMaxQueuedJobs) {
-              assistant.wait_for(std::chrono::seconds(1));
-            } else {
-              break;
-            }
-          }
-        }
-      }
+    // Items are queued by the collector thread while it's running
+    if (!mPipeline.Pop(item, std::chrono::seconds(1), rank_fn)) {
+      // Flush any collected notifications while idle
+      NotifyFixedErr(0ull, 0ul, "", true);
+      continue;
     }
 
     // Remove orphans from unavailable filesystems
-    for (const auto& [fid, fsids] : local_emap[eos::common::FSCK_ORPHANS_N]) {
-      for (const auto& fsid : fsids) {
+    if (item.mErrType == eos::common::FSCK_ORPHANS_N) {
+      for (const auto& fsid : item.mFsids) {
         eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
         FileSystem* fs = FsView::gFsView.mIdView.lookupByID(fsid);
 
         if (!fs) {
           eos_info("msg=\"dropping orphans for missing filesystem\" "
-                   "fxid=%08llx fsid=%d", fid, fsid);
-          NotifyFixedErr(fid, fsid, eos::common::FSCK_ORPHANS_N);
+                   "fxid=%08llx fsid=%d", item.mFid, fsid);
+          NotifyFixedErr(item.mFid, fsid, eos::common::FSCK_ORPHANS_N);
         }
       }
+
+      continue;
+    }
+
+    // Repair only targeted categories if this option is set
+    if ((mRepairCategory != FsckErr::None) &&
+        (mRepairCategory != ConvertToFsckErr(item.mErrType))) {
+      continue;
+    }
+
+    if (!gOFS->mFidTracker.AddEntry(item.mFid, TrackerType::Fsck)) {
+      eos_debug("msg=\"skip already scheduled transfer\" fxid=%08llx",
+                item.mFid);
+      continue;
     }
 
-    // Force flush any collected notifications
-    NotifyFixedErr(0ull, 0ul, "", true);
-    mStartProcessing = false;
-    eos_info("%s", "msg=\"loop in fsck repair thread\"");
+    std::shared_ptr<FsckEntry> job{
+      new FsckEntry(item.mFid, item.mFsids, item.mErrType, mQcl)};
+    mThreadPool.PushTask<void>([job]() {
+      return job->Repair();
+    });
+
+    // Sleep if the thread pool queue is full
+    while ((mThreadPool.GetQueueSize() > mMaxQueuedJobs) &&
+           !assistant.terminationRequested()) {
+      assistant.wait_for(std::chrono::seconds(1));
+    }
   }
 
-  // Wait that there are no more jobs in the queue
+  // Drop the pending items and wait that there are no more jobs in the
+  // queue - this can take a while depending on the queue size
+  mPipeline.SetConsumerActive(false);
+
   while (mThreadPool.GetQueueSize()) {
-    assistant.wait_for(std::chrono::seconds(1));
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    if (++msg_delay % 5 == 0) {
+      eos_info("%s", "msg=\"stopping fsck repair waiting for thread "
+               "pool queue to be consummed\"");
+      msg_delay = 0;
+    }
   }
 
+  NotifyFixedErr(0ull, 0ul, "", true);
   gOFS->mFidTracker.Clear(TrackerType::Fsck);
   eos_info("%s", "msg=\"stopped fsck repair thread\"");
   mRepairRunning = false;
@@ -542,7 +538,10 @@ Fsck::PrintOut(std::string& out, bool monitor_fmt) const
         << std::endl
         << "repair_category=" <<
         ((mRepairCategory == FsckErr::None) ?
-         "all" : eos::common::FsckErrToString(mRepairCategory)) << std::endl;
+         "all" : eos::common::FsckErrToString(mRepairCategory)) << std::endl
+        << "collected=" << mPipeline.GetNumCollected() << std::endl
+        << "repair_queued=" << mPipeline.GetQueueSize() << std::endl
+        << "repair_scheduled=" << mPipeline.GetNumScheduled() << std::endl;
   } else {
     oss << "Info: collection thread status -> "
         << (mCollectEnabled ? "enabled" : "disabled") << std::endl
@@ -550,7 +549,11 @@ Fsck::PrintOut(std::string& out, bool monitor_fmt) const
         << (mRepairEnabled ? "enabled" : "disabled") << std::endl
         << "Info: repair category          -> "
         << ((mRepairCategory == FsckErr::None) ?
-            "all" : eos::common::FsckErrToString(mRepairCategory)) << std::endl;
+            "all" : eos::common::FsckErrToString(mRepairCategory)) << std::endl
+        << "Info: collected entries        -> "
+        << mPipeline.GetNumCollected() << std::endl
+        << "Info: queued/scheduled repairs -> " << mPipeline.GetQueueSize()
+        << "/" << mPipeline.GetNumScheduled() << std::endl;
   }
 
   {
@@ -595,12 +598,34 @@ Fsck::Report(std::string& out, const std::set<std::string> tags,
              bool display_json)
 {
   std::ostringstream oss;
+  FsckCounters counters = mPipeline.GetCounters();
+  ErrMapT fid_map;
+
+  // The file identifiers are not kept in memory, stream them from QDB only
+  // if they need to be displayed
+  if (display_fxid || display_lfn) {
+    QueryQdb(fid_map, tags);
+  }
+
   eos::common::RWMutexReadLock rd_lock(mErrMutex);
+  // Add the errors accounted from the namespace view
+  AccountErrMap(eFsMap, counters);
+
+  if (display_fxid || display_lfn) {
+    for (const auto& elem_map : eFsMap) {
+      if (tags.empty() || tags.count(elem_map.first)) {
+        fid_map[elem_map.first].insert(elem_map.second.begin(),
+                                       elem_map.second.end());
+      }
+    }
+  }
 
   if (display_json) {
-    ReportJsonFormat(oss, tags, display_per_fs, display_fxid, display_lfn);
+    ReportJsonFormat(oss, counters, fid_map, tags, display_per_fs,
+                     display_fxid, display_lfn);
   } else {
-    ReportMonitorFormat(oss, tags, display_per_fs, display_fxid, display_lfn);
+    ReportMonitorFormat(oss, counters, fid_map, tags, display_per_fs,
+                        display_fxid, display_lfn);
   }
 
   out = oss.str();
@@ -611,7 +636,8 @@ Fsck::Report(std::string& out, const std::set<std::string> tags,
 // Create report in JSON format
 //------------------------------------------------------------------------------
 void
-Fsck::ReportJsonFormat(std::ostringstream& oss,
+Fsck::ReportJsonFormat(std::ostringstream& oss, const FsckCounters& counters,
+                       const ErrMapT& fid_map,
                        const std::set<std::string> tags,
                        bool display_per_fs, bool display_fxid,
                        bool display_lfn) const
@@ -623,11 +649,7 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
     std::map<eos::common::FileSystem::fsid_t,
         std::map<std::string, std::set<unsigned long long>>> fs_fxid;
 
-    for (const auto& elem_map : eFsMap) {
-      if (!tags.empty() && (tags.find(elem_map.first) == tags.end())) {
-        continue;  // skip unselected
-      }
-
+    for (const auto& elem_map : fid_map) {
       for (const auto& elem : elem_map.second) {
         for (const auto& fsid : elem.second) {
           fs_fxid[fsid][elem_map.first].insert(elem.first);
@@ -635,13 +657,17 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
       }
     }
 
-    for (const auto& elem : fs_fxid) {
+    for (const auto& elem : counters.mFsErrCount) {
       for (auto it = elem.second.begin(); it != elem.second.end(); ++it) {
+        if (!tags.empty() && (tags.find(it->first) == tags.end())) {
+          continue;  // skip unselected
+        }
+
         Json::Value json_entry;
-        json_entry["timestamp"] = (Json::Value::UInt64)eTimeStamp;
+        json_entry["timestamp"] = (Json::Value::UInt64)counters.mTimestamp;
         json_entry["fsid"] = (int) elem.first;
         json_entry["tag"] = it->first.c_str();
-        json_entry["count"] = (int) it->second.size();
+        json_entry["count"] = (Json::Value::UInt64) it->second;
 
         if (!display_fxid && !display_lfn) {
           json.append(json_entry);
@@ -650,9 +676,8 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
 
         Json::Value json_ids;
 
-        for (auto it_fid = it->second.begin();
-             it_fid != it->second.end(); ++it_fid) {
-          json_ids.append(GetFidFormat(*it_fid, display_fxid, display_lfn));
+        for (const auto& fid : fs_fxid[elem.first][it->first]) {
+          json_ids.append(GetFidFormat(fid, display_fxid, display_lfn));
         }
 
         if (display_fxid) {
@@ -665,31 +690,32 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
       }
     }
   } else {
-    for (const auto& elem_map : eFsMap) {
-      if (!tags.empty() && (tags.find(elem_map.first) == tags.end())) {
+    for (const auto& elem : counters.mErrFids) {
+      if (!tags.empty() && (tags.find(elem.first) == tags.end())) {
         continue;  // skip unselected
       }
 
       Json::Value json_entry;
-      json_entry["timestamp"] = (Json::Value::UInt64) eTimeStamp;
-      json_entry["tag"] = elem_map.first;
-      Json::Value json_ids;
-      std::set<unsigned long long> fids;
+      json_entry["timestamp"] = (Json::Value::UInt64) counters.mTimestamp;
+      json_entry["tag"] = elem.first;
+      json_entry["count"] = (Json::Value::UInt64) elem.second;
 
-      for (const auto& elem : elem_map.second) {
-        fids.insert(elem.first);
-      }
-
-      for (auto it = fids.begin(); it != fids.end(); ++it) {
-        json_ids.append(GetFidFormat(*it, display_fxid, display_lfn));
-      }
+      if (display_fxid || display_lfn) {
+        Json::Value json_ids;
+        auto it_map = fid_map.find(elem.first);
 
-      json_entry["count"] = (Json::Value::UInt64)fids.size();
+        if (it_map != fid_map.end()) {
+          for (const auto& fid_elem : it_map->second) {
+            json_ids.append(GetFidFormat(fid_elem.first, display_fxid,
+                                         display_lfn));
+          }
+        }
 
-      if (display_fxid) {
-        json_entry["fxid"] = json_ids;
-      } else if (display_lfn) {
-        json_entry["lfn"] = json_ids;
+        if (display_fxid) {
+          json_entry["fxid"] = json_ids;
+        } else {
+          json_entry["lfn"] = json_ids;
+        }
       }
 
       json.append(json_entry);
@@ -700,7 +726,7 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
   if (!eFsDark.empty()) {
     for (auto fsit = eFsDark.begin(); fsit != eFsDark.end(); fsit++) {
       Json::Value json_entry;
-      json_entry["timestamp"] = (Json::Value::UInt64) eTimeStamp;
+      json_entry["timestamp"] = (Json::Value::UInt64) counters.mTimestamp;
       json_entry["tag"] = "shadow_fsid";
       json_entry["fsid"] = (Json::Value::UInt64)fsit->first;
       json_entry["count"] = (Json::Value::UInt64)fsit->second;
@@ -716,6 +742,8 @@ Fsck::ReportJsonFormat(std::ostringstream& oss,
 //------------------------------------------------------------------------------
 void
 Fsck::ReportMonitorFormat(std::ostringstream& oss,
+                          const FsckCounters& counters,
+                          const ErrMapT& fid_map,
                           const std::set<std::string> tags,
                           bool display_per_fs, bool display_fxid,
                           bool display_lfn) const
@@ -725,11 +753,7 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
     std::map<eos::common::FileSystem::fsid_t,
         std::map<std::string, std::set<unsigned long long>>> fs_fxid;
 
-    for (const auto& elem_map : eFsMap) {
-      if (!tags.empty() && (tags.find(elem_map.first) == tags.end())) {
-        continue;  // skip unselected
-      }
-
+    for (const auto& elem_map : fid_map) {
       for (const auto& elem : elem_map.second) {
         for (const auto& fsid : elem.second) {
           fs_fxid[fsid][elem_map.first].insert(elem.first);
@@ -737,10 +761,14 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
       }
     }
 
-    for (const auto& elem : fs_fxid) {
+    for (const auto& elem : counters.mFsErrCount) {
       for (auto it = elem.second.begin(); it != elem.second.end(); ++it) {
-        oss << "timestamp=" << eTimeStamp << " fsid=" << elem.first
-            << " tag=\"" << it->first << "\" count=" << it->second.size();
+        if (!tags.empty() && (tags.find(it->first) == tags.end())) {
+          continue;  // skip unselected
+        }
+
+        oss << "timestamp=" << counters.mTimestamp << " fsid=" << elem.first
+            << " tag=\"" << it->first << "\" count=" << it->second;
 
         if (display_fxid) {
           oss << " fxid=";
@@ -751,11 +779,12 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
           continue;
         }
 
-        for (auto it_fid = it->second.begin();
-             it_fid != it->second.end(); ++it_fid) {
+        const auto& fids = fs_fxid[elem.first][it->first];
+
+        for (auto it_fid = fids.begin(); it_fid != fids.end(); ++it_fid) {
           oss << GetFidFormat(*it_fid, display_fxid, display_lfn);
 
-          if (it_fid != std::prev(it->second.end())) {
+          if (it_fid != std::prev(fids.end())) {
             oss << ", ";
           }
         }
@@ -764,19 +793,13 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
       }
     }
   } else {
-    for (const auto& elem_map : eFsMap) {
-      if (!tags.empty() && (tags.find(elem_map.first) == tags.end())) {
+    for (const auto& elem : counters.mErrCount) {
+      if (!tags.empty() && (tags.find(elem.first) == tags.end())) {
         continue;  // skip unselected
       }
 
-      oss << "timestamp=" << eTimeStamp << " tag=\"" << elem_map.first << "\"";
-      uint64_t count = 0ull;
-
-      for (const auto& elem : elem_map.second) {
-        count += elem.second.size();
-      }
-
-      oss << " count=" << count;
+      oss << "timestamp=" << counters.mTimestamp << " tag=\"" << elem.first
+          << "\"" << " count=" << elem.second;
 
       if (display_fxid) {
         oss << " fxid=";
@@ -787,17 +810,15 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
         continue;
       }
 
-      std::set<unsigned long long> fids;
-
-      for (const auto& elem : elem_map.second) {
-        fids.insert(elem.first);
-      }
+      auto it_map = fid_map.find(elem.first);
 
-      for (auto it = fids.begin(); it != fids.end(); ++it) {
-        oss << GetFidFormat(*it, display_fxid, display_lfn);
+      if (it_map != fid_map.end()) {
+        for (auto it = it_map->second.begin(); it != it_map->second.end(); ++it) {
+          oss << GetFidFormat(it->first, display_fxid, display_lfn);
 
-        if (it != std::prev(fids.end())) {
-          oss << ", ";
+          if (it != std::prev(it_map->second.end())) {
+            oss << ", ";
+          }
         }
       }
 
@@ -808,7 +829,7 @@ Fsck::ReportMonitorFormat(std::ostringstream& oss,
   // List shadow filesystems
   if (!eFsDark.empty()) {
     for (auto fsit = eFsDark.begin(); fsit != eFsDark.end(); ++fsit) {
-      oss << "timestamp=" << eTimeStamp << " tag=\"shadow_fsid\""
+      oss << "timestamp=" << counters.mTimestamp << " tag=\"shadow_fsid\""
           << " fsid=" << fsit->first << " count=" << fsit->second;
     }
   }
@@ -881,7 +902,6 @@ Fsck::ResetErrorMaps()
   eFsMap.clear();
   eFsUnavail.clear();
   eFsDark.clear();
-  eTimeStamp = time(NULL);
 }
 
 //------------------------------------------------------------------------------
@@ -1012,6 +1032,14 @@ Fsck::AccountOfflineFiles()
   // Loop over all replica_offline and layout error files to assemble a
   // file offline list
   std::set <eos::common::FileId::fileid_t> fid2check;
+  ErrMapT diff_map;
+  // The replica layout errors are only stored in QDB
+  QueryQdb(diff_map, {"rep_diff_n"});
+
+  for (const auto& elem : diff_map["rep_diff_n"]) {
+    fid2check.insert(elem.first);
+  }
+
   {
     eos::common::RWMutexReadLock rd_lock(mErrMutex);
     auto it_offline = eFsMap.find("rep_offline");
@@ -1021,14 +1049,6 @@ Fsck::AccountOfflineFiles()
         fid2check.insert(elem.first);
       }
     }
-
-    auto it_diff_n = eFsMap.find("rep_diff_n");
-
-    if (it_diff_n != eFsMap.end()) {
-      for (const auto& elem : it_diff_n->second) {
-        fid2check.insert(elem.first);
-      }
-    }
   }
 
   for (auto it = fid2check.begin(); it != fid2check.end(); ++it) {
@@ -1096,18 +1116,19 @@ Fsck::AccountOfflineFiles()
 void
 Fsck::PrintErrorsSummary() const
 {
-  eos::common::RWMutexReadLock rd_lock(mErrMutex);
-
-  for (const auto& elem_type : eFsMap) {
-    uint64_t count {0ull};
-
-    for (const auto& elem_errs : elem_type.second) {
-      count += elem_errs.second.size();
-    }
+  FsckCounters counters = mPipeline.GetCounters();
+  {
+    eos::common::RWMutexReadLock rd_lock(mErrMutex);
+    AccountErrMap(eFsMap, counters);
+  }
 
-    Log("%-30s : %llu", elem_type.first.c_str(), count);
-    LogMonitor("%s=%llu", elem_type.first.c_str(), count);
+  for (const auto& elem : counters.mErrCount) {
+    Log("%-30s : %llu", elem.first.c_str(), elem.second);
+    LogMonitor("%s=%llu", elem.first.c_str(), elem.second);
   }
+
+  Log("Scheduled repairs: %llu dedup_memory=%llu bytes",
+      mPipeline.GetNumScheduled(), mPipeline.GetDedupMemory());
 }
 
 //------------------------------------------------------------------------------
@@ -1146,52 +1167,190 @@ Fsck::AccountDarkFiles()
 }
 
 //------------------------------------------------------------------------------
-// Query QDB for fsck errors
+// Stream the fsck errors from QDB into the pipeline
 //------------------------------------------------------------------------------
-void
-Fsck::QueryQdb(ErrMapT& err_map)
+bool
+Fsck::CollectQdbErrs(ThreadAssistant& assistant)
 {
   static std::set<std::string> known_errs = eos::common::GetKnownFsckErrs();
   qclient::QSet set_errs(*mQcl.get(), "");
-  // Helper function to parse fsck info stored in QDB
-  auto parse_fsck =
-    [](const std::string & data) ->
-  std::pair<eos::IFileMD::id_t, eos::common::FileSystem::fsid_t> {
-    const size_t pos = data.find(':');
-
-    if ((pos == std::string::npos) || (pos == data.length()))
-    {
-      eos_static_err("msg=\"failed to parse fsck element\" data=\"%s\"",
-      data.c_str());
-      return {0ull, 0ul};
+  qclient::QHash progress(*mQcl.get(), sProgressKey);
+  std::map<std::string, std::string> cursors;
+  auto stop = [&assistant]() {
+    return assistant.terminationRequested();
+  };
+  // Only the error type rank is used when queueing, the remaining redundancy
+  // is looked up by the repair thread
+  auto prio_fn = [](const FsckRepairItem & item) {
+    return GetRepairRank(item.mErrType);
+  };
+  eos_static_info("%s", "msg=\"check for fsck errors\"");
+
+  // The counters, deduplication state and repair queue of the interrupted
+  // collection only live in memory, if they are gone e.g. after a restart
+  // then the scan starts over
+  if (mPipeline.CanResumeCycle()) {
+    try {
+      for (const auto& err_type : known_errs) {
+        cursors[err_type] = progress.hget(err_type);
+      }
+
+      Log("Resume interrupted error collection");
+    } catch (const std::exception& e) {
+      eos_static_err("msg=\"failed to read fsck progress\" emsg=\"%s\"",
+                     e.what());
+      cursors.clear();
+    }
+  }
+
+  if (cursors.empty()) {
+    try {
+      (void) mQcl->del(sProgressKey);
+    } catch (const std::exception& e) {
+      eos_static_err("%s", "msg=\"failed to reset fsck progress\"");
     }
 
-    eos::IFileMD::id_t fid;
-    eos::common::FileSystem::fsid_t fsid;
+    mPipeline.StartCycle();
+  }
+
+  for (const auto& err_type : known_errs) {
+    std::string cursor = cursors[err_type];
 
-    if (!eos::common::StringToNumeric(data.substr(0, pos), fid) ||
-        !eos::common::StringToNumeric(data.substr(pos + 1), fsid))
-    {
-      eos_static_err("msg=\"failed to convert fsck info\" data=\"%s\"",
-                     data.c_str());
-      return {0ull, 0ul};
+    if (cursor == "done") {
+      continue;
     }
 
-    return {fid, fsid};
-  };
-  eos_static_info("%s", "msg=\"check for fsck errors\"");
+    if (cursor.empty()) {
+      cursor = "0";
+    }
+
+    const bool repair = (err_type == eos::common::FSCK_ORPHANS_N) ||
+                        (std::find(sRepairPriority.begin(), sRepairPriority.end(),
+                                   err_type) != sRepairPriority.end());
+    set_errs.setKey(SSTR("fsck:" << err_type));
+
+    try {
+      do {
+        auto reply = set_errs.sscan(cursor, sScanBatch);
+
+        for (const auto& elem : reply.second) {
+          auto pair_info = ParseFsckElement(elem);
+
+          if (pair_info.first || pair_info.second) {
+            mPipeline.Add(err_type, pair_info.first, pair_info.second,
+                          repair, prio_fn, stop);
+          }
+        }
+
+        cursor = reply.first;
+        progress.hset(err_type, (cursor == "0") ? "done" : cursor);
+
+        if (stop()) {
+          return false;
+        }
+      } while (cursor != "0");
+    } catch (const std::exception& e) {
+      eos_static_err("msg=\"failed to scan fsck errors\" err_type=%s "
+                     "emsg=\"%s\"", err_type.c_str(), e.what());
+    }
+  }
+
+  mPipeline.EndCycle();
+
+  try {
+    (void) mQcl->del(sProgressKey);
+  } catch (const std::exception& e) {
+    eos_static_err("%s", "msg=\"failed to reset fsck progress\"");
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Query QDB for the file identifiers of the given fsck errors
+//------------------------------------------------------------------------------
+void
+Fsck::QueryQdb(ErrMapT& err_map, const std::set<std::string>& tags) const
+{
+  static std::set<std::string> known_errs = eos::common::GetKnownFsckErrs();
+  qclient::QSet set_errs(*mQcl.get(), "");
 
   for (const auto& err_type : known_errs) {
+    if (!tags.empty() && (tags.find(err_type) == tags.end())) {
+      continue;
+    }
+
     set_errs.setKey(SSTR("fsck:" << err_type));
 
     for (auto it = set_errs.getIterator(); it.valid(); it.next()) {
       // Set elements are in the form: fid:fsid
-      auto pair_info = parse_fsck(it.getElement());
-      err_map[err_type][pair_info.first].insert(pair_info.second);
+      auto pair_info = ParseFsckElement(it.getElement());
+
+      if (pair_info.first || pair_info.second) {
+        err_map[err_type][pair_info.first].insert(pair_info.second);
+      }
     }
   }
+}
 
-  return;
+//------------------------------------------------------------------------------
+// Get rank of the given error type in the repair order
+//------------------------------------------------------------------------------
+uint32_t
+Fsck::GetRepairRank(const std::string& err_type)
+{
+  return std::find(sRepairPriority.begin(), sRepairPriority.end(), err_type) -
+         sRepairPriority.begin();
+}
+
+//------------------------------------------------------------------------------
+// Compute repair priority for the given item
+//------------------------------------------------------------------------------
+uint32_t
+Fsck::GetRepairPriority(const FsckRepairItem& item) const
+{
+  // Cap for the redundancy, files above this are treated the same
+  static constexpr unsigned long sMaxRedundancy = 7ul;
+  const uint32_t rank = GetRepairRank(item.mErrType);
+  unsigned long redundancy = sMaxRedundancy;
+
+  try {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, item.mFid);
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+    auto fmd = gOFS->eosFileService->getFileMD(item.mFid);
+    unsigned long healthy = 0ul;
+
+    for (const auto& loc : fmd->getLocations()) {
+      if (item.mFsids.find(loc) == item.mFsids.end()) {
+        ++healthy;
+      }
+    }
+
+    redundancy = std::min(sMaxRedundancy, eos::common::LayoutId::GetRedundancy
+                          (fmd->getLayoutId(), healthy));
+  } catch (const eos::MDException& e) {
+    // file does not exist anymore, repair it with the lowest priority
+  }
+
+  return redundancy * (sRepairPriority.size() + 1) + rank;
+}
+
+//------------------------------------------------------------------------------
+// Add the errors from the given map to the counters
+//------------------------------------------------------------------------------
+void
+Fsck::AccountErrMap(const ErrMapT& err_map, FsckCounters& counters)
+{
+  for (const auto& elem_map : err_map) {
+    for (const auto& elem : elem_map.second) {
+      ++counters.mErrFids[elem_map.first];
+
+      for (const auto& fsid : elem.second) {
+        ++counters.mErrCount[elem_map.first];
+        ++counters.mFsErrCount[fsid][elem_map.first];
+      }
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #pragma once
 #include "mgm/Namespace.hh"
 #include "mgm/fsck/FsckEntry.hh"
+#include "mgm/fsck/FsckPipeline.hh"
 #include "common/FileSystem.hh"
 #include "common/FileId.hh"
 #include "common/AssistedThread.hh"
@@ -47,7 +48,9 @@ EOSMGMNAMESPACE_BEGIN
 //! @brief Class implementing the EOS filesystem check.
 //!
 //! When the FSCK thread is enabled it collects on a regular interval the
-//! FSCK results broadcasted by all FST nodes into a central view.
+//! FSCK results stored by all FST nodes in QuarkDB. The errors are streamed
+//! from QuarkDB into aggregated counters and a bounded repair queue so that
+//! repairs start while the collection is still running.
 //! The FSCK interface offers a 'report' and a 'repair' utility allowing to
 //! inspect and to actively try to run repair to fix inconsistencies.
 //------------------------------------------------------------------------------
@@ -221,11 +224,14 @@ private:
   static const std::string sRepairKey;
   //! Key used to store the repair category in the config
   static const std::string sRepairCategory;
+  //! QuarkDB hash key storing the scan cursors of the collection in progress
+  static const std::string sProgressKey;
+  //! Number of elements requested per scan from QuarkDB
+  static constexpr long long sScanBatch = 1000;
 
   std::atomic<bool> mShowOffline; ///< Flag to display offline files/replicas
   std::atomic<bool> mShowNoReplica; ///< Flag to display no replica files
   std::atomic<bool> mShowDarkFiles; ///< Flag to display dark files
-  std::atomic<bool> mStartProcessing; ///< Notification flag for repair thread
   std::atomic<bool> mCollectEnabled; ///< Mark if the err collection is enabled
   std::atomic<bool> mRepairEnabled; ///< Mark if the repair thread is enabled
   std::atomic<bool> mCollectRunning; ///< Mark if collector is running
@@ -239,17 +245,19 @@ private:
   ///< Interval between FSCK collection loops
   std::chrono::seconds mCollectInterval;
   mutable eos::common::RWMutex mErrMutex; ///< Mutex protecting all map obj
-  //! Error detail map storing "<error-name>=><fsid>=>[fid1,fid2,fid3...]"
+  //! Error detail map storing "<error-name>=><fid>=>[fsid1,fsid2...]"
   using ErrMapT = std::map<std::string,
         std::map<eos::common::FileId::fileid_t ,
         std::set <eos::common::FileSystem::fsid_t>>>;
+  //! Errors accounted from the namespace view i.e. offline replicas/files and
+  //! files without replicas. The errors stored in QuarkDB are only kept as
+  //! aggregated counters in the pipeline.
   ErrMapT eFsMap;
   //! Unavailable filesystems map
   std::map<eos::common::FileSystem::fsid_t, unsigned long long > eFsUnavail;
   //! Dark filesystem map - filesystems referenced by a file but not configured
   //! in the filesystem view
   std::map<eos::common::FileSystem::fsid_t, unsigned long long > eFsDark;
-  time_t eTimeStamp; ///< Timestamp of collection
   uint64_t mMaxQueuedJobs {(uint64_t)1e3}; ///< Max number of queued jobs (1k)
   uint32_t mMaxThreadPoolSize {20}; ///< Max number of threads in the pool
   eos::common::ThreadPool mThreadPool; ///< Thread pool for fsck repair jobs
@@ -257,24 +265,68 @@ private:
   AssistedThread mRepairThread;
   AssistedThread mCollectorThread; ///< Thread collecting errors
   std::shared_ptr<qclient::QClient> mQcl; ///< QClient object for metadata
+  FsckPipeline mPipeline; ///< Error aggregation and repair queue
 
   //----------------------------------------------------------------------------
-  //! Query QDB for fsck errors
+  //! Stream the fsck errors from QDB into the pipeline. The scan cursors are
+  //! persisted so that an interrupted collection resumes where it stopped,
+  //! as long as the pipeline still holds the state of that collection.
+  //!
+  //! @param assistant thread doing the job
+  //!
+  //! @return true if collection completed, otherwise false
+  //----------------------------------------------------------------------------
+  bool CollectQdbErrs(ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! Query QDB for the file identifiers of the given fsck errors
   //!
   //! @param err_map map of fsck errors collected
+  //! @param tags error types to query, if empty then query all
+  //----------------------------------------------------------------------------
+  void QueryQdb(ErrMapT& err_map, const std::set<std::string>& tags) const;
+
+  //----------------------------------------------------------------------------
+  //! Get rank of the given error type in the repair order
+  //!
+  //! @param err_type error type
+  //!
+  //! @return rank, lower means more urgent
   //----------------------------------------------------------------------------
-  void QueryQdb(ErrMapT& err_map);
+  static uint32_t GetRepairRank(const std::string& err_type);
+
+  //----------------------------------------------------------------------------
+  //! Compute repair priority for the given item, files with the lowest
+  //! remaining redundancy e.g. single replica files are repaired first. This
+  //! needs a namespace lookup and is done by the repair thread.
+  //!
+  //! @param item repair item
+  //!
+  //! @return priority value, lower means more urgent
+  //----------------------------------------------------------------------------
+  uint32_t GetRepairPriority(const FsckRepairItem& item) const;
+
+  //----------------------------------------------------------------------------
+  //! Add the errors from the given map to the counters
+  //!
+  //! @param err_map map of fsck errors
+  //! @param counters counters to update
+  //----------------------------------------------------------------------------
+  static void AccountErrMap(const ErrMapT& err_map, FsckCounters& counters);
 
   //----------------------------------------------------------------------------
   //! Create report in JSON format
   //!
   //! @param output output string
+  //! @param counters aggregated error counters
+  //! @param fid_map file identifiers per error, only used if fids displayed
   //! @param tags set of tags for which the report should be generated
   //! @param display_per_fs if true then display information per file system
   //! @param display_fxid if true then display file identifiers
   //! @param display_lfn if true then display logical file name
   //----------------------------------------------------------------------------
   void ReportJsonFormat(std::ostringstream& output,
+                        const FsckCounters& counters, const ErrMapT& fid_map,
                         const std::set<std::string> tags,
                         bool display_per_fs, bool display_fxid,
                         bool display_lfn) const;
@@ -283,14 +335,16 @@ private:
   //! Create report in monitor format
   //!
   //! @param output output string
+  //! @param counters aggregated error counters
+  //! @param fid_map file identifiers per error, only used if fids displayed
   //! @param tags set of tags for which the report should be generated
   //! @param display_per_fs if true then display information per file system
   //! @param display_fxid if true then display file identifiers
   //! @param display_lfn if true then display logical file name
-  //!
-  //! @return true if successful, otherwise false
   //----------------------------------------------------------------------------
   void ReportMonitorFormat(std::ostringstream& output,
+                           const FsckCounters& counters,
+                           const ErrMapT& fid_map,
                            const std::set<std::string> tags,
                            bool display_per_fs, bool display_fxid,
                            bool display_lfn) const;
@@ -0,0 +1,282 @@
+//------------------------------------------------------------------------------
+//! @file FsckPipeline.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/fsck/FsckPipeline.hh"
+#include <ctime>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Insert file identifier
+//------------------------------------------------------------------------------
+bool
+FsckFidSet::Insert(uint64_t fid)
+{
+  auto& chunk = mChunks[fid >> sChunkBits];
+
+  if (chunk == nullptr) {
+    chunk.reset(new ChunkT());
+    chunk->fill(0ull);
+  }
+
+  const uint64_t offset = fid & ((1ull << sChunkBits) - 1);
+  const uint64_t mask = 1ull << (offset % 64);
+  uint64_t& word = (*chunk)[offset / 64];
+
+  if (word & mask) {
+    return false;
+  }
+
+  word |= mask;
+  ++mSize;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if file identifier is present
+//------------------------------------------------------------------------------
+bool
+FsckFidSet::Contains(uint64_t fid) const
+{
+  auto it = mChunks.find(fid >> sChunkBits);
+
+  if (it == mChunks.end()) {
+    return false;
+  }
+
+  const uint64_t offset = fid & ((1ull << sChunkBits) - 1);
+  return ((*it->second)[offset / 64] & (1ull << (offset % 64)));
+}
+
+//------------------------------------------------------------------------------
+// Start new collection cycle
+//------------------------------------------------------------------------------
+void
+FsckPipeline::StartCycle()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCurrent = FsckCounters();
+  mCurrent.mTimestamp = time(NULL);
+  mSeen.clear();
+  mNumCollected = 0ull;
+  mNumScheduled = 0ull;
+  mInCycle = true;
+  mIntact = true;
+}
+
+//------------------------------------------------------------------------------
+// Mark end of the collection cycle and publish the counters
+//------------------------------------------------------------------------------
+void
+FsckPipeline::EndCycle()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCurrent.mComplete = true;
+  mLast = mCurrent;
+  mInCycle = false;
+}
+
+//------------------------------------------------------------------------------
+// Check if the interrupted collection cycle can be continued
+//------------------------------------------------------------------------------
+bool
+FsckPipeline::CanResumeCycle() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return (mInCycle && mIntact);
+}
+
+//------------------------------------------------------------------------------
+// Add error entry collected from the backend
+//------------------------------------------------------------------------------
+bool
+FsckPipeline::Add(const std::string& err_type, uint64_t fid,
+                  eos::common::FileSystem::fsid_t fsid, bool repair,
+                  const PriorityFnT& prio_fn, const std::function<bool()>& stop)
+{
+  const std::string key = err_type + ":" + std::to_string(fid);
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    ++mNumCollected;
+    ++mCurrent.mErrCount[err_type];
+    ++mCurrent.mFsErrCount[fsid][err_type];
+
+    if (!mSeen[err_type].Insert(fid)) {
+      // Already seen in this cycle, merge into the queued item if any
+      auto it = mQueued.find(key);
+
+      if (it != mQueued.end()) {
+        it->second->mFsids.insert(fsid);
+      }
+
+      return false;
+    }
+
+    ++mCurrent.mErrFids[err_type];
+
+    if (!repair) {
+      return false;
+    }
+
+    if (!mConsumerActive) {
+      // Marked as seen but never queued, a resumed cycle would skip it
+      mIntact = false;
+      return false;
+    }
+  }
+  // Compute the priority without the lock since it can be expensive
+  auto item = std::make_shared<FsckRepairItem>();
+  item->mFid = fid;
+  item->mErrType = err_type;
+  item->mFsids.insert(fsid);
+  item->mPriority = (prio_fn ? prio_fn(*item) : 0);
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (mConsumerActive && (mQueued.size() >= mMaxQueued)) {
+    if (stop && stop()) {
+      return false;
+    }
+
+    mCvPush.wait_for(lock, std::chrono::milliseconds(500));
+  }
+
+  if (!mConsumerActive) {
+    mIntact = false;
+    return false;
+  }
+
+  mQueue[item->mPriority].push_back(item);
+  mQueued.emplace(key, item);
+  mCvPop.notify_one();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Pop the most urgent repair item
+//------------------------------------------------------------------------------
+bool
+FsckPipeline::Pop(FsckRepairItem& item, std::chrono::milliseconds timeout,
+                  const PriorityFnT& rank_fn)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (true) {
+    if (!mCvPop.wait_for(lock, timeout, [&]() {
+    return !mQueue.empty();
+    })) {
+      return false;
+    }
+
+    auto it_prio = mQueue.begin();
+    std::shared_ptr<FsckRepairItem> sitem = it_prio->second.front();
+    it_prio->second.pop_front();
+
+    if (it_prio->second.empty()) {
+      mQueue.erase(it_prio);
+    }
+
+    if (rank_fn && !sitem->mRanked) {
+      // Rank without the lock since it can be expensive, the item stays in
+      // mQueued so that new entries are still merged into it
+      FsckRepairItem copy = *sitem;
+      lock.unlock();
+      uint32_t priority = rank_fn(copy);
+      lock.lock();
+      sitem->mRanked = true;
+
+      if (!mConsumerActive) {
+        // Queue dropped in the meantime
+        return false;
+      }
+
+      if (priority > sitem->mPriority) {
+        sitem->mPriority = priority;
+        mQueue[priority].push_back(sitem);
+        continue;
+      }
+    }
+
+    mQueued.erase(sitem->mErrType + ":" + std::to_string(sitem->mFid));
+    item = *sitem;
+    ++mNumScheduled;
+    mCvPush.notify_one();
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Mark if there is a consumer for the repair queue
+//------------------------------------------------------------------------------
+void
+FsckPipeline::SetConsumerActive(bool active)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mConsumerActive = active;
+
+  if (!active) {
+    if (!mQueued.empty()) {
+      mIntact = false;
+    }
+
+    mQueue.clear();
+    mQueued.clear();
+    mCvPush.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get counters of the last complete collection or of the one in progress
+//------------------------------------------------------------------------------
+FsckCounters
+FsckPipeline::GetCounters() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return (mLast.mComplete ? mLast : mCurrent);
+}
+
+//------------------------------------------------------------------------------
+// Get number of queued repair items
+//------------------------------------------------------------------------------
+uint64_t
+FsckPipeline::GetQueueSize() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mQueued.size();
+}
+
+//------------------------------------------------------------------------------
+// Get memory used by the deduplication sets in bytes
+//------------------------------------------------------------------------------
+uint64_t
+FsckPipeline::GetDedupMemory() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  uint64_t sz = 0ull;
+
+  for (const auto& elem : mSeen) {
+    sz += elem.second.GetMemory();
+  }
+
+  return sz;
+}
+
+EOSMGMNAMESPACE_END
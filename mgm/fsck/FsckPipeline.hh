@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+//! @file FsckPipeline.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Compact set of file identifiers stored as a chunked bitmap. File
+//! identifiers are allocated sequentially therefore the errors reported for a
+//! large instance map to a relatively small number of dense chunks.
+//------------------------------------------------------------------------------
+class FsckFidSet
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Insert file identifier
+  //!
+  //! @return true if inserted, false if already present
+  //----------------------------------------------------------------------------
+  bool Insert(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Check if file identifier is present
+  //----------------------------------------------------------------------------
+  bool Contains(uint64_t fid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of file identifiers stored
+  //----------------------------------------------------------------------------
+  inline uint64_t Size() const
+  {
+    return mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get memory used by the bitmap chunks in bytes
+  //----------------------------------------------------------------------------
+  inline uint64_t GetMemory() const
+  {
+    return mChunks.size() * sizeof(ChunkT);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all entries
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    mChunks.clear();
+    mSize = 0ull;
+  }
+
+private:
+  static constexpr uint64_t sChunkBits = 16; ///< 64k fids per chunk
+  using ChunkT = std::array<uint64_t, (1ull << sChunkBits) / 64>;
+  std::unordered_map<uint64_t, std::unique_ptr<ChunkT>> mChunks;
+  uint64_t mSize {0ull};
+};
+
+//------------------------------------------------------------------------------
+//! Aggregated fsck error counters
+//------------------------------------------------------------------------------
+struct FsckCounters {
+  time_t mTimestamp {0}; ///< Start timestamp of the collection
+  bool mComplete {false}; ///< Collection finished
+  //! Number of fid:fsid error entries per error type
+  std::map<std::string, uint64_t> mErrCount;
+  //! Number of distinct file identifiers per error type
+  std::map<std::string, uint64_t> mErrFids;
+  //! Number of error entries per file system and error type
+  std::map<eos::common::FileSystem::fsid_t,
+      std::map<std::string, uint64_t>> mFsErrCount;
+};
+
+//------------------------------------------------------------------------------
+//! Fsck repair item
+//------------------------------------------------------------------------------
+struct FsckRepairItem {
+  uint64_t mFid {0ull};
+  std::string mErrType;
+  std::set<eos::common::FileSystem::fsid_t> mFsids;
+  uint32_t mPriority {0}; ///< Lower value means more urgent
+  bool mRanked {false}; ///< Priority computed by the consumer
+};
+
+//------------------------------------------------------------------------------
+//! @brief Bounded pipeline between the fsck error collection and the repair
+//! thread. The collector streams error entries into the pipeline which
+//! aggregates them into counters, deduplicates them per file and error type
+//! and queues the repairable ones ordered by priority. The repair thread
+//! consumes the queue while the collection is still running. Memory usage is
+//! bounded by the maximum queue size and the compact per error fid sets.
+//------------------------------------------------------------------------------
+class FsckPipeline
+{
+public:
+  //! Function computing the repair priority of a new item
+  using PriorityFnT = std::function<uint32_t(const FsckRepairItem&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_queued maximum number of queued repair items
+  //----------------------------------------------------------------------------
+  FsckPipeline(uint64_t max_queued = 10000):
+    mMaxQueued(max_queued)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Start new collection cycle
+  //----------------------------------------------------------------------------
+  void StartCycle();
+
+  //----------------------------------------------------------------------------
+  //! Mark end of the collection cycle and publish the counters
+  //----------------------------------------------------------------------------
+  void EndCycle();
+
+  //----------------------------------------------------------------------------
+  //! Check if the interrupted collection cycle can be continued i.e. its
+  //! counters and deduplication state are still in memory and no repairable
+  //! entry of it was dropped
+  //!
+  //! @return true if the cycle can be continued, otherwise a new one must be
+  //!         started
+  //----------------------------------------------------------------------------
+  bool CanResumeCycle() const;
+
+  //----------------------------------------------------------------------------
+  //! Add error entry collected from the backend. The entry is accounted and,
+  //! if requested and the (fid, err_type) pair was not yet seen in the current
+  //! cycle, queued for repair. Entries for an already queued (fid, err_type)
+  //! are merged into the queued item. The call blocks while the queue is full.
+  //!
+  //! @param err_type error type
+  //! @param fid file identifier
+  //! @param fsid file system identifier
+  //! @param repair if true queue entry for repair
+  //! @param prio_fn function computing the priority of the new repair items
+  //! @param stop function returning true if the caller should stop waiting
+  //!
+  //! @return true if the entry was queued for repair, otherwise false
+  //----------------------------------------------------------------------------
+  bool Add(const std::string& err_type, uint64_t fid,
+           eos::common::FileSystem::fsid_t fsid, bool repair,
+           const PriorityFnT& prio_fn, const std::function<bool()>& stop);
+
+  //----------------------------------------------------------------------------
+  //! Pop the most urgent repair item. If a rank function is given, items are
+  //! ranked by the consumer the first time they reach the head of the queue
+  //! and queued again if they turn out to be less urgent.
+  //!
+  //! @param item output repair item
+  //! @param timeout maximum time to wait for an item
+  //! @param rank_fn function computing the final priority of an item
+  //!
+  //! @return true if an item was returned, otherwise false
+  //----------------------------------------------------------------------------
+  bool Pop(FsckRepairItem& item, std::chrono::milliseconds timeout,
+           const PriorityFnT& rank_fn = nullptr);
+
+  //----------------------------------------------------------------------------
+  //! Mark if there is a consumer for the repair queue. When disabled the
+  //! queue is dropped and new entries are only accounted.
+  //----------------------------------------------------------------------------
+  void SetConsumerActive(bool active);
+
+  //----------------------------------------------------------------------------
+  //! Get counters of the last complete collection or of the collection in
+  //! progress if there was no complete one
+  //----------------------------------------------------------------------------
+  FsckCounters GetCounters() const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of queued repair items
+  //----------------------------------------------------------------------------
+  uint64_t GetQueueSize() const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of error entries collected in the current cycle
+  //----------------------------------------------------------------------------
+  inline uint64_t GetNumCollected() const
+  {
+    return mNumCollected;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of items handed to the repair thread in the current cycle
+  //----------------------------------------------------------------------------
+  inline uint64_t GetNumScheduled() const
+  {
+    return mNumScheduled;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get memory used by the deduplication sets in bytes
+  //----------------------------------------------------------------------------
+  uint64_t GetDedupMemory() const;
+
+private:
+#ifdef IN_TEST_HARNESS
+public:
+#endif
+  uint64_t mMaxQueued; ///< Maximum number of queued items
+  bool mConsumerActive {false}; ///< Mark if repair thread is consuming
+  mutable std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mCvPush; ///< Signal space available in the queue
+  std::condition_variable mCvPop; ///< Signal items available in the queue
+  FsckCounters mCurrent; ///< Counters of the collection in progress
+  FsckCounters mLast; ///< Counters of the last complete collection
+  bool mInCycle {false}; ///< Collection cycle started and not finished
+  bool mIntact {false}; ///< No repairable entry dropped in the cycle
+  //! Per error type set of fids seen in the current cycle
+  std::map<std::string, FsckFidSet> mSeen;
+  //! Queued items indexed by priority, FIFO order within the same priority
+  std::map<uint32_t, std::deque<std::shared_ptr<FsckRepairItem>>> mQueue;
+  //! Queued items indexed by "<err_type>:<fid>" used for merging entries
+  std::unordered_map<std::string, std::shared_ptr<FsckRepairItem>> mQueued;
+  std::atomic<uint64_t> mNumCollected {0ull};
+  std::atomic<uint64_t> mNumScheduled {0ull};
+};
+
+EOSMGMNAMESPACE_END
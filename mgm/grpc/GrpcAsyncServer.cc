@@ -0,0 +1,549 @@
+//------------------------------------------------------------------------------
+//! @file GrpcAsyncServer.cc
+//! @brief Completion queue based gRPC namespace service
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/grpc/GrpcAsyncServer.hh"
+#include "mgm/grpc/GrpcServer.hh"
+#include "common/Logging.hh"
+#include "common/ThreadPool.hh"
+#include <condition_variable>
+#include <deque>
+
+EOSMGMNAMESPACE_BEGIN
+
+#ifdef EOS_GRPC
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Read a positive integer from the environment
+//------------------------------------------------------------------------------
+unsigned long
+GetEnvLimit(const char* name, unsigned long def)
+{
+  const char* value = getenv(name);
+
+  if (value) {
+    unsigned long limit = strtoul(value, nullptr, 10);
+
+    if (limit) {
+      return limit;
+    }
+
+    eos_static_warning("msg=\"ignore invalid value\" var=%s value=\"%s\"",
+                       name, value);
+  }
+
+  return def;
+}
+
+//------------------------------------------------------------------------------
+// Key the per client limits are accounted by
+//------------------------------------------------------------------------------
+std::string
+ClientKey(grpc::ServerContext* context)
+{
+  std::string dn = GrpcServer::DN(context);
+  return dn.empty() ? GrpcServer::IP(context) : dn;
+}
+}
+
+//------------------------------------------------------------------------------
+//! Base class of an asynchronous call. Every completion queue tag points to a
+//! Tag of a call, the polling thread hands the event over to the call.
+//------------------------------------------------------------------------------
+class GrpcAsyncServer::Call
+{
+public:
+  enum Event { eRequest, eWrite, eFinish };
+
+  struct Tag {
+    Call* mCall;
+    Event mEvent;
+  };
+
+  Call(GrpcAsyncServer* server, grpc::ServerCompletionQueue* cq):
+    mServer(server), mCq(cq) {}
+
+  virtual ~Call()
+  {
+    if (mAdmitted) {
+      mServer->Release(mClient, mLong);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Handle a completion queue event
+  //!
+  //! @param event completed operation
+  //! @param ok operation succeeded
+  //----------------------------------------------------------------------------
+  virtual void Proceed(Event event, bool ok) = 0;
+
+protected:
+  GrpcAsyncServer* mServer;
+  grpc::ServerCompletionQueue* mCq;
+  grpc::ServerContext mCtx;
+  Tag mRequestTag {this, eRequest};
+  Tag mWriteTag {this, eWrite};
+  Tag mFinishTag {this, eFinish};
+  std::string mClient; ///< Client key
+  bool mLong {false}; ///< Served by the long call pool
+  bool mAdmitted {false}; ///< Accounted in the client load
+};
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Unary call e.g. Ping, NsStat, Exec
+//------------------------------------------------------------------------------
+template<typename Req, typename Reply>
+class UnaryCall : public GrpcAsyncServer::Call
+{
+public:
+  typedef void (GrpcAsyncServer::AsyncService::*RequestFn)
+  (grpc::ServerContext*, Req*, grpc::ServerAsyncResponseWriter<Reply>*,
+   grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+  typedef grpc::Status(*HandlerFn)(grpc::ServerContext*, const Req*, Reply*);
+
+  UnaryCall(GrpcAsyncServer* server, grpc::ServerCompletionQueue* cq,
+            RequestFn request, HandlerFn handler, bool is_long):
+    Call(server, cq), mRequestFn(request), mHandler(handler),
+    mResponder(&mCtx)
+  {
+    mLong = is_long;
+    (mServer->mService.*mRequestFn)(&mCtx, &mRequest, &mResponder, mCq, mCq,
+                                    &mRequestTag);
+  }
+
+  void Proceed(Event event, bool ok) override
+  {
+    if (event == eFinish) {
+      delete this;
+      return;
+    }
+
+    if (!ok) {
+      // Server is shutting down
+      delete this;
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mServer->mShutdownMutex);
+
+      if (!mServer->IsShutdown()) {
+        new UnaryCall(mServer, mCq, mRequestFn, mHandler, mLong);
+      }
+    }
+
+    mClient = ClientKey(&mCtx);
+
+    if (!mServer->Admit(mClient, mLong)) {
+      mResponder.FinishWithError(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                 "too many calls in flight"), &mFinishTag);
+      return;
+    }
+
+    mAdmitted = true;
+    mServer->Submit(mLong, [this]() {
+      grpc::Status status = mHandler(&mCtx, &mRequest, &mReply);
+      mResponder.Finish(mReply, status, &mFinishTag);
+    });
+  }
+
+private:
+  RequestFn mRequestFn;
+  HandlerFn mHandler;
+  Req mRequest;
+  Reply mReply;
+  grpc::ServerAsyncResponseWriter<Reply> mResponder;
+};
+
+//------------------------------------------------------------------------------
+// Server streaming call i.e. MD and Find. The handler runs in a worker and
+// writes through the ServerWriterInterface, messages are queued up to the
+// stream buffer size and written one at a time by the completion queue.
+//------------------------------------------------------------------------------
+template<typename Req>
+class StreamCall : public GrpcAsyncServer::Call,
+  public grpc::ServerWriterInterface<eos::rpc::MDResponse>
+{
+public:
+  typedef void (GrpcAsyncServer::AsyncService::*RequestFn)
+  (grpc::ServerContext*, Req*, grpc::ServerAsyncWriter<eos::rpc::MDResponse>*,
+   grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+  typedef grpc::Status(*HandlerFn)
+  (grpc::ServerContext*, const Req*,
+   grpc::ServerWriterInterface<eos::rpc::MDResponse>*);
+  typedef bool (*ClassifyFn)(const Req&);
+
+  StreamCall(GrpcAsyncServer* server, grpc::ServerCompletionQueue* cq,
+             RequestFn request, HandlerFn handler, ClassifyFn classify):
+    Call(server, cq), mRequestFn(request), mHandler(handler),
+    mClassify(classify), mWriter(&mCtx)
+  {
+    (mServer->mService.*mRequestFn)(&mCtx, &mRequest, &mWriter, mCq, mCq,
+                                    &mRequestTag);
+  }
+
+  using grpc::ServerWriterInterface<eos::rpc::MDResponse>::Write;
+
+  //----------------------------------------------------------------------------
+  //! Metadata goes out with the first message
+  //----------------------------------------------------------------------------
+  void SendInitialMetadata() override {}
+
+  //----------------------------------------------------------------------------
+  //! Queue a message, blocks while the stream buffer is full
+  //!
+  //! @return false if the client went away, otherwise true
+  //----------------------------------------------------------------------------
+  bool Write(const eos::rpc::MDResponse& msg,
+             grpc::WriteOptions options) override
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCv.wait(lock, [this]() {
+      return mCancelled || (mQueue.size() < mServer->mOptions.mStreamBuffer);
+    });
+
+    if (mCancelled) {
+      return false;
+    }
+
+    if (mWriting) {
+      mQueue.push_back(msg);
+    } else {
+      mWriting = true;
+      mCurrent = msg;
+      mWriter.Write(mCurrent, &mWriteTag);
+    }
+
+    return true;
+  }
+
+  void Proceed(Event event, bool ok) override
+  {
+    if (event == eFinish) {
+      delete this;
+      return;
+    }
+
+    if (event == eWrite) {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (!ok) {
+        mCancelled = true;
+        mQueue.clear();
+      }
+
+      if (!mQueue.empty()) {
+        mCurrent = std::move(mQueue.front());
+        mQueue.pop_front();
+        mWriter.Write(mCurrent, &mWriteTag);
+      } else {
+        mWriting = false;
+
+        if (mDone) {
+          mWriter.Finish(mStatus, &mFinishTag);
+        }
+      }
+
+      mCv.notify_all();
+      return;
+    }
+
+    if (!ok) {
+      // Server is shutting down
+      delete this;
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mServer->mShutdownMutex);
+
+      if (!mServer->IsShutdown()) {
+        new StreamCall(mServer, mCq, mRequestFn, mHandler, mClassify);
+      }
+    }
+
+    mClient = ClientKey(&mCtx);
+    mLong = mClassify(mRequest);
+
+    if (!mServer->Admit(mClient, mLong)) {
+      mWriter.Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                  "too many calls in flight"), &mFinishTag);
+      return;
+    }
+
+    mAdmitted = true;
+    mServer->Submit(mLong, [this]() {
+      grpc::Status status = mHandler(&mCtx, &mRequest, this);
+      bool finish = false;
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone = true;
+        mStatus = status;
+        finish = !mWriting;
+      }
+
+      // The call may be deleted as soon as Finish is issued
+      if (finish) {
+        mWriter.Finish(mStatus, &mFinishTag);
+      }
+    });
+  }
+
+private:
+  RequestFn mRequestFn;
+  HandlerFn mHandler;
+  ClassifyFn mClassify;
+  Req mRequest;
+  grpc::ServerAsyncWriter<eos::rpc::MDResponse> mWriter;
+  std::mutex mMutex; ///< Protects the members below
+  std::condition_variable mCv; ///< Signals free space in the queue
+  std::deque<eos::rpc::MDResponse> mQueue; ///< Messages waiting to be written
+  eos::rpc::MDResponse mCurrent; ///< Message being written
+  bool mWriting {false}; ///< A write is in flight
+  bool mCancelled {false}; ///< Client went away
+  bool mDone {false}; ///< Handler returned
+  grpc::Status mStatus; ///< Handler status
+};
+
+//------------------------------------------------------------------------------
+// Only listings are long MD calls, stats are answered with one message
+//------------------------------------------------------------------------------
+bool
+IsLongMD(const eos::rpc::MDRequest& request)
+{
+  return (request.type() == eos::rpc::LISTING);
+}
+
+bool
+IsLongFind(const eos::rpc::FindRequest&)
+{
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+// Read the settings from the environment
+//------------------------------------------------------------------------------
+GrpcAsyncServer::Options
+GrpcAsyncServer::Options::FromEnv()
+{
+  Options options;
+  options.mShortThreads = GetEnvLimit("EOS_MGM_GRPC_SHORT_THREADS",
+                                      options.mShortThreads);
+  options.mLongThreads = GetEnvLimit("EOS_MGM_GRPC_LONG_THREADS",
+                                     options.mLongThreads);
+  options.mQueues = GetEnvLimit("EOS_MGM_GRPC_QUEUES", options.mQueues);
+  options.mClientInFlight = GetEnvLimit("EOS_MGM_GRPC_CLIENT_INFLIGHT",
+                                        options.mClientInFlight);
+  options.mClientLong = GetEnvLimit("EOS_MGM_GRPC_CLIENT_LONG",
+                                    options.mClientLong);
+  options.mStreamBuffer = GetEnvLimit("EOS_MGM_GRPC_STREAM_BUFFER",
+                                      options.mStreamBuffer);
+  return options;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+GrpcAsyncServer::GrpcAsyncServer(const Options& options):
+  mOptions(options)
+{
+  mShortPool.reset(new eos::common::ThreadPool(mOptions.mShortThreads,
+                   mOptions.mShortThreads, 10, 12, 10, "grpc_short"));
+  mLongPool.reset(new eos::common::ThreadPool(mOptions.mLongThreads,
+                  mOptions.mLongThreads, 10, 12, 10, "grpc_long"));
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+GrpcAsyncServer::~GrpcAsyncServer()
+{
+  Shutdown();
+}
+
+//------------------------------------------------------------------------------
+// Register the service and the completion queues with the builder
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Register(grpc::ServerBuilder& builder)
+{
+  builder.RegisterService(&mService);
+
+  for (unsigned int i = 0; i < mOptions.mQueues; ++i) {
+    mQueues.push_back(builder.AddCompletionQueue());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start accepting calls
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Start()
+{
+  eos_static_info("msg=\"starting asynchronous grpc service\" queues=%u "
+                  "short_threads=%u long_threads=%u client_inflight=%u "
+                  "client_long=%u stream_buffer=%lu", mOptions.mQueues,
+                  mOptions.mShortThreads, mOptions.mLongThreads,
+                  mOptions.mClientInFlight, mOptions.mClientLong,
+                  mOptions.mStreamBuffer);
+
+  for (auto& queue : mQueues) {
+    grpc::ServerCompletionQueue* cq = queue.get();
+    // One pending call per method and queue, each accepted call requests
+    // the next one
+    new UnaryCall<eos::rpc::PingRequest, eos::rpc::PingReply>
+    (this, cq, &AsyncService::RequestPing, &GrpcServer::Ping, false);
+    new UnaryCall<eos::rpc::FileInsertRequest, eos::rpc::InsertReply>
+    (this, cq, &AsyncService::RequestFileInsert, &GrpcServer::FileInsert, true);
+    new UnaryCall<eos::rpc::ContainerInsertRequest, eos::rpc::InsertReply>
+    (this, cq, &AsyncService::RequestContainerInsert,
+     &GrpcServer::ContainerInsert, true);
+    new UnaryCall<eos::rpc::NsStatRequest, eos::rpc::NsStatResponse>
+    (this, cq, &AsyncService::RequestNsStat, &GrpcServer::NsStat, false);
+    new UnaryCall<eos::rpc::NSRequest, eos::rpc::NSResponse>
+    (this, cq, &AsyncService::RequestExec, &GrpcServer::Exec, false);
+    new StreamCall<eos::rpc::MDRequest>
+    (this, cq, &AsyncService::RequestMD, &GrpcServer::MD, &IsLongMD);
+    new StreamCall<eos::rpc::FindRequest>
+    (this, cq, &AsyncService::RequestFind, &GrpcServer::Find, &IsLongFind);
+    mPollers.emplace_back(&GrpcAsyncServer::Poll, this, cq);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stop the workers and drain the completion queues
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(mShutdownMutex);
+
+    if (mShutdown) {
+      return;
+    }
+
+    mShutdown = true;
+  }
+
+  // Running handlers complete their calls before the queues go away
+  mShortPool->Stop();
+  mLongPool->Stop();
+
+  for (auto& queue : mQueues) {
+    queue->Shutdown();
+  }
+
+  for (auto& poller : mPollers) {
+    poller.join();
+  }
+
+  mPollers.clear();
+}
+
+//------------------------------------------------------------------------------
+// Completion queue polling loop
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Poll(grpc::ServerCompletionQueue* cq)
+{
+  void* tag = nullptr;
+  bool ok = false;
+
+  while (cq->Next(&tag, &ok)) {
+    auto* call_tag = static_cast<Call::Tag*>(tag);
+    call_tag->mCall->Proceed(call_tag->mEvent, ok);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account a new call of a client
+//------------------------------------------------------------------------------
+bool
+GrpcAsyncServer::Admit(const std::string& client, bool is_long)
+{
+  std::lock_guard<std::mutex> lock(mClientMutex);
+  ClientLoad& load = mClients[client];
+
+  if ((load.mInFlight >= mOptions.mClientInFlight) ||
+      (is_long && (load.mLong >= mOptions.mClientLong))) {
+    eos_static_warning("msg=\"reject grpc call\" client=\"%s\" inflight=%u "
+                       "long=%u", client.c_str(), load.mInFlight, load.mLong);
+
+    if (!load.mInFlight) {
+      mClients.erase(client);
+    }
+
+    return false;
+  }
+
+  ++load.mInFlight;
+
+  if (is_long) {
+    ++load.mLong;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Release a call accounted by Admit
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Release(const std::string& client, bool is_long)
+{
+  std::lock_guard<std::mutex> lock(mClientMutex);
+  auto it = mClients.find(client);
+
+  if (it == mClients.end()) {
+    return;
+  }
+
+  --it->second.mInFlight;
+
+  if (is_long) {
+    --it->second.mLong;
+  }
+
+  if (!it->second.mInFlight) {
+    mClients.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Run a call handler in the short or long call pool
+//------------------------------------------------------------------------------
+void
+GrpcAsyncServer::Submit(bool is_long, std::function<void()> task)
+{
+  (is_long ? mLongPool : mShortPool)->PushTask<void>(std::move(task));
+}
+
+#endif
+
+EOSMGMNAMESPACE_END
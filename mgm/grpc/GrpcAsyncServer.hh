@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+//! @file GrpcAsyncServer.hh
+//! @brief Completion queue based gRPC namespace service
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#ifdef EOS_GRPC
+#include "proto/Rpc.grpc.pb.h"
+#include <grpc++/grpc++.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#endif
+
+namespace eos
+{
+namespace common
+{
+class ThreadPool;
+}
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+#ifdef EOS_GRPC
+
+//------------------------------------------------------------------------------
+//! Asynchronous flavour of the namespace gRPC service. A few threads poll the
+//! completion queues and only accept and complete calls, the RPCs run in two
+//! bounded worker pools: one for short calls (stat, ping, exec, ...) and one
+//! for long calls (listings, find, bulk inserts) so a handful of recursive
+//! finds can not starve the stat traffic. Each client (DN, otherwise IP) is
+//! limited in the number of calls it can have in flight. Streamed responses
+//! are written through a bounded queue, a handler producing faster than the
+//! client consumes blocks in Write instead of buffering the whole listing.
+//------------------------------------------------------------------------------
+class GrpcAsyncServer
+{
+public:
+  //! Service with all namespace methods served asynchronously
+  typedef eos::rpc::Eos::WithAsyncMethod_Ping <
+  eos::rpc::Eos::WithAsyncMethod_FileInsert <
+  eos::rpc::Eos::WithAsyncMethod_ContainerInsert <
+  eos::rpc::Eos::WithAsyncMethod_MD <
+  eos::rpc::Eos::WithAsyncMethod_Find <
+  eos::rpc::Eos::WithAsyncMethod_NsStat <
+  eos::rpc::Eos::WithAsyncMethod_Exec <
+  eos::rpc::Eos::Service >>>>>>> AsyncService;
+
+  //! Server settings
+  struct Options {
+    unsigned int mShortThreads = 16; ///< Workers for short calls
+    unsigned int mLongThreads = 4; ///< Workers for long calls
+    unsigned int mQueues = 2; ///< Completion queues, one thread each
+    unsigned int mClientInFlight = 64; ///< Calls in flight per client
+    unsigned int mClientLong = 4; ///< Long calls in flight per client
+    size_t mStreamBuffer = 256; ///< Queued messages per streamed response
+
+    //--------------------------------------------------------------------------
+    //! Read the settings from the EOS_MGM_GRPC_* environment variables
+    //--------------------------------------------------------------------------
+    static Options FromEnv();
+  };
+
+  //! Calls in flight of one client
+  struct ClientLoad {
+    unsigned int mInFlight = 0;
+    unsigned int mLong = 0;
+  };
+
+  class Call;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  GrpcAsyncServer(const Options& options);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~GrpcAsyncServer();
+
+  //----------------------------------------------------------------------------
+  //! Register the service and the completion queues with the builder, to be
+  //! called before the server is built
+  //----------------------------------------------------------------------------
+  void Register(grpc::ServerBuilder& builder);
+
+  //----------------------------------------------------------------------------
+  //! Start accepting calls, to be called once the server is built
+  //----------------------------------------------------------------------------
+  void Start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the workers and drain the completion queues, to be called after
+  //! the server was shut down
+  //----------------------------------------------------------------------------
+  void Shutdown();
+
+  //----------------------------------------------------------------------------
+  //! Account a new call of a client
+  //!
+  //! @param client client key
+  //! @param is_long call is served by the long call pool
+  //!
+  //! @return false if the client is over its limits, otherwise true
+  //----------------------------------------------------------------------------
+  bool Admit(const std::string& client, bool is_long);
+
+  //----------------------------------------------------------------------------
+  //! Release a call accounted by Admit
+  //----------------------------------------------------------------------------
+  void Release(const std::string& client, bool is_long);
+
+  //----------------------------------------------------------------------------
+  //! Run a call handler in the short or long call pool
+  //----------------------------------------------------------------------------
+  void Submit(bool is_long, std::function<void()> task);
+
+  //----------------------------------------------------------------------------
+  //! Check if the server is shutting down, needs mShutdownMutex
+  //----------------------------------------------------------------------------
+  bool IsShutdown() const
+  {
+    return mShutdown;
+  }
+
+  AsyncService mService; ///< Asynchronous service
+  const Options mOptions; ///< Server settings
+  //! Serializes requesting new calls with the queue shutdown
+  std::mutex mShutdownMutex;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Completion queue polling loop
+  //----------------------------------------------------------------------------
+  void Poll(grpc::ServerCompletionQueue* cq);
+
+  bool mShutdown {false}; ///< Server is shutting down
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> mQueues;
+  std::vector<std::thread> mPollers; ///< Completion queue threads
+  std::unique_ptr<eos::common::ThreadPool> mShortPool; ///< Short call workers
+  std::unique_ptr<eos::common::ThreadPool> mLongPool; ///< Long call workers
+  std::mutex mClientMutex; ///< Protects mClients
+  std::map<std::string, ClientLoad> mClients; ///< Load per client
+};
+
+#endif
+
+EOSMGMNAMESPACE_END
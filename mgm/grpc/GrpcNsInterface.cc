@@ -41,12 +41,17 @@
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "mgm/Recycle.hh"
 #include "namespace/Prefetcher.hh"
+#include "namespace/MDLocking.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/MDException.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/utils/Etag.hh"
 #include "namespace/utils/Attributes.hh"
 
 #include <regex.h>
+#include <mutex>
+#include <unordered_set>
 /*----------------------------------------------------------------------------*/
 
 
@@ -452,7 +457,7 @@ GrpcNsInterface::Filter(std::shared_ptr<eos::IContainerMD> md,
 
 grpc::Status
 GrpcNsInterface::GetMD(eos::common::VirtualIdentity& vid,
-                       grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                       grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                        const eos::rpc::MDRequest* request, bool check_perms,
                        bool lock,
                        bool access_self)
@@ -591,7 +596,13 @@ GrpcNsInterface::GetMD(eos::common::VirtualIdentity& vid,
 
       gRPCResponse.mutable_fmd()->set_etag(etag);
       gRPCResponse.mutable_fmd()->set_path(path);
-      writer->Write(gRPCResponse);
+      // Don't block namespace writers while the stream is flow controlled
+      viewReadLock.Release();
+
+      if (!writer->Write(gRPCResponse)) {
+        return grpc::Status(grpc::StatusCode::CANCELLED, "stream closed");
+      }
+
       return grpc::Status::OK;
     }
   }
@@ -707,7 +718,13 @@ GrpcNsInterface::GetMD(eos::common::VirtualIdentity& vid,
     }
 
     gRPCResponse.mutable_cmd()->set_path(path);
-    writer->Write(gRPCResponse);
+    // Don't block namespace writers while the stream is flow controlled
+    viewReadLock.Release();
+
+    if (!writer->Write(gRPCResponse)) {
+      return grpc::Status(grpc::StatusCode::CANCELLED, "stream closed");
+    }
+
     return grpc::Status::OK;
   }
 
@@ -716,7 +733,7 @@ GrpcNsInterface::GetMD(eos::common::VirtualIdentity& vid,
 
 grpc::Status
 GrpcNsInterface::Stat(eos::common::VirtualIdentity& ivid,
-                      grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                      grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                       const eos::rpc::MDRequest* request)
 {
   eos::common::VirtualIdentity vid = ivid;
@@ -738,7 +755,7 @@ GrpcNsInterface::Stat(eos::common::VirtualIdentity& ivid,
 
 grpc::Status
 GrpcNsInterface::StreamMD(eos::common::VirtualIdentity& ivid,
-                          grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                          grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                           const eos::rpc::MDRequest* request,
                           bool streamparent,
                           std::vector<uint64_t>* childdirs)
@@ -815,25 +832,25 @@ GrpcNsInterface::StreamMD(eos::common::VirtualIdentity& ivid,
   }
 
   grpc::Status status;
+  bool first = true;
+  auto itf = eos::FileMapIterator(cmd);
+  auto itc = eos::ContainerMapIterator(cmd);
+  viewReadLock.Release();
 
   if (streamparent && (request->type() != eos::rpc::FILE)) {
-    // stream the requested container
+    // stream the requested container, GetMD takes the namespace lock itself
+    // and releases it before writing
     eos::rpc::MDRequest c_dir;
     c_dir.mutable_selection()->CopyFrom(request->selection());
     c_dir.mutable_id()->set_id(cid);
     c_dir.set_type(eos::rpc::CONTAINER);
-    status = GetMD(vid, writer, &c_dir, true, false, true);
+    status = GetMD(vid, writer, &c_dir, true, true, true);
 
     if (!status.ok()) {
       return status;
     }
   }
 
-  bool first = true;
-  auto itf = eos::FileMapIterator(cmd);
-  auto itc = eos::ContainerMapIterator(cmd);
-  viewReadLock.Release();
-
   // stream for listing and file type
   if (request->type() != eos::rpc::CONTAINER) {
     // stream all the children files
@@ -880,7 +897,7 @@ GrpcNsInterface::StreamMD(eos::common::VirtualIdentity& ivid,
 
 grpc::Status
 GrpcNsInterface::Find(eos::common::VirtualIdentity& ivid,
-                      grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                      grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                       const eos::rpc::FindRequest* request)
 {
   eos::common::VirtualIdentity vid = ivid;
@@ -1070,6 +1087,120 @@ GrpcNsInterface::NsStat(eos::common::VirtualIdentity& vid,
   return grpc::Status::OK;
 }
 
+namespace
+{
+//! Entries of a bulk insert below the same parent container
+struct InsertGroup {
+  std::string mParent;
+  std::vector<int> mItems;
+};
+
+//! Number of entries inserted per namespace write lock
+const size_t cInsertLockBatch = 16384;
+
+//------------------------------------------------------------------------------
+//! Ids requested by the bulk inserts in progress. The existence of the ids is
+//! checked before taking the namespace lock, reserving them first makes sure
+//! that no concurrent insert creates the same id in between.
+//------------------------------------------------------------------------------
+class InsertReservation
+{
+public:
+  InsertReservation(std::mutex& mutex, std::unordered_set<uint64_t>& ids):
+    mMutex(mutex), mIds(ids)
+  {}
+
+  ~InsertReservation()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto id : mReserved) {
+      mIds.erase(id);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reserve id
+  //!
+  //! @return true if reserved, false if already reserved by an insert
+  //----------------------------------------------------------------------------
+  bool Reserve(uint64_t id)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!mIds.insert(id).second) {
+      return false;
+    }
+
+    mReserved.push_back(id);
+    return true;
+  }
+
+private:
+  std::mutex& mMutex;
+  std::unordered_set<uint64_t>& mIds;
+  std::vector<uint64_t> mReserved;
+};
+
+std::mutex gInsertFilesMutex;
+std::unordered_set<uint64_t> gInsertFiles; ///< File ids being inserted
+std::mutex gInsertContainersMutex;
+std::unordered_set<uint64_t> gInsertContainers; ///< Container ids being inserted
+
+//------------------------------------------------------------------------------
+// Group the entries of a bulk insert by parent container, keeping the request
+// order within a group. With consecutive only neighbouring entries are
+// grouped since a container may be the parent of a later entry.
+//------------------------------------------------------------------------------
+template<typename Entries>
+std::vector<InsertGroup>
+GroupByParent(const Entries& entries, bool consecutive)
+{
+  std::vector<InsertGroup> groups;
+  std::map<std::string, size_t> index;
+
+  for (int i = 0; i < entries.size(); ++i) {
+    eos::common::Path cPath(entries.Get(i).path());
+    std::string parent = cPath.GetParentPath();
+
+    if (consecutive) {
+      if (groups.empty() || (groups.back().mParent != parent)) {
+        groups.push_back(InsertGroup{parent, {}});
+      }
+
+      groups.back().mItems.push_back(i);
+    } else {
+      auto it = index.find(parent);
+
+      if (it == index.end()) {
+        it = index.emplace(parent, groups.size()).first;
+        groups.push_back(InsertGroup{parent, {}});
+      }
+
+      groups[it->second].mItems.push_back(i);
+    }
+  }
+
+  return groups;
+}
+
+//------------------------------------------------------------------------------
+// Get the flusher of the namespace metadata, null if not running on QuarkDB
+//------------------------------------------------------------------------------
+eos::MetadataFlusher*
+GetMetadataFlusher()
+{
+  auto* qdb_ns_grp = dynamic_cast<eos::QuarkNamespaceGroup*>
+                     (gOFS->namespaceGroup.get());
+  return (qdb_ns_grp ? qdb_ns_grp->getMetadataFlusher() : nullptr);
+}
+}
+
+//------------------------------------------------------------------------------
+// Insert files. The entries are grouped by parent container: each parent is
+// resolved and locked once per group and the writes of up to
+// cInsertLockBatch entries go to QuarkDB as one flusher batch.
+//------------------------------------------------------------------------------
 grpc::Status
 GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
                             eos::rpc::InsertReply* reply,
@@ -1082,97 +1213,146 @@ GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
     return grpc::Status::OK;
   }
 
-  std::shared_ptr<eos::IFileMD> newfile;
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Look up the requested ids before taking the namespace lock, ids
+  // requested by a concurrent insert count as existing
+  InsertReservation reservation(gInsertFilesMutex, gInsertFiles);
   std::vector<folly::Future<eos::IFileMDPtr>> conflicts;
+  std::vector<bool> exists(request->files_size(), false);
 
   for (auto it : request->files()) {
-    if (it.id() <= 0) {
-      conflicts.emplace_back(eos::IFileMDPtr(
-                               nullptr)); // folly::makeFuture<eos::IFileMDPtr>(eos::IFileMDPtr(nullptr)));
+    if ((it.id() > 0) && !reservation.Reserve(it.id())) {
+      exists[conflicts.size()] = true;
+    }
+
+    if ((it.id() <= 0) || exists[conflicts.size()]) {
+      conflicts.emplace_back(eos::IFileMDPtr(nullptr));
     } else {
       conflicts.emplace_back(gOFS->eosFileService->getFileMDFut(it.id()));
     }
+
+    reply->add_message("");
+    reply->add_retc(0);
   }
 
-  int counter = -1;
+  for (size_t i = 0; i < conflicts.size(); ++i) {
+    conflicts[i].wait();
+    exists[i] = exists[i] || (!conflicts[i].hasException() &&
+                              std::move(conflicts[i]).get() != nullptr);
+  }
 
-  for (auto it : request->files()) {
-    counter++;
-    conflicts[counter].wait();
+  std::vector<InsertGroup> groups = GroupByParent(request->files(), false);
+  eos::MetadataFlusher* flusher = GetMetadataFlusher();
+  size_t pos = 0;
 
-    if (!conflicts[counter].hasException() &&
-        std::move(conflicts[counter]).get() != nullptr) {
-      std::ostringstream ss;
-      ss << "Attempted to create file with id=" << it.id() <<
-         ", which already exists";
-      eos_static_err("%s", ss.str().c_str());
-      reply->add_message(ss.str());
-      reply->add_retc(EINVAL);
-      continue;
-    }
+  while (pos < groups.size()) {
+    eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+    // Destroyed first, commits before the lock is released
+    eos::MetadataFlusher::Batch batch(flusher);
+    size_t inserted = 0;
 
-    eos_static_info("creating path=%s id=%lx", it.path().c_str(), it.id());
+    for (; (pos < groups.size()) && (inserted < cInsertLockBatch); ++pos) {
+      const InsertGroup& group = groups[pos];
+      inserted += group.mItems.size();
+      std::shared_ptr<eos::IContainerMD> parent;
 
-    try {
       try {
-        newfile = gOFS->eosView->createFile(it.path(), it.uid(), it.gid(), it.id());
+        parent = gOFS->eosView->getContainer(group.mParent);
       } catch (eos::MDException& e) {
-        std::ostringstream msg;
-        msg << "Failed to call gOFS->eosView->createFile(): " << e.getMessage().str();
-        e.getMessage().str(msg.str());
-        throw;
-      }
+        for (int idx : group.mItems) {
+          const auto& it = request->files(idx);
+          reply->set_message(idx, SSTR("Failed to insert fid=" << it.id() <<
+                                       ", errno=" << e.getErrno() << ", path=" << it.path() <<
+                                       ": Failed to get parent container: " <<
+                                       e.getMessage().str()));
+          reply->set_retc(idx, -1);
+        }
 
-      eos::IFileMD::ctime_t ctime;
-      eos::IFileMD::ctime_t mtime;
-      ctime.tv_sec  = it.ctime().sec();
-      ctime.tv_nsec = it.ctime().n_sec();
-      mtime.tv_sec  = it.mtime().sec();
-      mtime.tv_nsec = it.mtime().n_sec();
-      newfile->setFlags(it.flags());
-      newfile->setCTime(ctime);
-      newfile->setMTime(mtime);
-      newfile->setCUid(it.uid());
-      newfile->setCGid(it.gid());
-      newfile->setLayoutId(it.layout_id());
-      newfile->setSize(it.size());
-      newfile->setChecksum(it.checksum().value().c_str(),
-                           it.checksum().value().size());
-
-      for (auto attrit : it.xattrs()) {
-        newfile->setAttribute(attrit.first, attrit.second);
+        continue;
       }
 
-      for (auto locit : it.locations()) {
-        newfile->addLocation(locit);
-      }
+      eos::MDLocking::ContainerWriteLockPtr parent_lock =
+        eos::MDLocking::writeLock(parent);
 
-      try {
-        gOFS->eosView->updateFileStore(newfile.get());
-      } catch (eos::MDException& e) {
-        std::ostringstream msg;
-        msg << "Failed to call gOFS->eosView->updateFileStore(): " <<
-            e.getMessage().str();
-        e.getMessage().str(msg.str());
-        throw;
-      }
+      for (int idx : group.mItems) {
+        const auto& it = request->files(idx);
 
-      reply->add_message("");
-      reply->add_retc(0);
-    } catch (eos::MDException& e) {
-      eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\" path=\"%s\" fxid=%08llx\n",
-                     e.getErrno(), e.getMessage().str().c_str(), it.path().c_str(), it.id());
-      reply->add_message(SSTR("Failed to insert fid=" << it.id() << ", errno=" <<
-                              e.getErrno() << ", path=" << it.path() << ": " << e.getMessage().str()));
-      reply->add_retc(-1);
+        if (exists[idx]) {
+          std::ostringstream ss;
+          ss << "Attempted to create file with id=" << it.id() <<
+             ", which already exists";
+          eos_static_err("%s", ss.str().c_str());
+          reply->set_message(idx, ss.str());
+          reply->set_retc(idx, EINVAL);
+          continue;
+        }
+
+        eos_static_info("creating path=%s id=%lx", it.path().c_str(), it.id());
+
+        try {
+          eos::common::Path cPath(it.path());
+          std::string name = cPath.GetName();
+          eos::FileOrContainerMD conflict = parent->findItem(name).get();
+
+          if (name.empty() || conflict.file || conflict.container) {
+            throw_mdexception(EEXIST, "File exists");
+          }
+
+          std::shared_ptr<eos::IFileMD> newfile =
+            gOFS->eosFileService->createFile(it.id());
+
+          if (!newfile) {
+            throw_mdexception(EIO, "File creation failed");
+          }
+
+          eos::IFileMD::ctime_t ctime;
+          eos::IFileMD::ctime_t mtime;
+          ctime.tv_sec  = it.ctime().sec();
+          ctime.tv_nsec = it.ctime().n_sec();
+          mtime.tv_sec  = it.mtime().sec();
+          mtime.tv_nsec = it.mtime().n_sec();
+          newfile->setName(name);
+          newfile->setATimeNow(0);
+          newfile->setFlags(it.flags());
+          newfile->setCTime(ctime);
+          newfile->setMTime(mtime);
+          newfile->setCUid(it.uid());
+          newfile->setCGid(it.gid());
+          newfile->setLayoutId(it.layout_id());
+          newfile->setSize(it.size());
+          newfile->setChecksum(it.checksum().value().c_str(),
+                               it.checksum().value().size());
+
+          for (auto attrit : it.xattrs()) {
+            newfile->setAttribute(attrit.first, attrit.second);
+          }
+
+          for (auto locit : it.locations()) {
+            newfile->addLocation(locit);
+          }
+
+          // A single store update once the file is complete
+          parent->addFile(newfile.get());
+          gOFS->eosView->updateFileStore(newfile.get());
+        } catch (eos::MDException& e) {
+          eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\" path=\"%s\" fxid=%08llx\n",
+                         e.getErrno(), e.getMessage().str().c_str(), it.path().c_str(), it.id());
+          reply->set_message(idx, SSTR("Failed to insert fid=" << it.id() <<
+                                       ", errno=" << e.getErrno() << ", path=" << it.path() <<
+                                       ": " << e.getMessage().str()));
+          reply->set_retc(idx, -1);
+        }
+      }
     }
   }
 
   return grpc::Status::OK;
 }
 
-
+//------------------------------------------------------------------------------
+// Insert containers, grouped and batched like the file insert. Only
+// consecutive entries with the same parent are grouped so that a container
+// can be created below one inserted earlier in the same request.
+//------------------------------------------------------------------------------
 grpc::Status
 GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
                                  eos::rpc::InsertReply* reply,
@@ -1185,126 +1365,166 @@ GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
     return grpc::Status::OK;
   }
 
-  std::shared_ptr<eos::IContainerMD> newdir;
-  eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+  // Look up the requested ids before taking the namespace lock, ids
+  // requested by a concurrent insert count as existing
+  InsertReservation reservation(gInsertContainersMutex, gInsertContainers);
   std::vector<folly::Future<eos::IContainerMDPtr>> conflicts;
+  std::vector<bool> exists(request->container_size(), false);
 
   for (auto it : request->container()) {
-    if (it.id() <= 0) {
+    if ((it.id() > 0) && !reservation.Reserve(it.id())) {
+      exists[conflicts.size()] = true;
+    }
+
+    if ((it.id() <= 0) || exists[conflicts.size()]) {
       conflicts.emplace_back(eos::IContainerMDPtr(nullptr));
     } else {
       conflicts.emplace_back(gOFS->eosDirectoryService->getContainerMDFut(it.id()));
     }
-  }
-
-  int counter = -1;
-  bool inherit = request->inherit_md();
 
-  for (auto it : request->container()) {
-    counter++;
-    conflicts[counter].wait();
+    reply->add_message("");
+    reply->add_retc(0);
+  }
 
-    if (!conflicts[counter].hasException() &&
-        std::move(conflicts[counter]).get() != nullptr) {
-      std::ostringstream ss;
-      ss << "Attempted to create container with id=" << it.id() <<
-         ", which already exists";
-      eos_static_err("%s", ss.str().c_str());
-      reply->add_message(ss.str());
-      reply->add_retc(EINVAL);
-      continue;
-    }
+  for (size_t i = 0; i < conflicts.size(); ++i) {
+    conflicts[i].wait();
+    exists[i] = exists[i] || (!conflicts[i].hasException() &&
+                              std::move(conflicts[i]).get() != nullptr);
+  }
 
-    eos_static_info("creating path=%s id=%lx inherit_md=%d",
-                    it.path().c_str(), it.id(), inherit);
+  bool inherit = request->inherit_md();
+  std::vector<InsertGroup> groups = GroupByParent(request->container(), true);
+  eos::MetadataFlusher* flusher = GetMetadataFlusher();
+  size_t pos = 0;
+
+  while (pos < groups.size()) {
+    eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+    // Destroyed first, commits before the lock is released
+    eos::MetadataFlusher::Batch batch(flusher);
+    size_t inserted = 0;
+
+    for (; (pos < groups.size()) && (inserted < cInsertLockBatch); ++pos) {
+      const InsertGroup& group = groups[pos];
+      inserted += group.mItems.size();
+      std::shared_ptr<eos::IContainerMD> parent;
 
-    try {
       try {
-        newdir = gOFS->eosView->createContainer(it.path(), false, it.id());
+        parent = gOFS->eosView->getContainer(group.mParent);
       } catch (eos::MDException& e) {
-        std::ostringstream msg;
-        msg << "Failed to call gOFS->eosView->createContainer(): " <<
-            e.getMessage().str();
-        e.getMessage().str(msg.str());
-        throw;
+        for (int idx : group.mItems) {
+          const auto& it = request->container(idx);
+          reply->set_message(idx, SSTR("Failed to insert cid=" << it.id() <<
+                                       ", errno=" << e.getErrno() << ", path=" << it.path() <<
+                                       ": Failed to get parent container: " <<
+                                       e.getMessage().str()));
+          reply->set_retc(idx, e.getErrno());
+        }
+
+        continue;
       }
 
-      eos::IContainerMD::ctime_t ctime;
-      eos::IContainerMD::ctime_t mtime;
-      eos::IContainerMD::ctime_t stime;
-      ctime.tv_sec  = it.ctime().sec();
-      ctime.tv_nsec = it.ctime().n_sec();
-      mtime.tv_sec  = it.mtime().sec();
-      mtime.tv_nsec = it.mtime().n_sec();
-      stime.tv_sec  = it.stime().sec();
-      stime.tv_nsec = it.stime().n_sec();
-      // we can send flags or mode to store in flags ... sigh
-      newdir->setFlags(it.flags());
-      newdir->setCTime(ctime);
-      newdir->setMTime(mtime);
-      newdir->setTMTime(stime);
-      newdir->setCUid(it.uid());
-      newdir->setCGid(it.gid());
-      newdir->setMode(it.mode() | S_IFDIR);
-      std::shared_ptr<eos::IContainerMD> parent;
+      eos::MDLocking::ContainerWriteLockPtr parent_lock =
+        eos::MDLocking::writeLock(parent);
+      eos::IContainerMD::ctime_t parent_mtime {0, 0};
+      bool modified = false;
+
+      for (int idx : group.mItems) {
+        const auto& it = request->container(idx);
+
+        if (exists[idx]) {
+          std::ostringstream ss;
+          ss << "Attempted to create container with id=" << it.id() <<
+             ", which already exists";
+          eos_static_err("%s", ss.str().c_str());
+          reply->set_message(idx, ss.str());
+          reply->set_retc(idx, EINVAL);
+          continue;
+        }
 
-      if (inherit) {
-        eos::common::Path cPath(it.path());
+        eos_static_info("creating path=%s id=%lx inherit_md=%d",
+                        it.path().c_str(), it.id(), inherit);
 
         try {
-          parent = gOFS->eosView->getContainer(cPath.GetParentPath());
-        } catch (eos::MDException& e) {
-          std::ostringstream msg;
-          msg << "Failed to call parent gOFS->eosView->getContainer(): " <<
-              e.getMessage().str();
-          e.getMessage().str(msg.str());
-          throw;
-        }
+          eos::common::Path cPath(it.path());
+          std::string name = cPath.GetName();
+          eos::FileOrContainerMD conflict = parent->findItem(name).get();
 
-        if (it.mode() == 0) {
-          newdir->setMode(parent->getMode());
-        }
+          if (name.empty() || conflict.file || conflict.container) {
+            throw_mdexception(EEXIST, it.path() << ": Container exists");
+          }
 
-        for (const auto& attrit : parent->getAttributes()) {
-          newdir->setAttribute(attrit.first, attrit.second);
-        }
-      }
+          std::shared_ptr<eos::IContainerMD> newdir =
+            gOFS->eosDirectoryService->createContainer(it.id());
+          eos::IContainerMD::ctime_t ctime;
+          eos::IContainerMD::ctime_t mtime;
+          eos::IContainerMD::ctime_t stime;
+          ctime.tv_sec  = it.ctime().sec();
+          ctime.tv_nsec = it.ctime().n_sec();
+          mtime.tv_sec  = it.mtime().sec();
+          mtime.tv_nsec = it.mtime().n_sec();
+          stime.tv_sec  = it.stime().sec();
+          stime.tv_nsec = it.stime().n_sec();
+          newdir->setName(name);
+          // we can send flags or mode to store in flags ... sigh
+          newdir->setFlags(it.flags());
+          newdir->setCTime(ctime);
+          newdir->setMTime(mtime);
+          newdir->setTMTime(stime);
+          newdir->setCUid(it.uid());
+          newdir->setCGid(it.gid());
+          newdir->setMode(it.mode() | S_IFDIR);
+
+          if (inherit) {
+            if (it.mode() == 0) {
+              newdir->setMode(parent->getMode());
+            }
 
-      struct timespec now;
+            for (const auto& attrit : parent->getAttributes()) {
+              newdir->setAttribute(attrit.first, attrit.second);
+            }
 
-      eos::common::Timing::GetTimeSpec(now);
+            parent_mtime = ctime;
+          }
+
+          struct timespec now;
 
-      newdir->setAttribute("sys.eos.btime",
-                           SSTR(now.tv_sec << "." << now.tv_nsec));
+          eos::common::Timing::GetTimeSpec(now);
 
-      for (auto attrit : it.xattrs()) {
-        newdir->setAttribute(attrit.first, attrit.second);
+          newdir->setAttribute("sys.eos.btime",
+                               SSTR(now.tv_sec << "." << now.tv_nsec));
+
+          for (auto attrit : it.xattrs()) {
+            newdir->setAttribute(attrit.first, attrit.second);
+          }
+
+          parent->addContainer(newdir.get());
+          gOFS->eosView->updateContainerStore(newdir.get());
+          modified = true;
+        } catch (eos::MDException& e) {
+          eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\" path=\"%s\" fxid=%08llx\n",
+                         e.getErrno(), e.getMessage().str().c_str(), it.path().c_str(), it.id());
+          reply->set_message(idx, SSTR("Failed to insert cid=" << it.id() <<
+                                       ", errno=" << e.getErrno() << ", path=" << it.path() <<
+                                       ": " << e.getMessage().str()));
+          reply->set_retc(idx, e.getErrno());
+        }
       }
 
-      try {
-        gOFS->eosView->updateContainerStore(newdir.get());
+      // The parent is updated once per group
+      if (modified) {
+        try {
+          if (inherit) {
+            parent->setMTime(parent_mtime);
+            parent->notifyMTimeChange(gOFS->eosDirectoryService);
+          }
 
-        if (parent) {
-          parent->setMTime(ctime);
-          parent->notifyMTimeChange(gOFS->eosDirectoryService);
           gOFS->eosView->updateContainerStore(parent.get());
+        } catch (eos::MDException& e) {
+          eos_static_err("msg=\"failed to update parent container\" ec=%d "
+                         "emsg=\"%s\" path=\"%s\"", e.getErrno(),
+                         e.getMessage().str().c_str(), group.mParent.c_str());
         }
-      } catch (eos::MDException& e) {
-        std::ostringstream msg;
-        msg << "Failed to call gOFS->eosView->updateContainerStore(): " <<
-            e.getMessage().str();
-        e.getMessage().str(msg.str());
-        throw;
       }
-
-      reply->add_message("");
-      reply->add_retc(0);
-    } catch (eos::MDException& e) {
-      eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\" path=\"%s\" fxid=%08llx\n",
-                     e.getErrno(), e.getMessage().str().c_str(), it.path().c_str(), it.id());
-      reply->add_message(SSTR("Failed to insert cid=" << it.id() << ", errno=" <<
-                              e.getErrno() << ", path=" << it.path() << ": " << e.getMessage().str()));
-      reply->add_retc(e.getErrno());
     }
   }
 
@@ -57,23 +57,23 @@ public:
 
 
   static grpc::Status GetMD(eos::common::VirtualIdentity& vid,
-                            grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                            grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                             const eos::rpc::MDRequest* request, bool check_perms = true,
                             bool lock = true,
                             bool access_self = false);
 
   static grpc::Status Stat(eos::common::VirtualIdentity& vid,
-                           grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                           grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                            const eos::rpc::MDRequest* request);
 
   static grpc::Status StreamMD(eos::common::VirtualIdentity& vid,
-                               grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                               grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                                const eos::rpc::MDRequest* request,
                                bool streamparent = true,
                                std::vector<uint64_t>* childdirs = 0);
 
   static grpc::Status Find(eos::common::VirtualIdentity& vid,
-                           grpc::ServerWriter<eos::rpc::MDResponse>* writer,
+                           grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer,
                            const eos::rpc::FindRequest* request);
 
   static grpc::Status NsStat(eos::common::VirtualIdentity& vid,
@@ -23,6 +23,7 @@
 
 #include "GrpcServer.hh"
 #include "GrpcNsInterface.hh"
+#include "GrpcAsyncServer.hh"
 #include <google/protobuf/util/json_util.h>
 #include "common/Logging.hh"
 #include "common/StringConversion.hh"
@@ -57,109 +58,162 @@ class RequestServiceImpl final : public Eos::Service
   Status Ping(ServerContext* context, const eos::rpc::PingRequest* request,
               eos::rpc::PingReply* reply) override
   {
-    eos_static_info("grpc::ping from client peer=%s ip=%s DN=%s token=%s len=%lu",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str(),
-                    request->message().length());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    reply->set_message(request->message());
-    return Status::OK;
+    return GrpcServer::Ping(context, request, reply);
   }
 
   Status FileInsert(ServerContext* context,
                     const eos::rpc::FileInsertRequest* request,
                     eos::rpc::InsertReply* reply) override
   {
-    eos_static_info("grpc::fileinsert from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::FileInsert(vid, reply, request);
+    return GrpcServer::FileInsert(context, request, reply);
   }
 
   Status ContainerInsert(ServerContext* context,
                          const eos::rpc::ContainerInsertRequest* request,
                          eos::rpc::InsertReply* reply) override
   {
-    eos_static_info("grpc::containerinsert from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::ContainerInsert(vid, reply, request);
+    return GrpcServer::ContainerInsert(context, request, reply);
   }
 
   Status MD(ServerContext* context, const eos::rpc::MDRequest* request,
             ServerWriter<eos::rpc::MDResponse>* writer) override
   {
-    eos_static_info("grpc::md from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-
-    switch (request->type()) {
-    case eos::rpc::FILE:
-    case eos::rpc::CONTAINER:
-    case eos::rpc::STAT:
-      return GrpcNsInterface::Stat(vid, writer, request);
-      break;
-
-    case eos::rpc::LISTING:
-      return GrpcNsInterface::StreamMD(vid, writer, request);
-      break;
-
-    default:
-      ;
-    }
-
-    return Status(grpc::StatusCode::INVALID_ARGUMENT, "request is not supported");
+    return GrpcServer::MD(context, request, writer);
   }
 
   Status Find(ServerContext* context, const eos::rpc::FindRequest* request,
               ServerWriter<eos::rpc::MDResponse>* writer) override
   {
-    eos_static_info("grpc::find from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::Find(vid, writer, request);
+    return GrpcServer::Find(context, request, writer);
   }
 
   Status NsStat(ServerContext* context,
                 const eos::rpc::NsStatRequest* request,
                 eos::rpc::NsStatResponse* reply) override
   {
-    eos_static_info("grpc::nsstat::request from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::NsStat(vid, reply, request);
+    return GrpcServer::NsStat(context, request, reply);
   }
 
   Status Exec(ServerContext* context,
               const eos::rpc::NSRequest* request,
               eos::rpc::NSResponse* reply) override
   {
-    eos_static_info("grpc::exec::request from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::Exec(vid, reply, request);
+    return GrpcServer::Exec(context, request, reply);
   }
 };
 
+Status
+GrpcServer::Ping(ServerContext* context, const eos::rpc::PingRequest* request,
+                 eos::rpc::PingReply* reply)
+{
+  eos_static_info("grpc::ping from client peer=%s ip=%s DN=%s token=%s len=%lu",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str(),
+                  request->message().length());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  reply->set_message(request->message());
+  return Status::OK;
+}
+
+Status
+GrpcServer::FileInsert(ServerContext* context,
+                       const eos::rpc::FileInsertRequest* request,
+                       eos::rpc::InsertReply* reply)
+{
+  eos_static_info("grpc::fileinsert from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+  return GrpcNsInterface::FileInsert(vid, reply, request);
+}
+
+Status
+GrpcServer::ContainerInsert(ServerContext* context,
+                            const eos::rpc::ContainerInsertRequest* request,
+                            eos::rpc::InsertReply* reply)
+{
+  eos_static_info("grpc::containerinsert from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+  return GrpcNsInterface::ContainerInsert(vid, reply, request);
+}
+
+Status
+GrpcServer::MD(ServerContext* context, const eos::rpc::MDRequest* request,
+               grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer)
+{
+  eos_static_info("grpc::md from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+
+  switch (request->type()) {
+  case eos::rpc::FILE:
+  case eos::rpc::CONTAINER:
+  case eos::rpc::STAT:
+    return GrpcNsInterface::Stat(vid, writer, request);
+    break;
+
+  case eos::rpc::LISTING:
+    return GrpcNsInterface::StreamMD(vid, writer, request);
+    break;
+
+  default:
+    ;
+  }
+
+  return Status(grpc::StatusCode::INVALID_ARGUMENT, "request is not supported");
+}
+
+Status
+GrpcServer::Find(ServerContext* context, const eos::rpc::FindRequest* request,
+                 grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer)
+{
+  eos_static_info("grpc::find from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+  return GrpcNsInterface::Find(vid, writer, request);
+}
+
+Status
+GrpcServer::NsStat(ServerContext* context,
+                   const eos::rpc::NsStatRequest* request,
+                   eos::rpc::NsStatResponse* reply)
+{
+  eos_static_info("grpc::nsstat::request from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+  return GrpcNsInterface::NsStat(vid, reply, request);
+}
+
+Status
+GrpcServer::Exec(ServerContext* context,
+                 const eos::rpc::NSRequest* request,
+                 eos::rpc::NSResponse* reply)
+{
+  eos_static_info("grpc::exec::request from client peer=%s ip=%s DN=%s token=%s",
+                  context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                  GrpcServer::DN(context).c_str(), request->authkey().c_str());
+  eos::common::VirtualIdentity vid;
+  GrpcServer::Vid(context, vid, request->authkey());
+  WAIT_BOOT;
+  return GrpcNsInterface::Exec(vid, reply, request);
+}
+
 /* return client DN*/
 std::string
 GrpcServer::DN(grpc::ServerContext* context)
@@ -308,13 +362,32 @@ GrpcServer::Run(ThreadAssistant& assistant) noexcept
     builder.AddListeningPort(bind_address, grpc::InsecureServerCredentials());
   }
 
-  builder.RegisterService(&service);
+  // The asynchronous service serves the namespace calls from a few completion
+  // queue threads and bounded worker pools instead of a thread per call
+  std::unique_ptr<GrpcAsyncServer> async_service;
+  const char* async = getenv("EOS_MGM_GRPC_ASYNC");
+
+  if (async && (std::string(async) == "1")) {
+    async_service.reset(new GrpcAsyncServer(GrpcAsyncServer::Options::FromEnv()));
+    async_service->Register(builder);
+  } else {
+    builder.RegisterService(&service);
+  }
+
   mServer = builder.BuildAndStart();
 
   if (mServer) {
+    if (async_service) {
+      async_service->Start();
+    }
+
     mServer->Wait();
   }
 
+  if (async_service) {
+    async_service->Shutdown();
+  }
+
 #else
   // Make the compiler happy
   (void) mPort;
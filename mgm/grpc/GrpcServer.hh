@@ -27,6 +27,25 @@
 #include "common/Mapping.hh"
 #ifdef EOS_GRPC
 #include <grpc++/grpc++.h>
+
+namespace eos
+{
+namespace rpc
+{
+class PingRequest;
+class PingReply;
+class FileInsertRequest;
+class ContainerInsertRequest;
+class InsertReply;
+class MDRequest;
+class MDResponse;
+class FindRequest;
+class NsStatRequest;
+class NsStatResponse;
+class NSRequest;
+class NSResponse;
+}
+}
 #endif
 
 EOSMGMNAMESPACE_BEGIN
@@ -93,6 +112,29 @@ public:
                   eos::common::VirtualIdentity& vid,
                   const std::string& authkey);
 
+  /* RPC implementations shared by the synchronous and asynchronous service */
+  static grpc::Status Ping(grpc::ServerContext* context,
+                           const eos::rpc::PingRequest* request,
+                           eos::rpc::PingReply* reply);
+  static grpc::Status FileInsert(grpc::ServerContext* context,
+                                 const eos::rpc::FileInsertRequest* request,
+                                 eos::rpc::InsertReply* reply);
+  static grpc::Status ContainerInsert(grpc::ServerContext* context,
+                                      const eos::rpc::ContainerInsertRequest* request,
+                                      eos::rpc::InsertReply* reply);
+  static grpc::Status MD(grpc::ServerContext* context,
+                         const eos::rpc::MDRequest* request,
+                         grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer);
+  static grpc::Status Find(grpc::ServerContext* context,
+                           const eos::rpc::FindRequest* request,
+                           grpc::ServerWriterInterface<eos::rpc::MDResponse>* writer);
+  static grpc::Status NsStat(grpc::ServerContext* context,
+                             const eos::rpc::NsStatRequest* request,
+                             eos::rpc::NsStatResponse* reply);
+  static grpc::Status Exec(grpc::ServerContext* context,
+                           const eos::rpc::NSRequest* request,
+                           eos::rpc::NSResponse* reply);
+
 #endif
 };
 
@@ -40,6 +40,52 @@ EOSMGMNAMESPACE_BEGIN
                           </head><body>No such file or directory</body></html>"
 
 #ifdef EOS_MICRO_HTTPD
+namespace
+{
+//------------------------------------------------------------------------------
+//! Streamed response owning its protocol handler until MHD releases it
+//------------------------------------------------------------------------------
+struct StreamedResponse {
+  std::unique_ptr<eos::common::ProtocolHandler> mHandler;
+  std::string mChunk; ///< Current piece of the body
+  size_t mPos {0}; ///< Offset of the next byte to send in mChunk
+  bool mLast {false}; ///< mChunk is the last piece of the body
+};
+
+//------------------------------------------------------------------------------
+//! MHD reader callback pulling the body from the response generator
+//------------------------------------------------------------------------------
+ssize_t
+StreamReaderCallback(void* cls, uint64_t pos, char* buf, size_t max)
+{
+  StreamedResponse* stream = static_cast<StreamedResponse*>(cls);
+
+  while (stream->mPos == stream->mChunk.size()) {
+    if (stream->mLast) {
+      return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+
+    stream->mLast = !stream->mHandler->GetResponse()->NextBodyChunk(
+                      stream->mChunk);
+    stream->mPos = 0;
+  }
+
+  size_t len = std::min(max, stream->mChunk.size() - stream->mPos);
+  memcpy(buf, stream->mChunk.data() + stream->mPos, len);
+  stream->mPos += len;
+  return len;
+}
+
+//------------------------------------------------------------------------------
+//! MHD callback releasing a streamed response
+//------------------------------------------------------------------------------
+void
+StreamFreeCallback(void* cls)
+{
+  delete static_cast<StreamedResponse*>(cls);
+}
+}
+
 /*----------------------------------------------------------------------------*/
 int
 HttpServer::Handler(void* cls,
@@ -86,47 +132,7 @@ HttpServer::Handler(void* cls,
       }
     }
 
-    // Clients which are gateways/sudoer can pass x-forwarded-for and remote-user
-    if (headers.count("x-forwarded-for")) {
-      // Check if this is a http gateway and sudoer by calling the mapping function
-      std::unique_ptr<VirtualIdentity> vid_tmp  {new VirtualIdentity()};
-
-      if (vid_tmp) {
-        XrdSecEntity eclient(headers.count("x-real-ip") ? "https" : "http");
-        eclient.tident = "";
-        eclient.name = (char*)"nobody";
-        eclient.host = (char*)(headers["client-real-host"].length() ?
-                               headers["client-real-host"].c_str() : "");
-
-        if (headers.count("x-gateway-authorization")) {
-          eclient.endorsements = (char*)headers["x-gateway-authorization"].c_str();
-        }
-
-        std::string stident = "https.0:0@";
-        stident += headers["client-real-host"];
-        eos::common::Mapping::IdMap(&eclient, "", stident.c_str(), *vid_tmp);
-
-        if (!vid_tmp->isGateway() ||
-            ((vid_tmp->prot != "https") && (vid_tmp->prot != "http"))) {
-          headers.erase("x-forwarded-for");
-          headers.erase("x-real-ip");
-        }
-
-        eos_static_debug("vid trace: %s gw:%d", vid_tmp->getTrace().c_str(),
-                         vid_tmp->isGateway());
-
-        if (headers.count("x-gateway-authorization") && !vid_tmp->sudoer) {
-          headers.erase("remote-user");
-        }
-      } else {
-        eos_static_err("msg=\"failed to allocate VirtualIdentity object\" "
-                       "method=%s", method);
-        return MHD_NO;
-      }
-    } else {
-      headers.erase("x-real-ip");
-      headers.erase("remote-user");
-    }
+    FilterGatewayHeaders(headers);
 
     // Authenticate the client
     eos::common::VirtualIdentity* vid = Authenticate(headers);
@@ -207,9 +213,25 @@ HttpServer::Handler(void* cls,
   eos_static_debug("\n\n%s", response->ToString().c_str());
   // Create the response
   struct MHD_Response* mhdResponse;
-  mhdResponse = MHD_create_response_from_buffer(response->GetBodySize(), (void*)
-                response->GetBody().c_str(),
-                MHD_RESPMEM_MUST_COPY);
+
+  if (response->IsStreamed()) {
+    // The response takes over the protocol handler, it is released by MHD
+    // once the body is sent
+    StreamedResponse* stream = new StreamedResponse();
+    stream->mHandler.reset(protocolHandler);
+    protocolHandler = nullptr;
+    mhdResponse = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                  256 * 1024, &StreamReaderCallback, stream,
+                  &StreamFreeCallback);
+
+    if (!mhdResponse) {
+      delete stream;
+    }
+  } else {
+    mhdResponse = MHD_create_response_from_buffer(response->GetBodySize(), (void*)
+                  response->GetBody().c_str(),
+                  MHD_RESPMEM_MUST_COPY);
+  }
 
   if (mhdResponse) {
     // Add all the response header tags
@@ -270,6 +292,141 @@ HttpServer::CompleteHandler(void*                              cls,
 
 #endif
 
+//------------------------------------------------------------------------------
+// Drop the gateway headers unless the client is a gateway allowed to pass them
+//------------------------------------------------------------------------------
+void
+HttpServer::FilterGatewayHeaders(std::map<std::string, std::string>& headers)
+{
+  using namespace eos::common;
+
+  // Clients which are gateways/sudoer can pass x-forwarded-for and remote-user
+  if (headers.count("x-forwarded-for")) {
+    // Check if this is a http gateway and sudoer by calling the mapping function
+    std::unique_ptr<VirtualIdentity> vid_tmp  {new VirtualIdentity()};
+    XrdSecEntity eclient(headers.count("x-real-ip") ? "https" : "http");
+    eclient.tident = "";
+    eclient.name = (char*)"nobody";
+    eclient.host = (char*)(headers["client-real-host"].length() ?
+                           headers["client-real-host"].c_str() : "");
+
+    if (headers.count("x-gateway-authorization")) {
+      eclient.endorsements = (char*)headers["x-gateway-authorization"].c_str();
+    }
+
+    std::string stident = "https.0:0@";
+    stident += headers["client-real-host"];
+    eos::common::Mapping::IdMap(&eclient, "", stident.c_str(), *vid_tmp);
+
+    if (!vid_tmp->isGateway() ||
+        ((vid_tmp->prot != "https") && (vid_tmp->prot != "http"))) {
+      headers.erase("x-forwarded-for");
+      headers.erase("x-real-ip");
+    }
+
+    eos_static_debug("vid trace: %s gw:%d", vid_tmp->getTrace().c_str(),
+                     vid_tmp->isGateway());
+
+    if (headers.count("x-gateway-authorization") && !vid_tmp->sudoer) {
+      headers.erase("remote-user");
+    }
+  } else {
+    headers.erase("x-real-ip");
+    headers.erase("remote-user");
+  }
+}
+
+//------------------------------------------------------------------------------
+// HTTP exchange handler function of the event-driven server
+//------------------------------------------------------------------------------
+void
+HttpServer::HandleExchange(eos::common::HttpExchange& exchange)
+{
+  using namespace eos::common;
+  // Wait for the namespace to boot
+  WAIT_BOOT;
+  const std::string& method = exchange.GetMethod();
+  std::map<std::string, std::string> headers = exchange.GetHeaders();
+  headers["client-real-ip"] = exchange.GetClientIp();
+  XrdNetAddr netaddr(exchange.GetClientAddress());
+  const char* name = netaddr.Name();
+
+  if (name) {
+    headers["client-real-host"] = name;
+  }
+
+  FilterGatewayHeaders(headers);
+  // Authenticate the client
+  eos::common::VirtualIdentity* vid = Authenticate(headers);
+  eos_static_info("request=%s client-real-ip=%s client-real-host=%s vid.uid=%s vid.gid=%s vid.host=%s vid.tident=%s\n",
+                  method.c_str(), headers["client-real-ip"].c_str(),
+                  headers["client-real-host"].c_str(), vid->uid_string.c_str(),
+                  vid->gid_string.c_str(), vid->host.c_str(), vid->tident.c_str());
+  ProtocolHandlerFactory factory = ProtocolHandlerFactory();
+  std::unique_ptr<eos::common::ProtocolHandler> handler(
+    factory.CreateProtocolHandler(method, headers, vid));
+
+  if (!handler) {
+    eos_static_err("msg=\"no matching protocol for request method %s\"",
+                   method.c_str());
+    delete vid;
+    exchange.SendResponse(HttpResponse::METHOD_NOT_ALLOWED,
+                          HttpExchange::HeaderMap(), "");
+    return;
+  }
+
+  // PUT is answered with a redirect before its body is read, this avoids
+  // the generation of 100-CONTINUE
+  std::string body;
+
+  if ((method != "PUT") && !exchange.ReadBody(body, cMaxRequestBody)) {
+    eos_static_err("msg=\"failed to read request body\" method=%s path=\"%s\"",
+                   method.c_str(), exchange.GetPath().c_str());
+    exchange.SendResponse(HttpResponse::BAD_REQUEST, HttpExchange::HeaderMap(),
+                          "");
+    return;
+  }
+
+  size_t bodySize = body.size();
+  HttpRequest request(headers, method, exchange.GetPath(), exchange.GetQuery(),
+                      body, &bodySize, exchange.GetCookies());
+  eos_static_debug("\n\n%s\n%s\n", request.ToString().c_str(),
+                   request.GetBody().c_str());
+  handler->HandleRequest(&request);
+  HttpResponse* response = handler->GetResponse();
+
+  if (!response) {
+    eos_static_crit("msg=\"response creation failed\"");
+    exchange.SendResponse(HttpResponse::INTERNAL_SERVER_ERROR,
+                          HttpExchange::HeaderMap(), "");
+    return;
+  }
+
+  eos_static_debug("\n\n%s", response->ToString().c_str());
+
+  if (!response->IsStreamed()) {
+    exchange.SendResponse(response->GetResponseCode(), response->GetHeaders(),
+                          response->GetBody());
+    return;
+  }
+
+  if (!exchange.SendResponseHead(response->GetResponseCode(),
+                                 response->GetHeaders(), -1)) {
+    return;
+  }
+
+  std::string chunk;
+  bool more = true;
+
+  while (more) {
+    more = response->NextBodyChunk(chunk);
+
+    if (chunk.size() && !exchange.SendBody(chunk.data(), chunk.size())) {
+      break;
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Do a "rough" mapping between HTTP verbs and access operation types
 //
@@ -94,6 +94,14 @@ public:
 
 #endif
 
+  /**
+   * HTTP exchange handler function on MGM called by the event-driven server
+   *
+   * @param exchange the request to serve and its response
+   */
+  virtual void
+  HandleExchange(eos::common::HttpExchange& exchange);
+
   /**
    * Authenticate the client request by inspecting the SSL headers which were
    * transmitted by the reverse proxy server and attempting to map the client
@@ -152,6 +160,17 @@ public:
   //----------------------------------------------------------------------------
   std::string ProcessClientDN(const std::string& cnd) const;
 
+  //----------------------------------------------------------------------------
+  //! Drop the x-forwarded-for, x-real-ip and remote-user headers unless the
+  //! client is a http gateway (and sudoer) allowed to pass them
+  //!
+  //! @param headers request headers including client-real-host
+  //----------------------------------------------------------------------------
+  void FilterGatewayHeaders(std::map<std::string, std::string>& headers);
+
+  //! Maximum request body buffered by the event-driven server
+  static constexpr size_t cMaxRequestBody {128 * 1024 * 1024};
+
   //----------------------------------------------------------------------------
   //! Build path and opaque information based on the HTTP headers
   //!
@@ -33,6 +33,8 @@
 #include "common/Path.hh"
 #include "common/http/OwnCloud.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
+#include <algorithm>
+#include <atomic>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -40,6 +42,46 @@ EOSMGMNAMESPACE_BEGIN
 char dav_rfc3986[256] = {0};
 char dav_html5[256] = {0};
 
+namespace
+{
+//! Number of <response/> nodes streamed per chunk
+constexpr size_t cPropFindBatch = 512;
+
+//! Running depth infinity walks
+std::atomic<int> gPropFindWalks {0};
+
+//------------------------------------------------------------------------------
+//! Limits of the depth infinity PROPFIND, configured once from the env.
+//! A limit of 0 entries or levels disables depth infinity.
+//------------------------------------------------------------------------------
+struct PropFindLimits {
+  uint64_t mMaxEntries = 100000; ///< Maximum number of streamed entries
+  int mMaxLevel = 32; ///< Maximum number of levels below the resource
+  int mMaxWalks = 4; ///< Maximum number of concurrent walks
+
+  PropFindLimits()
+  {
+    if (getenv("EOS_MGM_HTTP_PROPFIND_MAX_ENTRIES")) {
+      mMaxEntries = strtoull(getenv("EOS_MGM_HTTP_PROPFIND_MAX_ENTRIES"), 0, 10);
+    }
+
+    if (getenv("EOS_MGM_HTTP_PROPFIND_MAX_DEPTH")) {
+      mMaxLevel = std::max(atoi(getenv("EOS_MGM_HTTP_PROPFIND_MAX_DEPTH")), 0);
+    }
+
+    if (getenv("EOS_MGM_HTTP_PROPFIND_MAX_WALKS")) {
+      mMaxWalks = std::max(atoi(getenv("EOS_MGM_HTTP_PROPFIND_MAX_WALKS")), 1);
+    }
+  }
+};
+
+const PropFindLimits& GetPropFindLimits()
+{
+  static const PropFindLimits limits;
+  return limits;
+}
+}
+
 /*----------------------------------------------------------------------------*/
 void
 dav_uri_encode(unsigned char* s, char* enc, char* tb)
@@ -80,6 +122,15 @@ dav_uri_decode(char* source, char* dest)
 }
 
 
+/*----------------------------------------------------------------------------*/
+PropFindResponse::~PropFindResponse()
+{
+  // Give back the walk slot of an aborted depth infinity response
+  if (mInfinity) {
+    --gPropFindWalks;
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 std::string
 PropFindResponse::EncodeURI(const char* uri)
@@ -123,19 +174,6 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     }
   }
 
-  // Build the response
-  // xml declaration
-  xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
-  decl->append_attribute(AllocateAttribute("version", "1.0"));
-  decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
-  mXMLResponseDocument.append_node(decl);
-  // <multistatus/> node
-  xml_node<>* multistatusNode = AllocateNode("d:multistatus");
-  multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
-  multistatusNode->append_attribute(
-    AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
-                      eos::common::OwnCloud::OwnCloudNsUrl()));
-  mXMLResponseDocument.append_node(multistatusNode);
   // Is the requested resource a file or directory?
   XrdOucErrInfo error;
   struct stat statInfo;
@@ -150,87 +188,251 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
   std::string depth = request->GetHeaders()["depth"];
   eos_static_debug("depth=%s, isdir=%d", depth.c_str(),
                    S_ISDIR(statInfo.st_mode));
-  xml_node<>* responseNode = 0;
 
   if (depth == "0" || !S_ISDIR(statInfo.st_mode)) {
     // Simply stat the file or direcAtory
-    responseNode = BuildResponseNode(request->GetUrl(), request->GetUrl(true));
+    // xml declaration
+    xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
+    decl->append_attribute(AllocateAttribute("version", "1.0"));
+    decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
+    mXMLResponseDocument.append_node(decl);
+    // <multistatus/> node
+    xml_node<>* multistatusNode = AllocateNode("d:multistatus");
+    multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
+    multistatusNode->append_attribute(
+      AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
+                        eos::common::OwnCloud::OwnCloudNsUrl()));
+    mXMLResponseDocument.append_node(multistatusNode);
+    xml_node<>* responseNode = BuildResponseNode(request->GetUrl(),
+                               request->GetUrl(true));
 
     if (responseNode) {
       multistatusNode->append_node(responseNode);
     } else {
       return this;
     }
-  } else if (depth == "1") {
-    // Stat the resource and all child resources
-    XrdMgmOfsDirectory directory;
-    int listrc = directory.open(request->GetUrl().c_str(), *mVirtualIdentity,
-                                (const char*) 0);
-    responseNode = BuildResponseNode(request->GetUrl().c_str(),
-                                     request->GetUrl(true).c_str());
 
-    if (responseNode) {
-      multistatusNode->append_node(responseNode);
-    }
+    std::string responseString;
+    rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
+                    rapidxml::print_no_indenting);
+    mXMLResponseDocument.clear();
+    SetResponseCode(HttpResponse::MULTI_STATUS);
+    AddHeader("Content-Length", std::to_string((long long) responseString.size()));
+    AddHeader("Content-Type", "application/xml; charset=utf-8");
+    SetBody(responseString);
+    return this;
+  }
 
-    if (!listrc) {
-      const char* val;
+  // Directory listings are streamed batch by batch with the chunked transfer
+  // encoding, Depth 1 lists the children and infinity the whole subtree
+  // within the configured limits. A missing Depth header means infinity.
+  const std::string noroot = ",noroot";
 
-      while ((val = directory.nextEntry())) {
-        XrdOucString entryname = val;
+  if ((depth.length() > noroot.length()) &&
+      (depth.compare(depth.length() - noroot.length(), noroot.length(),
+                     noroot) == 0)) {
+    mStreamRoot = false;
+    depth.erase(depth.length() - noroot.length());
+  }
 
-        // don't display . .., atomic(+version) uploads and version directories
-        if (entryname.beginswith(EOS_COMMON_PATH_VERSION_FILE_PREFIX) ||
-            entryname.beginswith(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) ||
-            entryname.beginswith(EOS_WEBDAV_HIDE_IN_PROPFIND_PREFIX) ||
-            entryname.beginswith("...eos.ino...") ||
-            (entryname == ".") ||
-            (entryname == "..")) {
-          // skip over . .., and hidden files
-          continue;
-        }
+  if (depth == "infinity" || depth == "") {
+    const PropFindLimits& limits = GetPropFindLimits();
 
-        // one response node for each file...
-        eos::common::Path path((request->GetUrl() + std::string("/") + std::string(
-                                  val)).c_str());
-        eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
-                                   std::string(val)).c_str());
-        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
-
-        if (responseNode) {
-          multistatusNode->append_node(responseNode);
-        } else {
-          // We might have a failed stat in the BuildResponseNode if there are
-          // symlinks present
-          SetResponseCode(HttpResponse::OK);
-        }
-      }
-    } else {
-      eos_static_warning("msg=\"error opening directory - might be stalled/banned\"");
+    if (!limits.mMaxEntries || !limits.mMaxLevel) {
+      // RFC 4918 9.1 - depth infinity is disabled
       SetResponseCode(ResponseCodes::FORBIDDEN);
+      AddHeader("Content-Type", "application/xml; charset=utf-8");
+      SetBody("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+              "<d:error xmlns:d=\"DAV:\"><d:propfind-finite-depth/></d:error>");
       return this;
     }
-  } else if (depth == "1,noroot") {
-    // Stat all child resources but not the requested resource
-    SetResponseCode(HttpResponse::NOT_IMPLEMENTED);
+
+    // Throttle the number of concurrent depth infinity walks
+    if (++gPropFindWalks > limits.mMaxWalks) {
+      --gPropFindWalks;
+      eos_static_warning("msg=\"too many depth infinity propfind requests\" "
+                         "max=%d url=\"%s\"", limits.mMaxWalks,
+                         request->GetUrl().c_str());
+      SetResponseCode(ResponseCodes::SERVICE_UNAVAILABLE);
+      AddHeader("Retry-After", "5");
+      return this;
+    }
+
+    mInfinity = true;
+    mMaxLevel = limits.mMaxLevel;
+  } else if (depth != "1") {
+    SetResponseCode(ResponseCodes::BAD_REQUEST);
     return this;
-  } else if (depth == "infinity" || depth == "") {
-    // Recursively stat the resource and all child resources
-    SetResponseCode(HttpResponse::NOT_IMPLEMENTED);
+  }
+
+  // Open the requested directory up front so that a failed listing is still
+  // answered with an error code
+  mCurrentDir = {request->GetUrl(), request->GetUrl(true), 0};
+  mDirectory.reset(new XrdMgmOfsDirectory());
+
+  if (mDirectory->open(mCurrentDir.mUrl.c_str(), *mVirtualIdentity,
+                       (const char*) 0)) {
+    eos_static_warning("msg=\"error opening directory - might be stalled/banned\"");
+    mDirectory.reset();
+    SetResponseCode(ResponseCodes::FORBIDDEN);
     return this;
   }
 
-  std::string responseString;
-  rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
-                  rapidxml::print_no_indenting);
-  mXMLResponseDocument.clear();
+  mRootHref = mCurrentDir.mHref;
   SetResponseCode(HttpResponse::MULTI_STATUS);
-  AddHeader("Content-Length", std::to_string((long long) responseString.size()));
   AddHeader("Content-Type", "application/xml; charset=utf-8");
-  SetBody(responseString);
+  SetBodyGenerator([this](std::string & chunk) {
+    return StreamNextBatch(chunk);
+  });
   return this;
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+PropFindResponse::StreamNextBatch(std::string& chunk)
+{
+  using namespace rapidxml;
+
+  if (!mStreamStarted) {
+    mStreamStarted = true;
+    chunk += "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+             "<d:multistatus xmlns:d=\"DAV:\" ";
+    chunk += eos::common::OwnCloud::OwnCloudNs();
+    chunk += "=\"";
+    chunk += eos::common::OwnCloud::OwnCloudNsUrl();
+    chunk += "\">";
+
+    if (mStreamRoot) {
+      xml_node<>* responseNode = BuildResponseNode(mCurrentDir.mUrl,
+                                 mCurrentDir.mHref);
+
+      if (responseNode) {
+        rapidxml::print(std::back_inserter(chunk), *responseNode,
+                        rapidxml::print_no_indenting);
+      }
+    }
+  }
+
+  const PropFindLimits& limits = GetPropFindLimits();
+  size_t batch = 0;
+
+  while (batch < cPropFindBatch) {
+    if (!mDirectory) {
+      if (mPendingDirs.empty()) {
+        break;
+      }
+
+      // Opening the directory stages the metadata of all its children through
+      // the Prefetcher, the stat of every entry is then served from the cache
+      mCurrentDir = mPendingDirs.front();
+      mPendingDirs.pop_front();
+      mDirectory.reset(new XrdMgmOfsDirectory());
+
+      if (mDirectory->open(mCurrentDir.mUrl.c_str(), *mVirtualIdentity,
+                           (const char*) 0)) {
+        eos_static_warning("msg=\"skip directory which can not be listed\" "
+                           "path=\"%s\"", mCurrentDir.mUrl.c_str());
+        mDirectory.reset();
+      }
+
+      continue;
+    }
+
+    const char* val = mDirectory->nextEntry();
+
+    if (!val) {
+      mDirectory->close();
+      mDirectory.reset();
+      continue;
+    }
+
+    XrdOucString entryname = val;
+
+    // don't display . .., atomic(+version) uploads and version directories
+    if (entryname.beginswith(EOS_COMMON_PATH_VERSION_FILE_PREFIX) ||
+        entryname.beginswith(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) ||
+        entryname.beginswith(EOS_WEBDAV_HIDE_IN_PROPFIND_PREFIX) ||
+        entryname.beginswith("...eos.ino...") ||
+        (entryname == ".") ||
+        (entryname == "..")) {
+      // skip over . .., and hidden files
+      continue;
+    }
+
+    if (mInfinity && (mStreamedEntries >= limits.mMaxEntries)) {
+      mTruncated = true;
+      mDirectory.reset();
+      mPendingDirs.clear();
+      break;
+    }
+
+    // one response node for each file...
+    eos::common::Path path((mCurrentDir.mUrl + std::string("/") +
+                            std::string(val)).c_str());
+    eos::common::Path refpath((mCurrentDir.mHref + std::string("/") +
+                               std::string(val)).c_str());
+    bool isdir = false;
+    xml_node<>* responseNode = BuildResponseNode(path.GetPath(),
+                               refpath.GetPath(), &isdir);
+
+    // We might have a failed stat in the BuildResponseNode if there are
+    // symlinks present
+    if (!responseNode) {
+      continue;
+    }
+
+    rapidxml::print(std::back_inserter(chunk), *responseNode,
+                    rapidxml::print_no_indenting);
+    ++mStreamedEntries;
+    ++batch;
+
+    if (isdir && mInfinity) {
+      if (mCurrentDir.mLevel + 1 < mMaxLevel) {
+        mPendingDirs.push_back({path.GetPath(), refpath.GetPath(),
+                                mCurrentDir.mLevel + 1});
+      } else {
+        mTruncated = true;
+      }
+    }
+  }
+
+  // Release the nodes of this batch
+  mXMLResponseDocument.clear();
+
+  if (mDirectory || !mPendingDirs.empty()) {
+    return true;
+  }
+
+  if (mTruncated) {
+    // RFC 5323 2.6 - mark the result as truncated by the server limits
+    std::string href = EncodeURI(mRootHref.c_str());
+
+    if (href.empty() || (href.back() != '/')) {
+      href += "/";
+    }
+
+    eos_static_warning("msg=\"truncated depth infinity propfind\" href=\"%s\" "
+                       "entries=%llu", mRootHref.c_str(),
+                       (unsigned long long) mStreamedEntries);
+    chunk += "<d:response><d:href>" + href + "</d:href>"
+             "<d:status>HTTP/1.1 507 Insufficient Storage</d:status>"
+             "<d:error><d:number-of-matches-within-limits/></d:error>"
+             "<d:responsedescription>depth infinity listing limited to " +
+             std::to_string(limits.mMaxEntries) + " entries and " +
+             std::to_string(limits.mMaxLevel) + " levels"
+             "</d:responsedescription></d:response>";
+  }
+
+  chunk += "</d:multistatus>";
+
+  if (mInfinity) {
+    mInfinity = false;
+    --gPropFindWalks;
+  }
+
+  return false;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
@@ -301,7 +503,7 @@ PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
 /*----------------------------------------------------------------------------*/
 rapidxml::xml_node<>*
 PropFindResponse::BuildResponseNode(const std::string& url,
-                                    const std::string& hrefurl)
+                                    const std::string& hrefurl, bool* isdir)
 {
   using namespace rapidxml;
   XrdOucErrInfo error;
@@ -347,6 +549,11 @@ PropFindResponse::BuildResponseNode(const std::string& url,
   }
 
   eos_static_debug("url=%s etag=%s", urlp.c_str(), etag.c_str());
+
+  if (isdir) {
+    *isdir = S_ISDIR(statInfo.st_mode);
+  }
+
   // encode the url's
   urlp = EncodeURI(urlp.c_str()).c_str();
   hrefp = EncodeURI(hrefp.c_str()).c_str();
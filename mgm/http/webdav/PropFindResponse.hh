@@ -43,6 +43,10 @@
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucErrInfo.hh"
 /*----------------------------------------------------------------------------*/
+#include <deque>
+#include <memory>
+
+class XrdMgmOfsDirectory;
 
 EOSMGMNAMESPACE_BEGIN;
 
@@ -85,6 +89,26 @@ protected:
   int mRequestPropertyTypes; //!< properties that were requested
   eos::common::VirtualIdentity *mVirtualIdentity; //!< virtual identity for this client
 
+  /**
+   * Directory whose children still have to be streamed
+   */
+  struct PendingDir {
+    std::string mUrl;  //!< path of the directory
+    std::string mHref; //!< href of the directory
+    int mLevel;        //!< levels below the requested resource
+  };
+
+  std::deque<PendingDir> mPendingDirs; //!< directories left to list
+  PendingDir mCurrentDir; //!< directory being listed
+  std::unique_ptr<XrdMgmOfsDirectory> mDirectory; //!< listing of mCurrentDir
+  std::string mRootHref; //!< href of the requested resource
+  int mMaxLevel; //!< deepest level of the streamed listing
+  bool mStreamRoot; //!< stream the requested resource itself
+  bool mStreamStarted; //!< multistatus head was streamed
+  bool mTruncated; //!< listing was cut by the depth infinity limits
+  bool mInfinity; //!< depth infinity request holding a walk slot
+  uint64_t mStreamedEntries; //!< number of streamed children
+
 public:
 
   /**
@@ -95,7 +119,9 @@ public:
   PropFindResponse (eos::common::HttpRequest *request,
                     eos::common::VirtualIdentity *vid) :
     WebDAVResponse (request), mRequestPropertyTypes (NONE),
-    mVirtualIdentity (vid)
+    mVirtualIdentity (vid), mCurrentDir {"", "", 0}, mMaxLevel (1),
+    mStreamRoot (true), mStreamStarted (false), mTruncated (false),
+    mInfinity (false), mStreamedEntries (0)
   {
     static bool initialized = false;
     if (!initialized)
@@ -115,9 +141,7 @@ public:
   /**
    * Destructor
    */
-  virtual ~PropFindResponse ()
-  {
-  };
+  virtual ~PropFindResponse ();
 
 
   /**
@@ -145,11 +169,26 @@ public:
    * requested, whether they were found or not, etc (see RFC)
    *
    * @param url  the URL of the resource to build a response node for
+   * @param isdir  set to true if the resource is a directory
    *
    * @return the newly build response node
    */
   rapidxml::xml_node<>*
-  BuildResponseNode (const std::string &url, const std::string &hrefurl);
+  BuildResponseNode (const std::string &url, const std::string &hrefurl,
+                     bool *isdir = nullptr);
+
+  /**
+   * Produce the next piece of a streamed Depth 1 or infinity response: the
+   * multistatus head, the <response/> nodes of the next batch of children
+   * and finally the multistatus tail. Only one batch of nodes is held in the
+   * XML document at a time.
+   *
+   * @param chunk  filled with the XML of the batch
+   *
+   * @return false once the response is complete, otherwise true
+   */
+  bool
+  StreamNextBatch (std::string &chunk);
 
   /**
    * Convert the given property type string into its integer constant
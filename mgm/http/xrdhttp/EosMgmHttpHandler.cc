@@ -335,6 +335,28 @@ EosMgmHttpHandler::ProcessReq(XrdHttpExtReq& req)
                               response->GetResponseCodeDescription().c_str(),
                               oss_header.str().c_str(),
                               nullptr, content_length);
+  } else if (response->IsStreamed()) {
+    // Send the body piece by piece with the chunked transfer encoding
+    int rc = req.StartChunkedResp(response->GetResponseCode(),
+                                  response->GetResponseCodeDescription().c_str(),
+                                  oss_header.str().c_str());
+    std::string chunk;
+    bool more = true;
+
+    while (!rc && more) {
+      more = response->NextBodyChunk(chunk);
+
+      if (chunk.size()) {
+        rc = req.ChunkResp(chunk.c_str(), chunk.length());
+      }
+    }
+
+    if (!rc) {
+      // A null body terminates the chunked response
+      rc = req.ChunkResp(nullptr, 0);
+    }
+
+    return rc;
   } else {
     return req.SendSimpleResp(response->GetResponseCode(),
                               response->GetResponseCodeDescription().c_str(),
@@ -632,7 +632,8 @@ void AccessCmd::RmSubcmd(const eos::console::AccessProto_RmProto& rm,
       if (!rm.key().empty()) {
         if ((rm.key().find("rate:user:") == 0) ||
             (rm.key().find("rate:group:") == 0) ||
-            (rm.key().find("threads:") == 0)) {
+            (rm.key().find("threads:") == 0) ||
+            (rm.key().find("admission:") == 0)) {
           std_out << "limit";
         } else {
           std_out << "stall";
@@ -643,7 +644,8 @@ void AccessCmd::RmSubcmd(const eos::console::AccessProto_RmProto& rm,
 
       if ((rm.key().find("rate:user:") == 0) ||
           (rm.key().find("rate:group:") == 0) ||
-          (rm.key().find("threads:") == 0)) {
+          (rm.key().find("threads:") == 0) ||
+          (rm.key().find("admission:") == 0)) {
         const std::string rule_key = ProcessRuleKey(rm.key());
 
         if (rule_key.empty()) {
@@ -742,13 +744,18 @@ void AccessCmd::SetSubcmd(const eos::console::AccessProto_SetProto& set,
     try {
       target = (std::stoi(set.target()));
     } catch (const std::exception& e) {
-      reply.set_std_err("error: target must be an integer equal or greater than 0 (value zero allowed just for 'rate:' limit)");
+      reply.set_std_err("error: target must be an integer equal or greater than 0 (value zero allowed just for 'rate:' and 'admission:queue:' limits)");
       reply.set_retc(EINVAL);
       return;
     }
 
-    if (!((set.key().find("rate:") == 0 && target >= 0) || (target > 0))) {
-      reply.set_std_err("error: target must be an integer equal or greater than 0 (value zero allowed just for 'rate:' limit)");
+    // A zero admission rate would lift the limit instead of stalling like
+    // a zero 'rate:' limit does, so it is only allowed for the queue settings
+    bool zero_allowed = ((set.key().find("rate:") == 0) ||
+                         (set.key().find("admission:queue:") == 0));
+
+    if (!((zero_allowed && target >= 0) || (target > 0))) {
+      reply.set_std_err("error: target must be an integer equal or greater than 0 (value zero allowed just for 'rate:' and 'admission:queue:' limits)");
       reply.set_retc(EINVAL);
       return;
     }
@@ -756,6 +763,9 @@ void AccessCmd::SetSubcmd(const eos::console::AccessProto_SetProto& set,
     if (set.key().find("rate:") == 0) {
       std_out << "success: setting rate cutoff at " << set.target()
               << " Hz for rate:<user|group>:<operation>=" << set.key();
+    } else if (set.key().find("admission:") == 0) {
+      std_out << "success: setting admission control value " << set.target()
+              << " for " << set.key();
     }  else if (set.key().find("threads:") == 0) {
       std_out << "success: setting thread limit at " << set.target()
               << " for " << set.key();
@@ -778,7 +788,8 @@ void AccessCmd::SetSubcmd(const eos::console::AccessProto_SetProto& set,
 
     if ((set.key().find("rate:user:") == 0) ||
         (set.key().find("rate:group:") == 0) ||
-        (set.key().find("threads:") == 0)) {
+        (set.key().find("threads:") == 0) ||
+        (set.key().find("admission:") == 0)) {
       const std::string rule_key = ProcessRuleKey(set.key());
 
       if (rule_key.empty()) {
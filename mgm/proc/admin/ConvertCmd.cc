@@ -31,6 +31,7 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "common/table_formatter/TableFormatterBase.hh"
 #include <json/json.h>
+#include <iomanip>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -141,11 +142,13 @@ void ConvertCmd::StatusSubcmd(
   std::string threadpool = gOFS->mConverterDriver->GetThreadPoolInfo();
   std::string config =
     SSTR("maxthreads=" << gOFS->mConverterDriver->GetMaxThreadPoolSize()
-         << " maxqueuesize=" << gOFS->mConverterDriver->GetMaxQueueSize());
+         << " maxqueuesize=" << gOFS->mConverterDriver->GetMaxQueueSize()
+         << " batchsize=" << gOFS->mConverterDriver->GetBatchSize());
   uint64_t running = gOFS->mConverterDriver->NumRunningJobs();
   uint64_t failed = gOFS->mConverterDriver->NumQdbFailedJobs();
   int64_t pending = gOFS->mConverterDriver->NumPendingJobs();
   auto state = gOFS->mConverterDriver->IsRunning() ? "enabled" : "disabled";
+  auto tput = gOFS->mConverterDriver->GetThroughput();
 
   if (jsonOutput) {
     Json::Value json;
@@ -155,6 +158,11 @@ void ConvertCmd::StatusSubcmd(
     json["running"] = (Json::Value::UInt64) running;
     json["pending"] = (Json::Value::UInt64) pending;
     json["failed"] = (Json::Value::UInt64) failed;
+    json["throughput"]["converted"] = (Json::Value::UInt64) tput.mFiles;
+    json["throughput"]["converted_bytes"] = (Json::Value::UInt64) tput.mBytes;
+    json["throughput"]["failed"] = (Json::Value::UInt64) tput.mFailed;
+    json["throughput"]["files_per_sec"] = tput.mFileRate;
+    json["throughput"]["bytes_per_sec"] = tput.mByteRate;
 
     Json::StreamWriterBuilder builder;
     std::unique_ptr<Json::StreamWriter> jsonwriter(
@@ -166,7 +174,12 @@ void ConvertCmd::StatusSubcmd(
         << "Threadpool: " << threadpool << std::endl
         << "Running jobs: " << running << std::endl
         << "Pending jobs: " << pending << std::endl
-        << "Total failed jobs : " << failed << std::endl;
+        << "Total failed jobs : " << failed << std::endl
+        << "Throughput: converted=" << tput.mFiles
+        << " converted_bytes=" << tput.mBytes
+        << " failed=" << tput.mFailed
+        << " files/s=" << std::fixed << std::setprecision(2) << tput.mFileRate
+        << " bytes/s=" << std::setprecision(0) << tput.mByteRate << std::endl;
   }
 
   reply.set_std_out(out.str());
@@ -202,6 +215,17 @@ void ConvertCmd::ConfigSubcmd(
     output["maxqueuesize"] = std::to_string(config.maxqueuesize());
   }
 
+  if (config.batchsize()) {
+    if (config.batchsize() > 1000) {
+      err << "error: batchsize value " << config.batchsize()
+          << " above 1000 limit" << std::endl;
+      retc = EINVAL;
+    } else {
+      gOFS->mConverterDriver->SetBatchSize(config.batchsize());
+      output["batchsize"] = std::to_string(config.batchsize());
+    }
+  }
+
   if (output.empty()) {
     err << "error: no config values given" << std::endl;
     retc = ENODATA;
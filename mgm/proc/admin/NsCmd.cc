@@ -31,7 +31,6 @@
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
-#include "namespace/ns_quarkdb/utils/QuotaRecomputer.hh"
 #include "namespace/ns_quarkdb/NamespaceGroup.hh"
 #include "namespace/ns_quarkdb/QClPerformance.hh"
 #include "namespace/Resolver.hh"
@@ -41,6 +40,7 @@
 #include "mgm/XrdMgmOfsFile.hh"
 #include "mgm/fsck/Fsck.hh"
 #include "mgm/Quota.hh"
+#include "mgm/QuotaRecompute.hh"
 #include "mgm/Stat.hh"
 #include "mgm/ZMQ.hh"
 #include "mgm/convert/ConverterDriver.hh"
@@ -737,6 +737,10 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat,
 
   oss << gOFS->mTracker.PrintOut(monitoring);
 
+  if (gOFS->mAdmission.IsEnabled()) {
+    oss << gOFS->mAdmission.PrintOut(monitoring);
+  }
+
   if (WantsJsonOutput()) {
     std::string out = ResponseToJsonString(oss.str(), err.str(), retc);
     oss.clear(), oss.str(out);
@@ -850,6 +854,13 @@ void
 NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
                        eos::console::ReplyProto& reply)
 {
+  if (tree.status()) {
+    std::string status = gOFS->mQuotaRecompute->GetStatus();
+    reply.set_std_out(status.empty() ? "info: no quota recomputation" : status);
+    reply.set_retc(0);
+    return;
+  }
+
   std::string cont_uri {""};
   eos::IContainerMD::id_t cont_id {0ull};
   {
@@ -873,30 +884,8 @@ NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
     cont_uri = gOFS->eosView->getUri(cont.get());
     cont_id = cont->getId();
   }
-  // Recompute the quota node
-  QuotaNodeCore qnc;
-  bool update = false;
-
-  if (tree.used_bytes() || tree.used_inodes()) {
-    QuotaNodeCore::UsageInfo usage;
-    usage.space = tree.used_bytes();
-    usage.physicalSpace = tree.physical_bytes();
-    usage.files = tree.used_inodes();
-
-    if (tree.uid().size() && !tree.gid().size()) {
-      // set by user
-      qnc.setByUid(strtoul(tree.uid().c_str(), 0, 10), usage);
-    } else if (tree.gid().size() && !tree.uid().size())  {
-      // set by group
-      qnc.setByGid(strtoul(tree.gid().c_str(), 0, 10), usage);
-    } else {
-      reply.set_std_err("error: to overwrite quota you have to set a user or group id - never both");
-      reply.set_retc(EINVAL);
-      return;
-    }
 
-    update = true;
-  } else {
+  if (!tree.used_bytes() && !tree.used_inodes()) {
     if (gOFS->eosView->inMemory()) {
       reply.set_std_err("error: quota recomputation is only available for "
                         "QDB namespace");
@@ -904,35 +893,51 @@ NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
       return;
     }
 
-    std::unique_ptr<qclient::QClient> qcl =
-      std::make_unique<qclient::QClient>(gOFS->mQdbContactDetails.members,
-                                         gOFS->mQdbContactDetails.constructOptions());
-    eos::QuotaRecomputer recomputer(qcl.get(),
-                                    static_cast<QuarkNamespaceGroup*>(gOFS->namespaceGroup.get())->getExecutor());
-    eos::MDStatus status = recomputer.recompute(cont_uri, cont_id, qnc);
+    // Recompute the quota node online, the uid/gid if specified restrict the
+    // entries which are updated
+    std::string msg;
+    int retc = gOFS->mQuotaRecompute->Submit(cont_id, tree.uid(), tree.gid(),
+               msg);
 
-    if (!status.ok()) {
-      reply.set_std_err(status.getError());
-      reply.set_retc(status.getErrno());
-      return;
+    if ((retc == 0) && !tree.background()) {
+      retc = gOFS->mQuotaRecompute->Wait(cont_id, msg);
     }
 
-    // Remove all the entries, which should not be updated if any uid/gid
-    // specified.
-    if (tree.uid().size() || tree.gid().size()) {
-      qnc.filterByUid(strtoul(tree.uid().c_str(), 0, 10));
-      qnc.filterByGid(strtoul(tree.gid().c_str(), 0, 10));
-      update = true;
+    if (retc) {
+      reply.set_std_err(msg);
+    } else {
+      reply.set_std_out(msg);
     }
+
+    reply.set_retc(retc);
+    return;
+  }
+
+  // Overwrite the quota node
+  QuotaNodeCore qnc;
+  QuotaNodeCore::UsageInfo usage;
+  usage.space = tree.used_bytes();
+  usage.physicalSpace = tree.physical_bytes();
+  usage.files = tree.used_inodes();
+
+  if (tree.uid().size() && !tree.gid().size()) {
+    // set by user
+    qnc.setByUid(strtoul(tree.uid().c_str(), 0, 10), usage);
+  } else if (tree.gid().size() && !tree.uid().size())  {
+    // set by group
+    qnc.setByGid(strtoul(tree.gid().c_str(), 0, 10), usage);
+  } else {
+    reply.set_std_err("error: to overwrite quota you have to set a user or group id - never both");
+    reply.set_retc(EINVAL);
+    return;
   }
 
-  // Update the quota note
   try {
     eos::common::RWMutexWriteLock ns_wr_lock(gOFS->eosViewRWMutex);
     auto cont = gOFS->eosDirectoryService->getContainerMD(cont_id);
 
     if ((cont->getFlags() & eos::QUOTA_NODE_FLAG) == 0) {
-      eos_err("msg=\"quota recomputation failed, directory is not (anymore) a "
+      eos_err("msg=\"quota update failed, directory is not (anymore) a "
               "quota node\" cxid=%08llx path=\"%s\"", cont_id, cont_uri.c_str());
       reply.set_std_err("error: directory is not a quota node (anymore)");
       reply.set_retc(EINVAL);
@@ -940,18 +945,11 @@ NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
     }
 
     eos::IQuotaNode* quotaNode = gOFS->eosView->getQuotaNode(cont.get());
-
-    if (update) {
-      quotaNode->updateCore(qnc);
-      eos_info("msg=\"quota update successful\" cxid=%08llx path=\"%s\"",
-               cont_id, cont_uri.c_str());
-    } else {
-      quotaNode->replaceCore(qnc);
-      eos_info("msg=\"quota recomputation successful\" cxid=%08llx path=\"%s\"",
-               cont_id, cont_uri.c_str());
-    }
+    quotaNode->updateCore(qnc);
+    eos_info("msg=\"quota update successful\" cxid=%08llx path=\"%s\"",
+             cont_id, cont_uri.c_str());
   } catch (const eos::MDException& e) {
-    eos_err("msg=\"quota recomputation failed, directory removed\" "
+    eos_err("msg=\"quota update failed, directory removed\" "
             "cxid=%08llx path=\"%s\"", cont_id, cont_uri.c_str());
     reply.set_std_err(SSTR(e.what()));
     reply.set_retc(e.getErrno());
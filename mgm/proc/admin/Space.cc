@@ -577,15 +577,22 @@ ProcCommand::Space()
                   (key == "drainer.node.nfs") ||
                   (key == "drainer.retries") ||
                   (key == "drainer.fs.ntx") ||
+                  (key == "drainer.node.slots") ||
+                  (key == "drainer.node.bw") ||
+                  (key == "drainer.disk.slots") ||
+                  (key == "drainer.disk.bw") ||
                   (key == "converter") ||
                   (key == "tracker") ||
                   (key == "inspector") ||
                   (key == "inspector.interval") ||
                   (key == "lru") ||
                   (key == "lru.interval") ||
+                  (key == "lru.incremental") ||
+                  (key == "lru.rate") ||
                   (key == "wfe") ||
                   (key == "wfe.interval") ||
                   (key == "wfe.ntx") ||
+                  (key == "wfe.lease") ||
                   (key == "converter.ntx") ||
                   (key == "autorepair") ||
                   (key == "groupbalancer") ||
@@ -618,6 +625,7 @@ ProcCommand::Space()
                 if ((key == "balancer") || (key == "converter") ||
                     (key == "tracker") || (key == "inspector") ||
                     (key == "autorepair") || (key == "lru") ||
+                    (key == "lru.incremental") ||
                     (key == "groupbalancer") || (key == "geobalancer") ||
                     (key == "geo.access.policy.read.exact") ||
                     (key == "geo.access.policy.write.exact") ||
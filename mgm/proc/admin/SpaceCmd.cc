@@ -796,6 +796,10 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
           (key == "drainer.node.nfs") ||
           (key == "drainer.retries") ||
           (key == "drainer.fs.ntx") ||
+          (key == "drainer.node.slots") ||
+          (key == "drainer.node.bw") ||
+          (key == "drainer.disk.slots") ||
+          (key == "drainer.disk.bw") ||
           (key == "converter") ||
           (key == "tracker") ||
           (key == "inspector") ||
@@ -805,9 +809,12 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
 	  (key == "inspector.price.currency") ||
           (key == "lru") ||
           (key == "lru.interval") ||
+          (key == "lru.incremental") ||
+          (key == "lru.rate") ||
           (key == "wfe") ||
           (key == "wfe.interval") ||
           (key == "wfe.ntx") ||
+          (key == "wfe.lease") ||
           (key == "converter.ntx") ||
           (key == "groupbalancer") ||
           (key == "groupbalancer.ntx") ||
@@ -847,6 +854,7 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
             (key == "tracker") ||
             (key == "inspector") ||
             (key == "lru") ||
+            (key == "lru.incremental") ||
             (key == "groupbalancer") ||
             (key == "geobalancer") ||
             (key == "geo.access.policy.read.exact") ||
@@ -997,6 +1005,12 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
                             "success: LRU is disabled");
                 gOFS->mLRUEngine->RefreshOptions();
               }
+
+              if (key == "lru.incremental") {
+                std_out << ((value == "on") ? "success: incremental LRU is enabled" :
+                            "success: incremental LRU is disabled");
+                gOFS->mLRUEngine->RefreshOptions();
+              }
             }
           }
         } else if (key == "wfe") {
@@ -1054,7 +1068,7 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
                   eos::common::EosTok::sTokenGeneration = strtoull(value.c_str(), 0, 0);
                 }
 
-                if (key == "lru.interval") {
+                if ((key == "lru.interval") || (key == "lru.rate")) {
                   gOFS->mLRUEngine->RefreshOptions();
                 }
 
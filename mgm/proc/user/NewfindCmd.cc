@@ -36,7 +36,9 @@
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/utils/Attributes.hh"
 #include "namespace/utils/BalanceCalculator.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/Stat.hh"
@@ -975,6 +977,12 @@ public:
     }
   }
 
+  //----------------------------------------------------------------------------
+  // QDB index: Serve the files found through the secondary metadata index
+  //----------------------------------------------------------------------------
+  FindResultProvider(std::vector<std::string>&& paths)
+    : indexed(new std::vector<std::string>(std::move(paths))) {}
+
   //----------------------------------------------------------------------------
   // In-memory: Check whether we need to take deep query mutex lock
   //----------------------------------------------------------------------------
@@ -1063,8 +1071,26 @@ public:
     return true;
   }
 
+  bool nextInIndex(FindResult& res)
+  {
+    if (indexPos >= indexed->size()) {
+      return false;
+    }
+
+    res.expansionFilteredOut = false;
+    res.iscache = true;
+    res.isdir = false;
+    res.path = (*indexed)[indexPos++];
+    return true;
+  }
+
   bool next(FindResult& res)
   {
+    if (indexed) {
+      // Index case
+      return nextInIndex(res);
+    }
+
     if (found) {
       // In-memory case
       return nextInMemory(res);
@@ -1095,8 +1121,210 @@ private:
   bool ignore_files;
   std::unique_ptr<NamespaceExplorer> explorer;
   eos::common::VirtualIdentity vid;
+
+  //----------------------------------------------------------------------------
+  // QDB index: Sorted file paths
+  //----------------------------------------------------------------------------
+  std::unique_ptr<std::vector<std::string>> indexed;
+  size_t indexPos = 0;
 };
 
+//------------------------------------------------------------------------------
+// Check whether the given identity may traverse all directories from the
+// search path down to the given container, like the TraversalFilter does
+//------------------------------------------------------------------------------
+static bool canTraverse(eos::IContainerMD::id_t cid, const std::string& target,
+                        uint32_t depthlimit,
+                        const eos::common::VirtualIdentity& vid,
+                        std::map<eos::IContainerMD::id_t, bool>& cache)
+{
+  std::vector<eos::IContainerMD::id_t> chain;
+  bool allowed = false;
+
+  while (true) {
+    auto it = cache.find(cid);
+
+    if (it != cache.end()) {
+      allowed = it->second;
+      break;
+    }
+
+    chain.push_back(cid);
+    std::shared_ptr<eos::IContainerMD> cmd;
+    std::string path;
+
+    try {
+      cmd = gOFS->eosDirectoryService->getContainerMD(cid);
+      path = gOFS->eosView->getUri(cmd.get());
+    } catch (eos::MDException& e) {
+      allowed = false;
+      break;
+    }
+
+    eos::IContainerMD::XAttrMap attrs;
+    eos::listAttributes(gOFS->eosView, cmd.get(), attrs, false);
+    allowed = (path.find(target) == 0) &&
+              (eos::common::Path(path).GetSubPathSize() < depthlimit) &&
+              AccessChecker::checkContainer(cmd.get(), attrs, R_OK | X_OK, vid) &&
+              AccessChecker::checkPublicAccess(path, vid);
+
+    if (!allowed || (path == target)) {
+      break;
+    }
+
+    cid = cmd->getParentId();
+  }
+
+  // A denied directory hides the whole subtree below it
+  for (auto id : chain) {
+    cache[id] = allowed;
+  }
+
+  return allowed;
+}
+
+//------------------------------------------------------------------------------
+// Query planner: answer a files-only query from the secondary metadata index
+// if one covers the filter. Of the covering index terms the one with the
+// fewest candidates is used. The candidates are only a superset of the
+// result, the regular filters are applied on them again by the caller.
+// Returns nullptr if the tree has to be walked.
+//------------------------------------------------------------------------------
+static std::unique_ptr<FindResultProvider>
+IndexedFindResultProvider(const eos::console::FindProto& req,
+                          uint32_t depthlimit,
+                          const eos::common::VirtualIdentity& vid)
+{
+  static constexpr uint64_t sMaxCandidates = 1000000;
+  static constexpr uint64_t sMaxTimeBuckets = 366;
+
+  if (!req.files() || req.directories() || req.treecount() ||
+      req.childcount() || req.balance() || req.cache() ||
+      !req.purge().empty() || gOFS->namespaceGroup->isInMemory()) {
+    return nullptr;
+  }
+
+  QuarkMetadataIndex* index = static_cast<QuarkNamespaceGroup*>
+                              (gOFS->namespaceGroup.get())->getMetadataIndex();
+
+  if (!index) {
+    return nullptr;
+  }
+
+  QuarkMetadataIndex::Spec spec = index->getUsableSpec();
+  std::vector<std::vector<std::string>> terms;
+
+  if (spec.uid && req.searchuid()) {
+    terms.push_back({QuarkMetadataIndex::uidKey(req.uid())});
+  }
+
+  if (spec.gid && req.searchgid()) {
+    terms.push_back({QuarkMetadataIndex::gidKey(req.gid())});
+  }
+
+  if (spec.xattrs.count(req.attributekey()) && !req.attributevalue().empty()) {
+    terms.push_back({QuarkMetadataIndex::xattrKey(req.attributekey(),
+                     req.attributevalue())});
+  }
+
+  if (spec.size && req.zerosizefiles()) {
+    terms.push_back({QuarkMetadataIndex::sizeKey(0)});
+  }
+
+  if (spec.time && (req.youngerthan() > 0)) {
+    // without an upper bound allow for clocks being a bit ahead
+    uint64_t from = req.youngerthan();
+    uint64_t to = (req.olderthan() > 0) ? req.olderthan() :
+                  time(nullptr) + mdindex::sTimeBucket;
+
+    if ((from <= to) &&
+        ((to - from) / mdindex::sTimeBucket < sMaxTimeBuckets)) {
+      std::vector<std::string> keys;
+
+      for (uint64_t t = from - (from % mdindex::sTimeBucket); t <= to;
+           t += mdindex::sTimeBucket) {
+        keys.push_back(req.ctime() ? QuarkMetadataIndex::ctimeKey(t) :
+                       QuarkMetadataIndex::mtimeKey(t));
+      }
+
+      terms.push_back(keys);
+    }
+  }
+
+  if (terms.empty()) {
+    return nullptr;
+  }
+
+  const std::vector<std::string>* best = nullptr;
+  uint64_t best_count = 0;
+
+  for (const auto& term : terms) {
+    uint64_t count = index->getCount(term);
+
+    if (!best || (count < best_count)) {
+      best = &term;
+      best_count = count;
+    }
+  }
+
+  if (best_count > sMaxCandidates) {
+    return nullptr;
+  }
+
+  std::set<eos::IFileMD::id_t> fids;
+
+  for (const auto& key : *best) {
+    for (auto it = index->getFileList(key); it->valid(); it->next()) {
+      fids.insert(it->getElement());
+    }
+  }
+
+  std::string target = req.path();
+
+  if (target.empty() || (target.back() != '/')) {
+    target += '/';
+  }
+
+  std::map<eos::IContainerMD::id_t, bool> traversable;
+  std::vector<std::string> paths;
+  auto it = fids.begin();
+
+  while (it != fids.end()) {
+    std::vector<folly::Future<eos::IFileMDPtr>> batch;
+
+    for (size_t i = 0; (i < 1000) && (it != fids.end()); ++i, ++it) {
+      batch.emplace_back(gOFS->eosFileService->getFileMDFut(*it));
+    }
+
+    for (auto& fut : batch) {
+      try {
+        eos::IFileMDPtr fmd = std::move(fut).get();
+
+        if (!fmd || !fmd->getContainerId()) {
+          continue;
+        }
+
+        std::string path = gOFS->eosView->getUri(fmd.get());
+
+        if ((path.find(target) == 0) &&
+            canTraverse(fmd->getContainerId(), target, depthlimit, vid,
+                        traversable)) {
+          paths.push_back(std::move(path));
+        }
+      } catch (eos::MDException& e) {
+        // stale index entry, the file is gone
+      }
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+  eos_static_info("msg=\"find served from index\" path=\"%s\" keys=%lu "
+                  "candidates=%lu results=%lu", req.path().c_str(), best->size(),
+                  fids.size(), paths.size());
+  return std::unique_ptr<FindResultProvider>(new FindResultProvider(std::move(
+        paths)));
+}
+
 //------------------------------------------------------------------------------
 // Method implementing the specific behaviour of the command executed
 //------------------------------------------------------------------------------
@@ -1218,11 +1446,22 @@ NewfindCmd::ProcessRequest() noexcept
       }
     }
   } else {
-    // read from the QDB backend
+    // read from the QDB backend, through an index if one covers the query
     try {
-      findResultProvider.reset(new FindResultProvider(qcl.get(),
-                               findRequest.path(), depthlimit,
-                               onlydirs, mVid));
+      if (file_exists == XrdSfsFileExistIsDirectory) {
+        findResultProvider = IndexedFindResultProvider(findRequest, depthlimit,
+                             mVid);
+
+        if (findResultProvider) {
+          gOFS->MgmStats.Add("NewfindIndexed", mVid.uid, mVid.gid, 1);
+        }
+      }
+
+      if (!findResultProvider) {
+        findResultProvider.reset(new FindResultProvider(qcl.get(),
+                                 findRequest.path(), depthlimit,
+                                 onlydirs, mVid));
+      }
     } catch (eos::MDException& e) {
       eos_static_info("caught exception errno=%d what=\"%s\" in newfind "
                       "findRequest.path()=%s",
@@ -1573,11 +1812,22 @@ NewfindCmd::ProcessRequest(grpc::ServerWriter<eos::console::ReplyProto>* writer)
       }
     }
   } else {
-    // read from the back-end
+    // read from the back-end, through an index if one covers the query
     try {
-      findResultProvider.reset(new FindResultProvider(qcl.get(),
-                               findRequest.path(), depthlimit,
-                               onlydirs, mVid));
+      if (file_exists == XrdSfsFileExistIsDirectory) {
+        findResultProvider = IndexedFindResultProvider(findRequest, depthlimit,
+                             mVid);
+
+        if (findResultProvider) {
+          gOFS->MgmStats.Add("NewfindIndexed", mVid.uid, mVid.gid, 1);
+        }
+      }
+
+      if (!findResultProvider) {
+        findResultProvider.reset(new FindResultProvider(qcl.get(),
+                                 findRequest.path(), depthlimit,
+                                 onlydirs, mVid));
+      }
     } catch (eos::MDException& e) {
       eos_static_info("caught exception errno=%d what=\"%s\" in newfind "
                       "findRequest.path()=%s",
@@ -51,7 +51,8 @@ RecycleCmd::ProcessRequest() noexcept
 
     rc = Recycle::Print(std_out, std_err, mVid, ls.monitorfmt(),
                    !ls.numericids(), ls.fulldetails(),
-			ls.date(), ls.all(), nullptr, true, ls.maxentries());
+			ls.date(), ls.all(), nullptr, true, ls.maxentries(),
+			ls.cursor());
 
     if (std_out.length()) {
       reply.set_std_out(std_out.c_str());
@@ -175,6 +175,39 @@ protected:
   QuotaNodeCore pCore;
 };
 
+//----------------------------------------------------------------------------
+//! Listener of the usage changes of the quota nodes
+//----------------------------------------------------------------------------
+class IQuotaUsageListener
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~IQuotaUsageListener() {};
+
+  //----------------------------------------------------------------------------
+  //! A file was added to or removed from a quota node
+  //!
+  //! @param node_id quota node id
+  //! @param uid owner of the file
+  //! @param gid group of the file
+  //! @param size logical size change
+  //! @param physical_size physical size change
+  //! @param files number of files change i.e. 1 or -1
+  //----------------------------------------------------------------------------
+  virtual void usageChanged(IContainerMD::id_t node_id, uid_t uid, gid_t gid,
+                            int64_t size, int64_t physical_size,
+                            int64_t files) = 0;
+
+  //----------------------------------------------------------------------------
+  //! The usage of a quota node was replaced or merged as a whole
+  //!
+  //! @param node_id quota node id
+  //----------------------------------------------------------------------------
+  virtual void usageReset(IContainerMD::id_t node_id) = 0;
+};
+
 //----------------------------------------------------------------------------
 //! Manager of the quota nodes
 //----------------------------------------------------------------------------
@@ -190,7 +223,7 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor
   //----------------------------------------------------------------------------
-  IQuotaStats(): pSizeMapper(0) {}
+  IQuotaStats(): pSizeMapper(0), pUsageListener(nullptr) {}
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -250,8 +283,40 @@ public:
     return (*pSizeMapper)(file);
   }
 
+  //----------------------------------------------------------------------------
+  //! Register a listener notified of every usage change of the quota nodes.
+  //! The listener is called with the namespace locks of the change held so
+  //! it must not block.
+  //----------------------------------------------------------------------------
+  void registerUsageListener(IQuotaUsageListener* listener)
+  {
+    pUsageListener = listener;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Notify the listener of a file added to or removed from a quota node
+  //----------------------------------------------------------------------------
+  void notifyUsageChanged(IContainerMD::id_t node_id, uid_t uid, gid_t gid,
+                          int64_t size, int64_t physical_size, int64_t files)
+  {
+    if (pUsageListener) {
+      pUsageListener->usageChanged(node_id, uid, gid, size, physical_size, files);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Notify the listener of the usage of a quota node changed as a whole
+  //----------------------------------------------------------------------------
+  void notifyUsageReset(IContainerMD::id_t node_id)
+  {
+    if (pUsageListener) {
+      pUsageListener->usageReset(node_id);
+    }
+  }
+
 protected:
   SizeMapper pSizeMapper;
+  IQuotaUsageListener* pUsageListener; ///< Listener of usage changes
 };
 
 EOSNSNAMESPACE_END
@@ -106,4 +106,19 @@ static const std::string sUnlinkedSuffix = "unlinked";
 static const std::string sNoReplicaPrefix = "fsview_noreplicas";
 }
 
+// Variables associated with the secondary metadata index
+namespace mdindex
+{
+//! Prefix for sets storing the file ids of an index bucket
+static const std::string sPrefix = "eos-index:";
+//! Hash holding information about the index
+static const std::string sMetaKey = "eos-index-meta";
+//! Field holding the specification the index was completely built for
+static const std::string sBuiltField = "built";
+//! Namespace configuration key holding the index specification
+static const std::string sConfigKey = "ns_index";
+//! Bucket width in seconds of the ctime/mtime index
+static const uint64_t sTimeBucket = 86400;
+}
+
 EOSNSNAMESPACE_END
@@ -676,6 +676,21 @@ public:
     });
   };
 
+  //----------------------------------------------------------------------------
+  //! Replace the list of secondary index buckets the file is registered in
+  //!
+  //! @param keys new newline separated list of index keys
+  //!
+  //! @return previous list of index keys
+  //----------------------------------------------------------------------------
+  std::string swapIndexKeys(std::string keys)
+  {
+    return runWriteOp([this, &keys]() {
+      mIndexKeys.swap(keys);
+      return keys;
+    });
+  }
+
 protected:
   IFileMDSvc* pFileMDSvc;
 
@@ -710,6 +725,7 @@ private:
 
   eos::ns::FileMdProto mFile; ///< Protobuf file representation
   uint64_t mClock; ///< Value tracking metadata changes
+  std::string mIndexKeys; ///< Secondary index buckets holding this file
 };
 
 EOSNSNAMESPACE_END
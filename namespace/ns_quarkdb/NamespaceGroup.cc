@@ -22,6 +22,7 @@
 //------------------------------------------------------------------------------
 
 #include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
@@ -30,6 +31,7 @@
 #include "namespace/ns_quarkdb/accounting/SyncTimeAccounting.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
 #include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
 #include "namespace/ns_quarkdb/CacheRefreshListener.hh"
 #include "namespace/ns_quarkdb/VersionEnforcement.hh"
 #include <folly/executors/IOThreadPoolExecutor.h>
@@ -56,6 +58,7 @@ QuarkNamespaceGroup::~QuarkNamespaceGroup()
   mHierarchicalView.reset();
   mFileService.reset();
   mContainerService.reset();
+  mMetadataIndex.reset();
   mMetadataFlusher.reset();
   mQuotaFlusher.reset();
   mQClient.reset();
@@ -124,6 +127,20 @@ bool QuarkNamespaceGroup::initialize(eos::common::RWMutex* nsMtx,
   }
 
   flusherQuotaTag = it->second;
+  // Optional configuration: ns_index
+  it = config.find(mdindex::sConfigKey);
+
+  if (it != config.end()) {
+    QuarkMetadataIndex::Spec spec;
+
+    if (!QuarkMetadataIndex::Spec::parse(it->second, spec, err)) {
+      err = "could not parse " + mdindex::sConfigKey + ": " + err;
+      return false;
+    }
+
+    indexSpec = spec.toString();
+  }
+
   mPerfMonitor = std::make_shared<eos::QClPerfMonitor>();
 
   if (!enforceQuarkDBVersion(getQClient())) {
@@ -131,6 +148,11 @@ bool QuarkNamespaceGroup::initialize(eos::common::RWMutex* nsMtx,
     return false;
   }
 
+  // Without updates from this namespace an existing index goes stale
+  if (indexSpec.empty()) {
+    QuarkMetadataIndex::invalidate(*getQClient());
+  }
+
   return true;
 }
 
@@ -152,6 +174,15 @@ void QuarkNamespaceGroup::initializeFileAndContainerServices()
 
   mContainerService->setFileMDService(mFileService.get());
   mFileService->setContMDService(mContainerService.get());
+
+  if (!indexSpec.empty() && !mMetadataIndex) {
+    QuarkMetadataIndex::Spec spec;
+    std::string err;
+    QuarkMetadataIndex::Spec::parse(indexSpec, spec, err);
+    mMetadataIndex.reset(new QuarkMetadataIndex(getQClient(),
+                         getMetadataFlusher(), spec));
+    mFileService->setMetadataIndex(mMetadataIndex.get());
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -314,6 +345,20 @@ folly::Executor* QuarkNamespaceGroup::getExecutor()
   return mExecutor.get();
 }
 
+//------------------------------------------------------------------------------
+// Get secondary metadata index
+//------------------------------------------------------------------------------
+QuarkMetadataIndex* QuarkNamespaceGroup::getMetadataIndex()
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  if (!mFileService) {
+    initializeFileAndContainerServices();
+  }
+
+  return mMetadataIndex.get();
+}
+
 //------------------------------------------------------------------------------
 // Start cache refresh listener
 //------------------------------------------------------------------------------
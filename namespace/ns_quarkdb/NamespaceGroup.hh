@@ -48,6 +48,7 @@ class QuarkFileSystemView;
 class QuarkContainerAccounting;
 class QuarkSyncTimeAccounting;
 class QuarkQuotaStats;
+class QuarkMetadataIndex;
 class MetadataFlusher;
 class CacheRefreshListener;
 
@@ -145,6 +146,11 @@ public:
   //----------------------------------------------------------------------------
   folly::Executor* getExecutor();
 
+  //----------------------------------------------------------------------------
+  //! Get secondary metadata index, nullptr if not configured
+  //----------------------------------------------------------------------------
+  QuarkMetadataIndex* getMetadataIndex();
+
   //----------------------------------------------------------------------------
   //! Start cache refresh listener
   //----------------------------------------------------------------------------
@@ -158,6 +164,7 @@ private:
   std::string queuePath;            //< Namespace queue path
   std::string flusherMDTag;         //< Tag for MD flusher
   std::string flusherQuotaTag;      //< Tag for quota flusher
+  std::string indexSpec;            //< Secondary metadata index spec
 
   //----------------------------------------------------------------------------
   // Initialize file and container services
@@ -183,6 +190,7 @@ private:
   std::unique_ptr<qclient::QClient> mQClient;         //< Main qclient object
   //< used for generic tasks
 
+  std::unique_ptr<QuarkMetadataIndex> mMetadataIndex;
   std::unique_ptr<QuarkContainerMDSvc> mContainerService;
   std::unique_ptr<QuarkFileMDSvc> mFileService;
   std::unique_ptr<QuarkHierarchicalView> mHierarchicalView;
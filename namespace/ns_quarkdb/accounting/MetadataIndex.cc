@@ -0,0 +1,386 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
+#include "namespace/ns_quarkdb/accounting/FileSystemHandler.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include "common/StringTokenizer.hh"
+#include "common/Logging.hh"
+#include "qclient/QClient.hh"
+#include <algorithm>
+#include <iterator>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Split newline separated list of keys
+//------------------------------------------------------------------------------
+std::vector<std::string> splitKeys(const std::string& keys)
+{
+  std::vector<std::string> out;
+  size_t pos = 0;
+
+  while (pos < keys.length()) {
+    size_t end = keys.find('\n', pos);
+
+    if (end == std::string::npos) {
+      end = keys.length();
+    }
+
+    out.emplace_back(keys.substr(pos, end - pos));
+    pos = end + 1;
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Join list of keys with newlines
+//------------------------------------------------------------------------------
+std::string joinKeys(const std::vector<std::string>& keys)
+{
+  std::string out;
+
+  for (const auto& key : keys) {
+    if (!out.empty()) {
+      out += '\n';
+    }
+
+    out += key;
+  }
+
+  return out;
+}
+}
+
+//------------------------------------------------------------------------------
+// Parse specification
+//------------------------------------------------------------------------------
+bool
+QuarkMetadataIndex::Spec::parse(const std::string& str, Spec& spec,
+                                std::string& err)
+{
+  static const std::string xattr_prefix = "xattr:";
+  spec = Spec();
+  std::string tmp = str;
+  std::replace(tmp.begin(), tmp.end(), ',', ' ');
+
+  for (const auto& token : eos::common::StringTokenizer::split<
+         std::vector<std::string>>(tmp, ' ')) {
+    if (token.empty()) {
+      continue;
+    }
+
+    if (token == "uid") {
+      spec.uid = true;
+    } else if (token == "gid") {
+      spec.gid = true;
+    } else if (token == "time") {
+      spec.time = true;
+    } else if (token == "size") {
+      spec.size = true;
+    } else if ((token.find(xattr_prefix) == 0) &&
+               (token.length() > xattr_prefix.length())) {
+      spec.xattrs.insert(token.substr(xattr_prefix.length()));
+    } else {
+      err = "unknown index type \"" + token + "\"";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Canonical string representation
+//------------------------------------------------------------------------------
+std::string
+QuarkMetadataIndex::Spec::toString() const
+{
+  std::vector<std::string> items;
+
+  if (uid) {
+    items.push_back("uid");
+  }
+
+  if (gid) {
+    items.push_back("gid");
+  }
+
+  if (time) {
+    items.push_back("time");
+  }
+
+  if (size) {
+    items.push_back("size");
+  }
+
+  for (const auto& name : xattrs) {
+    items.push_back("xattr:" + name);
+  }
+
+  std::string out;
+
+  for (const auto& item : items) {
+    out += (out.empty() ? "" : ",") + item;
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Intersection of two specifications
+//------------------------------------------------------------------------------
+QuarkMetadataIndex::Spec
+QuarkMetadataIndex::Spec::intersect(const Spec& other) const
+{
+  Spec out;
+  out.uid = uid && other.uid;
+  out.gid = gid && other.gid;
+  out.time = time && other.time;
+  out.size = size && other.size;
+  std::set_intersection(xattrs.begin(), xattrs.end(), other.xattrs.begin(),
+                        other.xattrs.end(),
+                        std::inserter(out.xattrs, out.xattrs.begin()));
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QuarkMetadataIndex::QuarkMetadataIndex(qclient::QClient* qcl,
+                                       MetadataFlusher* flusher,
+                                       const Spec& spec)
+  : pQcl(qcl), pFlusher(flusher), mSpec(spec)
+{}
+
+//------------------------------------------------------------------------------
+// Index bucket keys
+//------------------------------------------------------------------------------
+std::string
+QuarkMetadataIndex::uidKey(uint64_t uid)
+{
+  return mdindex::sPrefix + "uid:" + std::to_string(uid);
+}
+
+std::string
+QuarkMetadataIndex::gidKey(uint64_t gid)
+{
+  return mdindex::sPrefix + "gid:" + std::to_string(gid);
+}
+
+std::string
+QuarkMetadataIndex::ctimeKey(uint64_t sec)
+{
+  return mdindex::sPrefix + "ctime:" + std::to_string(sec /
+         mdindex::sTimeBucket);
+}
+
+std::string
+QuarkMetadataIndex::mtimeKey(uint64_t sec)
+{
+  return mdindex::sPrefix + "mtime:" + std::to_string(sec /
+         mdindex::sTimeBucket);
+}
+
+std::string
+QuarkMetadataIndex::sizeKey(uint64_t size)
+{
+  int bucket = (size ? 64 - __builtin_clzll(size) : 0);
+  return mdindex::sPrefix + "size:" + std::to_string(bucket);
+}
+
+std::string
+QuarkMetadataIndex::xattrKey(const std::string& name, const std::string& value)
+{
+  return mdindex::sPrefix + "xattr:" + name + "=" + value;
+}
+
+//------------------------------------------------------------------------------
+// Get the sorted list of index buckets a file belongs to
+//------------------------------------------------------------------------------
+std::vector<std::string>
+QuarkMetadataIndex::getKeys(const Spec& spec, const IFileMD* fmd)
+{
+  std::vector<std::string> keys;
+
+  if (spec.uid) {
+    keys.push_back(uidKey(fmd->getCUid()));
+  }
+
+  if (spec.gid) {
+    keys.push_back(gidKey(fmd->getCGid()));
+  }
+
+  if (spec.time) {
+    IFileMD::ctime_t ctime, mtime;
+    fmd->getCTime(ctime);
+    fmd->getMTime(mtime);
+    keys.push_back(ctimeKey(ctime.tv_sec));
+    keys.push_back(mtimeKey(mtime.tv_sec));
+  }
+
+  if (spec.size) {
+    keys.push_back(sizeKey(fmd->getSize()));
+  }
+
+  for (const auto& name : spec.xattrs) {
+    if (fmd->hasAttribute(name)) {
+      keys.push_back(xattrKey(name, fmd->getAttribute(name)));
+    }
+  }
+
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+//------------------------------------------------------------------------------
+// Remember the buckets of a file loaded from the backend
+//------------------------------------------------------------------------------
+void
+QuarkMetadataIndex::track(QuarkFileMD* fmd)
+{
+  (void) fmd->swapIndexKeys(joinKeys(getKeys(mSpec, fmd)));
+}
+
+//------------------------------------------------------------------------------
+// Move a stored file to its current buckets
+//------------------------------------------------------------------------------
+void
+QuarkMetadataIndex::update(QuarkFileMD* fmd)
+{
+  std::vector<std::string> keys = getKeys(mSpec, fmd);
+  std::string joined = joinKeys(keys);
+  std::string previous = fmd->swapIndexKeys(joined);
+
+  if (previous == joined) {
+    return;
+  }
+
+  std::vector<std::string> old_keys = splitKeys(previous);
+  std::vector<std::string> removed, added;
+  std::set_difference(old_keys.begin(), old_keys.end(), keys.begin(),
+                      keys.end(), std::back_inserter(removed));
+  std::set_difference(keys.begin(), keys.end(), old_keys.begin(),
+                      old_keys.end(), std::back_inserter(added));
+  const std::string sid = std::to_string(fmd->getId());
+
+  for (const auto& key : removed) {
+    pFlusher->srem(key, sid);
+  }
+
+  for (const auto& key : added) {
+    pFlusher->sadd(key, sid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop a removed file from all its buckets
+//------------------------------------------------------------------------------
+void
+QuarkMetadataIndex::remove(QuarkFileMD* fmd)
+{
+  std::vector<std::string> keys = getKeys(mSpec, fmd);
+  std::vector<std::string> old_keys = splitKeys(fmd->swapIndexKeys(""));
+  std::set<std::string> all(keys.begin(), keys.end());
+  all.insert(old_keys.begin(), old_keys.end());
+  const std::string sid = std::to_string(fmd->getId());
+
+  for (const auto& key : all) {
+    pFlusher->srem(key, sid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the completely built part of the configured specification
+//------------------------------------------------------------------------------
+QuarkMetadataIndex::Spec
+QuarkMetadataIndex::getUsableSpec()
+{
+  Spec built;
+  std::string err;
+  qclient::redisReplyPtr reply = pQcl->exec("HGET", mdindex::sMetaKey,
+                                 mdindex::sBuiltField).get();
+
+  if ((reply == nullptr) || (reply->type != REDIS_REPLY_STRING)) {
+    return built;
+  }
+
+  if (!Spec::parse(std::string(reply->str, reply->len), built, err)) {
+    eos_static_err("msg=\"failed to parse built index specification\" "
+                   "err=\"%s\"", err.c_str());
+    return Spec();
+  }
+
+  return mSpec.intersect(built);
+}
+
+//------------------------------------------------------------------------------
+// Get the number of files in the given buckets
+//------------------------------------------------------------------------------
+uint64_t
+QuarkMetadataIndex::getCount(const std::vector<std::string>& keys)
+{
+  std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+
+  for (const auto& key : keys) {
+    replies.emplace_back(pQcl->exec("SCARD", key));
+  }
+
+  uint64_t count = 0;
+
+  for (auto& fut : replies) {
+    qclient::redisReplyPtr reply = std::move(fut).get();
+
+    if (reply && (reply->type == REDIS_REPLY_INTEGER)) {
+      count += reply->integer;
+    }
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Get streaming iterator over the file ids of an index bucket
+//------------------------------------------------------------------------------
+std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
+    QuarkMetadataIndex::getFileList(const std::string& key)
+{
+  return std::make_shared<StreamingFileListIterator>(*pQcl, key);
+}
+
+//------------------------------------------------------------------------------
+// Drop the "built" marker of the index
+//------------------------------------------------------------------------------
+void
+QuarkMetadataIndex::invalidate(qclient::QClient& qcl)
+{
+  qclient::redisReplyPtr reply = qcl.exec("HDEL", mdindex::sMetaKey,
+                                          mdindex::sBuiltField).get();
+
+  if (reply && (reply->type == REDIS_REPLY_INTEGER) && reply->integer) {
+    eos_static_warning("%s", "msg=\"secondary metadata index is not maintained "
+                       "by this namespace, dropped its built marker\"");
+  }
+}
+
+EOSNSNAMESPACE_END
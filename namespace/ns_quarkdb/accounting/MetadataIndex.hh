@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+//! @file MetadataIndex.hh
+//! @brief Secondary metadata index of files kept in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IFileMD.hh"
+#include "namespace/interface/IFsView.hh"
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+class MetadataFlusher;
+class QuarkFileMD;
+
+//------------------------------------------------------------------------------
+//! Secondary index of the file metadata, stored next to the namespace in
+//! QuarkDB. Every index bucket is a set of file ids:
+//!
+//!   eos-index:uid:<uid>                 files owned by uid
+//!   eos-index:gid:<gid>                 files owned by gid
+//!   eos-index:ctime:<day>               files created on that day
+//!   eos-index:mtime:<day>               files modified on that day
+//!   eos-index:size:<log2>               files with size in [2^(n-1), 2^n)
+//!   eos-index:xattr:<name>=<value>      files carrying the attribute value
+//!
+//! Only the index types listed in the specification are maintained, the
+//! extended attributes to index have to be named explicitly. The buckets are
+//! updated through the metadata flusher whenever a file is stored, using the
+//! list of buckets remembered in the QuarkFileMD object to remove the file
+//! from the buckets it left. The index is a hint: concurrent updates can
+//! leave stale members behind, so every user has to check the candidates it
+//! gets against the real metadata.
+//!
+//! Files written before the index was enabled are added by the
+//! "eos-ns-inspect build-index" command, which records the specification it
+//! completed in the eos-index-meta hash. Only index types recorded there are
+//! complete and can be used to answer queries.
+//------------------------------------------------------------------------------
+class QuarkMetadataIndex
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Index specification
+  //----------------------------------------------------------------------------
+  struct Spec {
+    bool uid = false;
+    bool gid = false;
+    bool time = false;
+    bool size = false;
+    std::set<std::string> xattrs;
+
+    //--------------------------------------------------------------------------
+    //! Parse specification given as comma or space separated list of
+    //! "uid", "gid", "time", "size" and "xattr:<name>" items
+    //!
+    //! @param str specification string
+    //! @param spec parsed specification
+    //! @param err error message if parsing failed
+    //!
+    //! @return true if successful, otherwise false
+    //--------------------------------------------------------------------------
+    static bool parse(const std::string& str, Spec& spec, std::string& err);
+
+    //--------------------------------------------------------------------------
+    //! Canonical string representation, parsable by Spec::parse
+    //--------------------------------------------------------------------------
+    std::string toString() const;
+
+    //--------------------------------------------------------------------------
+    //! Check if nothing is indexed
+    //--------------------------------------------------------------------------
+    bool empty() const
+    {
+      return !uid && !gid && !time && !size && xattrs.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Intersection of two specifications
+    //--------------------------------------------------------------------------
+    Spec intersect(const Spec& other) const;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl qclient used for queries
+  //! @param flusher metadata flusher used for index updates
+  //! @param spec index specification
+  //----------------------------------------------------------------------------
+  QuarkMetadataIndex(qclient::QClient* qcl, MetadataFlusher* flusher,
+                     const Spec& spec);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~QuarkMetadataIndex() = default;
+
+  //----------------------------------------------------------------------------
+  //! Get the configured specification
+  //----------------------------------------------------------------------------
+  const Spec& getSpec() const
+  {
+    return mSpec;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Index bucket keys
+  //----------------------------------------------------------------------------
+  static std::string uidKey(uint64_t uid);
+  static std::string gidKey(uint64_t gid);
+  static std::string ctimeKey(uint64_t sec);
+  static std::string mtimeKey(uint64_t sec);
+  static std::string sizeKey(uint64_t size);
+  static std::string xattrKey(const std::string& name, const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Get the sorted list of index buckets a file belongs to
+  //!
+  //! @param spec index specification
+  //! @param fmd file object
+  //----------------------------------------------------------------------------
+  static std::vector<std::string> getKeys(const Spec& spec, const IFileMD* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Remember the buckets of a file loaded from the backend - the backend is
+  //! assumed to be indexed already
+  //----------------------------------------------------------------------------
+  void track(QuarkFileMD* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Move a stored file to its current buckets
+  //----------------------------------------------------------------------------
+  void update(QuarkFileMD* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Drop a removed file from all its buckets
+  //----------------------------------------------------------------------------
+  void remove(QuarkFileMD* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Get the part of the configured specification which is completely built
+  //! in the backend and can be used to answer queries
+  //----------------------------------------------------------------------------
+  Spec getUsableSpec();
+
+  //----------------------------------------------------------------------------
+  //! Get the number of files in the given buckets, one query round-trip
+  //!
+  //! @param keys index bucket keys
+  //!
+  //! @return sum of the bucket sizes
+  //----------------------------------------------------------------------------
+  uint64_t getCount(const std::vector<std::string>& keys);
+
+  //----------------------------------------------------------------------------
+  //! Get streaming iterator over the file ids of an index bucket
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
+      getFileList(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Drop the "built" marker of the index - called when the namespace runs
+  //! without maintaining the index, which therefore goes stale
+  //----------------------------------------------------------------------------
+  static void invalidate(qclient::QClient& qcl);
+
+private:
+  qclient::QClient* pQcl; ///< QClient object
+  MetadataFlusher* pFlusher; ///< Metadata flusher object
+  const Spec mSpec; ///< Index specification
+};
+
+EOSNSNAMESPACE_END
@@ -76,6 +76,8 @@ QuarkQuotaNode::addFile(const IFileMD* file)
     file->getSize(),
     size
   );
+  pQuotaStats->notifyUsageChanged(pContainerId, file->getCUid(),
+                                  file->getCGid(), file->getSize(), size, 1);
 }
 
 //------------------------------------------------------------------------------
@@ -105,6 +107,8 @@ QuarkQuotaNode::removeFile(const IFileMD* file)
     file->getSize(),
     size
   );
+  pQuotaStats->notifyUsageChanged(pContainerId, file->getCUid(),
+                                  file->getCGid(), -logicalSizeInt, -size, -1);
 }
 
 //------------------------------------------------------------------------------
@@ -146,6 +150,7 @@ QuarkQuotaNode::meld(const IQuotaNode* node)
 
   // Update the cached information
   pCore.meld(node->getCore());
+  pQuotaStats->notifyUsageReset(pContainerId);
 }
 
 //------------------------------------------------------------------------------
@@ -238,6 +243,8 @@ void QuarkQuotaNode::updateFromBackend()
   for (const auto& key_del : to_delete) {
     gid_map.hdel(key_del);
   }
+
+  pQuotaStats->notifyUsageReset(pContainerId);
 }
 
 //------------------------------------------------------------------------------
@@ -281,6 +288,8 @@ QuarkQuotaNode::replaceCore(const QuotaNodeCore& updated)
                    std::to_string(it->second.files)
                   );
   }
+
+  pQuotaStats->notifyUsageReset(pContainerId);
 }
 
 
@@ -324,6 +333,8 @@ QuarkQuotaNode::updateCore(const QuotaNodeCore& updated)
                    std::to_string(it->second.files)
                   );
   }
+
+  pQuotaStats->notifyUsageReset(pContainerId);
 }
 
 //------------------------------------------------------------------------------
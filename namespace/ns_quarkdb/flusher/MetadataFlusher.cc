@@ -22,6 +22,7 @@
 #include <sstream>
 #include <memory>
 #include "qclient/BackgroundFlusher.hh"
+#include "qclient/MultiBuilder.hh"
 #include "qclient/RocksDBPersistency.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
@@ -35,6 +36,106 @@
 
 EOSNSNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Commands staged by a batch
+//------------------------------------------------------------------------------
+struct MetadataFlusher::Batch::Pending {
+  MetadataFlusher* mFlusher = nullptr;
+  qclient::MultiBuilder mMulti;
+  size_t mCommands = 0;
+
+  //----------------------------------------------------------------------------
+  // Add a command, the flusher stages at most five arguments except for
+  // SREM/HINCRBYMULTI with a list which are pushed on their own
+  //----------------------------------------------------------------------------
+  bool Add(const std::vector<std::string>& req)
+  {
+    switch (req.size()) {
+    case 1:
+      mMulti.emplace_back(req[0]);
+      break;
+
+    case 2:
+      mMulti.emplace_back(req[0], req[1]);
+      break;
+
+    case 3:
+      mMulti.emplace_back(req[0], req[1], req[2]);
+      break;
+
+    case 4:
+      mMulti.emplace_back(req[0], req[1], req[2], req[3]);
+      break;
+
+    case 5:
+      mMulti.emplace_back(req[0], req[1], req[2], req[3], req[4]);
+      break;
+
+    default:
+      return false;
+    }
+
+    ++mCommands;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Push the staged commands as one queue entry
+  //----------------------------------------------------------------------------
+  void Push()
+  {
+    if (!mCommands) {
+      return;
+    }
+
+    std::deque<std::string> multi = mMulti.getDeque();
+    mFlusher->backgroundFlusher.pushRequest(std::vector<std::string>
+                                            (multi.begin(), multi.end()));
+    mMulti = qclient::MultiBuilder();
+    mCommands = 0;
+  }
+};
+
+namespace
+{
+//! Batch of the calling thread
+thread_local MetadataFlusher::Batch::Pending* tBatch = nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Batch constructor
+//------------------------------------------------------------------------------
+MetadataFlusher::Batch::Batch(MetadataFlusher* flusher)
+{
+  if (flusher && !tBatch) {
+    mPending.reset(new Pending());
+    mPending->mFlusher = flusher;
+    tBatch = mPending.get();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Batch destructor
+//------------------------------------------------------------------------------
+MetadataFlusher::Batch::~Batch()
+{
+  if (mPending) {
+    mPending->Push();
+    tBatch = nullptr;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Push the commands staged so far
+//------------------------------------------------------------------------------
+void
+MetadataFlusher::Batch::commit()
+{
+  if (mPending) {
+    mPending->Push();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -82,7 +183,7 @@ void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
 void MetadataFlusher::hset(const std::string& key, const std::string& field,
                            const std::string& value)
 {
-  backgroundFlusher.pushRequest({"HSET", key, field, value});
+  stage({"HSET", key, field, value});
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +192,7 @@ void MetadataFlusher::hset(const std::string& key, const std::string& field,
 void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
                               int64_t value)
 {
-  backgroundFlusher.pushRequest({"HINCRBY", key, field, std::to_string(value)});
+  stage({"HINCRBY", key, field, std::to_string(value)});
 }
 
 //------------------------------------------------------------------------------
@@ -99,7 +200,7 @@ void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
 //------------------------------------------------------------------------------
 void MetadataFlusher::del(const std::string& key)
 {
-  backgroundFlusher.pushRequest({"DEL", key});
+  stage({"DEL", key});
 }
 
 //------------------------------------------------------------------------------
@@ -107,7 +208,7 @@ void MetadataFlusher::del(const std::string& key)
 //------------------------------------------------------------------------------
 void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"HDEL", key, field});
+  stage({"HDEL", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -115,7 +216,7 @@ void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SADD", key, field});
+  stage({"SADD", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -123,7 +224,7 @@ void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::srem(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SREM", key, field});
+  stage({"SREM", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -138,6 +239,28 @@ void MetadataFlusher::srem(const std::string& key,
     req.emplace_back(*it);
   }
 
+  stage(req);
+}
+
+//------------------------------------------------------------------------------
+// Add a command to the batch of the calling thread or push it to the queue
+//------------------------------------------------------------------------------
+void
+MetadataFlusher::stage(const std::vector<std::string>& req)
+{
+  if (tBatch && (tBatch->mFlusher == this)) {
+    if (tBatch->Add(req)) {
+      if (tBatch->mCommands >= sMaxBatchCommands) {
+        tBatch->Push();
+      }
+
+      return;
+    }
+
+    // Keep the order of the commands
+    tBatch->Push();
+  }
+
   backgroundFlusher.pushRequest(req);
 }
 
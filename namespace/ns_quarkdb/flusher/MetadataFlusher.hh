@@ -29,6 +29,7 @@
 #include "qclient/AssistedThread.hh"
 #include <list>
 #include <map>
+#include <memory>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -72,7 +73,7 @@ public:
   template<typename... Args>
   void exec(const Args... args)
   {
-    backgroundFlusher.pushRequest(std::vector<std::string> {args...});
+    stage(std::vector<std::string> {args...});
   }
 
   void del(const std::string& key);
@@ -87,7 +88,7 @@ public:
 
   void execute(const std::vector<std::string>& req)
   {
-    backgroundFlusher.pushRequest(req);
+    stage(req);
   }
 
   //----------------------------------------------------------------------------
@@ -99,7 +100,54 @@ public:
   //----------------------------------------------------------------------------
   void synchronize(ItemIndex targetIndex = -1);
 
+  //----------------------------------------------------------------------------
+  //! Group the commands staged by the calling thread while the batch is alive
+  //! into MULTI transactions, each of them a single entry of the flusher
+  //! queue, instead of one queue entry per command. Used by bulk namespace
+  //! mutations. Commands of other threads are not part of the batch, so it
+  //! has to be committed before the namespace lock protecting the modified
+  //! objects is released. A batch opened while another one is active on the
+  //! same thread joins the outer batch.
+  //----------------------------------------------------------------------------
+  class Batch
+  {
+  public:
+    struct Pending;
+
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param flusher flusher to batch, nullptr makes the batch a no-op
+    //--------------------------------------------------------------------------
+    Batch(MetadataFlusher* flusher);
+
+    //--------------------------------------------------------------------------
+    //! Destructor - commits the batch
+    //--------------------------------------------------------------------------
+    ~Batch();
+
+    //--------------------------------------------------------------------------
+    //! Push the commands staged so far to the flusher queue
+    //--------------------------------------------------------------------------
+    void commit();
+
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+  private:
+    std::unique_ptr<Pending> mPending; ///< Staged commands, null if joined
+  };
+
+  //! Maximum number of commands in one MULTI of a batch
+  static constexpr size_t sMaxBatchCommands = 4096;
+
 private:
+  //----------------------------------------------------------------------------
+  //! Add a command to the batch of the calling thread if any, otherwise
+  //! push it to the flusher queue
+  //----------------------------------------------------------------------------
+  void stage(const std::vector<std::string>& req);
+
   void queueSizeMonitoring(qclient::ThreadAssistant& assistant);
   std::string id;
 
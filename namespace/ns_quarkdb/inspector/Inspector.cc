@@ -29,6 +29,7 @@
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/persistency/FileSystemIterator.hh"
 #include "namespace/ns_quarkdb/accounting/FileSystemHandler.hh"
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/Constants.hh"
@@ -1973,6 +1974,101 @@ int Inspector::dropEmptyCid(bool dryRun, uint64_t cid)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Add all files to the secondary metadata index
+//------------------------------------------------------------------------------
+int Inspector::buildIndex(bool dryRun, const std::string& specStr,
+                          std::ostream& out, std::ostream& err)
+{
+  QuarkMetadataIndex::Spec spec;
+  std::string errorString;
+
+  if (!QuarkMetadataIndex::Spec::parse(specStr, spec, errorString) ||
+      spec.empty()) {
+    err << "Invalid index specification: " << errorString << std::endl;
+    return 1;
+  }
+
+  FileScanner fileScanner(mQcl);
+  common::IntervalStopwatch stopwatch(std::chrono::seconds(10));
+  std::deque<folly::Future<qclient::redisReplyPtr>> pending;
+  std::map<std::string, uint64_t> buckets;
+  uint64_t failed = 0;
+
+  while (fileScanner.valid()) {
+    eos::ns::FileMdProto proto;
+
+    if (!fileScanner.getItem(proto)) {
+      break;
+    }
+
+    QuarkFileMD fmd;
+    fmd.initialize(std::move(proto));
+    const std::string sid = std::to_string(fmd.getId());
+
+    for (const auto& key : QuarkMetadataIndex::getKeys(spec, &fmd)) {
+      buckets[key]++;
+
+      if (!dryRun) {
+        pending.emplace_back(mQcl.exec("SADD", key, sid));
+      }
+    }
+
+    while (!pending.empty() && (pending.front().isReady() ||
+                                pending.size() > 10000)) {
+      qclient::redisReplyPtr reply = std::move(pending.front()).get();
+      failed += ((reply == nullptr) || (reply->type != REDIS_REPLY_INTEGER));
+      pending.pop_front();
+    }
+
+    if (stopwatch.restartIfExpired()) {
+      err << "Progress: Processed " << fileScanner.getScannedSoFar() <<
+          " files so far..." << std::endl;
+    }
+
+    fileScanner.next();
+  }
+
+  for (auto& fut : pending) {
+    qclient::redisReplyPtr reply = std::move(fut).get();
+    failed += ((reply == nullptr) || (reply->type != REDIS_REPLY_INTEGER));
+  }
+
+  if (fileScanner.hasError(errorString)) {
+    err << errorString;
+    return 1;
+  }
+
+  out << "files=" << fileScanner.getScannedSoFar() << " buckets=" <<
+      buckets.size() << " spec=" << spec.toString() << std::endl;
+
+  if (dryRun) {
+    for (const auto& bucket : buckets) {
+      out << bucket.first << " " << bucket.second << std::endl;
+    }
+
+    out << "Dry run, index not modified" << std::endl;
+    return 0;
+  }
+
+  if (failed) {
+    err << "Failed to add " << failed << " index entries, index not marked "
+        "as built" << std::endl;
+    return 1;
+  }
+
+  qclient::redisReplyPtr reply = mQcl.exec("HSET", mdindex::sMetaKey,
+                                 mdindex::sBuiltField, spec.toString()).get();
+
+  if ((reply == nullptr) || (reply->type != REDIS_REPLY_INTEGER)) {
+    err << "Failed to mark index as built" << std::endl;
+    return 1;
+  }
+
+  out << "Index built" << std::endl;
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Change the given fid - USE WITH CAUTION
 //------------------------------------------------------------------------------
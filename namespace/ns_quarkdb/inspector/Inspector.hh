@@ -177,6 +177,13 @@ public:
   //------------------------------------------------------------------------------
   int dropEmptyCid(bool dryRun, uint64_t cid);
 
+  //----------------------------------------------------------------------------
+  //! Add all files to the secondary metadata index of the given specification
+  //! and mark it as built, so that the MGM starts using it for queries
+  //----------------------------------------------------------------------------
+  int buildIndex(bool dryRun, const std::string& spec, std::ostream& out,
+                 std::ostream& err);
+
   //----------------------------------------------------------------------------
   //! Change the given fid - USE WITH CAUTION
   //----------------------------------------------------------------------------
@@ -233,6 +233,7 @@ QuarkContainerMDSvc::updateStore(IContainerMD* obj)
   }
 
   pFlusher->execute(RequestBuilder::writeContainerProto(obj));
+  notifyListeners(obj, IContainerMDChangeListener::Updated);
 }
 
 //----------------------------------------------------------------------------
@@ -258,6 +259,7 @@ QuarkContainerMDSvc::removeContainer(IContainerMD* obj)
     pFlusher->del(constants::sMapMetaInfoKey);
   }
 
+  notifyListeners(obj, IContainerMDChangeListener::Deleted);
   obj->setDeleted();
 
   if (mNumConts) {
@@ -22,6 +22,7 @@
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
@@ -251,6 +252,13 @@ QuarkFileMDSvc::updateStore(IFileMD* obj)
   if (obj->getContainerId() == 0) {
     pFlusher->sadd(constants::sOrphanFiles, stringify(obj->getId()));
   }
+
+  if (pIndex) {
+    pIndex->update(static_cast<QuarkFileMD*>(obj));
+  }
+
+  IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Updated);
+  notifyListeners(&e);
 }
 
 //------------------------------------------------------------------------------
@@ -263,6 +271,11 @@ QuarkFileMDSvc::removeFile(IFileMD* obj)
   pFlusher->execute(RequestBuilder::deleteFileProto(FileIdentifier(
                       obj->getId())));
   pFlusher->srem(constants::sOrphanFiles, sid);
+
+  if (pIndex) {
+    pIndex->remove(static_cast<QuarkFileMD*>(obj));
+  }
+
   IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Deleted);
   notifyListeners(&e);
   obj->setDeleted();
@@ -34,6 +34,7 @@ EOSNSNAMESPACE_BEGIN
 class IQuotaStats;
 class MetadataFlusher;
 class MetadataProvider;
+class QuarkMetadataIndex;
 
 //------------------------------------------------------------------------------
 //! FileMDSvc based on Redis
@@ -188,6 +189,22 @@ public:
   //----------------------------------------------------------------------------
   MetadataProvider* getMetadataProvider();
 
+  //----------------------------------------------------------------------------
+  //! Set secondary metadata index to maintain, can be nullptr
+  //----------------------------------------------------------------------------
+  void setMetadataIndex(QuarkMetadataIndex* index)
+  {
+    pIndex = index;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get secondary metadata index, nullptr if not enabled
+  //----------------------------------------------------------------------------
+  QuarkMetadataIndex* getMetadataIndex() const
+  {
+    return pIndex;
+  }
+
 
 private:
   typedef std::list<IFileMDChangeListener*> ListenerList;
@@ -205,6 +222,7 @@ private:
   IQuotaStats* pQuotaStats; ///< Quota view
   IContainerMDSvc* pContSvc; ///< Container metadata service
   MetadataFlusher* pFlusher = nullptr; ///< Metadata flusher object
+  QuarkMetadataIndex* pIndex = nullptr; ///< Secondary metadata index
   qclient::QClient* pQcl; ///< QClient object
   qclient::QHash mMetaMap ; ///< Map holding metainfo about the namespace
   std::atomic<uint64_t> mNumFiles; ///< Total number of fileso
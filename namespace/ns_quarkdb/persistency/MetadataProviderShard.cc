@@ -26,6 +26,7 @@
 #include "MetadataProviderShard.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
 #include "namespace/MDException.hh"
 #include "common/Assert.hh"
 #include <functional>
@@ -313,6 +314,13 @@ MetadataProviderShard::processIncomingFileMdProto(FileIdentifier id,
   // Yep, construct FileMD object..
   QuarkFileMD* fileMD = new QuarkFileMD(0, mFileSvc);
   fileMD->initialize(std::move(proto));
+  QuarkMetadataIndex* index = (mFileSvc ? static_cast<QuarkFileMDSvc*>
+                               (mFileSvc)->getMetadataIndex() : nullptr);
+
+  if (index) {
+    index->track(fileMD);
+  }
+
   // Drop inFlightFiles future..
   auto it = mInFlightFiles.find(id);
   eos_assert(it != mInFlightFiles.end());
@@ -29,6 +29,7 @@
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "namespace/ns_quarkdb/tests/TestUtils.hh"
 #include "namespace/ns_quarkdb/utils/QuotaRecomputer.hh"
+#include "namespace/ns_quarkdb/utils/QuotaRecomputeJob.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/utils/RenameSafetyCheck.hh"
 #include "namespace/utils/RmrfHelper.hh"
@@ -744,6 +745,142 @@ TEST_F(HierarchicalViewF, QuotaRecomputation)
   ASSERT_EQ(qnc.getNumFilesByGroup(200), 0);
 }
 
+TEST_F(HierarchicalViewF, IncrementalQuotaRecomputation)
+{
+  eos::IContainerMDPtr quota = view()->createContainer("/quota-inc", true);
+  eos::IContainerMDPtr deeper =
+    view()->createContainer("/quota-inc/sub/deeper", true);
+  eos::IContainerMDPtr nested =
+    view()->createContainer("/quota-inc/nested", true);
+  unsigned long layoutId = eos::common::LayoutId::GetId(
+                             eos::common::LayoutId::kReplica,
+                             eos::common::LayoutId::kMD5,
+                             2,
+                             eos::common::LayoutId::k4k);
+
+  for (size_t i = 0; i < 5; i++) {
+    eos::IFileMDPtr file = view()->createFile(SSTR("/quota-inc/f" << i), true);
+    file->setSize(100);
+    file->setLayoutId(layoutId);
+    file->setCUid(1);
+    file->setCGid(2);
+    fileSvc()->updateStore(file.get());
+  }
+
+  for (size_t i = 0; i < 10; i++) {
+    eos::IFileMDPtr file =
+      view()->createFile(SSTR("/quota-inc/sub/deeper/f" << i), true);
+    file->setSize(10);
+    file->setLayoutId(layoutId);
+    file->setCUid(3);
+    file->setCGid(4);
+    fileSvc()->updateStore(file.get());
+  }
+
+  for (size_t i = 0; i < 3; i++) {
+    eos::IFileMDPtr file =
+      view()->createFile(SSTR("/quota-inc/nested/f" << i), true);
+    file->setSize(1000);
+    file->setLayoutId(layoutId);
+    file->setCUid(5);
+    file->setCGid(6);
+    fileSvc()->updateStore(file.get());
+  }
+
+  ASSERT_NE(view()->registerQuotaNode(quota.get()), nullptr);
+  ASSERT_NE(view()->registerQuotaNode(nested.get()), nullptr);
+  mdFlusher()->synchronize();
+  {
+    eos::QuotaRecomputeJob job(&(qcl()), quota->getId());
+    ASSERT_TRUE(job.load().ok());
+    ASSERT_TRUE(job.hasPending());
+    // An interrupted walk keeps what is still to visit
+    ASSERT_EQ(job.walk(4, []() {
+      return true;
+    }).getErrno(), EINTR);
+    ASSERT_TRUE(job.hasPending());
+    // A bounded walk stops after the given number of containers
+    ASSERT_EQ(job.walk(4, []() {
+      return false;
+    }, 1).getErrno(), EINTR);
+    ASSERT_EQ(job.getProgress().mContainers, 1);
+    ASSERT_TRUE(job.hasPending());
+    ASSERT_TRUE(job.walk(4, []() {
+      return false;
+    }).ok());
+    ASSERT_FALSE(job.hasPending());
+    eos::QuotaNodeCore qnc;
+    job.getCore(qnc);
+    ASSERT_EQ(qnc.getUsedSpaceByUser(1), 500);
+    ASSERT_EQ(qnc.getPhysicalSpaceByUser(1), 1000);
+    ASSERT_EQ(qnc.getNumFilesByUser(1), 5);
+    ASSERT_EQ(qnc.getUsedSpaceByGroup(4), 100);
+    ASSERT_EQ(qnc.getNumFilesByGroup(4), 10);
+    // The nested quota node is not accounted
+    ASSERT_EQ(qnc.getNumFilesByUser(5), 0);
+    ASSERT_EQ(job.getProgress().mContainers, 3);
+    ASSERT_EQ(job.getProgress().mFiles, 15);
+    // Change the namespace while the job is alive
+    eos::IFileMDPtr file = view()->getFile("/quota-inc/f0");
+    file->setSize(200);
+    fileSvc()->updateStore(file.get());
+    eos::IContainerMDPtr more =
+      view()->createContainer("/quota-inc/sub/more", true);
+    file = view()->createFile("/quota-inc/sub/more/f0", true);
+    file->setSize(7);
+    file->setLayoutId(layoutId);
+    file->setCUid(7);
+    file->setCGid(8);
+    fileSvc()->updateStore(file.get());
+    ASSERT_TRUE(job.markDirty(quota->getId()));
+    ASSERT_TRUE(job.markDirty(more->getParentId()));
+    ASSERT_FALSE(job.markDirty(quota->getId()));
+    ASSERT_EQ(job.getNumDirty(), 2);
+    mdFlusher()->synchronize();
+    ASSERT_TRUE(job.reconcile(job.takeDirty()).ok());
+    ASSERT_EQ(job.getNumDirty(), 0);
+    ASSERT_TRUE(job.hasPending());
+    ASSERT_TRUE(job.walk(4, []() {
+      return false;
+    }).ok());
+    job.getCore(qnc);
+    ASSERT_EQ(qnc.getUsedSpaceByUser(1), 600);
+    ASSERT_EQ(qnc.getPhysicalSpaceByUser(1), 1200);
+    ASSERT_EQ(qnc.getUsedSpaceByUser(7), 7);
+    ASSERT_EQ(qnc.getNumFilesByGroup(8), 1);
+    ASSERT_EQ(job.getProgress().mContainers, 4);
+    ASSERT_EQ(job.getProgress().mReconciled, 2);
+    // Removing a subtree drops everything below it
+    view()->removeFile(view()->getFile("/quota-inc/sub/more/f0").get());
+    view()->removeContainer("/quota-inc/sub/more");
+    eos::IContainerMDPtr sub = view()->getContainer("/quota-inc/sub");
+    ASSERT_TRUE(job.markDirty(sub->getId()));
+    mdFlusher()->synchronize();
+    ASSERT_TRUE(job.reconcile(job.takeDirty()).ok());
+    ASSERT_FALSE(job.hasPending());
+    job.getCore(qnc);
+    ASSERT_EQ(qnc.getNumFilesByUser(7), 0);
+    ASSERT_EQ(job.getProgress().mContainers, 3);
+  }
+  // A new instance resumes from the checkpoint
+  eos::QuotaRecomputeJob resumed(&(qcl()), quota->getId());
+  ASSERT_TRUE(resumed.load().ok());
+  ASSERT_FALSE(resumed.hasPending());
+  eos::QuotaNodeCore qnc;
+  resumed.getCore(qnc);
+  ASSERT_EQ(qnc.getUsedSpaceByUser(1), 600);
+  ASSERT_EQ(qnc.getNumFilesByUser(1), 5);
+  ASSERT_EQ(qnc.getNumFilesByUser(3), 10);
+  ASSERT_EQ(resumed.getProgress().mContainers, 3);
+  // Once cleared the next job starts from scratch
+  resumed.clear();
+  eos::QuotaRecomputeJob fresh(&(qcl()), quota->getId());
+  ASSERT_TRUE(fresh.load().ok());
+  ASSERT_TRUE(fresh.hasPending());
+  ASSERT_EQ(fresh.getProgress().mContainers, 0);
+  fresh.clear();
+}
+
 TEST_F(HierarchicalViewF, CustomContainerId)
 {
   eos::IContainerMDPtr c32 = view()->createContainer("/c32", false, 32);
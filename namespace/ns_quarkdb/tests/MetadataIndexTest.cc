@@ -0,0 +1,145 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Secondary metadata index tests
+//------------------------------------------------------------------------------
+#include "namespace/ns_quarkdb/accounting/MetadataIndex.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include "namespace/ns_quarkdb/tests/TestUtils.hh"
+#include "namespace/interface/IView.hh"
+#include <qclient/QClient.hh>
+#include <gtest/gtest.h>
+
+using eos::QuarkMetadataIndex;
+
+TEST(MetadataIndex, SpecParsing)
+{
+  QuarkMetadataIndex::Spec spec;
+  std::string err;
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("", spec, err));
+  ASSERT_TRUE(spec.empty());
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("xattr:sys.b, gid uid,,xattr:sys.a",
+              spec, err));
+  ASSERT_TRUE(spec.uid);
+  ASSERT_TRUE(spec.gid);
+  ASSERT_FALSE(spec.time);
+  ASSERT_FALSE(spec.size);
+  ASSERT_EQ(spec.toString(), "uid,gid,xattr:sys.a,xattr:sys.b");
+  ASSERT_FALSE(QuarkMetadataIndex::Spec::parse("uid,owner", spec, err));
+  ASSERT_FALSE(QuarkMetadataIndex::Spec::parse("xattr:", spec, err));
+  QuarkMetadataIndex::Spec a, b;
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("uid,time,xattr:x,xattr:y", a,
+              err));
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("uid,size,xattr:y", b, err));
+  ASSERT_EQ(a.intersect(b).toString(), "uid,xattr:y");
+}
+
+TEST(MetadataIndex, Keys)
+{
+  ASSERT_EQ(QuarkMetadataIndex::uidKey(12), "eos-index:uid:12");
+  ASSERT_EQ(QuarkMetadataIndex::gidKey(34), "eos-index:gid:34");
+  ASSERT_EQ(QuarkMetadataIndex::sizeKey(0), "eos-index:size:0");
+  ASSERT_EQ(QuarkMetadataIndex::sizeKey(1), "eos-index:size:1");
+  ASSERT_EQ(QuarkMetadataIndex::sizeKey(1023), "eos-index:size:10");
+  ASSERT_EQ(QuarkMetadataIndex::sizeKey(1024), "eos-index:size:11");
+  ASSERT_EQ(QuarkMetadataIndex::mtimeKey(86399), "eos-index:mtime:0");
+  ASSERT_EQ(QuarkMetadataIndex::ctimeKey(86400), "eos-index:ctime:1");
+  ASSERT_EQ(QuarkMetadataIndex::xattrKey("sys.a", "v"),
+            "eos-index:xattr:sys.a=v");
+  QuarkMetadataIndex::Spec spec;
+  std::string err;
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("uid,gid,time,size,xattr:sys.a",
+              spec, err));
+  eos::QuarkFileMD fmd;
+  fmd.setCUid(5);
+  fmd.setCGid(6);
+  fmd.setSize(4096);
+  eos::IFileMD::ctime_t tm {3 * 86400 + 5, 0};
+  fmd.setCTime(tm);
+  fmd.setMTime(tm);
+  std::vector<std::string> expected {
+    "eos-index:ctime:3", "eos-index:gid:6", "eos-index:mtime:3",
+    "eos-index:size:13", "eos-index:uid:5"};
+  ASSERT_EQ(QuarkMetadataIndex::getKeys(spec, &fmd), expected);
+  fmd.setAttribute("sys.a", "v");
+  fmd.setAttribute("sys.b", "w");
+  expected.push_back("eos-index:xattr:sys.a=v");
+  ASSERT_EQ(QuarkMetadataIndex::getKeys(spec, &fmd), expected);
+}
+
+class MetadataIndexF : public eos::ns::testing::NsTestsFixture {};
+
+TEST_F(MetadataIndexF, Maintenance)
+{
+  QuarkMetadataIndex::Spec spec;
+  std::string err;
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("uid,gid,xattr:sys.a", spec,
+              err));
+  QuarkMetadataIndex index(&qcl(), mdFlusher(), spec);
+  view()->createContainer("/index/", true);
+  std::shared_ptr<eos::IFileMD> file = view()->createFile("/index/f1", 10, 20);
+  eos::QuarkFileMD* fmd = static_cast<eos::QuarkFileMD*>(file.get());
+  const std::string uid10 = QuarkMetadataIndex::uidKey(10);
+  const std::string uid11 = QuarkMetadataIndex::uidKey(11);
+  const std::string gid20 = QuarkMetadataIndex::gidKey(20);
+  const std::string attr = QuarkMetadataIndex::xattrKey("sys.a", "v");
+  index.update(fmd);
+  mdFlusher()->synchronize();
+  ASSERT_EQ(index.getCount({uid10}), 1u);
+  ASSERT_EQ(index.getCount({gid20}), 1u);
+  ASSERT_EQ(index.getCount({uid11}), 0u);
+  auto it = index.getFileList(uid10);
+  ASSERT_TRUE(it->valid());
+  ASSERT_EQ(it->getElement(), file->getId());
+  // Changed owner and new attribute move the file between buckets
+  file->setCUid(11);
+  file->setAttribute("sys.a", "v");
+  index.update(fmd);
+  mdFlusher()->synchronize();
+  ASSERT_EQ(index.getCount({uid10}), 0u);
+  ASSERT_EQ(index.getCount({uid11, gid20, attr}), 3u);
+  // A file loaded from the backend only remembers its buckets
+  eos::QuarkFileMD loaded;
+  loaded.initialize(eos::ns::FileMdProto(fmd->getProto()));
+  index.track(&loaded);
+  loaded.setCGid(21);
+  index.update(&loaded);
+  mdFlusher()->synchronize();
+  ASSERT_EQ(index.getCount({gid20}), 0u);
+  ASSERT_EQ(index.getCount({QuarkMetadataIndex::gidKey(21)}), 1u);
+  index.remove(&loaded);
+  mdFlusher()->synchronize();
+  ASSERT_EQ(index.getCount({uid11, QuarkMetadataIndex::gidKey(21), attr}), 0u);
+}
+
+TEST_F(MetadataIndexF, UsableSpec)
+{
+  QuarkMetadataIndex::Spec spec;
+  std::string err;
+  ASSERT_TRUE(QuarkMetadataIndex::Spec::parse("uid,gid", spec, err));
+  QuarkMetadataIndex index(&qcl(), mdFlusher(), spec);
+  ASSERT_TRUE(index.getUsableSpec().empty());
+  qcl().exec("HSET", eos::mdindex::sMetaKey, eos::mdindex::sBuiltField,
+             "uid,time").get();
+  ASSERT_EQ(index.getUsableSpec().toString(), "uid");
+  QuarkMetadataIndex::invalidate(qcl());
+  ASSERT_TRUE(index.getUsableSpec().empty());
+}
@@ -561,6 +561,31 @@ TEST_F(VariousTests, createFile)
                eos::MDException);
 }
 
+TEST_F(VariousTests, BatchedFlusherWrites)
+{
+  containerSvc()->updateStore(view()->createContainer("/eos/bulk",
+                              true).get());
+  {
+    eos::MetadataFlusher::Batch batch(mdFlusher());
+    // Nested batches join the outer one
+    eos::MetadataFlusher::Batch nested(mdFlusher());
+
+    for (size_t i = 0; i < 2 * eos::MetadataFlusher::sMaxBatchCommands; ++i) {
+      IFileMDPtr file = view()->createFile(SSTR("/eos/bulk/file-" << i));
+      file->setSize(i);
+      fileSvc()->updateStore(file.get());
+    }
+  }
+  mdFlusher()->synchronize();
+  shut_down_everything();
+  IContainerMDPtr cont = view()->getContainer("/eos/bulk");
+  ASSERT_EQ(cont->getNumFiles(), 2 * eos::MetadataFlusher::sMaxBatchCommands);
+
+  for (size_t i = 0; i < 2 * eos::MetadataFlusher::sMaxBatchCommands; ++i) {
+    ASSERT_EQ(view()->getFile(SSTR("/eos/bulk/file-" << i))->getSize(), i);
+  }
+}
+
 TEST_F(VariousTests, createContainerMadness)
 {
   containerSvc()->updateStore(view()->createContainer("/eos/dev/../dev/",
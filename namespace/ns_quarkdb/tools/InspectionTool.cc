@@ -361,6 +361,18 @@ int main(int argc, char* argv[])
                            "Specify which container ID to drop")
   ->required();
   //----------------------------------------------------------------------------
+  // Set-up build-index subcommand..
+  //----------------------------------------------------------------------------
+  std::string indexSpec;
+  auto buildIndexSubcommand = app.add_subcommand("build-index",
+                              "Add all files to the secondary metadata index and mark it as built. The MGM has to maintain the same index (mgmofs.nsindex) while this runs.");
+  addClusterOptions(buildIndexSubcommand, membersStr, memberValidator, password,
+                    passwordFile, connectionRetries);
+  addDryRun(buildIndexSubcommand, noDryRun);
+  buildIndexSubcommand->add_option("--spec", indexSpec,
+                                   "Index specification, eg. \"uid,gid,time,size,xattr:sys.archive.status\"")
+  ->required();
+  //----------------------------------------------------------------------------
   // Change fid protobuf properties
   //----------------------------------------------------------------------------
   auto changeFidSubcommand = app.add_subcommand("change-fid",
@@ -602,6 +614,10 @@ int main(int argc, char* argv[])
     return inspector.dropEmptyCid(dryRun, cid);
   }
 
+  if (buildIndexSubcommand->parsed()) {
+    return inspector.buildIndex(dryRun, indexSpec, std::cout, std::cerr);
+  }
+
   if (changeFidSubcommand->parsed()) {
     return inspector.changeFid(dryRun, fid, newParent, newChecksum, newSize,
                                newLayoutId, std::cout, std::cerr);
@@ -0,0 +1,793 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Incremental, checkpointed recomputation of a quota node
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_quarkdb/utils/QuotaRecomputeJob.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
+#include "namespace/Constants.hh"
+#include "common/LayoutId.hh"
+#include "common/Logging.hh"
+#include "qclient/QClient.hh"
+#include "qclient/MultiBuilder.hh"
+#include "qclient/structures/QHash.hh"
+#include "qclient/structures/QSet.hh"
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//! Prefix of the checkpoint keys
+const std::string sKeyPrefix = "quota-recompute:";
+//! Containers visited by a worker before its checkpoint batch is written
+constexpr size_t cCheckpointContainers = 64;
+//! Commands after which a checkpoint batch is written anyway
+constexpr size_t cCheckpointCommands = 4096;
+//! Entries fetched per round trip by reconcile
+constexpr size_t cReconcileBatch = 1024;
+//! Entries and members per scan when resuming
+constexpr int64_t cScanCount = 100000;
+//! Parents followed to decide if a container is below the quota node
+constexpr size_t cMaxDepth = 2048;
+
+//------------------------------------------------------------------------------
+// Check that all the commands of a transaction succeeded
+//------------------------------------------------------------------------------
+bool IsMultiOk(const qclient::redisReplyPtr& reply)
+{
+  if (!reply || (reply->type != REDIS_REPLY_ARRAY)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < reply->elements; ++i) {
+    if (reply->element[i]->type == REDIS_REPLY_ERROR) {
+      return false;
+    }
+  }
+
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+// Serialize a checkpoint entry
+//------------------------------------------------------------------------------
+std::string
+QuotaRecomputeJob::Entry::serialize() const
+{
+  std::ostringstream oss;
+
+  for (size_t i = 0; i < mChildren.size(); ++i) {
+    oss << (i ? "," : "") << mChildren[i];
+  }
+
+  oss << "|";
+  bool first = true;
+
+  for (const auto& elem : mUsage) {
+    oss << (first ? "" : ",") << elem.first.first << ":" << elem.first.second
+        << ":" << elem.second.files << ":" << elem.second.space << ":"
+        << elem.second.physicalSpace;
+    first = false;
+  }
+
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Parse a checkpoint entry
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::Entry::deserialize(const std::string& data)
+{
+  mChildren.clear();
+  mUsage.clear();
+  size_t sep = data.find('|');
+
+  if (sep == std::string::npos) {
+    return false;
+  }
+
+  try {
+    std::istringstream children(data.substr(0, sep));
+    std::string item;
+
+    while (std::getline(children, item, ',')) {
+      mChildren.push_back(std::stoull(item));
+    }
+
+    std::istringstream usage(data.substr(sep + 1));
+
+    while (std::getline(usage, item, ',')) {
+      uint64_t val[5];
+      size_t pos = 0;
+
+      for (size_t i = 0; i < 5; ++i) {
+        size_t end = item.find(':', pos);
+
+        if ((end == std::string::npos) != (i == 4)) {
+          return false;
+        }
+
+        val[i] = std::stoull(item.substr(pos, end - pos));
+        pos = end + 1;
+      }
+
+      QuotaNodeCore::UsageInfo& info = mUsage[ {val[0], val[1]}];
+      info.files = val[2];
+      info.space = val[3];
+      info.physicalSpace = val[4];
+    }
+  } catch (const std::exception& e) {
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QuotaRecomputeJob::QuotaRecomputeJob(qclient::QClient* qcl,
+                                     IContainerMD::id_t cont_id)
+  : mQcl(qcl), mContId(cont_id), mStart(std::chrono::steady_clock::now()) {}
+
+//------------------------------------------------------------------------------
+// Checkpoint keys
+//------------------------------------------------------------------------------
+std::string
+QuotaRecomputeJob::KeyEntries(IContainerMD::id_t cont_id)
+{
+  return sKeyPrefix + std::to_string(cont_id) + ":entries";
+}
+
+std::string
+QuotaRecomputeJob::KeyPending(IContainerMD::id_t cont_id)
+{
+  return sKeyPrefix + std::to_string(cont_id) + ":pending";
+}
+
+std::string
+QuotaRecomputeJob::KeyDirty(IContainerMD::id_t cont_id)
+{
+  return sKeyPrefix + std::to_string(cont_id) + ":dirty";
+}
+
+//------------------------------------------------------------------------------
+// Resume from the checkpoint or start a new walk
+//------------------------------------------------------------------------------
+MDStatus
+QuotaRecomputeJob::load()
+{
+  if (mContId == 0ull) {
+    return MDStatus(EINVAL, "error: requested computation for cid=0");
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFrontier.clear();
+  mTotal.clear();
+  mContainers = mFiles = mReconciled = mWalked = mWalkedFiles = 0;
+  mStatus = MDStatus();
+  mStart = std::chrono::steady_clock::now();
+
+  try {
+    // Everything recorded so far makes up the usage
+    qclient::QHash entries(*mQcl, KeyEntries(mContId));
+    std::string cursor = "0";
+
+    do {
+      auto reply = entries.hscan(cursor, cScanCount);
+      cursor = reply.first;
+
+      for (const auto& elem : reply.second) {
+        Entry entry;
+
+        if (!entry.deserialize(elem.second)) {
+          return MDStatus(EIO, SSTR("error: corrupted checkpoint entry of "
+                                    "container " << elem.first));
+        }
+
+        applyUsage(entry.mUsage, true);
+        ++mContainers;
+      }
+    } while (cursor != "0");
+
+    qclient::QSet set(*mQcl, KeyPending(mContId));
+    cursor = "0";
+
+    do {
+      auto reply = set.sscan(cursor, cScanCount);
+      cursor = reply.first;
+
+      for (const auto& elem : reply.second) {
+        mFrontier.push_back(std::stoull(elem));
+      }
+    } while (cursor != "0");
+
+    // Containers changed before an interruption are re-read at the end
+    set.setKey(KeyDirty(mContId));
+    cursor = "0";
+
+    do {
+      auto reply = set.sscan(cursor, cScanCount);
+      cursor = reply.first;
+      std::lock_guard<std::mutex> dirty_lock(mDirtyMutex);
+
+      for (const auto& elem : reply.second) {
+        mDirty.insert(std::stoull(elem));
+      }
+    } while (cursor != "0");
+
+    if ((mContainers == 0) && mFrontier.empty()) {
+      qclient::redisReplyPtr reply = mQcl->exec("SADD", KeyPending(mContId),
+                                     std::to_string(mContId)).get();
+
+      if (!reply || (reply->type == REDIS_REPLY_ERROR)) {
+        return MDStatus(EIO, "error: failed to store checkpoint");
+      }
+
+      mFrontier.push_back(mContId);
+    }
+  } catch (const std::exception& e) {
+    return MDStatus(EIO, SSTR("error: failed to load checkpoint: "
+                              << e.what()));
+  }
+
+  return MDStatus();
+}
+
+//------------------------------------------------------------------------------
+// Visit all pending containers
+//------------------------------------------------------------------------------
+MDStatus
+QuotaRecomputeJob::walk(size_t threads, std::function<bool()> stopped,
+                        uint64_t max_containers)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStatus = MDStatus();
+    mWalkLimit = (max_containers ? mContainers + max_containers : 0);
+  }
+  std::vector<std::thread> workers;
+
+  for (size_t i = 0; i < std::max(threads, (size_t)1); ++i) {
+    workers.emplace_back(&QuotaRecomputeJob::walkWorker, this,
+                         std::cref(stopped));
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mStatus.ok() && !mFrontier.empty()) {
+    return MDStatus(EINTR, "error: quota recomputation interrupted");
+  }
+
+  return mStatus;
+}
+
+//------------------------------------------------------------------------------
+// Walk worker loop
+//------------------------------------------------------------------------------
+void
+QuotaRecomputeJob::walkWorker(const std::function<bool()>& stopped)
+{
+  qclient::MultiBuilder multi;
+  size_t num_cmds = 0;
+  size_t num_conts = 0;
+
+  while (true) {
+    IContainerMD::id_t id = 0;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      while (mFrontier.empty() && mInFlight && mStatus.ok()) {
+        mCond.wait_for(lock, std::chrono::seconds(1));
+      }
+
+      if (mFrontier.empty() || !mStatus.ok() || stopped() ||
+          (mWalkLimit && (mContainers + mInFlight >= mWalkLimit))) {
+        break;
+      }
+
+      id = mFrontier.front();
+      mFrontier.pop_front();
+      ++mInFlight;
+    }
+    Entry entry;
+    bool failed = false;
+
+    try {
+      entry = readContainer(id);
+    } catch (const std::exception& e) {
+      // Removed meanwhile, its parent is dirty and drops it during reconcile
+      eos_static_debug("msg=\"failed to read container\" cxid=%08llx "
+                       "emsg=\"%s\"", id, e.what());
+    }
+
+    const std::string sid = std::to_string(id);
+    multi.emplace_back("HSET", KeyEntries(mContId), sid, entry.serialize());
+    multi.emplace_back("SREM", KeyPending(mContId), sid);
+    num_cmds += 2;
+
+    for (auto child : entry.mChildren) {
+      multi.emplace_back("SADD", KeyPending(mContId), std::to_string(child));
+      ++num_cmds;
+    }
+
+    // A worker may visit the children before its batch is written. This is
+    // harmless: after an interruption the parent and the children are
+    // simply visited again and their entries overwritten.
+    if ((++num_conts >= cCheckpointContainers) ||
+        (num_cmds >= cCheckpointCommands)) {
+      failed = !writeCheckpoint(multi);
+      num_cmds = num_conts = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    const uint64_t files = mFiles;
+    applyUsage(entry.mUsage, true);
+    mWalkedFiles += mFiles - files;
+    ++mContainers;
+    ++mWalked;
+    --mInFlight;
+
+    for (auto child : entry.mChildren) {
+      mFrontier.push_back(child);
+    }
+
+    if (failed && mStatus.ok()) {
+      mStatus = MDStatus(EIO, "error: failed to store checkpoint");
+    }
+
+    mCond.notify_all();
+  }
+
+  if (num_conts && !writeCheckpoint(multi)) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mStatus.ok()) {
+      mStatus = MDStatus(EIO, "error: failed to store checkpoint");
+    }
+  }
+
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Write a batch of checkpoint commands as one transaction
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::writeCheckpoint(qclient::MultiBuilder& multi)
+{
+  bool ok = false;
+
+  try {
+    ok = IsMultiOk(mQcl->follyExecute(multi.getDeque()).get());
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to store quota recomputation checkpoint\" "
+                   "cxid=%08llx emsg=\"%s\"", mContId, e.what());
+  }
+
+  multi = qclient::MultiBuilder();
+  return ok;
+}
+
+//------------------------------------------------------------------------------
+// Read what a container holds directly
+//------------------------------------------------------------------------------
+QuotaRecomputeJob::Entry
+QuotaRecomputeJob::readContainer(IContainerMD::id_t id)
+{
+  Entry entry;
+  auto file_map = MetadataFetcher::getFileMap(*mQcl, ContainerIdentifier(id));
+  auto cont_map = MetadataFetcher::getContainerMap(*mQcl,
+                  ContainerIdentifier(id));
+  std::vector<folly::Future<eos::ns::FileMdProto>> files;
+  std::vector<folly::Future<eos::ns::ContainerMdProto>> conts;
+
+  for (const auto& elem : std::move(file_map).get()) {
+    files.emplace_back(MetadataFetcher::getFileFromId(*mQcl,
+                       FileIdentifier(elem.second)));
+  }
+
+  for (const auto& elem : std::move(cont_map).get()) {
+    conts.emplace_back(MetadataFetcher::getContainerFromId(*mQcl,
+                       ContainerIdentifier(elem.second)));
+  }
+
+  for (auto& fut : files) {
+    try {
+      eos::ns::FileMdProto proto = std::move(fut).get();
+      QuotaNodeCore::UsageInfo& info = entry.mUsage[ {proto.uid(), proto.gid()}];
+      info.space += proto.size();
+      info.physicalSpace += proto.size() *
+                            eos::common::LayoutId::GetSizeFactor(proto.layout_id());
+      ++info.files;
+    } catch (const MDException& e) {
+      // File removed meanwhile, the container is dirty
+    }
+  }
+
+  for (auto& fut : conts) {
+    try {
+      eos::ns::ContainerMdProto proto = std::move(fut).get();
+
+      // Sub-quota nodes are accounted on their own
+      if ((proto.flags() & eos::QUOTA_NODE_FLAG) == 0) {
+        entry.mChildren.push_back(proto.id());
+      }
+    } catch (const MDException& e) {
+      // Container removed meanwhile, the container is dirty
+    }
+  }
+
+  std::sort(entry.mChildren.begin(), entry.mChildren.end());
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Record that a container changed
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::markDirty(IContainerMD::id_t id)
+{
+  std::lock_guard<std::mutex> lock(mDirtyMutex);
+  return mDirty.insert(id).second;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of dirty containers
+//------------------------------------------------------------------------------
+size_t
+QuotaRecomputeJob::getNumDirty() const
+{
+  std::lock_guard<std::mutex> lock(mDirtyMutex);
+  return mDirty.size();
+}
+
+//------------------------------------------------------------------------------
+// Check if a container is marked dirty
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::isDirty(IContainerMD::id_t id) const
+{
+  std::lock_guard<std::mutex> lock(mDirtyMutex);
+  return (mDirty.count(id) != 0);
+}
+
+//------------------------------------------------------------------------------
+// Take the current set of dirty containers
+//------------------------------------------------------------------------------
+std::unordered_set<IContainerMD::id_t>
+QuotaRecomputeJob::takeDirty()
+{
+  std::unordered_set<IContainerMD::id_t> dirty;
+  std::lock_guard<std::mutex> lock(mDirtyMutex);
+  dirty.swap(mDirty);
+  return dirty;
+}
+
+//------------------------------------------------------------------------------
+// Get the checkpoint entry of a container
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::getEntry(IContainerMD::id_t id, Entry& entry)
+{
+  qclient::redisReplyPtr reply = mQcl->exec("HGET", KeyEntries(mContId),
+                                 std::to_string(id)).get();
+
+  if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+    return false;
+  }
+
+  return entry.deserialize(std::string(reply->str, reply->len));
+}
+
+//------------------------------------------------------------------------------
+// Check if a container is accounted by the quota node
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::isInside(IContainerMD::id_t id)
+{
+  IContainerMD::id_t current = id;
+
+  for (size_t depth = 0; depth < cMaxDepth; ++depth) {
+    if (current == mContId) {
+      return true;
+    }
+
+    eos::ns::ContainerMdProto proto;
+
+    try {
+      proto = MetadataFetcher::getContainerFromId(*mQcl,
+              ContainerIdentifier(current)).get();
+    } catch (const MDException& e) {
+      return false;
+    }
+
+    if ((proto.flags() & eos::QUOTA_NODE_FLAG) ||
+        (proto.parent_id() == current) || (proto.parent_id() == 0)) {
+      return false;
+    }
+
+    current = proto.parent_id();
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Drop a container and everything below it
+//------------------------------------------------------------------------------
+void
+QuotaRecomputeJob::dropSubtree(IContainerMD::id_t id, const Entry& entry,
+                               qclient::MultiBuilder& multi)
+{
+  std::deque<std::pair<IContainerMD::id_t, Entry>> todo;
+  todo.emplace_back(id, entry);
+
+  while (!todo.empty()) {
+    auto& item = todo.front();
+    const std::string sid = std::to_string(item.first);
+    multi.emplace_back("HDEL", KeyEntries(mContId), sid);
+    multi.emplace_back("SREM", KeyPending(mContId), sid);
+
+    for (auto child : item.second.mChildren) {
+      Entry child_entry;
+
+      if (getEntry(child, child_entry)) {
+        todo.emplace_back(child, std::move(child_entry));
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    applyUsage(item.second.mUsage, false);
+
+    if (mContainers) {
+      --mContainers;
+    }
+
+    todo.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Re-read dirty containers
+//------------------------------------------------------------------------------
+MDStatus
+QuotaRecomputeJob::reconcile(const std::unordered_set<IContainerMD::id_t>&
+                             ids)
+{
+  std::vector<IContainerMD::id_t> batch;
+  batch.reserve(cReconcileBatch);
+  auto it = ids.begin();
+
+  try {
+    while (it != ids.end()) {
+      batch.clear();
+
+      for (; (it != ids.end()) && (batch.size() < cReconcileBatch); ++it) {
+        batch.push_back(*it);
+      }
+
+      // Only containers with an entry were visited, the others are either
+      // still pending or not below the quota node
+      std::vector<folly::Future<qclient::redisReplyPtr>> replies;
+      replies.reserve(batch.size());
+
+      for (auto id : batch) {
+        replies.emplace_back(mQcl->follyExec("HGET", KeyEntries(mContId),
+                                             std::to_string(id)));
+      }
+
+      for (size_t i = 0; i < batch.size(); ++i) {
+        qclient::redisReplyPtr reply = std::move(replies[i]).get();
+
+        if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+          continue;
+        }
+
+        const IContainerMD::id_t id = batch[i];
+        Entry old_entry, new_entry;
+
+        if (!old_entry.deserialize(std::string(reply->str, reply->len))) {
+          return MDStatus(EIO, SSTR("error: corrupted checkpoint entry of "
+                                    "container " << id));
+        }
+
+        qclient::MultiBuilder multi;
+        bool exists = true;
+
+        try {
+          eos::ns::ContainerMdProto proto =
+            MetadataFetcher::getContainerFromId(*mQcl, ContainerIdentifier(id)).get();
+          exists = (id == mContId) || !(proto.flags() & eos::QUOTA_NODE_FLAG);
+        } catch (const MDException& e) {
+          exists = false;
+        }
+
+        if (!exists) {
+          dropSubtree(id, old_entry, multi);
+        } else {
+          new_entry = readContainer(id);
+          multi.emplace_back("HSET", KeyEntries(mContId), std::to_string(id),
+                             new_entry.serialize());
+          // Children are sorted, find the ones added and removed
+          std::vector<IContainerMD::id_t> added, removed;
+          std::set_difference(new_entry.mChildren.begin(),
+                              new_entry.mChildren.end(),
+                              old_entry.mChildren.begin(),
+                              old_entry.mChildren.end(),
+                              std::back_inserter(added));
+          std::set_difference(old_entry.mChildren.begin(),
+                              old_entry.mChildren.end(),
+                              new_entry.mChildren.begin(),
+                              new_entry.mChildren.end(),
+                              std::back_inserter(removed));
+          Entry child_entry;
+
+          // New subcontainers not moved from elsewhere below the quota node
+          for (auto it_add = added.begin(); it_add != added.end();) {
+            if (getEntry(*it_add, child_entry)) {
+              it_add = added.erase(it_add);
+            } else {
+              multi.emplace_back("SADD", KeyPending(mContId),
+                                 std::to_string(*it_add));
+              ++it_add;
+            }
+          }
+
+          // Subcontainers removed or moved out of the quota node
+          for (auto child : removed) {
+            if (getEntry(child, child_entry) && !isInside(child)) {
+              dropSubtree(child, child_entry, multi);
+            }
+          }
+
+          std::lock_guard<std::mutex> lock(mMutex);
+          applyUsage(old_entry.mUsage, false);
+          applyUsage(new_entry.mUsage, true);
+          mFrontier.insert(mFrontier.end(), added.begin(), added.end());
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          ++mReconciled;
+        }
+
+        if (!writeCheckpoint(multi)) {
+          return MDStatus(EIO, "error: failed to store checkpoint");
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    return MDStatus(EIO, SSTR("error: failed to reconcile: " << e.what()));
+  }
+
+  return MDStatus();
+}
+
+//------------------------------------------------------------------------------
+// Check if containers are still to be visited
+//------------------------------------------------------------------------------
+bool
+QuotaRecomputeJob::hasPending() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return !mFrontier.empty();
+}
+
+//------------------------------------------------------------------------------
+// Add or subtract usage
+//------------------------------------------------------------------------------
+void
+QuotaRecomputeJob::applyUsage(const Usage& usage, bool add)
+{
+  for (const auto& elem : usage) {
+    QuotaNodeCore::UsageInfo& info = mTotal[elem.first];
+
+    if (add) {
+      info += elem.second;
+      mFiles += elem.second.files;
+    } else {
+      info.space -= elem.second.space;
+      info.physicalSpace -= elem.second.physicalSpace;
+      info.files -= elem.second.files;
+      mFiles -= elem.second.files;
+
+      if (info.files == 0) {
+        mTotal.erase(elem.first);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the usage accounted so far
+//------------------------------------------------------------------------------
+void
+QuotaRecomputeJob::getCore(QuotaNodeCore& core) const
+{
+  std::map<uint64_t, QuotaNodeCore::UsageInfo> by_uid, by_gid;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (const auto& elem : mTotal) {
+      by_uid[elem.first.first] += elem.second;
+      by_gid[elem.first.second] += elem.second;
+    }
+  }
+  core = {};
+
+  for (const auto& elem : by_uid) {
+    core.setByUid(elem.first, elem.second);
+  }
+
+  for (const auto& elem : by_gid) {
+    core.setByGid(elem.first, elem.second);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the progress of the job
+//------------------------------------------------------------------------------
+QuotaRecomputeJob::Progress
+QuotaRecomputeJob::getProgress() const
+{
+  Progress progress;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    progress.mContainers = mContainers;
+    progress.mFiles = mFiles;
+    progress.mPending = mFrontier.size() + mInFlight;
+    progress.mReconciled = mReconciled;
+    progress.mElapsed = std::chrono::duration_cast<std::chrono::seconds>
+                        (std::chrono::steady_clock::now() - mStart).count();
+    progress.mRate = progress.mElapsed ?
+                     (double) mWalked / progress.mElapsed : mWalked;
+    progress.mFileRate = progress.mElapsed ?
+                         (double) mWalkedFiles / progress.mElapsed : mWalkedFiles;
+  }
+  progress.mDirty = getNumDirty();
+  return progress;
+}
+
+//------------------------------------------------------------------------------
+// Delete the checkpoint
+//------------------------------------------------------------------------------
+void
+QuotaRecomputeJob::clear()
+{
+  try {
+    mQcl->exec("DEL", KeyEntries(mContId), KeyPending(mContId),
+               KeyDirty(mContId)).get();
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to delete quota recomputation checkpoint\" "
+                   "cxid=%08llx emsg=\"%s\"", mContId, e.what());
+  }
+}
+
+EOSNSNAMESPACE_END
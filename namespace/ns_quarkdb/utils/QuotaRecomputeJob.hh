@@ -0,0 +1,249 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Incremental, checkpointed recomputation of a quota node
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/ns_quarkdb/accounting/QuotaNodeCore.hh"
+#include "namespace/Namespace.hh"
+#include "namespace/MDException.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+class MultiBuilder;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Recomputation of a quota node which does not need a quiet namespace.
+//!
+//! The subtree is walked in parallel, one container at a time. What each
+//! container holds directly (usage of its files and its subcontainers which
+//! are not quota nodes) is stored in QuarkDB together with the containers
+//! still to visit, so an interrupted job resumes where it stopped.
+//!
+//! The namespace keeps changing while the job runs. Every container changed
+//! after the job started has to be reported with markDirty. reconcile
+//! re-reads such containers and replaces what was recorded for them, a
+//! container which was not visited yet is simply read later by the walk.
+//! Once no dirty container is left, getCore returns the exact usage.
+//------------------------------------------------------------------------------
+class QuotaRecomputeJob
+{
+public:
+  //! Usage per (uid, gid) pair
+  typedef std::map<std::pair<uint64_t, uint64_t>, QuotaNodeCore::UsageInfo>
+  Usage;
+
+  //----------------------------------------------------------------------------
+  //! What a container holds directly
+  //----------------------------------------------------------------------------
+  struct Entry {
+    std::vector<IContainerMD::id_t> mChildren; ///< Subcontainers to account
+    Usage mUsage; ///< Usage of the files
+
+    //--------------------------------------------------------------------------
+    //! Serialize as "<child>,...|<uid>:<gid>:<files>:<space>:<physical>,..."
+    //--------------------------------------------------------------------------
+    std::string serialize() const;
+
+    //--------------------------------------------------------------------------
+    //! Parse the output of serialize
+    //!
+    //! @return true if successful, otherwise false
+    //--------------------------------------------------------------------------
+    bool deserialize(const std::string& data);
+  };
+
+  //! Progress of the job
+  struct Progress {
+    uint64_t mContainers = 0; ///< Containers visited
+    uint64_t mFiles = 0; ///< Files accounted
+    uint64_t mPending = 0; ///< Containers known but not visited yet
+    uint64_t mDirty = 0; ///< Containers to re-read
+    uint64_t mReconciled = 0; ///< Containers re-read
+    uint64_t mElapsed = 0; ///< Walk time in seconds, since started or resumed
+    double mRate = 0; ///< Containers per second, since started or resumed
+    double mFileRate = 0; ///< Files per second, since started or resumed
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl QuarkDB client
+  //! @param cont_id quota node container id
+  //----------------------------------------------------------------------------
+  QuotaRecomputeJob(qclient::QClient* qcl, IContainerMD::id_t cont_id);
+
+  //----------------------------------------------------------------------------
+  //! Get the QuarkDB keys of the checkpoint of a quota node
+  //----------------------------------------------------------------------------
+  static std::string KeyEntries(IContainerMD::id_t cont_id);
+  static std::string KeyPending(IContainerMD::id_t cont_id);
+  static std::string KeyDirty(IContainerMD::id_t cont_id);
+
+  //----------------------------------------------------------------------------
+  //! Resume from the checkpoint in QuarkDB or, if there is none, start a new
+  //! walk from the quota node
+  //----------------------------------------------------------------------------
+  MDStatus load();
+
+  //----------------------------------------------------------------------------
+  //! Visit all pending containers
+  //!
+  //! @param threads number of parallel workers
+  //! @param stopped returns true if the walk has to be interrupted, called
+  //!        with the walk state locked
+  //! @param max_containers if not 0, interrupt the walk after visiting this
+  //!        many containers
+  //!
+  //! @return status, EINTR if interrupted
+  //----------------------------------------------------------------------------
+  MDStatus walk(size_t threads, std::function<bool()> stopped,
+                uint64_t max_containers = 0);
+
+  //----------------------------------------------------------------------------
+  //! Record that a container changed, thread safe and cheap
+  //!
+  //! @return true if the container was not dirty before
+  //----------------------------------------------------------------------------
+  bool markDirty(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of dirty containers
+  //----------------------------------------------------------------------------
+  size_t getNumDirty() const;
+
+  //----------------------------------------------------------------------------
+  //! Check if a container is marked dirty
+  //----------------------------------------------------------------------------
+  bool isDirty(IContainerMD::id_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Take the current set of dirty containers
+  //----------------------------------------------------------------------------
+  std::unordered_set<IContainerMD::id_t> takeDirty();
+
+  //----------------------------------------------------------------------------
+  //! Re-read dirty containers. The changes must be visible in QuarkDB i.e.
+  //! the metadata flusher synchronized after taking them. New subcontainers
+  //! become pending and need another walk, removed or moved out ones are
+  //! dropped together with everything below them.
+  //!
+  //! @param ids dirty containers
+  //!
+  //! @return status
+  //----------------------------------------------------------------------------
+  MDStatus reconcile(const std::unordered_set<IContainerMD::id_t>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Check if containers are still to be visited
+  //----------------------------------------------------------------------------
+  bool hasPending() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the usage accounted so far
+  //----------------------------------------------------------------------------
+  void getCore(QuotaNodeCore& core) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the progress of the job
+  //----------------------------------------------------------------------------
+  Progress getProgress() const;
+
+  //----------------------------------------------------------------------------
+  //! Delete the checkpoint from QuarkDB
+  //----------------------------------------------------------------------------
+  void clear();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Read what a container holds directly from QuarkDB
+  //----------------------------------------------------------------------------
+  Entry readContainer(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Check if a container is below the quota node, without being or being
+  //! below another quota node
+  //----------------------------------------------------------------------------
+  bool isInside(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Drop a container and everything below it
+  //----------------------------------------------------------------------------
+  void dropSubtree(IContainerMD::id_t id, const Entry& entry,
+                   qclient::MultiBuilder& multi);
+
+  //----------------------------------------------------------------------------
+  //! Get the checkpoint entry of a container
+  //!
+  //! @return false if the container has no entry, otherwise true
+  //----------------------------------------------------------------------------
+  bool getEntry(IContainerMD::id_t id, Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Write a batch of checkpoint commands as one transaction
+  //----------------------------------------------------------------------------
+  bool writeCheckpoint(qclient::MultiBuilder& multi);
+
+  //----------------------------------------------------------------------------
+  //! Walk worker loop
+  //----------------------------------------------------------------------------
+  void walkWorker(const std::function<bool()>& stopped);
+
+  //----------------------------------------------------------------------------
+  //! Add or subtract usage, needs mMutex
+  //----------------------------------------------------------------------------
+  void applyUsage(const Usage& usage, bool add);
+
+  qclient::QClient* mQcl; ///< QuarkDB client
+  const IContainerMD::id_t mContId; ///< Quota node container id
+  mutable std::mutex mMutex; ///< Protects the walk state below
+  std::condition_variable mCond; ///< Signals frontier changes
+  std::deque<IContainerMD::id_t> mFrontier; ///< Containers to visit
+  size_t mInFlight {0}; ///< Containers being visited
+  Usage mTotal; ///< Usage accounted so far
+  uint64_t mContainers {0}; ///< Containers visited
+  uint64_t mWalkLimit {0}; ///< Stop the walk at this many visited, 0 if none
+  uint64_t mFiles {0}; ///< Files accounted
+  uint64_t mReconciled {0}; ///< Containers re-read
+  uint64_t mWalked {0}; ///< Containers visited since started or resumed
+  uint64_t mWalkedFiles {0}; ///< Files accounted since started or resumed
+  MDStatus mStatus; ///< First walk error
+  std::chrono::steady_clock::time_point mStart; ///< Start or resume time
+  mutable std::mutex mDirtyMutex; ///< Protects mDirty
+  std::unordered_set<IContainerMD::id_t> mDirty; ///< Changed containers
+};
+
+EOSNSNAMESPACE_END
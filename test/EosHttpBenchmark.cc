@@ -0,0 +1,322 @@
+//------------------------------------------------------------------------------
+// File: EosHttpBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Measure the requests/s and the latency percentiles of HTTP keep-alive
+// clients against the event-driven HTTP server, or against any server given
+// as host:port e.g. an FST or MGM running a libmicrohttpd thread model.
+// Every connection sends one GET at a time and sends the next one as soon
+// as the response is complete.
+//------------------------------------------------------------------------------
+
+#include "common/http/HttpEventServer.hh"
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------
+// Client side of one connection
+//------------------------------------------------------------------------------
+struct Client {
+  int mFd = -1;
+  std::string mIn;
+  Clock::time_point mSent;
+};
+
+//------------------------------------------------------------------------------
+// Connect to the server
+//------------------------------------------------------------------------------
+int Connect(const struct addrinfo* ai)
+{
+  int fd = socket(ai->ai_family, SOCK_STREAM, 0);
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (connect(fd, ai->ai_addr, ai->ai_addrlen)) {
+    close(fd);
+    return -1;
+  }
+
+  int on = 1;
+  (void) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+// Check if the buffer starts with a complete response, return its length
+//------------------------------------------------------------------------------
+size_t ResponseLength(const std::string& in)
+{
+  size_t end = in.find("\r\n\r\n");
+
+  if (end == std::string::npos) {
+    return 0;
+  }
+
+  size_t length = 0;
+  size_t pos = in.find("Content-Length: ");
+
+  if ((pos == std::string::npos) || (pos > end)) {
+    pos = in.find("content-length: ");
+  }
+
+  if ((pos != std::string::npos) && (pos < end)) {
+    length = strtoull(in.c_str() + pos + 16, nullptr, 10);
+  }
+
+  return (in.size() >= end + 4 + length) ? (end + 4 + length) : 0;
+}
+
+//------------------------------------------------------------------------------
+// Run the clients of one thread until the deadline
+//------------------------------------------------------------------------------
+void RunClients(std::vector<Client>& clients, const std::string& request,
+                Clock::time_point deadline, std::vector<uint32_t>& latencies,
+                std::atomic<uint64_t>& errors)
+{
+  int epfd = epoll_create1(0);
+
+  for (size_t i = 0; i < clients.size(); ++i) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = i;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i].mFd, &ev);
+    clients[i].mSent = Clock::now();
+
+    if (write(clients[i].mFd, request.c_str(), request.size()) !=
+        (ssize_t) request.size()) {
+      ++errors;
+    }
+  }
+
+  struct epoll_event events[512];
+  char buf[64 * 1024];
+
+  while (Clock::now() < deadline) {
+    int n = epoll_wait(epfd, events, 512, 100);
+
+    for (int i = 0; i < n; ++i) {
+      Client& client = clients[events[i].data.u64];
+      ssize_t nread = read(client.mFd, buf, sizeof(buf));
+
+      if (nread <= 0) {
+        ++errors;
+        epoll_ctl(epfd, EPOLL_CTL_DEL, client.mFd, nullptr);
+        continue;
+      }
+
+      client.mIn.append(buf, nread);
+      size_t length = ResponseLength(client.mIn);
+
+      if (!length) {
+        continue;
+      }
+
+      Clock::time_point now = Clock::now();
+      latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>
+                          (now - client.mSent).count());
+
+      if (client.mIn.compare(9, 3, "200")) {
+        ++errors;
+      }
+
+      client.mIn.erase(0, length);
+      client.mSent = now;
+
+      if (write(client.mFd, request.c_str(), request.size()) !=
+          (ssize_t) request.size()) {
+        ++errors;
+      }
+    }
+  }
+
+  close(epfd);
+}
+
+int main(int argc, const char* argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <num-connections> [duration-s]"
+              << " [client-threads] [server-workers] [server-reactors]"
+              << " [body-size] [host:port]" << std::endl
+              << "       Without host:port an embedded event server is"
+              << " benchmarked" << std::endl;
+    return 1;
+  }
+
+  size_t nconn = std::stoul(argv[1]);
+  int duration = (argc > 2) ? std::stoi(argv[2]) : 10;
+  size_t nthreads = (argc > 3) ? std::stoul(argv[3]) : 4;
+  unsigned int nworkers = (argc > 4) ? std::stoul(argv[4]) : 16;
+  unsigned int nreactors = (argc > 5) ? std::stoul(argv[5]) : 4;
+  size_t body_size = (argc > 6) ? std::stoul(argv[6]) : 128;
+  std::string host = "localhost";
+  std::string port;
+  // Each connection needs two descriptors when the server is embedded
+  struct rlimit rl;
+
+  if (!getrlimit(RLIMIT_NOFILE, &rl)) {
+    rl.rlim_cur = rl.rlim_max;
+    (void) setrlimit(RLIMIT_NOFILE, &rl);
+
+    if (rl.rlim_cur < 2 * nconn + 64) {
+      std::cerr << "warning: open file limit " << rl.rlim_cur
+                << " is too low for " << nconn << " connections" << std::endl;
+    }
+  }
+
+  std::unique_ptr<eos::common::HttpEventServer> server;
+
+  if (argc > 7) {
+    std::string endpoint = argv[7];
+    size_t pos = endpoint.rfind(':');
+
+    if (pos == std::string::npos) {
+      std::cerr << "error: endpoint has to be host:port" << std::endl;
+      return 1;
+    }
+
+    host = endpoint.substr(0, pos);
+    port = endpoint.substr(pos + 1);
+  } else {
+    eos::common::HttpEventServer::Options options;
+    options.mPort = 0;
+    options.mWorkers = nworkers;
+    options.mReactors = nreactors;
+    options.mMaxConnections = nconn + 1024;
+    const std::string body(body_size, 'x');
+    server.reset(new eos::common::HttpEventServer(options,
+    [&body](eos::common::HttpExchange & exchange) {
+      exchange.SendResponse(200, {{"Content-Type", "text/plain"}}, body);
+    }));
+
+    if (!server->Start()) {
+      std::cerr << "error: failed to start the http server" << std::endl;
+      return 1;
+    }
+
+    port = std::to_string(server->GetPort());
+  }
+
+  struct addrinfo hints;
+  struct addrinfo* ai = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &ai) || !ai) {
+    std::cerr << "error: failed to resolve " << host << std::endl;
+    return 1;
+  }
+
+  // Open all connections before measuring
+  nthreads = std::max((size_t) 1, std::min(nthreads, nconn));
+  std::vector<std::vector<Client>> clients(nthreads);
+
+  for (size_t i = 0; i < nconn; ++i) {
+    Client client;
+    client.mFd = Connect(ai);
+
+    if (client.mFd < 0) {
+      std::cerr << "error: failed to open connection " << i << ": "
+                << strerror(errno) << std::endl;
+      return 1;
+    }
+
+    clients[i % nthreads].push_back(std::move(client));
+  }
+
+  freeaddrinfo(ai);
+  std::string request = "GET /bench HTTP/1.1\r\nHost: " + host + "\r\n\r\n";
+  std::vector<std::vector<uint32_t>> latencies(nthreads);
+  std::vector<std::thread> threads;
+  std::atomic<uint64_t> errors {0};
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline = start + std::chrono::seconds(duration);
+
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back(RunClients, std::ref(clients[i]), std::cref(request),
+                         deadline, std::ref(latencies[i]), std::ref(errors));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+                   (Clock::now() - start).count() / 1000.0;
+  std::vector<uint32_t> all;
+
+  for (auto& lat : latencies) {
+    all.insert(all.end(), lat.begin(), lat.end());
+  }
+
+  std::sort(all.begin(), all.end());
+
+  for (auto& thread_clients : clients) {
+    for (auto& client : thread_clients) {
+      close(client.mFd);
+    }
+  }
+
+  auto percentile = [&all](double p) -> double {
+    if (all.empty())
+    {
+      return 0.0;
+    }
+
+    return all[std::min(all.size() - 1, (size_t)(p * all.size()))] / 1000.0;
+  };
+
+  std::cout << "connections=" << nconn
+            << " duration=" << elapsed << "s"
+            << " requests=" << all.size()
+            << " errors=" << errors
+            << " rate=" << (uint64_t)(all.size() / elapsed) << " req/s"
+            << std::endl
+            << "latency p50=" << percentile(0.50) << "ms"
+            << " p90=" << percentile(0.90) << "ms"
+            << " p99=" << percentile(0.99) << "ms"
+            << " p99.9=" << percentile(0.999) << "ms"
+            << " max=" << (all.empty() ? 0.0 : all.back() / 1000.0) << "ms"
+            << std::endl;
+
+  if (server) {
+    server->Stop();
+  }
+
+  return 0;
+}
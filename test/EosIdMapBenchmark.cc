@@ -24,8 +24,35 @@
 #include "common/Mapping.hh"
 #include "common/Logging.hh"
 #include "XrdSec/XrdSecEntity.hh"
+#include <atomic>
 #include <chrono>
 
+//------------------------------------------------------------------------------
+// Number of calls to the simulated NSS backend
+//------------------------------------------------------------------------------
+std::atomic<uint64_t> g_nss_calls {0};
+
+//------------------------------------------------------------------------------
+// Simulate a slow NSS backend (e.g. LDAP) which knows all the testuser<i>
+// accounts and answers each lookup after the given delay
+//------------------------------------------------------------------------------
+void SimulateSlowNss(int delay_ms)
+{
+  using eos::common::Mapping;
+  Mapping::gPasswdByNameCache.SetResolver([delay_ms](const std::string & name)
+  -> std::optional<Mapping::pw_entry> {
+    ++g_nss_calls;
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+
+    if (name.find("testuser") != 0) {
+      return std::nullopt;
+    }
+
+    uid_t uid = 10000 + atoi(name.c_str() + 8);
+    return Mapping::pw_entry{uid, uid, name};
+  });
+}
+
 void IdMapClient(int n, int cache_factor=1){
   auto vid = eos::common::VirtualIdentity::Nobody();
   XrdSecEntity client("sss");
@@ -47,7 +74,8 @@ void IdMapClient(int n, int cache_factor=1){
 
 int main(int argc, const char* argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <num-entries> [num-threads] [cache_factor]" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <num-entries> [num-threads] [cache_factor]"
+              << " [nss-delay-ms]" << std::endl;
     return 1;
   }
   std::chrono::steady_clock::time_point init = std::chrono::steady_clock::now();
@@ -58,8 +86,11 @@ int main(int argc, const char* argv[]) {
   int n_clients = 1;
   int num_threads = 50;
   int cache_factor = 1;
+  int nss_delay_ms = 0;
 
   switch (argc) {
+  case 5:
+    nss_delay_ms = atoi(argv[4]);
   case 4:
     cache_factor = atoi(argv[3]);
   case 3:
@@ -68,6 +99,10 @@ int main(int argc, const char* argv[]) {
     n_clients = atoi(argv[1]);
   }
 
+  if (nss_delay_ms > 0) {
+    SimulateSlowNss(nss_delay_ms);
+  }
+
   /*
   auto& g_logger = eos::common::Logging::GetInstance();
   g_logger.SetLogPriority(LOG_INFO);
@@ -93,6 +128,15 @@ int main(int argc, const char* argv[]) {
             << (n_clients*num_threads)/ms_elapsed << " [kHz]"
             << "\n";
 
+  if (nss_delay_ms > 0) {
+    auto stats = eos::common::Mapping::gPasswdByNameCache.GetStats();
+    std::cout << "NSS delay = " << nss_delay_ms << " ms"
+              << " nss_calls=" << g_nss_calls
+              << " hits=" << stats.mHits
+              << " misses=" << stats.mMisses
+              << " timeouts=" << stats.mTimeouts << "\n";
+  }
+
   eos::common::Mapping::Reset();
   std::chrono::steady_clock::time_point reset = std::chrono::steady_clock::now();
   auto reset_time = std::chrono::duration_cast<std::chrono::milliseconds>(reset - end).count();
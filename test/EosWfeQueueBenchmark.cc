@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------
+//! @file EosWfeQueueBenchmark.cc
+//! @brief throughput benchmark of the QuarkDB workflow job queue
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+// Enqueues jobs from several threads like the MGM does when workflow events
+// fire, then runs them through the queue the way the WFE dispatcher does:
+// one thread dequeues batches and leases the jobs, worker threads mark them
+// done. Prints the rate of each phase in jobs/s. The benchmark uses its own
+// set of keys in the given QuarkDB instance and removes them at the end.
+//
+// usage: eos-wfe-queue-benchmark <host:port> [jobs=100000] [threads=8] [batch=1000] [password-file]
+
+#include "mgm/WFEQueue.hh"
+#include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "common/PasswordHandler.hh"
+#include <qclient/QClient.hh>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using eos::mgm::WFEQueue;
+
+static double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <host:port> [jobs=100000] [threads=8] [batch=1000] [password-file]\n",
+            argv[0]);
+    exit(EINVAL);
+  }
+
+  eos::QdbContactDetails cd;
+  size_t jobs = (argc > 2) ? strtoul(argv[2], 0, 10) : 100000;
+  size_t threads = (argc > 3) ? strtoul(argv[3], 0, 10) : 8;
+  size_t batch = (argc > 4) ? strtoul(argv[4], 0, 10) : WFEQueue::cBatchSize;
+
+  if (!cd.members.parse(argv[1]) || !jobs || !threads || !batch) {
+    fprintf(stderr, "error: invalid arguments\n");
+    exit(EINVAL);
+  }
+
+  if ((argc > 5) &&
+      !eos::common::PasswordHandler::readPasswordFile(argv[5], cd.password)) {
+    fprintf(stderr, "error: failed to read password file %s\n", argv[5]);
+    exit(EINVAL);
+  }
+
+  qclient::QClient qcl(cd.members, cd.constructOptions());
+  WFEQueue queue(qcl, "eos-wfe-benchmark-" + std::to_string(getpid()));
+  WFEQueue::Record record {
+    {"action", "bash:shell:benchmark true"},
+    {"event", "closew"},
+    {"workflow", "default"},
+    {"fxid", "00000001"},
+    {"vid", "uid:0,gid:0"},
+    {"retry", "0"},
+    {"errmsg", ""}
+  };
+  std::atomic<uint64_t> errors {0};
+  // enqueue phase: every job is stored with its own transaction
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (size_t i = t; i < jobs; i += threads) {
+        std::string id;
+
+        if (!queue.Store(id, record, "q", time(nullptr))) {
+          errors++;
+        }
+      }
+    });
+  }
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  workers.clear();
+  double enqueue_time = seconds_since(start);
+  // run phase: batched dequeue with leases, workers finish the jobs
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<WFEQueue::Entry> pending;
+  bool drained = false;
+  std::atomic<uint64_t> done {0};
+  uint64_t batches = 0;
+  start = std::chrono::steady_clock::now();
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&]() {
+      while (true) {
+        WFEQueue::Entry entry;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          cv.wait(lock, [&]() {
+            return drained || !pending.empty();
+          });
+
+          if (pending.empty()) {
+            return;
+          }
+
+          entry = std::move(pending.front());
+          pending.pop_front();
+        }
+
+        if (queue.Store(entry.mId, entry.mRecord, "d", time(nullptr))) {
+          done++;
+        } else {
+          errors++;
+        }
+      }
+    });
+  }
+
+  while (true) {
+    std::vector<WFEQueue::Entry> entries = queue.Dequeue(batch, time(nullptr),
+                                           3600);
+
+    if (entries.empty()) {
+      break;
+    }
+
+    batches++;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+
+      for (auto& entry : entries) {
+        pending.push_back(std::move(entry));
+      }
+    }
+    cv.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    drained = true;
+  }
+  cv.notify_all();
+
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  double run_time = seconds_since(start);
+  WFEQueue::Stats stats = queue.GetStats();
+  start = std::chrono::steady_clock::now();
+  size_t expired = queue.Expire(time(nullptr) + 1, 0);
+  double expire_time = seconds_since(start);
+  fprintf(stdout, "# jobs=%lu threads=%lu batch=%lu\n", jobs, threads, batch);
+  fprintf(stdout, "# %10s %10s %12s\n", "phase", "jobs", "rate[jobs/s]");
+  fprintf(stdout, "  %10s %10lu %12.01f\n", "enqueue", jobs,
+          jobs / enqueue_time);
+  fprintf(stdout, "  %10s %10lu %12.01f\n", "run", done.load(),
+          done.load() / run_time);
+  fprintf(stdout, "  %10s %10lu %12.01f\n", "expire", expired,
+          expired / expire_time);
+  fprintf(stdout, "# batches=%lu leased-left=%lu ready-left=%lu errors=%lu\n",
+          batches, stats.mLeased, stats.mReady, errors.load());
+  queue.Clear();
+  return (errors || (done != jobs)) ? EIO : 0;
+}
@@ -0,0 +1,161 @@
+// ----------------------------------------------------------------------
+// File: BM_AdmissionControl.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Load generator for the MGM admission control: an abusive client floods a
+// simulated MGM with a fixed number of worker slots while a polite client
+// issues requests at a low rate. The benchmark reports the latency
+// percentiles seen by the polite client with and without admission control.
+// Rejected abusive requests back off for the stall hint scaled down from
+// seconds to milliseconds.
+//------------------------------------------------------------------------------
+
+#include "benchmark/benchmark.h"
+#include "mgm/AdmissionControl.hh"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Simulated server with a fixed number of worker slots
+//------------------------------------------------------------------------------
+class SimulatedServer
+{
+public:
+  SimulatedServer(int slots, microseconds service_time):
+    mFreeSlots(slots), mServiceTime(service_time)
+  {}
+
+  void Serve()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCv.wait(lock, [&]() {
+        return mFreeSlots > 0;
+      });
+      --mFreeSlots;
+    }
+
+    std::this_thread::sleep_for(mServiceTime);
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      ++mFreeSlots;
+    }
+
+    mCv.notify_one();
+  }
+
+private:
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  int mFreeSlots;
+  microseconds mServiceTime;
+};
+
+eos::mgm::AdmissionControl::Request MakeRequest(uid_t uid)
+{
+  eos::mgm::AdmissionControl::Request req;
+  req.mUid = uid;
+  req.mGid = uid;
+  return req;
+}
+}
+
+//------------------------------------------------------------------------------
+// Polite client latency under an abusive client. Arguments: admission control
+// enabled (0/1) and number of abusive client threads.
+//------------------------------------------------------------------------------
+static void BM_PoliteLatencyUnderAbuse(benchmark::State& state)
+{
+  const bool use_admission = state.range(0);
+  const int abusive_threads = state.range(1);
+  eos::mgm::AdmissionControl admission;
+  admission.Configure({
+    {"admission:queue:wait", "50"},
+    {"admission:user:*:*", "500"}
+  }, 1);
+  SimulatedServer server(8, microseconds(500));
+  std::atomic<bool> stop {false};
+  std::vector<std::thread> abusers;
+
+  for (int i = 0; i < abusive_threads; ++i) {
+    abusers.emplace_back([&]() {
+      while (!stop) {
+        if (use_admission) {
+          auto decision = admission.Admit(MakeRequest(1000));
+
+          if (!decision.mAdmitted) {
+            std::this_thread::sleep_for(milliseconds(decision.mStallSec));
+            continue;
+          }
+        }
+
+        server.Serve();
+      }
+    });
+  }
+
+  // Let the abusive client saturate the server
+  std::this_thread::sleep_for(milliseconds(100));
+  std::vector<double> latencies;
+
+  for (auto _ : state) {
+    auto start = steady_clock::now();
+
+    if (use_admission) {
+      benchmark::DoNotOptimize(admission.Admit(MakeRequest(2000)));
+    }
+
+    server.Serve();
+    latencies.push_back(duration_cast<microseconds>
+                        (steady_clock::now() - start).count());
+    std::this_thread::sleep_for(milliseconds(2));
+  }
+
+  stop = true;
+
+  for (auto& thread : abusers) {
+    thread.join();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies.empty() ? 0.0 :
+           latencies[std::min(latencies.size() - 1,
+                              (size_t)(p * latencies.size()))];
+  };
+  state.counters["p50_us"] = percentile(0.50);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["max_us"] = latencies.empty() ? 0.0 : latencies.back();
+}
+
+BENCHMARK(BM_PoliteLatencyUnderAbuse)
+->ArgsProduct({{0, 1}, {16, 64}})
+->Iterations(500)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_MAIN();
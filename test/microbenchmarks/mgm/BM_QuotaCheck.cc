@@ -0,0 +1,226 @@
+// ----------------------------------------------------------------------
+// File: BM_QuotaCheck.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Create throughput of the quota check done for every file creation. Each
+// iteration is one create: the quota check of SpaceQuota::CheckWriteQuota
+// (user, group and project bytes/files targets and usage) followed by the
+// accounting of the new file. Three modes are compared: quota disabled, the
+// previous scheme with the counters in a map under the space quota mutex and a
+// refresh from the quota node core on every check, and the lock-free
+// QuotaCounters updated from the namespace deltas.
+//------------------------------------------------------------------------------
+
+#include "benchmark/benchmark.h"
+#include "mgm/QuotaCounters.hh"
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+namespace
+{
+//! Subset of SpaceQuota::eQuotaTag used by the write quota check
+enum Tag {
+  kUserBytesIs = 1, kUserBytesTarget, kUserFilesIs, kUserFilesTarget,
+  kGroupBytesIs, kGroupBytesTarget, kGroupFilesIs, kGroupFilesTarget
+};
+
+const unsigned long kProjectId = 99;
+const int kNumIds = 1024;
+
+//------------------------------------------------------------------------------
+//! Usage core of a quota node, like QuotaNodeCore
+//------------------------------------------------------------------------------
+struct NodeCore {
+  mutable std::shared_timed_mutex mMutex;
+  std::map<unsigned long, std::pair<long long, long long>> mUser;
+  std::map<unsigned long, std::pair<long long, long long>> mGroup;
+
+  void Add(unsigned long uid, unsigned long gid, long long size)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mUser[uid].first += size;
+    mUser[uid].second += 1;
+    mGroup[gid].first += size;
+    mGroup[gid].second += 1;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Space quota counters as a map under a mutex, refreshed from the core on
+//! every check like the previous SpaceQuota::CheckWriteQuota
+//------------------------------------------------------------------------------
+class LockedQuota
+{
+public:
+  LockedQuota()
+  {
+    for (unsigned long id = 0; id < kNumIds; ++id) {
+      SetQuota(kUserBytesTarget, id, 1ll << 50);
+      SetQuota(kUserFilesTarget, id, 1ll << 40);
+      SetQuota(kGroupBytesTarget, id, 1ll << 50);
+      SetQuota(kGroupFilesTarget, id, 1ll << 40);
+      mCore.Add(id, id, 0);
+    }
+  }
+
+  bool CheckAndCreate(unsigned long uid, unsigned long gid, long long size)
+  {
+    Refresh(uid, gid);
+    bool has_quota = false;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      bool user = (GetQuota(kUserBytesTarget, uid) > 0) &&
+                  (GetQuota(kUserBytesIs, uid) + size <=
+                   GetQuota(kUserBytesTarget, uid)) &&
+                  (GetQuota(kUserFilesIs, uid) + 1 <=
+                   GetQuota(kUserFilesTarget, uid));
+      bool group = (GetQuota(kGroupBytesTarget, gid) > 0) &&
+                   (GetQuota(kGroupBytesIs, gid) + size <=
+                    GetQuota(kGroupBytesTarget, gid)) &&
+                   (GetQuota(kGroupFilesIs, gid) + 1 <=
+                    GetQuota(kGroupFilesTarget, gid));
+      bool project = (GetQuota(kGroupBytesTarget, kProjectId) > 0) &&
+                     (GetQuota(kGroupBytesIs, kProjectId) + size <=
+                      GetQuota(kGroupBytesTarget, kProjectId));
+      has_quota = user || group || project;
+    }
+
+    if (has_quota) {
+      mCore.Add(uid, gid, size);
+    }
+
+    return has_quota;
+  }
+
+private:
+  long long GetQuota(unsigned long tag, unsigned long id)
+  {
+    auto it = mMap.find((tag << 32) | id);
+    return (it == mMap.end() ? 0 : it->second);
+  }
+
+  void SetQuota(unsigned long tag, unsigned long id, long long value)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMap[(tag << 32) | id] = value;
+  }
+
+  void Refresh(unsigned long uid, unsigned long gid)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::shared_lock<std::shared_timed_mutex> core_lock(mCore.mMutex);
+    const auto& user = mCore.mUser[uid];
+    const auto& group = mCore.mGroup[gid];
+    mMap[((unsigned long) kUserBytesIs << 32) | uid] = user.first;
+    mMap[((unsigned long) kUserFilesIs << 32) | uid] = user.second;
+    mMap[((unsigned long) kGroupBytesIs << 32) | gid] = group.first;
+    mMap[((unsigned long) kGroupFilesIs << 32) | gid] = group.second;
+  }
+
+  std::mutex mMutex;
+  std::map<unsigned long, long long> mMap;
+  NodeCore mCore;
+};
+
+//------------------------------------------------------------------------------
+//! Space quota backed by the lock-free counters
+//------------------------------------------------------------------------------
+class LockFreeQuota
+{
+public:
+  LockFreeQuota()
+  {
+    for (unsigned long id = 0; id < kNumIds; ++id) {
+      mCounters.Set(kUserBytesTarget, id, 1ll << 50);
+      mCounters.Set(kUserFilesTarget, id, 1ll << 40);
+      mCounters.Set(kGroupBytesTarget, id, 1ll << 50);
+      mCounters.Set(kGroupFilesTarget, id, 1ll << 40);
+    }
+  }
+
+  bool CheckAndCreate(unsigned long uid, unsigned long gid, long long size)
+  {
+    bool user = (mCounters.Get(kUserBytesTarget, uid) > 0) &&
+                (mCounters.Get(kUserBytesIs, uid) + size <=
+                 mCounters.Get(kUserBytesTarget, uid)) &&
+                (mCounters.Get(kUserFilesIs, uid) + 1 <=
+                 mCounters.Get(kUserFilesTarget, uid));
+    bool group = (mCounters.Get(kGroupBytesTarget, gid) > 0) &&
+                 (mCounters.Get(kGroupBytesIs, gid) + size <=
+                  mCounters.Get(kGroupBytesTarget, gid)) &&
+                 (mCounters.Get(kGroupFilesIs, gid) + 1 <=
+                  mCounters.Get(kGroupFilesTarget, gid));
+    bool project = (mCounters.Get(kGroupBytesTarget, kProjectId) > 0) &&
+                   (mCounters.Get(kGroupBytesIs, kProjectId) + size <=
+                    mCounters.Get(kGroupBytesTarget, kProjectId));
+
+    if (user || group || project) {
+      // Delta delivered by the namespace usage listener
+      mCounters.Add(kUserBytesIs, uid, size);
+      mCounters.Add(kUserFilesIs, uid, 1);
+      mCounters.Add(kGroupBytesIs, gid, size);
+      mCounters.Add(kGroupFilesIs, gid, 1);
+      return true;
+    }
+
+    return false;
+  }
+
+private:
+  eos::mgm::QuotaCounters mCounters;
+};
+
+LockedQuota gLockedQuota;
+LockFreeQuota gLockFreeQuota;
+}
+
+//------------------------------------------------------------------------------
+// Creates per second. Argument: quota mode, 0 disabled, 1 locked map refreshed
+// from the quota node, 2 lock-free counters. Every thread creates files as
+// its own uid/gid, the second argument lets threads share a single id.
+//------------------------------------------------------------------------------
+static void BM_CreateQuotaCheck(benchmark::State& state)
+{
+  const int mode = state.range(0);
+  const bool shared_id = state.range(1);
+  const unsigned long id = (shared_id ? 0 : state.thread_index() % kNumIds);
+
+  for (auto _ : state) {
+    bool allowed = true;
+
+    if (mode == 1) {
+      allowed = gLockedQuota.CheckAndCreate(id, id, 4096);
+    } else if (mode == 2) {
+      allowed = gLockFreeQuota.CheckAndCreate(id, id, 4096);
+    }
+
+    benchmark::DoNotOptimize(allowed);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CreateQuotaCheck)
+->ArgsProduct({{0, 1, 2}, {0, 1}})
+->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+BENCHMARK_MAIN();
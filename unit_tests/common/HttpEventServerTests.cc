@@ -0,0 +1,599 @@
+//------------------------------------------------------------------------------
+// File: HttpEventServerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/http/HttpEventServer.hh"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using eos::common::HttpEventServer;
+using eos::common::HttpExchange;
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Raw HTTP/1.1 client talking to the server over a loopback connection, so
+//! the tests control exactly how the request bytes are split and pipelined
+//------------------------------------------------------------------------------
+class RawClient
+{
+public:
+  struct Response {
+    int mCode {0};
+    std::map<std::string, std::string> mHeaders; ///< Lower case names
+    std::string mBody;
+  };
+
+  RawClient(int port)
+  {
+    mFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv {5, 0};
+    int on = 1;
+    (void) setsockopt(mFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    (void) setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    mConnected = !connect(mFd, (struct sockaddr*) &addr, sizeof(addr));
+  }
+
+  ~RawClient()
+  {
+    (void) close(mFd);
+  }
+
+  bool IsConnected() const
+  {
+    return mConnected;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Send data in pieces of the given size with a short pause in between so
+  //! that every piece arrives in a separate read of the server
+  //----------------------------------------------------------------------------
+  bool Send(const std::string& data, size_t piece = 0)
+  {
+    piece = piece ? piece : data.size();
+
+    for (size_t pos = 0; pos < data.size(); pos += piece) {
+      size_t len = std::min(piece, data.size() - pos);
+
+      if (send(mFd, data.data() + pos, len, MSG_NOSIGNAL) != (ssize_t) len) {
+        return false;
+      }
+
+      if (pos + len < data.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Read the next response, the body is not expected for a HEAD request
+  //----------------------------------------------------------------------------
+  bool Read(Response& resp, bool head = false)
+  {
+    resp = Response();
+    std::string line;
+
+    if (!ReadLine(line) || (line.compare(0, 9, "HTTP/1.1 ") != 0)) {
+      return false;
+    }
+
+    resp.mCode = atoi(line.c_str() + 9);
+
+    while (ReadLine(line)) {
+      if (line.empty()) {
+        break;
+      }
+
+      size_t colon = line.find(':');
+
+      if (colon == std::string::npos) {
+        return false;
+      }
+
+      std::string key = line.substr(0, colon);
+      std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+      size_t value = line.find_first_not_of(' ', colon + 1);
+      resp.mHeaders[key] = (value == std::string::npos) ? "" :
+                           line.substr(value);
+    }
+
+    if (head || (resp.mCode < 200)) {
+      return true;
+    }
+
+    auto it_te = resp.mHeaders.find("transfer-encoding");
+
+    if ((it_te != resp.mHeaders.end()) && (it_te->second == "chunked")) {
+      while (ReadLine(line)) {
+        size_t len = strtoul(line.c_str(), nullptr, 16);
+
+        if (!len) {
+          return ReadLine(line) && line.empty();
+        }
+
+        if (!ReadBytes(resp.mBody, len) || !ReadLine(line) || !line.empty()) {
+          return false;
+        }
+      }
+
+      return false;
+    }
+
+    if (resp.mHeaders.count("content-length")) {
+      return ReadBytes(resp.mBody,
+                       std::stoul(resp.mHeaders["content-length"]));
+    }
+
+    // Body delimited by the end of the connection
+    while (Fill()) {}
+
+    resp.mBody = mBuf;
+    mBuf.clear();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check that the server closed the connection without sending more data
+  //----------------------------------------------------------------------------
+  bool IsClosed()
+  {
+    return mBuf.empty() && !Fill() && mBuf.empty() && !mTimedOut;
+  }
+
+private:
+  bool Fill()
+  {
+    char buf[4096];
+    ssize_t nread;
+
+    do {
+      nread = recv(mFd, buf, sizeof(buf), 0);
+    } while ((nread < 0) && (errno == EINTR));
+
+    if (nread > 0) {
+      mBuf.append(buf, nread);
+      return true;
+    }
+
+    mTimedOut = (nread < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+    return false;
+  }
+
+  bool ReadLine(std::string& line)
+  {
+    size_t eol;
+
+    while ((eol = mBuf.find("\r\n")) == std::string::npos) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+
+    line = mBuf.substr(0, eol);
+    mBuf.erase(0, eol + 2);
+    return true;
+  }
+
+  bool ReadBytes(std::string& out, size_t len)
+  {
+    while (mBuf.size() < len) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+
+    out.append(mBuf, 0, len);
+    mBuf.erase(0, len);
+    return true;
+  }
+
+  int mFd {-1};
+  bool mConnected {false};
+  bool mTimedOut {false};
+  std::string mBuf;
+};
+
+//------------------------------------------------------------------------------
+//! Handler echoing the parsed request: the request line and selected headers
+//! come back as response headers, the request body as response body. GET and
+//! HEAD requests without a body get their path as body.
+//------------------------------------------------------------------------------
+void
+EchoHandler(HttpExchange& exchange)
+{
+  std::string body;
+
+  if (exchange.GetPath() == "/limited") {
+    if (!exchange.ReadBody(body, 4)) {
+      exchange.SendResponse(413, {}, "");
+      return;
+    }
+  } else if (!exchange.ReadBody(body)) {
+    return;
+  }
+
+  HttpExchange::HeaderMap headers {
+    {"X-Method", exchange.GetMethod()},
+    {"X-Path", exchange.GetPath()},
+    {"X-Query", exchange.GetQuery()},
+    {"X-Version", exchange.GetVersion()}
+  };
+  auto it = exchange.GetHeaders().find("x-test");
+
+  if (it != exchange.GetHeaders().end()) {
+    headers["X-Test"] = it->second;
+  }
+
+  if (!exchange.HasBody()) {
+    body = exchange.GetPath();
+  }
+
+  if (exchange.GetPath() == "/stream") {
+    exchange.SendResponseHead(200, headers, -1);
+    exchange.SendBody(body.c_str(), body.size());
+    exchange.SendBody(body.c_str(), body.size());
+    return;
+  }
+
+  exchange.SendResponse(200, headers, body);
+}
+}
+
+//------------------------------------------------------------------------------
+//! Fixture running a server on a free port
+//------------------------------------------------------------------------------
+class HttpEventServerTest : public ::testing::Test
+{
+protected:
+  void StartServer(HttpEventServer::Options opts = HttpEventServer::Options())
+  {
+    opts.mPort = 0;
+    opts.mReactors = 2;
+    opts.mWorkers = 4;
+    mServer.reset(new HttpEventServer(opts, EchoHandler));
+    ASSERT_TRUE(mServer->Start());
+  }
+
+  void SetUp() override
+  {
+    StartServer();
+  }
+
+  void TearDown() override
+  {
+    mServer->Stop();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Send a request on a new connection and expect an error response
+  //! followed by the server closing the connection
+  //----------------------------------------------------------------------------
+  void ExpectRejected(const std::string& request, int code)
+  {
+    RawClient client(mServer->GetPort());
+    RawClient::Response resp;
+    ASSERT_TRUE(client.IsConnected());
+    ASSERT_TRUE(client.Send(request));
+    ASSERT_TRUE(client.Read(resp)) << request;
+    EXPECT_EQ(code, resp.mCode) << request;
+    EXPECT_EQ("close", resp.mHeaders["connection"]) << request;
+    EXPECT_TRUE(client.IsClosed()) << request;
+  }
+
+  std::unique_ptr<HttpEventServer> mServer;
+};
+
+//------------------------------------------------------------------------------
+// Request line, headers and body arriving in many small pieces
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, SplitRequest)
+{
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("PUT /dir/a%20file?k=a+b&x=%41 HTTP/1.1\r\n"
+                          "Host: localhost\r\nX-Test: 1\r\nx-test:  2 \r\n"
+                          "Content-Length: 11\r\n\r\nhello world", 3));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_EQ("PUT", resp.mHeaders["x-method"]);
+  EXPECT_EQ("/dir/a file", resp.mHeaders["x-path"]);
+  EXPECT_EQ("k=a b&x=A", resp.mHeaders["x-query"]);
+  EXPECT_EQ("HTTP/1.1", resp.mHeaders["x-version"]);
+  // Repeated fields are combined, values are trimmed
+  EXPECT_EQ("1, 2", resp.mHeaders["x-test"]);
+  EXPECT_EQ("hello world", resp.mBody);
+  EXPECT_EQ(0u, resp.mHeaders.count("connection"));
+  // The connection stays open for the next request
+  ASSERT_TRUE(client.Send("GET /next HTTP/1.1\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_EQ("/next", resp.mBody);
+}
+
+//------------------------------------------------------------------------------
+// Several requests sent at once are answered in order on the same connection
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, Pipelined)
+{
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("GET /1 HTTP/1.1\r\n\r\n"
+                          "\r\n\r\n" // empty lines before a request are ignored
+                          "POST /2 HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+                          "HEAD /3 HTTP/1.1\r\n\r\n"
+                          "POST /4 HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                          "2\r\nde\r\n0\r\n\r\n"
+                          "GET http://localhost:8000/5?y HTTP/1.1\r\n"
+                          "Connection: close\r\n\r\n"
+                          "GET /6 HTTP/1.1\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ("/1", resp.mBody);
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ("POST", resp.mHeaders["x-method"]);
+  EXPECT_EQ("/2", resp.mHeaders["x-path"]);
+  EXPECT_EQ("abc", resp.mBody);
+  // A HEAD response announces the body length without sending the body
+  ASSERT_TRUE(client.Read(resp, true));
+  EXPECT_EQ("HEAD", resp.mHeaders["x-method"]);
+  EXPECT_EQ("2", resp.mHeaders["content-length"]);
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ("/4", resp.mHeaders["x-path"]);
+  EXPECT_EQ("de", resp.mBody);
+  // Absolute form target, the connection closes after this response and the
+  // last request is never served
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ("/5", resp.mHeaders["x-path"]);
+  EXPECT_EQ("y", resp.mHeaders["x-query"]);
+  EXPECT_EQ("close", resp.mHeaders["connection"]);
+  EXPECT_TRUE(client.IsClosed());
+}
+
+//------------------------------------------------------------------------------
+// Chunked request body split at every byte, with chunk extensions and
+// trailer fields, followed by a chunked response
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, ChunkedBody)
+{
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("POST /stream HTTP/1.1\r\n"
+                          "Transfer-Encoding: Chunked\r\n\r\n"
+                          "5;name=value\r\nhello\r\nA \r\n, chunked!\r\n"
+                          "0\r\nX-Trailer: 1\r\n\r\n", 1));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_EQ("chunked", resp.mHeaders["transfer-encoding"]);
+  EXPECT_EQ("hello, chunked!hello, chunked!", resp.mBody);
+  ASSERT_TRUE(client.Send("GET /next HTTP/1.1\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ("/next", resp.mBody);
+}
+
+//------------------------------------------------------------------------------
+// Malformed chunked bodies close the connection
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, MalformedChunkedBody)
+{
+  for (const char* body : {
+         "zz\r\nhello\r\n0\r\n\r\n", // chunk size not hex
+         "\r\nhello\r\n0\r\n\r\n", // empty chunk size
+         "1000000000000000\r\n", // chunk size overflow
+         "5\r\nhelloXX0\r\n\r\n" // missing CRLF after the chunk data
+       }) {
+    RawClient client(mServer->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    ASSERT_TRUE(client.Send(std::string("POST /x HTTP/1.1\r\n"
+                                        "Transfer-Encoding: chunked\r\n\r\n") +
+                            body));
+    EXPECT_TRUE(client.IsClosed()) << body;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Request body framing errors
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, BodyFraming)
+{
+  // Only the chunked transfer coding is implemented
+  ExpectRejected("POST /x HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 501);
+  ExpectRejected("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n"
+                 "\r\n", 501);
+  ExpectRejected("POST /x HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n"
+                 "\r\n", 501);
+  ExpectRejected("POST /x HTTP/1.1\r\nTransfer-Encoding: xchunked\r\n\r\n",
+                 501);
+  // Invalid content lengths
+  ExpectRejected("POST /x HTTP/1.1\r\nContent-Length: abc\r\n\r\n", 400);
+  ExpectRejected("POST /x HTTP/1.1\r\nContent-Length: -1\r\n\r\n", 400);
+  ExpectRejected("POST /x HTTP/1.1\r\nContent-Length: \r\n\r\n", 400);
+  ExpectRejected("POST /x HTTP/1.1\r\nContent-Length: 1234567890123456789\r\n"
+                 "\r\n", 400);
+  // A body above the limit of the handler is refused and the connection is
+  // closed since the rest of the body is not read
+  ExpectRejected("POST /limited HTTP/1.1\r\nContent-Length: 10\r\n\r\n"
+                 "012345", 413);
+  // With both a transfer coding and a content length the request is served
+  // but the connection is not reused
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n"
+                          "Content-Length: 3\r\n\r\n3\r\nabc\r\n0\r\n\r\n"
+                          "GET /smuggled HTTP/1.1\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_EQ("close", resp.mHeaders["connection"]);
+  EXPECT_TRUE(client.IsClosed());
+}
+
+//------------------------------------------------------------------------------
+// A body larger than the body buffer streams through to the handler
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, BoundedBodyBuffer)
+{
+  mServer->Stop();
+  HttpEventServer::Options opts;
+  opts.mMaxBodyBuffer = 16;
+  StartServer(opts);
+  std::string body;
+
+  for (int i = 0; body.size() < 256 * 1024; ++i) {
+    body += std::to_string(i);
+  }
+
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("PUT /big HTTP/1.1\r\nContent-Length: " +
+                          std::to_string(body.size()) + "\r\n\r\n" + body));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_TRUE(resp.mBody == body);
+}
+
+//------------------------------------------------------------------------------
+// Malformed request lines and header fields
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, MalformedHead)
+{
+  ExpectRejected("GET\r\n\r\n", 400);
+  ExpectRejected("GET /\r\n\r\n", 400);
+  ExpectRejected(" GET / HTTP/1.1\r\n\r\n", 400);
+  ExpectRejected("GET / FOO/1.1\r\n\r\n", 400);
+  ExpectRejected("GET / HTTP/2.0\r\n\r\n", 505);
+  ExpectRejected("GET / HTTP/1.1\r\nNoColon\r\n\r\n", 400);
+  ExpectRejected("GET / HTTP/1.1\r\n: value\r\n\r\n", 400);
+  // Whitespace in the field name or before the colon
+  ExpectRejected("POST / HTTP/1.1\r\nContent-Length : 5\r\n\r\nhello", 400);
+  ExpectRejected("GET / HTTP/1.1\r\nX Test: 1\r\n\r\n", 400);
+  // Obsolete line folding
+  ExpectRejected("GET / HTTP/1.1\r\nX-Test: 1\r\n 2\r\n\r\n", 400);
+}
+
+//------------------------------------------------------------------------------
+// Request heads above the size limit, complete or not
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, HeadTooLarge)
+{
+  mServer->Stop();
+  HttpEventServer::Options opts;
+  opts.mMaxHeaderSize = 1024;
+  StartServer(opts);
+  const std::string big(2048, 'a');
+  ExpectRejected("GET / HTTP/1.1\r\nX-Big: " + big, 431);
+  ExpectRejected("GET / HTTP/1.1\r\nX-Big: " + big + "\r\n\r\n", 431);
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("GET / HTTP/1.1\r\nX-Test: " + big.substr(0, 900) +
+                          "\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+}
+
+//------------------------------------------------------------------------------
+// Connection persistence of HTTP/1.0 and HTTP/1.1
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, KeepAlive)
+{
+  RawClient::Response resp;
+  {
+    // HTTP/1.0 closes by default
+    RawClient client(mServer->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    ASSERT_TRUE(client.Send("GET /a HTTP/1.0\r\n\r\n"));
+    ASSERT_TRUE(client.Read(resp));
+    EXPECT_EQ("HTTP/1.0", resp.mHeaders["x-version"]);
+    EXPECT_EQ("close", resp.mHeaders["connection"]);
+    EXPECT_TRUE(client.IsClosed());
+  }
+  {
+    // HTTP/1.0 with keep-alive
+    RawClient client(mServer->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(client.Send("GET /a HTTP/1.0\r\nConnection: Keep-Alive\r\n"
+                              "\r\n"));
+      ASSERT_TRUE(client.Read(resp));
+      EXPECT_EQ(200, resp.mCode);
+      EXPECT_EQ(0u, resp.mHeaders.count("connection"));
+    }
+  }
+  {
+    // HTTP/1.0 with keep-alive reading a chunked response can only find its
+    // end by the connection closing
+    RawClient client(mServer->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    ASSERT_TRUE(client.Send("GET /stream HTTP/1.0\r\nConnection: keep-alive\r\n"
+                            "\r\n"));
+    ASSERT_TRUE(client.Read(resp));
+    EXPECT_EQ("close", resp.mHeaders["connection"]);
+    EXPECT_EQ(0u, resp.mHeaders.count("transfer-encoding"));
+    EXPECT_EQ("/stream/stream", resp.mBody);
+  }
+  {
+    // HTTP/1.1 closes on request
+    RawClient client(mServer->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    ASSERT_TRUE(client.Send("GET /a HTTP/1.1\r\nConnection: close\r\n\r\n"));
+    ASSERT_TRUE(client.Read(resp));
+    EXPECT_EQ("close", resp.mHeaders["connection"]);
+    EXPECT_TRUE(client.IsClosed());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Expect: 100-continue is answered once the handler reads the body
+//------------------------------------------------------------------------------
+TEST_F(HttpEventServerTest, ExpectContinue)
+{
+  RawClient client(mServer->GetPort());
+  RawClient::Response resp;
+  ASSERT_TRUE(client.IsConnected());
+  ASSERT_TRUE(client.Send("PUT /c HTTP/1.1\r\nExpect: 100-continue\r\n"
+                          "Content-Length: 4\r\n\r\n"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(100, resp.mCode);
+  ASSERT_TRUE(client.Send("data"));
+  ASSERT_TRUE(client.Read(resp));
+  EXPECT_EQ(200, resp.mCode);
+  EXPECT_EQ("data", resp.mBody);
+}
@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------
+// File: NssCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/NssCache.hh"
+
+using eos::common::NssCache;
+using namespace std::chrono;
+
+//------------------------------------------------------------------------------
+// Positive and negative entries with their TTLs
+//------------------------------------------------------------------------------
+TEST(NssCache, PositiveNegativeTtl)
+{
+  std::atomic<int> calls {0};
+  NssCache<int, std::string> cache([&](const int & key)
+  -> std::optional<std::string> {
+    ++calls;
+
+    if (key < 0) {
+      return std::nullopt;
+    }
+
+    return std::to_string(key);
+  }, 2, true);
+  NssCache<int, std::string>::Options opts;
+  opts.mPositiveTtl = seconds(100);
+  opts.mNegativeTtl = seconds(10);
+  opts.mRefreshAhead = seconds(0);
+  cache.SetOptions(opts);
+  int errc = 0;
+  auto val = cache.Get(1, errc);
+  ASSERT_TRUE(val);
+  ASSERT_EQ("1", *val);
+  ASSERT_EQ(0, errc);
+  ASSERT_FALSE(cache.Get(-1, errc));
+  ASSERT_EQ(ENOENT, errc);
+  ASSERT_EQ(2, calls);
+  // Both entries are cached
+  ASSERT_TRUE(cache.Get(1, errc));
+  ASSERT_FALSE(cache.Get(-1, errc));
+  ASSERT_EQ(ENOENT, errc);
+  ASSERT_EQ(2, calls);
+  // Negative entry expires first
+  cache.GetClock().advance(seconds(11));
+  ASSERT_TRUE(cache.Get(1, errc));
+  ASSERT_FALSE(cache.Get(-1, errc));
+  ASSERT_EQ(3, calls);
+  cache.GetClock().advance(seconds(90));
+  ASSERT_TRUE(cache.Get(1, errc));
+  ASSERT_EQ(4, calls);
+  auto stats = cache.GetStats();
+  ASSERT_EQ(2, stats.mHits);
+  ASSERT_EQ(1, stats.mNegativeHits);
+  ASSERT_EQ(4, stats.mMisses);
+  // Explicit store and invalidation
+  cache.Store(-5, "minus five");
+  val = cache.Get(-5, errc);
+  ASSERT_TRUE(val);
+  ASSERT_EQ("minus five", *val);
+  cache.Invalidate(-5);
+  ASSERT_FALSE(cache.Get(-5, errc));
+  ASSERT_EQ(5, calls);
+  cache.Clear();
+  ASSERT_EQ(0, cache.Size());
+}
+
+//------------------------------------------------------------------------------
+// Concurrent misses are coalesced, slow lookups time out and stale values
+// are served while refreshing
+//------------------------------------------------------------------------------
+TEST(NssCache, SingleFlightAndTimeout)
+{
+  std::atomic<int> calls {0};
+  std::atomic<int> delay_ms {50};
+  eos::common::ThreadPool pool(2, 2, 10, 6, 10, "NssTest");
+  NssCache<int, std::string> cache([&](const int & key)
+  -> std::optional<std::string> {
+    ++calls;
+    std::this_thread::sleep_for(milliseconds(delay_ms));
+    return std::to_string(key);
+  });
+  NssCache<int, std::string>::Options opts;
+  opts.mTimeout = seconds(5);
+  opts.mPositiveTtl = milliseconds(200);
+  opts.mRefreshAhead = milliseconds(0);
+  cache.SetOptions(opts);
+  cache.SetPool(&pool);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 16; ++i) {
+    threads.emplace_back([&]() {
+      int errc = 0;
+      auto val = cache.Get(7, errc);
+      ASSERT_TRUE(val);
+      ASSERT_EQ("7", *val);
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(1, calls);
+  // Slow lookup without stale value times out
+  delay_ms = 500;
+  opts.mTimeout = milliseconds(10);
+  cache.SetOptions(opts);
+  int errc = 0;
+  ASSERT_FALSE(cache.Get(8, errc));
+  ASSERT_EQ(ETIMEDOUT, errc);
+  // Slow lookup with stale value returns the stale value
+  std::this_thread::sleep_for(milliseconds(250));
+  auto val = cache.Get(7, errc);
+  ASSERT_TRUE(val);
+  ASSERT_EQ("7", *val);
+  ASSERT_EQ(0, errc);
+  ASSERT_EQ(2, cache.GetStats().mTimeouts);
+}
+
+//------------------------------------------------------------------------------
+// Entries close to expiry are refreshed in the background
+//------------------------------------------------------------------------------
+TEST(NssCache, RefreshAhead)
+{
+  std::atomic<int> calls {0};
+  eos::common::ThreadPool pool(1, 1, 10, 6, 10, "NssTest");
+  NssCache<int, int> cache([&](const int & key) -> std::optional<int> {
+    return key + (calls++);
+  }, 2, true);
+  NssCache<int, int>::Options opts;
+  opts.mPositiveTtl = seconds(100);
+  opts.mRefreshAhead = seconds(10);
+  cache.SetOptions(opts);
+  cache.SetPool(&pool);
+  int errc = 0;
+  ASSERT_EQ(1, *cache.Get(1, errc));
+  cache.GetClock().advance(seconds(95));
+  // Hit close to expiry returns cached value and triggers a refresh
+  ASSERT_EQ(1, *cache.Get(1, errc));
+
+  for (int i = 0; (i < 100) && (calls < 2); ++i) {
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+
+  std::this_thread::sleep_for(milliseconds(10));
+  ASSERT_EQ(2, cache.Get(1, errc).value());
+  ASSERT_EQ(1, cache.GetStats().mRefreshes);
+}
+
+//------------------------------------------------------------------------------
+// Batched lookups are resolved in parallel
+//------------------------------------------------------------------------------
+TEST(NssCache, GetMany)
+{
+  eos::common::ThreadPool pool(8, 8, 10, 6, 10, "NssTest");
+  NssCache<int, int> cache([&](const int & key) -> std::optional<int> {
+    std::this_thread::sleep_for(milliseconds(100));
+
+    if (key % 2) {
+      return std::nullopt;
+    }
+
+    return 2 * key;
+  });
+  cache.SetPool(&pool);
+  std::vector<int> keys {0, 1, 2, 3, 4, 5, 6, 7};
+  auto start = steady_clock::now();
+  auto result = cache.GetMany(keys);
+  ASSERT_LT(duration_cast<milliseconds>(steady_clock::now() - start).count(),
+            500);
+  ASSERT_EQ(keys.size(), result.size());
+
+  for (int key : keys) {
+    if (key % 2) {
+      ASSERT_FALSE(result[key]);
+    } else {
+      ASSERT_EQ(2 * key, result[key].value());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Lookups never run in the caller's thread, with an overloaded pool misses
+// are served from stale entries or fail fast
+//------------------------------------------------------------------------------
+TEST(NssCache, Overload)
+{
+  std::atomic<int> calls {0};
+  std::atomic<bool> blocked {true};
+  std::atomic<bool> caller_thread {false};
+  const std::thread::id caller_id = std::this_thread::get_id();
+  eos::common::ThreadPool pool(1, 1, 10, 6, 10, "NssTest");
+  NssCache<int, std::string> cache([&](const int & key)
+  -> std::optional<std::string> {
+    ++calls;
+
+    if (std::this_thread::get_id() == caller_id) {
+      caller_thread = true;
+    }
+
+    while (blocked) {
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    return std::to_string(key);
+  }, 2, true);
+  NssCache<int, std::string>::Options opts;
+  opts.mTimeout = milliseconds(10);
+  opts.mPositiveTtl = seconds(100);
+  opts.mRefreshAhead = seconds(0);
+  opts.mMaxQueued = 1;
+  cache.SetOptions(opts);
+  cache.SetPool(&pool);
+  cache.Store(3, "three");
+  cache.GetClock().advance(seconds(200));
+  int errc = 0;
+  // One lookup running and one queued
+  ASSERT_FALSE(cache.Get(1, errc));
+  ASSERT_EQ(ETIMEDOUT, errc);
+
+  for (int i = 0; (i < 100) && (calls < 1); ++i) {
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+
+  ASSERT_FALSE(cache.Get(2, errc));
+  ASSERT_EQ(ETIMEDOUT, errc);
+  // Stale value is served without a lookup
+  auto val = cache.Get(3, errc);
+  ASSERT_TRUE(val);
+  ASSERT_EQ("three", *val);
+  ASSERT_EQ(0, errc);
+  // No stale value, fail fast
+  ASSERT_FALSE(cache.Get(4, errc));
+  ASSERT_EQ(EAGAIN, errc);
+  ASSERT_EQ(2, cache.GetStats().mOverloads);
+  ASSERT_EQ(1, calls);
+  // Once the pool drains the entries are looked up again
+  blocked = false;
+  opts.mTimeout = seconds(5);
+  cache.SetOptions(opts);
+  ASSERT_EQ("2", cache.Get(2, errc).value());
+  val = cache.Get(4, errc);
+  ASSERT_TRUE(val);
+  ASSERT_EQ("4", *val);
+  ASSERT_EQ(0, errc);
+  ASSERT_FALSE(caller_thread);
+}
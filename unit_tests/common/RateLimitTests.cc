@@ -104,3 +104,50 @@ TEST(RequestRateLimit, MultiThread)
     std::cout << "Run took: " << dur_ms << " (fake)ms" << std::endl;
   }
 }
+
+//------------------------------------------------------------------------------
+// Test token bucket refill and burst behaviour
+//------------------------------------------------------------------------------
+TEST(TokenBucket, BasicFunctionality)
+{
+  using namespace eos::common;
+  SteadyClock clock(true);
+  clock.advance(seconds(5));
+  TokenBucket unlimited(0, 0, clock.getTime());
+  ASSERT_TRUE(unlimited.IsUnlimited());
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(unlimited.CanConsume(clock.getTime()));
+    unlimited.Consume(clock.getTime());
+  }
+
+  // Bucket starts full with a burst of one second worth of tokens
+  TokenBucket bucket(10, 0, clock.getTime());
+  ASSERT_EQ(10, bucket.GetBurst());
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(bucket.CanConsume(clock.getTime()));
+    bucket.Consume(clock.getTime());
+  }
+
+  ASSERT_FALSE(bucket.CanConsume(clock.getTime()));
+  auto wait = bucket.TimeToAvailable(clock.getTime());
+  ASSERT_GT(wait.count(), 99000);
+  ASSERT_LE(wait.count(), 100001);
+  clock.advance(wait);
+  ASSERT_TRUE(bucket.CanConsume(clock.getTime()));
+  // Tokens don't accumulate above the burst size
+  clock.advance(seconds(100));
+  ASSERT_EQ(10, bucket.GetTokens(clock.getTime()));
+  // Consume can go into debt which delays the refill
+  bucket.Consume(clock.getTime(), 20);
+  ASSERT_EQ(-10, bucket.GetTokens(clock.getTime()));
+  clock.advance(seconds(1));
+  ASSERT_FALSE(bucket.CanConsume(clock.getTime()));
+  clock.advance(milliseconds(100));
+  ASSERT_TRUE(bucket.CanConsume(clock.getTime()));
+  // Reconfiguring caps the existing tokens
+  clock.advance(seconds(10));
+  bucket.Configure(5, 2);
+  ASSERT_EQ(2, bucket.GetTokens(clock.getTime()));
+}
@@ -0,0 +1,288 @@
+//------------------------------------------------------------------------------
+//! @file AdmissionControlTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#define IN_TEST_HARNESS
+#include "mgm/AdmissionControl.hh"
+#undef IN_TEST_HARNESS
+#include <thread>
+#include <vector>
+
+using namespace eos::mgm;
+
+namespace
+{
+AdmissionControl::Request MakeRequest(uid_t uid, gid_t gid,
+                                      const std::string& app = "",
+                                      const std::string& op = "r")
+{
+  AdmissionControl::Request req;
+  req.mUid = uid;
+  req.mGid = gid;
+  req.mApp = app;
+  req.mOp = op;
+  return req;
+}
+}
+
+//------------------------------------------------------------------------------
+// Test configuration parsing and the disabled mode
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, Configure)
+{
+  AdmissionControl ac(true);
+  ASSERT_FALSE(ac.IsEnabled());
+  // Without rules every request is admitted
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000)).mAdmitted);
+  std::map<std::string, std::string> rules {
+    {"rate:user:*:OpenRead", "10"},
+    {"admission:user:bad", "10"},
+    {"admission:global:1000:r", "10"},
+    {"admission:user:*:r", "0"}
+  };
+  ac.Configure(rules, 1);
+  ASSERT_FALSE(ac.IsEnabled());
+  rules["admission:user:*:w"] = "10";
+  // Same version is not re-applied
+  ac.Configure(rules, 1);
+  ASSERT_FALSE(ac.IsEnabled());
+  ac.Configure(rules, 2);
+  ASSERT_TRUE(ac.IsEnabled());
+  ASSERT_EQ(1u, ac.mRules.size());
+}
+
+//------------------------------------------------------------------------------
+// Test the hierarchical buckets without queueing
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, HierarchicalBuckets)
+{
+  AdmissionControl ac(true);
+  auto& clock = ac.GetClock();
+  clock.advance(std::chrono::seconds(5));
+  std::map<std::string, std::string> rules {
+    {"admission:queue:wait", "0"},
+    {"admission:global:*:*", "100"},
+    {"admission:user:*:w", "5"},
+    {"admission:user:1001:w", "20"},
+    {"admission:app:batch:*", "3"}
+  };
+  ac.Configure(rules, 1);
+
+  // Per-user default limit for writes, reads are only globally limited
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000, "", "w")).mAdmitted);
+  }
+
+  auto decision = ac.Admit(MakeRequest(1000, 1000, "", "w"));
+  ASSERT_FALSE(decision.mAdmitted);
+  ASSERT_EQ("user:1000:w", decision.mBucket);
+  ASSERT_GE(decision.mStallSec, 1u);
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000, "", "r")).mAdmitted);
+
+  // Explicit user rule overrides the wildcard one
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(ac.Admit(MakeRequest(1001, 1000, "", "w")).mAdmitted);
+  }
+
+  ASSERT_FALSE(ac.Admit(MakeRequest(1001, 1000, "", "w")).mAdmitted);
+
+  // Application limit applies across users
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(ac.Admit(MakeRequest(2000 + i, 1000, "batch")).mAdmitted);
+  }
+
+  decision = ac.Admit(MakeRequest(2010, 1000, "batch"));
+  ASSERT_FALSE(decision.mAdmitted);
+  ASSERT_EQ("app:batch:*", decision.mBucket);
+
+  // Exhaust the global bucket, a rejected request must not consume tokens
+  // from the upper levels
+  int admitted = 0;
+
+  for (int i = 0; i < 200; ++i) {
+    if (ac.Admit(MakeRequest(3000 + i, 1000)).mAdmitted) {
+      ++admitted;
+    }
+  }
+
+  ASSERT_EQ(100 - 5 - 1 - 20 - 3, admitted);
+  decision = ac.Admit(MakeRequest(5000, 1000));
+  ASSERT_FALSE(decision.mAdmitted);
+  ASSERT_EQ("global:*:*", decision.mBucket);
+  auto stats = ac.GetBucketStats("global:*:*");
+  ASSERT_EQ(100u, stats.mAdmitted);
+  // After one second the buckets are refilled
+  clock.advance(std::chrono::seconds(1));
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000, "", "w")).mAdmitted);
+  ASSERT_TRUE(ac.Admit(MakeRequest(2010, 1000, "batch")).mAdmitted);
+  ASSERT_FALSE(ac.PrintOut(true).empty());
+}
+
+//------------------------------------------------------------------------------
+// Test that queued requests are served fairly between users
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, FairQueueing)
+{
+  using namespace std::chrono;
+  AdmissionControl ac(true);
+  auto& clock = ac.GetClock();
+  clock.advance(seconds(5));
+  std::map<std::string, std::string> rules {
+    {"admission:queue:wait", "60000"},
+    {"admission:global:*:*", "1"}
+  };
+  ac.Configure(rules, 1);
+  // Drain the global bucket
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000)).mAdmitted);
+  // Wait until the given number of requests is queued
+  auto wait_depth = [&](uint64_t depth) {
+    auto deadline = steady_clock::now() + seconds(30);
+
+    while ((ac.GetQueueDepth() != depth) && (steady_clock::now() < deadline)) {
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    return ac.GetQueueDepth();
+  };
+  // Refill exactly one token and wake up the queued requests
+  auto refill = [&]() {
+    {
+      std::unique_lock<std::mutex> lock(ac.mMutex);
+      clock.advance(seconds(1));
+    }
+    ac.mCv.notify_all();
+  };
+  // The threads only record their decisions, they are checked at the end
+  const size_t num_abusive = 8;
+  std::vector<AdmissionControl::Decision> decisions(num_abusive + 1);
+  std::vector<std::thread> threads;
+
+  // Abusive user queues many requests first
+  for (size_t i = 0; i < num_abusive; ++i) {
+    threads.emplace_back([&, i]() {
+      decisions[i] = ac.Admit(MakeRequest(1000, 1000));
+    });
+  }
+
+  ASSERT_EQ(num_abusive, wait_depth(num_abusive));
+  // Polite user with a single request arriving last
+  threads.emplace_back([&]() {
+    decisions[num_abusive] = ac.Admit(MakeRequest(2000, 2000));
+  });
+  ASSERT_EQ(num_abusive + 1, wait_depth(num_abusive + 1));
+  // Served in round-robin with the abusive user i.e. with the second token
+  refill();
+  ASSERT_EQ(num_abusive, wait_depth(num_abusive));
+  refill();
+  ASSERT_EQ(num_abusive - 1, wait_depth(num_abusive - 1));
+  threads.back().join();
+  threads.pop_back();
+
+  for (size_t i = 0; i < num_abusive - 1; ++i) {
+    refill();
+    ASSERT_EQ(num_abusive - 2 - i, wait_depth(num_abusive - 2 - i));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& decision : decisions) {
+    ASSERT_TRUE(decision.mAdmitted);
+  }
+
+  ASSERT_EQ(2 * 1000000, decisions[num_abusive].mQueued.count());
+  ASSERT_EQ(num_abusive + 2, ac.GetBucketStats("global:*:*").mAdmitted);
+}
+
+//------------------------------------------------------------------------------
+// Test rejection when the queue is full
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, QueueFull)
+{
+  AdmissionControl ac(true);
+  auto& clock = ac.GetClock();
+  clock.advance(std::chrono::seconds(5));
+  std::map<std::string, std::string> rules {
+    {"admission:queue:depth", "0"},
+    {"admission:stall:max", "30"},
+    {"admission:user:*:*", "1"}
+  };
+  ac.Configure(rules, 1);
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000)).mAdmitted);
+
+  for (int i = 0; i < 10; ++i) {
+    auto decision = ac.Admit(MakeRequest(1000, 1000));
+    ASSERT_FALSE(decision.mAdmitted);
+    ASSERT_GE(decision.mStallSec, 1u);
+    ASSERT_LE(decision.mStallSec, 45u);
+  }
+
+  ASSERT_EQ(10u, ac.GetBucketStats("user:1000:*").mRejected);
+}
+
+//------------------------------------------------------------------------------
+// Test that a weighted request is charged all its tokens in one decision
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, Weight)
+{
+  AdmissionControl ac(true);
+  auto& clock = ac.GetClock();
+  clock.advance(std::chrono::seconds(5));
+  std::map<std::string, std::string> rules {
+    {"admission:queue:wait", "0"},
+    {"admission:user:*:w", "10"}
+  };
+  ac.Configure(rules, 1);
+  // A batch larger than the burst is admitted and leaves the bucket in debt
+  auto req = MakeRequest(1000, 1000, "", "w");
+  req.mWeight = 25;
+  ASSERT_TRUE(ac.Admit(req).mAdmitted);
+  auto decision = ac.Admit(MakeRequest(1000, 1000, "", "w"));
+  ASSERT_FALSE(decision.mAdmitted);
+  ASSERT_GE(decision.mStallSec, 1u);
+  // The debt of 15 tokens plus one token is repaid after 1.6 seconds
+  clock.advance(std::chrono::milliseconds(1500));
+  ASSERT_FALSE(ac.Admit(MakeRequest(1000, 1000, "", "w")).mAdmitted);
+  clock.advance(std::chrono::milliseconds(200));
+  ASSERT_TRUE(ac.Admit(MakeRequest(1000, 1000, "", "w")).mAdmitted);
+  ASSERT_EQ(2u, ac.GetBucketStats("user:1000:w").mAdmitted);
+}
+
+//------------------------------------------------------------------------------
+// Test that metadata reads are exempt from admission control
+//------------------------------------------------------------------------------
+TEST(AdmissionControl, ExemptOps)
+{
+  for (const auto& op : {
+         "stat", "exists", "access", "Checksum", "FSctl", "Eosxd::prot::STAT",
+         "Eosxd::prot::LS"
+       }) {
+    ASSERT_FALSE(AdmissionControl::IsAdmissionOp(op)) << op;
+  }
+
+  for (const auto& op : {
+         "open", "prepare", "Redirect", "rem", "_mkdir", "Eosxd::prot::SET"
+       }) {
+    ASSERT_TRUE(AdmissionControl::IsAdmissionOp(op)) << op;
+  }
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// File: ConversionThroughputTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#define IN_TEST_HARNESS
+#include "mgm/convert/ConversionThroughput.hh"
+#undef IN_TEST_HARNESS
+
+using eos::mgm::ConversionThroughput;
+using namespace std::chrono;
+
+//------------------------------------------------------------------------------
+// Counters of finished conversions
+//------------------------------------------------------------------------------
+TEST(ConversionThroughput, Counters)
+{
+  ConversionThroughput tput(true);
+  tput.Account(true, 100);
+  tput.Account(true, 200);
+  tput.Account(false, 300);
+  auto stats = tput.GetStats();
+  ASSERT_EQ(2u, stats.mFiles);
+  ASSERT_EQ(300u, stats.mBytes);
+  ASSERT_EQ(1u, stats.mFailed);
+  // No complete sampling window yet
+  ASSERT_EQ(0, stats.mFileRate);
+  ASSERT_EQ(0, stats.mByteRate);
+}
+
+//------------------------------------------------------------------------------
+// Smoothed rates in files/s and bytes/s
+//------------------------------------------------------------------------------
+TEST(ConversionThroughput, Rates)
+{
+  ConversionThroughput tput(true);
+  auto& clock = tput.GetClock();
+  // Start sampling
+  (void) tput.GetStats();
+
+  for (int i = 0; i < 100; ++i) {
+    tput.Account(true, 1000);
+  }
+
+  clock.advance(ConversionThroughput::sRateWindow);
+  auto stats = tput.GetStats();
+  ASSERT_DOUBLE_EQ(10.0, stats.mFileRate);
+  ASSERT_DOUBLE_EQ(10000.0, stats.mByteRate);
+  // An empty window lowers the rates smoothly
+  clock.advance(ConversionThroughput::sRateWindow);
+  stats = tput.GetStats();
+  ASSERT_DOUBLE_EQ(7.0, stats.mFileRate);
+  ASSERT_DOUBLE_EQ(7000.0, stats.mByteRate);
+  // A long idle period resets the rates
+  clock.advance(10 * ConversionThroughput::sRateWindow);
+  stats = tput.GetStats();
+  ASSERT_DOUBLE_EQ(0.0, stats.mFileRate);
+  ASSERT_DOUBLE_EQ(0.0, stats.mByteRate);
+  ASSERT_EQ(100u, stats.mFiles);
+  ASSERT_EQ(100000u, stats.mBytes);
+}
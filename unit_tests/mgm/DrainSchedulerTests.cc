@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+// File: DrainSchedulerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/drain/DrainScheduler.hh"
+#include <thread>
+
+using eos::mgm::DrainScheduler;
+using namespace std::chrono;
+
+//------------------------------------------------------------------------------
+// Slot budgets per disk and per node
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, SlotBudgets)
+{
+  DrainScheduler sched(true);
+  DrainScheduler::Budget budget;
+  budget.mFsSlots = 2;
+  budget.mNodeSlots = 3;
+  sched.SetBudget(budget);
+  DrainScheduler::Endpoint src {1, "node1"};
+  DrainScheduler::Endpoint dst1 {10, "node2"};
+  DrainScheduler::Endpoint dst2 {11, "node2"};
+  DrainScheduler::Endpoint dst3 {20, "node3"};
+  ASSERT_TRUE(sched.TryAcquire(src, dst1));
+  ASSERT_TRUE(sched.TryAcquire(src, dst2));
+  // Source disk is full
+  ASSERT_FALSE(sched.TryAcquire(src, dst3));
+  ASSERT_EQ(2, sched.GetFsLoad(1));
+  ASSERT_EQ(2, sched.GetNodeLoad("node2"));
+  // Destination node is limited to 3 transfers
+  DrainScheduler::Endpoint src2 {2, "node1"};
+  DrainScheduler::Endpoint dst4 {12, "node2"};
+  ASSERT_TRUE(sched.TryAcquire(src2, dst4));
+  ASSERT_EQ(3, sched.GetNodeLoad("node1"));
+  ASSERT_FALSE(sched.TryAcquire({3, "node4"}, {13, "node2"}));
+  // Failed attempts don't leak slots
+  ASSERT_EQ(0, sched.GetFsLoad(3));
+  ASSERT_EQ(0, sched.GetNodeLoad("node4"));
+  sched.Release(src, dst1, 1, true, 0);
+  ASSERT_EQ(1, sched.GetFsLoad(1));
+  ASSERT_EQ(0, sched.GetFsLoad(10));
+  ASSERT_TRUE(sched.TryAcquire({3, "node4"}, {13, "node2"}));
+}
+
+//------------------------------------------------------------------------------
+// Bandwidth budgets are charged with the data moved
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, BandwidthBudget)
+{
+  DrainScheduler sched(true);
+  DrainScheduler::Budget budget;
+  budget.mNodeRate = 100 * 1024 * 1024;
+  sched.SetBudget(budget);
+  DrainScheduler::Endpoint src {1, "node1"};
+  DrainScheduler::Endpoint dst {10, "node2"};
+  ASSERT_TRUE(sched.TryAcquire(src, dst));
+  // Moving 1GB puts the node buckets in debt for ~9 seconds
+  sched.Release(src, dst, 1, true, 1024 * 1024 * 1024);
+  ASSERT_FALSE(sched.TryAcquire(src, dst));
+  ASSERT_FALSE(sched.TryAcquire({2, "node3"}, {11, "node2"}));
+  ASSERT_TRUE(sched.TryAcquire({2, "node3"}, {11, "node4"}));
+  sched.GetClock().advance(seconds(10));
+  ASSERT_TRUE(sched.TryAcquire(src, dst));
+}
+
+//------------------------------------------------------------------------------
+// Candidates are ranked by load, the ones over budget last
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, Rank)
+{
+  DrainScheduler sched(true);
+  DrainScheduler::Budget budget;
+  budget.mFsSlots = 2;
+  sched.SetBudget(budget);
+  DrainScheduler::Endpoint src {1, "node1"};
+  ASSERT_TRUE(sched.TryAcquire(src, {10, "node2"}));
+  ASSERT_TRUE(sched.TryAcquire({2, "node1"}, {10, "node2"}));
+  ASSERT_TRUE(sched.TryAcquire({3, "node1"}, {11, "node2"}));
+  auto ranked = sched.Rank({{10, "node2"}, {11, "node2"}, {12, "node3"}});
+  ASSERT_EQ(3, ranked.size());
+  ASSERT_EQ(12, ranked[0].mFsid);
+  ASSERT_EQ(11, ranked[1].mFsid);
+  ASSERT_EQ(10, ranked[2].mFsid);
+}
+
+//------------------------------------------------------------------------------
+// Drain throughput and ETA
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, ThroughputAndEta)
+{
+  DrainScheduler sched(true);
+  DrainScheduler::Endpoint src {1, "node1"};
+  DrainScheduler::Endpoint dst {10, "node2"};
+  // No estimate before any data was moved
+  ASSERT_EQ(-1, sched.GetEta(1, 1000));
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(sched.TryAcquire(src, dst));
+    sched.GetClock().advance(seconds(1));
+    sched.Release(src, dst, 1, true, 1000000);
+  }
+
+  // Failed transfers are not accounted
+  ASSERT_TRUE(sched.TryAcquire(src, dst));
+  sched.Release(src, dst, 1, false, 0);
+  auto stats = sched.GetDrainStats(1);
+  ASSERT_EQ(10, stats.mFiles);
+  ASSERT_EQ(10000000, stats.mBytes);
+  ASSERT_NEAR(1000000, stats.mRate, 1);
+  ASSERT_EQ(100, sched.GetEta(1, 100000000));
+  // Stalled drain lowers the estimated rate
+  sched.GetClock().advance(seconds(10));
+  ASSERT_NEAR(700000, sched.GetDrainStats(1).mRate, 1);
+  sched.ForgetDrain(1);
+  ASSERT_EQ(0, sched.GetDrainStats(1).mFiles);
+}
+
+//------------------------------------------------------------------------------
+// Submission waits for a source slot, the destination is picked afterwards
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, WaitSourceAcquireDst)
+{
+  DrainScheduler sched(true);
+  DrainScheduler::Budget budget;
+  budget.mFsSlots = 1;
+  budget.mNodeSlots = 3;
+  sched.SetBudget(budget);
+  DrainScheduler::Endpoint src {1, "node1"};
+  ASSERT_TRUE(sched.WaitSource(src, milliseconds(10)));
+  ASSERT_EQ(1, sched.GetFsLoad(1));
+  // Source disk is full
+  ASSERT_FALSE(sched.WaitSource(src, milliseconds(10)));
+  ASSERT_EQ(1, sched.GetFsLoad(1));
+  // Least loaded destination with free slots is picked
+  ASSERT_TRUE(sched.TryAcquire({2, "node2"}, {10, "node3"}));
+  auto dst = sched.AcquireDst({{10, "node3"}, {11, "node1"}, {12, "node2"}});
+  ASSERT_EQ(11, dst.mFsid);
+  ASSERT_EQ(2, sched.GetNodeLoad("node1"));
+  // Waiter is woken up by the release of the slot
+  std::thread waiter([&]() {
+    ASSERT_TRUE(sched.WaitSource(src, seconds(10)));
+  });
+  std::this_thread::sleep_for(milliseconds(50));
+  sched.Release(src, dst, 1, true, 1000);
+  waiter.join();
+  ASSERT_EQ(1, sched.GetFsLoad(1));
+  ASSERT_EQ(0, sched.GetFsLoad(11));
+  ASSERT_EQ(1, sched.GetNodeLoad("node1"));
+  // Destination over budget still takes the transfer of a running job
+  dst = sched.AcquireDst({{10, "node3"}});
+  ASSERT_EQ(10, dst.mFsid);
+  ASSERT_EQ(2, sched.GetFsLoad(10));
+  sched.Release(src, dst, 1, false, 0);
+  ASSERT_EQ(0, sched.GetFsLoad(1));
+  ASSERT_EQ(1, sched.GetFsLoad(10));
+  // Release of a source slot without destination
+  ASSERT_TRUE(sched.WaitSource(src, milliseconds(10)));
+  sched.Release(src, {}, 1, false, 0);
+  ASSERT_EQ(0, sched.GetFsLoad(1));
+  ASSERT_EQ(0, sched.GetNodeLoad("node1"));
+  ASSERT_EQ(1, sched.GetNodeLoad("node3"));
+}
@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------
+// File: FsckPipelineTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/fsck/FsckPipeline.hh"
+#include <thread>
+
+using eos::mgm::FsckFidSet;
+using eos::mgm::FsckPipeline;
+using eos::mgm::FsckRepairItem;
+using namespace std::chrono;
+
+namespace
+{
+//! Priority function using the fid as priority
+uint32_t FidPriority(const FsckRepairItem& item)
+{
+  return item.mFid;
+}
+
+//! Stop function that never stops
+bool NoStop()
+{
+  return false;
+}
+}
+
+//------------------------------------------------------------------------------
+// Compact fid set
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, FidSet)
+{
+  FsckFidSet set;
+  ASSERT_TRUE(set.Insert(1));
+  ASSERT_FALSE(set.Insert(1));
+  ASSERT_TRUE(set.Insert(65536));
+  ASSERT_TRUE(set.Insert(1ull << 40));
+  ASSERT_TRUE(set.Contains(1));
+  ASSERT_TRUE(set.Contains(1ull << 40));
+  ASSERT_FALSE(set.Contains(2));
+  ASSERT_FALSE(set.Contains(3ull << 40));
+  ASSERT_EQ(3, set.Size());
+  ASSERT_EQ(3 * 8192, set.GetMemory());
+
+  // Dense fids share the same chunk
+  for (uint64_t fid = 2; fid < 65536; ++fid) {
+    ASSERT_TRUE(set.Insert(fid));
+  }
+
+  ASSERT_EQ(65537, set.Size());
+  ASSERT_EQ(3 * 8192, set.GetMemory());
+  set.Clear();
+  ASSERT_EQ(0, set.Size());
+  ASSERT_FALSE(set.Contains(1));
+}
+
+//------------------------------------------------------------------------------
+// Entries are deduplicated per fid and error type and merged into the
+// already queued items
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, DedupAndMerge)
+{
+  FsckPipeline pipeline;
+  pipeline.SetConsumerActive(true);
+  pipeline.StartCycle();
+  ASSERT_TRUE(pipeline.Add("rep_missing_n", 10, 1, true, FidPriority, NoStop));
+  ASSERT_FALSE(pipeline.Add("rep_missing_n", 10, 2, true, FidPriority, NoStop));
+  ASSERT_TRUE(pipeline.Add("blockxs_err", 10, 3, true, FidPriority, NoStop));
+  ASSERT_FALSE(pipeline.Add("orphans_n", 11, 3, false, FidPriority, NoStop));
+  ASSERT_EQ(2, pipeline.GetQueueSize());
+  ASSERT_EQ(4, pipeline.GetNumCollected());
+  FsckRepairItem item;
+  ASSERT_TRUE(pipeline.Pop(item, milliseconds(10)));
+  ASSERT_EQ(10, item.mFid);
+  ASSERT_EQ("rep_missing_n", item.mErrType);
+  ASSERT_EQ((std::set<eos::common::FileSystem::fsid_t> {1, 2}), item.mFsids);
+  ASSERT_TRUE(pipeline.Pop(item, milliseconds(10)));
+  ASSERT_EQ("blockxs_err", item.mErrType);
+  ASSERT_FALSE(pipeline.Pop(item, milliseconds(10)));
+  // Already scheduled entries are not queued again in the same cycle
+  ASSERT_FALSE(pipeline.Add("rep_missing_n", 10, 4, true, FidPriority, NoStop));
+  ASSERT_EQ(0, pipeline.GetQueueSize());
+  ASSERT_EQ(2, pipeline.GetNumScheduled());
+  // New cycle allows rescheduling
+  pipeline.StartCycle();
+  ASSERT_TRUE(pipeline.Add("rep_missing_n", 10, 1, true, FidPriority, NoStop));
+}
+
+//------------------------------------------------------------------------------
+// Items are popped by priority and in FIFO order for the same priority
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, PriorityOrder)
+{
+  FsckPipeline pipeline;
+  pipeline.SetConsumerActive(true);
+  pipeline.StartCycle();
+  auto prio_fn = [](const FsckRepairItem & item) -> uint32_t {
+    return (item.mErrType == "stripe_err") ? 0 : 10;
+  };
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 1, 1, true, prio_fn, NoStop));
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 2, 1, true, prio_fn, NoStop));
+  ASSERT_TRUE(pipeline.Add("stripe_err", 3, 1, true, prio_fn, NoStop));
+  std::vector<uint64_t> order;
+  FsckRepairItem item;
+
+  while (pipeline.Pop(item, milliseconds(1))) {
+    order.push_back(item.mFid);
+  }
+
+  ASSERT_EQ((std::vector<uint64_t> {3, 1, 2}), order);
+}
+
+//------------------------------------------------------------------------------
+// Producer blocks while the queue is full and entries are dropped without an
+// active consumer
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, BoundedQueue)
+{
+  FsckPipeline pipeline(2);
+  pipeline.StartCycle();
+  // No consumer, entries are only accounted
+  ASSERT_FALSE(pipeline.Add("d_cx_diff", 1, 1, true, FidPriority, NoStop));
+  ASSERT_EQ(0, pipeline.GetQueueSize());
+  pipeline.SetConsumerActive(true);
+  pipeline.StartCycle();
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 1, 1, true, FidPriority, NoStop));
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 2, 1, true, FidPriority, NoStop));
+  std::atomic<bool> done {false};
+  std::thread producer([&]() {
+    ASSERT_TRUE(pipeline.Add("d_cx_diff", 3, 1, true, FidPriority, NoStop));
+    done = true;
+  });
+  std::this_thread::sleep_for(milliseconds(50));
+  ASSERT_FALSE(done);
+  FsckRepairItem item;
+  ASSERT_TRUE(pipeline.Pop(item, milliseconds(10)));
+  producer.join();
+  ASSERT_TRUE(done);
+  ASSERT_EQ(2, pipeline.GetQueueSize());
+  // Stop function unblocks the producer
+  ASSERT_FALSE(pipeline.Add("d_cx_diff", 4, 1, true, FidPriority, []() {
+    return true;
+  }));
+  // Deactivating the consumer drops the queue
+  pipeline.SetConsumerActive(false);
+  ASSERT_EQ(0, pipeline.GetQueueSize());
+}
+
+//------------------------------------------------------------------------------
+// Counters of the last complete cycle are published
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, Counters)
+{
+  FsckPipeline pipeline;
+  pipeline.StartCycle();
+  pipeline.Add("rep_diff_n", 1, 1, false, nullptr, NoStop);
+  pipeline.Add("rep_diff_n", 1, 2, false, nullptr, NoStop);
+  pipeline.Add("rep_diff_n", 2, 2, false, nullptr, NoStop);
+  auto counters = pipeline.GetCounters();
+  ASSERT_FALSE(counters.mComplete);
+  ASSERT_EQ(3, counters.mErrCount["rep_diff_n"]);
+  ASSERT_EQ(2, counters.mErrFids["rep_diff_n"]);
+  ASSERT_EQ(1, counters.mFsErrCount[1]["rep_diff_n"]);
+  ASSERT_EQ(2, counters.mFsErrCount[2]["rep_diff_n"]);
+  pipeline.EndCycle();
+  // Collection in progress does not hide the last complete counters
+  pipeline.StartCycle();
+  pipeline.Add("rep_diff_n", 5, 1, false, nullptr, NoStop);
+  counters = pipeline.GetCounters();
+  ASSERT_TRUE(counters.mComplete);
+  ASSERT_EQ(3, counters.mErrCount["rep_diff_n"]);
+  pipeline.EndCycle();
+  ASSERT_EQ(1, pipeline.GetCounters().mErrCount["rep_diff_n"]);
+}
+
+//------------------------------------------------------------------------------
+// Interrupted cycle can only be resumed while none of its repairable entries
+// was dropped
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, ResumeCycle)
+{
+  FsckPipeline pipeline;
+  ASSERT_FALSE(pipeline.CanResumeCycle());
+  pipeline.SetConsumerActive(true);
+  pipeline.StartCycle();
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 1, 1, true, FidPriority, NoStop));
+  ASSERT_TRUE(pipeline.CanResumeCycle());
+  pipeline.EndCycle();
+  ASSERT_FALSE(pipeline.CanResumeCycle());
+  // Dropping the queue loses the pending repairs
+  pipeline.StartCycle();
+  ASSERT_TRUE(pipeline.Add("d_cx_diff", 2, 1, true, FidPriority, NoStop));
+  pipeline.SetConsumerActive(false);
+  ASSERT_FALSE(pipeline.CanResumeCycle());
+  // Repairable entries accounted without a consumer are never queued
+  pipeline.StartCycle();
+  ASSERT_FALSE(pipeline.Add("orphans_n", 3, 1, false, FidPriority, NoStop));
+  ASSERT_TRUE(pipeline.CanResumeCycle());
+  ASSERT_FALSE(pipeline.Add("d_cx_diff", 3, 1, true, FidPriority, NoStop));
+  ASSERT_FALSE(pipeline.CanResumeCycle());
+}
+
+//------------------------------------------------------------------------------
+// Items are ranked by the consumer and queued again if they are less urgent
+//------------------------------------------------------------------------------
+TEST(FsckPipeline, LazyRank)
+{
+  FsckPipeline pipeline;
+  pipeline.SetConsumerActive(true);
+  pipeline.StartCycle();
+
+  for (uint64_t fid = 1; fid <= 4; ++fid) {
+    ASSERT_TRUE(pipeline.Add("d_cx_diff", fid, 1, true, nullptr, NoStop));
+  }
+
+  // Even fids keep more redundancy and are repaired last
+  int num_ranked = 0;
+  auto rank_fn = [&](const FsckRepairItem & item) -> uint32_t {
+    ++num_ranked;
+    return (item.mFid % 2) ? 0 : 10;
+  };
+  std::vector<uint64_t> order;
+  FsckRepairItem item;
+
+  while (pipeline.Pop(item, milliseconds(1), rank_fn)) {
+    order.push_back(item.mFid);
+  }
+
+  ASSERT_EQ((std::vector<uint64_t> {1, 3, 2, 4}), order);
+  ASSERT_EQ(4, num_ranked);
+  ASSERT_EQ(4, pipeline.GetNumScheduled());
+}
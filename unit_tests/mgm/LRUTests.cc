@@ -54,3 +54,94 @@ TEST(LRUTests, ExpireMatchParsingMultiple) {
   ASSERT_EQ(results, expected);
 }
 
+
+//------------------------------------------------------------------------------
+// Test "sys.lru.convert.match" policy parsing
+//------------------------------------------------------------------------------
+TEST(LRUTests, ConvertMatchParsing) {
+  std::map<std::string, time_t> ages, expected_ages;
+  std::map<std::string, ssize_t> sizes, expected_sizes;
+  eos::IContainerMD::XAttrMap map {
+    {"sys.lru.convert.match", "*.root:1w,*.tgz:1d:>1k,*.txt:1d"},
+    {"sys.conversion.*.root", "00650112"},
+    {"sys.conversion.*.tgz", "00650112"}
+  };
+
+  ASSERT_TRUE(eos::mgm::LRU::parseConvertMatchPolicy(map, ages, sizes));
+  // *.txt has no conversion attribute
+  expected_ages = { {"*.root", 7 * 86400 }, {"*.tgz", 86400} };
+  expected_sizes = { {"*.tgz", 1000} };
+  ASSERT_EQ(ages, expected_ages);
+  ASSERT_EQ(sizes, expected_sizes);
+
+  map.erase("sys.lru.convert.match");
+  ASSERT_FALSE(eos::mgm::LRU::parseConvertMatchPolicy(map, ages, sizes));
+}
+
+//------------------------------------------------------------------------------
+// Test due time computation of the expire and conversion policies
+//------------------------------------------------------------------------------
+TEST(LRUTests, PolicyDueTime) {
+  std::map<std::string, time_t> ages { {"*.root", 100}, {"*", 1000} };
+  ASSERT_EQ(eos::mgm::LRU::getExpireDue("file.root", 10, ages), 110);
+  ASSERT_EQ(eos::mgm::LRU::getExpireDue("file.txt", 10, ages), 1010);
+  ages.erase("*");
+  ASSERT_EQ(eos::mgm::LRU::getExpireDue("file.txt", 10, ages), 0);
+
+  std::string rule;
+  std::map<std::string, ssize_t> sizes { {"*.root", -1000} };
+  ASSERT_EQ(eos::mgm::LRU::getConvertDue("file.root", 10, 999, ages, sizes,
+                                         rule), 110);
+  ASSERT_EQ(rule, "*.root");
+  ASSERT_EQ(eos::mgm::LRU::getConvertDue("file.root", 10, 1000, ages, sizes,
+                                         rule), 0);
+  ASSERT_TRUE(rule.empty());
+  sizes["*.root"] = 1000;
+  ASSERT_EQ(eos::mgm::LRU::getConvertDue("file.root", 10, 1001, ages, sizes,
+                                         rule), 110);
+}
+
+//------------------------------------------------------------------------------
+// Test the candidate queue ordering, updates and removal
+//------------------------------------------------------------------------------
+TEST(LRUTests, CandidateQueue) {
+  eos::mgm::LRUCandidates queue;
+  eos::mgm::LRUCandidates::Candidate candidate;
+  queue.Update(1, 300, 10);
+  queue.Update(2, 100, 20);
+  queue.Update(3, 200, 30);
+  ASSERT_EQ(queue.Size(), 3);
+  ASSERT_EQ(queue.GetBytes(), 60);
+  ASSERT_EQ(queue.GetEarliestDue(), 100);
+
+  // Updating moves the file and replaces its size
+  queue.Update(2, 400, 25);
+  ASSERT_EQ(queue.Size(), 3);
+  ASSERT_EQ(queue.GetBytes(), 65);
+  ASSERT_EQ(queue.GetEarliestDue(), 200);
+
+  // Nothing is due before 200
+  ASSERT_FALSE(queue.Pop(150, candidate));
+  ASSERT_TRUE(queue.Pop(250, candidate));
+  ASSERT_EQ(candidate.mFid, 3);
+  ASSERT_EQ(candidate.mDue, 200);
+  ASSERT_EQ(candidate.mSize, 30);
+  ASSERT_FALSE(queue.Contains(3));
+
+  ASSERT_TRUE(queue.Remove(1));
+  ASSERT_FALSE(queue.Remove(1));
+  ASSERT_EQ(queue.GetBytes(), 25);
+
+  // Popping without a time limit returns the oldest entry
+  ASSERT_TRUE(queue.Pop(0, candidate));
+  ASSERT_EQ(candidate.mFid, 2);
+  ASSERT_FALSE(queue.Pop(0, candidate));
+  ASSERT_EQ(queue.Size(), 0);
+  ASSERT_EQ(queue.GetBytes(), 0);
+  ASSERT_EQ(queue.GetEarliestDue(), 0);
+
+  queue.Update(5, 100, 1);
+  queue.Clear();
+  ASSERT_EQ(queue.Size(), 0);
+  ASSERT_FALSE(queue.Contains(5));
+}
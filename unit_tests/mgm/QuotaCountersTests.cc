@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+//! @file QuotaCountersTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/QuotaCounters.hh"
+#include <map>
+#include <thread>
+#include <vector>
+
+using eos::mgm::QuotaCounters;
+
+//------------------------------------------------------------------------------
+// Get, set and add
+//------------------------------------------------------------------------------
+TEST(QuotaCounters, Basic)
+{
+  QuotaCounters counters;
+  ASSERT_EQ(0, counters.Get(1, 1000));
+  ASSERT_EQ(0, counters.Size());
+  counters.Set(1, 1000, 4096);
+  counters.Add(1, 1000, 1024);
+  ASSERT_EQ(5120, counters.Get(1, 1000));
+  // Same id with another tag is another counter
+  ASSERT_EQ(0, counters.Get(7, 1000));
+  counters.Add(7, 1000, 1);
+  ASSERT_EQ(1, counters.Get(7, 1000));
+  ASSERT_EQ(2, counters.Size());
+  // Values do not go below 0
+  counters.Add(1, 1000, -10000);
+  ASSERT_EQ(0, counters.Get(1, 1000));
+  counters.Add(1, 1000, 10);
+  ASSERT_EQ(10, counters.Get(1, 1000));
+}
+
+//------------------------------------------------------------------------------
+// Counters survive the table growth and are all visited
+//------------------------------------------------------------------------------
+TEST(QuotaCounters, Growth)
+{
+  QuotaCounters counters(16);
+  std::map<std::pair<unsigned long, unsigned long>, long long> expected;
+
+  for (unsigned long id = 0; id < 5000; ++id) {
+    counters.Set(1 + id % 12, id, id * 3);
+    expected[ {1 + id % 12, id}] = id * 3;
+  }
+
+  ASSERT_EQ(expected.size(), counters.Size());
+
+  for (const auto& elem : expected) {
+    ASSERT_EQ(elem.second, counters.Get(elem.first.first, elem.first.second));
+  }
+
+  std::map<std::pair<unsigned long, unsigned long>, long long> visited;
+  counters.ForEach([&](unsigned long tag, unsigned long id, long long value) {
+    visited[ {tag, id}] = value;
+  });
+  ASSERT_EQ(expected, visited);
+}
+
+//------------------------------------------------------------------------------
+// Concurrent updates, including the ones racing with the table growth, are
+// not lost
+//------------------------------------------------------------------------------
+TEST(QuotaCounters, Concurrent)
+{
+  QuotaCounters counters(16);
+  const int num_threads = 8;
+  const unsigned long num_ids = 2000;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&]() {
+      for (int round = 0; round < 5; ++round) {
+        for (unsigned long id = 0; id < num_ids; ++id) {
+          counters.Add(5, id, 1);
+          (void) counters.Get(5, (id * 7) % num_ids);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(num_ids, counters.Size());
+
+  for (unsigned long id = 0; id < num_ids; ++id) {
+    ASSERT_EQ(num_threads * 5, counters.Get(5, id));
+  }
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// File: RecycleIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/RecycleIndex.hh"
+
+using eos::mgm::RecycleIndex;
+
+TEST(RecycleIndex, Keys)
+{
+  ASSERT_EQ(RecycleIndex::GetKey(0x1a2b, false), "fxid:0000000000001a2b");
+  ASSERT_EQ(RecycleIndex::GetKey(0x1a2b, true), "pxid:0000000000001a2b");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("#:#eos#:#a#:#f.0000000000001a2b"),
+            "fxid:0000000000001a2b");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("#:#eos#:#a#:#d.00000000000000ff.d"),
+            "pxid:00000000000000ff");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("0000000000001a2b"), "");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("#:#eos#:#f.0000000000001a2"), "");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("#:#eos#:#f_0000000000001a2b"), "");
+  ASSERT_EQ(RecycleIndex::GetKeyFromName("#:#eos#:#f.000000000000XYZW"), "");
+}
+
+TEST(RecycleIndex, TimeOrder)
+{
+  const std::string key = RecycleIndex::GetKey(1, false);
+  ASSERT_EQ(RecycleIndex::GetTimeField(1700000000, key),
+            "1700000000:fxid:0000000000000001");
+  ASSERT_EQ(RecycleIndex::GetTimeField(5, ""), "0000000005:");
+  // Lexicographic order of the fields follows the deletion time
+  ASSERT_LT(RecycleIndex::GetTimeField(999999999, key),
+            RecycleIndex::GetTimeField(1000000000, key));
+  ASSERT_LT(RecycleIndex::GetTimeField(100, ""),
+            RecycleIndex::GetTimeField(100, key));
+  ASSERT_LT(RecycleIndex::GetTimeField(100, key),
+            RecycleIndex::GetTimeField(101, ""));
+}
+
+TEST(RecycleIndex, SerializeRoundTrip)
+{
+  RecycleIndex::Entry entry;
+  entry.mKey = "pxid:00000000000000ff";
+  entry.mPath = "/eos/dev/proc/recycle/uid:1000/2024/01/02/0/"
+                "#:#eos#:#my dir#:#x.00000000000000ff.d";
+  entry.mUid = 1000;
+  entry.mGid = 1001;
+  entry.mSize = 123456789012ull;
+  entry.mDeletionTime = 1704153600;
+  std::string data = RecycleIndex::Serialize(entry);
+  RecycleIndex::Entry parsed;
+  ASSERT_TRUE(RecycleIndex::Deserialize(data, parsed));
+  ASSERT_EQ(parsed.mPath, entry.mPath);
+  ASSERT_EQ(parsed.mUid, entry.mUid);
+  ASSERT_EQ(parsed.mGid, entry.mGid);
+  ASSERT_EQ(parsed.mSize, entry.mSize);
+  ASSERT_EQ(parsed.mDeletionTime, entry.mDeletionTime);
+  ASSERT_TRUE(entry.IsDirectory());
+  ASSERT_FALSE(RecycleIndex::Deserialize("", parsed));
+  ASSERT_FALSE(RecycleIndex::Deserialize("1 2 3 4", parsed));
+  ASSERT_FALSE(RecycleIndex::Deserialize("1 2 x 4 /path", parsed));
+}
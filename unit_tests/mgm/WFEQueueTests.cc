@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+// File: WFEQueueTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/WFEQueue.hh"
+
+using eos::mgm::WFEQueue;
+
+TEST(WFEQueue, SerializeRoundTrip)
+{
+  WFEQueue::Record record {
+    {"action", "bash:shell:mylog echo <eos::wfe::path>"},
+    {"errmsg", ""},
+    {"log", std::string("a,b:c\n\0d", 9)},
+    {"when", "1700000000"}
+  };
+  std::string data = WFEQueue::Serialize(record);
+  WFEQueue::Record parsed;
+  ASSERT_TRUE(WFEQueue::Deserialize(data, parsed));
+  ASSERT_EQ(record, parsed);
+  ASSERT_EQ(WFEQueue::Serialize({}), "");
+  ASSERT_TRUE(WFEQueue::Deserialize("", parsed));
+  ASSERT_TRUE(parsed.empty());
+}
+
+TEST(WFEQueue, DeserializeMalformed)
+{
+  WFEQueue::Record parsed;
+  ASSERT_TRUE(WFEQueue::Deserialize("1:a,1:b,", parsed));
+  ASSERT_EQ(parsed.size(), 1u);
+  ASSERT_EQ(parsed["a"], "b");
+  // odd number of items
+  ASSERT_FALSE(WFEQueue::Deserialize("1:a,", parsed));
+  // length beyond the data
+  ASSERT_FALSE(WFEQueue::Deserialize("1:a,9:b,", parsed));
+  // missing separator
+  ASSERT_FALSE(WFEQueue::Deserialize("1:a,1:bc", parsed));
+  // no length
+  ASSERT_FALSE(WFEQueue::Deserialize(":a,1:b,", parsed));
+  ASSERT_FALSE(WFEQueue::Deserialize("x:a,1:b,", parsed));
+}